@@ -1,9 +1,13 @@
-#  KCONFIG_ADD_KCFG_FILES (SRCS_VAR [GENERATE_MOC] [USE_RELATIVE_PATH] file1.kcfgc ... fileN.kcfgc)
-#  KCONFIG_ADD_KCFG_FILES (<target> [GENERATE_MOC] [USE_RELATIVE_PATH] file1.kcfgc ... fileN.kcfgc) (since 5.67)
+#  KCONFIG_ADD_KCFG_FILES (SRCS_VAR [GENERATE_MOC] [USE_RELATIVE_PATH] [BATCH] file1.kcfgc ... fileN.kcfgc)
+#  KCONFIG_ADD_KCFG_FILES (<target> [GENERATE_MOC] [USE_RELATIVE_PATH] [BATCH] file1.kcfgc ... fileN.kcfgc) (since 5.67)
 #    Use this to add KDE config compiler files to your application/library.
 #    Use optional GENERATE_MOC to generate moc if you use signals in your kcfg files.
 #    Use optional USE_RELATIVE_PATH to generate the classes in the build following the given
 #    relative path to the file.
+#    Use optional BATCH to generate the classes of all the files with a single run of the
+#    config compiler, which spreads them across the cores and only writes the generated
+#    files that changed, so that the sources including them aren't rebuilt for nothing.
+#    Setting KCONFIG_ADD_KCFG_FILES_BATCH to ON does the same for all calls. (since 6.1)
 #    <target> must not be an alias.
 #
 # SPDX-FileCopyrightText: 2006-2009 Alexander Neundorf <neundorf@kde.org>
@@ -15,7 +19,7 @@
 include(CMakeParseArguments)
 
 function (KCONFIG_ADD_KCFG_FILES _target_or_source_var)
-   set(options GENERATE_MOC USE_RELATIVE_PATH)
+   set(options GENERATE_MOC USE_RELATIVE_PATH BATCH)
    cmake_parse_arguments(ARG "${options}" "" "" ${ARGN})
 
    if (TARGET ${_target_or_source_var})
@@ -25,7 +29,14 @@ function (KCONFIG_ADD_KCFG_FILES _target_or_source_var)
        endif()
    endif()
 
+   if (KCONFIG_ADD_KCFG_FILES_BATCH)
+       set(ARG_BATCH ON)
+   endif()
+
    set(sources)
+   set(_batch_JOBS)
+   set(_batch_OUTPUTS)
+   set(_batch_DEPENDS)
    foreach (_current_FILE ${ARG_UNPARSED_ARGUMENTS})
        get_filename_component(_tmp_FILE ${_current_FILE} ABSOLUTE)
        get_filename_component(_abs_PATH ${_tmp_FILE} PATH)
@@ -97,12 +108,19 @@ function (KCONFIG_ADD_KCFG_FILES _target_or_source_var)
            file(MAKE_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}/${_rel_PATH})
        endif()
 
-       # the command for creating the source file from the kcfg file
-       add_custom_command(OUTPUT ${_header_FILE} ${_src_FILE}
-                          COMMAND KF6::kconfig_compiler
-                          ARGS ${_kcfg_FILE} ${_tmp_FILE} -d ${CMAKE_CURRENT_BINARY_DIR}/${_rel_PATH}
-                          MAIN_DEPENDENCY ${_tmp_FILE}
-                          DEPENDS ${_kcfg_FILE} KF6::kconfig_compiler)
+       if (ARG_BATCH)
+           # one line of the batch file: the kcfg file, the kcfgc file and the directory
+           list(APPEND _batch_JOBS "${_kcfg_FILE}\t${_tmp_FILE}\t${CMAKE_CURRENT_BINARY_DIR}/${_rel_PATH}")
+           list(APPEND _batch_OUTPUTS ${_header_FILE} ${_src_FILE})
+           list(APPEND _batch_DEPENDS ${_tmp_FILE} ${_kcfg_FILE})
+       else()
+           # the command for creating the source file from the kcfg file
+           add_custom_command(OUTPUT ${_header_FILE} ${_src_FILE}
+                              COMMAND KF6::kconfig_compiler
+                              ARGS ${_kcfg_FILE} ${_tmp_FILE} -d ${CMAKE_CURRENT_BINARY_DIR}/${_rel_PATH}
+                              MAIN_DEPENDENCY ${_tmp_FILE}
+                              DEPENDS ${_kcfg_FILE} KF6::kconfig_compiler)
+       endif()
 
        set_source_files_properties(${_header_FILE} ${_src_FILE} PROPERTIES
            SKIP_AUTOMOC ON
@@ -118,6 +136,25 @@ function (KCONFIG_ADD_KCFG_FILES _target_or_source_var)
        list(APPEND sources ${_src_FILE} ${_header_FILE})
    endforeach (_current_FILE)
 
+   if (_batch_JOBS)
+       # named after the kcfgc files, a call with other files gets a batch of its own
+       string(MD5 _batch_ID "${ARG_UNPARSED_ARGUMENTS}")
+       set(_batch_FILE ${CMAKE_CURRENT_BINARY_DIR}/kcfg_batch_${_batch_ID}.txt)
+       set(_stamp_FILE ${CMAKE_CURRENT_BINARY_DIR}/kcfg_batch_${_batch_ID}.stamp)
+       string(JOIN "\n" _batch_CONTENT ${_batch_JOBS})
+       # only written when the content changes
+       file(GENERATE OUTPUT ${_batch_FILE} CONTENT "${_batch_CONTENT}\n")
+
+       # the generated files are byproducts, so that the ones left alone because they
+       # didn't change don't make the command run again
+       add_custom_command(OUTPUT ${_stamp_FILE}
+                          BYPRODUCTS ${_batch_OUTPUTS}
+                          COMMAND KF6::kconfig_compiler --batch ${_batch_FILE}
+                          COMMAND ${CMAKE_COMMAND} -E touch ${_stamp_FILE}
+                          DEPENDS ${_batch_FILE} ${_batch_DEPENDS} KF6::kconfig_compiler)
+       list(APPEND sources ${_stamp_FILE})
+   endif()
+
    if (TARGET ${_target_or_source_var})
       target_sources(${_target_or_source_var} PRIVATE ${sources})
    else()
@@ -0,0 +1,77 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: MIT
+*/
+
+#include "lazygroups_test.h"
+
+#include <KConfigGroup>
+
+#include <QTemporaryFile>
+#include <QTest>
+
+class KConfigCompiler_Test_LazyGroups : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testLazyCreation();
+    void testSetDefaults();
+    void testSave();
+
+private:
+    QTemporaryFile m_file;
+};
+
+void KConfigCompiler_Test_LazyGroups::initTestCase()
+{
+    QVERIFY(m_file.open());
+    m_file.write("[General]\nName=Katie\n[Window]\nMaximized=true\n");
+    m_file.close();
+    LazyGroupsTest::instance(m_file.fileName());
+}
+
+void KConfigCompiler_Test_LazyGroups::testLazyCreation()
+{
+    LazyGroupsTest *settings = LazyGroupsTest::self();
+    QCOMPARE(settings->name(), QStringLiteral("Katie"));
+    QCOMPARE(settings->count(), 3);
+
+    // the items of Window don't exist yet, they read the config once they do
+    settings->config()->group(QStringLiteral("Window")).writeEntry("Maximized", false);
+    settings->config()->group(QStringLiteral("General")).writeEntry("Count", 5);
+    QCOMPARE(settings->maximized(), false);
+    QCOMPARE(settings->count(), 3);
+
+    settings->read();
+    QCOMPARE(settings->count(), 5);
+    QVERIFY(settings->findItem(QStringLiteral("Maximized")));
+    QCOMPARE(settings->items().count(), 3);
+}
+
+void KConfigCompiler_Test_LazyGroups::testSetDefaults()
+{
+    LazyGroupsTest *settings = LazyGroupsTest::self();
+    settings->setDefaults();
+    QVERIFY(settings->isDefaults());
+    QCOMPARE(settings->name(), QStringLiteral("Konqi"));
+    QCOMPARE(settings->maximized(), false);
+    settings->read();
+}
+
+void KConfigCompiler_Test_LazyGroups::testSave()
+{
+    LazyGroupsTest *settings = LazyGroupsTest::self();
+    settings->setName(QStringLiteral("Konqui"));
+    settings->setMaximized(true);
+    QVERIFY(settings->save());
+
+    KConfig reread(m_file.fileName(), KConfig::SimpleConfig);
+    QCOMPARE(reread.group(QStringLiteral("General")).readEntry("Name", QString()), QStringLiteral("Konqui"));
+    QCOMPARE(reread.group(QStringLiteral("Window")).readEntry("Maximized", false), true);
+}
+
+QTEST_MAIN(KConfigCompiler_Test_LazyGroups)
+
+#include "kconfigcompiler_test_lazygroups.moc"
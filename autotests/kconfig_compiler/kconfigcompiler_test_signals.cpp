@@ -25,6 +25,8 @@ private Q_SLOTS:
     void testSetters_data();
     void testSetProperty();
     void testSetProperty_data();
+    void testMultipleSignals();
+    void benchmarkSave();
     void initTestCase();
     void cleanupTestCase();
 };
@@ -211,6 +213,44 @@ void KConfigCompiler_Test_Signals::testSetProperty()
     QVERIFY(item->isEqual(args[0]));
 }
 
+/** Test that each signal of an entry emitting several is emitted */
+void KConfigCompiler_Test_Signals::testMultipleSignals()
+{
+    noSingleton->setDefaults();
+    noSingleton->save();
+    QSignalSpy fooSpy(noSingleton, &SignalsTestNoSingleton::fooChanged);
+    QSignalSpy somethingSpy(noSingleton, &SignalsTestNoSingleton::somethingChanged);
+
+    KConfigSkeletonItem *item = noSingleton->findItem(QStringLiteral("bar"));
+    QVERIFY(item);
+    item->setProperty(42);
+    noSingleton->save();
+    QCOMPARE(fooSpy.count(), 1);
+    QCOMPARE(somethingSpy.count(), 1);
+
+    // through the setter
+    noSingleton->setBar(43);
+    noSingleton->save();
+    QCOMPARE(fooSpy.count(), 2);
+    QCOMPARE(somethingSpy.count(), 2);
+
+    // nothing changed, nothing emitted
+    noSingleton->save();
+    QCOMPARE(fooSpy.count(), 2);
+    QCOMPARE(somethingSpy.count(), 2);
+}
+
+void KConfigCompiler_Test_Signals::benchmarkSave()
+{
+    KConfigSkeletonItem *item = noSingleton->findItem(QStringLiteral("bar"));
+    QVERIFY(item);
+    int value = 0;
+    QBENCHMARK {
+        item->setProperty(++value);
+        noSingleton->save();
+    }
+}
+
 QTEST_MAIN(KConfigCompiler_Test_Signals)
 
 #include "kconfigcompiler_test_signals.moc"
@@ -0,0 +1,195 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: MIT
+*/
+
+#include "staticitems_test.h"
+#include "staticitems_param_test.h"
+#include "staticitems_test_items.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QTemporaryFile>
+#include <QTest>
+
+#include <thread>
+
+class KConfigCompiler_Test_StaticItems : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testDefaults();
+    void testReadSave();
+    void testUseDefaults();
+    void testImmutable();
+    void testSameAsItems();
+    void testParameterizedGroups();
+    void testValues();
+    void benchmarkReadStatic();
+    void benchmarkReadItems();
+};
+
+static const QByteArray s_contents = "[General]\nName=Katie\nCount=7\nTags=x,y,z\n[Window]\nMaximized=true\n";
+
+static KSharedConfig::Ptr openConfig(QTemporaryFile &file, const QByteArray &contents = QByteArray())
+{
+    if (!file.open()) {
+        return KSharedConfig::Ptr();
+    }
+    file.write(contents);
+    file.close();
+    return KSharedConfig::openConfig(file.fileName(), KConfig::SimpleConfig);
+}
+
+void KConfigCompiler_Test_StaticItems::testDefaults()
+{
+    QTemporaryFile file;
+    StaticItemsTest settings(openConfig(file));
+    QVERIFY(settings.items().isEmpty());
+    QCOMPARE(settings.name(), QStringLiteral("Konqi"));
+    QCOMPARE(settings.count(), 3);
+    QCOMPARE(settings.tags(), QStringList({QStringLiteral("a"), QStringLiteral("b")}));
+    QCOMPARE(settings.maximized(), false);
+    QVERIFY(settings.isDefaults());
+    QVERIFY(!settings.isSaveNeeded());
+}
+
+void KConfigCompiler_Test_StaticItems::testReadSave()
+{
+    QTemporaryFile file;
+    KSharedConfig::Ptr config = openConfig(file, "[General]\nName=Katie\nCount=42\n");
+    StaticItemsTest settings(config);
+    QCOMPARE(settings.name(), QStringLiteral("Katie"));
+    QCOMPARE(settings.count(), 10); // clamped to the maximum
+    QVERIFY(!settings.isDefaults());
+
+    settings.setMaximized(true);
+    settings.setName(QStringLiteral("Konqi"));
+    QVERIFY(settings.isSaveNeeded());
+    QVERIFY(settings.save());
+    QVERIFY(!settings.isSaveNeeded());
+
+    KConfig reread(file.fileName(), KConfig::SimpleConfig);
+    QCOMPARE(reread.group(QStringLiteral("Window")).readEntry("Maximized", false), true);
+    QVERIFY(!reread.group(QStringLiteral("General")).hasKey("Name")); // back to the default
+    QCOMPARE(reread.group(QStringLiteral("General")).readEntry("Count", 0), 42); // untouched
+
+    config->group(QStringLiteral("General")).writeEntry("Count", 5);
+    settings.read();
+    QCOMPARE(settings.count(), 5);
+    QVERIFY(!settings.isSaveNeeded());
+
+    settings.setDefaults();
+    QVERIFY(settings.isDefaults());
+    QCOMPARE(settings.maximized(), false);
+}
+
+void KConfigCompiler_Test_StaticItems::testUseDefaults()
+{
+    QTemporaryFile file;
+    StaticItemsTest settings(openConfig(file, "[General]\nCount=7\n"));
+    QCOMPARE(settings.count(), 7);
+    settings.useDefaults(true);
+    QCOMPARE(settings.count(), 3);
+    settings.useDefaults(false);
+    QCOMPARE(settings.count(), 7);
+}
+
+void KConfigCompiler_Test_StaticItems::testImmutable()
+{
+    QTemporaryFile file;
+    StaticItemsTest settings(openConfig(file, "[General]\nName[$i]=Locked\n"));
+    QVERIFY(settings.isNameImmutable());
+    QVERIFY(!settings.isCountImmutable());
+    settings.setName(QStringLiteral("Other"));
+    QCOMPARE(settings.name(), QStringLiteral("Locked"));
+}
+
+void KConfigCompiler_Test_StaticItems::testSameAsItems()
+{
+    QTemporaryFile file;
+    KSharedConfig::Ptr config = openConfig(file, s_contents);
+    StaticItemsTest settings(config);
+    StaticItemsTestItems items(config);
+    QCOMPARE(settings.name(), items.name());
+    QCOMPARE(settings.count(), items.count());
+    QCOMPARE(settings.tags(), items.tags());
+    QCOMPARE(settings.maximized(), items.maximized());
+}
+
+void KConfigCompiler_Test_StaticItems::testParameterizedGroups()
+{
+    QTemporaryFile file;
+    KSharedConfig::Ptr config = openConfig(file, "[Account work]\nServer[$i]=mail.example.com\n");
+    StaticItemsParamTest work(config, QStringLiteral("work"));
+    StaticItemsParamTest home(config, QStringLiteral("home"));
+    QCOMPARE(work.server(), QStringLiteral("mail.example.com"));
+    QCOMPARE(home.server(), QStringLiteral("localhost"));
+    QVERIFY(work.isServerImmutable());
+    QVERIFY(!home.isServerImmutable());
+
+    home.setInterval(10);
+    QVERIFY(home.save());
+    QCOMPARE(config->group(QStringLiteral("Account home")).readEntry("Interval", 0), 10);
+    QVERIFY(!config->group(QStringLiteral("Account work")).hasKey("Interval"));
+
+    // the names filled in before are used again
+    config->group(QStringLiteral("Account home")).writeEntry("Server", QStringLiteral("imap.example.com"));
+    home.read();
+    QCOMPARE(home.server(), QStringLiteral("imap.example.com"));
+    QCOMPARE(home.interval(), 10);
+}
+
+void KConfigCompiler_Test_StaticItems::testValues()
+{
+    QTemporaryFile file;
+    KSharedConfig::Ptr config = openConfig(file, s_contents);
+    StaticItemsTest settings(config);
+    StaticItemsTestItems items(config);
+    const StaticItemsTest::Values values = settings.values();
+    const StaticItemsTestItems::Values itemValues = items.values();
+    QCOMPARE(values.mName, QStringLiteral("Katie"));
+    QCOMPARE(itemValues.mName, values.mName);
+    QCOMPARE(itemValues.mCount, values.mCount);
+    QCOMPARE(itemValues.mTags, values.mTags);
+    QCOMPARE(itemValues.mMaximized, values.mMaximized);
+
+    // the copy stays as it was, and can be read by another thread
+    settings.setCount(2);
+    items.setCount(2);
+    int count = 0;
+    std::thread reader([&itemValues, &count] {
+        count = itemValues.mCount;
+    });
+    reader.join();
+    QCOMPARE(count, 7);
+    QCOMPARE(values.mCount, 7);
+    QCOMPARE(settings.values().mCount, 2);
+    QCOMPARE(items.values().mCount, 2);
+}
+
+void KConfigCompiler_Test_StaticItems::benchmarkReadStatic()
+{
+    QTemporaryFile file;
+    StaticItemsTest settings(openConfig(file, s_contents));
+    QBENCHMARK {
+        settings.read();
+    }
+    QCOMPARE(settings.count(), 7);
+}
+
+void KConfigCompiler_Test_StaticItems::benchmarkReadItems()
+{
+    QTemporaryFile file;
+    StaticItemsTestItems settings(openConfig(file, s_contents));
+    QBENCHMARK {
+        settings.read();
+    }
+    QCOMPARE(settings.count(), 7);
+}
+
+QTEST_MAIN(KConfigCompiler_Test_StaticItems)
+
+#include "kconfigcompiler_test_staticitems.moc"
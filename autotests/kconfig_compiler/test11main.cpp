@@ -7,6 +7,10 @@
 #include "test11a.h"
 #include <QGuiApplication>
 
+// literal defaults are compile-time constants
+static_assert(Test11::defaultHourSizeValue() == 10);
+static_assert(Test11a::defaultDestinationValue() == Test11a::EnumDestination::standardDestination);
+
 int main(int argc, char **argv)
 {
     QGuiApplication app(argc, argv);
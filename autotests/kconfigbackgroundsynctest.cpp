@@ -0,0 +1,172 @@
+/*  This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include <QFile>
+#include <QLockFile>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <KConfigBackgroundSync>
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+class KConfigBackgroundSyncTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void testSync();
+    void testCoalescing();
+    void testChangesWhileWriting();
+    void testFlush();
+    void testLockedFile();
+
+private:
+    QString m_fileName;
+};
+
+static QString readEntry(const QString &fileName, const char *key)
+{
+    KConfig config(fileName, KConfig::SimpleConfig);
+    return config.group(QStringLiteral("Group")).readEntry(key, QString());
+}
+
+void KConfigBackgroundSyncTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    m_fileName = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QLatin1String("/kconfigbackgroundsynctestrc");
+}
+
+void KConfigBackgroundSyncTest::init()
+{
+    QFile::remove(m_fileName);
+}
+
+void KConfigBackgroundSyncTest::testSync()
+{
+    KConfigBackgroundSync syncer(KSharedConfig::openConfig(m_fileName, KConfig::SimpleConfig));
+    syncer.setInterval(0);
+    QSignalSpy spy(&syncer, &KConfigBackgroundSync::syncFinished);
+
+    KConfigGroup group(syncer.config(), QStringLiteral("Group"));
+    group.writeEntry("Key", "value");
+    syncer.requestSync();
+    QVERIFY(syncer.isPending());
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.size(), 1);
+    QCOMPARE(spy.at(0).at(0).toBool(), true);
+    QVERIFY(!syncer.isPending());
+    QVERIFY(!syncer.config()->isDirty());
+    QCOMPARE(readEntry(m_fileName, "Key"), QStringLiteral("value"));
+
+    // nothing to write
+    syncer.requestSync();
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.at(1).at(0).toBool(), true);
+}
+
+void KConfigBackgroundSyncTest::testCoalescing()
+{
+    KConfigBackgroundSync syncer(KSharedConfig::openConfig(m_fileName, KConfig::SimpleConfig));
+    syncer.setInterval(50);
+    QSignalSpy spy(&syncer, &KConfigBackgroundSync::syncFinished);
+
+    KConfigGroup group(syncer.config(), QStringLiteral("Group"));
+    for (int i = 0; i < 10; ++i) {
+        group.writeEntry("Key", i);
+        syncer.requestSync();
+    }
+    QVERIFY(spy.wait());
+    QTest::qWait(100);
+    QCOMPARE(spy.size(), 1);
+    QCOMPARE(readEntry(m_fileName, "Key"), QStringLiteral("9"));
+}
+
+void KConfigBackgroundSyncTest::testChangesWhileWriting()
+{
+    KConfigBackgroundSync syncer(KSharedConfig::openConfig(m_fileName, KConfig::SimpleConfig));
+    syncer.setInterval(0);
+    QSignalSpy spy(&syncer, &KConfigBackgroundSync::syncFinished);
+
+    KConfigGroup group(syncer.config(), QStringLiteral("Group"));
+    group.writeEntry("Key", "first");
+    syncer.requestSync();
+    QTRY_VERIFY(!syncer.config()->isDirty()); // the entries were taken out
+
+    // a sync requested while writing follows once the first one is done
+    group.writeEntry("Other", "second");
+    QVERIFY(syncer.config()->isDirty());
+    syncer.requestSync();
+    QTRY_COMPARE(spy.size(), 2);
+    QVERIFY(!syncer.isPending());
+    QCOMPARE(readEntry(m_fileName, "Key"), QStringLiteral("first"));
+    QCOMPARE(readEntry(m_fileName, "Other"), QStringLiteral("second"));
+
+    // a plain sync() waits for a background sync, so the newer value wins
+    group.writeEntry("Key", "third");
+    syncer.requestSync();
+    QTRY_VERIFY(!syncer.config()->isDirty());
+    group.writeEntry("Key", "fourth");
+    QVERIFY(syncer.config()->sync());
+    QTRY_COMPARE(spy.size(), 3);
+    QCOMPARE(readEntry(m_fileName, "Key"), QStringLiteral("fourth"));
+}
+
+void KConfigBackgroundSyncTest::testFlush()
+{
+    {
+        KConfigBackgroundSync syncer(KSharedConfig::openConfig(m_fileName, KConfig::SimpleConfig));
+        syncer.setInterval(60000);
+        QSignalSpy spy(&syncer, &KConfigBackgroundSync::syncFinished);
+
+        KConfigGroup group(syncer.config(), QStringLiteral("Group"));
+        group.writeEntry("Key", "flushed");
+        syncer.requestSync();
+        QVERIFY(syncer.flush());
+        QCOMPARE(spy.size(), 1);
+        QVERIFY(!syncer.isPending());
+        QCOMPARE(readEntry(m_fileName, "Key"), QStringLiteral("flushed"));
+
+        // and once more when destroyed
+        group.writeEntry("Key", "destroyed");
+        syncer.requestSync();
+    }
+    QCOMPARE(readEntry(m_fileName, "Key"), QStringLiteral("destroyed"));
+}
+
+void KConfigBackgroundSyncTest::testLockedFile()
+{
+    KConfigBackgroundSync syncer(KSharedConfig::openConfig(m_fileName, KConfig::SimpleConfig));
+    syncer.setInterval(10);
+    QSignalSpy spy(&syncer, &KConfigBackgroundSync::syncFinished);
+
+    // another process writing the file
+    QLockFile lockFile(m_fileName + QLatin1String(".lock"));
+    QVERIFY(lockFile.tryLock(0));
+
+    KConfigGroup group(syncer.config(), QStringLiteral("Group"));
+    group.writeEntry("Key", "waited");
+    syncer.requestSync();
+    QTest::qWait(500);
+    QCOMPARE(spy.size(), 0);
+    QVERIFY(syncer.isPending());
+
+    // tried again once the file is free
+    lockFile.unlock();
+    QTRY_COMPARE(spy.size(), 1);
+    QCOMPARE(spy.at(0).at(0).toBool(), true);
+    QVERIFY(!syncer.isPending());
+    QCOMPARE(readEntry(m_fileName, "Key"), QStringLiteral("waited"));
+}
+
+QTEST_MAIN(KConfigBackgroundSyncTest)
+
+#include "kconfigbackgroundsynctest.moc"
@@ -12,6 +12,7 @@
 #include <QStandardPaths>
 #include <kconfig.h>
 #include <kconfiggroup.h>
+#include <kconfiggui.h>
 #include <kconfigskeleton.h>
 
 QTEST_MAIN(KConfigTest)
@@ -146,3 +147,121 @@ void KConfigTest::testInvalid()
 
     QVERIFY(sc3.readEntry("badList", QColor()) == QColor());
 }
+
+void KConfigTest::testFontCache()
+{
+    KConfig sc(KConfig::ConfigAssociation::KdeApp, QStringLiteral("kconfigtest"));
+    KConfigGroup cg(&sc, "Fonts");
+    QFont other = fontEntry();
+    other.setPointSize(20);
+    cg.writeEntry("font1", fontEntry());
+    cg.writeEntry("font2", other);
+
+    // the second reads of each come from the cache of decoded fonts
+    for (int i = 0; i < 2; ++i) {
+        if (m_fontFromStringBug) {
+            QEXPECT_FAIL("", "QFont fromString bug from Qt 5.8.0", Continue);
+        }
+        QCOMPARE(cg.readEntry("font1", QFont()), fontEntry());
+        if (m_fontFromStringBug) {
+            QEXPECT_FAIL("", "QFont fromString bug from Qt 5.8.0", Continue);
+        }
+        QCOMPARE(cg.readEntry("font2", QFont()), other);
+    }
+}
+
+// the groups and keys of a color scheme in kdeglobals
+static const QStringList s_colorSets = {QStringLiteral("Colors:Button"),
+                                        QStringLiteral("Colors:Complementary"),
+                                        QStringLiteral("Colors:Header"),
+                                        QStringLiteral("Colors:Selection"),
+                                        QStringLiteral("Colors:Tooltip"),
+                                        QStringLiteral("Colors:View"),
+                                        QStringLiteral("Colors:Window")};
+static const QByteArrayList s_colorRoles = {"BackgroundAlternate",
+                                            "BackgroundNormal",
+                                            "DecorationFocus",
+                                            "DecorationHover",
+                                            "ForegroundActive",
+                                            "ForegroundInactive",
+                                            "ForegroundLink",
+                                            "ForegroundNegative",
+                                            "ForegroundNeutral",
+                                            "ForegroundNormal",
+                                            "ForegroundPositive",
+                                            "ForegroundVisited"};
+
+static QColor schemeColor(int index)
+{
+    return QColor(index % 256, (index * 7) % 256, (index * 13) % 256);
+}
+
+static bool writeColorScheme()
+{
+    KConfig writer(QStringLiteral("kconfigguitest_colors"), KConfig::SimpleConfig);
+    int i = 0;
+    for (const QString &set : s_colorSets) {
+        KConfigGroup cg(&writer, set);
+        for (const QByteArray &role : s_colorRoles) {
+            cg.writeEntry(role.constData(), schemeColor(i++));
+        }
+    }
+    return writer.sync();
+}
+
+void KConfigTest::testReadColors()
+{
+    QVERIFY(writeColorScheme());
+    KConfig sc(QStringLiteral("kconfigguitest_colors"), KConfig::SimpleConfig);
+    KConfigGroup extra(&sc, "Colors:Extra");
+    extra.writeEntry("Hex", QByteArray("#102030"));
+    extra.writeEntry("Named", QByteArray("steelblue"));
+    extra.writeEntry("Alpha", QColor(1, 2, 3, 4));
+    extra.writeEntry("Invalid", QColor());
+    extra.writeEntry("Bad", QByteArray("1,2,300"));
+
+    const QList<QColor> colors = KConfigGui::readColors(sc, s_colorSets, s_colorRoles);
+    QCOMPARE(colors.size(), s_colorSets.size() * s_colorRoles.size());
+    for (int i = 0; i < colors.size(); ++i) {
+        QCOMPARE(colors.at(i), schemeColor(i));
+    }
+
+    const QByteArrayList keys = {"Hex", "Named", "Alpha", "Invalid", "Bad", "Missing"};
+    const QList<QColor> extraColors = KConfigGui::readColors(sc, {QStringLiteral("Colors:Extra")}, keys, Qt::red);
+    const QList<QColor> expected = {QColor(0x10, 0x20, 0x30), QColor(QLatin1String("steelblue")), QColor(1, 2, 3, 4), QColor(), QColor(Qt::red), QColor(Qt::red)};
+    QCOMPARE(extraColors, expected);
+    // the same as reading them one by one
+    for (int i = 0; i < keys.size(); ++i) {
+        QCOMPARE(extraColors.at(i), extra.readEntry(keys.at(i).constData(), QColor(Qt::red)));
+    }
+}
+
+void KConfigTest::benchmarkReadColorScheme()
+{
+    QVERIFY(writeColorScheme());
+
+    KConfig sc(QStringLiteral("kconfigguitest_colors"), KConfig::SimpleConfig);
+    int valid = 0;
+    QBENCHMARK {
+        valid = 0;
+        for (const QString &set : s_colorSets) {
+            const KConfigGroup cg(&sc, set);
+            for (const QByteArray &role : s_colorRoles) {
+                valid += cg.readEntry(role.constData(), QColor()).isValid();
+            }
+        }
+    }
+    QCOMPARE(valid, s_colorSets.size() * s_colorRoles.size());
+}
+
+void KConfigTest::benchmarkReadColorSchemeBulk()
+{
+    QVERIFY(writeColorScheme());
+
+    KConfig sc(QStringLiteral("kconfigguitest_colors"), KConfig::SimpleConfig);
+    QList<QColor> colors;
+    QBENCHMARK {
+        colors = KConfigGui::readColors(sc, s_colorSets, s_colorRoles);
+    }
+    QCOMPARE(colors.size(), s_colorSets.size() * s_colorRoles.size());
+}
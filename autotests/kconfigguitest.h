@@ -15,6 +15,10 @@ class KConfigTest : public QObject
 private Q_SLOTS:
     void testComplex();
     void testInvalid();
+    void testFontCache();
+    void testReadColors();
+    void benchmarkReadColorScheme();
+    void benchmarkReadColorSchemeBulk();
     void initTestCase();
     void cleanupTestCase();
 
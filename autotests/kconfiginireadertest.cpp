@@ -0,0 +1,106 @@
+/*  This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include <QTemporaryFile>
+#include <QTest>
+
+#include <kconfiginireader.h>
+
+class KConfigIniReaderTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testEntries();
+    void testEarlyExit();
+    void testMissingFile();
+};
+
+void KConfigIniReaderTest::testEntries()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(
+        "TopLevel=top\n"
+        "# comment\n"
+        "[Group]\n"
+        "Name=Plain\n"
+        "Name[de]=Einfach\n"
+        "Escaped=\\sa\\tb\n"
+        "Path[$e]=$HOME/foo\n"
+        "Gone[$d]\n"
+        "[Locked][$i]\n"
+        "Key=value\n"
+        "[Parent][Child]\n"
+        "Key[$i]=child\n");
+    file.close();
+
+    struct Entry {
+        QByteArray group;
+        QByteArray key;
+        QByteArray locale;
+        QByteArray value;
+        KConfigIniReader::EntryFlags flags;
+    };
+    const QList<Entry> expected = {
+        {"<default>", "TopLevel", {}, "top", KConfigIniReader::NoFlags},
+        {"Group", "Name", {}, "Plain", KConfigIniReader::NoFlags},
+        {"Group", "Name", "de", "Einfach", KConfigIniReader::NoFlags},
+        {"Group", "Escaped", {}, " a\tb", KConfigIniReader::NoFlags},
+        {"Group", "Path", {}, "$HOME/foo", KConfigIniReader::Expand},
+        {"Group", "Gone", {}, {}, KConfigIniReader::Deleted},
+        {"Locked", "Key", {}, "value", KConfigIniReader::Immutable},
+        {"Parent\x1d" "Child", "Key", {}, "child", KConfigIniReader::Immutable},
+    };
+
+    KConfigIniReader reader(file.fileName());
+    QVERIFY(reader.isOpen());
+    for (const Entry &entry : expected) {
+        QVERIFY(reader.readNext());
+        QCOMPARE(reader.group().toByteArray(), entry.group);
+        QCOMPARE(reader.key().toByteArray(), entry.key);
+        QCOMPARE(reader.locale().isNull(), entry.locale.isNull());
+        QCOMPARE(reader.locale().toByteArray(), entry.locale);
+        QCOMPARE(reader.value().toByteArray(), entry.value);
+        QCOMPARE(reader.flags(), entry.flags);
+    }
+    QVERIFY(!reader.readNext());
+    QVERIFY(!reader.readNext());
+}
+
+void KConfigIniReaderTest::testEarlyExit()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    for (int i = 0; i < 100; ++i) {
+        file.write("[Group" + QByteArray::number(i) + "]\nKey=" + QByteArray::number(i) + "\n");
+    }
+    file.close();
+
+    KConfigIniReader reader(file.fileName());
+    int entries = 0;
+    while (reader.readNext()) {
+        ++entries;
+        if (reader.group() == QByteArrayView("Group41")) {
+            break;
+        }
+    }
+    QCOMPARE(entries, 42);
+    QCOMPARE(reader.value().toByteArray(), QByteArray("41"));
+}
+
+void KConfigIniReaderTest::testMissingFile()
+{
+    KConfigIniReader reader(QStringLiteral("/does/not/exist"));
+    QVERIFY(!reader.isOpen());
+    QVERIFY(!reader.readNext());
+}
+
+QTEST_MAIN(KConfigIniReaderTest)
+
+#include "kconfiginireadertest.moc"
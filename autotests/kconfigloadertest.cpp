@@ -197,4 +197,49 @@ void ConfigLoaderTest::ulongLongDefaultValue()
     QVERIFY(typeItem->isEqual(Q_UINT64_C(9223372036854775806)));
 }
 
+void ConfigLoaderTest::sameSchemaTwice()
+{
+    // the second loader of the same file reuses what the first one parsed
+    QFile file(configFile->fileName());
+    KConfigLoader other(KConfig::ConfigAssociation::KdeApp, configFile->fileName(), &file);
+    QCOMPARE(other.groupList(), cl->groupList());
+    QCOMPARE(other.items().size(), cl->items().size());
+    for (int i = 0; i < cl->items().size(); ++i) {
+        QCOMPARE(other.items().at(i)->group(), cl->items().at(i)->group());
+        QCOMPARE(other.items().at(i)->name(), cl->items().at(i)->name());
+        QCOMPARE(other.items().at(i)->label(), cl->items().at(i)->label());
+        QCOMPARE(other.items().at(i)->getDefault(), cl->items().at(i)->getDefault());
+    }
+
+    // relative to another base group
+    KConfig config(QStringLiteral("kconfigloadertest_sub"), KConfig::SimpleConfig);
+    QFile subFile(configFile->fileName());
+    KConfigLoader sub(KConfig::ConfigAssociation::KdeApp, config.group(QStringLiteral("Base")), &subFile);
+    QCOMPARE(sub.groupList(), cl->groupList());
+    QVERIFY(sub.findItem(QStringLiteral("Base\x1d") + s_testName, QStringLiteral("DefaultBoolItem")));
+}
+
+void ConfigLoaderTest::createAsync()
+{
+    QFile file(configFile->fileName());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QObject parent;
+    QFuture<KConfigLoader *> future = KConfigLoader::createAsync(KConfig::ConfigAssociation::KdeApp, configFile->fileName(), file.readAll(), &parent);
+    QTRY_VERIFY(future.isFinished());
+
+    KConfigLoader *loader = future.result();
+    QVERIFY(loader);
+    QCOMPARE(loader->parent(), &parent);
+    QCOMPARE(loader->groupList(), cl->groupList());
+    QCOMPARE(loader->items().size(), cl->items().size());
+    QCOMPARE(loader->property(QStringLiteral("DefaultIntItem")), cl->property(QStringLiteral("DefaultIntItem")));
+
+    // nothing is created once the parent is gone
+    auto doomed = new QObject;
+    future = KConfigLoader::createAsync(KConfig::ConfigAssociation::KdeApp, configFile->fileName(), QByteArray(), doomed);
+    delete doomed;
+    QTRY_VERIFY(future.isFinished());
+    QVERIFY(future.isCanceled());
+}
+
 QTEST_MAIN(ConfigLoaderTest)
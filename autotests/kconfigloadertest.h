@@ -42,6 +42,8 @@ private Q_SLOTS:
     void rectDefaultValue();
     void sizeDefaultValue();
     void ulongLongDefaultValue();
+    void sameSchemaTwice();
+    void createAsync();
 
 private:
     KConfigLoader *cl;
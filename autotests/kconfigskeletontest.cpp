@@ -10,6 +10,8 @@
 #include <QtTestGui>
 #include <kconfig.h>
 
+#include <thread>
+
 QTEST_MAIN(KConfigSkeletonTest)
 
 // clazy:excludeall=non-pod-global-static
@@ -176,3 +178,273 @@ void KConfigSkeletonTest::testSaveRead()
     s->read();
     QCOMPARE(mMyBool, false);
 }
+
+void KConfigSkeletonTest::testGroupsOfItems()
+{
+    // items of the same group, one of them with a nested group of its own
+    QString nested;
+    QString plain;
+    s->setCurrentGroup(QStringLiteral("MyGroup"));
+    auto *nestedItem = s->addItemString(QStringLiteral("MySetting5"), nested, QStringLiteral("default"));
+    nestedItem->setGroup(s->config()->group(QStringLiteral("MyGroup")).group(QStringLiteral("Nested")));
+    s->addItemString(QStringLiteral("MySetting6"), plain, QStringLiteral("default"));
+
+    nested = QStringLiteral("nested");
+    plain = QStringLiteral("plain");
+    mMyBool = true;
+    mMyString = QStringLiteral("other");
+    QVERIFY(s->save());
+
+    const KConfigGroup group = s->config()->group(QStringLiteral("MyGroup"));
+    QCOMPARE(group.readEntry("MySetting6", QString()), QStringLiteral("plain"));
+    QVERIFY(!group.hasKey("MySetting5"));
+    QCOMPARE(group.group(QStringLiteral("Nested")).readEntry("MySetting5", QString()), QStringLiteral("nested"));
+    QCOMPARE(group.readEntry("MySetting1", false), true);
+    QCOMPARE(s->config()->group(QStringLiteral("MyOtherGroup")).readEntry("MySetting4", QString()), QStringLiteral("other"));
+
+    nested.clear();
+    plain.clear();
+    mMyBool = false;
+    mMyString.clear();
+    s->read();
+    QCOMPARE(nested, QStringLiteral("nested"));
+    QCOMPARE(plain, QStringLiteral("plain"));
+    QCOMPARE(mMyBool, true);
+    QCOMPARE(mMyString, QStringLiteral("other"));
+}
+
+void KConfigSkeletonTest::testTrackChanges()
+{
+    s->setTrackChanges(true);
+    QVERIFY(s->tracksChanges());
+    QVERIFY(s->isDefaults());
+    QVERIFY(!s->isSaveNeeded());
+
+    itemBool->setProperty(true);
+    QVERIFY(!s->isDefaults());
+    QVERIFY(s->isSaveNeeded());
+    QVERIFY(s->save());
+    QVERIFY(!s->isSaveNeeded());
+    QVERIFY(!s->isDefaults());
+    QCOMPARE(s->config()->group(QStringLiteral("MyGroup")).readEntry("MySetting1", false), true);
+
+    // a change made behind the back of the skeleton is only seen once it is marked
+    mMyString = QStringLiteral("unmarked");
+    QVERIFY(!s->isSaveNeeded());
+    QVERIFY(s->save());
+    QVERIFY(!s->config()->group(QStringLiteral("MyOtherGroup")).hasKey("MySetting4"));
+    s->markChanged(QStringLiteral("MySetting4"));
+    QVERIFY(s->isSaveNeeded());
+    QVERIFY(s->save());
+    QCOMPARE(s->config()->group(QStringLiteral("MyOtherGroup")).readEntry("MySetting4", QString()), QStringLiteral("unmarked"));
+
+    itemBool->setValue(false);
+    mMyString = s_default_setting4;
+    s->markChanged(QStringLiteral("MySetting4"));
+    QVERIFY(s->isDefaults());
+    QVERIFY(s->isSaveNeeded());
+
+    s->setDefaults();
+    QVERIFY(s->isDefaults());
+    s->read();
+    QVERIFY(!s->isSaveNeeded());
+    QCOMPARE(mMyBool, true);
+    QVERIFY(!s->isDefaults());
+
+    // all the values swapped by useDefaults() are looked at again
+    s->useDefaults(true);
+    QCOMPARE(mMyBool, false);
+    QVERIFY(s->isDefaults());
+    QVERIFY(s->isSaveNeeded());
+    s->useDefaults(false);
+    QCOMPARE(mMyBool, true);
+    QVERIFY(!s->isDefaults());
+    QVERIFY(!s->isSaveNeeded());
+}
+
+void KConfigSkeletonTest::testIncrementalLoad()
+{
+    const QString path = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QLatin1String{"/kconfigskeletontestrc"};
+    s->load();
+    QCOMPARE(mMyString, s_default_setting4);
+
+    // another process changes one group while the skeleton has a change of its own
+    {
+        KConfig other(path, KConfig::SimpleConfig);
+        other.group(QStringLiteral("MyOtherGroup")).writeEntry("MySetting4", QStringLiteral("other"));
+        QVERIFY(other.sync());
+    }
+    mMyBool = true;
+    s->load();
+    QCOMPARE(mMyString, QStringLiteral("other"));
+    QCOMPARE(mMyBool, s_default_setting1);
+    QCOMPARE(mMyFont, defaultSetting3());
+    QVERIFY(!s->isSaveNeeded());
+
+    // nothing changed
+    s->load();
+    QCOMPARE(mMyString, QStringLiteral("other"));
+    QCOMPARE(mMyBool, s_default_setting1);
+
+    // a change through the shared config, without the files being touched
+    s->config()->group(QStringLiteral("MyGroup")).writeEntry("MySetting1", true);
+    s->load();
+    QCOMPARE(mMyBool, true);
+
+    {
+        KConfig other(path, KConfig::SimpleConfig);
+        other.group(QStringLiteral("MyOtherGroup")).writeEntry("MySetting4", QStringLiteral("changed again"));
+        QVERIFY(other.sync());
+    }
+    s->load();
+    QCOMPARE(mMyString, QStringLiteral("changed again"));
+    QCOMPARE(mMyBool, true);
+}
+
+void KConfigSkeletonTest::testFindItemByKey()
+{
+    QCOMPARE(s->findItem(QStringLiteral("MyGroup"), QStringLiteral("MySetting1")), static_cast<KConfigSkeletonItem *>(itemBool));
+    QCOMPARE(s->findItem(QStringLiteral("MyOtherGroup"), QStringLiteral("MySetting4")), s->findItem(QStringLiteral("MySetting4")));
+    QVERIFY(!s->findItem(QStringLiteral("MyOtherGroup"), QStringLiteral("MySetting1")));
+
+    itemBool->setGroup(QStringLiteral("MyOtherGroup"));
+    itemBool->setKey(QStringLiteral("Moved"));
+    QVERIFY(!s->findItem(QStringLiteral("MyGroup"), QStringLiteral("MySetting1")));
+    QCOMPARE(s->findItem(QStringLiteral("MyOtherGroup"), QStringLiteral("Moved")), static_cast<KConfigSkeletonItem *>(itemBool));
+
+    s->removeItem(itemBool->name());
+    QVERIFY(!s->findItem(QStringLiteral("MyOtherGroup"), QStringLiteral("Moved")));
+    s->clearItems();
+    QVERIFY(!s->findItem(QStringLiteral("MyOtherGroup"), QStringLiteral("MySetting4")));
+}
+
+void KConfigSkeletonTest::testChangedKey()
+{
+    // converts the key once, the next write must not reuse it
+    s->read();
+
+    itemBool->setKey(QStringLiteral("Größe"));
+    mMyBool = s_write_setting1;
+    s->save();
+    const KConfigGroup group = s->sharedConfig()->group(QStringLiteral("MyGroup"));
+    QCOMPARE(group.readEntry("Größe", s_default_setting1), s_write_setting1);
+    QVERIFY(!group.hasKey("MySetting1"));
+
+    mMyBool = s_default_setting1;
+    s->read();
+    QCOMPARE(mMyBool, s_write_setting1);
+}
+
+void KConfigSkeletonTest::testSnapshots()
+{
+    QVERIFY(!s->snapshot());
+    s->setSnapshotsEnabled(true);
+    const KCoreConfigSkeleton::Snapshot first = s->snapshot();
+    QVERIFY(first);
+    QCOMPARE(first->value(QStringLiteral("MySetting1")).toBool(), s_default_setting1);
+    QCOMPARE(first->value(QStringLiteral("MySetting4")).toString(), s_default_setting4);
+
+    // only saving publishes the change
+    mMyBool = s_write_setting1;
+    QCOMPARE(s->snapshot(), first);
+    QVERIFY(s->save());
+    const KCoreConfigSkeleton::Snapshot saved = s->snapshot();
+    QVERIFY(saved != first);
+    QCOMPARE(saved->value(QStringLiteral("MySetting1")).toBool(), s_write_setting1);
+    QCOMPARE(first->value(QStringLiteral("MySetting1")).toBool(), s_default_setting1);
+
+    // reading what is already in it keeps it
+    s->load();
+    QCOMPARE(s->snapshot(), saved);
+
+    // what another thread took stays as it was when the skeleton loads a change
+    s->config()->group(QStringLiteral("MyOtherGroup")).writeEntry("MySetting4", QStringLiteral("changed"));
+    KCoreConfigSkeleton::Snapshot taken;
+    std::thread reader([this, &taken] {
+        taken = s->snapshot();
+    });
+    reader.join();
+    s->load();
+    QCOMPARE(taken->value(QStringLiteral("MySetting4")).toString(), s_default_setting4);
+    QCOMPARE(s->snapshot()->value(QStringLiteral("MySetting4")).toString(), QStringLiteral("changed"));
+
+    s->setSnapshotsEnabled(false);
+    QVERIFY(!s->snapshot());
+}
+
+void KConfigSkeletonTest::testEnumChoices()
+{
+    qint32 side = 0;
+    QList<KCoreConfigSkeleton::ItemEnum::Choice> choices(3);
+    choices[0].name = QStringLiteral("Left");
+    choices[1].name = QStringLiteral("Right");
+    choices[2].name = QStringLiteral("Straight");
+    auto *item = new KCoreConfigSkeleton::ItemEnum(QStringLiteral("MyGroup"), QStringLiteral("Side"), side, choices, 2);
+    s->addItem(item);
+    item->setValueForChoice(QStringLiteral("Right"), QStringLiteral("East"));
+    QCOMPARE(side, 2);
+
+    KConfigGroup group = s->config()->group(QStringLiteral("MyGroup"));
+    const auto readSide = [&](const QString &value) {
+        group.writeEntry("Side", value);
+        s->read();
+        return side;
+    };
+    QCOMPARE(readSide(QStringLiteral("left")), 0);
+    QCOMPARE(readSide(QStringLiteral("EAST")), 1);
+    QCOMPARE(readSide(QStringLiteral("Right")), 2); // no longer the value of a choice
+    QCOMPARE(readSide(QStringLiteral("1")), 1);
+    QCOMPARE(readSide(QStringLiteral("nowhere")), 2);
+
+    // a value set later is used on the next read
+    item->setValueForChoice(QStringLiteral("Left"), QStringLiteral("West"));
+    QCOMPARE(readSide(QStringLiteral("west")), 0);
+
+    group.deleteEntry("Side");
+    s->read();
+    QCOMPARE(side, 2);
+    s->removeItem(QStringLiteral("Side"));
+}
+
+void KConfigSkeletonTest::testAutoReload()
+{
+    QVERIFY(!s->autoReload());
+    s->setAutoReload(true);
+    QVERIFY(s->autoReload());
+
+    // only the notified item is read again, the change of another one stays
+    mMyBool = true;
+    {
+        KConfig other(QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QLatin1String{"/kconfigskeletontestrc"}, KConfig::SimpleConfig);
+        other.group(QStringLiteral("MyOtherGroup")).writeEntry("MySetting4", QStringLiteral("notified"), KConfig::Notify);
+        QVERIFY(other.sync());
+    }
+    QTRY_COMPARE(mMyString, QStringLiteral("notified"));
+    QCOMPARE(mMyBool, true);
+
+    s->setAutoReload(false);
+    QVERIFY(!s->autoReload());
+}
+
+void KConfigSkeletonTest::testListItemCompare()
+{
+    const QStringList defaults{QStringLiteral("a"), QStringLiteral("b")};
+    QStringList list;
+    auto *item = s->addItemStringList(QStringLiteral("MyList"), list, defaults);
+    item->setDefault();
+    QVERIFY(item->isDefault());
+
+    // an equal copy of its own is still the default and nothing to save
+    list = QStringList{QStringLiteral("a"), QStringLiteral("b")};
+    QVERIFY(item->isDefault());
+    QVERIFY(item->isDefault());
+    item->readConfig(s->config());
+    QVERIFY(!item->isSaveNeeded());
+    list = QStringList{QStringLiteral("a"), QStringLiteral("b")};
+    QVERIFY(!item->isSaveNeeded());
+
+    list.append(QStringLiteral("c"));
+    QVERIFY(!item->isDefault());
+    QVERIFY(item->isSaveNeeded());
+    s->removeItem(QStringLiteral("MyList"));
+}
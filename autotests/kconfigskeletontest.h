@@ -22,6 +22,15 @@ private Q_SLOTS:
     void testClear();
     void testKConfigDirty();
     void testSaveRead();
+    void testGroupsOfItems();
+    void testTrackChanges();
+    void testIncrementalLoad();
+    void testFindItemByKey();
+    void testChangedKey();
+    void testSnapshots();
+    void testEnumChoices();
+    void testAutoReload();
+    void testListItemCompare();
 
 private:
     KConfigSkeleton *s;
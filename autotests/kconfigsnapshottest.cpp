@@ -0,0 +1,207 @@
+/*  This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include <QFile>
+#include <QStandardPaths>
+#include <QTest>
+#include <QtConcurrentRun>
+
+#include <KConfigGroup>
+#include <KConfigGroupSnapshot>
+#include <KConfigSnapshot>
+
+class KConfigSnapshotTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testSnapshot();
+    void testNull();
+    void testOpenFromThreads();
+    void testOpenAfterSync();
+    void testUpdateFromThreads();
+    void testGroupSnapshot();
+
+private:
+    QString m_fileName;
+};
+
+void KConfigSnapshotTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    m_fileName = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QLatin1String("/kconfigsnapshottestrc");
+    QFile::remove(m_fileName);
+
+    KConfig config(m_fileName, KConfig::SimpleConfig);
+    KConfigGroup group = config.group(QStringLiteral("Group"));
+    group.writeEntry("Key", "value");
+    group.writeEntry("Escaped", "a\tb");
+    group.writePathEntry("Path", QStringLiteral("$HOME/file"));
+    group.writeEntry("Gone", "soon");
+    group.deleteEntry("Gone");
+    group.group(QStringLiteral("Sub")).writeEntry("Nested", "yes");
+    config.group(QStringLiteral("Other")).writeEntry("Key", 42);
+    QVERIFY(config.sync());
+}
+
+void KConfigSnapshotTest::testSnapshot()
+{
+    KConfig config(m_fileName, KConfig::SimpleConfig);
+    KConfigGroup group = config.group(QStringLiteral("Group"));
+    group.writeEntry("Unsaved", "new");
+
+    const KConfigSnapshot snapshot = config.snapshot();
+    QCOMPARE(snapshot.name(), m_fileName);
+    QCOMPARE(snapshot.groupList(), (QStringList{QStringLiteral("Group"), QStringLiteral("Other")}));
+    QCOMPARE(snapshot.keyList(QStringLiteral("Group")),
+             (QStringList{QStringLiteral("Escaped"), QStringLiteral("Key"), QStringLiteral("Path"), QStringLiteral("Unsaved")}));
+    QVERIFY(snapshot.hasGroup(QStringLiteral("Group")));
+    QVERIFY(snapshot.hasGroup(QStringLiteral("Group\x1dSub")));
+    QVERIFY(!snapshot.hasGroup(QStringLiteral("Missing")));
+    QVERIFY(snapshot.hasKey(QStringLiteral("Group"), "Key"));
+    QVERIFY(!snapshot.hasKey(QStringLiteral("Group"), "Gone"));
+
+    QCOMPARE(snapshot.readEntry(QStringLiteral("Group"), "Key"), QStringLiteral("value"));
+    QCOMPARE(snapshot.readEntry(QStringLiteral("Group"), "Escaped"), QStringLiteral("a\tb"));
+    QCOMPARE(snapshot.readEntry(QStringLiteral("Group"), "Path"), group.readPathEntry("Path", QString()));
+    QCOMPARE(snapshot.readEntry(QStringLiteral("Group"), "Unsaved"), QStringLiteral("new"));
+    QCOMPARE(snapshot.readEntry(QStringLiteral("Group\x1dSub"), "Nested"), QStringLiteral("yes"));
+    QCOMPARE(snapshot.readEntry(QStringLiteral("Other"), "Key"), QStringLiteral("42"));
+    QCOMPARE(snapshot.readEntry(QStringLiteral("Group"), "Missing", QStringLiteral("default")), QStringLiteral("default"));
+
+    // later changes don't show up in it
+    group.writeEntry("Key", "changed");
+    group.deleteEntry("Unsaved");
+    QCOMPARE(snapshot.readEntry(QStringLiteral("Group"), "Key"), QStringLiteral("value"));
+    QCOMPARE(snapshot.readEntry(QStringLiteral("Group"), "Unsaved"), QStringLiteral("new"));
+    QCOMPARE(config.snapshot().readEntry(QStringLiteral("Group"), "Key"), QStringLiteral("changed"));
+    config.markAsClean();
+}
+
+void KConfigSnapshotTest::testNull()
+{
+    const KConfigSnapshot snapshot;
+    QVERIFY(snapshot.isNull());
+    QVERIFY(snapshot.name().isEmpty());
+    QVERIFY(snapshot.groupList().isEmpty());
+    QCOMPARE(snapshot.readEntry(QStringLiteral("Group"), "Key", QStringLiteral("default")), QStringLiteral("default"));
+    QVERIFY(!KConfig(m_fileName, KConfig::SimpleConfig).snapshot().isNull());
+}
+
+void KConfigSnapshotTest::testOpenFromThreads()
+{
+    QList<QFuture<QString>> futures;
+    for (int i = 0; i < 8; ++i) {
+        futures.append(QtConcurrent::run([this]() {
+            QString values;
+            for (int j = 0; j < 100; ++j) {
+                const KConfigSnapshot snapshot = KConfigSnapshot::open(m_fileName, KConfig::SimpleConfig);
+                values = snapshot.readEntry(QStringLiteral("Group"), "Key") + snapshot.readEntry(QStringLiteral("Group"), "Escaped");
+            }
+            return values;
+        }));
+    }
+    for (QFuture<QString> &future : futures) {
+        QCOMPARE(future.result(), QStringLiteral("valuea\tb"));
+    }
+}
+
+void KConfigSnapshotTest::testOpenAfterSync()
+{
+    QCOMPARE(KConfigSnapshot::open(m_fileName, KConfig::SimpleConfig).readEntry(QStringLiteral("Other"), "Key"), QStringLiteral("42"));
+
+    KConfig config(m_fileName, KConfig::SimpleConfig);
+    config.group(QStringLiteral("Other")).writeEntry("Key", 43);
+    QCOMPARE(KConfigSnapshot::open(m_fileName, KConfig::SimpleConfig).readEntry(QStringLiteral("Other"), "Key"), QStringLiteral("42"));
+    QVERIFY(config.sync());
+    QCOMPARE(KConfigSnapshot::open(m_fileName, KConfig::SimpleConfig).readEntry(QStringLiteral("Other"), "Key"), QStringLiteral("43"));
+}
+
+void KConfigSnapshotTest::testUpdateFromThreads()
+{
+    QVERIFY(KConfigSnapshot::update(
+        m_fileName,
+        [](KConfig &config) {
+            config.group(QStringLiteral("Update")).writeEntry("Counter", 0);
+        },
+        KConfig::SimpleConfig));
+
+    // the read, modify and write of each update must not overlap with the others
+    QList<QFuture<bool>> futures;
+    for (int i = 0; i < 8; ++i) {
+        futures.append(QtConcurrent::run([this]() {
+            bool ok = true;
+            for (int j = 0; j < 10; ++j) {
+                ok = ok
+                    && KConfigSnapshot::update(
+                         m_fileName,
+                         [](KConfig &config) {
+                             KConfigGroup group = config.group(QStringLiteral("Update"));
+                             group.writeEntry("Counter", group.readEntry("Counter", 0) + 1);
+                         },
+                         KConfig::SimpleConfig);
+                ok = ok && !KConfigSnapshot::open(m_fileName, KConfig::SimpleConfig).readEntry(QStringLiteral("Update"), "Counter").isEmpty();
+            }
+            return ok;
+        }));
+    }
+    for (QFuture<bool> &future : futures) {
+        QVERIFY(future.result());
+    }
+    QCOMPARE(KConfigSnapshot::open(m_fileName, KConfig::SimpleConfig).readEntry(QStringLiteral("Update"), "Counter"), QStringLiteral("80"));
+    QCOMPARE(KConfig(m_fileName, KConfig::SimpleConfig).group(QStringLiteral("Update")).readEntry("Counter", 0), 80);
+}
+
+void KConfigSnapshotTest::testGroupSnapshot()
+{
+    KConfig config(m_fileName, KConfig::SimpleConfig);
+    KConfigGroup group = config.group(QStringLiteral("Group"));
+    group.writeEntry("List", QStringList{QStringLiteral("a"), QStringLiteral("b,c")});
+    group.writeEntry("Flag", true);
+    group.writeEntry("Ratio", 0.5);
+
+    const KConfigGroupSnapshot snapshot = group.snapshot();
+    QVERIFY(!snapshot.isNull());
+    QCOMPARE(snapshot.name(), QStringLiteral("Group"));
+    QCOMPARE(snapshot.keyList(),
+             (QStringList{QStringLiteral("Escaped"), QStringLiteral("Flag"), QStringLiteral("Key"), QStringLiteral("List"), QStringLiteral("Path"), QStringLiteral("Ratio")}));
+    QVERIFY(snapshot.hasKey("Key"));
+    QVERIFY(!snapshot.hasKey("Gone"));
+    QVERIFY(!snapshot.hasKey("Nested"));
+
+    QCOMPARE(snapshot.readEntry("Key"), QStringLiteral("value"));
+    QCOMPARE(snapshot.readEntry("Escaped"), QStringLiteral("a\tb"));
+    QCOMPARE(snapshot.readEntry("Path"), group.readPathEntry("Path", QString()));
+    QCOMPARE(snapshot.readEntry("List", QStringList()), (QStringList{QStringLiteral("a"), QStringLiteral("b,c")}));
+    QCOMPARE(snapshot.readEntry("Missing", QStringLiteral("default")), QStringLiteral("default"));
+    QCOMPARE(snapshot.readBoolEntry("Flag", false), true);
+    QCOMPARE(snapshot.readDoubleEntry("Ratio", 0), 0.5);
+    QCOMPARE(snapshot.readIntEntry("Key", 7), 7);
+
+    const KConfigGroupSnapshot other = config.group(QStringLiteral("Other")).snapshot();
+    QCOMPARE(other.readIntEntry("Key", 0), 42);
+    QCOMPARE(other.readInt64Entry("Key", 0), 42);
+    QCOMPARE(group.group(QStringLiteral("Sub")).snapshot().readEntry("Nested"), QStringLiteral("yes"));
+
+    // later changes don't show up in it
+    group.writeEntry("Key", "changed");
+    group.deleteEntry("List");
+    QCOMPARE(snapshot.readEntry("Key"), QStringLiteral("value"));
+    QVERIFY(snapshot.hasKey("List"));
+    QCOMPARE(group.snapshot().readEntry("Key"), QStringLiteral("changed"));
+
+    const KConfigGroupSnapshot null;
+    QVERIFY(null.isNull());
+    QVERIFY(null.keyList().isEmpty());
+    QCOMPARE(null.readIntEntry("Key", 3), 3);
+}
+
+QTEST_MAIN(KConfigSnapshotTest)
+
+#include "kconfigsnapshottest.moc"
@@ -9,6 +9,8 @@
 
 #include "config-kconfig.h"
 
+#include <QDateTime>
+#include <QRect>
 #include <QSignalSpy>
 #include <QStandardPaths>
 #include <QTemporaryFile>
@@ -17,10 +19,20 @@
 #include <qtemporarydir.h>
 
 #include <kauthorized.h>
+#include <kconfig_p.h>
+#include <kconfigentry.h>
+#include <kconfigcompiled_p.h>
+#include <kconfignotify_p.h>
 #include <kconfiggroup.h>
+#include <kconfiginireader.h>
+#include <kconfigstringpool_p.h>
 #include <kconfigwatcher.h>
 #include <ksharedconfig.h>
 
+#include <limits>
+#include <memory>
+#include <vector>
+
 #ifdef Q_OS_UNIX
 #include <utime.h>
 #endif
@@ -503,6 +515,79 @@ void KConfigTest::testLists()
     QCOMPARE(sc3.readEntry("listOfByteArraysEntry1", QList<QByteArray>()), s_bytearray_list_entry1);
 }
 
+void KConfigTest::testTypedLists()
+{
+    // these lists don't go through a QVariantList, they must still give the text they always did
+    KConfig config(QString(), KConfig::SimpleConfig);
+    KConfigGroup group = config.group(QStringLiteral("Lists"));
+    const auto variants = [](const auto &list) {
+        QVariantList variants;
+        for (const auto &value : list) {
+            variants.append(QVariant::fromValue(value));
+        }
+        return variants;
+    };
+    const auto compareText = [&group](const char *key, const QVariantList &list) {
+        KConfig other(QString(), KConfig::SimpleConfig);
+        KConfigGroup otherGroup = other.group(QStringLiteral("Lists"));
+        otherGroup.writeEntry(key, list);
+        return group.readEntry(key, QString()) == otherGroup.readEntry(key, QString());
+    };
+
+    const QList<int> ints = {0, -1, 1200, std::numeric_limits<int>::min(), std::numeric_limits<int>::max()};
+    group.writeEntry("Ints", ints);
+    QVERIFY(compareText("Ints", variants(ints)));
+    QCOMPARE(group.readEntry("Ints", QList<int>()), ints);
+
+    const QList<qint64> longs = {std::numeric_limits<qint64>::min(), 0, std::numeric_limits<qint64>::max()};
+    group.writeEntry("Longs", longs);
+    QVERIFY(compareText("Longs", variants(longs)));
+    QCOMPARE(group.readEntry("Longs", QList<qint64>()), longs);
+
+    const QList<double> reals = {0.0, -0.5, 1.0 / 3, 1e21, 1.5e-7};
+    group.writeEntry("Reals", reals);
+    QVERIFY(compareText("Reals", variants(reals)));
+    QCOMPARE(group.readEntry("Reals", QList<double>()), reals);
+
+    const QList<QUrl> urls = {QUrl(QStringLiteral("file:///home/a,b")), QUrl(QStringLiteral("https://example.com/?q=1,2")), QUrl()};
+    group.writeEntry("Urls", urls);
+    QVERIFY(compareText("Urls", variants(urls)));
+    QCOMPARE(group.readEntry("Urls", QList<QUrl>()), urls);
+
+    // what the QVariantList conversion made of missing, empty and broken elements
+    const QList<int> fallback = {7};
+    QCOMPARE(group.readEntry("Missing", fallback), fallback);
+    group.writeEntry("Ints", QList<int>());
+    QCOMPARE(group.readEntry("Ints", fallback), QList<int>());
+    group.writeEntry("Ints", QStringLiteral("1,2,x,,4"));
+    QCOMPARE(group.readEntry("Ints", fallback), (QList<int>{1, 2, 0, 0, 4}));
+    group.writeEntry("Ints", QStringLiteral("\\0"));
+    QCOMPARE(group.readEntry("Ints", fallback), QList<int>{0});
+}
+
+void KConfigTest::testLongLists()
+{
+    QStringList list;
+    for (int i = 0; i < 5000; ++i) {
+        list << QStringLiteral("/home/user/Documents/file %1.odt").arg(i) << QStringLiteral("a,b\\c\\,%1").arg(i) << QString() << QStringLiteral("äöü€ %1").arg(i);
+    }
+
+    KConfig config(KConfig::ConfigAssociation::KdeApp, QString(), KConfig::SimpleConfig);
+    KConfigGroup group = config.group("Lists");
+    group.writeEntry("Long", list);
+    QCOMPARE(group.readEntry("Long", QStringList()), list);
+    QCOMPARE(group.readEntry("Long", QVariantList()).size(), list.size());
+    QCOMPARE(group.readEntry("Long", QVariant(QStringList())).toStringList(), list);
+
+    // the serialized form is unchanged
+    group.writeEntry("Short", QStringList{QStringLiteral("a,b"), QStringLiteral("c\\"), QString()});
+    QCOMPARE(group.readEntry("Short", QString()), QStringLiteral("a\\,b,c\\\\,"));
+
+    // expanded entries are expanded before they are split
+    group.writePathEntry("Paths", QStringList{QDir::homePath() + QLatin1String("/a,b"), QStringLiteral("/tmp")});
+    QCOMPARE(group.readEntry("Paths", QStringList()), (QStringList{QDir::homePath() + QLatin1String("/a,b"), QStringLiteral("/tmp")}));
+}
+
 void KConfigTest::testPath()
 {
     KConfig sc2(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
@@ -552,6 +637,93 @@ void KConfigTest::testPath()
     QCOMPARE(group.readPathEntry(QStringLiteral("escapes"), QStringList()), val);
 }
 
+void KConfigTest::testExpansionCache()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(
+        "[Expand]\n"
+        "Path[$e]=$KCONFIGTEST_EXPAND/foo\n"
+        "List[$e]=$KCONFIGTEST_EXPAND/a,b\n");
+    file.close();
+
+    qputenv("KCONFIGTEST_EXPAND", "/first");
+    KConfig config(file.fileName(), KConfig::SimpleConfig);
+    KConfigGroup group = config.group("Expand");
+    QCOMPARE(group.readEntry("Path", QString()), QStringLiteral("/first/foo"));
+    QCOMPARE(group.readPathEntry("Path", QString()), QStringLiteral("/first/foo"));
+    QCOMPARE(group.readEntry("List", QStringList()), (QStringList{QStringLiteral("/first/a"), QStringLiteral("b")}));
+
+    // the expanded values are kept until they are invalidated
+    qputenv("KCONFIGTEST_EXPAND", "/second");
+    QCOMPARE(group.readEntry("Path", QString()), QStringLiteral("/first/foo"));
+    config.invalidateExpansions();
+    QCOMPARE(group.readEntry("Path", QString()), QStringLiteral("/second/foo"));
+    QCOMPARE(group.entryMap().value(QStringLiteral("Path")), QStringLiteral("/second/foo"));
+    QCOMPARE(group.readEntry("List", QStringList()), (QStringList{QStringLiteral("/second/a"), QStringLiteral("b")}));
+
+    // a changed entry is expanded again
+    QCOMPARE(group.readPathEntry("Path", QString()), QStringLiteral("/second/foo"));
+    group.writeEntry("Path", "$KCONFIGTEST_EXPAND/bar");
+    QCOMPARE(group.readPathEntry("Path", QString()), QStringLiteral("/second/bar"));
+    qunsetenv("KCONFIGTEST_EXPAND");
+}
+
+void KConfigTest::testReparseGroups()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(
+        "[Changed]\n"
+        "Key=old\n"
+        "[Changed][Sub]\n"
+        "Key=old\n"
+        "[Kept]\n"
+        "Key=old\n"
+        "[Removed]\n"
+        "Key=old\n");
+    file.close();
+
+    for (const KConfig::OpenFlags flags : {KConfig::SimpleConfig, KConfig::OpenFlags(KConfig::SimpleConfig | KConfig::LazyLoading)}) {
+        KConfig config(file.fileName(), flags);
+        QCOMPARE(config.group(QStringLiteral("Changed")).readEntry("Key"), QStringLiteral("old"));
+
+        {
+            KConfig writer(file.fileName(), KConfig::SimpleConfig);
+            writer.group(QStringLiteral("Changed")).writeEntry("Key", "new");
+            writer.group(QStringLiteral("Changed")).writeEntry("Added", "new");
+            writer.group(QStringLiteral("Changed")).group(QStringLiteral("Sub")).writeEntry("Key", "new");
+            writer.group(QStringLiteral("Kept")).writeEntry("Key", "new");
+            writer.group(QStringLiteral("Created")).writeEntry("Key", "new");
+            writer.deleteGroup(QStringLiteral("Removed"));
+            QVERIFY(writer.sync());
+        }
+
+        config.reparseGroups({QStringLiteral("Changed"), QStringLiteral("Created"), QStringLiteral("Removed")});
+        const KConfigGroup changed = config.group(QStringLiteral("Changed"));
+        QCOMPARE(changed.readEntry("Key"), QStringLiteral("new"));
+        QCOMPARE(changed.readEntry("Added"), QStringLiteral("new"));
+        QCOMPARE(config.group(QStringLiteral("Created")).readEntry("Key"), QStringLiteral("new"));
+        QVERIFY(!config.hasGroup(QStringLiteral("Removed")));
+        // not listed, so not read again
+        QCOMPARE(changed.group(QStringLiteral("Sub")).readEntry("Key"), QStringLiteral("old"));
+        QCOMPARE(config.group(QStringLiteral("Kept")).readEntry("Key"), QStringLiteral("old"));
+
+        config.reparseConfiguration();
+        QCOMPARE(config.group(QStringLiteral("Kept")).readEntry("Key"), QStringLiteral("new"));
+
+        // back to the initial file for the next round
+        KConfig writer(file.fileName(), KConfig::SimpleConfig);
+        writer.group(QStringLiteral("Changed")).writeEntry("Key", "old");
+        writer.group(QStringLiteral("Changed")).deleteEntry("Added");
+        writer.group(QStringLiteral("Changed")).group(QStringLiteral("Sub")).writeEntry("Key", "old");
+        writer.group(QStringLiteral("Kept")).writeEntry("Key", "old");
+        writer.deleteGroup(QStringLiteral("Created"));
+        writer.group(QStringLiteral("Removed")).writeEntry("Key", "old");
+        QVERIFY(writer.sync());
+    }
+}
+
 void KConfigTest::testPersistenceOfExpandFlagForPath()
 {
     // This test checks that a path entry starting with $HOME is still flagged
@@ -649,6 +821,78 @@ void KConfigTest::testEnums()
     QVERIFY(sc3.readEntry("flags-bit0-bit1", Flags()) == bitfield);
 }
 
+void KConfigTest::testPrimitiveEntries()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(
+        "[Primitives]\n"
+        "True=true\n"
+        "No=No\n"
+        "Zero=0\n"
+        "Empty=\n"
+        "Int=-42\n"
+        "Escaped=\\s12\n"
+        "Huge=12345678901\n"
+        "NotANumber=12abc\n"
+        "Double=123456.78912345\n"
+        "Enum=Tens\n"
+        "Flags=bit0|bit1\n"
+        "Unknown=Fifties\n");
+    file.close();
+
+    KConfig config(file.fileName(), KConfig::SimpleConfig);
+    const KConfigGroup group = config.group("Primitives");
+    const QStringList keys = group.keyList() + QStringList{QStringLiteral("Missing")};
+    // the same results as readEntry()
+    for (const QString &key : keys) {
+        QCOMPARE(group.readBoolEntry(key, true), group.readEntry(key, true));
+        QCOMPARE(group.readBoolEntry(key, false), group.readEntry(key, false));
+        QCOMPARE(group.readIntEntry(key, 7), group.readEntry(key, 7));
+        QCOMPARE(group.readInt64Entry(key, 7), group.readEntry(key, qint64(7)));
+        QCOMPARE(group.readDoubleEntry(key, 0.5), group.readEntry(key, 0.5));
+    }
+    QCOMPARE(group.readBoolEntry("No", true), false);
+    QCOMPARE(group.readIntEntry("Int", 0), -42);
+    QCOMPARE(group.readIntEntry("Huge", 0), 0);
+    QCOMPARE(group.readInt64Entry("Huge", 0), Q_INT64_C(12345678901));
+    QCOMPARE(group.readDoubleEntry("Double", 0.0), 123456.78912345);
+
+    const QMetaEnum testing = QMetaEnum::fromType<Testing>();
+    QCOMPARE(group.readEnumEntry("Enum", testing, Ones), int(Tens));
+    QCOMPARE(group.readEnumEntry("Unknown", testing, Ones), int(Ones));
+    QCOMPARE(group.readEnumEntry("Missing", testing, Hundreds), int(Hundreds));
+    QCOMPARE(group.readEnumEntry("Flags", QMetaEnum::fromType<Flags>(), 0), int(bit0 | bit1));
+    QCOMPARE(group.readEnumEntry("Enum", QMetaEnum::fromType<Flags>(), 0), 0);
+}
+
+void KConfigTest::testRawEntries()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(
+        "[Raw]\n"
+        "Plain=none\n"
+        "Escaped=\\sa\\tb\n"
+        "Utf8=\xc3\xa4\n"
+        "Path[$e]=$HOME/file\n"
+        "Gone[$d]\n");
+    file.close();
+
+    KConfig config(file.fileName(), KConfig::SimpleConfig);
+    KConfigGroup group = config.group(QStringLiteral("Raw"));
+    QCOMPARE(group.readEntryRaw("Plain").toByteArray(), QByteArray("none"));
+    QCOMPARE(group.readEntryRaw(QStringLiteral("Escaped")).toByteArray(), QByteArray(" a\tb"));
+    QCOMPARE(QString::fromUtf8(group.readEntryRaw("Utf8")), QStringLiteral("\u00e4"));
+    // no dollar expansion
+    QCOMPARE(group.readEntryRaw("Path").toByteArray(), QByteArray("$HOME/file"));
+    QVERIFY(group.readEntryRaw("Gone").isNull());
+    QVERIFY(group.readEntryRaw("Missing").isNull());
+
+    group.writeEntry("Plain", "changed");
+    QCOMPARE(group.readEntryRaw("Plain").toByteArray(), QByteArray("changed"));
+}
+
 void KConfigTest::testEntryMap()
 {
     KConfig sc(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
@@ -1343,6 +1587,48 @@ static void ageTimeStamp(const QString &path, int nsec)
 #endif
 }
 
+void KConfigTest::testCascadeLookupCache()
+{
+#ifdef Q_XDG_PLATFORM
+    QTemporaryDir globalDir;
+    const QByteArray oldConfigDirs = qgetenv("XDG_CONFIG_DIRS");
+    qputenv("XDG_CONFIG_DIRS", QFile::encodeName(globalDir.path()));
+
+    const QString globalConfigDir = globalDir.path() + QLatin1Char('/') + s_test_subdir;
+    QVERIFY(QDir().mkpath(globalConfigDir));
+    const QString fileName = s_test_subdir + QLatin1String("cascadelookuprc");
+    // the lookups in a directory changed just now aren't cached, pretend it's older
+    ageTimeStamp(globalConfigDir, 60);
+    {
+        KConfig config(fileName, KConfig::NoGlobals);
+        QVERIFY(!config.hasGroup(QStringLiteral("Group")));
+    }
+
+    // adding the file changes its directory, which makes the cached lookup outdated
+    QFile global(globalConfigDir + QLatin1String("cascadelookuprc"));
+    QVERIFY(global.open(QIODevice::WriteOnly));
+    global.write("[Group]\nKey=global\n");
+    global.close();
+    {
+        KConfig config(fileName, KConfig::NoGlobals);
+        QCOMPARE(config.group(QStringLiteral("Group")).readEntry("Key"), QStringLiteral("global"));
+    }
+
+    // and so does removing it
+    ageTimeStamp(globalConfigDir, 60);
+    {
+        KConfig config(fileName, KConfig::NoGlobals);
+        QCOMPARE(config.group(QStringLiteral("Group")).readEntry("Key"), QStringLiteral("global"));
+    }
+    QVERIFY(global.remove());
+    {
+        KConfig config(fileName, KConfig::NoGlobals);
+        QVERIFY(!config.hasGroup(QStringLiteral("Group")));
+    }
+    qputenv("XDG_CONFIG_DIRS", oldConfigDirs);
+#endif
+}
+
 void KConfigTest::testWriteOnSync()
 {
     QDateTime oldStamp;
@@ -1388,6 +1674,8 @@ void KConfigTest::testFailOnReadOnlyFileSync()
     cgLocal.writeEntry("someLocalString", "whatever");
     QVERIFY(cgLocal.sync());
 
+    QVERIFY(sc.isConfigWritable(false));
+
     QFile f(m_testConfigDir + QLatin1String("kconfigfailonreadonlytest"));
     QVERIFY(f.exists());
     QVERIFY(f.setPermissions(QFileDevice::ReadOwner));
@@ -1399,6 +1687,8 @@ void KConfigTest::testFailOnReadOnlyFileSync()
 #endif
     cgLocal.writeEntry("someLocalString", "whatever2");
     QVERIFY(!cgLocal.sync());
+    // the failed sync() doesn't leave the answer of before
+    QVERIFY(!sc.isConfigWritable(false));
 
     QVERIFY(f.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner));
     QVERIFY(f.remove());
@@ -1947,10 +2237,1184 @@ void KConfigTest::testXdgListEntry()
     QCOMPARE(grp.readXdgListEntry("Key6", invalidList), (QStringList{QStringLiteral("1"), QStringLiteral("2;3"), QString{}}));
 }
 
+void KConfigTest::testCachedEntry()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(
+        "[Cached]\n"
+        "Number=42\n"
+        "Point=1,2\n"
+        "Path[$e]=$HOME/cached\n");
+    file.close();
+
+    KConfig config(file.fileName(), KConfig::SimpleConfig);
+    KConfigGroup group = config.group("Cached");
+    QCOMPARE(group.readCachedEntry("Number", 0), 42);
+    QCOMPARE(group.readCachedEntry("Number", 0), 42);
+    // the type and the default are part of the lookup
+    QCOMPARE(group.readCachedEntry("Number", QString()), QStringLiteral("42"));
+    QCOMPARE(group.readCachedEntry("Missing", 7), 7);
+    QCOMPARE(group.readCachedEntry("Missing", 8), 8);
+    QCOMPARE(group.readCachedEntry("Point", QPoint()), QPoint(1, 2));
+    // strings are expanded as by readEntry(const char *, const QString &)
+    QCOMPARE(group.readCachedEntry("Path", QString()), group.readEntry("Path", QString()));
+    QCOMPARE(group.readCachedEntry("Path", QString()), QDir::homePath() + QLatin1String("/cached"));
+
+    // any change drops the kept values
+    group.writeEntry("Number", 43);
+    QCOMPARE(group.readCachedEntry("Number", 0), 43);
+    group.deleteEntry("Number");
+    QCOMPARE(group.readCachedEntry("Number", -1), -1);
+    config.group("Other").writeEntry("Number", 1);
+    QCOMPARE(group.readCachedEntry("Number", -1), -1);
+    QVERIFY(config.sync());
+
+    QFile rewritten(file.fileName());
+    QVERIFY(rewritten.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    rewritten.write("[Cached]\nNumber=44\n");
+    rewritten.close();
+    QCOMPARE(group.readCachedEntry("Number", -1), -1);
+    config.reparseConfiguration();
+    QCOMPARE(group.readCachedEntry("Number", -1), 44);
+}
+
+void KConfigTest::testBatchWrite()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QTextStream out(&file);
+    out << "[Import]\n"
+        << "Existing=old\n"
+        << "Obsolete=gone soon\n";
+    out.flush();
+    file.close();
+
+    KConfig config(file.fileName(), KConfig::SimpleConfig);
+    KConfigGroup group = config.group("Import");
+    {
+        KConfigGroupBatch batch = group.beginBatch();
+        for (int i = 999; i >= 0; --i) {
+            batch.writeEntry(QStringLiteral("Key%1").arg(i), QString::number(i));
+        }
+        batch.writeEntry("Existing", QStringLiteral("new"));
+        batch.writeEntry("List", QStringList{QStringLiteral("a"), QStringLiteral("b,c")});
+        batch.writeEntry("Twice", "first");
+        batch.writeEntry("Twice", "second");
+        batch.deleteEntry("Obsolete");
+
+        // nothing happens before the batch is applied
+        QVERIFY(!config.isDirty());
+        QCOMPARE(group.readEntry("Existing"), QStringLiteral("old"));
+        batch.apply();
+        QVERIFY(config.isDirty());
+        QCOMPARE(group.readEntry("Existing"), QStringLiteral("new"));
+
+        batch.writeEntry("Late", "applied on destruction");
+    }
+    QCOMPARE(group.readEntry("Late"), QStringLiteral("applied on destruction"));
+    QVERIFY(config.sync());
+
+    KConfig reread(file.fileName(), KConfig::SimpleConfig);
+    const KConfigGroup readGroup = reread.group("Import");
+    QCOMPARE(readGroup.keyList().count(), 1000 + 4);
+    QCOMPARE(readGroup.readEntry("Key0"), QStringLiteral("0"));
+    QCOMPARE(readGroup.readEntry("Key999", 0), 999);
+    QCOMPARE(readGroup.readEntry("Existing"), QStringLiteral("new"));
+    QCOMPARE(readGroup.readEntry("List", QStringList()), (QStringList{QStringLiteral("a"), QStringLiteral("b,c")}));
+    QCOMPARE(readGroup.readEntry("Twice"), QStringLiteral("second"));
+    QVERIFY(!readGroup.hasKey("Obsolete"));
+
+    // writes without Persistent don't make the config dirty
+    KConfigGroup transient = reread.group("Import");
+    transient.beginBatch().writeEntry("Transient", "value", KConfigBase::WriteConfigFlags());
+    QCOMPARE(transient.readEntry("Transient"), QStringLiteral("value"));
+    QVERIFY(!reread.isDirty());
+}
+
+void KConfigTest::testWriteKeepsUnchangedGroups()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(
+        "Top=level\n"
+        "[Kept]\n"
+        "# a comment that survives\n"
+        "Spaced   =   value\n"
+        "Name[fr]=Nom\n"
+        "\n"
+        "\n"
+        "[Changed]\n"
+        "# this group is written anew\n"
+        "Key=old\n"
+        "[Split]\n"
+        "First=1\n"
+        "[Kept][Sub]\n"
+        "Nested=yes\n"
+        "[Split]\n"
+        "Second=2\n");
+    file.close();
+
+    KConfig config(file.fileName(), KConfig::SimpleConfig);
+    config.group("Changed").writeEntry("Key", "new");
+    config.group("Added").writeEntry("Key", "value");
+    QVERIFY(config.sync());
+
+    QFile written(file.fileName());
+    QVERIFY(written.open(QIODevice::ReadOnly | QIODevice::Text));
+    QCOMPARE(written.readAll(),
+             QByteArray("Top=level\n"
+                        "\n"
+                        "[Added]\n"
+                        "Key=value\n"
+                        "\n"
+                        "[Changed]\n"
+                        "Key=new\n"
+                        "\n"
+                        "[Kept]\n"
+                        "# a comment that survives\n"
+                        "Spaced   =   value\n"
+                        "Name[fr]=Nom\n"
+                        "\n"
+                        "[Kept][Sub]\n"
+                        "Nested=yes\n"
+                        "\n"
+                        "[Split]\n"
+                        "First=1\n"
+                        "Second=2\n"));
+
+    KConfig reread(file.fileName(), KConfig::SimpleConfig);
+    QCOMPARE(reread.group("Kept").readEntry("Spaced"), QStringLiteral("value"));
+    QCOMPARE(reread.group("Kept").group("Sub").readEntry("Nested"), QStringLiteral("yes"));
+    QCOMPARE(reread.group("Changed").readEntry("Key"), QStringLiteral("new"));
+    QCOMPARE(reread.group("Split").keyList(), (QStringList{QStringLiteral("First"), QStringLiteral("Second")}));
+}
+
+void KConfigTest::testWriteEscaping()
+{
+    // enough groups for the output to be written in several chunks
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.close();
+    const QList<QByteArray> values = {"plain", " leading", "trailing ", "line\nbreak", "back\\slash", "[brackets]=", "caf\xc3\xa9", "bad\xff"};
+    {
+        KConfig config(file.fileName(), KConfig::SimpleConfig);
+        for (int i = 0; i < 2000; ++i) {
+            KConfigGroup group = config.group(QStringLiteral("Group [%1]").arg(i));
+            for (int j = 0; j < values.size(); ++j) {
+                group.writeEntry(QByteArray("Key=" + QByteArray::number(j)).constData(), values.at(j));
+            }
+        }
+        QVERIFY(config.sync());
+    }
+
+    QFile written(file.fileName());
+    QVERIFY(written.open(QIODevice::ReadOnly | QIODevice::Text));
+    const QByteArray contents = written.readAll();
+    QVERIFY(contents.size() > 128 * 1024);
+    QVERIFY(contents.startsWith("[Group \\x5b0\\x5d]\nKey\\x3d0=plain\nKey\\x3d1=\\sleading\nKey\\x3d2=trailing\\s\n"
+                                "Key\\x3d3=line\\nbreak\nKey\\x3d4=back\\\\slash\nKey\\x3d5=[brackets]=\n"
+                                "Key\\x3d6=caf\xc3\xa9\nKey\\x3d7=bad\\xff\n"));
+
+    KConfig reread(file.fileName(), KConfig::SimpleConfig);
+    QCOMPARE(reread.groupList().size(), 2000);
+    const KConfigGroup last = reread.group(QStringLiteral("Group [1999]"));
+    for (int j = 0; j < values.size(); ++j) {
+        QCOMPARE(last.readEntry(QByteArray("Key=" + QByteArray::number(j)).constData(), QByteArray()), values.at(j));
+    }
+}
+
+void KConfigTest::testWriteNumbers()
+{
+    // the numbers are formatted without QString, they must still give the text they always did
+    KConfig config(QString(), KConfig::SimpleConfig);
+    KConfigGroup group = config.group(QStringLiteral("Numbers"));
+    const QVariantList values = {0,
+                                 -1,
+                                 std::numeric_limits<int>::min(),
+                                 std::numeric_limits<uint>::max(),
+                                 std::numeric_limits<qlonglong>::min(),
+                                 std::numeric_limits<qulonglong>::max(),
+                                 0.0,
+                                 -0.5,
+                                 0.1,
+                                 1.0 / 3,
+                                 100000.0,
+                                 1e6,
+                                 1e21,
+                                 1.5e-7,
+                                 std::numeric_limits<double>::max(),
+                                 std::numeric_limits<double>::denorm_min(),
+                                 true,
+                                 false};
+    for (const QVariant &value : values) {
+        group.writeEntry("Key", value);
+        QCOMPARE(group.readEntry("Key", QString()), value.toString());
+    }
+
+    group.writeEntry("Point", QPoint(-3, 4));
+    QCOMPARE(group.readEntry("Point", QString()), QStringLiteral("-3,4"));
+    group.writeEntry("Rect", QRect(1, 2, 300, 400));
+    QCOMPARE(group.readEntry("Rect", QString()), QStringLiteral("1,2,300,400"));
+    group.writeEntry("Size", QSize(1920, 1080));
+    QCOMPARE(group.readEntry("Size", QString()), QStringLiteral("1920,1080"));
+    group.writeEntry("RectF", QRectF(0.5, -1, 2.25, 1e-3));
+    QCOMPARE(group.readEntry("RectF", QString()), QStringLiteral("0.5,-1,2.25,0.001"));
+    QCOMPARE(group.readEntry("RectF", QRectF()), QRectF(0.5, -1, 2.25, 1e-3));
+    group.writeEntry("Date", QDate(2026, 3, 9));
+    QCOMPARE(group.readEntry("Date", QString()), QStringLiteral("2026,3,9"));
+    group.writeEntry("DateTime", QDateTime(QDate(2026, 3, 9), QTime(8, 5, 7, 250)));
+    QCOMPARE(group.readEntry("DateTime", QString()), QStringLiteral("2026,3,9,8,5,7.25"));
+}
+void KConfigTest::testWriteMergesExternalChanges()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.close();
+
+    KConfig config(file.fileName(), KConfig::SimpleConfig);
+    config.group(QStringLiteral("<default>")).writeEntry("Top", "a\tb");
+    config.group(QStringLiteral("Mine")).writeEntry("Key", "1");
+    config.group(QStringLiteral("Escaped")).writeEntry("Key", " x\ny ");
+    QVERIFY(config.sync());
+
+    // the file wasn't touched in between, what was written last is merged with
+    config.group(QStringLiteral("Mine")).writeEntry("Key", "2");
+    QVERIFY(config.sync());
+    {
+        KConfig reread(file.fileName(), KConfig::SimpleConfig);
+        QCOMPARE(reread.group(QStringLiteral("<default>")).readEntry("Top"), QStringLiteral("a\tb"));
+        QCOMPARE(reread.group(QStringLiteral("Mine")).readEntry("Key"), QStringLiteral("2"));
+        QCOMPARE(reread.group(QStringLiteral("Escaped")).readEntry("Key"), QStringLiteral(" x\ny "));
+    }
+
+    // another writer changed the file, its changes are kept
+    {
+        KConfig other(file.fileName(), KConfig::SimpleConfig);
+        other.group(QStringLiteral("Theirs")).writeEntry("Key", "theirs");
+        QVERIFY(other.sync());
+    }
+    config.group(QStringLiteral("Mine")).writeEntry("Key", "3");
+    QVERIFY(config.sync());
+
+    KConfig reread(file.fileName(), KConfig::SimpleConfig);
+    QCOMPARE(reread.group(QStringLiteral("Theirs")).readEntry("Key"), QStringLiteral("theirs"));
+    QCOMPARE(reread.group(QStringLiteral("Mine")).readEntry("Key"), QStringLiteral("3"));
+    QCOMPARE(reread.group(QStringLiteral("Escaped")).readEntry("Key"), QStringLiteral(" x\ny "));
+    QCOMPARE(reread.group(QStringLiteral("<default>")).readEntry("Top"), QStringLiteral("a\tb"));
+}
+
+void KConfigTest::testLargeFileParse()
+{
+    // files above a certain size are mapped instead of being read, values
+    // with escape sequences must still be decoded correctly
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QTextStream out(&file);
+    for (int i = 0; i < 2000; ++i) {
+        out << "[Group" << i << "]\n"
+            << "Plain=value" << i << "\n"
+            << "Escaped=\\sline1\\nline2\\t\\x41\n";
+    }
+    out.flush();
+    QVERIFY(file.size() > 64 * 1024);
+    file.close();
+
+    KConfig config(KConfig::ConfigAssociation::KdeApp, file.fileName(), KConfig::SimpleConfig);
+    QCOMPARE(config.groupList().size(), 2000);
+    for (int i : {0, 999, 1999}) {
+        const KConfigGroup group = config.group(QStringLiteral("Group%1").arg(i));
+        QCOMPARE(group.readEntry("Plain"), QStringLiteral("value%1").arg(i));
+        QCOMPARE(group.readEntry("Escaped"), QStringLiteral(" line1\nline2\tA"));
+    }
+
+    // the file on disk must not have been touched by the in-place unescaping
+    QFile readFile(file.fileName());
+    QVERIFY(readFile.open(QFile::ReadOnly));
+    QVERIFY(readFile.readAll().contains("Escaped=\\sline1\\nline2\\t\\x41\n"));
+}
+
+void KConfigTest::testLargeFileWrite()
+{
+    // the groups of a large file are written to it as they are serialized
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QTextStream out(&file);
+    for (int i = 0; i < 30000; ++i) {
+        out << "[Group" << i << "]\n"
+            << "Plain=value" << i << "\n"
+            << "Escaped=\\sline1\\nline2\n";
+    }
+    out.flush();
+    QVERIFY(file.size() > 1024 * 1024);
+    file.close();
+
+    {
+        KConfig config(file.fileName(), KConfig::SimpleConfig);
+        config.group(QStringLiteral("Group15000")).writeEntry("Plain", QStringLiteral("changed"));
+        config.group(QStringLiteral("New")).writeEntry("Key", QStringLiteral("new"));
+        QVERIFY(config.sync());
+    }
+
+    KConfig reread(file.fileName(), KConfig::SimpleConfig);
+    QCOMPARE(reread.groupList().size(), 30001);
+    for (int i : {0, 14999, 15001, 29999}) {
+        const KConfigGroup group = reread.group(QStringLiteral("Group%1").arg(i));
+        QCOMPARE(group.readEntry("Plain"), QStringLiteral("value%1").arg(i));
+        QCOMPARE(group.readEntry("Escaped"), QStringLiteral(" line1\nline2"));
+    }
+    QCOMPARE(reread.group(QStringLiteral("Group15000")).readEntry("Plain"), QStringLiteral("changed"));
+    QCOMPARE(reread.group(QStringLiteral("New")).readEntry("Key"), QStringLiteral("new"));
+}
+
+void KConfigTest::testLazyLoading()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(
+        "TopLevel=top\n"
+        "[Group1]\n"
+        "Key=value1\n"
+        "Escaped=\\sa\\nb\n"
+        "[Group2]\n"
+        "Key=value2\n"
+        "Other=other2\n"
+        "[Locked][$i]\n"
+        "Key=locked\n"
+        "[Parent][Child]\n"
+        "Key=child\n"
+        "[Group1]\n"
+        "Key=overridden\n");
+    file.close();
+
+    {
+        KConfig config(KConfig::ConfigAssociation::KdeApp, file.fileName(), KConfig::SimpleConfig | KConfig::LazyLoading);
+        QCOMPARE(config.group(QString()).readEntry("TopLevel"), QStringLiteral("top"));
+        const KConfigGroup group1 = config.group(QStringLiteral("Group1"));
+        QCOMPARE(group1.readEntry("Key"), QStringLiteral("overridden"));
+        QCOMPARE(group1.readEntry("Escaped"), QStringLiteral(" a\nb"));
+
+        KConfigGroup locked = config.group(QStringLiteral("Locked"));
+        QVERIFY(locked.isImmutable());
+        QCOMPARE(locked.readEntry("Key"), QStringLiteral("locked"));
+
+        QVERIFY(config.hasGroup(QStringLiteral("Parent")));
+        QCOMPARE(config.group(QStringLiteral("Parent")).groupList(), QStringList{QStringLiteral("Child")});
+
+        // writing to a group that wasn't read yet must keep its other entries
+        KConfigGroup group2 = config.group(QStringLiteral("Group2"));
+        group2.writeEntry("Key", "changed");
+        QCOMPARE(group2.readEntry("Other"), QStringLiteral("other2"));
+
+        QStringList groups = config.groupList();
+        groups.sort();
+        QCOMPARE(groups, (QStringList{QStringLiteral("Group1"), QStringLiteral("Group2"), QStringLiteral("Locked"), QStringLiteral("Parent")}));
+        QVERIFY(config.sync());
+    }
+
+    KConfig config(KConfig::ConfigAssociation::KdeApp, file.fileName(), KConfig::SimpleConfig);
+    const KConfigGroup group2 = config.group(QStringLiteral("Group2"));
+    QCOMPARE(group2.readEntry("Key"), QStringLiteral("changed"));
+    QCOMPARE(group2.readEntry("Other"), QStringLiteral("other2"));
+    QCOMPARE(config.group(QStringLiteral("Group1")).readEntry("Key"), QStringLiteral("overridden"));
+    QCOMPARE(config.group(QStringLiteral("Parent")).group(QStringLiteral("Child")).readEntry("Key"), QStringLiteral("child"));
+}
+
+void KConfigTest::testCompiledConfig()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("compiledrc"));
+    const auto writeSource = [&fileName](const QByteArray &key) {
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(
+            "TopLevel=top\n"
+            "[Group]\n"
+            "Key="
+            + key
+            + "\n"
+              "Escaped=\\sa\\tb\n"
+              "Name=Name\n"
+              "Name[de]=Deutsch\n"
+              "Gone[$d]\n"
+              "[Locked][$i]\n"
+              "Key=locked\n"
+              "[Parent][Child]\n"
+              "Key=child\n");
+    };
+    writeSource("compiled");
+    QVERIFY(KConfigCompiledBackend::compile(fileName, KConfigCompiledBackend::compiledPath(fileName)));
+
+    // A change of the same size with the same modification time: reading the old value
+    // proves that the compiled file is used
+    const QDateTime modified = QFileInfo(fileName).lastModified();
+    writeSource("original");
+    {
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.setFileTime(modified, QFileDevice::FileModificationTime));
+    }
+
+    // but only once it is registered, the files of the user aren't looked for a compiled file otherwise
+    {
+        KConfig config(fileName, KConfig::SimpleConfig);
+        QCOMPARE(config.group(QStringLiteral("Group")).readEntry("Key"), QStringLiteral("original"));
+    }
+    QVERIFY(KConfigCompiledBackend::setRegistered(fileName, true));
+
+    for (const KConfig::OpenFlags flags : {KConfig::OpenFlags(KConfig::SimpleConfig), KConfig::SimpleConfig | KConfig::LazyLoading}) {
+        KConfig config(fileName, flags);
+        QCOMPARE(config.group(QString()).readEntry("TopLevel"), QStringLiteral("top"));
+        KConfigGroup group = config.group(QStringLiteral("Group"));
+        QCOMPARE(group.readEntry("Key"), QStringLiteral("compiled"));
+        QCOMPARE(group.readEntry("Escaped"), QStringLiteral(" a\tb"));
+        QVERIFY(!group.hasKey("Gone"));
+        QVERIFY(config.group(QStringLiteral("Locked")).isImmutable());
+        QCOMPARE(config.group(QStringLiteral("Parent")).group(QStringLiteral("Child")).readEntry("Key"), QStringLiteral("child"));
+
+        config.setLocale(QStringLiteral("de"));
+        QCOMPARE(config.group(QStringLiteral("Group")).readEntry("Name"), QStringLiteral("Deutsch"));
+    }
+
+    // writing goes to the source, then the compiled file is compiled again from it
+    {
+        KConfig config(fileName, KConfig::SimpleConfig);
+        config.group(QStringLiteral("Group")).writeEntry("Other", "written");
+        QVERIFY(config.sync());
+    }
+    // the same trick as above: still reading what was written proves that it was compiled
+    {
+        const QDateTime written = QFileInfo(fileName).lastModified();
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        const QByteArray contents = file.readAll();
+        QVERIFY(contents.contains("Other=written"));
+        QVERIFY(file.seek(0));
+        QCOMPARE(file.write(QByteArray(contents).replace("Other=written", "Other=changed")), contents.size());
+        QVERIFY(file.setFileTime(written, QFileDevice::FileModificationTime));
+    }
+    KConfig config(fileName, KConfig::SimpleConfig);
+    QCOMPARE(config.group(QStringLiteral("Group")).readEntry("Key"), QStringLiteral("original"));
+    QCOMPARE(config.group(QStringLiteral("Group")).readEntry("Other"), QStringLiteral("written"));
+    QVERIFY(KConfigCompiledBackend::setRegistered(fileName, false));
+}
+
+void KConfigTest::testDefaultsBundle()
+{
+    QTemporaryDir systemDir;
+    QTemporaryDir localDir;
+    QVERIFY(systemDir.isValid() && localDir.isValid());
+    const QString fileName = systemDir.filePath(QStringLiteral("bundledrc"));
+    const QString otherFileName = systemDir.filePath(QStringLiteral("otherrc"));
+    const auto writeFile = [](const QString &path, const QByteArray &contents) {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(contents);
+    };
+    writeFile(fileName, "[Group]\nKey=packed\nName=Name\nName[de]=Deutsch\n[Locked][$i]\nKey=locked\n");
+    writeFile(otherFileName, "[Group]\nKey=other\n");
+    QVERIFY(KConfigCompiledBackend::pack(systemDir.path(), {QStringLiteral("bundledrc")}));
+
+    {
+        const auto bundle = KConfigDefaultsBundle::open(systemDir.path());
+        QVERIFY(bundle);
+        QCOMPARE(bundle->canonicalFilePath(u"bundledrc"), QFileInfo(fileName).canonicalFilePath());
+        // not packed, but known to be there
+        QCOMPARE(bundle->canonicalFilePath(u"otherrc"), QFileInfo(otherFileName).canonicalFilePath());
+        QVERIFY(bundle->canonicalFilePath(u"missingrc").isNull());
+        QVERIFY(KConfigDefaultsBundle::compiledFile(fileName));
+        QVERIFY(!KConfigDefaultsBundle::compiledFile(otherFileName));
+    }
+
+    // Editing the file in place leaves the directory as it was: reading the old value proves that the bundle is used
+    writeFile(fileName, "[Group]\nKey=edited\n");
+    const auto readDefaults = [&localDir](const QString &source) {
+        KConfig config(localDir.filePath(QStringLiteral("localrc")), KConfig::NoGlobals);
+        config.addConfigSources({source});
+        return config.group(QStringLiteral("Group")).readEntry("Key");
+    };
+    for (const KConfig::OpenFlags flags : {KConfig::OpenFlags(KConfig::NoGlobals), KConfig::NoGlobals | KConfig::LazyLoading}) {
+        KConfig config(localDir.filePath(QStringLiteral("localrc")), flags);
+        config.addConfigSources({fileName});
+        QCOMPARE(config.group(QStringLiteral("Group")).readEntry("Key"), QStringLiteral("packed"));
+        QVERIFY(config.group(QStringLiteral("Locked")).isImmutable());
+        config.setLocale(QStringLiteral("de"));
+        QCOMPARE(config.group(QStringLiteral("Group")).readEntry("Name"), QStringLiteral("Deutsch"));
+    }
+    QCOMPARE(readDefaults(otherFileName), QStringLiteral("other"));
+
+    // Removing a file modifies the directory, the bundle is not used anymore. Both are
+    // aged first, so that the removal can't happen within the same timestamp tick.
+    ageTimeStamp(systemDir.path(), 60);
+    ageTimeStamp(KConfigDefaultsBundle::bundlePath(systemDir.path()), 60);
+    QVERIFY(KConfigDefaultsBundle::open(systemDir.path()));
+    QVERIFY(QFile::remove(otherFileName));
+    QVERIFY(!KConfigDefaultsBundle::open(systemDir.path()));
+    QCOMPARE(readDefaults(fileName), QStringLiteral("edited"));
+}
+
+void KConfigTest::testStringPool()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    for (int i = 0; i < 10; ++i) {
+        file.write("[Window" + QByteArray::number(i) + "]\nWidth=640\nHeight=480\nState=AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA\n");
+    }
+    file.close();
+
+    const KConfigStringPool::Statistics before = KConfigStringPool::statistics();
+    KConfig config1(KConfig::ConfigAssociation::KdeApp, file.fileName(), KConfig::SimpleConfig);
+    KConfig config2(KConfig::ConfigAssociation::KdeApp, file.fileName(), KConfig::SimpleConfig);
+    const KConfigStringPool::Statistics after = KConfigStringPool::statistics();
+
+    // the keys and the long value repeat in each group, the short values are stored inline
+    QVERIFY(after.hits - before.hits >= 2 * 10 * 4 - 4);
+    QVERIFY(after.bytesSaved > before.bytesSaved);
+    QCOMPARE(config2.group(QStringLiteral("Window9")).readEntry("Height"), QStringLiteral("480"));
+}
+
 #include <QThreadPool>
 #include <qtconcurrentrun.h>
 
 // To find multithreading bugs: valgrind --tool=helgrind --track-lockorders=no ./kconfigtest testThreads
+void KConfigTest::testStatistics()
+{
+    const QString file = m_testConfigDir + QLatin1String("/statisticstest");
+    QFile::remove(file);
+    {
+        KConfig config(file, KConfig::SimpleConfig);
+        config.group(QStringLiteral("Group")).writeEntry("Number", 42);
+        QVERIFY(config.sync());
+    }
+
+    KConfig::setStatisticsEnabled(true);
+    KConfig::resetStatistics();
+    {
+        KConfig config(file, KConfig::SimpleConfig);
+        KConfigGroup group = config.group(QStringLiteral("Group"));
+        QCOMPARE(group.readEntry("Number", 0), 42);
+        QCOMPARE(group.readEntry("Missing", QString()), QString());
+        group.writeEntry("Number", 43);
+        QVERIFY(config.sync());
+    }
+    KConfig::Statistics statistics = KConfig::statistics();
+    QVERIFY(statistics.filesParsed >= 2); // opening, and merging before the write
+    QVERIFY(statistics.bytesRead > 0);
+    QVERIFY(statistics.lookups >= 2);
+    QVERIFY(statistics.conversions >= 1);
+    QCOMPARE(statistics.syncs, quint64(1));
+    QVERIFY(statistics.writeNanoseconds > 0);
+
+    // nothing is counted while disabled
+    KConfig::setStatisticsEnabled(false);
+    KConfig::resetStatistics();
+    {
+        KConfig config(file, KConfig::SimpleConfig);
+        QCOMPARE(config.group(QStringLiteral("Group")).readEntry("Number", 0), 43);
+    }
+    statistics = KConfig::statistics();
+    QCOMPARE(statistics.filesParsed, quint64(0));
+    QCOMPARE(statistics.lookups, quint64(0));
+}
+
+void KConfigTest::testCacheLocales()
+{
+    const QString file = m_testConfigDir + QLatin1String("/cachelocalestest");
+    auto writeFile = [&file](const QByteArray &contents) {
+        QFile out(file);
+        QVERIFY(out.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        out.write(contents);
+    };
+    writeFile("[Group]\nName=C\nName[de]=Deutsch\nName[fr]=Francais\n");
+
+    KConfig config(file, KConfig::OpenFlags(KConfig::SimpleConfig | KConfig::CacheLocales));
+    config.setLocale(QStringLiteral("de"));
+    KConfigGroup group = config.group(QStringLiteral("Group"));
+    QCOMPARE(group.readEntry("Name"), QStringLiteral("Deutsch"));
+    config.setLocale(QStringLiteral("fr"));
+    QCOMPARE(group.readEntry("Name"), QStringLiteral("Francais"));
+
+    // back to a locale that was read before, without parsing the file
+    KConfig::setStatisticsEnabled(true);
+    KConfig::resetStatistics();
+    config.setLocale(QStringLiteral("de"));
+    QCOMPARE(group.readEntry("Name"), QStringLiteral("Deutsch"));
+    config.setLocale(QStringLiteral("fr"));
+    QCOMPARE(group.readEntry("Name"), QStringLiteral("Francais"));
+    QCOMPARE(KConfig::statistics().filesParsed, quint64(0));
+    KConfig::setStatisticsEnabled(false);
+
+    // the entries kept for a locale are not used once the file changed
+    writeFile("[Group]\nName=C\nName[de]=Deutsch geaendert\nName[fr]=Francais\n");
+    config.setLocale(QStringLiteral("de"));
+    QCOMPARE(group.readEntry("Name"), QStringLiteral("Deutsch geaendert"));
+
+    // nor when there are changes to write
+    group.writeEntry("Other", 1);
+    config.setLocale(QStringLiteral("fr"));
+    QCOMPARE(group.readEntry("Name"), QStringLiteral("Francais"));
+    QCOMPARE(group.readEntry("Other", 0), 1);
+    QVERIFY(!config.isDirty());
+}
+
+void KConfigTest::testExitSync()
+{
+    std::vector<std::unique_ptr<KConfig>> configs;
+    QList<KConfig *> dirty;
+    for (int i = 0; i < 6; ++i) {
+        const QString file = m_testConfigDir + QLatin1String("/exitsynctest%1").arg(i);
+        QFile::remove(file);
+        configs.push_back(std::make_unique<KConfig>(file, KConfig::SimpleConfig));
+        configs.back()->group(QStringLiteral("Group")).writeEntry("Number", i);
+        dirty.append(configs.back().get());
+    }
+    // a second config of the same file, written after the first one
+    auto same = std::make_unique<KConfig>(m_testConfigDir + QLatin1String("/exitsynctest0"), KConfig::SimpleConfig);
+    same->group(QStringLiteral("Other")).writeEntry("Number", 42);
+    dirty.append(same.get());
+    // and one with nothing to write
+    KConfig clean(m_testConfigDir + QLatin1String("/exitsynctest0"), KConfig::SimpleConfig);
+    dirty.append(&clean);
+
+    QVERIFY(KConfigExitSync::syncAll(dirty));
+    for (int i = 0; i < 6; ++i) {
+        QVERIFY(!configs[i]->isDirty());
+        KConfig reread(m_testConfigDir + QLatin1String("/exitsynctest%1").arg(i), KConfig::SimpleConfig);
+        QCOMPARE(reread.group(QStringLiteral("Group")).readEntry("Number", -1), i);
+    }
+    QVERIFY(!same->isDirty());
+    KConfig reread(m_testConfigDir + QLatin1String("/exitsynctest0"), KConfig::SimpleConfig);
+    QCOMPARE(reread.group(QStringLiteral("Group")).readEntry("Number", -1), 0);
+    QCOMPARE(reread.group(QStringLiteral("Other")).readEntry("Number", -1), 42);
+}
+
+void KConfigTest::testBinaryEntries()
+{
+    const QString file = m_testConfigDir + QLatin1String("/binaryentriestest");
+    QFile::remove(file);
+    QByteArray blob;
+    for (int i = 0; i < 512; ++i) {
+        blob.append(char(i));
+    }
+
+    {
+        KConfig config(file, KConfig::SimpleConfig);
+        KConfigGroup group = config.group(QStringLiteral("State"));
+        group.writeEntry("Blob", blob, KConfig::Binary);
+        group.writeEntry("Text", QByteArray("a\x01b"));
+        QCOMPARE(group.readEntry("Blob", QByteArray()), blob);
+        QVERIFY(config.sync());
+    }
+
+    QFile in(file);
+    QVERIFY(in.open(QIODevice::ReadOnly));
+    const QByteArray contents = in.readAll();
+    QVERIFY(contents.contains("Blob[$b]=" + blob.toBase64() + '\n'));
+    QVERIFY(contents.contains("Text=a\\x01b\n"));
+    in.close();
+
+    KConfig config(file, KConfig::SimpleConfig);
+    KConfigGroup group = config.group(QStringLiteral("State"));
+    QCOMPARE(group.readEntry("Blob", QByteArray()), blob);
+    QCOMPARE(group.readEntry("Text", QByteArray()), QByteArray("a\x01b"));
+
+    // merging the file with another change keeps the entry binary
+    group.writeEntry("Other", 1);
+    QVERIFY(config.sync());
+    QVERIFY(in.open(QIODevice::ReadOnly));
+    QVERIFY(in.readAll().contains("Blob[$b]=" + blob.toBase64() + '\n'));
+    in.close();
+
+    KConfigIniReader reader(file);
+    bool found = false;
+    while (reader.readNext()) {
+        if (reader.key() == "Blob") {
+            found = true;
+            QVERIFY(reader.flags() & KConfigIniReader::Binary);
+            QCOMPARE(reader.value(), blob);
+        }
+    }
+    QVERIFY(found);
+}
+
+void KConfigTest::testChangesSince()
+{
+    const QString file = m_testConfigDir + QLatin1String("/changessincetest");
+    QFile::remove(file);
+    KConfig config(file, KConfig::SimpleConfig);
+    KConfigGroup one = config.group(QStringLiteral("One"));
+    KConfigGroup two = config.group(QStringLiteral("Two"));
+
+    const quint64 start = config.generation();
+    one.writeEntry("A", 1);
+    one.writeEntry("B", 2);
+    one.writeEntry("A", 3);
+    QVERIFY(config.generation() > start);
+    QCOMPARE(config.groupGeneration(QStringLiteral("One")), config.generation());
+    QCOMPARE(config.groupGeneration(QStringLiteral("Two")), start);
+
+    const quint64 written = config.generation();
+    two.writeEntry("C", 4);
+    two.deleteEntry("C");
+    config.group(QString()).writeEntry("D", 5);
+    QVERIFY(config.groupGeneration(QStringLiteral("One")) < config.groupGeneration(QStringLiteral("Two")));
+
+    bool complete = false;
+    QHash<QString, QByteArrayList> changes = config.changesSince(start, &complete);
+    QVERIFY(complete);
+    QCOMPARE(changes.size(), 3);
+    QCOMPARE(changes.value(QStringLiteral("One")), (QByteArrayList{"A", "B"}));
+    QCOMPARE(changes.value(QStringLiteral("Two")), QByteArrayList{"C"});
+    QCOMPARE(changes.value(QString()), QByteArrayList{"D"});
+
+    changes = config.changesSince(written, &complete);
+    QVERIFY(complete);
+    QVERIFY(!changes.contains(QStringLiteral("One")));
+    QVERIFY(config.changesSince(config.generation(), &complete).isEmpty());
+    QVERIFY(complete);
+
+    // reparsing lists the entries that differ from the files
+    QVERIFY(config.sync());
+    const quint64 synced = config.generation();
+    config.reparseConfiguration();
+    QVERIFY(config.generation() > synced);
+    QVERIFY(config.changesSince(synced, &complete).isEmpty());
+    QVERIFY(complete);
+
+    {
+        KConfig other(file, KConfig::SimpleConfig);
+        other.group(QStringLiteral("One")).writeEntry("A", 7);
+        other.group(QStringLiteral("One")).deleteEntry("B");
+        other.group(QStringLiteral("Three")).writeEntry("F", 8);
+        QVERIFY(other.sync());
+    }
+    const quint64 beforeReparse = config.generation();
+    config.reparseConfiguration();
+    changes = config.changesSince(beforeReparse, &complete);
+    QVERIFY(complete);
+    QCOMPARE(changes.size(), 2);
+    QByteArrayList changedKeys = changes.value(QStringLiteral("One"));
+    std::sort(changedKeys.begin(), changedKeys.end());
+    QCOMPARE(changedKeys, (QByteArrayList{"A", "B"}));
+    QCOMPARE(changes.value(QStringLiteral("Three")), QByteArrayList{"F"});
+    QVERIFY(config.groupGeneration(QStringLiteral("Two")) < beforeReparse);
+    QCOMPARE(one.readEntry("A", 0), 7);
+
+    const quint64 beforeGroups = config.generation();
+    config.reparseGroups({QStringLiteral("Two")});
+    changes = config.changesSince(beforeGroups, &complete);
+    QVERIFY(complete);
+    QCOMPARE(changes.keys(), QStringList{QStringLiteral("Two")});
+    QVERIFY(changes.value(QStringLiteral("Two")).isEmpty());
+
+    // the oldest changes are dropped from the log
+    const quint64 beforeMany = config.generation();
+    for (int i = 0; i < 1000; ++i) {
+        one.writeEntry("Counter", i);
+    }
+    config.changesSince(beforeMany, &complete);
+    QVERIFY(!complete);
+    const quint64 recent = config.generation();
+    two.writeEntry("E", 6);
+    QCOMPARE(config.changesSince(recent, &complete).value(QStringLiteral("Two")), QByteArrayList{"E"});
+    QVERIFY(complete);
+}
+
+void KConfigTest::testTryReadEntry()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(
+        "[Group]\n"
+        "Int=42\n"
+        "NotInt=abc\n"
+        "Empty=\n"
+        "Path[$e]=$KCONFIGTEST_TRYREAD/foo\n"
+        "List[$e]=$KCONFIGTEST_TRYREAD/a,b\n");
+    file.close();
+
+    qputenv("KCONFIGTEST_TRYREAD", "/home");
+    KConfig config(file.fileName(), KConfig::SimpleConfig);
+    KConfigGroup group = config.group(QStringLiteral("Group"));
+    QCOMPARE(group.tryReadEntry<int>("Int"), std::optional<int>(42));
+    QCOMPARE(group.tryReadEntry<int>(QStringLiteral("Int")), std::optional<int>(42));
+    QCOMPARE(group.tryReadEntry<int>("NotInt"), std::optional<int>(0));
+    QVERIFY(!group.tryReadEntry<int>("Missing"));
+    QCOMPARE(group.tryReadEntry<QString>("Empty").has_value(), group.hasKey("Empty"));
+    QVERIFY(!group.tryReadEntry<QString>("Missing"));
+
+    // strings and string lists are expanded like readEntry() does
+    QCOMPARE(group.tryReadEntry<QString>("Path"), std::optional<QString>(QStringLiteral("/home/foo")));
+    QCOMPARE(group.tryReadEntry<QStringList>("List"), (std::optional<QStringList>(QStringList{QStringLiteral("/home/a"), QStringLiteral("b")})));
+    QVERIFY(!group.tryReadEntry<QStringList>("Missing"));
+    qunsetenv("KCONFIGTEST_TRYREAD");
+
+    group.deleteEntry("Int");
+    QVERIFY(!group.tryReadEntry<int>("Int"));
+    group.writeEntry("Bool", true);
+    QCOMPARE(group.tryReadEntry<bool>("Bool"), std::optional<bool>(true));
+}
+
+void KConfigTest::testConfigKey()
+{
+    const QString file = m_testConfigDir + QLatin1String("/configkeytest");
+    {
+        QFile out(file);
+        QVERIFY(out.open(QIODevice::WriteOnly));
+        out.write(
+            "[A]\n"
+            "Other=1\n"
+            "\n"
+            "[B]\n"
+            "Enabled=true\n"
+            "Path[$e]=$KCONFIGTEST_CONFIGKEY/foo\n");
+    }
+
+    KConfig config(file, KConfig::SimpleConfig);
+    KConfigGroup group = config.group(QStringLiteral("B"));
+    const KConfigKey enabled = group.configKey("Enabled");
+    QVERIFY(!enabled.isNull());
+    QVERIFY(KConfigKey().isNull());
+    QCOMPARE(enabled.key(), QByteArray("Enabled"));
+    QCOMPARE(enabled.group().name(), QStringLiteral("B"));
+    QVERIFY(enabled.exists());
+    QCOMPARE(enabled.readBoolEntry(false), true);
+    QCOMPARE(enabled.readEntryRaw().toByteArray(), QByteArray("true"));
+
+    // the handle follows the changes of the entry
+    group.writeEntry("Enabled", false);
+    QCOMPARE(enabled.readBoolEntry(true), false);
+    group.deleteEntry("Enabled");
+    QVERIFY(!enabled.exists());
+    QCOMPARE(enabled.readBoolEntry(true), true);
+    config.group(QStringLiteral("A")).writeEntry("Enabled", 5);
+    QVERIFY(!enabled.exists());
+    group.writeEntry("Enabled", 7);
+    QCOMPARE(enabled.readIntEntry(0), 7);
+
+    // and of the groups before it
+    config.group(QStringLiteral("0")).writeEntry("Enabled", 3);
+    QCOMPARE(enabled.readIntEntry(0), 7);
+    QVERIFY(config.sync());
+    config.reparseConfiguration();
+    QCOMPARE(enabled.readIntEntry(0), 7);
+
+    const KConfigKey missing = group.configKey(QStringLiteral("Missing"));
+    QVERIFY(!missing.exists());
+    QCOMPARE(missing.readEntry(QStringLiteral("default")), QStringLiteral("default"));
+    QCOMPARE(missing.readIntEntry(-1), -1);
+
+    qputenv("KCONFIGTEST_CONFIGKEY", "/home");
+    const KConfigKey path = group.configKey("Path");
+    QCOMPARE(path.readEntry(), QStringLiteral("/home/foo"));
+    qunsetenv("KCONFIGTEST_CONFIGKEY");
+
+    // a lazily loaded group is only loaded by the first read
+    KConfig lazy(file, KConfig::SimpleConfig | KConfig::LazyLoading);
+    const KConfigKey lazyEnabled = lazy.group(QStringLiteral("B")).configKey("Enabled");
+    QCOMPARE(lazy.group(QStringLiteral("A")).readEntry("Other", 0), 1);
+    QCOMPARE(lazyEnabled.readIntEntry(0), 7);
+    QCOMPARE(lazy.group(QStringLiteral("0")).readEntry("Enabled", 0), 3);
+    QCOMPARE(lazyEnabled.readIntEntry(0), 7);
+
+    // copies have their own slot
+    KConfigKey copy = enabled;
+    QCOMPARE(copy.readIntEntry(0), 7);
+    copy = missing;
+    QCOMPARE(copy.key(), QByteArray("Missing"));
+}
+
+void KConfigTest::testConfigEntry()
+{
+    static constexpr KConfigEntry<int> width{"General", "Width", 800};
+    static constexpr KConfigEntry<bool> enabled{"General", "Enabled", true};
+    static constexpr KConfigEntry<QString> theme{"Icons", "Theme", "breeze"};
+    static constexpr KConfigEntry<Testing> testing{"General", "Testing", Tens};
+    static_assert(width.defaultValue() == 800);
+    static_assert(width.group()[0] == 'G');
+
+    KConfig config(QString(), KConfig::SimpleConfig);
+    QCOMPARE(width.read(&config), 800);
+    QCOMPARE(enabled.read(&config), true);
+    QCOMPARE(theme.read(&config), QStringLiteral("breeze"));
+    QCOMPARE(testing.read(&config), Tens);
+
+    width.write(&config, 1024);
+    enabled.write(&config, false);
+    theme.write(&config, QStringLiteral("oxygen"));
+    testing.write(&config, Hundreds);
+    const KConfigGroup general = config.group(QStringLiteral("General"));
+    QCOMPARE(general.readEntry("Width", 0), 1024);
+    QCOMPARE(general.readEntry("Testing", QString()), QStringLiteral("Hundreds"));
+    QCOMPARE(config.group(QStringLiteral("Icons")).readEntry("Theme", QString()), QStringLiteral("oxygen"));
+    QCOMPARE(width.read(&config), 1024);
+    QCOMPARE(enabled.read(&config), false);
+    QCOMPARE(theme.read(&config), QStringLiteral("oxygen"));
+    QCOMPARE(testing.read(&config), Hundreds);
+
+    // through a handle, and in another group
+    const KConfigKey handle = width.configKey(&config);
+    QCOMPARE(width.read(handle), 1024);
+    width.write(&config, 640);
+    QCOMPARE(width.read(handle), 640);
+    QCOMPARE(width.read(config.group(QStringLiteral("Other"))), 800);
+}
+
+void KConfigTest::testForEachEntry()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(
+        "[Parent]\n"
+        "A=1\n"
+        "B[$e]=$HOME\n"
+        "C=3\n"
+        "C[fr]=trois\n"
+        "D[$i]=4\n");
+    file.close();
+
+    KConfig config(file.fileName(), KConfig::SimpleConfig);
+    config.setLocale(QStringLiteral("fr"));
+    KConfigGroup parent = config.group(QStringLiteral("Parent"));
+    parent.deleteEntry("A");
+    parent.writeEntry("E", 5);
+
+    QList<QByteArray> keys;
+    QList<QByteArray> values;
+    QList<KConfigGroup::EntryFlags> flags;
+    parent.forEachEntry([&](QByteArrayView key, QByteArrayView value, KConfigGroup::EntryFlags entryFlags) {
+        keys.append(key.toByteArray());
+        values.append(value.toByteArray());
+        flags.append(entryFlags);
+    });
+    QCOMPARE(keys, (QList<QByteArray>{"B", "C", "D", "E"}));
+    QCOMPARE(values, (QList<QByteArray>{"$HOME", "trois", "4", "5"}));
+    QCOMPARE(flags, (QList<KConfigGroup::EntryFlags>{KConfigGroup::EntryExpandable, KConfigGroup::EntryLocalized, KConfigGroup::EntryImmutable, {}}));
+    QCOMPARE(QStringList(keys.cbegin(), keys.cend()), parent.keyList());
+
+    // the subgroups are each listed once, like groupList() does
+    parent.group(QStringLiteral("Sub")).writeEntry("F", 6);
+    parent.group(QStringLiteral("Sub")).group(QStringLiteral("Inner")).writeEntry("G", 7);
+    parent.group(QStringLiteral("Sub\x01")).writeEntry("H", 8);
+    parent.group(QStringLiteral("Other")).group(QStringLiteral("Inner")).writeEntry("I", 9);
+    parent.group(QStringLiteral("Deleted")).writeEntry("J", 10);
+    parent.group(QStringLiteral("Deleted")).deleteEntry("J");
+    QStringList subGroups;
+    parent.forEachSubGroup([&subGroups](QByteArrayView name) {
+        subGroups.append(QString::fromUtf8(name));
+    });
+    QCOMPARE(subGroups.size(), 3);
+    subGroups.sort();
+    QCOMPARE(subGroups, parent.groupList());
+
+    int count = 0;
+    config.group(QStringLiteral("Missing")).forEachEntry([&count](QByteArrayView, QByteArrayView, KConfigGroup::EntryFlags) {
+        ++count;
+    });
+    QCOMPARE(count, 0);
+}
+
+void KConfigTest::testOptimisticWrites()
+{
+    const QString file = m_testConfigDir + QLatin1String("/optimisticwritetest");
+    QFile::remove(file);
+    qputenv("KCONFIG_OPTIMISTIC_WRITES", "1");
+
+    KConfig first(file, KConfig::SimpleConfig);
+    KConfig second(file, KConfig::SimpleConfig);
+    first.group(QStringLiteral("Group")).writeEntry("First", 1);
+    QVERIFY(first.sync());
+    QVERIFY(!QFile::exists(file + QLatin1String(".lock")));
+
+    // the second one merges with what the first one wrote
+    second.group(QStringLiteral("Group")).writeEntry("Second", 2);
+    QVERIFY(second.sync());
+    QVERIFY(!second.isDirty());
+    first.group(QStringLiteral("Group")).writeEntry("First", 3);
+    QVERIFY(first.sync());
+
+    qunsetenv("KCONFIG_OPTIMISTIC_WRITES");
+    KConfig reader(file, KConfig::SimpleConfig);
+    QCOMPARE(reader.group(QStringLiteral("Group")).readEntry("First", 0), 3);
+    QCOMPARE(reader.group(QStringLiteral("Group")).readEntry("Second", 0), 2);
+}
+
+void KConfigTest::testDurability()
+{
+    const QString file = m_testConfigDir + QLatin1String("/durabilitytest");
+    QFile::remove(file);
+    const auto valueOnDisk = [&file]() {
+        KConfig reader(file, KConfig::SimpleConfig);
+        return reader.group(QStringLiteral("Group")).readEntry("Number", 0);
+    };
+
+    {
+        KConfig config(file, KConfig::SimpleConfig);
+        QCOMPARE(config.durability(), KConfig::Durable);
+        config.setDurability(KConfig::RelaxedNoFsync);
+        config.group(QStringLiteral("Group")).writeEntry("Number", 1);
+        QVERIFY(config.sync());
+        QCOMPARE(valueOnDisk(), 1);
+        // no temporary file is left behind
+        QCOMPARE(QDir(m_testConfigDir).entryList({QStringLiteral("durabilitytest*")}, QDir::Files), QStringList{QStringLiteral("durabilitytest")});
+
+        // and the file that is there now is replaced as well
+        config.group(QStringLiteral("Group")).writeEntry("Number", 5);
+        QVERIFY(config.sync());
+        QVERIFY(!config.isDirty());
+        QCOMPARE(valueOnDisk(), 5);
+        QCOMPARE(QDir(m_testConfigDir).entryList({QStringLiteral("durabilitytest*")}, QDir::Files), QStringList{QStringLiteral("durabilitytest")});
+
+        config.setDurability(KConfig::WriteBehind);
+        config.group(QStringLiteral("Group")).writeEntry("Number", 2);
+        QVERIFY(config.sync());
+        QVERIFY(config.isDirty());
+        QCOMPARE(valueOnDisk(), 1);
+        QTRY_VERIFY_WITH_TIMEOUT(!config.isDirty(), 10000);
+        QCOMPARE(valueOnDisk(), 2);
+
+        // leaving WriteBehind writes what is pending
+        config.group(QStringLiteral("Group")).writeEntry("Number", 3);
+        QVERIFY(config.sync());
+        config.setDurability(KConfig::Durable);
+        QVERIFY(!config.isDirty());
+        QCOMPARE(valueOnDisk(), 3);
+
+        config.setDurability(KConfig::WriteBehind);
+        config.group(QStringLiteral("Group")).writeEntry("Number", 4);
+        QVERIFY(config.sync());
+    }
+    // and so does destroying the config
+    QCOMPARE(valueOnDisk(), 4);
+
+    QCOMPARE(KSharedConfig::openStateConfig(QStringLiteral("durabilitystaterc"))->durability(), KConfig::RelaxedNoFsync);
+}
+
+void KConfigTest::testJournal()
+{
+    const QString file = m_testConfigDir + QLatin1String("/journaltest");
+    const QString journal = file + QLatin1String(".journal");
+    QFile::remove(file);
+    QFile::remove(journal);
+    const auto reread = [&file]() {
+        return KConfig(file, KConfig::SimpleConfig).group(QStringLiteral("Group")).entryMap();
+    };
+
+    {
+        KConfig config(file, KConfig::SimpleConfig);
+        config.setDurability(KConfig::Journaled);
+        KConfigGroup group = config.group(QStringLiteral("Group"));
+        group.writeEntry("Number", 1);
+        group.writeEntry("Other", "a");
+        config.group(QString()).writeEntry("Top", "level");
+        QVERIFY(config.sync());
+        QVERIFY(!QFile::exists(file));
+        QVERIFY(QFile::exists(journal));
+        QCOMPARE(reread(), (QMap<QString, QString>{{QStringLiteral("Number"), QStringLiteral("1")}, {QStringLiteral("Other"), QStringLiteral("a")}}));
+
+        // later records win, a removed entry is gone
+        group.writeEntry("Number", 2);
+        group.deleteEntry("Other");
+        config.group(QString()).writeEntry("Top", "again");
+        QVERIFY(config.sync());
+        QVERIFY(!QFile::exists(file));
+        QCOMPARE(reread(), (QMap<QString, QString>{{QStringLiteral("Number"), QStringLiteral("2")}}));
+        QCOMPARE(KConfig(file, KConfig::SimpleConfig).group(QString()).readEntry("Top"), QStringLiteral("again"));
+    }
+    // destroying the config folds the journal into the file
+    QVERIFY(!QFile::exists(journal));
+    QCOMPARE(reread(), (QMap<QString, QString>{{QStringLiteral("Number"), QStringLiteral("2")}}));
+    QCOMPARE(KConfig(file, KConfig::SimpleConfig).group(QString()).readEntry("Top"), QStringLiteral("again"));
+
+    {
+        KConfig config(file, KConfig::SimpleConfig);
+        config.setDurability(KConfig::Journaled);
+        KConfigGroup group = config.group(QStringLiteral("Group"));
+        group.writeEntry("Big", QString(70 * 1024, QLatin1Char('x')));
+        QVERIFY(config.sync());
+        QVERIFY(QFile::exists(journal));
+        // a full journal is folded into the file by the next sync()
+        group.writeEntry("Number", 3);
+        QVERIFY(config.sync());
+        QVERIFY(!QFile::exists(journal));
+        QCOMPARE(reread().value(QStringLiteral("Number")), QStringLiteral("3"));
+        QCOMPARE(reread().value(QStringLiteral("Big")).size(), 70 * 1024);
+
+        group.deleteEntry("Big");
+        QVERIFY(config.sync());
+        QVERIFY(QFile::exists(journal));
+        QCOMPARE(reread(), (QMap<QString, QString>{{QStringLiteral("Number"), QStringLiteral("3")}}));
+    }
+    QVERIFY(!QFile::exists(journal));
+    QCOMPARE(reread(), (QMap<QString, QString>{{QStringLiteral("Number"), QStringLiteral("3")}}));
+}
+
+void KConfigTest::testShardedGroups()
+{
+    const QString file = m_testConfigDir + QLatin1String("/shardedtest");
+    const QString shards = file + QLatin1String(".d");
+    QFile::remove(file);
+    QDir(shards).removeRecursively();
+    const auto shardNames = [&shards]() {
+        return QDir(shards).entryList(QDir::Files, QDir::Name);
+    };
+
+    {
+        // written before it was sharded
+        KConfig config(file, KConfig::SimpleConfig);
+        config.group(QStringLiteral("Top")).writeEntry("a", 1);
+        KConfigGroup containments = config.group(QStringLiteral("Containments"));
+        containments.group(QStringLiteral("1")).writeEntry("x", 1);
+        containments.group(QStringLiteral("1")).group(QStringLiteral("Applets")).group(QStringLiteral("2")).writeEntry("y", 2);
+        containments.group(QStringLiteral("3.5")).writeEntry("z", 3);
+        QVERIFY(config.sync());
+    }
+
+    {
+        KConfig config(file, KConfig::SimpleConfig | KConfig::ShardedGroups);
+        KConfigGroup containments = config.group(QStringLiteral("Containments"));
+        QCOMPARE(containments.group(QStringLiteral("1")).readEntry("x", 0), 1);
+        // the first sync() moves the groups of the shards out of the file
+        config.group(QStringLiteral("Top")).writeEntry("a", 2);
+        QVERIFY(config.sync());
+    }
+    QCOMPARE(KConfig(file, KConfig::SimpleConfig).groupList(), QStringList{QStringLiteral("Top")});
+    QCOMPARE(shardNames(), (QStringList{QStringLiteral("Containments.1"), QStringLiteral("Containments.3%2E5")}));
+
+    KConfig config(file, KConfig::SimpleConfig | KConfig::ShardedGroups);
+    KConfig reader(file, KConfig::SimpleConfig | KConfig::ShardedGroups);
+    KConfigGroup containments = config.group(QStringLiteral("Containments"));
+    QCOMPARE(config.group(QStringLiteral("Top")).readEntry("a", 0), 2);
+    QCOMPARE(containments.group(QStringLiteral("1")).group(QStringLiteral("Applets")).group(QStringLiteral("2")).readEntry("y", 0), 2);
+    QCOMPARE(containments.group(QStringLiteral("3.5")).readEntry("z", 0), 3);
+
+    // a change to a shard leaves the file alone
+    const QDateTime old = QDateTime::currentDateTime().addDays(-1);
+    {
+        QFile main(file);
+        QVERIFY(main.open(QIODevice::ReadWrite));
+        QVERIFY(main.setFileTime(old, QFileDevice::FileModificationTime));
+    }
+    containments.group(QStringLiteral("1")).writeEntry("x", 5);
+    QVERIFY(config.sync());
+    QCOMPARE(QFileInfo(file).lastModified().toSecsSinceEpoch(), old.toSecsSinceEpoch());
+    QCOMPARE(KConfig(shards + QLatin1String("/Containments.1"), KConfig::SimpleConfig).group(QStringLiteral("Containments")).group(QStringLiteral("1")).readEntry("x", 0),
+             5);
+
+    // reading a group again only reads its shard
+    QCOMPARE(reader.group(QStringLiteral("Containments")).group(QStringLiteral("1")).readEntry("x", 0), 1);
+    reader.reparseGroups({QStringLiteral("Containments\x1d" "1")});
+    QCOMPARE(reader.group(QStringLiteral("Containments")).group(QStringLiteral("1")).readEntry("x", 0), 5);
+    QCOMPARE(reader.group(QStringLiteral("Containments")).group(QStringLiteral("3.5")).readEntry("z", 0), 3);
+
+    // a shard without entries is removed
+    containments.group(QStringLiteral("3.5")).deleteGroup();
+    QVERIFY(config.sync());
+    QCOMPARE(shardNames(), QStringList{QStringLiteral("Containments.1")});
+    QVERIFY(!KConfig(file, KConfig::SimpleConfig | KConfig::ShardedGroups).group(QStringLiteral("Containments")).hasGroup(QStringLiteral("3.5")));
+}
+
 void KConfigTest::testThreads()
 {
     QThreadPool::globalInstance()->setMaxThreadCount(6);
@@ -1972,6 +3436,144 @@ void KConfigTest::testThreads()
     }
 }
 
+void KConfigTest::testGlobalParseCache()
+{
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/kconfig-parsecache");
+    QDir(cacheDir).removeRecursively();
+
+    const auto writeGlobal = [](const QString &value) {
+        KConfig glob(KConfig::ConfigAssociation::KdeApp, QStringLiteral("kdeglobals"), KConfig::NoGlobals);
+        glob.group("ParseCache").writeEntry("Key", value);
+        QVERIFY(glob.sync());
+    };
+    // a write drops the parsed kdeglobals of this process, the next config parses it again or uses the cache file
+    const auto readGlobal = []() {
+        return QtConcurrent::run([]() {
+                   KConfig config(KConfig::ConfigAssociation::KdeApp, s_test_subdir + QLatin1String("parsecachetest"));
+                   return config.group("ParseCache").readEntry("Key");
+               })
+            .result();
+    };
+
+    writeGlobal(QStringLiteral("first"));
+    QCOMPARE(readGlobal(), QStringLiteral("first"));
+    QCOMPARE(QDir(cacheDir).entryList(QDir::Files).size(), 1);
+    QCOMPARE(readGlobal(), QStringLiteral("first"));
+
+    // a changed source makes the cache stale
+    writeGlobal(QStringLiteral("second"));
+    QCOMPARE(readGlobal(), QStringLiteral("second"));
+    QCOMPARE(readGlobal(), QStringLiteral("second"));
+
+    // a broken cache file is ignored
+    const QString cacheFile = cacheDir + QLatin1Char('/') + QDir(cacheDir).entryList(QDir::Files).constFirst();
+    QFile file(cacheFile);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 3));
+    file.close();
+    QCOMPARE(readGlobal(), QStringLiteral("second"));
+}
+
+void KConfigTest::testSharedGlobalParse()
+{
+    const auto readGlobal = []() {
+        KConfig config(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
+        return config.group(QStringLiteral("GlobalGroup")).readEntry("globalEntry");
+    };
+    QCOMPARE(readGlobal(), s_string_entry1);
+
+    // another thread gets the files parsed by this one
+    KConfigGlobalParseCache::Statistics before = KConfigGlobalParseCache::statistics();
+    QCOMPARE(QtConcurrent::run(readGlobal).result(), s_string_entry1);
+    KConfigGlobalParseCache::Statistics after = KConfigGlobalParseCache::statistics();
+    QCOMPARE(after.hits, before.hits + 1);
+    QCOMPARE(after.misses, before.misses);
+    QVERIFY(after.cost > 0);
+    QVERIFY(after.cost <= after.budget);
+
+    // nothing fits into an empty budget
+    const qsizetype budget = after.budget;
+    KConfigGlobalParseCache::setBudget(0);
+    QCOMPARE(KConfigGlobalParseCache::statistics().size, 0);
+    before = KConfigGlobalParseCache::statistics();
+    QCOMPARE(readGlobal(), s_string_entry1);
+    after = KConfigGlobalParseCache::statistics();
+    QCOMPARE(after.misses, before.misses + 1);
+    QCOMPARE(after.size, 0);
+
+    KConfigGlobalParseCache::setBudget(budget);
+    QCOMPARE(readGlobal(), s_string_entry1);
+    QCOMPARE(KConfigGlobalParseCache::statistics().size, 1);
+}
+
+void KConfigTest::testTrimCaches()
+{
+    KConfig::trimCaches(KConfig::TrimAll);
+    QCOMPARE(KConfigGlobalParseCache::statistics().size, 0);
+
+    // the parsed global files are kept as long as a config shares them
+    auto config = std::make_unique<KConfig>(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
+    QCOMPARE(config->group(QStringLiteral("GlobalGroup")).readEntry("globalEntry"), s_string_entry1);
+    QCOMPARE(KConfigGlobalParseCache::statistics().size, 1);
+    KConfig::trimCaches(KConfig::TrimUnused);
+    QCOMPARE(KConfigGlobalParseCache::statistics().size, 1);
+    QCOMPARE(config->group(QStringLiteral("GlobalGroup")).readEntry("globalEntry"), s_string_entry1);
+
+    config.reset();
+    QVERIFY(KConfig::trimCaches(KConfig::TrimUnused) > 0);
+    QCOMPARE(KConfigGlobalParseCache::statistics().size, 0);
+
+    // trimming everything leaves what the live configs read untouched
+    KSharedConfig::Ptr shared = KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
+    KConfigGroup group = shared->group(QStringLiteral("TrimGroup"));
+    for (int i = 0; i < 100; ++i) {
+        group.writeEntry(QByteArray("Key" + QByteArray::number(i)).constData(), i);
+    }
+    for (int i = 1; i < 100; ++i) {
+        group.revertToDefault(QByteArray("Key" + QByteArray::number(i)).constData());
+    }
+    QVERIFY(KConfig::trimCaches(KConfig::TrimAll) > 0);
+    QCOMPARE(group.readEntry("Key0", -1), 0);
+    QCOMPARE(group.readEntry("Key1", -1), -1);
+    QCOMPARE(shared->group(QStringLiteral("GlobalGroup")).readEntry("globalEntry"), s_string_entry1);
+    shared->markAsClean();
+}
+
+void KConfigTest::testWatchedGlobalParse()
+{
+    const auto readGlobal = [](const char *group) {
+        KConfig config(KConfig::ConfigAssociation::KdeApp, s_test_subdir + QLatin1String("parsecachetest"));
+        return config.group(group).readEntry("Key");
+    };
+    {
+        KConfig glob(KConfig::ConfigAssociation::KdeApp, QStringLiteral("kdeglobals"), KConfig::NoGlobals);
+        glob.group("ParseCacheWatch").writeEntry("Key", "written");
+        QVERIFY(glob.sync());
+    }
+
+    KConfigGlobalParseCache::setWatchFiles(true);
+    QCOMPARE(readGlobal("ParseCacheWatch"), QStringLiteral("written"));
+    // the files are watched once the event loop ran, from then on hits don't check them
+    const KConfigGlobalParseCache::Statistics before = KConfigGlobalParseCache::statistics();
+    QTRY_VERIFY(readGlobal("ParseCacheWatch") == QLatin1String("written") && KConfigGlobalParseCache::statistics().watchedHits > before.watchedHits);
+
+    // a change by another process is noticed through the watcher
+    QFile file(QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QLatin1String("/kdeglobals"));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+    file.write("\n[ParseCacheWatchOutside]\nKey=outside\n");
+    file.close();
+    QTRY_COMPARE(readGlobal("ParseCacheWatchOutside"), QStringLiteral("outside"));
+
+    // a write of this process is seen right away
+    {
+        KConfig glob(KConfig::ConfigAssociation::KdeApp, QStringLiteral("kdeglobals"), KConfig::NoGlobals);
+        glob.group("ParseCacheWatch").writeEntry("Key", "rewritten");
+        QVERIFY(glob.sync());
+    }
+    QCOMPARE(readGlobal("ParseCacheWatch"), QStringLiteral("rewritten"));
+    KConfigGlobalParseCache::setWatchFiles(false);
+}
+
 void KConfigTest::testNotify()
 {
 #if !KCONFIG_USE_DBUS
@@ -2054,6 +3656,195 @@ void KConfigTest::testNotify()
     QCOMPARE(otherWatcherSpy[0][1].value<QByteArrayList>(), QByteArrayList({"someGlobalEntry"}));
 }
 
+void KConfigTest::testNotifyCoalesced()
+{
+#if !KCONFIG_USE_DBUS
+    QSKIP("KConfig notification requires DBus");
+#endif
+
+    KConfig config(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
+    KConfigGroup watchedGroup(&config, "CoalescedGroup");
+    KConfigGroup otherGroup(&config, "IgnoredGroup");
+
+    auto remoteConfig = KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
+    KConfigWatcher::Ptr watcher = KConfigWatcher::create(remoteConfig);
+    KConfigWatcher::Ptr groupWatcher = KConfigWatcher::create(remoteConfig, {QStringLiteral("CoalescedGroup")});
+    QVERIFY(groupWatcher != watcher);
+    QSignalSpy watcherSpy(watcher.data(), &KConfigWatcher::configChanged);
+    QSignalSpy groupWatcherSpy(groupWatcher.data(), &KConfigWatcher::configChanged);
+
+    // three syncs within the interval make a single signal
+    KConfigNotifications::setInterval(200);
+    watchedGroup.writeEntry("entryA", "foo", KConfig::Persistent | KConfig::Notify);
+    config.sync();
+    watchedGroup.writeEntry("entryB", "foo", KConfig::Persistent | KConfig::Notify);
+    watchedGroup.group("aSubGroup").writeEntry("entryC", "foo", KConfig::Persistent | KConfig::Notify);
+    config.sync();
+    watchedGroup.writeEntry("entryA", "bar", KConfig::Persistent | KConfig::Notify);
+    otherGroup.writeEntry("entryD", "foo", KConfig::Persistent | KConfig::Notify);
+    config.sync();
+    KConfigNotifications::setInterval(0);
+
+    QTRY_COMPARE(watcherSpy.count(), 3);
+    QTRY_COMPARE(groupWatcherSpy.count(), 2);
+    QTest::qWait(100);
+    QCOMPARE(watcherSpy.count(), 3);
+    QCOMPARE(groupWatcherSpy.count(), 2);
+
+    QHash<QString, QByteArrayList> changes;
+    for (const QList<QVariant> &signal : std::as_const(watcherSpy)) {
+        const KConfigGroup group = signal[0].value<KConfigGroup>();
+        changes.insert(group.name(), signal[1].value<QByteArrayList>());
+    }
+    QCOMPARE(changes.value(QStringLiteral("CoalescedGroup")), QByteArrayList({"entryA", "entryB"}));
+    QCOMPARE(changes.value(QStringLiteral("aSubGroup")), QByteArrayList({"entryC"}));
+    QCOMPARE(changes.value(QStringLiteral("IgnoredGroup")), QByteArrayList({"entryD"}));
+
+    for (const QList<QVariant> &signal : std::as_const(groupWatcherSpy)) {
+        QVERIFY(signal[0].value<KConfigGroup>().name() != QLatin1String("IgnoredGroup"));
+    }
+    QCOMPARE(remoteConfig->group(QStringLiteral("CoalescedGroup")).readEntry("entryA"), QStringLiteral("bar"));
+}
+
+void KConfigTest::testSharedSubscription()
+{
+#if !KCONFIG_USE_DBUS
+    QSKIP("KConfig notification requires DBus");
+#endif
+
+    KConfig config(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
+    KConfigGroup group(&config, "SharedSubscription");
+
+    // both watchers are fed by the one subscription of the path
+    auto remoteConfig = KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
+    KConfigWatcher::Ptr first = KConfigWatcher::create(remoteConfig, {QStringLiteral("SharedSubscription")});
+    KConfigWatcher::Ptr second = KConfigWatcher::create(remoteConfig, {QStringLiteral("SharedSubscription")});
+    QSignalSpy firstSpy(first.data(), &KConfigWatcher::configChanged);
+    QSignalSpy secondSpy(second.data(), &KConfigWatcher::configChanged);
+
+    group.writeEntry("entry", "foo", KConfig::Persistent | KConfig::Notify);
+    config.sync();
+    QTRY_COMPARE(firstSpy.count(), 1);
+    QTRY_COMPARE(secondSpy.count(), 1);
+
+    // the others keep getting the signals once a watcher is gone
+    firstSpy.clear();
+    secondSpy.clear();
+    first.reset();
+    group.writeEntry("entry", "bar", KConfig::Persistent | KConfig::Notify);
+    config.sync();
+    QTRY_COMPARE(secondSpy.count(), 1);
+    QCOMPARE(secondSpy[0][1].value<QByteArrayList>(), QByteArrayList({"entry"}));
+}
+
+void KConfigTest::testNotifyValues()
+{
+#if !KCONFIG_USE_DBUS
+    QSKIP("KConfig notification requires DBus");
+#endif
+
+    KConfig config(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
+    KConfigGroup group(&config, "ValuesGroup");
+    group.writeEntry("entryA", "foo");
+    group.writeEntry("entryB", "foo");
+    config.sync();
+
+    auto remoteConfig = KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
+    remoteConfig->reparseConfiguration();
+    KConfigWatcher::Ptr watcher = KConfigWatcher::create(remoteConfig);
+    QSignalSpy watcherSpy(watcher.data(), &KConfigWatcher::configChanged);
+    QCOMPARE(remoteConfig->group(QStringLiteral("ValuesGroup")).readEntry("entryA"), QStringLiteral("foo"));
+
+    // a change the watcher isn't told about, only seen if the file is parsed again
+    KConfig otherConfig(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
+    KConfigGroup(&otherConfig, "ValuesGroup").writeEntry("entryB", "unnotified");
+    otherConfig.sync();
+    config.reparseConfiguration();
+
+    KConfigNotifications::setIncludeValues(true);
+    group.writeEntry("entryA", "bar", KConfig::Persistent | KConfig::Notify);
+    group.writePathEntry("entryC", QStringLiteral("$HOME/values"), KConfig::Persistent | KConfig::Notify);
+    config.sync();
+    QTRY_COMPARE(watcherSpy.count(), 1);
+    QTest::qWait(100);
+    QCOMPARE(watcherSpy.count(), 1); // not once more for ConfigChanged
+    QCOMPARE(watcherSpy[0][0].value<KConfigGroup>().name(), QStringLiteral("ValuesGroup"));
+    QCOMPARE(watcherSpy[0][1].value<QByteArrayList>(), QByteArrayList({"entryA", "entryC"}));
+
+    KConfigGroup remoteGroup = remoteConfig->group(QStringLiteral("ValuesGroup"));
+    QCOMPARE(remoteGroup.readEntry("entryA"), QStringLiteral("bar"));
+    QCOMPARE(remoteGroup.readPathEntry("entryC", QString()), QDir::homePath() + QLatin1String("/values"));
+    QCOMPARE(remoteGroup.readEntry("entryB"), QStringLiteral("foo"));
+    QVERIFY(!remoteConfig->isDirty());
+
+    // a deleted entry can't be applied from the signal, the group is parsed again
+    watcherSpy.clear();
+    group.deleteEntry("entryA", KConfig::Persistent | KConfig::Notify);
+    config.sync();
+    QTRY_COMPARE(watcherSpy.count(), 1);
+    QVERIFY(!remoteGroup.hasKey("entryA"));
+    QCOMPARE(remoteGroup.readEntry("entryB"), QStringLiteral("unnotified"));
+    KConfigNotifications::setIncludeValues(false);
+}
+
+void KConfigTest::testFileNotify()
+{
+    const KConfigNotifyTransport::Kind kind = KConfigNotifyTransport::kind();
+    KConfigNotifyTransport::setKind(KConfigNotifyTransport::File);
+
+    KConfig config(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
+    KConfigGroup group(&config, "FileNotify");
+
+    auto remoteConfig = KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp, s_kconfig_test_subdir);
+    KConfigWatcher::Ptr watcher = KConfigWatcher::create(remoteConfig, {QStringLiteral("FileNotify")});
+    QSignalSpy watcherSpy(watcher.data(), &KConfigWatcher::configChanged);
+
+    group.writeEntry("entry with spaces", "foo", KConfig::Persistent | KConfig::Notify);
+    group.group("Sub").writeEntry("entry", "foo", KConfig::Persistent | KConfig::Notify);
+    config.sync();
+    QTRY_COMPARE(watcherSpy.count(), 2);
+    std::sort(watcherSpy.begin(), watcherSpy.end(), [](const QList<QVariant> &a, const QList<QVariant> &b) {
+        return a[0].value<KConfigGroup>().name() < b[0].value<KConfigGroup>().name();
+    });
+    QCOMPARE(watcherSpy[0][0].value<KConfigGroup>().name(), QStringLiteral("FileNotify"));
+    QCOMPARE(watcherSpy[0][1].value<QByteArrayList>(), QByteArrayList({"entry with spaces"}));
+    QCOMPARE(watcherSpy[1][0].value<KConfigGroup>().name(), QStringLiteral("Sub"));
+    QCOMPARE(remoteConfig->group(QStringLiteral("FileNotify")).readEntry("entry with spaces"), QStringLiteral("foo"));
+
+    watcherSpy.clear();
+    group.deleteEntry("entry with spaces", KConfig::Persistent | KConfig::Notify);
+    config.sync();
+    QTRY_COMPARE(watcherSpy.count(), 1);
+    QVERIFY(!remoteConfig->group(QStringLiteral("FileNotify")).hasKey("entry with spaces"));
+
+    watcher.reset();
+    KConfigNotifyTransport::setKind(kind);
+}
+
+void KConfigTest::testNotifyRecords()
+{
+    const QHash<QString, QByteArrayList> first = {{QStringLiteral("Group"), {"a", "b c"}}, {QStringLiteral("Parent\x1dChild"), {"%"}}};
+    const QHash<QString, QByteArrayList> second = {{QStringLiteral("Other"), {"d"}}};
+    QTemporaryDir runtimeDir;
+    qputenv("XDG_RUNTIME_DIR", QFile::encodeName(runtimeDir.path()));
+    KConfigNotifyTransport::writeFile(first, QStringLiteral("/notifyrecordsrc"));
+    KConfigNotifyTransport::writeFile(second, QStringLiteral("/notifyrecordsrc"));
+
+    QFile file(KConfigNotifyTransport::filePath(QStringLiteral("/notifyrecordsrc")));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+    qsizetype consumed = 0;
+    QCOMPARE(KConfigNotifyTransport::readRecords(data, &consumed), (QList<QHash<QString, QByteArrayList>>{first, second}));
+    QCOMPARE(consumed, data.size());
+
+    // a notification that isn't completely written yet is left for later
+    const QByteArray partial = data.chopped(1);
+    QCOMPARE(KConfigNotifyTransport::readRecords(partial, &consumed), (QList<QHash<QString, QByteArrayList>>{first}));
+    QVERIFY(KConfigNotifyTransport::readRecords(partial.mid(consumed), &consumed).isEmpty());
+    QCOMPARE(consumed, 0);
+    qunsetenv("XDG_RUNTIME_DIR");
+}
+
 void KConfigTest::testKAuthorizeEnums()
 {
     KSharedConfig::Ptr config = KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp);
@@ -2063,12 +3854,41 @@ void KConfigTest::testKAuthorizeEnums()
 
     QVERIFY(!KAuthorized::authorize(KAuthorized::SHELL_ACCESS));
     QVERIFY(!KAuthorized::authorizeAction(KAuthorized::OPEN_WITH));
+    QVERIFY(!KAuthorized::authorize(QStringLiteral("shell_access")));
+    QVERIFY(!KAuthorized::authorizeAction(QStringLiteral("open_with")));
+    QVERIFY(KAuthorized::authorizeAction(KAuthorized::BOOKMARKS));
+
+    // a changed entry is seen right away
+    actionRestrictions.writeEntry("action/open_with", true);
+    QVERIFY(KAuthorized::authorizeAction(KAuthorized::OPEN_WITH));
     actionRestrictions.deleteGroup();
+    QVERIFY(KAuthorized::authorize(KAuthorized::SHELL_ACCESS));
 
     QVERIFY(!KAuthorized::authorize((KAuthorized::GenericRestriction)0));
     QVERIFY(!KAuthorized::authorizeAction((KAuthorized::GenericAction)0));
 }
 
+void KConfigTest::testKAuthorizeControlModules()
+{
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp);
+    KConfigGroup restrictions = config->group("KDE Control Module Restrictions");
+    restrictions.writeEntry("blocked.desktop", false);
+    restrictions.writeEntry("allowed.desktop", true);
+
+    const QStringList ids{QStringLiteral("allowed.desktop"), QStringLiteral("blocked.desktop"), QStringLiteral("other.desktop")};
+    QVERIFY(!KAuthorized::authorizeControlModule(QStringLiteral("blocked.desktop")));
+    QVERIFY(KAuthorized::authorizeControlModule(QStringLiteral("other.desktop")));
+    QCOMPARE(KAuthorized::authorizeControlModules(ids), (QStringList{QStringLiteral("allowed.desktop"), QStringLiteral("other.desktop")}));
+    const QBitArray mask = KAuthorized::authorizeControlModulesMask(ids);
+    QCOMPARE(mask.size(), 3);
+    QVERIFY(mask.testBit(0));
+    QVERIFY(!mask.testBit(1));
+    QVERIFY(mask.testBit(2));
+
+    restrictions.deleteGroup();
+    QCOMPARE(KAuthorized::authorizeControlModules(ids), ids);
+}
+
 void KConfigTest::testKdeglobalsVsDefault()
 {
     // Add testRestore key with global value in kdeglobals
@@ -35,13 +35,19 @@ private Q_SLOTS:
     void testSimple();
     void testDefaults();
     void testLists();
+    void testLongLists();
+    void testTypedLists();
     void testLocale();
     void testEncoding();
     void testPath();
     void testPathQtHome();
+    void testExpansionCache();
+    void testReparseGroups();
     void testPersistenceOfExpandFlagForPath();
     void testComplex();
     void testEnums();
+    void testPrimitiveEntries();
+    void testRawEntries();
     void testEntryMap();
     void testInvalid();
     void testDeleteEntry();
@@ -50,6 +56,7 @@ private Q_SLOTS:
     void testDefaultGroup();
     void testEmptyGroup();
     void testCascadingWithLocale();
+    void testCascadeLookupCache();
     void testMerge();
     void testImmutable();
     void testGroupEscape();
@@ -81,10 +88,45 @@ private Q_SLOTS:
     void testLocalDeletion();
     void testNewlines();
     void testXdgListEntry();
+    void testCachedEntry();
+    void testBatchWrite();
+    void testWriteKeepsUnchangedGroups();
+    void testWriteEscaping();
+    void testWriteNumbers();
+    void testWriteMergesExternalChanges();
     void testNotify();
+    void testNotifyCoalesced();
+    void testSharedSubscription();
+    void testNotifyValues();
+    void testFileNotify();
+    void testNotifyRecords();
     void testKAuthorizeEnums();
+    void testKAuthorizeControlModules();
+    void testLargeFileParse();
+    void testLargeFileWrite();
+    void testLazyLoading();
+    void testCompiledConfig();
+    void testDefaultsBundle();
+    void testStringPool();
+    void testStatistics();
+    void testCacheLocales();
+    void testExitSync();
+    void testBinaryEntries();
+    void testChangesSince();
+    void testTryReadEntry();
+    void testConfigKey();
+    void testConfigEntry();
+    void testForEachEntry();
+    void testOptimisticWrites();
+    void testDurability();
+    void testJournal();
+    void testShardedGroups();
 
     void testThreads();
+    void testGlobalParseCache();
+    void testSharedGlobalParse();
+    void testTrimCaches();
+    void testWatchedGlobalParse();
 
     void testKdeglobalsVsDefault();
 
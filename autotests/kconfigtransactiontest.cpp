@@ -0,0 +1,174 @@
+/*  This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include <QFile>
+#include <QStandardPaths>
+#include <QTest>
+#include <QThread>
+
+#include <KConfigGroup>
+#include <KConfigTransaction>
+#include <KSharedConfig>
+
+#include <atomic>
+
+class KConfigTransactionTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void testCommit();
+    void testSharedFiles();
+    void testNothingToWrite();
+    void testAnonymousConfig();
+    void testConcurrentSync();
+
+private:
+    QString m_appFile;
+    QString m_stateFile;
+    QString m_globalFile;
+};
+
+static QString readEntry(const QString &fileName, const char *key)
+{
+    KConfig config(fileName, KConfig::SimpleConfig);
+    return config.group(QStringLiteral("Group")).readEntry(key, QString());
+}
+
+void KConfigTransactionTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    const QString location = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation);
+    m_appFile = location + QLatin1String("/kconfigtransactiontestrc");
+    m_stateFile = location + QLatin1String("/kconfigtransactiontest.state");
+    m_globalFile = location + QLatin1String("/kdeglobals");
+}
+
+void KConfigTransactionTest::init()
+{
+    QFile::remove(m_appFile);
+    QFile::remove(m_stateFile);
+    QFile::remove(m_globalFile);
+}
+
+void KConfigTransactionTest::testCommit()
+{
+    KConfig app(m_appFile, KConfig::SimpleConfig);
+    KSharedConfig::Ptr state = KSharedConfig::openConfig(m_stateFile, KConfig::SimpleConfig);
+    app.group(QStringLiteral("Group")).writeEntry("Key", "app");
+    state->group(QStringLiteral("Group")).writeEntry("Key", "state");
+
+    KConfigTransaction transaction;
+    transaction.addConfig(&app);
+    transaction.addConfig(state);
+    transaction.addConfig(&app);
+    QCOMPARE(transaction.configs(), (QList<KConfig *>{&app, state.data()}));
+
+    QVERIFY(transaction.commit());
+    QVERIFY(transaction.configs().isEmpty());
+    QVERIFY(!app.isDirty());
+    QVERIFY(!state->isDirty());
+    QCOMPARE(readEntry(m_appFile, "Key"), QStringLiteral("app"));
+    QCOMPARE(readEntry(m_stateFile, "Key"), QStringLiteral("state"));
+}
+
+void KConfigTransactionTest::testSharedFiles()
+{
+    // both write to kdeglobals, which is locked and written once for each of them
+    KConfig app(m_appFile, KConfig::IncludeGlobals);
+    KConfig globals(m_globalFile, KConfig::SimpleConfig);
+    app.group(QStringLiteral("Group")).writeEntry("Local", "app");
+    app.group(QStringLiteral("Group")).writeEntry("Global", "app", KConfig::Persistent | KConfig::Global);
+    globals.group(QStringLiteral("Group")).writeEntry("Key", "globals");
+
+    KConfigTransaction transaction;
+    transaction.addConfig(&app);
+    transaction.addConfig(&globals);
+    QVERIFY(transaction.commit());
+    QCOMPARE(readEntry(m_appFile, "Local"), QStringLiteral("app"));
+    QCOMPARE(readEntry(m_appFile, "Global"), QString());
+    QCOMPARE(readEntry(m_globalFile, "Global"), QStringLiteral("app"));
+    QCOMPARE(readEntry(m_globalFile, "Key"), QStringLiteral("globals"));
+}
+
+void KConfigTransactionTest::testNothingToWrite()
+{
+    KConfig app(m_appFile, KConfig::SimpleConfig);
+    KConfigTransaction transaction;
+    QVERIFY(transaction.commit());
+    transaction.addConfig(&app);
+    QVERIFY(transaction.commit());
+    QVERIFY(!QFile::exists(m_appFile));
+}
+
+void KConfigTransactionTest::testAnonymousConfig()
+{
+    KConfig app(m_appFile, KConfig::SimpleConfig);
+    KConfig anonymous(QString(), KConfig::SimpleConfig);
+    app.group(QStringLiteral("Group")).writeEntry("Key", "app");
+    anonymous.group(QStringLiteral("Group")).writeEntry("Key", "anonymous");
+
+    // none of the configs is written
+    KConfigTransaction transaction;
+    transaction.addConfig(&app);
+    transaction.addConfig(&anonymous);
+    QVERIFY(!transaction.commit());
+    QVERIFY(app.isDirty());
+    QVERIFY(!QFile::exists(m_appFile));
+
+    QVERIFY(app.sync());
+    QCOMPARE(readEntry(m_appFile, "Key"), QStringLiteral("app"));
+}
+
+void KConfigTransactionTest::testConcurrentSync()
+{
+    // sorts after kdeglobals, which both lock after it
+    const QString file = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QLatin1String("/lockordertestrc");
+    QFile::remove(file);
+    const auto write = [](KConfig *config, int i) {
+        config->group(QStringLiteral("Group")).writeEntry("Local", i);
+        config->group(QStringLiteral("Group")).writeEntry("Global", i, KConfig::Persistent | KConfig::Global);
+    };
+
+    std::atomic<int> failures{0};
+    QThread *committing = QThread::create([&]() {
+        for (int i = 0; i < 50; ++i) {
+            KConfig config(file, KConfig::IncludeGlobals);
+            write(&config, i);
+            KConfigTransaction transaction;
+            transaction.addConfig(&config);
+            if (!transaction.commit()) {
+                ++failures;
+            }
+        }
+    });
+    QThread *syncing = QThread::create([&]() {
+        for (int i = 0; i < 50; ++i) {
+            KConfig config(file, KConfig::IncludeGlobals);
+            write(&config, i);
+            if (!config.sync()) {
+                ++failures;
+            }
+        }
+    });
+    committing->start();
+    syncing->start();
+    // each holding one of the locks the other waits for, neither would finish
+    QVERIFY(committing->wait(QDeadlineTimer(60000)));
+    QVERIFY(syncing->wait(QDeadlineTimer(60000)));
+    delete committing;
+    delete syncing;
+    QCOMPARE(failures.load(), 0);
+    QFile::remove(file);
+}
+
+QTEST_MAIN(KConfigTransactionTest)
+
+#include "kconfigtransactiontest.moc"
@@ -0,0 +1,135 @@
+/*  This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include <QDir>
+#include <QFile>
+#include <QLocale>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <kdesktopfile.h>
+#include <kdesktopfileindex.h>
+
+class KDesktopFileIndexTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testFields();
+    void testShadowed();
+    void testRefresh();
+};
+
+static void writeFile(const QString &path, const QByteArray &contents)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(contents);
+}
+
+void KDesktopFileIndexTest::initTestCase()
+{
+    QLocale::setDefault(QLocale(QStringLiteral("de_DE")));
+}
+
+void KDesktopFileIndexTest::testFields()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString app = dir.filePath(QStringLiteral("app.desktop"));
+    writeFile(app,
+              "[Desktop Entry]\n"
+              "Type=Application\n"
+              "Name=Text Editor\n"
+              "Name[de]=Texteditor\n"
+              "Name[fr]=Éditeur de texte\n"
+              "Icon=accessories-text-editor\n"
+              "Actions=new-window;new\\;document;\n"
+              "\n"
+              "[Desktop Action new-window]\n"
+              "Name=New Window\n");
+    const QString hidden = dir.filePath(QStringLiteral("sub/hidden.desktop"));
+    writeFile(hidden,
+              "[Desktop Entry]\n"
+              "Type=Service\n"
+              "Name=Hidden\n"
+              "OnlyShowIn=GNOME;\n");
+
+    KDesktopFileIndex index({dir.path()});
+    QCOMPARE(index.count(), 2);
+
+    const int appRow = index.indexOf(app);
+    QVERIFY(appRow >= 0);
+    KDesktopFile desktopFile(app);
+    QCOMPARE(index.filePath(appRow), app);
+    QCOMPARE(index.readName(appRow), desktopFile.readName());
+    QCOMPARE(index.readName(appRow), QStringLiteral("Texteditor"));
+    QCOMPARE(index.readIcon(appRow), desktopFile.readIcon());
+    QCOMPARE(index.readType(appRow), desktopFile.readType());
+    QCOMPARE(index.readActions(appRow), desktopFile.readActions());
+    QCOMPARE(index.noDisplay(appRow), desktopFile.noDisplay());
+
+    const int hiddenRow = index.indexOf(hidden);
+    QVERIFY(hiddenRow >= 0);
+    QCOMPARE(index.readType(hiddenRow), QStringLiteral("Service"));
+    QVERIFY(index.noDisplay(hiddenRow));
+    QCOMPARE(index.noDisplay(hiddenRow), KDesktopFile(hidden).noDisplay());
+
+    QCOMPARE(index.indexOf(dir.filePath(QStringLiteral("missing.desktop"))), -1);
+}
+
+void KDesktopFileIndexTest::testShadowed()
+{
+    QTemporaryDir first;
+    QTemporaryDir second;
+    writeFile(first.filePath(QStringLiteral("app.desktop")), "[Desktop Entry]\nName=First\n");
+    writeFile(second.filePath(QStringLiteral("app.desktop")), "[Desktop Entry]\nName=Second\n");
+    writeFile(second.filePath(QStringLiteral("other.desktop")), "[Desktop Entry]\nName=Other\n");
+
+    KDesktopFileIndex index({first.path(), second.path()});
+    QCOMPARE(index.count(), 2);
+    QCOMPARE(index.readName(index.indexOf(first.filePath(QStringLiteral("app.desktop")))), QStringLiteral("First"));
+    QCOMPARE(index.indexOf(second.filePath(QStringLiteral("app.desktop"))), -1);
+}
+
+void KDesktopFileIndexTest::testRefresh()
+{
+    QTemporaryDir dir;
+    for (int i = 0; i < 100; ++i) {
+        writeFile(dir.filePath(QStringLiteral("app%1.desktop").arg(i)), "[Desktop Entry]\nName=App " + QByteArray::number(i) + "\n");
+    }
+
+    KDesktopFileIndex index({dir.path()});
+    QCOMPARE(index.count(), 100);
+    for (int i = 0; i < 100; ++i) {
+        const int row = index.indexOf(dir.filePath(QStringLiteral("app%1.desktop").arg(i)));
+        QCOMPARE(index.readName(row), QStringLiteral("App %1").arg(i));
+    }
+    QVERIFY(!index.refresh());
+
+    const QString changed = dir.filePath(QStringLiteral("app7.desktop"));
+    const int changedRow = index.indexOf(changed);
+    writeFile(changed, "[Desktop Entry]\nName=Changed and longer\n");
+    QVERIFY(QFile::remove(dir.filePath(QStringLiteral("app3.desktop"))));
+    const QString added = dir.filePath(QStringLiteral("added.desktop"));
+    writeFile(added, "[Desktop Entry]\nName=Added\n");
+
+    QVERIFY(index.refresh());
+    QCOMPARE(index.count(), 100);
+    QCOMPARE(index.indexOf(dir.filePath(QStringLiteral("app3.desktop"))), -1);
+    QCOMPARE(index.readName(index.indexOf(changed)), QStringLiteral("Changed and longer"));
+    QVERIFY(index.indexOf(changed) <= changedRow);
+    QCOMPARE(index.indexOf(added), 99);
+    QCOMPARE(index.readName(99), QStringLiteral("Added"));
+}
+
+QTEST_MAIN(KDesktopFileIndexTest)
+
+#include "kdesktopfileindextest.moc"
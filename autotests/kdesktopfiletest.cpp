@@ -171,6 +171,36 @@ void KDesktopFileTest::testActionGroup()
     QCOMPARE(cg.readEntry("Name"), QStringLiteral("With semicolon"));
 }
 
+void KDesktopFileTest::testDesktopEntryOnly()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    const QString fileName = file.fileName();
+    QTextStream ts(&file);
+    ts << "[Desktop Action encrypt]\n"
+          "Name=Encrypt file\n"
+          "[Desktop Entry]\n"
+          "Type=Application\n"
+          "Name=Crypto\n"
+          "Name[xx]=Other language\n"
+          "Actions=encrypt;decrypt;\n"
+          "[Desktop Action decrypt]\n"
+          "Name=Decrypt file\n"
+          "\n";
+    file.close();
+
+    KDesktopFile full(fileName);
+    KDesktopFile df(fileName, KDesktopFile::DesktopEntryOnly);
+    QVERIFY(df.openFlags() & KConfig::LazyLoading);
+    QCOMPARE(df.readType(), full.readType());
+    QCOMPARE(df.readName(), QStringLiteral("Crypto"));
+    QCOMPARE(df.readActions(), full.readActions());
+    QCOMPARE(df.groupList(), full.groupList());
+    QVERIFY(df.hasActionGroup(QStringLiteral("decrypt")));
+    QCOMPARE(df.actionGroup(QStringLiteral("encrypt")).readEntry("Name"), QStringLiteral("Encrypt file"));
+    QCOMPARE(df.actionGroup(QStringLiteral("decrypt")).readEntry("Name"), QStringLiteral("Decrypt file"));
+}
+
 void KDesktopFileTest::testIsAuthorizedDesktopFile()
 {
     QTemporaryFile file(QStringLiteral("testAuthXXXXXX.desktop"));
@@ -300,3 +330,16 @@ void KDesktopFileTest::testLocateLocal()
 
     QCOMPARE(KDesktopFile::locateLocal(path), result);
 }
+
+void KDesktopFileTest::benchmarkParseTranslated()
+{
+    // a real desktop file with a translation of its comment in about 80 languages
+    const QString fileName = QFINDTESTDATA("../src/core/kconfigbackend.desktop");
+    QVERIFY(!fileName.isEmpty());
+
+    QBENCHMARK {
+        KConfig config(fileName, KConfig::SimpleConfig);
+        config.setLocale(QStringLiteral("de"));
+        QCOMPARE(config.group(QStringLiteral("Desktop Entry")).readEntry("Comment"), QString::fromUtf8("Speicher-Unterstützung für KConfig"));
+    }
+}
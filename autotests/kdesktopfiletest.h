@@ -21,10 +21,12 @@ private Q_SLOTS:
     void testUnsuccessfulTryExec();
     void testSuccessfulTryExec();
     void testActionGroup();
+    void testDesktopEntryOnly();
     void testIsAuthorizedDesktopFile();
     void testTryExecWithAuthorizeAction();
     void testLocateLocal_data();
     void testLocateLocal();
+    void benchmarkParseTranslated();
 };
 
 #endif /* KDESKTOPFILETEST_H */
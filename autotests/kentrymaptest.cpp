@@ -6,6 +6,7 @@
 
 #include "kentrymaptest.h"
 
+#include <QFile>
 #include <QTest>
 
 // clazy:excludeall=non-pod-global-static
@@ -62,13 +63,19 @@ void KEntryMapTest::testSimple()
     QVERIFY(map.constFindEntry(group1, key2) != map.cend());
     QCOMPARE(map.constFindEntry(group1, key2.toUpper()), map.cend());
 
-    QByteArray found = map.constFindEntry(group1, key1)->mValue;
+    QByteArray found = map.constFindEntry(group1, key1)->toByteArray();
     QCOMPARE(found, value1);
     QVERIFY(found != value2);
 
-    found = map.constFindEntry(group1, key2)->mValue;
+    found = map.constFindEntry(group1, key2)->toByteArray();
     QVERIFY(found != value1);
     QCOMPARE(found, value2);
+
+    // lookups by views, which don't need to be null terminated
+    const char buffer[] = "A GroupA KeyZ";
+    QCOMPARE(map.constFindEntry(QByteArrayView(buffer, 7), QByteArrayView(buffer + 7, 5)), map.constFindEntry(group1, key1));
+    QCOMPARE(map.constFindEntry("A Group", "A Key"), map.constFindEntry(group1, key1));
+    QCOMPARE(map.constFindEntry(QByteArrayView(buffer, 7), QByteArrayView(buffer + 7, 6)), map.cend());
 }
 
 void KEntryMapTest::testDirty()
@@ -84,41 +91,275 @@ void KEntryMapTest::testDirty()
     QCOMPARE(ret, false);
 }
 
-void KEntryMapTest::testDefault()
+void KEntryMapTest::testDirtyGroups()
+{
+    KEntryMap map;
+    for (int i = 0; i < 10; ++i) {
+        map.setEntry("Group" + QByteArray::number(i), key1, value1, EntryOptions());
+    }
+
+    const auto dirtyKeys = [&map](bool clean) {
+        QList<KEntryKey> keys;
+        map.forEachDirtyEntry([&keys, clean](KEntryMapIterator it) {
+            keys.append(it.key());
+            if (clean) {
+                it->bDirty = false;
+            }
+        });
+        return keys;
+    };
+    QVERIFY(dirtyKeys(false).isEmpty());
+
+    map.setEntry("Group3", key2, value2, EntryDirty);
+    map.setEntry("Group7", key1, value2, EntryDirty);
+    map.setEntryOption("Group5", key1, SearchFlags(), EntryDirty, true);
+    QVERIFY(map.revertEntry("Group1", key1, EntryOptions()));
+    KEntryMap::EntryWrite write{"New", "value", EntryDirty};
+    map.setEntries("Group9", {write});
+
+    QList<KEntryKey> keys = dirtyKeys(false);
+    QCOMPARE(keys.size(), 5);
+    QVERIFY(keys.at(0).mGroup == "Group1");
+    QVERIFY(keys.at(1).mGroup == "Group3" && keys.at(1).mKey == key2);
+    QVERIFY(keys.at(2).mGroup == "Group5");
+    QVERIFY(keys.at(3).mGroup == "Group7");
+    QVERIFY(keys.at(4).mGroup == "Group9" && keys.at(4).mKey == "New");
+
+    // entries left dirty are found again, the cleaned ones not
+    map.forEachDirtyEntry([](KEntryMapIterator it) {
+        if (it.key().mGroup != "Group3") {
+            it->bDirty = false;
+        }
+    });
+    QCOMPARE(dirtyKeys(true).size(), 1);
+    QVERIFY(dirtyKeys(false).isEmpty());
+
+    // changing entries of a copy doesn't affect the original
+    KEntryMap copy = map;
+    copy.findEntry("Group0", key1)->bDirty = true;
+    QCOMPARE(copy.findEntry("Group0", key1)->bDirty, true);
+    QVERIFY(dirtyKeys(false).isEmpty());
+    int count = 0;
+    copy.forEachDirtyEntry([&count](KEntryMapIterator) {
+        ++count;
+    });
+    QCOMPARE(count, 1);
+
+    int markers = 0;
+    map.forEachGroupMarker([&markers](KEntryMapConstIterator it) {
+        QVERIFY(it.key().mKey.isNull());
+        ++markers;
+    });
+    QCOMPARE(markers, 10);
+}
+
+void KEntryMapTest::testDirtyRange()
 {
     KEntryMap map;
+    for (int i = 10; i < 30; ++i) {
+        map.setEntry(group1, "Key" + QByteArray::number(i), value1, EntryOptions());
+    }
+    const auto dirtyKeys = [&map](bool keepKey25) {
+        QByteArrayList keys;
+        map.forEachDirtyEntry([&keys, keepKey25](KEntryMapIterator it) {
+            keys.append(it.key().mKey + (it.key().bLocal ? "[l]" : ""));
+            it->bDirty = keepKey25 && it.key().mKey == "Key25";
+        });
+        return keys;
+    };
+
+    // only the entries between the first and the last changed key are looked at,
+    // that range still has to find the ones in between and the localized ones
+    map.setEntry(group1, "Key20", value2, EntryDirty);
+    map.setEntry(group1, "Key12", value2, EntryDirty);
+    map.setEntry(group1, "Key25", value2, EntryDirty);
+    map.setEntry(group1, "Key15", value2, EntryDirty | EntryLocalized);
+    QCOMPARE(dirtyKeys(true), (QByteArrayList{"Key12", "Key15[l]", "Key20", "Key25"}));
+    QCOMPARE(dirtyKeys(false), QByteArrayList{"Key25"});
+    QVERIFY(dirtyKeys(false).isEmpty());
+
+    // a new first key and the group marker
+    map.setEntry(group1, "Key00", value2, EntryDirty);
+    map.setEntryOption(group1, QByteArray(), SearchFlags(), EntryDirty, true);
+    QCOMPARE(dirtyKeys(false), (QByteArrayList{"", "Key00"}));
+
+    map.setEntry(group1, "Key29", value2, EntryDirty);
+    const KEntryMap taken = map.takeDirtyEntries();
+    QCOMPARE(taken.size(), 2); // with the group marker
+    QVERIFY(taken.hasEntry(group1, "Key29"));
+}
 
+void KEntryMapTest::testTakeDirtyEntries()
+{
+    const QByteArray group2("Another Group");
+    KEntryMap map;
     map.setEntry(group1, key1, value1, EntryDefault);
-    QCOMPARE(map.size(), 3); // group marker, default, entry
+    map.setEntry(group1, key1, value2, EntryDirty);
+    map.setEntry(group1, key2, value1, EntryOptions());
+    map.setEntry(group2, key1, value1, EntryOptions());
+    map.setEntry(group2, key2, QByteArray(), EntryDirty | EntryDeleted);
+
+    KEntryMap taken = map.takeDirtyEntries();
+
+    // nothing is dirty in the original anymore, all values are kept
+    int dirty = 0;
+    map.forEachDirtyEntry([&dirty](KEntryMapIterator) {
+        ++dirty;
+    });
+    QCOMPARE(dirty, 0);
+    QCOMPARE(map.size(), 7);
+    QCOMPARE(map.findEntry(group1, key1)->toByteArray(), value2);
+
+    // the markers, the dirty entries and the default of the first one
+    QCOMPARE(taken.size(), 5);
+    QVERIFY(taken.hasEntry(group1));
+    QVERIFY(taken.hasEntry(group2));
+    QCOMPARE(taken.findEntry(group1, key1)->toByteArray(), value2);
+    QCOMPARE(taken.findEntry(group1, key1, SearchDefaults)->toByteArray(), value1);
+    QVERIFY(taken.hasDefault(taken.findEntry(group1, key1)));
+    QVERIFY(!taken.hasEntry(group1, key2));
+    QVERIFY(!taken.hasEntry(group2, key1));
+    QVERIFY(taken.findEntry(group2, key2)->bDeleted);
+
+    QList<KEntryKey> keys;
+    taken.forEachDirtyEntry([&keys](KEntryMapIterator it) {
+        keys.append(it.key());
+    });
+    QCOMPARE(keys.size(), 2);
+    QVERIFY(keys.at(0).mGroup == group1 && keys.at(0).mKey == key1);
+    QVERIFY(keys.at(1).mGroup == group2 && keys.at(1).mKey == key2);
+
+    QCOMPARE(map.takeDirtyEntries().size(), 2); // only the markers
+}
+
+void KEntryMapTest::testMarkAllDirty()
+{
+    const QByteArray group2("Another Group");
+    KEntryMap source;
+    source.setEntry(group1, key1, value1, EntryOptions());
+    source.setEntry(group1, key2, value2, EntryOptions());
+    source.setEntry(group2, key1, value1, EntryOptions());
+
+    KEntryMap copy = source;
+    copy.markAllDirty();
+    // the groups aren't touched by that
+    QCOMPARE(copy.memoryUsage().sharedGroups, qsizetype(2));
+    QVERIFY(copy.getEntryOption(copy.constFindEntry(group1, key1), EntryDirty));
+    QVERIFY(!source.getEntryOption(source.constFindEntry(group1, key1), EntryDirty));
+
+    // changing an entry gives its group entries of its own, all of them still dirty
+    copy.setEntry(group1, key1, value2, EntryOptions());
+    QCOMPARE(copy.memoryUsage().sharedGroups, qsizetype(1));
+    QVERIFY(copy.getEntryOption(copy.constFindEntry(group1, key2), EntryDirty));
+    QCOMPARE(source.findEntry(group1, key1)->toByteArray(), value1);
+
+    KEntryMap taken = copy.takeDirtyEntries();
+    QCOMPARE(taken.size(), copy.size());
+    QVERIFY(taken.getEntryOption(taken.constFindEntry(group2, key1), EntryDirty));
+    QVERIFY(!copy.getEntryOption(copy.constFindEntry(group2, key1), EntryDirty));
+
+    int dirty = 0;
+    taken.forEachDirtyEntry([&dirty](KEntryMapIterator it) {
+        ++dirty;
+        it->bDirty = false;
+    });
+    QCOMPARE(dirty, int(taken.size()));
+    QVERIFY(!taken.getEntryOption(taken.constFindEntry(group2, key1), EntryDirty));
+}
+
+void KEntryMapTest::testRemoveKeys()
+{
+    const QByteArray group2("Another Group");
+    KEntryMap map;
+    map.setEntry(group1, key1, value1, EntryOptions());
     map.setEntry(group1, key2, value2, EntryOptions());
-    QCOMPARE(map.size(), 4); // group marker, default1, entry1, entry2
+    map.setEntry(group2, key1, value1, EntryOptions());
+    QCOMPARE(map.size(), 5); // two group markers
+
+    // unsorted, and with a key that isn't there
+    const QList<KEntryKey> keys{KEntryKey(group2, key1), KEntryKey(group1, key1), KEntryKey(group1, "No Such Key"), KEntryKey(group2)};
+    QCOMPARE(map.remove(keys), qsizetype(3));
+    QCOMPARE(map.size(), 2);
+    QVERIFY(map.constFindEntry(group1, key1) == map.constEnd());
+    QCOMPARE(map.constFindEntry(group1, key2)->toByteArray(), value2);
+    QVERIFY(map.constFindEntry(group2) == map.constEnd());
+    QCOMPARE(map.remove(QList<KEntryKey>()), qsizetype(0));
+}
 
-    const auto defaultEntry(map.constFindEntry(group1, key1, SearchDefaults));
-    const auto entry1(map.constFindEntry(group1, key1));
-    const auto entry2(map.constFindEntry(group1, key2));
+void KEntryMapTest::testDefault()
+{
+    KEntryMap map;
+
+    map.setEntry(group1, key1, value1, EntryDefault);
+    QCOMPARE(map.size(), 2); // group marker, entry sharing its default
+    map.setEntry(group1, key2, value2, EntryOptions());
+    QCOMPARE(map.size(), 3); // group marker, entry1 sharing its default, entry2
+
+    // the iterators don't survive changes to the map
+    const auto defaultEntry = [&map]() {
+        return map.constFindEntry(group1, key1, SearchDefaults);
+    };
+    const auto entry1 = [&map]() {
+        return map.constFindEntry(group1, key1);
+    };
+    const auto entry2 = [&map]() {
+        return map.constFindEntry(group1, key2);
+    };
 
     // default set for entry1
-    QVERIFY(defaultEntry != map.constEnd());
-    QCOMPARE(defaultEntry->mValue, entry1->mValue);
+    QVERIFY(defaultEntry() != map.constEnd());
+    QCOMPARE(defaultEntry()->toByteArray(), entry1()->toByteArray());
+    QVERIFY(map.hasDefault(entry1()));
 
     // no default set for entry2
     QCOMPARE(map.constFindEntry(group1, key2, SearchDefaults), map.cend());
+    QVERIFY(!map.hasDefault(entry2()));
 
-    // change from default
+    // change from default, the default gets an entry of its own
     map.setEntry(group1, key1, value2, EntryOptions());
-    QVERIFY(defaultEntry->mValue != entry1->mValue);
-    QVERIFY(entry1 != entry2);
-    QCOMPARE(entry1->mValue, entry2->mValue);
+    QCOMPARE(map.size(), 4);
+    QCOMPARE(defaultEntry()->toByteArray(), value1);
+    QVERIFY(defaultEntry()->toByteArray() != entry1()->toByteArray());
+    QVERIFY(entry1() != entry2());
+    QCOMPARE(entry1()->toByteArray(), entry2()->toByteArray());
+    QVERIFY(map.hasDefault(entry1()));
 
     // revert entry1
     map.revertEntry(group1, key1, EntryOptions());
-    QCOMPARE(defaultEntry->mValue, entry1->mValue);
+    QCOMPARE(defaultEntry()->toByteArray(), entry1()->toByteArray());
+    QVERIFY(entry1()->bDirty);
+    QVERIFY(!defaultEntry()->bDirty);
 
     // revert entry2, no default --> should be marked as deleted
     map.revertEntry(group1, key2, EntryOptions());
-    QCOMPARE(entry2->mValue, QByteArray());
-    QVERIFY(entry2->bDirty);
-    QVERIFY(entry2->bReverted);
+    QCOMPARE(entry2()->toByteArray(), QByteArray());
+    QVERIFY(entry2()->bDirty);
+    QVERIFY(entry2()->bReverted);
+}
+
+void KEntryMapTest::testSharedDefault()
+{
+    const QByteArray translated("bonjour");
+    KEntryMap map;
+
+    // reverting an entry that still has its default value
+    map.setEntry(group1, key1, value1, EntryDefault);
+    QVERIFY(map.revertEntry(group1, key1, EntryOptions()));
+    QVERIFY(map.constFindEntry(group1, key1)->bReverted);
+    QVERIFY(!map.constFindEntry(group1, key1, SearchDefaults)->bReverted);
+    QCOMPARE(map.constFindEntry(group1, key1, SearchDefaults)->toByteArray(), value1);
+
+    // a new default replaces the overridden one and shares the entry again
+    map.setEntry(group1, key1, value2, EntryDefault);
+    QCOMPARE(map.size(), 2);
+    QCOMPARE(map.constFindEntry(group1, key1)->toByteArray(), value2);
+    QCOMPARE(map.constFindEntry(group1, key1, SearchDefaults)->toByteArray(), value2);
+
+    // a non-localized value removes the localized one, but not its default
+    map.setEntry(group1, key1, translated, EntryDefault | EntryLocalized);
+    map.setEntry(group1, key1, value1, EntryOptions());
+    QCOMPARE(map.constFindEntry(group1, key1, SearchLocalized)->toByteArray(), value1);
+    QCOMPARE(map.constFindEntry(group1, key1, SearchLocalized | SearchDefaults)->toByteArray(), translated);
 }
 
 void KEntryMapTest::testDelete()
@@ -127,11 +368,12 @@ void KEntryMapTest::testDelete()
 
     map.setEntry(group1, key1, value1, EntryDefault);
     map.setEntry(group1, key2, value2, EntryDefault);
-    QCOMPARE(map.size(), 5);
+    QCOMPARE(map.size(), 3);
 
     map.setEntry(group1, key2, QByteArray(), EntryDeleted | EntryDirty);
-    QCOMPARE(map.size(), 5); // entry should still be in map, so it can override merged entries later
-    QCOMPARE(map.constFindEntry(group1, key2)->mValue, QByteArray());
+    QCOMPARE(map.size(), 4); // entry should still be in map, so it can override merged entries later
+    QCOMPARE(map.constFindEntry(group1, key2)->toByteArray(), QByteArray());
+    QCOMPARE(map.constFindEntry(group1, key2, SearchDefaults)->toByteArray(), value2);
 }
 
 void KEntryMapTest::testGlobal()
@@ -154,7 +396,7 @@ void KEntryMapTest::testImmutable()
     QCOMPARE(map.constFindEntry(group1, key1)->bImmutable, true); // verify the immutable bit was set
 
     map.setEntry(group1, key1, value2, EntryOptions());
-    QCOMPARE(map.constFindEntry(group1, key1)->mValue, value1); // verify the value didn't change
+    QCOMPARE(map.constFindEntry(group1, key1)->toByteArray(), value1); // verify the value didn't change
 
     map.clear();
 
@@ -165,6 +407,40 @@ void KEntryMapTest::testImmutable()
     QCOMPARE(map.constFindEntry(group1, key1), map.cend());
 }
 
+void KEntryMapTest::testMayHaveImmutableEntries()
+{
+    const QByteArray group2("Another Group");
+    KEntryMap map;
+    QVERIFY(!map.mayHaveImmutableEntries(group1));
+
+    map.setEntry(group1, key1, value1, EntryOptions());
+    map.setEntry(group2, key1, value1, EntryOptions());
+    QVERIFY(!map.mayHaveImmutableEntries(group1));
+    QVERIFY(!map.mayHaveImmutableEntries(group2));
+
+    // through setEntry(), after the group was found to have none
+    map.setEntry(group1, key2, value2, EntryImmutable);
+    QVERIFY(map.mayHaveImmutableEntries(group1));
+    QVERIFY(!map.mayHaveImmutableEntries(group2));
+
+    // through setEntryOption(), which changes the entry in place
+    map.setEntryOption(group2, key1, SearchFlags(), EntryImmutable, true);
+    QVERIFY(map.mayHaveImmutableEntries(group2));
+    map.setEntryOption(group2, key1, SearchFlags(), EntryImmutable, false);
+    QVERIFY(!map.mayHaveImmutableEntries(group2));
+
+    // the marker of an immutable group
+    map.setEntry(group2, QByteArray(), QByteArray(), EntryImmutable);
+    QVERIFY(map.mayHaveImmutableEntries(group2));
+
+    // a copy keeps what was found, and finds it again once changed
+    KEntryMap copy = map;
+    QVERIFY(copy.mayHaveImmutableEntries(group1));
+    copy.setEntryOption(group1, key2, SearchFlags(), EntryImmutable, false);
+    QVERIFY(!copy.mayHaveImmutableEntries(group1));
+    QVERIFY(map.mayHaveImmutableEntries(group1));
+}
+
 void KEntryMapTest::testLocale()
 {
     const QByteArray translatedDefault("hola");
@@ -173,17 +449,446 @@ void KEntryMapTest::testLocale()
     KEntryMap map;
 
     map.setEntry(group1, key1, untranslated, EntryDefault);
-    QCOMPARE(map.constFindEntry(group1, key1)->mValue, untranslated);
-    QCOMPARE(map.constFindEntry(group1, key1, SearchLocalized)->mValue, untranslated); // no localized value yet
+    QCOMPARE(map.constFindEntry(group1, key1)->toByteArray(), untranslated);
+    QCOMPARE(map.constFindEntry(group1, key1, SearchLocalized)->toByteArray(), untranslated); // no localized value yet
 
     map.setEntry(group1, key1, translated, EntryLocalized);
 
-    QCOMPARE(map.constFindEntry(group1, key1, SearchLocalized)->mValue, translated); // has localized value now
-    QVERIFY(map.constFindEntry(group1, key1, SearchLocalized)->mValue != map.constFindEntry(group1, key1)->mValue);
-    QCOMPARE(map.constFindEntry(group1, key1, SearchDefaults | SearchLocalized)->mValue, untranslated); // default should still be untranslated
+    QCOMPARE(map.constFindEntry(group1, key1, SearchLocalized)->toByteArray(), translated); // has localized value now
+    QVERIFY(map.constFindEntry(group1, key1, SearchLocalized)->toByteArray() != map.constFindEntry(group1, key1)->toByteArray());
+    QCOMPARE(map.constFindEntry(group1, key1, SearchDefaults | SearchLocalized)->toByteArray(), untranslated); // default should still be untranslated
 
     map.setEntry(group1, key1, translatedDefault, EntryDefault | EntryLocalized);
-    QCOMPARE(map.constFindEntry(group1, key1, SearchLocalized)->mValue, translatedDefault);
+    QCOMPARE(map.constFindEntry(group1, key1, SearchLocalized)->toByteArray(), translatedDefault);
     map.setEntry(group1, key1, translated, EntryLocalized); // set the translated entry to a different locale
-    QCOMPARE(map.constFindEntry(group1, key1, SearchLocalized)->mValue, translated);
+    QCOMPARE(map.constFindEntry(group1, key1, SearchLocalized)->toByteArray(), translated);
+}
+
+void KEntryMapTest::testLocalizedNeighbours()
+{
+    KEntryMap map;
+    map.setEntry(group1, QByteArray("Key"), QByteArray("default"), EntryDefault);
+    map.setEntry(group1, QByteArray("Key"), QByteArray("plain"), EntryOptions());
+    map.setEntry(group1, QByteArray("Key"), QByteArray("localizedDefault"), EntryDefault | EntryLocalized);
+    map.setEntry(group1, QByteArray("Key"), QByteArray("localized"), EntryLocalized);
+    map.setEntry(group1, QByteArray("Ke"), QByteArray("shorter"), EntryLocalized);
+    map.setEntry(group1, QByteArray("Key2"), QByteArray("longer"), EntryOptions());
+
+    QCOMPARE(map.constFindEntry(group1, "Key")->toByteArray(), QByteArray("plain"));
+    QCOMPARE(map.constFindEntry(group1, "Key", SearchDefaults)->toByteArray(), QByteArray("default"));
+    QCOMPARE(map.constFindEntry(group1, "Key", SearchLocalized)->toByteArray(), QByteArray("localized"));
+    QCOMPARE(map.constFindEntry(group1, "Key", SearchLocalized | SearchDefaults)->toByteArray(), QByteArray("localizedDefault"));
+
+    // the variants of the neighbouring keys aren't taken for the ones of the key
+    QCOMPARE(map.constFindEntry(group1, "Key2", SearchLocalized)->toByteArray(), QByteArray("longer"));
+    QCOMPARE(map.constFindEntry(group1, "Ke", SearchLocalized)->toByteArray(), QByteArray("shorter"));
+    QCOMPARE(map.constFindEntry(group1, "Ke"), map.cend());
+    QCOMPARE(map.constFindEntry(group1, "K", SearchLocalized | SearchDefaults), map.cend());
+    QCOMPARE(map.constFindEntry(group1, "Key3", SearchLocalized), map.cend());
+}
+
+void KEntryMapTest::testEscaped()
+{
+    const QByteArray escaped("\\sa\\x41\\n");
+    const QByteArray decoded(" aA\n");
+    KEntryMap map;
+
+    map.setEntry(group1, key1, escaped, EntryEscaped);
+    map.setEntry(group1, key2, escaped, EntryEscaped);
+    QVERIFY(map.constFindEntry(group1, key1)->bEscaped);
+
+    // setting the decoded value doesn't change the entry
+    QCOMPARE(map.setEntry(group1, key2, decoded, EntryOptions()), false);
+
+    QCOMPARE(map.getEntry(group1, key1), QString::fromLatin1(decoded));
+    // decoded once, the result is kept
+    QVERIFY(!map.constFindEntry(group1, key1)->bEscaped);
+    QCOMPARE(map.constFindEntry(group1, key1)->toByteArray(), decoded);
+}
+
+void KEntryMapTest::testMerge()
+{
+    const QByteArray group2("Another Group");
+    const QByteArray translated("bonjour");
+
+    // what the parser produces for a defaults file followed by the local file
+    const auto parseDefaults = [&](KEntryMap &map) {
+        map.setEntry(group1, key1, value1, EntryDefault);
+        map.setEntry(group1, key1, translated, EntryDefault | EntryLocalized);
+        map.setEntry(group2, key1, value1, EntryDefault | EntryImmutable);
+        map.setEntry(group2, QByteArray(), QByteArray(), EntryImmutable);
+    };
+    const auto parseLocal = [&](KEntryMap &map) {
+        map.setEntry(group1, key1, value2, EntryOptions());
+        map.setEntry(group1, key2, value2, EntryOptions());
+        map.setEntry(group2, key1, value2, EntryOptions());
+    };
+
+    KEntryMap sequential;
+    parseDefaults(sequential);
+    parseLocal(sequential);
+
+    KEntryMap defaults;
+    parseDefaults(defaults);
+    KEntryMap local;
+    parseLocal(local);
+    KEntryMap merged;
+    merged.merge(defaults);
+    merged.merge(local);
+
+    QCOMPARE(merged.size(), sequential.size());
+    for (auto it = sequential.cbegin(); it != sequential.cend(); ++it) {
+        QVERIFY(merged.contains(it.key()));
+        QVERIFY(merged.value(it.key()) == it.value());
+    }
+    // the immutable group kept its default value
+    QCOMPARE(merged.getEntry(group2, key1), QString::fromLatin1(value1));
+    // the local non-localized value replaced the default translation
+    QCOMPARE(merged.constFindEntry(group1, key1, SearchLocalized)->toByteArray(), value2);
+}
+
+void KEntryMapTest::testIteration()
+{
+    const QByteArray group2("A Group\x1dSub");
+    const QByteArray group3("B Group");
+    KEntryMap map;
+
+    // inserted out of order, iterated in the order of KEntryKey
+    map.setEntry(group3, key1, value1, EntryOptions());
+    map.setEntry(group1, key2, value2, EntryOptions());
+    map.setEntry(group2, key1, value1, EntryOptions());
+    map.setEntry(group1, key1, value1, EntryDefault);
+    map.setEntry(group1, key1, value2, EntryOptions()); // the default gets an entry of its own
+    map.setEntry(group1, key1, value2, EntryLocalized);
+    QCOMPARE(map.size(), 9);
+
+    const QList<KEntryKey> expected = {
+        KEntryKey(group1),
+        KEntryKey(group1, key1, true, false),
+        KEntryKey(group1, key1, false, false),
+        KEntryKey(group1, key1, false, true),
+        KEntryKey(group1, key2),
+        KEntryKey(group2),
+        KEntryKey(group2, key1),
+        KEntryKey(group3),
+        KEntryKey(group3, key1),
+    };
+    auto it = map.cbegin();
+    for (const KEntryKey &key : expected) {
+        QVERIFY(it != map.cend());
+        QVERIFY(!(it.key() < key) && !(key < it.key()));
+        ++it;
+    }
+    QCOMPARE(it, map.cend());
+
+    // the group and its subgroups
+    int count = 0;
+    map.forEachEntryWhoseGroupStartsWith(group1, [&count](KEntryMapConstIterator) {
+        ++count;
+    });
+    QCOMPARE(count, 7);
+    count = 0;
+    map.forEachEntryInGroupTree(group1, [&count](KEntryMapConstIterator) {
+        ++count;
+    });
+    QCOMPARE(count, 7);
+    // a group whose name merely starts with the one of the tree isn't part of it
+    map.setEntry("A GroupOther", key1, value1, EntryOptions());
+    count = 0;
+    map.forEachEntryInGroupTree(group1, [&count](KEntryMapConstIterator) {
+        ++count;
+    });
+    QCOMPARE(count, 7);
+    QCOMPARE(map.groupAndSubGroupNames(group1), QByteArrayList({group1, group2}));
+    QCOMPARE(map.groupAndSubGroupNames("A GroupOther"), QByteArrayList({"A GroupOther"}));
+    QCOMPARE(map.remove(KEntryKey("A GroupOther", key1)), 1);
+    QCOMPARE(map.remove(KEntryKey("A GroupOther")), 1);
+    QVERIFY(map.lowerBound(minimumGroupKey("A Group\x1d")).key().mGroup == group2);
+    QCOMPARE(map.lowerBound(minimumGroupKey("C Group")), map.cend());
+
+    // erasing the last entry of a group removes the group
+    QCOMPARE(map.remove(KEntryKey(group2, key1)), 1);
+    QCOMPARE(map.remove(KEntryKey(group2)), 1);
+    QCOMPARE(map.remove(KEntryKey(group2)), 0);
+    QCOMPARE(map.size(), 7);
+    QCOMPARE(map.constFindEntry(group2), map.cend());
+    auto next = map.erase(map.findEntry(group1, key2));
+    QVERIFY(next.key().mGroup == group3);
+    QVERIFY(next.key().mKey.isNull());
+}
+
+void KEntryMapTest::testSubGroups()
+{
+    KEntryMap map;
+    map.setEntry("Top", key1, value1, EntryOptions());
+    map.setEntry("Top\x1d" "Child", key1, value1, EntryOptions());
+    map.setEntry("Top\x1d" "Child\x1d" "Grandchild", key1, value1, EntryOptions());
+    map.setEntry("Top\x1d" "Child\x1d" "Other", key1, value1, EntryOptions());
+    map.setEntry("Top\x1d" "Deep\x1d" "Down", key1, value1, EntryOptions()); // "Deep" itself has no entries
+    map.setEntry("Top\x1d" "Gone", key1, QByteArray(), EntryDeleted);
+    map.setEntry("Top\x1d" "Empty", QByteArray(), QByteArray(), EntryOptions()); // only the group marker
+    map.setEntry("Topmost", key1, value1, EntryOptions());
+    map.setEntry("Zoo", key1, QByteArray(), EntryDeleted);
+
+    const auto toList = [](const QList<QByteArrayView> &views) {
+        QByteArrayList list;
+        for (QByteArrayView view : views) {
+            list.append(view.toByteArray());
+        }
+        return list;
+    };
+    QCOMPARE(toList(map.subGroupNames({})), QByteArrayList({"Top", "Topmost"}));
+    QCOMPARE(toList(map.subGroupNames("Top")), QByteArrayList({"Child", "Deep"}));
+    QCOMPARE(toList(map.subGroupNames("Top\x1d" "Child")), QByteArrayList({"Grandchild", "Other"}));
+    QVERIFY(map.subGroupNames("Top\x1d" "Gone").isEmpty());
+    QVERIFY(map.subGroupNames("Nothing").isEmpty());
+
+    // a name sorting between a group and its subgroups
+    map.setEntry("Top\x1d" "Child\x01", key1, value1, EntryOptions());
+    QCOMPARE(toList(map.subGroupNames("Top")), QByteArrayList({"Child", "Child\x01", "Deep"}));
+
+    QVERIFY(map.hasNonDeletedEntries("Top"));
+    QVERIFY(map.hasNonDeletedEntries("Top\x1d" "Deep"));
+    QVERIFY(!map.hasNonDeletedEntries("Top\x1d" "Gone"));
+    QVERIFY(!map.hasNonDeletedEntries("Top\x1d" "Empty"));
+    QVERIFY(!map.hasNonDeletedEntries("Zoo"));
+    QVERIFY(!map.hasNonDeletedEntries("To")); // "Top" is no subgroup of it
+
+    // "Deep" has no group marker, deleted groups have one
+    QCOMPARE(map.groupAndSubGroupNames("Top\x1d" "Child"),
+             QByteArrayList({"Top\x1d" "Child", "Top\x1d" "Child\x1d" "Grandchild", "Top\x1d" "Child\x1d" "Other"}));
+    QCOMPARE(map.groupAndSubGroupNames("Top\x1d" "Deep"), QByteArrayList({"Top\x1d" "Deep\x1d" "Down"}));
+    QCOMPARE(map.groupAndSubGroupNames("Top\x1d" "Gone"), QByteArrayList({"Top\x1d" "Gone"}));
+}
+
+void KEntryMapTest::testGroupEntries()
+{
+    KEntryMap map;
+    map.setEntry("Group", key1, value1, EntryDefault);
+    map.setEntry("Group", key1, value2, EntryOptions());
+    map.setEntry("Group", key2, value1, EntryLocalized);
+    map.setEntry("Group\x1d" "Child", key1, value1, EntryOptions());
+    map.setEntry("Other", key1, value1, EntryOptions());
+
+    const KEntryMap group = map.groupEntries("Group");
+    QVERIFY(!group.isEmpty());
+    QCOMPARE(group.getEntry("Group", key1), QString::fromUtf8(value2));
+    QCOMPARE(group.getEntry("Group", key1, QString(), SearchDefaults), QString::fromUtf8(value1));
+    QCOMPARE(group.getEntry("Group", key2, QString(), SearchLocalized), QString::fromUtf8(value1));
+    QVERIFY(!group.hasEntry("Group\x1d" "Child", key1));
+    QVERIFY(!group.hasEntry("Other", key1));
+    QVERIFY(map.groupEntries("Group\x1d" "Missing").isEmpty());
+
+    // a later change of the map doesn't reach the copy
+    map.setEntry("Group", key1, value1, EntryOptions());
+    QCOMPARE(group.getEntry("Group", key1), QString::fromUtf8(value2));
+    QCOMPARE(map.getEntry("Group", key1), QString::fromUtf8(value1));
+}
+
+void KEntryMapTest::testGroupHint()
+{
+    KEntryMap map;
+    map.setEntry("B", key1, value1, EntryOptions());
+    map.setEntry("D", key1, value2, EntryOptions());
+
+    KEntryMap::GroupHint hint;
+    QCOMPARE(map.constFindEntry("D", &hint, key1, SearchFlags())->value().toByteArray(), value2);
+    // the hint found the group, even though the name isn't compared anymore
+    QCOMPARE(map.constFindEntry("D", &hint, key1, SearchFlags())->value().toByteArray(), value2);
+    QCOMPARE(map.getEntry("D", key1, QString(), SearchFlags(), nullptr, &hint), QString::fromUtf8(value2));
+
+    // a copy has the same groups
+    const KEntryMap copy = map;
+    QCOMPARE(copy.constFindEntry("D", &hint, key1, SearchFlags())->value().toByteArray(), value2);
+
+    // adding a group in front moves "D"
+    map.setEntry("A", key1, value1, EntryOptions());
+    QCOMPARE(map.constFindEntry("D", &hint, key1, SearchFlags())->value().toByteArray(), value2);
+    map.remove(KEntryKey("A", key1));
+    QCOMPARE(map.constFindEntry("D", &hint, key1, SearchFlags())->value().toByteArray(), value2);
+
+    // a missing group is remembered as well
+    KEntryMap::GroupHint missing;
+    QVERIFY(map.constFindEntry("C", &missing, key1, SearchFlags()) == map.constEnd());
+    QVERIFY(map.constFindEntry("C", &missing, key1, SearchFlags()) == map.constEnd());
+    map.setEntry("C", key1, value1, EntryOptions());
+    QCOMPARE(map.constFindEntry("C", &missing, key1, SearchFlags())->value().toByteArray(), value1);
+
+    KEntryMap moved = std::move(map);
+    QCOMPARE(moved.constFindEntry("D", &hint, key1, SearchFlags())->value().toByteArray(), value2);
+    map.clear();
+    QVERIFY(map.constFindEntry("D", &hint, key1, SearchFlags()) == map.constEnd());
+}
+
+void KEntryMapTest::testReplaceGroup()
+{
+    KEntryMap map;
+    map.setEntry("Group", key1, value1, EntryOptions());
+    map.setEntry("Group", key2, value1, EntryOptions());
+    map.setEntry("Group\x1d" "Child", key1, value1, EntryOptions());
+    map.setEntry("Gone", key1, value1, EntryOptions());
+
+    KEntryMap source;
+    source.setEntry("Group", key1, value2, EntryOptions());
+    source.setEntry("New", key1, value2, EntryOptions());
+    source.setEntry("Other", key1, value2, EntryOptions());
+
+    map.replaceGroup("Group", source);
+    map.replaceGroup("New", source);
+    map.replaceGroup("Gone", source);
+    QCOMPARE(map.getEntry("Group", key1), QString::fromUtf8(value2));
+    QVERIFY(!map.hasEntry("Group", key2));
+    QCOMPARE(map.getEntry("Group\x1d" "Child", key1), QString::fromUtf8(value1));
+    QCOMPARE(map.getEntry("New", key1), QString::fromUtf8(value2));
+    QVERIFY(!map.hasEntry("Gone", key1));
+    QVERIFY(!map.hasEntry("Other", key1));
+    QCOMPARE(map.size(), source.groupEntries("Group").size() + source.groupEntries("New").size() + map.groupEntries("Group\x1d" "Child").size());
+
+    // the entries are shared, not linked
+    map.setEntry("Group", key1, value1, EntryOptions());
+    QCOMPARE(source.getEntry("Group", key1), QString::fromUtf8(value2));
+}
+
+void KEntryMapTest::testHasSameGroup()
+{
+    KEntryMap map;
+    map.setEntry("Group", key1, value1, EntryDefault);
+    map.setEntry("Group", key1, value2, EntryOptions());
+    map.setEntry("Other", key1, value1, EntryOptions());
+
+    KEntryMap copy = map;
+    QVERIFY(copy.hasSameGroup("Group", map));
+    QVERIFY(copy.hasSameGroup("Missing", map));
+
+    // the same entries, parsed again
+    KEntryMap reparsed;
+    reparsed.setEntry("Group", key1, value1, EntryDefault);
+    reparsed.setEntry("Group", key1, value2, EntryOptions());
+    QVERIFY(reparsed.hasSameGroup("Group", map));
+    QVERIFY(!reparsed.hasSameGroup("Other", map));
+
+    copy.setEntry("Group", key1, value1, EntryOptions());
+    QVERIFY(!copy.hasSameGroup("Group", map));
+    QVERIFY(copy.hasSameGroup("Other", map));
+    reparsed.setEntry("Group", key1, value2, EntryImmutable);
+    QVERIFY(!reparsed.hasSameGroup("Group", map));
+}
+
+void KEntryMapTest::testSetEntries()
+{
+    const auto prepare = [](KEntryMap &map) {
+        map.setEntry(group1, "b", "old", EntryOptions());
+        map.setEntry(group1, "d", "default", EntryDefault);
+        map.setEntry(group1, "f", "fixed", EntryImmutable);
+        map.setEntry(group1, "h", "hallo", EntryLocalized);
+        map.setEntry("Locked", QByteArray(), QByteArray(), EntryImmutable);
+    };
+    const std::vector<KEntryMap::EntryWrite> writes = {
+        {"z", "last", EntryDirty},
+        {"b", "new", EntryDirty},
+        {"a", "first", EntryDirty},
+        {"d", "override", EntryDirty},
+        {"f", "changed", EntryDirty},
+        {"h", "hello", EntryDirty},
+        {"a", "again", EntryDirty}, // written twice, the last one wins
+        {"c", "c", EntryOptions(EntryDirty | EntryLocalized)},
+        {"c", "plain", EntryDirty}, // new, and removes the localized entry written before
+        {"gone", QByteArray(), EntryOptions(EntryDirty | EntryDeleted)},
+    };
+
+    KEntryMap oneByOne;
+    prepare(oneByOne);
+    for (const KEntryMap::EntryWrite &write : writes) {
+        oneByOne.setEntry(group1, write.key, write.value, write.options);
+    }
+
+    KEntryMap batched;
+    prepare(batched);
+    QVERIFY(batched.setEntries(group1, writes));
+
+    QCOMPARE(batched.size(), oneByOne.size());
+    for (auto it = batched.cbegin(), other = oneByOne.cbegin(); it != batched.cend(); ++it, ++other) {
+        QVERIFY(!(it.key() < other.key()) && !(other.key() < it.key()));
+        QVERIFY(it.value() == other.value());
+        QCOMPARE(it->bDirty, other->bDirty);
+        QCOMPARE(it->bSharesDefault, other->bSharesDefault);
+    }
+    QCOMPARE(batched.findEntry(group1, "a")->toByteArray(), QByteArray("again"));
+    QCOMPARE(batched.findEntry(group1, "f")->toByteArray(), QByteArray("fixed"));
+    QVERIFY(batched.findEntry(group1, "gone")->bDeleted);
+
+    // nothing changes in an immutable group
+    QVERIFY(!batched.setEntries("Locked", {{"key", "value", EntryDirty}}));
+    QCOMPARE(batched.findEntry("Locked", "key"), batched.end());
+
+    // the group marker gets added for a new group
+    QVERIFY(batched.setEntries("New", {{"key", "value", EntryDirty}}));
+    QVERIFY(batched.hasEntry("New"));
+    QCOMPARE(batched.findEntry("New", "key")->toByteArray(), QByteArray("value"));
+    QVERIFY(!batched.setEntries("New", {{"key", "value", EntryOptions()}}));
+}
+
+void KEntryMapTest::testInlineValues()
+{
+    const QByteArray shortValue(KEntryValue::InlineCapacity, 'a');
+    const QByteArray longValue(KEntryValue::InlineCapacity + 1, 'b');
+    KEntryMap map;
+
+    map.setEntry(group1, key1, shortValue, EntryOptions());
+    map.setEntry(group1, key2, longValue, EntryOptions());
+    QVERIFY(map.constFindEntry(group1, key1)->isInline());
+    QVERIFY(!map.constFindEntry(group1, key2)->isInline());
+    QCOMPARE(map.constFindEntry(group1, key1)->toByteArray(), shortValue);
+    QCOMPARE(map.constFindEntry(group1, key2)->toByteArray(), longValue);
+
+    // null and empty stay apart
+    map.setEntry(group1, key1, QByteArray(""), EntryOptions());
+    QVERIFY(!map.constFindEntry(group1, key1)->isNull());
+    QVERIFY(map.constFindEntry(group1, key1)->toByteArray().isEmpty());
+    map.setEntry(group1, key1, QByteArray(), EntryDeleted);
+    QVERIFY(map.constFindEntry(group1, key1)->isNull());
+
+    // switching between inline and heap storage
+    map.setEntry(group1, key2, shortValue, EntryOptions());
+    QVERIFY(map.constFindEntry(group1, key2)->isInline());
+    map.setEntry(group1, key2, longValue, EntryOptions());
+    QCOMPARE(map.constFindEntry(group1, key2)->toByteArray(), longValue);
+
+    // escaped inline values are decoded in place
+    map.setEntry(group1, key1, QByteArrayLiteral("\\sa\\tb"), EntryEscaped);
+    QVERIFY(map.constFindEntry(group1, key1)->isInline());
+    QCOMPARE(map.constFindEntry(group1, key1)->value(), QByteArrayView(" a\tb"));
+}
+
+void KEntryMapTest::testKdeglobalsInlineValues()
+{
+    QFile file(QFINDTESTDATA("kdeglobals.sample"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QList<QByteArray> lines = file.readAll().split('\n');
+
+    // fill the map the way the system wide defaults are loaded
+    KEntryMap map;
+    QByteArray group("<default>");
+    for (const QByteArray &line : lines) {
+        if (line.startsWith('[')) {
+            group = line.mid(1, line.size() - 2).replace("][", "\x1d");
+        } else if (const auto eq = line.indexOf('='); eq > 0) {
+            map.setEntry(group, line.left(eq), line.mid(eq + 1), EntryDefault);
+        }
+    }
+
+    // most values of a real kdeglobals are short enough to need no allocation
+    qsizetype inlineValues = 0;
+    qsizetype heapValues = 0;
+    for (auto it = map.cbegin(); it != map.cend(); ++it) {
+        if (it->isNull()) {
+            continue;
+        }
+        if (it->isInline()) {
+            ++inlineValues;
+        } else {
+            ++heapValues;
+        }
+    }
+    QVERIFY(inlineValues > heapValues);
 }
@@ -30,15 +30,35 @@ public:
     static const EntryOption EntryExpansion = KEntryMap::EntryExpansion;
     static const EntryOption EntryDefault = KEntryMap::EntryDefault;
     static const EntryOption EntryLocalized = KEntryMap::EntryLocalized;
+    static const EntryOption EntryEscaped = KEntryMap::EntryEscaped;
 private Q_SLOTS:
     void testKeyOrder();
     void testSimple();
     void testDirty();
+    void testDirtyGroups();
+    void testDirtyRange();
+    void testTakeDirtyEntries();
+    void testMarkAllDirty();
+    void testRemoveKeys();
     void testDefault();
+    void testSharedDefault();
     void testDelete();
     void testGlobal();
     void testImmutable();
+    void testMayHaveImmutableEntries();
     void testLocale();
+    void testLocalizedNeighbours();
+    void testEscaped();
+    void testMerge();
+    void testIteration();
+    void testSubGroups();
+    void testGroupEntries();
+    void testGroupHint();
+    void testReplaceGroup();
+    void testHasSameGroup();
+    void testSetEntries();
+    void testInlineValues();
+    void testKdeglobalsInlineValues();
 };
 
 #endif // KENTRYMAPTEST_H
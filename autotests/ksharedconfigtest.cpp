@@ -9,12 +9,19 @@
 #include <kconfiggroup.h>
 #include <ksharedconfig.h>
 
+#include <algorithm>
+#include <cstring>
+
 class KSharedConfigTest : public QObject
 {
     Q_OBJECT
 private Q_SLOTS:
     void initTestCase();
     void testUnicity();
+    void testManyConfigs();
+    void testPrefetch();
+    void testOpenConfigAsync();
+    void testMemoryReport();
     void testReadWrite();
     void testReadWriteSync();
     void testQrcFile();
@@ -39,6 +46,101 @@ void KSharedConfigTest::testUnicity()
     QCOMPARE(cfg1.data(), cfg2.data());
 }
 
+void KSharedConfigTest::testManyConfigs()
+{
+    QList<KSharedConfig::Ptr> configs;
+    for (int i = 0; i < 200; ++i) {
+        configs.append(KSharedConfig::openConfig(KConfig::ConfigAssociation::NoAssociation, QStringLiteral("ksharedconfigtest%1").arg(i), KConfig::SimpleConfig));
+    }
+    for (int i = 0; i < 200; ++i) {
+        QCOMPARE(KSharedConfig::openConfig(KConfig::ConfigAssociation::NoAssociation, QStringLiteral("ksharedconfigtest%1").arg(i), KConfig::SimpleConfig).data(), configs.at(i).data());
+    }
+
+    // the flags and the location tell the configs apart
+    const KSharedConfig::Ptr noGlobals = KSharedConfig::openConfig(KConfig::ConfigAssociation::NoAssociation, QStringLiteral("ksharedconfigtest0"), KConfig::NoGlobals);
+    QVERIFY(noGlobals.data() != configs.constFirst().data());
+    const KSharedConfig::Ptr appData = KSharedConfig::openConfig(KConfig::ConfigAssociation::NoAssociation, QStringLiteral("ksharedconfigtest0"), KConfig::SimpleConfig, QStandardPaths::AppDataLocation);
+    QVERIFY(appData.data() != configs.constFirst().data());
+    QCOMPARE(appData->locationType(), QStandardPaths::AppDataLocation);
+
+    // the shared configs don't keep the configs alive
+    const QString name = configs.constFirst()->name();
+    configs.clear();
+    const KSharedConfig::Ptr reopened = KSharedConfig::openConfig(KConfig::ConfigAssociation::NoAssociation, QStringLiteral("ksharedconfigtest0"), KConfig::SimpleConfig);
+    QCOMPARE(reopened->ref.loadRelaxed(), 1);
+    QCOMPARE(reopened->name(), name);
+}
+
+void KSharedConfigTest::testPrefetch()
+{
+    const QString fileName = QStringLiteral("ksharedconfigprefetchtest");
+    {
+        KConfig config(KConfig::ConfigAssociation::NoAssociation, fileName, KConfig::SimpleConfig);
+        config.group(QStringLiteral("Prefetch")).writeEntry("Key", "value");
+        QVERIFY(config.sync());
+    }
+
+    KSharedConfig::prefetch(KConfig::ConfigAssociation::NoAssociation, {fileName}, KConfig::SimpleConfig);
+    const KSharedConfig::Ptr config = KSharedConfig::openConfig(KConfig::ConfigAssociation::NoAssociation, fileName, KConfig::SimpleConfig);
+    QCOMPARE(config->ref.loadRelaxed(), 1);
+    QCOMPARE(config->name(), fileName);
+    QCOMPARE(config->group(QStringLiteral("Prefetch")).readEntry("Key"), QStringLiteral("value"));
+    // it is shared like any other config
+    QCOMPARE(KSharedConfig::openConfig(KConfig::ConfigAssociation::NoAssociation, fileName, KConfig::SimpleConfig).data(), config.data());
+
+    // an open config isn't parsed again
+    KSharedConfig::prefetch(KConfig::ConfigAssociation::NoAssociation, {fileName}, KConfig::SimpleConfig);
+    QCOMPARE(KSharedConfig::openConfig(KConfig::ConfigAssociation::NoAssociation, fileName, KConfig::SimpleConfig).data(), config.data());
+}
+
+void KSharedConfigTest::testOpenConfigAsync()
+{
+    const QString fileName = QStringLiteral("ksharedconfigasynctest");
+    {
+        KConfig config(KConfig::ConfigAssociation::NoAssociation, fileName, KConfig::SimpleConfig);
+        config.group(QStringLiteral("Async")).writeEntry("Key", "value");
+        QVERIFY(config.sync());
+    }
+
+    QFuture<KSharedConfig::Ptr> future = KSharedConfig::openConfigAsync(KConfig::ConfigAssociation::NoAssociation, fileName, KConfig::SimpleConfig);
+    // the same parse is handed out until the config is opened
+    QFuture<KSharedConfig::Ptr> again = KSharedConfig::openConfigAsync(KConfig::ConfigAssociation::NoAssociation, fileName, KConfig::SimpleConfig);
+    const KSharedConfig::Ptr config = KSharedConfig::openConfig(KConfig::ConfigAssociation::NoAssociation, fileName, KConfig::SimpleConfig);
+    QCOMPARE(future.result().data(), config.data());
+    QCOMPARE(again.result().data(), config.data());
+    QCOMPARE(config->group(QStringLiteral("Async")).readEntry("Key"), QStringLiteral("value"));
+
+    // an open config is there right away
+    future = KSharedConfig::openConfigAsync(KConfig::ConfigAssociation::NoAssociation, fileName, KConfig::SimpleConfig);
+    QVERIFY(future.isFinished());
+    QCOMPARE(future.result().data(), config.data());
+}
+
+void KSharedConfigTest::testMemoryReport()
+{
+    const QString fileName = QStringLiteral("ksharedconfigmemorytest");
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(KConfig::ConfigAssociation::NoAssociation, fileName, KConfig::SimpleConfig);
+    KConfigGroup group(config, QStringLiteral("Group"));
+    group.writeEntry("Key", QStringLiteral("value"));
+    group.writeEntry("Long", QString(100, QLatin1Char('x')));
+
+    const KConfig::MemoryUsage usage = config->memoryUsage();
+    QCOMPARE(usage.name, config->name());
+    QCOMPARE(usage.groups, qsizetype(1));
+    QVERIFY(usage.entries >= 2); // and maybe the group marker
+    QCOMPARE(usage.keyBytes, qint64(strlen("Group") + strlen("Key") + strlen("Long")));
+    QCOMPARE(usage.valueBytes, qint64(strlen("value") + 100));
+    QVERIFY(usage.structureBytes > 0);
+
+    const KSharedConfig::MemoryReport report = KSharedConfig::memoryReport();
+    const auto it = std::find_if(report.configs.cbegin(), report.configs.cend(), [&config](const KConfig::MemoryUsage &usage) {
+        return usage.name == config->name();
+    });
+    QVERIFY(it != report.configs.cend());
+    QCOMPARE(it->entries, usage.entries);
+    QVERIFY(report.globalParseCacheBytes <= report.globalParseCacheBudget);
+}
+
 void KSharedConfigTest::testReadWrite()
 {
     const int value = 1;
@@ -51,6 +51,9 @@ void KStandardShortcutTest::testFindStdAccel()
 {
     QCOMPARE(KStandardShortcut::find(QKeySequence(Qt::CTRL | Qt::Key_F)), KStandardShortcut::Find);
     QCOMPARE(KStandardShortcut::find(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::ALT | Qt::Key_G)), KStandardShortcut::AccelNone);
+    // Shared by Cut and Delete, the first one of the table wins
+    QCOMPARE(KStandardShortcut::find(QKeySequence(Qt::SHIFT | Qt::Key_Delete)), KStandardShortcut::Cut);
+    QCOMPARE(KStandardShortcut::find(QKeySequence()), KStandardShortcut::AccelNone);
 }
 
 void KStandardShortcutTest::testFindByName()
@@ -59,4 +62,6 @@ void KStandardShortcutTest::testFindByName()
         const auto id = static_cast<KStandardShortcut::StandardShortcut>(i);
         QCOMPARE(id, KStandardShortcut::findByName(KStandardShortcut::name(id)));
     }
+    QCOMPARE(KStandardShortcut::findByName(QStringLiteral("NoSuchShortcut")), KStandardShortcut::AccelNone);
+    QCOMPARE(KStandardShortcut::findByName(QString()), KStandardShortcut::AccelNone);
 }
@@ -21,11 +21,13 @@ private Q_SLOTS:
     void init();
     void testSignal();
     void testDataUpdated();
+    void testSaveShortcuts();
 };
 
 Q_DECLARE_METATYPE(KStandardShortcut::StandardShortcut)
 
 const QList<QKeySequence> newShortcut = {Qt::CTRL | Qt::Key_Adiaeresis};
+const QList<QKeySequence> newCloseShortcut = {Qt::CTRL | Qt::Key_Odiaeresis};
 
 void KStandardShortcutWatcherTest::initTestCase()
 {
@@ -38,8 +40,10 @@ void KStandardShortcutWatcherTest::init()
 {
     KConfigGroup group(KSharedConfig::openConfig(), "Shortcuts");
     group.writeEntry("Open", QKeySequence::listToString(KStandardShortcut::hardcodedDefaultShortcut(KStandardShortcut::Open)), KConfig::Global);
+    group.writeEntry("Close", QKeySequence::listToString(KStandardShortcut::hardcodedDefaultShortcut(KStandardShortcut::Close)), KConfig::Global);
     group.sync();
     KStandardShortcut::initialize(KStandardShortcut::Open);
+    KStandardShortcut::initialize(KStandardShortcut::Close);
 }
 
 void KStandardShortcutWatcherTest::testSignal()
@@ -69,5 +73,26 @@ void KStandardShortcutWatcherTest::testDataUpdated()
     QCOMPARE(KStandardShortcut::open(), newShortcut);
 }
 
+void KStandardShortcutWatcherTest::testSaveShortcuts()
+{
+#ifdef Q_OS_WIN
+    QSKIP("KConfig is built without DBus on Windows");
+#endif
+    QSignalSpy signalSpy(KStandardShortcut::shortcutWatcher(), &KStandardShortcut::StandardShortcutWatcher::shortcutChanged);
+    KStandardShortcut::saveShortcuts({{KStandardShortcut::Open, newShortcut}, {KStandardShortcut::Close, newCloseShortcut}});
+    QCOMPARE(KStandardShortcut::open(), newShortcut);
+    QCOMPARE(KStandardShortcut::find(newCloseShortcut.first()), KStandardShortcut::Close);
+    QTRY_COMPARE(signalSpy.count(), 2);
+    QList<KStandardShortcut::StandardShortcut> changed;
+    for (const QList<QVariant> &arguments : std::as_const(signalSpy)) {
+        changed.append(arguments[0].value<KStandardShortcut::StandardShortcut>());
+    }
+    std::sort(changed.begin(), changed.end());
+    QCOMPARE(changed, QList({KStandardShortcut::Open, KStandardShortcut::Close}));
+
+    KConfigGroup group(KSharedConfig::openConfig(), "Shortcuts");
+    QCOMPARE(group.readEntry("Close"), QKeySequence::listToString(newCloseShortcut));
+}
+
 QTEST_MAIN(KStandardShortcutWatcherTest)
 #include "kstandardshortcutwatchertest.moc"
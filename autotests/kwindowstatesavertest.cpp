@@ -5,11 +5,13 @@
 
 #include "kwindowstatesaver.h"
 #include "kconfiggroup.h"
+#include "kwindowconfig.h"
 #include "ksharedconfig.h"
 
 #include <QSignalSpy>
 #include <QStandardPaths>
 #include <QTest>
+#include <QWindow>
 
 #include <QFontDialog>
 
@@ -20,6 +22,7 @@ private Q_SLOTS:
     void initTestCase();
     void testTopLevelDialog();
     void testSubDialog();
+    void testRestoreWindowGeometry();
 };
 
 void KWindowStateSaverTest::initTestCase()
@@ -86,5 +89,34 @@ void KWindowStateSaverTest::testSubDialog()
     }
 }
 
+void KWindowStateSaverTest::testRestoreWindowGeometry()
+{
+    auto cfg = KSharedConfig::openStateConfig();
+    cfg->deleteGroup("restoreWindowGeometryTest");
+    KConfigGroup group = cfg->group(QStringLiteral("restoreWindowGeometryTest"));
+
+    QWindow saved;
+    saved.resize(640, 480);
+    KWindowConfig::saveWindowSize(&saved, group);
+    group.writeEntry("Unrelated", 1);
+
+    QWindow restored;
+    restored.resize(100, 100);
+    KWindowConfig::restoreWindowGeometry(&restored, group);
+    QCOMPARE(restored.size(), QSize(640, 480));
+    QVERIFY(!(restored.windowState() & Qt::WindowMaximized));
+
+    // the same as restoring the size on its own
+    QWindow single;
+    KWindowConfig::restoreWindowSize(&single, group);
+    QCOMPARE(single.size(), restored.size());
+
+    // and a group without geometry leaves the window as it is
+    QWindow untouched;
+    untouched.resize(300, 200);
+    KWindowConfig::restoreWindowGeometry(&untouched, cfg->group(QStringLiteral("restoreWindowGeometryEmpty")));
+    QCOMPARE(untouched.size(), QSize(300, 200));
+}
+
 QTEST_MAIN(KWindowStateSaverTest)
 #include "kwindowstatesavertest.moc"
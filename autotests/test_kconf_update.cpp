@@ -18,6 +18,9 @@
 
 #include <qtest.h>
 
+#include <kconfig.h>
+#include <kconfiggroup.h>
+
 QTEST_GUILESS_MAIN(TestKConfUpdate)
 
 void TestKConfUpdate::initTestCase()
@@ -485,3 +488,42 @@ void TestKConfUpdate::testScript()
     expectedNewConfContent = expectedNewConfContent.arg(updateInfo);
     QCOMPARE(newConfContent, expectedNewConfContent);
 }
+
+void TestKConfUpdate::testCheckUpdate()
+{
+    const QString updDir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QLatin1String{"/kconf_update"};
+    QVERIFY(QDir().mkpath(updDir));
+    writeFile(updDir + QLatin1String{"/checkupdate.upd"},
+              QStringLiteral("Version=5\n"
+                             "Id=rename\n"
+                             "File=checkupdaterc\n"
+                             "Group=group\n"
+                             "Key=old,new\n"));
+
+    const QString configDir = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation);
+    QVERIFY(QDir().mkpath(configDir));
+    const QString configPath = configDir + QLatin1String{"/checkupdaterc"};
+    writeFile(configPath, QStringLiteral("[group]\nold=value\n"));
+
+    // applied to the config itself, which kconf_update would have opened the same way
+    KConfig config(QStringLiteral("checkupdaterc"), KConfig::NoGlobals);
+    config.checkUpdate(QStringLiteral("rename"), QStringLiteral("checkupdate.upd"));
+    KConfigGroup group = config.group(QStringLiteral("group"));
+    QCOMPARE(group.readEntry("new", QString()), QStringLiteral("value"));
+    QVERIFY(!group.hasKey("old"));
+    QCOMPARE(config.group(QStringLiteral("$Version")).readEntry("update_info", QStringList()), QStringList{QStringLiteral("checkupdate.upd:rename")});
+    QVERIFY(!config.isDirty());
+    QCOMPARE(readFile(configPath),
+             QStringLiteral("[$Version]\n"
+                            "update_info=checkupdate.upd:rename\n"
+                            "\n"
+                            "[group]\n"
+                            "new=value\n"));
+
+    // with the globals, the file is updated on its own and read again
+    writeFile(configPath, QStringLiteral("[group]\nold=other\n"));
+    KConfig globalConfig(QStringLiteral("checkupdaterc"));
+    globalConfig.checkUpdate(QStringLiteral("rename"), QStringLiteral("checkupdate.upd"));
+    QCOMPARE(globalConfig.group(QStringLiteral("group")).readEntry("new", QString()), QStringLiteral("other"));
+    QVERIFY(!globalConfig.group(QStringLiteral("group")).hasKey("old"));
+}
@@ -18,6 +18,7 @@ private Q_SLOTS:
     void test();
     void testScript_data();
     void testScript();
+    void testCheckUpdate();
 };
 
 #endif /* TEST_KCONF_UPDATE_H */
@@ -10,7 +10,7 @@
 #include <qtest.h>
 
 // Local
-#include "kconfigutils.h"
+#include "kconfigutils_p.h"
 
 QTEST_GUILESS_MAIN(TestKConfigUtils)
 
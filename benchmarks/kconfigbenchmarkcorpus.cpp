@@ -0,0 +1,247 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kconfigbenchmarkcorpus.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+
+#include <iterator>
+
+namespace
+{
+// some words to make up values with, so that they don't all have the same length
+const char *const s_words[] = {"window", "desktop", "panel",  "activity", "document", "folder", "network", "display", "session", "color",
+                               "file",   "manager", "viewer", "editor",   "player",   "system", "monitor", "browser", "theme",   "launcher"};
+
+QByteArray words(QRandomGenerator &random, int count)
+{
+    QByteArray text;
+    for (int i = 0; i < count; ++i) {
+        if (i > 0) {
+            text += ' ';
+        }
+        text += s_words[random.bounded(int(std::size(s_words)))];
+    }
+    return text;
+}
+
+QByteArray color(QRandomGenerator &random)
+{
+    return QByteArray::number(random.bounded(256)) + ',' + QByteArray::number(random.bounded(256)) + ',' + QByteArray::number(random.bounded(256));
+}
+
+QByteArray entry(const QByteArray &key, const QByteArray &value)
+{
+    return key + '=' + value + '\n';
+}
+
+QByteArray localizedEntries(QRandomGenerator &random, const QByteArray &key, const QByteArray &value, int wordCount)
+{
+    QByteArray text = entry(key, value);
+    for (const QString &locale : KConfigBenchmarkCorpus::locales()) {
+        text += entry(key + '[' + locale.toLatin1() + ']', words(random, wordCount));
+    }
+    return text;
+}
+
+QByteArray appletGroups(QRandomGenerator &random, const QByteArray &prefix, int applet)
+{
+    static const char *const plugins[] = {"org.kde.plasma.kickoff",
+                                          "org.kde.plasma.icontasks",
+                                          "org.kde.plasma.systemtray",
+                                          "org.kde.plasma.digitalclock",
+                                          "org.kde.plasma.pager",
+                                          "org.kde.plasma.folder",
+                                          "org.kde.plasma.notes",
+                                          "org.kde.plasma.systemmonitor.cpu"};
+    const QByteArray group = prefix + "[Applets][" + QByteArray::number(applet) + ']';
+    QByteArray text;
+    text += '\n' + group + '\n';
+    text += entry("immutability", "1");
+    text += entry("plugin", plugins[random.bounded(int(std::size(plugins)))]);
+    text += '\n' + group + "[Configuration]\n";
+    text += entry("PreloadWeight", QByteArray::number(random.bounded(100)));
+    text += entry("popupHeight", QByteArray::number(400 + random.bounded(200)));
+    text += entry("popupWidth", QByteArray::number(500 + random.bounded(200)));
+    text += '\n' + group + "[Configuration][Appearance]\n";
+    text += entry("showSeconds", random.bounded(2) ? "true" : "false");
+    text += entry("fontWeight", QByteArray::number(400 + 100 * random.bounded(4)));
+    text += '\n' + group + "[Configuration][ConfigDialog]\n";
+    text += entry("DialogHeight", QByteArray::number(480 + random.bounded(300)));
+    text += entry("DialogWidth", QByteArray::number(640 + random.bounded(300)));
+    text += '\n' + group + "[Configuration][General]\n";
+    text += entry("favoritesPortedToKAstats", "true");
+    text += entry("launchers", "applications:org.kde." + words(random, 1) + ".desktop,applications:org.kde." + words(random, 1) + ".desktop");
+    text += entry("showOnlyCurrentDesktop", random.bounded(2) ? "true" : "false");
+    return text;
+}
+}
+
+QByteArray KConfigBenchmarkCorpus::kdeglobals()
+{
+    QRandomGenerator random(1);
+    QByteArray text;
+
+    text += "[ColorEffects:Disabled]\n";
+    text += entry("Color", color(random));
+    text += entry("ColorAmount", "0");
+    text += entry("ContrastAmount", "0.65");
+    text += entry("IntensityAmount", "0.1");
+
+    static const char *const colorSets[] = {"Button", "Complementary", "Header", "Header][Inactive", "Selection", "Tooltip", "View", "Window"};
+    static const char *const colorRoles[] = {"BackgroundAlternate",
+                                             "BackgroundNormal",
+                                             "DecorationFocus",
+                                             "DecorationHover",
+                                             "ForegroundActive",
+                                             "ForegroundInactive",
+                                             "ForegroundLink",
+                                             "ForegroundNegative",
+                                             "ForegroundNeutral",
+                                             "ForegroundNormal",
+                                             "ForegroundPositive",
+                                             "ForegroundVisited"};
+    for (const char *set : colorSets) {
+        text += QByteArray("\n[Colors:") + set + "]\n";
+        for (const char *role : colorRoles) {
+            text += entry(role, color(random));
+        }
+    }
+
+    text += "\n[General]\n";
+    text += entry("AccentColor", color(random));
+    text += entry("ColorScheme", "BreezeDark");
+    text += entry("TerminalApplication", "konsole");
+    text += entry("XftHintStyle", "hintslight");
+    text += entry("fixed", "Hack,10,-1,5,400,0,0,0,0,0,0,0,0,0,0,1");
+    text += entry("font", "Noto Sans,10,-1,5,400,0,0,0,0,0,0,0,0,0,0,1");
+    text += entry("menuFont", "Noto Sans,10,-1,5,400,0,0,0,0,0,0,0,0,0,0,1");
+    text += entry("smallestReadableFont", "Noto Sans,8,-1,5,400,0,0,0,0,0,0,0,0,0,0,1");
+    text += entry("toolBarFont", "Noto Sans,10,-1,5,400,0,0,0,0,0,0,0,0,0,0,1");
+
+    text += "\n[Icons]\n";
+    text += entry("Theme", "breeze-dark");
+
+    text += "\n[KDE]\n";
+    text += entry("AnimationDurationFactor", "0.5");
+    text += entry("LookAndFeelPackage", "org.kde.breezedark.desktop");
+    text += entry("SingleClick", "false");
+    text += entry("widgetStyle", "Breeze");
+
+    text += "\n[KFileDialog Settings]\n";
+    text += entry("Recent Files[$e]", "$HOME/Documents/" + words(random, 1) + ".odt,$HOME/Pictures/" + words(random, 1) + ".png");
+    text += entry("Recent URLs[$e]", "file:$HOME/Documents/,file:$HOME/Downloads/,file:$HOME/Pictures/");
+    text += entry("Show hidden files", "false");
+    text += entry("Sort by", "Date");
+    text += entry("View Style", "DetailTree");
+
+    // the global shortcuts of a few applications that were configured once
+    text += "\n[Shortcuts]\n";
+    for (int i = 0; i < 400; ++i) {
+        const QByteArray key = "Ctrl+" + QByteArray(1, char('A' + random.bounded(26))) + (random.bounded(2) ? "; Alt+F" + QByteArray::number(1 + random.bounded(12)) : "");
+        text += entry(words(random, 2).replace(' ', '_') + '_' + QByteArray::number(i), key);
+    }
+
+    text += "\n[WM]\n";
+    for (const char *role : {"activeBackground", "activeBlend", "activeForeground", "inactiveBackground", "inactiveBlend", "inactiveForeground"}) {
+        text += entry(role, color(random));
+    }
+    text += entry("activeFont", "Noto Sans,10,-1,5,700,0,0,0,0,0,0,0,0,0,0,1");
+    return text;
+}
+
+QByteArray KConfigBenchmarkCorpus::appletsrc(int containments, int applets)
+{
+    QRandomGenerator random(2);
+    QByteArray text;
+    text += "[ActionPlugins][0]\n";
+    text += entry("MiddleButton;NoModifier", "org.kde.paste");
+    text += entry("RightButton;NoModifier", "org.kde.contextmenu");
+    for (int containment = 1; containment <= containments; ++containment) {
+        const QByteArray group = "[Containments][" + QByteArray::number(containment) + ']';
+        text += '\n' + group + '\n';
+        text += entry("activityId", QByteArray::number(random.generate64(), 16));
+        text += entry("formfactor", QByteArray::number(random.bounded(4)));
+        text += entry("immutability", "1");
+        text += entry("lastScreen", QByteArray::number(random.bounded(3)));
+        text += entry("location", QByteArray::number(random.bounded(5)));
+        text += entry("plugin", random.bounded(2) ? "org.kde.panel" : "org.kde.plasma.folder");
+        text += entry("wallpaperplugin", "org.kde.image");
+        for (int applet = 1; applet <= applets; ++applet) {
+            text += appletGroups(random, group, containment * 1000 + applet);
+        }
+        text += '\n' + group + "[General]\n";
+        QByteArray order;
+        for (int applet = 1; applet <= applets; ++applet) {
+            order += (applet > 1 ? ";" : "") + QByteArray::number(containment * 1000 + applet);
+        }
+        text += entry("AppletOrder", order);
+    }
+
+    text += "\n[ScreenMapping]\n";
+    text += entry("itemsOnDisabledScreens", "");
+    text += entry("screenMapping", "desktop:/" + words(random, 1) + ".desktop,0,");
+    return text;
+}
+
+QByteArray KConfigBenchmarkCorpus::desktopFile(int number)
+{
+    QRandomGenerator random(3 + number);
+    const QByteArray name = words(random, 2);
+    const QByteArray id = "org.kde.app" + QByteArray::number(number);
+
+    QByteArray text;
+    text += "[Desktop Entry]\n";
+    text += entry("Type", "Application");
+    text += entry("Exec", id + " %U");
+    text += entry("Icon", id);
+    text += localizedEntries(random, "Name", name, 2);
+    text += localizedEntries(random, "GenericName", words(random, 3), 3);
+    text += localizedEntries(random, "Comment", words(random, 8), 8);
+    text += localizedEntries(random, "Keywords", words(random, 5).replace(' ', ';') + ';', 5);
+    text += entry("MimeType", "text/plain;text/x-c++src;text/x-chdr;application/x-shellscript;");
+    text += entry("Categories", "Qt;KDE;Utility;TextEditor;");
+    text += entry("StartupNotify", "true");
+    text += entry("X-DBUS-ServiceName", id);
+    text += entry("Actions", "new-window;new-document;");
+    for (const char *action : {"new-window", "new-document"}) {
+        text += QByteArray("\n[Desktop Action ") + action + "]\n";
+        text += localizedEntries(random, "Name", words(random, 2), 2);
+        text += entry("Exec", id + " --" + action);
+    }
+    return text;
+}
+
+QStringList KConfigBenchmarkCorpus::locales()
+{
+    static const QStringList locales = []() {
+        QStringList list;
+        static const char *const names[] = {
+            "af", "ar", "ast", "az", "be", "bg", "bn", "br", "bs", "ca", "ca@valencia", "cs", "cy", "da", "de", "el", "en_GB", "eo", "es", "et",
+            "eu", "fa", "fi", "fr", "fy", "ga", "gl", "gu", "he", "hi", "hr", "hu", "ia", "id", "is", "it", "ja", "ka", "kk", "km", "kn", "ko", "lt",
+            "lv", "mk", "ml", "mr", "ms", "nb", "nds", "ne", "nl", "nn", "oc", "pa", "pl", "pt", "pt_BR", "ro", "ru", "si", "sk", "sl", "sq", "sr",
+            "sr@ijekavian", "sr@ijekavianlatin", "sr@latin", "sv", "ta", "te", "tg", "th", "tr", "ug", "uk", "uz", "vi", "wa", "zh_CN", "zh_TW"};
+        for (const char *locale : names) {
+            list.append(QString::fromLatin1(locale));
+        }
+        return list;
+    }();
+    return locales;
+}
+
+bool KConfigBenchmarkCorpus::writeFile(const QString &path, const QByteArray &contents)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(contents) == contents.size();
+}
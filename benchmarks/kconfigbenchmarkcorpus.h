@@ -0,0 +1,55 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGBENCHMARKCORPUS_H
+#define KCONFIGBENCHMARKCORPUS_H
+
+#include <QByteArray>
+#include <QStringList>
+
+/**
+ * Config files shaped like the ones found on a desktop, to benchmark with.
+ *
+ * The groups, keys and the kind of values follow real files, with the
+ * values made up, so nothing personal ends up in the repository. The
+ * contents only depend on the arguments, every run parses the same bytes.
+ */
+namespace KConfigBenchmarkCorpus
+{
+/**
+ * A kdeglobals of a long used desktop: the color schemes, a few hundred
+ * shortcuts, the font and widget settings and some recently used lists.
+ */
+QByteArray kdeglobals();
+
+/**
+ * A plasma-org.kde.plasma.desktop-appletsrc with @p containments panels
+ * and desktops of @p applets applets each. Every applet brings about five
+ * nested groups, the defaults give some thousands.
+ */
+QByteArray appletsrc(int containments = 40, int applets = 25);
+
+/**
+ * The desktop file of application @p number, with its name, comment,
+ * generic name and keywords, and those of two actions, translated into
+ * all of locales().
+ */
+QByteArray desktopFile(int number);
+
+/**
+ * The locales the desktop files are translated into, as found in the
+ * files of a distribution.
+ */
+QStringList locales();
+
+/**
+ * Writes @p contents to @p path, creating its directory if needed.
+ */
+bool writeFile(const QString &path, const QByteArray &contents);
+}
+
+#endif // KCONFIGBENCHMARKCORPUS_H
@@ -0,0 +1,553 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kconfigbenchmarkcorpus.h"
+#include "kconfigdata_p.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <KConfig>
+#include <KConfigGroup>
+#include <KConfigSnapshot>
+#include <KCoreConfigSkeleton>
+#include <KDesktopFile>
+#include <KDesktopFileIndex>
+#include <KSharedConfig>
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// The operations the performance work on KConfig is about, on files of the
+// size and shape found on a desktop. See kconfigbenchmarkcorpus.h for them.
+class KConfigCoreBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void parse_data();
+    void parse();
+    void fillEntryMap();
+    void cascadeOpen_data();
+    void cascadeOpen();
+    void readEntry_data();
+    void readEntry();
+    void readLocalized();
+    void writeEntry();
+    void sync_data();
+    void sync();
+    void groupList();
+    void subgroups();
+    void skeleton_data();
+    void skeleton();
+    void watcherReload_data();
+    void watcherReload();
+    void desktopFiles_data();
+    void desktopFiles();
+    void threadedReads_data();
+    void threadedReads();
+
+private:
+    QString filePath(const QString &name) const
+    {
+        return m_dir.filePath(name);
+    }
+
+    QTemporaryDir m_dir;
+    QString m_localConfig; // the writable part of the cascade of kconfigbenchmarkrc
+    QString m_globals;
+    QStringList m_desktopFiles;
+};
+
+namespace
+{
+enum class Type {
+    String,
+    Int,
+    Bool,
+    Double,
+    StringList,
+    DateTime,
+};
+
+constexpr int s_desktopFileCount = 200;
+constexpr int s_readsPerThread = 100;
+constexpr int s_typedKeys = 100;
+
+QByteArray typedEntries()
+{
+    QByteArray text;
+    const QDateTime dateTime(QDate(2026, 1, 1), QTime(12, 0));
+    for (const char *group : {"String", "Int", "Bool", "Double", "StringList", "DateTime"}) {
+        text += QByteArray("[") + group + "]\n";
+        for (int i = 0; i < s_typedKeys; ++i) {
+            QByteArray value;
+            if (qstrcmp(group, "String") == 0) {
+                value = "Some text number " + QByteArray::number(i);
+            } else if (qstrcmp(group, "Int") == 0) {
+                value = QByteArray::number(i * 37);
+            } else if (qstrcmp(group, "Bool") == 0) {
+                value = i % 2 ? "true" : "false";
+            } else if (qstrcmp(group, "Double") == 0) {
+                value = QByteArray::number(i / 7.0);
+            } else if (qstrcmp(group, "StringList") == 0) {
+                value = "first,second item," + QByteArray::number(i) + ",last";
+            } else {
+                value = dateTime.addSecs(i).toString(Qt::ISODateWithMs).toLatin1();
+            }
+            text += "key" + QByteArray::number(i) + '=' + value + '\n';
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+class BenchmarkSkeleton : public KCoreConfigSkeleton
+{
+public:
+    static constexpr int s_groups = 10;
+    static constexpr int s_itemsPerGroup = 30;
+
+    explicit BenchmarkSkeleton(const KSharedConfig::Ptr &config)
+        : KCoreConfigSkeleton(config)
+    {
+        for (int group = 0; group < s_groups; ++group) {
+            setCurrentGroup(QStringLiteral("Group %1").arg(group));
+            for (int i = 0; i < s_itemsPerGroup; ++i) {
+                const int item = group * s_itemsPerGroup + i;
+                const QString name = QStringLiteral("Item%1").arg(item);
+                switch (item % 4) {
+                case 0:
+                    addItemInt(name, ints[item], item);
+                    break;
+                case 1:
+                    addItemBool(name, bools[item], item % 3 == 0);
+                    break;
+                case 2:
+                    addItemString(name, strings[item], QStringLiteral("default %1").arg(item));
+                    break;
+                default:
+                    addItemStringList(name, lists[item], {QStringLiteral("a"), QStringLiteral("b")});
+                    break;
+                }
+            }
+        }
+    }
+
+    std::array<qint32, s_groups * s_itemsPerGroup> ints = {};
+    std::array<bool, s_groups * s_itemsPerGroup> bools = {};
+    std::array<QString, s_groups * s_itemsPerGroup> strings;
+    std::array<QStringList, s_groups * s_itemsPerGroup> lists;
+};
+}
+
+Q_DECLARE_METATYPE(Type)
+
+void KConfigCoreBenchmark::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+
+    QVERIFY(KConfigBenchmarkCorpus::writeFile(filePath(QStringLiteral("kdeglobals")), KConfigBenchmarkCorpus::kdeglobals()));
+    QVERIFY(KConfigBenchmarkCorpus::writeFile(filePath(QStringLiteral("appletsrc")), KConfigBenchmarkCorpus::appletsrc()));
+    QVERIFY(KConfigBenchmarkCorpus::writeFile(filePath(QStringLiteral("typedrc")), typedEntries()));
+    for (int i = 0; i < s_desktopFileCount; ++i) {
+        const QString path = filePath(QStringLiteral("applications/org.kde.app%1.desktop").arg(i));
+        QVERIFY(KConfigBenchmarkCorpus::writeFile(path, KConfigBenchmarkCorpus::desktopFile(i)));
+        m_desktopFiles.append(path);
+    }
+
+    // a cascade as an application sees it: kdeglobals, the defaults of the
+    // distribution and a small local file that changes a few of them
+    qputenv("XDG_CONFIG_DIRS", QFile::encodeName(filePath(QStringLiteral("xdg"))));
+    const QString configDir = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation);
+    m_globals = configDir + QLatin1String("/kdeglobals");
+    m_localConfig = configDir + QLatin1String("/kconfigbenchmarkrc");
+    QVERIFY(KConfigBenchmarkCorpus::writeFile(m_globals, KConfigBenchmarkCorpus::kdeglobals()));
+    QVERIFY(KConfigBenchmarkCorpus::writeFile(filePath(QStringLiteral("xdg/kdeglobals")), KConfigBenchmarkCorpus::kdeglobals()));
+    QVERIFY(KConfigBenchmarkCorpus::writeFile(filePath(QStringLiteral("xdg/kconfigbenchmarkrc")), KConfigBenchmarkCorpus::appletsrc(10, 10)));
+    QVERIFY(KConfigBenchmarkCorpus::writeFile(m_localConfig, "[Containments][1]\nlastScreen=1\n\n[Containments][2][General]\nAppletOrder=2001\n"));
+}
+
+void KConfigCoreBenchmark::cleanupTestCase()
+{
+    QFile::remove(m_globals);
+    QFile::remove(m_localConfig);
+}
+
+void KConfigCoreBenchmark::parse_data()
+{
+    QTest::addColumn<QString>("file");
+    QTest::addColumn<bool>("lazy");
+
+    QTest::newRow("kdeglobals") << filePath(QStringLiteral("kdeglobals")) << false;
+    QTest::newRow("appletsrc") << filePath(QStringLiteral("appletsrc")) << false;
+    QTest::newRow("appletsrc, lazy") << filePath(QStringLiteral("appletsrc")) << true;
+    QTest::newRow("desktop file") << m_desktopFiles.first() << false;
+    QTest::newRow("desktop file, lazy") << m_desktopFiles.first() << true;
+}
+
+void KConfigCoreBenchmark::parse()
+{
+    QFETCH(QString, file);
+    QFETCH(bool, lazy);
+
+    QBENCHMARK {
+        KConfig config(file, lazy ? KConfig::LazyLoading : KConfig::SimpleConfig);
+        QVERIFY(!config.isImmutable());
+    }
+}
+
+void KConfigCoreBenchmark::fillEntryMap()
+{
+    const QList<QByteArray> lines = KConfigBenchmarkCorpus::kdeglobals().split('\n');
+
+    // the way the system wide defaults are loaded, without the parsing
+    KEntryMap map;
+    QBENCHMARK {
+        map.clear();
+        QByteArray group("<default>");
+        for (const QByteArray &line : lines) {
+            if (line.startsWith('[')) {
+                group = line.mid(1, line.size() - 2).replace("][", "\x1d");
+            } else if (const auto eq = line.indexOf('='); eq > 0) {
+                map.setEntry(group, line.left(eq), line.mid(eq + 1), KEntryMap::EntryDefault);
+            }
+        }
+    }
+}
+
+void KConfigCoreBenchmark::cascadeOpen_data()
+{
+    QTest::addColumn<bool>("parseCache");
+
+    QTest::newRow("parse cache") << true;
+    QTest::newRow("no parse cache") << false;
+}
+
+void KConfigCoreBenchmark::cascadeOpen()
+{
+    QFETCH(bool, parseCache);
+    if (parseCache) {
+        qunsetenv("KCONFIG_DISABLE_PARSE_CACHE");
+    } else {
+        qputenv("KCONFIG_DISABLE_PARSE_CACHE", "1");
+    }
+
+    QBENCHMARK {
+        KConfig config(QStringLiteral("kconfigbenchmarkrc"));
+        QCOMPARE(KConfigGroup(&config, QStringLiteral("Containments")).group(QStringLiteral("1")).readEntry("lastScreen", 0), 1);
+    }
+    qunsetenv("KCONFIG_DISABLE_PARSE_CACHE");
+}
+
+void KConfigCoreBenchmark::readEntry_data()
+{
+    QTest::addColumn<Type>("type");
+    QTest::addColumn<QString>("groupName");
+
+    QTest::newRow("QString") << Type::String << QStringLiteral("String");
+    QTest::newRow("int") << Type::Int << QStringLiteral("Int");
+    QTest::newRow("bool") << Type::Bool << QStringLiteral("Bool");
+    QTest::newRow("double") << Type::Double << QStringLiteral("Double");
+    QTest::newRow("QStringList") << Type::StringList << QStringLiteral("StringList");
+    QTest::newRow("QDateTime") << Type::DateTime << QStringLiteral("DateTime");
+}
+
+void KConfigCoreBenchmark::readEntry()
+{
+    QFETCH(Type, type);
+    QFETCH(QString, groupName);
+    KConfig config(filePath(QStringLiteral("typedrc")), KConfig::SimpleConfig);
+    const KConfigGroup group(&config, groupName);
+    QVERIFY(group.exists());
+
+    std::array<QByteArray, s_typedKeys> keys;
+    for (int i = 0; i < s_typedKeys; ++i) {
+        keys[i] = "key" + QByteArray::number(i);
+    }
+
+    qsizetype sum = 0;
+    QBENCHMARK {
+        for (const QByteArray &key : keys) {
+            switch (type) {
+            case Type::String:
+                sum += group.readEntry(key.constData(), QString()).size();
+                break;
+            case Type::Int:
+                sum += group.readEntry(key.constData(), 0);
+                break;
+            case Type::Bool:
+                sum += group.readEntry(key.constData(), false);
+                break;
+            case Type::Double:
+                sum += group.readEntry(key.constData(), 0.0) > 1;
+                break;
+            case Type::StringList:
+                sum += group.readEntry(key.constData(), QStringList()).size();
+                break;
+            case Type::DateTime:
+                sum += group.readEntry(key.constData(), QDateTime()).isValid();
+                break;
+            }
+        }
+    }
+    QVERIFY(sum > 0);
+}
+
+void KConfigCoreBenchmark::readLocalized()
+{
+    KConfig config(m_desktopFiles.first(), KConfig::SimpleConfig);
+    config.setLocale(QStringLiteral("pt_BR"));
+    const KConfigGroup group(&config, QStringLiteral("Desktop Entry"));
+
+    QBENCHMARK {
+        QVERIFY(!group.readEntry("Name").isEmpty());
+        QVERIFY(!group.readEntry("GenericName").isEmpty());
+        QVERIFY(!group.readEntry("Comment").isEmpty());
+        QVERIFY(!group.readXdgListEntry("Keywords").isEmpty());
+    }
+}
+
+void KConfigCoreBenchmark::writeEntry()
+{
+    KConfig config(filePath(QStringLiteral("writerc")), KConfig::SimpleConfig);
+    KConfigGroup group(&config, QStringLiteral("Group"));
+
+    std::array<QByteArray, 1000> keys;
+    for (int i = 0; i < int(keys.size()); ++i) {
+        keys[i] = "key" + QByteArray::number(i);
+    }
+
+    int value = 0;
+    QBENCHMARK {
+        for (const QByteArray &key : keys) {
+            group.writeEntry(key.constData(), ++value);
+        }
+    }
+    config.markAsClean();
+}
+
+void KConfigCoreBenchmark::sync_data()
+{
+    QTest::addColumn<QString>("file");
+
+    QTest::newRow("kdeglobals") << filePath(QStringLiteral("kdeglobals"));
+    QTest::newRow("appletsrc") << filePath(QStringLiteral("appletsrc"));
+}
+
+void KConfigCoreBenchmark::sync()
+{
+    QFETCH(QString, file);
+    const QString copy = file + QLatin1String(".sync");
+    QFile::remove(copy);
+    QVERIFY(QFile::copy(file, copy));
+
+    // an application that changes one setting of a large file
+    KConfig config(copy, KConfig::SimpleConfig);
+    KConfigGroup group(&config, QStringLiteral("General"));
+    int value = 0;
+    QBENCHMARK {
+        group.writeEntry("Counter", ++value);
+        QVERIFY(config.sync());
+    }
+}
+
+void KConfigCoreBenchmark::groupList()
+{
+    KConfig config(filePath(QStringLiteral("appletsrc")), KConfig::SimpleConfig);
+
+    QBENCHMARK {
+        QVERIFY(!config.groupList().isEmpty());
+    }
+}
+
+void KConfigCoreBenchmark::subgroups()
+{
+    KConfig config(filePath(QStringLiteral("appletsrc")), KConfig::SimpleConfig);
+    const KConfigGroup containments(&config, QStringLiteral("Containments"));
+
+    // what plasmashell does to find its applets
+    qsizetype count = 0;
+    QBENCHMARK {
+        for (const QString &containment : containments.groupList()) {
+            const KConfigGroup applets = containments.group(containment).group(QStringLiteral("Applets"));
+            for (const QString &applet : applets.groupList()) {
+                count += applets.group(applet).group(QStringLiteral("Configuration")).groupList().size();
+            }
+        }
+    }
+    QVERIFY(count > 0);
+}
+
+void KConfigCoreBenchmark::skeleton_data()
+{
+    QTest::addColumn<QString>("operation");
+
+    QTest::newRow("load") << QStringLiteral("load");
+    QTest::newRow("load, changed file") << QStringLiteral("reload");
+    QTest::newRow("read") << QStringLiteral("read");
+    QTest::newRow("save") << QStringLiteral("save");
+}
+
+void KConfigCoreBenchmark::skeleton()
+{
+    QFETCH(QString, operation);
+    const QString file = filePath(QStringLiteral("skeletonrc"));
+    QFile::remove(file);
+
+    BenchmarkSkeleton skeleton(KSharedConfig::openConfig(file, KConfig::SimpleConfig));
+    for (int i = 0; i < int(skeleton.ints.size()); ++i) {
+        skeleton.ints[i] = i;
+        skeleton.strings[i] = QStringLiteral("value %1").arg(i);
+    }
+    QVERIFY(skeleton.save());
+
+    int value = 0;
+    QBENCHMARK {
+        if (operation == QLatin1String("load")) {
+            skeleton.load();
+        } else if (operation == QLatin1String("reload")) {
+            // another process changed a setting
+            KConfig other(file, KConfig::SimpleConfig);
+            KConfigGroup(&other, QStringLiteral("Group 1")).writeEntry("Item30", ++value);
+            QVERIFY(other.sync());
+            skeleton.load();
+        } else if (operation == QLatin1String("read")) {
+            skeleton.read();
+        } else {
+            skeleton.ints[0] = ++value;
+            QVERIFY(skeleton.save());
+        }
+    }
+}
+
+void KConfigCoreBenchmark::watcherReload_data()
+{
+    QTest::addColumn<bool>("changedGroupsOnly");
+
+    QTest::newRow("changed groups") << true;
+    QTest::newRow("whole file") << false;
+}
+
+void KConfigCoreBenchmark::watcherReload()
+{
+    QFETCH(bool, changedGroupsOnly);
+    const QString file = filePath(QStringLiteral("appletsrc.watched"));
+    QFile::remove(file);
+    QVERIFY(QFile::copy(filePath(QStringLiteral("appletsrc")), file));
+
+    // What KConfigWatcher does once it is told about a change: the changed
+    // groups are parsed again. Writing the change is part of the numbers,
+    // but small next to reading the file again.
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(file, KConfig::SimpleConfig);
+    const QString changed = QStringLiteral("Containments");
+    KConfig other(file, KConfig::SimpleConfig);
+    KConfigGroup otherGroup = KConfigGroup(&other, changed).group(QStringLiteral("1"));
+    int value = 0;
+    QBENCHMARK {
+        otherGroup.writeEntry("lastScreen", ++value);
+        QVERIFY(other.sync());
+        if (changedGroupsOnly) {
+            config->reparseGroups({changed + QLatin1Char('\x1d') + QLatin1Char('1')});
+        } else {
+            config->reparseConfiguration();
+        }
+    }
+    QCOMPARE(config->group(changed).group(QStringLiteral("1")).readEntry("lastScreen", 0), value);
+}
+
+void KConfigCoreBenchmark::desktopFiles_data()
+{
+    QTest::addColumn<QString>("reader");
+
+    QTest::newRow("KDesktopFile") << QStringLiteral("full");
+    QTest::newRow("KDesktopFile, DesktopEntryOnly") << QStringLiteral("entry");
+    QTest::newRow("KDesktopFileIndex") << QStringLiteral("index");
+}
+
+void KConfigCoreBenchmark::desktopFiles()
+{
+    QFETCH(QString, reader);
+
+    // a launcher listing the applications with their names and icons
+    qsizetype count = 0;
+    QBENCHMARK {
+        if (reader == QLatin1String("index")) {
+            const KDesktopFileIndex index({filePath(QStringLiteral("applications"))});
+            for (int i = 0; i < index.count(); ++i) {
+                count += !index.noDisplay(i) && !index.readName(i).isEmpty() && !index.readIcon(i).isEmpty();
+            }
+        } else {
+            const KDesktopFile::DesktopFileFlags flags = reader == QLatin1String("entry") ? KDesktopFile::DesktopEntryOnly : KDesktopFile::DesktopFileFlags();
+            for (const QString &path : std::as_const(m_desktopFiles)) {
+                const KDesktopFile desktopFile(path, flags);
+                count += !desktopFile.noDisplay() && !desktopFile.readName().isEmpty() && !desktopFile.readIcon().isEmpty();
+            }
+        }
+    }
+    QVERIFY(count > 0);
+}
+
+void KConfigCoreBenchmark::threadedReads_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::addColumn<bool>("snapshot");
+
+    for (const int threads : {1, 4, 8}) {
+        QTest::addRow("%d threads, KSharedConfig", threads) << threads << false;
+        QTest::addRow("%d threads, KConfigSnapshot", threads) << threads << true;
+    }
+}
+
+void KConfigCoreBenchmark::threadedReads()
+{
+    QFETCH(int, threads);
+    QFETCH(bool, snapshot);
+    const QString file = filePath(QStringLiteral("appletsrc"));
+
+    // Worker threads opening the same config and reading from it: KSharedConfig
+    // parses it once in each thread, KConfigSnapshot once for the whole process
+    std::atomic<int> count = 0;
+    QBENCHMARK {
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (int i = 0; i < threads; ++i) {
+            workers.emplace_back([&file, &count, snapshot]() {
+                if (snapshot) {
+                    const KConfigSnapshot config = KConfigSnapshot::open(file, KConfig::SimpleConfig);
+                    for (int j = 0; j < s_readsPerThread; ++j) {
+                        count += !config.readEntry(QStringLiteral("Containments\x1d1"), "plugin").isEmpty();
+                    }
+                } else {
+                    const KSharedConfigPtr config = KSharedConfig::openConfig(KConfig::ConfigAssociation::NoAssociation, file, KConfig::SimpleConfig);
+                    const KConfigGroup group = config->group(QStringLiteral("Containments")).group(QStringLiteral("1"));
+                    for (int j = 0; j < s_readsPerThread; ++j) {
+                        count += !group.readEntry("plugin", QString()).isEmpty();
+                    }
+                }
+            });
+        }
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+    QVERIFY(count > 0);
+}
+
+QTEST_MAIN(KConfigCoreBenchmark)
+
+#include "kconfigcorebenchmark.moc"
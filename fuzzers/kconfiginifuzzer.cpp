@@ -0,0 +1,105 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+/*
+ * libFuzzer target for the parser of config files.
+ *
+ * Every input is written to a file, which is then parsed eagerly and lazily,
+ * read entry by entry with KConfigIniReader, read back through KConfigGroup,
+ * which decodes the escaped values, and merged with a written entry.
+ *
+ * Besides crashes, inputs that take too long are reported: a parser that goes
+ * quadratic on some inputs is a bug just like one that crashes on them. The
+ * budget of an input is KCONFIG_FUZZ_BUDGET_MS plus KCONFIG_FUZZ_BUDGET_MS_PER_KIB
+ * for each KiB of it, 50 and 5 by default, raise them for slow sanitizers.
+ */
+
+#include <KConfig>
+#include <KConfigGroup>
+#include <KConfigIniReader>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+QString inputFile()
+{
+    static QTemporaryDir dir;
+    static const QString fileName = dir.filePath(QStringLiteral("fuzzrc"));
+    return fileName;
+}
+
+qint64 budgetMs(qsizetype size)
+{
+    static const int base = qEnvironmentVariableIsSet("KCONFIG_FUZZ_BUDGET_MS") ? qEnvironmentVariableIntValue("KCONFIG_FUZZ_BUDGET_MS") : 50;
+    static const int perKiB = qEnvironmentVariableIsSet("KCONFIG_FUZZ_BUDGET_MS_PER_KIB") ? qEnvironmentVariableIntValue("KCONFIG_FUZZ_BUDGET_MS_PER_KIB") : 5;
+    return base + qint64(perKiB) * (size / 1024);
+}
+
+// Reads all the entries the way applications do, which decodes every value
+void readAll(const KConfig &config)
+{
+    const QStringList groups = config.groupList();
+    for (const QString &name : groups) {
+        const KConfigGroup group = config.group(name);
+        const QStringList keys = group.keyList();
+        for (const QString &key : keys) {
+            (void)group.readEntry(key, QString());
+            (void)group.readEntry(key, QStringList());
+        }
+        (void)group.groupList();
+    }
+}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    const QString fileName = inputFile();
+    {
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return 0;
+        }
+        file.write(reinterpret_cast<const char *>(data), qint64(size));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    {
+        KConfig config(fileName, KConfig::SimpleConfig);
+        readAll(config);
+    }
+    {
+        KConfig config(fileName, KConfig::SimpleConfig | KConfig::LazyLoading);
+        readAll(config);
+    }
+    {
+        KConfigIniReader reader(fileName);
+        while (reader.readNext()) {
+            (void)reader.value();
+        }
+    }
+    {
+        // writing merges the entry into the file, copying the groups it doesn't touch
+        KConfig config(fileName, KConfig::SimpleConfig);
+        config.group(QStringLiteral("Fuzz")).writeEntry("Key", QStringLiteral("[value]\\n"));
+        config.sync();
+    }
+
+    const qint64 elapsed = timer.elapsed();
+    if (elapsed > budgetMs(qsizetype(size))) {
+        fprintf(stderr, "An input of %zu bytes took %lld ms, more than the budget of %lld ms\n", size, qlonglong(elapsed), qlonglong(budgetMs(qsizetype(size))));
+        abort();
+    }
+    return 0;
+}
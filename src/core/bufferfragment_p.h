@@ -10,8 +10,80 @@
 
 #include "kconfigini_p.h"
 
+#include <QtAlgorithms>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #define bf_isspace(str) ((str == ' ') || (str == '\t') || (str == '\r'))
 
+// Returns the first occurrence of @p c in [@p begin, @p end), or nullptr.
+// Config files are mostly long runs of key and value characters, so the
+// delimiters are searched for 16 bytes at a time where the CPU allows it.
+static inline const char *bf_findChar(const char *begin, const char *end, char c)
+{
+#if defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - begin >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        const uint mask = uint(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        if (mask) {
+            return begin + qCountTrailingZeroBits(mask);
+        }
+        begin += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t needle = vdupq_n_u8(uchar(c));
+    while (end - begin >= 16) {
+        const uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t *>(begin));
+        if (vmaxvq_u8(vceqq_u8(chunk, needle))) {
+            break; // the scalar loop below finds it within this chunk
+        }
+        begin += 16;
+    }
+#endif
+    for (; begin < end; ++begin) {
+        if (*begin == c) {
+            return begin;
+        }
+    }
+    return nullptr;
+}
+
+// Returns the last occurrence of @p c in [@p begin, @p end), or nullptr.
+static inline const char *bf_findLastChar(const char *begin, const char *end, char c)
+{
+#if defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - begin >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(end - 16));
+        const uint mask = uint(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        if (mask) {
+            return end - 16 + (31 - qCountLeadingZeroBits(mask));
+        }
+        end -= 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t needle = vdupq_n_u8(uchar(c));
+    while (end - begin >= 16) {
+        const uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t *>(end - 16));
+        if (vmaxvq_u8(vceqq_u8(chunk, needle))) {
+            break; // the scalar loop below finds it within this chunk
+        }
+        end -= 16;
+    }
+#endif
+    while (end > begin) {
+        if (*--end == c) {
+            return end;
+        }
+    }
+    return nullptr;
+}
+
 // This class provides wrapper around fragment of existing buffer (array of bytes).
 // If underlying buffer gets deleted, all BufferFragment objects referencing it become invalid.
 // Use toByteArray() to make deep copy of the buffer fragment.
@@ -146,25 +218,17 @@ public:
 
     int indexOf(char c, unsigned int from = 0) const
     {
-        const char *cursor = d + from - 1;
-        const char *end = d + len;
-        while (++cursor < end)
-            if (*cursor == c) {
-                return cursor - d;
-            }
-        return -1;
+        if (from >= len) {
+            return -1;
+        }
+        const char *found = bf_findChar(d + from, d + len, c);
+        return found ? found - d : -1;
     }
 
     int lastIndexOf(char c) const
     {
-        int from = len - 1;
-        while (from >= 0)
-            if (d[from] == c) {
-                return from;
-            } else {
-                --from;
-            }
-        return -1;
+        const char *found = bf_findLastChar(d, d + len, c);
+        return found ? found - d : -1;
     }
 
     QByteArray toByteArray() const
@@ -184,21 +248,16 @@ private:
     unsigned int len;
 };
 
-uint qHash(const KConfigIniBackend::BufferFragment fragment)
-{
-    const uchar *p = reinterpret_cast<const uchar *>(fragment.constData());
-    const int len = fragment.length();
-
-    // This algorithm is copied from qhash.cpp (Qt5 version).
-    // Sadly this code is not accessible from the outside without going through abstraction
-    // layers. Even QByteArray::fromRawData would do an allocation internally...
-    uint h = 0;
-
-    for (int i = 0; i < len; ++i) {
-        h = 31 * h + p[i];
-    }
-
-    return h;
-}
+// The result of KConfigIniBackend::parseEntryLine()
+struct KConfigIniBackend::EntryToken {
+    BufferFragment key; // not decoded yet
+    BufferFragment locale; // null if there is none
+    BufferFragment value; // not decoded yet
+    bool immutable = false;
+    bool expand = false;
+    bool deleted = false;
+    bool removed = false; // [$r], only written to journals
+    bool binary = false; // the value is base64 encoded
+};
 
 #endif
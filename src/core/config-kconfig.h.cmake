@@ -1 +1,3 @@
 #cmakedefine01 KCONFIG_USE_DBUS
+#define CMAKE_INSTALL_FULL_LIBDIR "${CMAKE_INSTALL_FULL_LIBDIR}"
+#cmakedefine01 HAVE_EXECINFO_H
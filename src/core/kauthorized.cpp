@@ -23,11 +23,30 @@
 
 #include <kconfiggroup.h>
 
+#include "kconfig_p.h"
+
+#include <QMetaEnum>
 #include <QMutexLocker>
 #include <QRecursiveMutex>
 
+#include <memory>
+
 extern bool kde_kiosk_exception;
 
+// The parts of a URL the rules look at, taken from it once for all the rules
+struct URLActionParts {
+    explicit URLActionParts(const QUrl &url)
+        : scheme(url.scheme())
+        , host(url.host())
+        , path(url.path())
+    {
+    }
+
+    const QString scheme;
+    const QString host;
+    const QString path;
+};
+
 class URLActionRule
 {
 public:
@@ -76,79 +95,79 @@ public:
         checkEqual(destHost, destHostEqual);
     }
 
-    bool baseMatch(const QUrl &url, const QString &protClass) const
+    bool baseMatch(const URLActionParts &url, const QString &protClass) const
     {
         if (baseProtWildCard) {
             if (!baseProt.isEmpty() //
-                && !url.scheme().startsWith(baseProt) //
+                && !url.scheme.startsWith(baseProt) //
                 && (protClass.isEmpty() || (protClass != baseProt))) {
                 return false;
             }
         } else {
-            if (url.scheme() != baseProt //
+            if (url.scheme != baseProt //
                 && (protClass.isEmpty() || (protClass != baseProt))) {
                 return false;
             }
         }
         if (baseHostWildCard) {
-            if (!baseHost.isEmpty() && !url.host().endsWith(baseHost)) {
+            if (!baseHost.isEmpty() && !url.host.endsWith(baseHost)) {
                 return false;
             }
         } else {
-            if (url.host() != baseHost) {
+            if (url.host != baseHost) {
                 return false;
             }
         }
         if (basePathWildCard) {
-            if (!basePath.isEmpty() && !url.path().startsWith(basePath)) {
+            if (!basePath.isEmpty() && !url.path.startsWith(basePath)) {
                 return false;
             }
         } else {
-            if (url.path() != basePath) {
+            if (url.path != basePath) {
                 return false;
             }
         }
         return true;
     }
 
-    bool destMatch(const QUrl &url, const QString &protClass, const QUrl &base, const QString &baseClass) const
+    bool destMatch(const URLActionParts &url, const QString &protClass, const URLActionParts &base, const QString &baseClass) const
     {
         if (destProtEqual) {
-            if (url.scheme() != base.scheme() //
+            if (url.scheme != base.scheme //
                 && (protClass.isEmpty() || baseClass.isEmpty() || protClass != baseClass)) {
                 return false;
             }
         } else if (destProtWildCard) {
             if (!destProt.isEmpty() //
-                && !url.scheme().startsWith(destProt) //
+                && !url.scheme.startsWith(destProt) //
                 && (protClass.isEmpty() || (protClass != destProt))) {
                 return false;
             }
         } else {
-            if (url.scheme() != destProt //
+            if (url.scheme != destProt //
                 && (protClass.isEmpty() || (protClass != destProt))) {
                 return false;
             }
         }
         if (destHostWildCard) {
-            if (!destHost.isEmpty() && !url.host().endsWith(destHost)) {
+            if (!destHost.isEmpty() && !url.host.endsWith(destHost)) {
                 return false;
             }
         } else if (destHostEqual) {
-            if (url.host() != base.host()) {
+            if (url.host != base.host) {
                 return false;
             }
         } else {
-            if (url.host() != destHost) {
+            if (url.host != destHost) {
                 return false;
             }
         }
         if (destPathWildCard) {
-            if (!destPath.isEmpty() && !url.path().startsWith(destPath)) {
+            if (!destPath.isEmpty() && !url.path.startsWith(destPath)) {
                 return false;
             }
         } else {
-            if (url.path() != destPath) {
+            if (url.path != destPath) {
                 return false;
             }
         }
@@ -173,12 +192,43 @@ public:
     bool permission;
 };
 
+// The decisions for the values of @p Enum, indexed by the value, all true by default
+template<typename Enum>
+static QList<bool> enumDecisions(const QHash<QString, bool> &decisions)
+{
+    const QMetaEnum metaEnum = QMetaEnum::fromType<Enum>();
+    QList<bool> result;
+    for (int i = 0; i < metaEnum.keyCount(); ++i) {
+        const int value = metaEnum.value(i);
+        if (value >= result.size()) {
+            result.resize(value + 1, true);
+        }
+        result[value] = decisions.value(QString::fromLatin1(metaEnum.key(i)).toLower(), true);
+    }
+    return result;
+}
+
+// The URL action rules in effect, never changed once published, see
+// KAuthorizedPrivate::setUrlActionRules()
+struct URLActionRules {
+    explicit URLActionRules(QList<URLActionRule> &&list)
+        : rules(std::move(list))
+    {
+        for (const URLActionRule &rule : std::as_const(rules)) {
+            byAction[QString::fromLatin1(rule.action)].append(rule);
+        }
+    }
+
+    QList<URLActionRule> rules;
+    // the same rules, in the same order, for each action
+    QHash<QString, QList<URLActionRule>> byAction;
+};
+
 class KAuthorizedPrivate
 {
 public:
     KAuthorizedPrivate()
-        : actionRestrictions(false)
-        , blockEverything(false)
+        : blockEverything(false)
     {
         Q_ASSERT_X(QCoreApplication::instance(), "KAuthorizedPrivate()", "There has to be an existing QCoreApplication::instance() pointer");
 
@@ -187,21 +237,83 @@ public:
         Q_ASSERT_X(config, "KAuthorizedPrivate()", "There has to be an existing KSharedConfig::openConfig() pointer");
         if (!config) {
             blockEverything = true;
-            return;
         }
-        actionRestrictions = config->hasGroup("KDE Action Restrictions") && !kde_kiosk_exception;
     }
 
     ~KAuthorizedPrivate()
     {
     }
 
-    bool actionRestrictions : 1;
+    // Reads the restriction groups again if the entries of the config changed since the last time
+    void updateDecisions();
+
+    std::shared_ptr<const URLActionRules> urlActionRules() const
+    {
+        QMutexLocker locker(&urlActionMutex);
+        return urlActionRestrictions;
+    }
+    void setUrlActionRules(QList<URLActionRule> &&rules)
+    {
+        auto published = std::make_shared<const URLActionRules>(std::move(rules));
+        QMutexLocker locker(&urlActionMutex);
+        urlActionRestrictions = std::move(published);
+    }
+
     bool blockEverything : 1;
-    QList<URLActionRule> urlActionRestrictions;
     QRecursiveMutex mutex;
+
+    // only guards swapping the pointer, rules are matched without holding it
+    mutable QMutex urlActionMutex;
+    std::shared_ptr<const URLActionRules> urlActionRestrictions;
+
+    // the entries of "KDE Action Restrictions", those starting with "action/" without that
+    QHash<QString, bool> decisions;
+    QHash<QString, bool> actionDecisions;
+    QList<bool> restrictionDecisions; // indexed by KAuthorized::GenericRestriction
+    QList<bool> genericActionDecisions; // indexed by KAuthorized::GenericAction
+    // the entries of "KDE Control Module Restrictions"
+    QHash<QString, bool> controlModuleDecisions;
+    const KConfig *decisionsConfig = nullptr;
+    quint64 decisionsGeneration = 0;
 };
 
+void KAuthorizedPrivate::updateDecisions()
+{
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp);
+    const KConfigPrivate *configPrivate = config->d_func();
+    if (config.data() == decisionsConfig && configPrivate->generation == decisionsGeneration) {
+        return;
+    }
+    decisionsConfig = config.data();
+    decisionsGeneration = configPrivate->generation;
+
+    decisions.clear();
+    actionDecisions.clear();
+    if (config->hasGroup("KDE Action Restrictions") && !kde_kiosk_exception) {
+        const QLatin1String actionPrefix("action/");
+        const KConfigGroup cg(config, "KDE Action Restrictions");
+        const QStringList keys = cg.keyList();
+        for (const QString &key : keys) {
+            const bool decision = cg.readBoolEntry(key, true);
+            decisions.insert(key, decision);
+            if (key.startsWith(actionPrefix)) {
+                actionDecisions.insert(key.mid(actionPrefix.size()), decision);
+            }
+        }
+    }
+    restrictionDecisions = enumDecisions<KAuthorized::GenericRestriction>(decisions);
+    genericActionDecisions = enumDecisions<KAuthorized::GenericAction>(actionDecisions);
+
+    controlModuleDecisions.clear();
+    if (!kde_kiosk_exception) {
+        const KConfigGroup cg(config, "KDE Control Module Restrictions");
+        const QStringList keys = cg.keyList();
+        for (const QString &key : keys) {
+            controlModuleDecisions.insert(key, cg.readBoolEntry(key, true));
+        }
+    }
+}
+
 Q_GLOBAL_STATIC(KAuthorizedPrivate, authPrivate)
 #define MY_D KAuthorizedPrivate *d = authPrivate();
 
@@ -212,20 +324,23 @@ bool KAuthorized::authorize(const QString &genericAction)
         return false;
     }
 
-    if (!d->actionRestrictions) {
-        return true;
-    }
-
-    KConfigGroup cg(KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp), "KDE Action Restrictions");
-    return cg.readEntry(genericAction, true);
+    QMutexLocker locker(&d->mutex);
+    d->updateDecisions();
+    return d->decisions.value(genericAction, true);
 }
 
 bool KAuthorized::authorize(KAuthorized::GenericRestriction action)
 {
-    const QMetaEnum metaEnum = QMetaEnum::fromType<KAuthorized::GenericRestriction>();
+    MY_D if (d->blockEverything)
+    {
+        return false;
+    }
 
-    if (metaEnum.isValid() && action != 0) {
-        return KAuthorized::authorize(QString::fromLatin1(metaEnum.valueToKey(action)).toLower());
+    QMutexLocker locker(&d->mutex);
+    d->updateDecisions();
+    // index 0 is no enumerator either
+    if (action > 0 && action < d->restrictionDecisions.size()) {
+        return d->restrictionDecisions.at(action);
     }
     qCWarning(KCONFIG_CORE_LOG) << "Invalid GenericRestriction requested" << action;
     return false;
@@ -237,18 +352,26 @@ bool KAuthorized::authorizeAction(const QString &action)
     {
         return false;
     }
-    if (!d->actionRestrictions || action.isEmpty()) {
+    if (action.isEmpty()) {
         return true;
     }
 
-    return authorize(QLatin1String("action/") + action);
+    QMutexLocker locker(&d->mutex);
+    d->updateDecisions();
+    return d->actionDecisions.value(action, true);
 }
 
 bool KAuthorized::authorizeAction(KAuthorized::GenericAction action)
 {
-    const QMetaEnum metaEnum = QMetaEnum::fromType<KAuthorized::GenericAction>();
-    if (metaEnum.isValid() && action != 0) {
-        return KAuthorized::authorizeAction(QString::fromLatin1(metaEnum.valueToKey(action)).toLower());
+    MY_D if (d->blockEverything)
+    {
+        return false;
+    }
+
+    QMutexLocker locker(&d->mutex);
+    d->updateDecisions();
+    if (action > 0 && action < d->genericActionDecisions.size()) {
+        return d->genericActionDecisions.at(action);
     }
     qCWarning(KCONFIG_CORE_LOG) << "Invalid GenericAction requested" << action;
     return false;
@@ -259,17 +382,34 @@ bool KAuthorized::authorizeControlModule(const QString &menuId)
     if (menuId.isEmpty() || kde_kiosk_exception) {
         return true;
     }
-    KConfigGroup cg(KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp), "KDE Control Module Restrictions");
-    return cg.readEntry(menuId, true);
+    MY_D QMutexLocker locker(&d->mutex);
+    d->updateDecisions();
+    return d->controlModuleDecisions.value(menuId, true);
 }
 
 QStringList KAuthorized::authorizeControlModules(const QStringList &menuIds)
 {
-    KConfigGroup cg(KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp), "KDE Control Module Restrictions");
+    const QBitArray authorized = authorizeControlModulesMask(menuIds);
     QStringList result;
-    for (const auto &id : menuIds) {
-        if (cg.readEntry(id, true)) {
-            result.append(id);
+    for (int i = 0; i < menuIds.size(); ++i) {
+        if (authorized.testBit(i)) {
+            result.append(menuIds.at(i));
+        }
+    }
+    return result;
+}
+
+QBitArray KAuthorized::authorizeControlModulesMask(const QStringList &menuIds)
+{
+    QBitArray result(menuIds.size(), true);
+    MY_D QMutexLocker locker(&d->mutex);
+    d->updateDecisions();
+    if (d->controlModuleDecisions.isEmpty()) {
+        return result;
+    }
+    for (int i = 0; i < menuIds.size(); ++i) {
+        if (!d->controlModuleDecisions.value(menuIds.at(i), true)) {
+            result.clearBit(i);
         }
     }
     return result;
@@ -280,35 +420,35 @@ KCONFIGCORE_EXPORT void loadUrlActionRestrictions(const KConfigGroup &cg)
 {
     MY_D const QString Any;
 
-    d->urlActionRestrictions.clear();
-    d->urlActionRestrictions.append(URLActionRule("open", Any, Any, Any, Any, Any, Any, true));
-    d->urlActionRestrictions.append(URLActionRule("list", Any, Any, Any, Any, Any, Any, true));
+    QList<URLActionRule> rules;
+    rules.append(URLActionRule("open", Any, Any, Any, Any, Any, Any, true));
+    rules.append(URLActionRule("list", Any, Any, Any, Any, Any, Any, true));
     // TEST:
     //  d->urlActionRestrictions.append(
     //  URLActionRule("list", Any, Any, Any, Any, Any, Any, false));
     //  d->urlActionRestrictions.append(
     //  URLActionRule("list", Any, Any, Any, "file", Any, QDir::homePath(), true));
-    d->urlActionRestrictions.append(URLActionRule("link", Any, Any, Any, QStringLiteral(":internet"), Any, Any, true));
-    d->urlActionRestrictions.append(URLActionRule("redirect", Any, Any, Any, QStringLiteral(":internet"), Any, Any, true));
+    rules.append(URLActionRule("link", Any, Any, Any, QStringLiteral(":internet"), Any, Any, true));
+    rules.append(URLActionRule("redirect", Any, Any, Any, QStringLiteral(":internet"), Any, Any, true));
 
     // We allow redirections to file: but not from internet protocols, redirecting to file:
     // is very popular among KIO workers and we don't want to break them
-    d->urlActionRestrictions.append(URLActionRule("redirect", Any, Any, Any, QStringLiteral("file"), Any, Any, true));
-    d->urlActionRestrictions.append(URLActionRule("redirect", QStringLiteral(":internet"), Any, Any, QStringLiteral("file"), Any, Any, false));
+    rules.append(URLActionRule("redirect", Any, Any, Any, QStringLiteral("file"), Any, Any, true));
+    rules.append(URLActionRule("redirect", QStringLiteral(":internet"), Any, Any, QStringLiteral("file"), Any, Any, false));
 
     // local protocols may redirect everywhere
-    d->urlActionRestrictions.append(URLActionRule("redirect", QStringLiteral(":local"), Any, Any, Any, Any, Any, true));
+    rules.append(URLActionRule("redirect", QStringLiteral(":local"), Any, Any, Any, Any, Any, true));
 
     // Anyone may redirect to about:
-    d->urlActionRestrictions.append(URLActionRule("redirect", Any, Any, Any, QStringLiteral("about"), Any, Any, true));
+    rules.append(URLActionRule("redirect", Any, Any, Any, QStringLiteral("about"), Any, Any, true));
 
     // Anyone may redirect to mailto:
-    d->urlActionRestrictions.append(URLActionRule("redirect", Any, Any, Any, QStringLiteral("mailto"), Any, Any, true));
+    rules.append(URLActionRule("redirect", Any, Any, Any, QStringLiteral("mailto"), Any, Any, true));
 
     // Anyone may redirect to itself, cq. within it's own group
-    d->urlActionRestrictions.append(URLActionRule("redirect", Any, Any, Any, QStringLiteral("="), Any, Any, true));
+    rules.append(URLActionRule("redirect", Any, Any, Any, QStringLiteral("="), Any, Any, true));
 
-    d->urlActionRestrictions.append(URLActionRule("redirect", QStringLiteral("about"), Any, Any, Any, Any, Any, true));
+    rules.append(URLActionRule("redirect", QStringLiteral("about"), Any, Any, Any, Any, Any, true));
 
     int count = cg.readEntry("rule_count", 0);
     QString keyFormat = QStringLiteral("rule_%1");
@@ -345,8 +485,41 @@ KCONFIGCORE_EXPORT void loadUrlActionRestrictions(const KConfigGroup &cg)
             urlPath.replace(0, 4, QDir::tempPath());
         }
 
-        d->urlActionRestrictions.append(URLActionRule(action, refProt, refHost, refPath, urlProt, urlHost, urlPath, bEnabled));
+        rules.append(URLActionRule(action, refProt, refHost, refPath, urlProt, urlHost, urlPath, bEnabled));
+    }
+
+    d->setUrlActionRules(std::move(rules));
+}
+
+// The rules in effect for @p action, in their order, loaded on first use
+static QList<URLActionRule> urlActionRules(KAuthorizedPrivate *d, const QString &action)
+{
+    std::shared_ptr<const URLActionRules> rules = d->urlActionRules();
+    if (!rules || rules->rules.isEmpty()) {
+        QMutexLocker locker(&d->mutex);
+        rules = d->urlActionRules();
+        if (!rules || rules->rules.isEmpty()) {
+            KConfigGroup cg(KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp), "KDE URL Restrictions");
+            loadUrlActionRestrictions(cg);
+            rules = d->urlActionRules();
+        }
+    }
+    return rules->byAction.value(action);
+}
+
+static bool matchUrlAction(const QList<URLActionRule> &actionRules, const URLActionParts &base, const QString &baseClass, const QUrl &_destURL, const QString &destClass)
+{
+    QUrl destURL(_destURL);
+    destURL.setPath(QDir::cleanPath(destURL.path()));
+    const URLActionParts dest(destURL);
+
+    // the last matching rule decides
+    for (auto it = actionRules.crbegin(); it != actionRules.crend(); ++it) {
+        if (it->baseMatch(base, baseClass) && it->destMatch(dest, destClass, base, baseClass)) {
+            return it->permission;
+        }
     }
+    return false;
 }
 
 namespace KAuthorized
@@ -362,8 +535,11 @@ KCONFIGCORE_EXPORT void allowUrlActionInternal(const QString &action, const QUrl
     const QString basePath = _baseURL.adjusted(QUrl::StripTrailingSlash).path();
     const QString destPath = _destURL.adjusted(QUrl::StripTrailingSlash).path();
 
-    d->urlActionRestrictions.append(
-        URLActionRule(action.toLatin1(), _baseURL.scheme(), _baseURL.host(), basePath, _destURL.scheme(), _destURL.host(), destPath, true));
+    // the rules in effect are never changed, a copy with the new one replaces them
+    const std::shared_ptr<const URLActionRules> current = d->urlActionRules();
+    QList<URLActionRule> rules = current ? current->rules : QList<URLActionRule>();
+    rules.append(URLActionRule(action.toLatin1(), _baseURL.scheme(), _baseURL.host(), basePath, _destURL.scheme(), _destURL.host(), destPath, true));
+    d->setUrlActionRules(std::move(rules));
 }
 
 /**
@@ -373,8 +549,8 @@ KCONFIGCORE_EXPORT void allowUrlActionInternal(const QString &action, const QUrl
 KCONFIGCORE_EXPORT bool
 authorizeUrlActionInternal(const QString &action, const QUrl &_baseURL, const QUrl &_destURL, const QString &baseClass, const QString &destClass)
 {
-    MY_D QMutexLocker locker(&(d->mutex));
-    if (d->blockEverything) {
+    MY_D if (d->blockEverything)
+    {
         return false;
     }
 
@@ -382,23 +558,39 @@ authorizeUrlActionInternal(const QString &action, const QUrl &_baseURL, const QU
         return true;
     }
 
-    bool result = false;
-    if (d->urlActionRestrictions.isEmpty()) {
-        KConfigGroup cg(KSharedConfig::openConfig(KConfig::ConfigAssociation::KdeApp), "KDE URL Restrictions");
-        loadUrlActionRestrictions(cg);
+    const QList<URLActionRule> actionRules = urlActionRules(d, action);
+    if (actionRules.isEmpty()) {
+        return false;
     }
 
     QUrl baseURL(_baseURL);
     baseURL.setPath(QDir::cleanPath(baseURL.path()));
+    return matchUrlAction(actionRules, URLActionParts(baseURL), baseClass, _destURL, destClass);
+}
 
-    QUrl destURL(_destURL);
-    destURL.setPath(QDir::cleanPath(destURL.path()));
+/**
+ * Helper for KAuthorized::authorizeUrlAction in KIO, for many destinations at once
+ * @private
+ */
+KCONFIGCORE_EXPORT QBitArray
+authorizeUrlActionsInternal(const QString &action, const QUrl &_baseURL, const QList<QUrl> &destURLs, const QString &baseClass, const QStringList &destClasses)
+{
+    Q_ASSERT(destClasses.size() == destURLs.size());
+
+    MY_D if (d->blockEverything)
+    {
+        return QBitArray(destURLs.size(), false);
+    }
 
-    for (const URLActionRule &rule : std::as_const(d->urlActionRestrictions)) {
-        if ((result != rule.permission) && // No need to check if it doesn't make a difference
-            (action == QLatin1String(rule.action.constData())) && rule.baseMatch(baseURL, baseClass)
-            && rule.destMatch(destURL, destClass, baseURL, baseClass)) {
-            result = rule.permission;
+    QBitArray result(destURLs.size(), false);
+    const QList<URLActionRule> actionRules = urlActionRules(d, action);
+    QUrl baseURL(_baseURL);
+    baseURL.setPath(QDir::cleanPath(baseURL.path()));
+    const URLActionParts base(baseURL);
+    for (int i = 0; i < destURLs.size(); ++i) {
+        const QUrl &destURL = destURLs.at(i);
+        if (destURL.isEmpty() || (!actionRules.isEmpty() && matchUrlAction(actionRules, base, baseClass, destURL, destClasses.value(i)))) {
+            result.setBit(i);
         }
     }
     return result;
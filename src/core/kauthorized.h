@@ -10,6 +10,7 @@
 
 #include <kconfigcore_export.h>
 
+#include <QBitArray>
 #include <QMetaEnum>
 #include <QObject>
 #include <QStringList>
@@ -174,6 +175,19 @@ KCONFIGCORE_EXPORT bool authorizeControlModule(const QString &menuId);
  */
 KCONFIGCORE_EXPORT QStringList authorizeControlModules(const QStringList &menuIds);
 
+/**
+ * Determines which control modules from a list the user is permitted to
+ * use, all of them checked at once.
+ *
+ * @param menuIds  A list of desktop menu IDs for control modules.
+ * @return         A bit for each entry in @p menuIds, set if
+ *                 authorizeControlModule() returns @c true for it.
+ *
+ * @see authorizeControlModules()
+ * @since 6.1
+ */
+KCONFIGCORE_EXPORT QBitArray authorizeControlModulesMask(const QStringList &menuIds);
+
 }
 
 #endif
@@ -17,26 +17,43 @@
 #include <fcntl.h>
 
 #include "kconfigbackend_p.h"
+#include "kconfigcompiled_p.h"
+#include "kconfignotify_p.h"
 #include "kconfiggroup.h"
+#include "kconfigparsecache_p.h"
+#include "kconfigsnapshot.h"
+#include "kconfigsnapshot_p.h"
+#include "kconfigstringpool_p.h"
+#include "kconfigtrace_p.h"
+#include "kconfupdate_p.h"
 #include "qglobal.h"
 
+#include <QAbstractEventDispatcher>
 #include <QBasicMutex>
 #include <QByteArray>
 #include <QCache>
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QHash>
 #include <QLocale>
 #include <QMutexLocker>
+#include <QPointer>
 #include <QProcess>
+#include <QSemaphore>
 #include <QSet>
-#include <QThreadStorage>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
 
 #include <algorithm>
 #include <iterator>
+#include <map>
 #include <set>
-#include <string_view>
-#include <unordered_set>
+#include <vector>
 
 #if KCONFIG_USE_DBUS
 #include <QDBusConnection>
@@ -49,18 +66,299 @@ bool KConfigPrivate::mappingsRegistered = false;
 // For caching purposes
 static bool s_wasTestModeEnabled = false;
 
-Q_GLOBAL_STATIC(QStringList, s_globalFiles) // For caching purposes.
-static QBasicMutex s_globalFilesMutex;
+namespace
+{
+// A lookup of the global files. Once published it is never changed, a newer one replaces
+// it: the configs reading it only take a reference, they never wait for a lookup.
+struct GlobalFiles {
+    QStringList files;
+    quint64 version; // lookups are numbered, an older one never replaces a newer one
+};
+using GlobalFilesPtr = std::shared_ptr<const GlobalFiles>;
+
+class PublishedGlobalFiles
+{
+public:
+    GlobalFilesPtr load() const
+    {
+#ifdef __cpp_lib_atomic_shared_ptr
+        return m_current.load(std::memory_order_acquire);
+#else
+        QMutexLocker locker(&m_mutex);
+        return m_current;
+#endif
+    }
+
+    void publish(const GlobalFilesPtr &files)
+    {
+#ifdef __cpp_lib_atomic_shared_ptr
+        GlobalFilesPtr current = m_current.load(std::memory_order_acquire);
+        while (!current || current->version < files->version) {
+            if (m_current.compare_exchange_weak(current, files, std::memory_order_acq_rel)) {
+                return;
+            }
+        }
+#else
+        QMutexLocker locker(&m_mutex);
+        if (!m_current || m_current->version < files->version) {
+            m_current = files;
+        }
+#endif
+    }
+
+private:
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<GlobalFilesPtr> m_current;
+#else
+    mutable QBasicMutex m_mutex; // only held to copy the pointer
+    GlobalFilesPtr m_current;
+#endif
+};
+}
+Q_GLOBAL_STATIC(PublishedGlobalFiles, s_globalFiles)
+static std::atomic<quint64> s_globalFilesLookups{0};
 Q_GLOBAL_STATIC_WITH_ARGS(QString, sGlobalFileName, (QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QLatin1String("/kdeglobals")))
 
+namespace
+{
+// Where QStandardPaths found the files of a cascade, see locateCascade()
+struct CascadeLookup {
+    QStringList locations; // the standard locations searched
+    QList<qint64> stamps; // the modification time of the directory of the file in each location
+    QStringList files; // in the order of QStandardPaths::locateAll()
+    QStringList canonicalFiles;
+};
+
+struct CascadeCache {
+    QMutex mutex;
+    QHash<std::pair<int, QString>, CascadeLookup> lookups;
+};
+}
+Q_GLOBAL_STATIC(CascadeCache, s_cascadeCache)
+
+// Adding or removing a file changes the modification time of its directory. Modification
+// times get rounded, so if a directory was changed within the last couple of seconds,
+// another change might still not make a difference: @p recent is set then.
+static QList<qint64> cascadeStamps(const QStringList &locations, const QString &fileName, bool *recent)
+{
+    const qsizetype slash = fileName.lastIndexOf(QLatin1Char('/'));
+    const QString subdir = slash >= 0 ? QLatin1Char('/') + fileName.left(slash) : QString();
+    const qint64 recently = QDateTime::currentMSecsSinceEpoch() - 2000;
+
+    QList<qint64> stamps;
+    stamps.reserve(locations.size());
+    *recent = false;
+    for (const QString &location : locations) {
+        const QDateTime modified = QFileInfo(location + subdir).lastModified();
+        const qint64 stamp = modified.isValid() ? modified.toMSecsSinceEpoch() : -1;
+        *recent = *recent || stamp >= recently;
+        stamps.append(stamp);
+    }
+    return stamps;
+}
+
+// Like QStandardPaths::locateAll(), but in the locations that have a KConfigDefaultsBundle the
+// files are looked up in the bundle, which knows their canonical paths, too. Returns false,
+// leaving @p lookup as it is, if none of the locations has one.
+static bool locateBundled(const QString &fileName, CascadeLookup *lookup)
+{
+    const qsizetype slash = fileName.lastIndexOf(QLatin1Char('/'));
+    const QString subdir = slash >= 0 ? QLatin1Char('/') + fileName.left(slash) : QString();
+    const QStringView name = QStringView(fileName).mid(slash + 1);
+
+    QList<std::shared_ptr<const KConfigDefaultsBundle>> bundles;
+    bundles.reserve(lookup->locations.size());
+    bool bundled = false;
+    for (const QString &location : std::as_const(lookup->locations)) {
+        bundles.append(KConfigDefaultsBundle::open(location + subdir));
+        bundled = bundled || bundles.last();
+    }
+    if (!bundled) {
+        return false;
+    }
+
+    for (qsizetype i = 0; i < bundles.size(); ++i) {
+        const QString file = lookup->locations.at(i) + QLatin1Char('/') + fileName;
+        if (const auto &bundle = bundles.at(i)) {
+            const QString canonicalFile = bundle->canonicalFilePath(name);
+            if (!canonicalFile.isNull()) {
+                lookup->files.append(file);
+                lookup->canonicalFiles.append(canonicalFile);
+            }
+        } else if (const QFileInfo info(file); info.isFile()) {
+            lookup->files.append(file);
+            lookup->canonicalFiles.append(info.canonicalFilePath());
+        }
+    }
+    return true;
+}
+
+// Returns what QStandardPaths::locateAll() returns, or with @p canonical the canonical
+// paths of those files. The lookups are shared by all the KConfig objects of the process,
+// and only repeated once one of the directories the files are looked up in changes:
+// checking those takes one stat() per location, instead of the stat() and the
+// many lstat() of QFileInfo::canonicalFilePath() for each file found.
+static QStringList locateCascade(QStandardPaths::StandardLocation type, const QString &fileName, bool canonical)
+{
+    const QStringList locations = QStandardPaths::standardLocations(type);
+    bool recent = false;
+    const QList<qint64> stamps = cascadeStamps(locations, fileName, &recent);
+    const std::pair<int, QString> key(type, fileName);
+
+    CascadeCache &cache = *s_cascadeCache;
+    {
+        QMutexLocker locker(&cache.mutex);
+        const auto it = cache.lookups.constFind(key);
+        if (it != cache.lookups.constEnd() && it->locations == locations && it->stamps == stamps) {
+            return canonical ? it->canonicalFiles : it->files;
+        }
+    }
+
+    CascadeLookup lookup{locations, stamps, {}, {}};
+    if (!locateBundled(fileName, &lookup)) {
+        lookup.files = QStandardPaths::locateAll(type, fileName);
+        lookup.canonicalFiles.reserve(lookup.files.size());
+        for (const QString &file : std::as_const(lookup.files)) {
+            lookup.canonicalFiles.append(QFileInfo(file).canonicalFilePath());
+        }
+    }
+    const QStringList result = canonical ? lookup.canonicalFiles : lookup.files;
+    if (!recent) {
+        QMutexLocker locker(&cache.mutex);
+        cache.lookups.insert(key, std::move(lookup));
+    }
+    return result;
+}
+
+// Cascades are parsed in parallel in here, see KConfigPrivate::parseCascade()
+Q_GLOBAL_STATIC(QThreadPool, sParseThreadPool)
+
 using ParseCacheKey = std::pair<QStringList, QString>;
 struct ParseCacheValue {
+    // every value is decoded already, the map is only read while its groups are shared
     KEntryMap entries;
     QDateTime parseTime;
+    bool watched = false; // all the files are watched and unchanged since parseTime
 };
-using ParseCache = QThreadStorage<QCache<ParseCacheKey, ParseCacheValue>>;
+namespace
+{
+struct ParseCache {
+    ParseCache()
+    {
+        bool ok = false;
+        const qsizetype kib = qEnvironmentVariableIntValue("KCONFIG_GLOBAL_PARSE_CACHE_SIZE", &ok);
+        cache.setMaxCost(ok ? kib * 1024 : 4 * 1024 * 1024);
+        watch = qEnvironmentVariableIntValue("KCONFIG_GLOBAL_PARSE_CACHE_WATCH") != 0;
+    }
+
+    void remove(const QString &file)
+    {
+        const QList<ParseCacheKey> keys = cache.keys();
+        for (const ParseCacheKey &key : keys) {
+            if (key.first.contains(file)) {
+                cache.remove(key);
+            }
+        }
+    }
+    // Watches the files of @p key, called in the thread of the application
+    void watchFiles(const ParseCacheKey &key);
+
+    QMutex mutex;
+    QCache<ParseCacheKey, ParseCacheValue> cache;
+    qint64 hits = 0;
+    qint64 misses = 0;
+    qint64 watchedHits = 0;
+    bool watch = false;
+    QPointer<QFileSystemWatcher> watcher; // lives in the thread of the application
+};
+}
 Q_GLOBAL_STATIC(ParseCache, sGlobalParse)
 
+void ParseCache::watchFiles(const ParseCacheKey &key)
+{
+    if (!watcher) {
+        watcher = new QFileSystemWatcher(QCoreApplication::instance());
+        QObject::connect(watcher, &QFileSystemWatcher::fileChanged, watcher, [this](const QString &file) {
+            QMutexLocker locker(&mutex);
+            remove(file);
+        });
+    }
+
+    QStringList missing;
+    const QStringList watchedFiles = watcher->files();
+    for (const QString &file : key.first) {
+        if (!watchedFiles.contains(file)) {
+            missing.append(file);
+        }
+    }
+    // files replaced by a rename are dropped by the watcher, those fail if they are gone
+    if (!missing.isEmpty() && !watcher->addPaths(missing).isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    ParseCacheValue *value = cache.object(key);
+    if (!value) {
+        return;
+    }
+    // a change between the parse and now wasn't seen by the watcher
+    for (const QString &file : key.first) {
+        if (value->parseTime < QFileInfo(file).lastModified()) {
+            cache.remove(key);
+            return;
+        }
+    }
+    value->watched = true;
+}
+
+// A rough estimate of the memory used by @p map, for the budget of sGlobalParse
+static qsizetype parseCost(const KEntryMap &map)
+{
+    qsizetype cost = 0;
+    for (auto it = map.cbegin(), end = map.cend(); it != end; ++it) {
+        cost += 2 * sizeof(KEntryKey) + sizeof(KEntry) + it.key().mKey.size();
+        if (!it->isInline()) {
+            cost += it->rawValue().size();
+        }
+    }
+    return cost;
+}
+
+KConfigGlobalParseCache::Statistics KConfigGlobalParseCache::statistics()
+{
+    ParseCache &parseCache = *sGlobalParse;
+    QMutexLocker locker(&parseCache.mutex);
+    Statistics statistics;
+    statistics.hits = parseCache.hits;
+    statistics.misses = parseCache.misses;
+    statistics.watchedHits = parseCache.watchedHits;
+    statistics.size = parseCache.cache.size();
+    statistics.cost = parseCache.cache.totalCost();
+    statistics.budget = parseCache.cache.maxCost();
+    return statistics;
+}
+
+void KConfigGlobalParseCache::setBudget(qsizetype bytes)
+{
+    ParseCache &parseCache = *sGlobalParse;
+    QMutexLocker locker(&parseCache.mutex);
+    parseCache.cache.setMaxCost(bytes);
+}
+
+void KConfigGlobalParseCache::setWatchFiles(bool watch)
+{
+    ParseCache &parseCache = *sGlobalParse;
+    QMutexLocker locker(&parseCache.mutex);
+    parseCache.watch = watch;
+}
+
+void KConfigGlobalParseCache::invalidate(const QString &file)
+{
+    ParseCache &parseCache = *sGlobalParse;
+    QMutexLocker locker(&parseCache.mutex);
+    parseCache.remove(file);
+}
+
 #ifndef Q_OS_WIN
 static const Qt::CaseSensitivity sPathCaseSensitivity = Qt::CaseSensitive;
 #else
@@ -108,6 +406,62 @@ KConfigPrivate::KConfigPrivate(KConfig::ConfigAssociation association, KConfig::
     setLocale(QLocale().name());
 }
 
+KConfigBackend::WriteOptions KConfigPrivate::writeOptions() const
+{
+    KConfigBackend::WriteOptions options;
+    if (qEnvironmentVariableIntValue("KCONFIG_OPTIMISTIC_WRITES") == 1) {
+        options |= KConfigBackend::WriteOptimistic;
+    }
+    if (durability != KConfig::Durable) {
+        options |= KConfigBackend::WriteNoFsync;
+    }
+    if (durability == KConfig::Journaled) {
+        options |= KConfigBackend::WriteJournal;
+    }
+    if (openFlags & KConfig::ShardedGroups) {
+        options |= KConfigBackend::WriteSharded;
+    }
+    return options;
+}
+
+void KConfigPrivate::compactJournal()
+{
+    if (configState != KConfigBase::ReadWrite || !QFileInfo::exists(KConfigIniBackend::journalPath(mBackend->filePath()))) {
+        return;
+    }
+    if (!lockLocal()) {
+        qCWarning(KCONFIG_CORE_LOG) << "couldn't lock local file";
+        return;
+    }
+    // without dirty entries, the file is just merged with the journal
+    mBackend->writeConfig(locale.toUtf8(), entryMap, writeOptions() & ~KConfigBackend::WriteJournal);
+    mBackend->unlock();
+}
+
+bool KConfigPrivate::scheduleWriteBehind(KConfig *q)
+{
+    if (writingBehind || !QAbstractEventDispatcher::instance()) {
+        return false; // nothing would run the timer
+    }
+    if (!writeBehindTimer) {
+        writeBehindTimer = std::make_unique<QTimer>();
+        writeBehindTimer->setSingleShot(true);
+        writeBehindTimer->setInterval(writeBehindInterval);
+        QObject::connect(writeBehindTimer.get(), &QTimer::timeout, [this, q]() {
+            writingBehind = true;
+            q->sync();
+            writingBehind = false;
+        });
+    } else if (writeBehindTimer->thread() != QThread::currentThread()) {
+        return false;
+    }
+    // not restarted by further calls, so that a config changed all the time is still written
+    if (!writeBehindTimer->isActive()) {
+        writeBehindTimer->start();
+    }
+    return true;
+}
+
 bool KConfigPrivate::lockLocal()
 {
     if (mBackend) {
@@ -117,15 +471,10 @@ bool KConfigPrivate::lockLocal()
     return true;
 }
 
-static bool isGroupOrSubGroupMatch(KEntryMapConstIterator entryMapIt, const QByteArray &group)
-{
-    const QByteArray &entryGroup = entryMapIt.key().mGroup;
-    Q_ASSERT_X(entryGroup.startsWith(group), Q_FUNC_INFO, "Precondition");
-    return entryGroup.size() == group.size() || entryGroup[group.size()] == '\x1d';
-}
-
 void KConfigPrivate::copyGroup(const QByteArray &source, const QByteArray &destination, KConfigGroup *otherGroup, KConfigBase::WriteConfigFlags flags) const
 {
+    loadLazyGroups(source);
+    otherGroup->config()->d_ptr->loadLazyGroups(destination);
     KEntryMap &otherMap = otherGroup->config()->d_ptr->entryMap;
     const bool sameName = (destination == source);
 
@@ -134,12 +483,10 @@ void KConfigPrivate::copyGroup(const QByteArray &source, const QByteArray &desti
     // as dirty erroneously
     bool dirtied = false;
 
-    entryMap.forEachEntryWhoseGroupStartsWith(source, [&source, &destination, flags, &otherMap, sameName, &dirtied](KEntryMapConstIterator entryMapIt) {
-        // don't copy groups that start with the same prefix, but are not sub-groups
-        if (!isGroupOrSubGroupMatch(entryMapIt, source)) {
-            return;
-        }
+    // otherMap may be entryMap itself, and inserting into it invalidates the iterators
+    QList<std::pair<KEntryKey, KEntry>> copies;
 
+    entryMap.forEachEntryInGroupTree(source, [&source, &destination, flags, &copies, sameName, &dirtied](KEntryMapConstIterator entryMapIt) {
         KEntryKey newKey = entryMapIt.key();
 
         if (flags & KConfigBase::Localized) {
@@ -161,9 +508,23 @@ void KConfigPrivate::copyGroup(const QByteArray &source, const QByteArray &desti
             entry.bNotify = true;
         }
 
-        otherMap[newKey] = entry;
+        if (entry.bSharesDefault) {
+            // copy the default explicitly, the other map may have a different one for the key
+            KEntryKey defaultKey = newKey;
+            defaultKey.bDefault = true;
+            KEntry defaultEntry = entry;
+            defaultEntry.bSharesDefault = false;
+            copies.append({defaultKey, defaultEntry});
+            entry.bSharesDefault = false;
+        }
+
+        copies.append({newKey, entry});
     });
 
+    for (const auto &[key, entry] : std::as_const(copies)) {
+        otherMap[key] = entry;
+    }
+
     if (dirtied) {
         otherGroup->config()->d_ptr->bDirty = true;
     }
@@ -230,6 +591,79 @@ QString KConfigPrivate::expandString(const QString &value)
     return aValue;
 }
 
+QString KConfigPrivate::expandCached(const QString &value) const
+{
+    if (!value.contains(QLatin1Char('$'))) {
+        return value;
+    }
+    auto it = expandedValues.constFind(value);
+    if (it == expandedValues.cend()) {
+        it = expandedValues.insert(value, expandString(value));
+    }
+    return it.value();
+}
+
+void KConfig::invalidateExpansions()
+{
+    Q_D(KConfig);
+    d->dropCachedValues(); // readCachedEntry() may have kept expanded strings, too
+    d->logReset();
+}
+
+quint64 KConfig::generation() const
+{
+    Q_D(const KConfig);
+    return d->generation;
+}
+
+quint64 KConfig::groupGeneration(const QString &group) const
+{
+    Q_D(const KConfig);
+    const QByteArray name = group.isEmpty() ? QByteArrayLiteral("<default>") : group.toUtf8();
+    return d->groupGenerations.value(name, d->resetGeneration);
+}
+
+QHash<QString, QByteArrayList> KConfig::changesSince(quint64 generation, bool *complete) const
+{
+    Q_D(const KConfig);
+    QHash<QString, QByteArrayList> changes;
+    if (generation < d->changeLogStart) {
+        if (complete) {
+            *complete = false;
+        }
+        return changes;
+    }
+    if (complete) {
+        *complete = true;
+    }
+    // the log is in the order of the generations, the newest changes come last
+    for (auto it = d->changeLog.crbegin(); it != d->changeLog.crend() && it->generation > generation; ++it) {
+        QByteArrayList &keys = changes[it->group == "<default>" ? QString() : QString::fromUtf8(it->group)];
+        if (!it->key.isEmpty() && !keys.contains(it->key)) {
+            keys.append(it->key);
+        }
+    }
+    return changes;
+}
+
+void KConfigPrivate::logChange(const QByteArray &group, const QByteArray &key)
+{
+    groupGenerations.insert(group, generation);
+    changeLog.push_back({generation, group, key});
+    if (changeLog.size() > changeLogSize) {
+        changeLogStart = changeLog.front().generation;
+        changeLog.pop_front();
+    }
+}
+
+void KConfigPrivate::logReset()
+{
+    changeLog.clear();
+    groupGenerations.clear();
+    changeLogStart = generation;
+    resetGeneration = generation;
+}
+
 KConfig::KConfig(KConfig::ConfigAssociation association, const QString &file, OpenFlags mode, QStandardPaths::StandardLocation resourceType)
     : d_ptr(new KConfigPrivate(association, mode, resourceType))
 {
@@ -267,9 +701,18 @@ KConfig::KConfig(KConfigPrivate &d)
 KConfig::~KConfig()
 {
     Q_D(KConfig);
-    if (d->bDirty && (d->mBackend && d->mBackend->ref.loadRelaxed() == 1)) {
+    d->writingBehind = true;
+    const bool lastUser = d->mBackend && d->mBackend->ref.loadRelaxed() == 1;
+    const bool journaled = d->durability == Journaled;
+    if (lastUser && journaled) {
+        d->durability = RelaxedNoFsync; // what is left is written to the file itself
+    }
+    if (d->bDirty && lastUser) {
         sync();
     }
+    if (lastUser && journaled) {
+        d->compactJournal();
+    }
     delete d;
 }
 
@@ -278,22 +721,12 @@ static bool isNonDeletedKey(KEntryMapConstIterator entryMapIt)
     return !entryMapIt.key().mKey.isNull() && !entryMapIt->bDeleted;
 }
 
-static int findFirstGroupEndPos(const QByteArray &groupFullName, int from = 0)
-{
-    const auto index = groupFullName.indexOf('\x1d', from);
-    return index == -1 ? groupFullName.size() : index;
-}
-
-// std::string_view is used because QByteArrayView does not exist in Qt 5.
-// std::unordered_set rather than QSet is used because there is no qHash() overload for std::string_view in Qt 5.
-using ByteArrayViewSet = std::unordered_set<std::string_view>;
-
-static QStringList stringListFromUtf8Collection(const ByteArrayViewSet &source)
+static QStringList stringListFromUtf8(const QList<QByteArrayView> &source)
 {
     QStringList list;
     list.reserve(source.size());
-    std::transform(source.cbegin(), source.cend(), std::back_inserter(list), [](std::string_view view) {
-        return QString::fromUtf8(view.data(), view.size());
+    std::transform(source.cbegin(), source.cend(), std::back_inserter(list), [](QByteArrayView view) {
+        return QString::fromUtf8(view);
     });
     return list;
 }
@@ -301,61 +734,39 @@ static QStringList stringListFromUtf8Collection(const ByteArrayViewSet &source)
 QStringList KConfig::groupList() const
 {
     Q_D(const KConfig);
-    ByteArrayViewSet groups;
-
-    for (auto entryMapIt = d->entryMap.cbegin(); entryMapIt != d->entryMap.cend(); ++entryMapIt) {
-        const QByteArray &group = entryMapIt.key().mGroup;
-        if (isNonDeletedKey(entryMapIt) && !group.isEmpty() && group != "<default>" && group != "$Version") {
-            groups.emplace(group.constData(), findFirstGroupEndPos(group));
-        }
-    }
-
-    return stringListFromUtf8Collection(groups);
+    d->loadLazyGroups();
+    QList<QByteArrayView> groups = d->entryMap.subGroupNames({});
+    groups.removeIf([](QByteArrayView group) {
+        return group.isEmpty() || group == "<default>" || group == "$Version";
+    });
+    return stringListFromUtf8(groups);
 }
 
 QStringList KConfigPrivate::groupList(const QByteArray &group) const
 {
-    const QByteArray theGroup = group + '\x1d';
-    ByteArrayViewSet groups;
-
-    entryMap.forEachEntryWhoseGroupStartsWith(theGroup, [&theGroup, &groups](KEntryMapConstIterator entryMapIt) {
-        if (isNonDeletedKey(entryMapIt)) {
-            const QByteArray &entryGroup = entryMapIt.key().mGroup;
-            const auto subgroupStartPos = theGroup.size();
-            const auto subgroupEndPos = findFirstGroupEndPos(entryGroup, subgroupStartPos);
-            groups.emplace(entryGroup.constData() + subgroupStartPos, subgroupEndPos - subgroupStartPos);
-        }
-    });
-
-    return stringListFromUtf8Collection(groups);
+    loadLazyGroups(group);
+    return stringListFromUtf8(entryMap.subGroupNames(group));
 }
 
 /// Returns @p parentGroup itself, all its subgroups, subsubgroups, and so on, including deleted groups.
 QSet<QByteArray> KConfigPrivate::allSubGroups(const QByteArray &parentGroup) const
 {
-    QSet<QByteArray> groups;
-
-    entryMap.forEachEntryWhoseGroupStartsWith(parentGroup, [&parentGroup, &groups](KEntryMapConstIterator entryMapIt) {
-        const KEntryKey &key = entryMapIt.key();
-        if (key.mKey.isNull() && isGroupOrSubGroupMatch(entryMapIt, parentGroup)) {
-            groups << key.mGroup;
-        }
-    });
-
-    return groups;
+    loadLazyGroups(parentGroup);
+    const QByteArrayList groups = entryMap.groupAndSubGroupNames(parentGroup);
+    return QSet<QByteArray>(groups.cbegin(), groups.cend());
 }
 
 bool KConfigPrivate::hasNonDeletedEntries(const QByteArray &group) const
 {
-    return entryMap.anyEntryWhoseGroupStartsWith(group, [&group](KEntryMapConstIterator entryMapIt) {
-        return isGroupOrSubGroupMatch(entryMapIt, group) && isNonDeletedKey(entryMapIt);
-    });
+    loadLazyGroups(group);
+    return entryMap.hasNonDeletedEntries(group);
 }
 
 QStringList KConfigPrivate::keyListImpl(const QByteArray &theGroup) const
 {
     QStringList keys;
 
+    loadLazyGroup(theGroup);
     const auto theEnd = entryMap.constEnd();
     auto it = entryMap.constFindEntry(theGroup);
     if (it != theEnd) {
@@ -386,6 +797,7 @@ QMap<QString, QString> KConfig::entryMap(const QString &aGroup) const
     QMap<QString, QString> theMap;
     const QByteArray theGroup(aGroup.isEmpty() ? "<default>" : aGroup.toUtf8());
 
+    d->loadLazyGroup(theGroup);
     const auto theEnd = d->entryMap.constEnd();
     auto it = d->entryMap.constFindEntry(theGroup, {}, {});
     if (it != theEnd) {
@@ -399,9 +811,9 @@ QMap<QString, QString> KConfig::entryMap(const QString &aGroup) const
                 // with the non-localized entry
                 if (!theMap.contains(key)) {
                     if (it->bExpand) {
-                        theMap.insert(key, KConfigPrivate::expandString(QString::fromUtf8(it->mValue.constData())));
+                        theMap.insert(key, d->expandCached(QString::fromUtf8(it->value())));
                     } else {
-                        theMap.insert(key, QString::fromUtf8(it->mValue.constData()));
+                        theMap.insert(key, QString::fromUtf8(it->value()));
                     }
                 }
             }
@@ -411,6 +823,59 @@ QMap<QString, QString> KConfig::entryMap(const QString &aGroup) const
     return theMap;
 }
 
+// Finds out which of the files the dirty entries of @p map go to, and which
+// changes clients have to be notified about
+static void collectDirtyEntries(KEntryMap &map,
+                                bool *writeLocals,
+                                bool *writeGlobals,
+                                QHash<QString, QByteArrayList> *notifyGroupsLocal,
+                                QHash<QString, QByteArrayList> *notifyGroupsGlobal,
+                                QList<KEntryKey> *dirtyKeys = nullptr)
+{
+    map.forEachDirtyEntry([&](KEntryMapConstIterator it) {
+        const KEntry &e = it.value();
+        if (e.bGlobal) {
+            *writeGlobals = true;
+            if (e.bNotify) {
+                (*notifyGroupsGlobal)[QString::fromUtf8(it.key().mGroup)] << it.key().mKey;
+            }
+        } else {
+            *writeLocals = true;
+            if (e.bNotify) {
+                (*notifyGroupsLocal)[QString::fromUtf8(it.key().mGroup)] << it.key().mKey;
+            }
+        }
+        if (dirtyKeys) {
+            dirtyKeys->append(it.key());
+        }
+    });
+}
+
+// The new values of the entries in @p changes, as ConfigValuesChanged carries them, see KConfigNotifyTransport
+static QHash<QString, QByteArrayList> notifiedValues(const KEntryMap &map, const QHash<QString, QByteArrayList> &changes)
+{
+    QHash<QString, QByteArrayList> values;
+    if (!KConfigNotifications::includeValues()) {
+        return values;
+    }
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        const QByteArray group = it.key().toUtf8();
+        QByteArrayList &groupValues = values[it.key()];
+        for (const QByteArray &key : it.value()) {
+            groupValues.append(key);
+            const KEntryMapConstIterator entry = map.constFindEntry(group, key);
+            // a localized entry is only of use to the readers with the same locale
+            if (entry == map.constEnd() || entry->bDeleted || entry->bReverted || entry->bSharesDefault
+                || map.constFindEntry(group, key, KEntryMap::SearchLocalized) != entry) {
+                groupValues.append(QByteArrayLiteral("-"));
+            } else {
+                groupValues.append((entry->bExpand ? '$' : '=') + entry->toByteArray());
+            }
+        }
+    }
+    return values;
+}
+
 bool KConfig::sync()
 {
     Q_D(KConfig);
@@ -420,17 +885,36 @@ bool KConfig::sync()
         return false;
     }
 
+    if (d->durability == WriteBehind && d->bDirty && d->scheduleWriteBehind(this)) {
+        return true;
+    }
+    if (d->writeBehindTimer) {
+        d->writeBehindTimer->stop();
+    }
+
     QHash<QString, QByteArrayList> notifyGroupsLocal;
     QHash<QString, QByteArrayList> notifyGroupsGlobal;
 
+    // with KCONFIG_TRACE, the locking, writing and notifying are all part of the change
+    const KConfigTrace::ChangeScope change(d->bDirty ? KConfigTrace::currentOrNewChange() : QString());
+    const KConfigTrace::Span span("sync", name());
+
+    // wait for a background sync still writing older changes, see KConfigBackgroundSync
+    d->syncSemaphore.acquire();
+    QSemaphoreReleaser releaser(d->syncSemaphore);
+
     if (d->bDirty && d->mBackend) {
+        KConfigTrace::count(KConfigTrace::Syncs);
         const QByteArray utf8Locale(locale().toUtf8());
+        d->dropCachedValues(); // writing may mark reverted entries deleted
 
         // Create the containing dir, maybe it wasn't there
         d->mBackend->createEnclosing();
 
-        // lock the local file
-        if (d->configState == ReadWrite && !d->lockLocal()) {
+        // lock the local file, unless the files are only replaced if nobody changed them meanwhile
+        const KConfigBackend::WriteOptions writeOptions = d->writeOptions();
+        const bool lock = d->configState == ReadWrite && !(writeOptions & KConfigBackend::WriteOptimistic);
+        if (lock && !d->lockLocal()) {
             qCWarning(KCONFIG_CORE_LOG) << "couldn't lock local file";
             return false;
         }
@@ -438,29 +922,13 @@ bool KConfig::sync()
         // Rewrite global/local config only if there is a dirty entry in it.
         bool writeGlobals = false;
         bool writeLocals = false;
-
-        for (auto it = d->entryMap.constBegin(); it != d->entryMap.constEnd(); ++it) {
-            auto e = it.value();
-            if (e.bDirty) {
-                if (e.bGlobal) {
-                    writeGlobals = true;
-                    if (e.bNotify) {
-                        notifyGroupsGlobal[QString::fromUtf8(it.key().mGroup)] << it.key().mKey;
-                    }
-                } else {
-                    writeLocals = true;
-                    if (e.bNotify) {
-                        notifyGroupsLocal[QString::fromUtf8(it.key().mGroup)] << it.key().mKey;
-                    }
-                }
-            }
-        }
+        collectDirtyEntries(d->entryMap, &writeLocals, &writeGlobals, &notifyGroupsLocal, &notifyGroupsGlobal);
 
         d->bDirty = false; // will revert to true if a config write fails
 
         if (d->wantGlobals() && writeGlobals) {
             QExplicitlySharedDataPointer<KConfigBackend> tmp = KConfigBackend::create(*sGlobalFileName);
-            if (d->configState == ReadWrite && !tmp->lock()) {
+            if (lock && !tmp->lock()) {
                 qCWarning(KCONFIG_CORE_LOG) << "couldn't lock global file";
 
                 // unlock the local config if we're returning early
@@ -471,48 +939,521 @@ bool KConfig::sync()
                 d->bDirty = true;
                 return false;
             }
-            if (!tmp->writeConfig(utf8Locale, d->entryMap, KConfigBackend::WriteGlobal)) {
+            if (!tmp->writeConfig(utf8Locale, d->entryMap, writeOptions | KConfigBackend::WriteGlobal)) {
                 d->bDirty = true;
             }
+            KConfigGlobalParseCache::invalidate(*sGlobalFileName);
             if (tmp->isLocked()) {
                 tmp->unlock();
             }
         }
 
         if (writeLocals) {
-            if (!d->mBackend->writeConfig(utf8Locale, d->entryMap, KConfigBackend::WriteOptions())) {
+            if (!d->mBackend->writeConfig(utf8Locale, d->entryMap, writeOptions)) {
                 d->bDirty = true;
             }
         }
         if (d->mBackend->isLocked()) {
             d->mBackend->unlock();
         }
+        if (!d->bDirty) {
+            KConfigSnapshotPrivate::forgetShared(name());
+        }
+    }
+
+    if (!notifyGroupsLocal.isEmpty()) {
+        d->notifyClients(notifyGroupsLocal, QLatin1Char('/') + name(), notifiedValues(d->entryMap, notifyGroupsLocal));
+    }
+    if (!notifyGroupsGlobal.isEmpty()) {
+        d->notifyClients(notifyGroupsGlobal, QStringLiteral("/kdeglobals"), notifiedValues(d->entryMap, notifyGroupsGlobal));
+    }
+
+    return !d->bDirty;
+}
+
+void KConfig::setDurability(Durability durability)
+{
+    Q_D(KConfig);
+    if (d->durability == durability) {
+        return;
+    }
+    const bool pending = d->writeBehindTimer && d->writeBehindTimer->isActive();
+    d->durability = durability;
+    if (pending) {
+        sync();
+    }
+}
+
+KConfig::Durability KConfig::durability() const
+{
+    Q_D(const KConfig);
+    return d->durability;
+}
+
+bool KConfigPrivate::takeSyncJob(SyncJob *job)
+{
+    if (!bDirty || !mBackend) {
+        return false;
+    }
+
+    job->localFile = mBackend->filePath();
+    job->globalFile = *sGlobalFileName;
+    job->locale = locale.toUtf8();
+    job->writeOptions = writeOptions();
+    job->lock = configState == KConfigBase::ReadWrite && !(job->writeOptions & KConfigBackend::WriteOptimistic);
+    job->entries = entryMap.takeDirtyEntries();
+    collectDirtyEntries(job->entries, &job->writeLocals, &job->writeGlobals, &job->notifyGroupsLocal, &job->notifyGroupsGlobal, &job->dirtyKeys);
+    job->writeGlobals = job->writeGlobals && wantGlobals();
+    job->name = fileName;
+
+    bDirty = false; // restoreSyncJob() reverts this if the write fails
+    return true;
+}
+
+bool KConfigPrivate::runSyncJob(SyncJob *job)
+{
+    QExplicitlySharedDataPointer<KConfigBackend> local = KConfigBackend::create(job->localFile);
+    local->createEnclosing();
+
+    // the same steps as KConfig::sync(), with backends of our own. A file held by
+    // another process doesn't keep a thread of the pool waiting, the job is tried again.
+    job->lockBusy = false;
+    if (job->lock && !local->tryLock(syncJobLockTimeout)) {
+        job->lockBusy = true;
+        job->succeeded = false;
+        return false;
+    }
+
+    job->succeeded = true;
+    if (job->writeGlobals) {
+        QExplicitlySharedDataPointer<KConfigBackend> global = KConfigBackend::create(job->globalFile);
+        if (job->lock && !global->tryLock(syncJobLockTimeout)) {
+            if (local->isLocked()) {
+                local->unlock();
+            }
+            job->lockBusy = true;
+            job->succeeded = false;
+            return false;
+        }
+        job->succeeded = global->writeConfig(job->locale, job->entries, job->writeOptions | KConfigBackend::WriteGlobal);
+        KConfigGlobalParseCache::invalidate(job->globalFile);
+        if (global->isLocked()) {
+            global->unlock();
+        }
+    }
+    if (job->writeLocals && !local->writeConfig(job->locale, job->entries, job->writeOptions)) {
+        job->succeeded = false;
+    }
+    if (local->isLocked()) {
+        local->unlock();
+    }
+    if (job->succeeded) {
+        KConfigSnapshotPrivate::forgetShared(job->name);
+    }
+
+    if (!job->notify) {
+        return job->succeeded;
+    }
+    if (!job->notifyGroupsLocal.isEmpty()) {
+        notifyClients(job->notifyGroupsLocal, QLatin1Char('/') + job->name, notifiedValues(job->entries, job->notifyGroupsLocal));
+    }
+    if (!job->notifyGroupsGlobal.isEmpty()) {
+        notifyClients(job->notifyGroupsGlobal, QStringLiteral("/kdeglobals"), notifiedValues(job->entries, job->notifyGroupsGlobal));
+    }
+    return job->succeeded;
+}
+
+void KConfigPrivate::restoreSyncJob(const SyncJob &job)
+{
+    for (const KEntryKey &key : job.dirtyKeys) {
+        const KEntryMapIterator it = entryMap.find(key);
+        if (it != entryMap.end()) {
+            it->bDirty = true;
+        }
+    }
+    bDirty = true;
+}
+
+namespace
+{
+// The changes collected by KConfigPrivate::notifyClients(), see KConfigNotifications
+struct PendingNotifications {
+    PendingNotifications()
+        : interval(qEnvironmentVariableIntValue("KCONFIG_NOTIFY_INTERVAL"))
+        , includeValues(qEnvironmentVariableIntValue("KCONFIG_NOTIFY_VALUES") == 1)
+    {
+    }
+
+    QMutex mutex;
+    int interval;
+    bool includeValues;
+    bool scheduled = false;
+    bool flushOnExit = false;
+    // the changed keys of each group, by the path of the signal
+    QHash<QString, QHash<QString, QByteArrayList>> changes;
+    // the same for the values, if they are included
+    QHash<QString, QHash<QString, QByteArrayList>> values;
+    // with KCONFIG_TRACE, the first change merged into the notification of each path
+    QHash<QString, QString> tracedChanges;
+};
+}
+Q_GLOBAL_STATIC(PendingNotifications, sPendingNotifications)
+
+static void sendNotification(const QHash<QString, QByteArrayList> &changes,
+                             const QString &path,
+                             const QHash<QString, QByteArrayList> &values,
+                             const QString &tracedChange)
+{
+    KConfigTrace::count(KConfigTrace::NotificationsSent);
+    const KConfigTrace::ChangeScope scope(tracedChange);
+    const KConfigTrace::Span span("notify", path);
+    if (KConfigNotifyTransport::kind() == KConfigNotifyTransport::File) {
+        KConfigNotifyTransport::writeFile(changes, path);
+        return;
+    }
+#if KCONFIG_USE_DBUS
+    qDBusRegisterMetaType<QByteArrayList>();
+
+    qDBusRegisterMetaType<QHash<QString, QByteArrayList>>();
+
+    // the watchers tracing changes take the id for the signals that follow
+    if (!tracedChange.isEmpty()) {
+        QDBusMessage message = QDBusMessage::createSignal(path, QStringLiteral("org.kde.kconfig.notify"), QStringLiteral("ConfigChangeTraced"));
+        message.setArguments({tracedChange});
+        QDBusConnection::sessionBus().send(message);
+    }
+
+    // first, watchers that take the values skip the ConfigChanged signal matching them
+    if (!values.isEmpty()) {
+        QDBusMessage message = QDBusMessage::createSignal(path, QStringLiteral("org.kde.kconfig.notify"), QStringLiteral("ConfigValuesChanged"));
+        message.setArguments({QVariant::fromValue(values)});
+        QDBusConnection::sessionBus().send(message);
+    }
+
+    QDBusMessage message = QDBusMessage::createSignal(path, QStringLiteral("org.kde.kconfig.notify"), QStringLiteral("ConfigChanged"));
+    message.setArguments({QVariant::fromValue(changes)});
+    QDBusConnection::sessionBus().send(message);
+#else
+    Q_UNUSED(values);
+#endif
+}
+
+// Adds the changed keys and the values of one notification to those of another for the same path
+static void mergeNotification(QHash<QString, QByteArrayList> *intoChanges,
+                              QHash<QString, QByteArrayList> *intoValues,
+                              const QHash<QString, QByteArrayList> &changes,
+                              const QHash<QString, QByteArrayList> &values)
+{
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        QByteArrayList &keys = (*intoChanges)[it.key()];
+        for (const QByteArray &key : it.value()) {
+            if (!keys.contains(key)) {
+                keys.append(key);
+            }
+        }
+    }
+    if (!intoValues) {
+        return;
+    }
+    // a later value of a key replaces the earlier one, in the order of the changed keys
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        QByteArrayList &groupValues = (*intoValues)[it.key()];
+        for (qsizetype i = 0; i + 1 < it.value().size(); i += 2) {
+            qsizetype j = 0;
+            while (j < groupValues.size() && groupValues.at(j) != it.value().at(i)) {
+                j += 2;
+            }
+            if (j < groupValues.size()) {
+                groupValues[j + 1] = it.value().at(i + 1);
+            } else {
+                groupValues << it.value().at(i) << it.value().at(i + 1);
+            }
+        }
+    }
+}
+
+void KConfigPrivate::notifyClients(const QHash<QString, QByteArrayList> &changes, const QString &path, const QHash<QString, QByteArrayList> &values)
+{
+    const QString tracedChange = KConfigTrace::currentOrNewChange();
+    PendingNotifications &pending = *sPendingNotifications;
+    QMutexLocker locker(&pending.mutex);
+    if (pending.interval <= 0 || !QCoreApplication::instance()) {
+        locker.unlock();
+        sendNotification(changes, path, values, tracedChange);
+        return;
+    }
+
+    mergeNotification(&pending.changes[path], values.isEmpty() ? nullptr : &pending.values[path], changes, values);
+    if (!tracedChange.isEmpty() && !pending.tracedChanges.contains(path)) {
+        pending.tracedChanges.insert(path, tracedChange);
+    }
+    if (pending.scheduled) {
+        return;
+    }
+    pending.scheduled = true;
+    if (!pending.flushOnExit) {
+        pending.flushOnExit = true;
+        qAddPostRoutine(KConfigNotifications::flush);
+    }
+    // the timer has to be started in a thread with an event loop
+    const int interval = pending.interval;
+    QMetaObject::invokeMethod(
+        QCoreApplication::instance(),
+        [interval]() {
+            QTimer::singleShot(interval, QCoreApplication::instance(), &KConfigNotifications::flush);
+        },
+        Qt::QueuedConnection);
+}
+
+bool KConfigPrivate::runSyncJobs(const QList<SyncJob *> &jobs)
+{
+    const KConfigTrace::ChangeScope change(KConfigTrace::currentOrNewChange());
+    const KConfigTrace::Span span("sync", jobs.isEmpty() ? QString() : jobs.first()->name);
+
+    // one backend for each file, locked in the order sync() locks them in: the local files
+    // by their paths, then the global ones. So neither two transactions nor a transaction and
+    // a sync() can each end up holding a lock the other waits for.
+    std::map<QString, QExplicitlySharedDataPointer<KConfigBackend>> backends;
+    std::map<QString, bool> lock;
+    std::set<QString> globalFiles;
+    for (SyncJob *job : jobs) {
+        // all the files are locked while any is written, waiting for nobody to change them makes no sense
+        if (job->writeOptions & KConfigBackend::WriteOptimistic) {
+            job->writeOptions.setFlag(KConfigBackend::WriteOptimistic, false);
+            job->lock = true;
+        }
+        if (job->writeLocals) {
+            backends.emplace(job->localFile, nullptr);
+            lock[job->localFile] = lock[job->localFile] || job->lock;
+        }
+        if (job->writeGlobals) {
+            backends.emplace(job->globalFile, nullptr);
+            lock[job->globalFile] = lock[job->globalFile] || job->lock;
+            globalFiles.insert(job->globalFile);
+        }
+    }
+    std::vector<QString> lockOrder;
+    lockOrder.reserve(backends.size());
+    for (const auto &[path, backend] : backends) {
+        if (!globalFiles.count(path)) {
+            lockOrder.push_back(path);
+        }
+    }
+    lockOrder.insert(lockOrder.end(), globalFiles.cbegin(), globalFiles.cend());
+
+    const auto unlockAll = [&backends]() {
+        for (auto &[path, backend] : backends) {
+            if (backend && backend->isLocked()) {
+                backend->unlock();
+            }
+        }
+    };
+    for (const QString &path : lockOrder) {
+        QExplicitlySharedDataPointer<KConfigBackend> &backend = backends[path];
+        backend = KConfigBackend::create(path);
+        backend->createEnclosing();
+        if (lock[path] && !backend->lock()) {
+            qCWarning(KCONFIG_CORE_LOG) << "couldn't lock" << path;
+            unlockAll();
+            for (SyncJob *job : jobs) {
+                job->succeeded = false;
+                job->lockBusy = true;
+            }
+            return false;
+        }
+    }
+
+    // the changes to each path, all sent at the end
+    std::map<QString, QHash<QString, QByteArrayList>> changes;
+    std::map<QString, QHash<QString, QByteArrayList>> values;
+    const auto collectChanges = [&changes, &values](const QString &path, const KEntryMap &entries, const QHash<QString, QByteArrayList> &groups) {
+        if (!groups.isEmpty()) {
+            mergeNotification(&changes[path], &values[path], groups, notifiedValues(entries, groups));
+        }
+    };
+
+    bool succeeded = true;
+    for (SyncJob *job : jobs) {
+        job->lockBusy = false;
+        job->succeeded = true;
+        if (job->writeGlobals) {
+            job->succeeded = backends[job->globalFile]->writeConfig(job->locale, job->entries, job->writeOptions | KConfigBackend::WriteGlobal);
+            KConfigGlobalParseCache::invalidate(job->globalFile);
+        }
+        if (job->writeLocals && !backends[job->localFile]->writeConfig(job->locale, job->entries, job->writeOptions)) {
+            job->succeeded = false;
+        }
+        if (job->succeeded) {
+            KConfigSnapshotPrivate::forgetShared(job->name);
+        }
+        succeeded = succeeded && job->succeeded;
+
+        collectChanges(QLatin1Char('/') + job->name, job->entries, job->notifyGroupsLocal);
+        collectChanges(QStringLiteral("/kdeglobals"), job->entries, job->notifyGroupsGlobal);
+    }
+    unlockAll();
+
+    for (const auto &[path, groups] : changes) {
+        notifyClients(groups, path, values[path]);
+    }
+    return succeeded;
+}
+
+bool KConfigPrivate::syncConfigs(const QList<KConfig *> &configs)
+{
+    struct Pending {
+        KConfig *config = nullptr;
+        SyncJob job;
+    };
+    std::vector<std::unique_ptr<Pending>> pending;
+    QList<KConfig *> oneByOne;
+    QSet<QString> files;
+    for (KConfig *config : configs) {
+        KConfigPrivate *const d = config->d_ptr;
+        if (!d->bDirty || config->isImmutable() || config->name().isEmpty()) {
+            continue;
+        }
+        if (d->writeBehindTimer) {
+            d->writeBehindTimer->stop();
+        }
+
+        auto entry = std::make_unique<Pending>();
+        entry->config = config;
+        // held until the job was written, like in KConfigBackgroundSync
+        d->syncSemaphore.acquire();
+        if (!d->takeSyncJob(&entry->job)) {
+            d->syncSemaphore.release();
+            continue;
+        }
+        // two jobs wouldn't merge their changes to the same file, the second one goes through sync()
+        const SyncJob &job = entry->job;
+        if ((job.writeLocals && files.contains(job.localFile)) || (job.writeGlobals && files.contains(job.globalFile))) {
+            d->restoreSyncJob(job);
+            d->syncSemaphore.release();
+            oneByOne.append(config);
+            continue;
+        }
+        if (job.writeLocals) {
+            files.insert(job.localFile);
+        }
+        if (job.writeGlobals) {
+            files.insert(job.globalFile);
+        }
+        entry->job.notify = false;
+        pending.push_back(std::move(entry));
     }
 
-    if (!notifyGroupsLocal.isEmpty()) {
-        d->notifyClients(notifyGroupsLocal, QLatin1Char('/') + name());
+    if (pending.size() == 1) {
+        runSyncJob(&pending.front()->job);
+    } else if (!pending.empty()) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(KConfigExitSync::maxThreads());
+        for (const auto &entry : pending) {
+            SyncJob *const job = &entry->job;
+            pool.start([job]() {
+                runSyncJob(job);
+            });
+        }
+        pool.waitForDone();
+    }
+
+    // the changes to each path, all sent at the end as in runSyncJobs()
+    std::map<QString, QHash<QString, QByteArrayList>> changes;
+    std::map<QString, QHash<QString, QByteArrayList>> values;
+    const auto collectChanges = [&changes, &values](const QString &path, const KEntryMap &entries, const QHash<QString, QByteArrayList> &groups) {
+        if (!groups.isEmpty()) {
+            mergeNotification(&changes[path], &values[path], groups, notifiedValues(entries, groups));
+        }
+    };
+    for (const auto &entry : pending) {
+        KConfigPrivate *const d = entry->config->d_ptr;
+        const SyncJob &job = entry->job;
+        if (job.succeeded) {
+            KConfigTrace::count(KConfigTrace::Syncs);
+            collectChanges(QLatin1Char('/') + job.name, job.entries, job.notifyGroupsLocal);
+            collectChanges(QStringLiteral("/kdeglobals"), job.entries, job.notifyGroupsGlobal);
+        } else {
+            // sync() waits for a locked file as long as it takes, or reports the failure
+            d->restoreSyncJob(job);
+            oneByOne.append(entry->config);
+        }
+        d->syncSemaphore.release();
+    }
+    for (const auto &[path, groups] : changes) {
+        notifyClients(groups, path, values[path]);
+    }
+
+    bool succeeded = true;
+    for (KConfig *config : std::as_const(oneByOne)) {
+        succeeded = config->sync() && succeeded;
+    }
+    return succeeded;
+}
+
+bool KConfigExitSync::syncAll(const QList<KConfig *> &configs)
+{
+    return KConfigPrivate::syncConfigs(configs);
+}
+
+int KConfigExitSync::maxThreads()
+{
+    // writing is mostly waiting for the disk, a few at once are enough to hide that
+    return std::clamp(QThread::idealThreadCount(), 1, 4);
+}
+
+void KConfigNotifications::setInterval(int msecs)
+{
+    PendingNotifications &pending = *sPendingNotifications;
+    QMutexLocker locker(&pending.mutex);
+    pending.interval = msecs;
+}
+
+void KConfigNotifications::setIncludeValues(bool include)
+{
+    PendingNotifications &pending = *sPendingNotifications;
+    QMutexLocker locker(&pending.mutex);
+    pending.includeValues = include;
+}
+
+bool KConfigNotifications::includeValues()
+{
+    PendingNotifications &pending = *sPendingNotifications;
+    QMutexLocker locker(&pending.mutex);
+    return pending.includeValues;
+}
+
+void KConfigNotifications::flush()
+{
+    if (!sPendingNotifications.exists()) {
+        return;
     }
-    if (!notifyGroupsGlobal.isEmpty()) {
-        d->notifyClients(notifyGroupsGlobal, QStringLiteral("/kdeglobals"));
+    QHash<QString, QHash<QString, QByteArrayList>> changes;
+    QHash<QString, QHash<QString, QByteArrayList>> values;
+    QHash<QString, QString> tracedChanges;
+    {
+        PendingNotifications &pending = *sPendingNotifications;
+        QMutexLocker locker(&pending.mutex);
+        changes.swap(pending.changes);
+        values.swap(pending.values);
+        tracedChanges.swap(pending.tracedChanges);
+        pending.scheduled = false;
+    }
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        sendNotification(it.value(), it.key(), values.value(it.key()), tracedChanges.value(it.key()));
     }
-
-    return !d->bDirty;
 }
 
-void KConfigPrivate::notifyClients(const QHash<QString, QByteArrayList> &changes, const QString &path)
+KConfigSnapshot KConfig::snapshot() const
 {
-#if KCONFIG_USE_DBUS
-    qDBusRegisterMetaType<QByteArrayList>();
-
-    qDBusRegisterMetaType<QHash<QString, QByteArrayList>>();
+    Q_D(const KConfig);
+    d->loadLazyGroups();
+    return KConfigSnapshot(new KConfigSnapshotPrivate(name(), d->entryMap, d->bReadDefaults));
+}
 
-    QDBusMessage message = QDBusMessage::createSignal(path, QStringLiteral("org.kde.kconfig.notify"), QStringLiteral("ConfigChanged"));
-    message.setArguments({QVariant::fromValue(changes)});
-    QDBusConnection::sessionBus().send(message);
-#else
-    Q_UNUSED(changes)
-    Q_UNUSED(path)
-#endif
+KConfigSnapshotPrivate *KConfigPrivate::groupSnapshot(const QByteArray &group) const
+{
+    loadLazyGroup(group);
+    return new KConfigSnapshotPrivate(fileName, entryMap.groupEntries(group), bReadDefaults);
 }
 
 void KConfig::markAsClean()
@@ -540,8 +1481,20 @@ void KConfig::checkUpdate(const QString &id, const QString &updateFile)
     const QString cfg_id = updateFile + QLatin1Char(':') + id;
     const QStringList ids = cg.readEntry("update_info", QStringList());
     if (!ids.contains(cfg_id)) {
-        QProcess::execute(QStringLiteral(KCONF_UPDATE_INSTALL_LOCATION), QStringList{QStringLiteral("--check"), updateFile});
-        reparseConfiguration();
+        Q_D(KConfig);
+        // opened the way kconf_update opens the files, the updates are applied to this config instead of to a copy of it
+        const bool inPlace = d->association == ConfigAssociation::NoAssociation && d->resourceType == QStandardPaths::GenericConfigLocation
+            && !d->fileName.isEmpty() && QDir::isRelativePath(d->fileName)
+            && (d->openFlags & ~OpenFlags(LazyLoading | CacheLocales)) == NoGlobals;
+
+        KonfUpdate::Options options;
+        options.check = updateFile;
+        {
+            KonfUpdate update(options, inPlace ? this : nullptr);
+        }
+        if (!inPlace) {
+            reparseConfiguration();
+        }
     }
 }
 
@@ -552,13 +1505,14 @@ KConfig *KConfig::copyTo(const QString &file, KConfig *config) const
         config = new KConfig(d_ptr->association, QString(), SimpleConfig, d->resourceType);
     }
     config->d_func()->changeFileName(file);
+    d->loadLazyGroups();
     config->d_func()->entryMap = d->entryMap;
     config->d_func()->bFileImmutable = false;
+    config->d_func()->dropCachedValues();
+    config->d_func()->logReset();
 
-    const KEntryMapIterator theEnd = config->d_func()->entryMap.end();
-    for (KEntryMapIterator it = config->d_func()->entryMap.begin(); it != theEnd; ++it) {
-        it->bDirty = true;
-    }
+    // the copy shares the entries of this config until either of them changes a group
+    config->d_func()->entryMap.markAllDirty();
     config->d_ptr->bDirty = true;
 
     return config;
@@ -611,6 +1565,147 @@ QString KConfig::mainConfigName()
     return appName + QLatin1String("rc");
 }
 
+KConfig::Statistics KConfig::statistics()
+{
+    using namespace KConfigTrace;
+    Statistics statistics;
+    statistics.filesParsed = value(FilesParsed);
+    statistics.bytesRead = value(BytesRead);
+    statistics.parseNanoseconds = value(ParseTime);
+    statistics.writeNanoseconds = value(WriteTime);
+    statistics.globalParseHits = value(GlobalParseHits);
+    statistics.globalParseMisses = value(GlobalParseMisses);
+    statistics.lookups = value(Lookups);
+    statistics.conversions = value(Conversions);
+    statistics.syncs = value(Syncs);
+    statistics.lockWaitNanoseconds = value(LockWaitTime);
+    statistics.lockContentions = value(LockContentions);
+    statistics.writeConflicts = value(WriteConflicts);
+    statistics.notificationsSent = value(NotificationsSent);
+    statistics.notificationsReceived = value(NotificationsReceived);
+    return statistics;
+}
+
+void KConfig::setStatisticsEnabled(bool enabled)
+{
+    KConfigTrace::setEnabled(enabled);
+}
+
+void KConfig::resetStatistics()
+{
+    KConfigTrace::reset();
+}
+
+KConfig::MemoryUsage KConfig::memoryUsage() const
+{
+    Q_D(const KConfig);
+    const KEntryMap::MemoryUsage entries = d->entryMap.memoryUsage();
+    MemoryUsage usage;
+    usage.name = name();
+    usage.groups = entries.groups;
+    usage.entries = entries.entries;
+    usage.keyBytes = entries.keyBytes;
+    usage.valueBytes = entries.valueBytes;
+    usage.sharedKeys = entries.sharedKeys;
+    usage.sharedValues = entries.sharedValues;
+    usage.sharedGroups = entries.sharedGroups;
+    usage.structureBytes = entries.structureBytes;
+
+    // the hashes themselves are left out, their nodes are of about the size of a key and a value
+    for (auto it = d->convertedValues.cbegin(); it != d->convertedValues.cend(); ++it) {
+        usage.cacheBytes += sizeof(KConfigPrivate::ConvertedKey) + sizeof(KConfigPrivate::ConvertedValue) + it.key().key.size();
+    }
+    for (auto it = d->expandedValues.cbegin(); it != d->expandedValues.cend(); ++it) {
+        usage.cacheBytes += (it.key().size() + it.value().size()) * sizeof(QChar);
+    }
+    for (auto it = d->lazyGroups.cbegin(); it != d->lazyGroups.cend(); ++it) {
+        // the buffers the segments point into are shared by all the groups of a file
+        usage.cacheBytes += it.key().size() + it->size() * sizeof(KConfigIniBackend::GroupSegment);
+    }
+    return usage;
+}
+
+qint64 KConfigPrivate::trimCaches()
+{
+    // the same estimate as memoryUsage()
+    qint64 freed = entryMap.squeeze();
+    for (auto it = convertedValues.cbegin(); it != convertedValues.cend(); ++it) {
+        freed += sizeof(ConvertedKey) + sizeof(ConvertedValue) + it.key().key.size();
+    }
+    for (auto it = expandedValues.cbegin(); it != expandedValues.cend(); ++it) {
+        freed += (it.key().size() + it.value().size()) * sizeof(QChar);
+    }
+    // the entries stay the same, unlike with dropCachedValues() the generation does too
+    convertedValues.clear();
+    convertedValues.squeeze();
+    expandedValues.clear();
+    expandedValues.squeeze();
+    return freed;
+}
+
+// Drops the parsed global files no config shares anymore, or with @p all every one of them
+static qint64 trimGlobalParseCache(bool all)
+{
+    if (!sGlobalParse.exists()) {
+        return 0;
+    }
+    ParseCache &parseCache = *sGlobalParse;
+    QMutexLocker locker(&parseCache.mutex);
+    const qsizetype cost = parseCache.cache.totalCost();
+    if (all) {
+        parseCache.cache.clear();
+    } else {
+        const QList<ParseCacheKey> keys = parseCache.cache.keys();
+        for (const ParseCacheKey &key : keys) {
+            const ParseCacheValue *value = parseCache.cache.object(key);
+            if (value && value->entries.memoryUsage().sharedGroups == 0) {
+                parseCache.cache.remove(key);
+            }
+        }
+    }
+    return cost - parseCache.cache.totalCost();
+}
+
+// Drops the lookups of locateCascade(), they are redone with a few stat() each
+static qint64 trimCascadeCache()
+{
+    if (!s_cascadeCache.exists()) {
+        return 0;
+    }
+    CascadeCache &cache = *s_cascadeCache;
+    QMutexLocker locker(&cache.mutex);
+    qint64 freed = 0;
+    for (auto it = cache.lookups.cbegin(); it != cache.lookups.cend(); ++it) {
+        freed += it.key().second.size() * sizeof(QChar) + it->stamps.size() * sizeof(qint64);
+        for (const QStringList *list : {&it->locations, &it->files, &it->canonicalFiles}) {
+            for (const QString &string : *list) {
+                freed += string.size() * sizeof(QChar);
+            }
+        }
+    }
+    cache.lookups.clear();
+    cache.lookups.squeeze();
+    return freed;
+}
+
+qint64 KConfig::trimCaches(TrimLevel level)
+{
+    const bool all = level == TrimAll;
+    qint64 freed = 0;
+    for (KConfig *config : sharedConfigsOfThread()) {
+        freed += config->d_func()->trimCaches();
+    }
+    freed += trimGlobalParseCache(all);
+    freed += KConfigDefaultsBundle::trimCache(all);
+    if (all) {
+        freed += KConfigSnapshotPrivate::trimShared();
+        freed += trimCascadeCache();
+    }
+    // last, the caches dropped above may have held the only other references to strings of the pool
+    freed += KConfigStringPool::trim();
+    return freed;
+}
+
 std::optional<QString> getPrefix(KConfig::ConfigAssociation association)
 {
     switch (association) {
@@ -691,13 +1786,27 @@ void KConfig::reparseConfiguration()
         sync();
     }
 
-    d->entryMap.clear();
+    // The new entries are compared with the ones they replace, so that changesSince() lists
+    // just what differs. With LazyLoading most groups are only indexed and can't be compared,
+    // then the arrays of the entries are filled again by the parse, instead of being freed
+    // and allocated again.
+    const bool compare = !(d->openFlags & LazyLoading) && !d->entryMap.isEmpty();
+    KEntryMap previous;
+    if (compare) {
+        previous = std::move(d->entryMap);
+        d->entryMap.clear();
+    } else {
+        d->entryMap.recycle();
+    }
+    d->lazyGroups.clear();
+    d->dropCachedValues();
 
     d->bFileImmutable = false;
 
-    {
-        QMutexLocker locker(&s_globalFilesMutex);
-        s_globalFiles()->clear();
+    d->globalFilesOutdated = true;
+    if (d->openFlags & CacheLocales) {
+        // taken before the files are read, a change while they are means they are read again
+        d->parsedStamps = d->fileStamps();
     }
 
     // Parse all desired files from the least to the most specific.
@@ -706,31 +1815,152 @@ void KConfig::reparseConfiguration()
     }
 
     d->parseConfigFiles();
+    d->entryMap.releaseRecycled();
+
+    const QList<KEntryKey> changes = compare ? d->entryMap.differences(previous) : QList<KEntryKey>();
+    if (!compare || std::size_t(changes.size()) > KConfigPrivate::changeLogSize) {
+        d->logReset();
+        return;
+    }
+    for (const KEntryKey &change : changes) {
+        d->logChange(change.mGroup, change.mKey);
+    }
 }
 
-QStringList KConfigPrivate::getGlobalFiles() const
+void KConfig::reparseGroups(const QStringList &groups)
 {
-    QMutexLocker locker(&s_globalFilesMutex);
-    if (s_globalFiles()->isEmpty()) {
-        const QStringList paths1 = QStandardPaths::locateAll(QStandardPaths::GenericConfigLocation, QStringLiteral("kdeglobals"));
-        const QStringList paths2 = QStandardPaths::locateAll(QStandardPaths::GenericConfigLocation, QStringLiteral("system.kdeglobals"));
+    Q_D(KConfig);
+    if (d->fileName.isEmpty()) {
+        return;
+    }
+
+    if (!d->isReadOnly() && d->bDirty) {
+        sync();
+    }
+
+    QList<QByteArray> names;
+    names.reserve(groups.size());
+    for (const QString &group : groups) {
+        names.append(group.isEmpty() ? QByteArrayLiteral("<default>") : group.toUtf8());
+    }
+
+    // The entries of a group may come from any file of the cascade, so all of them are
+    // read again, of the shards only those of the groups. LazyLoading only indexes them,
+    // just the wanted groups get parsed.
+    KEntryMap entries = std::move(d->entryMap);
+    KConfigIniBackend::GroupIndex lazyGroups = std::move(d->lazyGroups);
+    d->entryMap.clear();
+    d->lazyGroups.clear();
+    d->bFileImmutable = false;
+    d->globalFilesOutdated = true;
+
+    const OpenFlags openFlags = d->openFlags;
+    d->openFlags |= LazyLoading;
+    if (d->wantGlobals()) {
+        d->parseGlobalFiles();
+    }
+    d->parseConfigFiles(&names);
+    d->openFlags = openFlags;
+
+    std::swap(entries, d->entryMap);
+    std::swap(lazyGroups, d->lazyGroups);
+    const QByteArray utf8Locale = d->locale.toUtf8();
+    for (const QByteArray &name : std::as_const(names)) {
+        const auto it = lazyGroups.constFind(name);
+        if (it != lazyGroups.cend()) {
+            KConfigIniBackend::parseGroupSegments(utf8Locale, entries, name, it.value());
+        }
+        // the segments still indexed for the group are out of date
+        d->lazyGroups.remove(name);
+        d->entryMap.replaceGroup(name, entries);
+    }
+    d->dropCachedValues();
+    for (const QByteArray &name : std::as_const(names)) {
+        d->logChange(name);
+    }
+}
 
-        const bool useEtcKderc = !etc_kderc.isEmpty();
-        s_globalFiles()->reserve(paths1.size() + paths2.size() + (useEtcKderc ? 1 : 0));
+bool KConfigPrivate::applyNotifiedValues(const QString &group, const QByteArrayList &values, const QString &path)
+{
+    // Entries of other files may override the ones of the notified file: the extra files
+    // override the local file, which overrides kdeglobals.
+    const bool global = path == QLatin1String("/kdeglobals");
+    if (bFileImmutable || !extraFiles.isEmpty() || (!global && path != QLatin1Char('/') + fileName)) {
+        return false;
+    }
+    const QByteArray name = group.isEmpty() ? QByteArrayLiteral("<default>") : group.toUtf8();
+    loadLazyGroup(name);
+    if (entryMap.getEntryOption(name, {}, {}, KEntryMap::EntryImmutable)) {
+        return false;
+    }
+    for (qsizetype i = 0; i + 1 < values.size(); i += 2) {
+        const QByteArray &value = values.at(i + 1);
+        if (value.isEmpty() || (value.at(0) != '=' && value.at(0) != '$')) {
+            return false;
+        }
+        const KEntryMapConstIterator entry = entryMap.constFindEntry(name, values.at(i));
+        if (entry == entryMap.constEnd()) {
+            continue;
+        }
+        // a change of our own would be lost, and a localized entry still wins over the new value
+        if (entry->bImmutable || entryMap.getEntryOption(entry, KEntryMap::EntryDirty) || (global && !entry->bGlobal)
+            || entryMap.constFindEntry(name, values.at(i), KEntryMap::SearchLocalized) != entry) {
+            return false;
+        }
+    }
 
-        for (const QString &dir1 : paths1) {
-            s_globalFiles()->push_front(dir1);
+    // set as if the files had been parsed again
+    for (qsizetype i = 0; i + 1 < values.size(); i += 2) {
+        const QByteArray &value = values.at(i + 1);
+        KEntryMap::EntryOptions options;
+        if (global) {
+            options |= KEntryMap::EntryGlobal;
         }
-        for (const QString &dir2 : paths2) {
-            s_globalFiles()->push_front(dir2);
+        if (value.at(0) == '$') {
+            options |= KEntryMap::EntryExpansion;
         }
+        entryMap.setEntry(name, values.at(i), value.mid(1), options);
+    }
+    dropCachedValues();
+    for (qsizetype i = 0; i + 1 < values.size(); i += 2) {
+        logChange(name, values.at(i));
+    }
+    return true;
+}
 
-        if (useEtcKderc) {
-            s_globalFiles()->push_front(etc_kderc);
+QStringList KConfigPrivate::getGlobalFiles() const
+{
+    if (!globalFilesOutdated) {
+        if (const GlobalFilesPtr current = s_globalFiles->load()) {
+            return current->files;
         }
     }
+    globalFilesOutdated = false;
+
+    // Looked up by this config only, the others take the result once it is published.
+    // Cheap if the files are where they were found the last time.
+    auto lookup = std::make_shared<GlobalFiles>();
+    lookup->version = ++s_globalFilesLookups;
+    const QStringList paths1 = locateCascade(QStandardPaths::GenericConfigLocation, QStringLiteral("kdeglobals"), false);
+    const QStringList paths2 = locateCascade(QStandardPaths::GenericConfigLocation, QStringLiteral("system.kdeglobals"), false);
+
+    const bool useEtcKderc = !etc_kderc.isEmpty();
+    QStringList &files = lookup->files;
+    files.reserve(paths1.size() + paths2.size() + (useEtcKderc ? 1 : 0));
+
+    for (const QString &dir1 : paths1) {
+        files.push_front(dir1);
+    }
+    for (const QString &dir2 : paths2) {
+        files.push_front(dir2);
+    }
+
+    if (useEtcKderc) {
+        files.push_front(etc_kderc);
+    }
 
-    return *s_globalFiles();
+    s_globalFiles->publish(lookup);
+    return lookup->files;
 }
 
 void KConfigPrivate::parseGlobalFiles()
@@ -740,24 +1970,74 @@ void KConfigPrivate::parseGlobalFiles()
 
     Q_ASSERT(entryMap.isEmpty());
     const ParseCacheKey key = {globalFiles, locale};
-    auto data = sGlobalParse->localData().object(key);
     QDateTime newest;
-    for (const auto &file : globalFiles) {
-        const auto fileDate = QFileInfo(file).lastModified();
-        if (fileDate > newest) {
-            newest = fileDate;
+    const auto findNewest = [&newest, &globalFiles]() {
+        for (const auto &file : globalFiles) {
+            const auto fileDate = QFileInfo(file).lastModified();
+            if (fileDate > newest) {
+                newest = fileDate;
+            }
+        }
+    };
+
+    ParseCache &parseCache = *sGlobalParse;
+    bool watch = false;
+    {
+        QMutexLocker locker(&parseCache.mutex);
+        watch = parseCache.watch;
+        const ParseCacheValue *data = parseCache.cache.object(key);
+        if (data && watch && data->watched) {
+            ++parseCache.hits;
+            ++parseCache.watchedHits;
+            KConfigTrace::count(KConfigTrace::GlobalParseHits);
+            entryMap = data->entries;
+            return;
         }
     }
-    if (data) {
-        if (data->parseTime < newest) {
-            data = nullptr;
-        } else {
+    findNewest();
+    {
+        QMutexLocker locker(&parseCache.mutex);
+        const ParseCacheValue *data = parseCache.cache.object(key);
+        if (data && !(data->parseTime < newest)) {
+            ++parseCache.hits;
+            KConfigTrace::count(KConfigTrace::GlobalParseHits);
             entryMap = data->entries;
             return;
         }
+        ++parseCache.misses;
+        KConfigTrace::count(KConfigTrace::GlobalParseMisses);
     }
 
+    // Other threads may read the cached map while this config reads its own copy,
+    // which decodes escaped values in place: decode them all before sharing it
+    const auto cacheEntries = [this, &parseCache, &key, &newest, watch]() {
+        for (auto it = entryMap.cbegin(), end = entryMap.cend(); it != end; ++it) {
+            it->value();
+        }
+        auto *value = new ParseCacheValue({entryMap, newest});
+        const qsizetype cost = parseCost(value->entries);
+        QMutexLocker locker(&parseCache.mutex);
+        if (parseCache.cache.insert(key, value, cost) && watch && QCoreApplication::instance()) {
+            // until the files are watched, hits keep checking them
+            QMetaObject::invokeMethod(
+                QCoreApplication::instance(),
+                [&parseCache, key]() {
+                    parseCache.watchFiles(key);
+                },
+                Qt::QueuedConnection);
+        }
+    };
+
     const QByteArray utf8Locale = locale.toUtf8();
+    // another process of the session is likely to have parsed the same files already
+    const KConfigParseCache::Sources sources = KConfigParseCache::sources(globalFiles, utf8Locale);
+    if (KConfigParseCache::load(sources, entryMap)) {
+        cacheEntries();
+        return;
+    }
+
+    QList<CascadeFile> cascade;
+    cascade.reserve(globalFiles.size());
     for (const QString &file : globalFiles) {
         KConfigBackend::ParseOptions parseOpts = KConfigBackend::ParseGlobal | KConfigBackend::ParseExpansions;
 
@@ -765,56 +2045,107 @@ void KConfigPrivate::parseGlobalFiles()
             parseOpts |= KConfigBackend::ParseDefaults;
         }
 
-        QExplicitlySharedDataPointer<KConfigBackend> backend = KConfigBackend::create(file);
-        if (backend->parseConfig(utf8Locale, entryMap, parseOpts) == KConfigBackend::ParseImmutable) {
-            break;
-        }
+        cascade.append({file, parseOpts});
     }
-    sGlobalParse->localData().insert(key, new ParseCacheValue({entryMap, newest}));
+    parseCascade(cascade, utf8Locale, false);
+    KConfigParseCache::store(sources, entryMap);
+    cacheEntries();
 }
 
-void KConfigPrivate::parseConfigFiles()
+QStringList KConfigPrivate::configFiles() const
 {
-    // can only read the file if there is a backend and a file name
-    if (mBackend && !fileName.isEmpty()) {
-        bFileImmutable = false;
-
-        QList<QString> files;
-        if (wantDefaults()) {
-            if (bSuppressGlobal) {
-                files = getGlobalFiles();
+    QList<QString> files;
+    if (wantDefaults()) {
+        if (bSuppressGlobal) {
+            files = getGlobalFiles();
+        } else {
+            if (QDir::isAbsolutePath(fileName)) {
+                const QString canonicalFile = QFileInfo(fileName).canonicalFilePath();
+                if (!canonicalFile.isEmpty()) { // empty if it doesn't exist
+                    files << canonicalFile;
+                }
             } else {
-                if (QDir::isAbsolutePath(fileName)) {
-                    const QString canonicalFile = QFileInfo(fileName).canonicalFilePath();
-                    if (!canonicalFile.isEmpty()) { // empty if it doesn't exist
-                        files << canonicalFile;
-                    }
-                } else {
-                    const QStringList localFilesPath = QStandardPaths::locateAll(resourceType, fileName);
-                    for (const QString &f : localFilesPath) {
-                        files.prepend(QFileInfo(f).canonicalFilePath());
-                    }
+                const QStringList localFilesPath = locateCascade(resourceType, fileName, true);
+                for (const QString &f : localFilesPath) {
+                    files.prepend(f);
+                }
 
-                    // allow fallback to config files bundled in resources
-                    const QString resourceFile(QStringLiteral(":/kconfig/") + fileName);
-                    if (QFile::exists(resourceFile)) {
-                        files.prepend(resourceFile);
-                    }
+                // allow fallback to config files bundled in resources
+                const QString resourceFile(QStringLiteral(":/kconfig/") + fileName);
+                if (QFile::exists(resourceFile)) {
+                    files.prepend(resourceFile);
                 }
             }
-        } else {
-            files << mBackend->filePath();
-        }
-        if (!isSimple()) {
-            files = QList<QString>(extraFiles.cbegin(), extraFiles.cend()) + files;
         }
+    } else {
+        files << mBackend->filePath();
+    }
+    if (!isSimple()) {
+        files = QList<QString>(extraFiles.cbegin(), extraFiles.cend()) + files;
+    }
+    return files;
+}
+
+QList<KConfigIniBackend::FileStamp> KConfigPrivate::fileStamps() const
+{
+    QList<KConfigIniBackend::FileStamp> stamps;
+    if (!mBackend || fileName.isEmpty()) {
+        return stamps;
+    }
+
+    QStringList files;
+    if (wantGlobals()) {
+        // a kdeglobals that was created since has to be found, too
+        globalFilesOutdated = true;
+        files = getGlobalFiles();
+    }
+    files += configFiles();
+    if (openFlags & KConfig::ShardedGroups) {
+        files += KConfigIniBackend::shardFiles(mBackend->filePath());
+    }
+
+    stamps.reserve(files.size() + 1);
+    for (const QString &file : std::as_const(files)) {
+        stamps.append(KConfigIniBackend::FileStamp::of(file));
+    }
+    // what KConfig::Journaled appended changes the entries as much
+    stamps.append(KConfigIniBackend::FileStamp::of(KConfigIniBackend::journalPath(mBackend->filePath())));
+    return stamps;
+}
+
+void KConfigPrivate::parseConfigFiles(const QList<QByteArray> *reparsedGroups)
+{
+    // can only read the file if there is a backend and a file name
+    if (mBackend && !fileName.isEmpty()) {
+        bFileImmutable = false;
+
+        const QList<QString> files = configFiles();
 
         //        qDebug() << "parsing local files" << files;
 
         const QByteArray utf8Locale = locale.toUtf8();
+        QList<CascadeFile> cascade;
+        cascade.reserve(files.size());
         for (const QString &file : std::as_const(files)) {
             if (file.compare(mBackend->filePath(), sPathCaseSensitivity) == 0) {
-                switch (mBackend->parseConfig(utf8Locale, entryMap, KConfigBackend::ParseExpansions)) {
+                cascade.append({file, KConfigBackend::ParseExpansions, true});
+            } else {
+                cascade.append({file, KConfigBackend::ParseDefaults | KConfigBackend::ParseExpansions});
+            }
+        }
+        if (openFlags & KConfig::ShardedGroups) {
+            const QString localFile = mBackend->filePath();
+            const QStringList shards =
+                reparsedGroups ? KConfigIniBackend::shardFiles(localFile, *reparsedGroups) : KConfigIniBackend::shardFiles(localFile);
+            for (const QString &shard : shards) {
+                cascade.append({shard, KConfigBackend::ParseExpansions, true});
+            }
+        }
+
+        const QList<KConfigBackend::ParseInfo> results = parseCascade(cascade, utf8Locale, openFlags & KConfig::LazyLoading);
+        for (qsizetype i = 0; i < results.size(); ++i) {
+            if (cascade.at(i).local) {
+                switch (results.at(i)) {
                 case KConfigBackend::ParseOk:
                     break;
                 case KConfigBackend::ParseImmutable:
@@ -825,15 +2156,96 @@ void KConfigPrivate::parseConfigFiles()
                     break;
                 }
             } else {
-                QExplicitlySharedDataPointer<KConfigBackend> backend = KConfigBackend::create(file);
-                constexpr auto parseOpts = KConfigBackend::ParseDefaults | KConfigBackend::ParseExpansions;
-                bFileImmutable = backend->parseConfig(utf8Locale, entryMap, parseOpts) == KConfigBackend::ParseImmutable;
+                bFileImmutable = results.at(i) == KConfigBackend::ParseImmutable;
             }
+        }
+    }
+}
+
+QList<KConfigBackend::ParseInfo> KConfigPrivate::parseCascade(const QList<CascadeFile> &cascade, const QByteArray &utf8Locale, bool lazy)
+{
+    QList<KConfigBackend::ParseInfo> results;
+    results.reserve(cascade.size());
 
-            if (bFileImmutable) {
+    if (lazy || cascade.size() < 2 || sParseThreadPool.isDestroyed()) {
+        for (const CascadeFile &file : cascade) {
+            if (lazy) {
+                results.append(KConfigCompiledBackend::indexCompiledFile(file.fileName, utf8Locale, entryMap, file.options, lazyGroups));
+            } else {
+                results.append(KConfigCompiledBackend::parseCompiledFile(file.fileName, utf8Locale, entryMap, file.options));
+            }
+            if (results.last() == KConfigBackend::ParseImmutable) {
                 break;
             }
         }
+        return results;
+    }
+
+    // Parse each file into its own map, the first one in this thread and the
+    // others in the pool, then merge them in order. The first one goes right
+    // into an empty entryMap, which may have kept its arrays, see KEntryMap::recycle().
+    const bool firstIntoEntryMap = entryMap.isEmpty();
+    QList<KEntryMap> maps(cascade.size());
+    results.resize(cascade.size());
+    QSemaphore done;
+    for (qsizetype i = 1; i < cascade.size(); ++i) {
+        const CascadeFile &file = cascade.at(i);
+        KEntryMap *map = &maps[i];
+        KConfigBackend::ParseInfo *result = &results[i];
+        sParseThreadPool->start([&file, &utf8Locale, map, result, &done]() {
+            *result = KConfigCompiledBackend::parseCompiledFile(file.fileName, utf8Locale, *map, file.options);
+            done.release();
+        });
+    }
+    results[0] = KConfigCompiledBackend::parseCompiledFile(cascade.at(0).fileName, utf8Locale, firstIntoEntryMap ? entryMap : maps[0], cascade.at(0).options);
+    done.acquire(cascade.size() - 1);
+
+    for (qsizetype i = 0; i < cascade.size(); ++i) {
+        if (i == 0 && firstIntoEntryMap) {
+            // already there
+        } else if (entryMap.isEmpty()) {
+            entryMap = std::move(maps[i]);
+        } else {
+            entryMap.merge(maps.at(i));
+        }
+        if (results.at(i) == KConfigBackend::ParseImmutable) {
+            // the files read after an immutable one are ignored
+            results.resize(i + 1);
+            break;
+        }
+    }
+    return results;
+}
+
+void KConfigPrivate::loadLazyGroup(const QByteArray &group) const
+{
+    const auto it = lazyGroups.find(group);
+    if (it == lazyGroups.end()) {
+        return;
+    }
+
+    // Parsing the segments modifies their buffer, so they must only be parsed once
+    const QList<KConfigIniBackend::GroupSegment> segments = std::move(it.value());
+    lazyGroups.erase(it);
+    // Loading a group doesn't change what the config contains, just when it's read
+    KConfigIniBackend::parseGroupSegments(locale.toUtf8(), const_cast<KEntryMap &>(entryMap), group, segments);
+}
+
+void KConfigPrivate::loadLazyGroups(const QByteArray &parentGroup) const
+{
+    if (lazyGroups.isEmpty()) {
+        return;
+    }
+
+    QByteArrayList groups;
+    for (auto it = lazyGroups.cbegin(); it != lazyGroups.cend(); ++it) {
+        const QByteArray &group = it.key();
+        if (parentGroup.isEmpty() || group == parentGroup || (group.startsWith(parentGroup) && group.at(parentGroup.size()) == '\x1d')) {
+            groups << group;
+        }
+    }
+    for (const QByteArray &group : std::as_const(groups)) {
+        loadLazyGroup(group);
     }
 }
 
@@ -876,11 +2288,48 @@ bool KConfigPrivate::setLocale(const QString &aLocale)
     return false;
 }
 
+bool KConfigPrivate::swapLocaleEntries(const QString &previousLocale)
+{
+    if (bDirty || parsedStamps.isEmpty()) {
+        // the changes are written with the new locale by reparseConfiguration(), as they always were
+        return false;
+    }
+
+    LocaleEntries &previous = localeEntries[previousLocale];
+    previous.entryMap = std::move(entryMap);
+    previous.lazyGroups = std::move(lazyGroups);
+    previous.fileImmutable = bFileImmutable;
+    previous.stamps = std::move(parsedStamps);
+    entryMap.clear();
+    lazyGroups.clear();
+    parsedStamps.clear();
+
+    const auto it = localeEntries.find(locale);
+    if (it == localeEntries.end()) {
+        return false;
+    }
+    LocaleEntries current = std::move(it.value());
+    localeEntries.erase(it);
+    if (current.stamps != fileStamps()) {
+        return false;
+    }
+    entryMap = std::move(current.entryMap);
+    lazyGroups = std::move(current.lazyGroups);
+    bFileImmutable = current.fileImmutable;
+    parsedStamps = std::move(current.stamps);
+    dropCachedValues();
+    logReset();
+    return true;
+}
+
 bool KConfig::setLocale(const QString &locale)
 {
     Q_D(KConfig);
+    const QString previousLocale = d->locale;
     if (d->setLocale(locale)) {
-        reparseConfiguration();
+        if (!(d->openFlags & CacheLocales) || !d->swapLocaleEntries(previousLocale)) {
+            reparseConfiguration();
+        }
         return true;
     }
     return false;
@@ -890,6 +2339,8 @@ void KConfig::setReadDefaults(bool b)
 {
     Q_D(KConfig);
     d->bReadDefaults = b;
+    d->dropCachedValues();
+    d->logReset();
 }
 
 bool KConfig::readDefaults() const
@@ -907,6 +2358,7 @@ bool KConfig::isImmutable() const
 bool KConfig::isGroupImmutableImpl(const QByteArray &aGroup) const
 {
     Q_D(const KConfig);
+    d->loadLazyGroup(aGroup);
     return isImmutable() || d->entryMap.getEntryOption(aGroup, {}, {}, KEntryMap::EntryImmutable);
 }
 
@@ -936,6 +2388,9 @@ KEntryMap::EntryOptions convertToOptions(KConfig::WriteConfigFlags flags)
     if (flags.testFlag(KConfig::Notify)) {
         options |= KEntryMap::EntryNotify;
     }
+    if (flags & KConfig::Binary) {
+        options |= KEntryMap::EntryBinary;
+    }
     return options;
 }
 
@@ -944,16 +2399,29 @@ void KConfig::deleteGroupImpl(const QByteArray &aGroup, WriteConfigFlags flags)
     Q_D(KConfig);
     KEntryMap::EntryOptions options = convertToOptions(flags) | KEntryMap::EntryDeleted;
 
+    d->dropCachedValues();
     const QSet<QByteArray> groups = d->allSubGroups(aGroup);
     for (const QByteArray &group : groups) {
-        const QStringList keys = d->keyListImpl(group);
-        for (const QString &_key : keys) {
-            const QByteArray &key = _key.toUtf8();
-            if (d->canWriteEntry(group, key.constData())) {
-                d->entryMap.setEntry(group, key, QByteArray(), options);
-                d->bDirty = true;
+        // the same keys as keyListImpl(), written in one go instead of one setEntry() each
+        d->loadLazyGroup(group);
+        std::vector<KEntryMap::EntryWrite> writes;
+        const auto theEnd = d->entryMap.constEnd();
+        auto it = d->entryMap.constFindEntry(group);
+        if (it != theEnd) {
+            ++it; // advance past the special group entry marker
+            for (; it != theEnd && it.key().mGroup == group; ++it) {
+                // the localized and default entries of a key come right after it
+                const QByteArray &key = it.key().mKey;
+                if (isNonDeletedKey(it) && (writes.empty() || writes.back().key != key) && d->canWriteEntry(group, key.constData())) {
+                    writes.push_back({key, QByteArray(), options});
+                    d->logChange(group, key);
+                }
             }
         }
+        if (!writes.empty()) {
+            d->entryMap.setEntries(group, std::move(writes));
+            d->bDirty = true;
+        }
     }
 }
 
@@ -993,13 +2461,15 @@ bool KConfig::hasGroupImpl(const QByteArray &aGroup) const
 
 bool KConfigPrivate::canWriteEntry(const QByteArray &group, const char *key, bool isDefault) const
 {
-    if (bFileImmutable || entryMap.getEntryOption(group, key, KEntryMap::SearchLocalized, KEntryMap::EntryImmutable)) {
+    loadLazyGroup(group);
+    if (bFileImmutable
+        || (entryMap.mayHaveImmutableEntries(group) && entryMap.getEntryOption(group, key, KEntryMap::SearchLocalized, KEntryMap::EntryImmutable))) {
         return isDefault;
     }
     return true;
 }
 
-void KConfigPrivate::putData(const QByteArray &group, const char *key, const QByteArray &value, KConfigBase::WriteConfigFlags flags, bool expand)
+KEntryMap::EntryOptions KConfigPrivate::writeOptions(const QByteArray &value, KConfigBase::WriteConfigFlags flags, bool expand) const
 {
     KEntryMap::EntryOptions options = convertToOptions(flags);
 
@@ -1013,17 +2483,50 @@ void KConfigPrivate::putData(const QByteArray &group, const char *key, const QBy
     if (value.isNull()) { // deleting entry
         options |= KEntryMap::EntryDeleted;
     }
+    return options;
+}
+
+// Counts the access for KCONFIG_ACCESS_PROFILE
+static inline void profileAccess(const QString &file, const QByteArray &group, const char *key, KConfigTrace::Access access)
+{
+    if (KConfigTrace::isProfilingAccess()) {
+        KConfigTrace::recordAccess(file, group, key, access);
+    }
+}
 
-    bool dirtied = entryMap.setEntry(group, key, value, options);
+void KConfigPrivate::putData(const QByteArray &group, const char *key, const QByteArray &value, KConfigBase::WriteConfigFlags flags, bool expand)
+{
+    profileAccess(fileName, group, key, KConfigTrace::Access::Write);
+    loadLazyGroup(group);
+    dropCachedValues();
+    logChange(group, key);
+    bool dirtied = entryMap.setEntry(group, key, value, writeOptions(value, flags, expand));
     if (dirtied && (flags & KConfigBase::Persistent)) {
         bDirty = true;
     }
 }
 
+void KConfigPrivate::putData(const QByteArray &group, std::vector<KEntryMap::EntryWrite> writes)
+{
+    loadLazyGroup(group);
+    dropCachedValues();
+    for (const KEntryMap::EntryWrite &write : writes) {
+        profileAccess(fileName, group, write.key.constData(), KConfigTrace::Access::Write);
+        logChange(group, write.key);
+    }
+    // only writes with KConfigBase::Persistent have EntryDirty
+    if (entryMap.setEntries(group, std::move(writes))) {
+        bDirty = true;
+    }
+}
+
 void KConfigPrivate::revertEntry(const QByteArray &group, const char *key, KConfigBase::WriteConfigFlags flags)
 {
     KEntryMap::EntryOptions options = convertToOptions(flags);
 
+    loadLazyGroup(group);
+    dropCachedValues();
+    logChange(group, key);
     bool dirtied = entryMap.revertEntry(group, key, options);
     if (dirtied) {
         bDirty = true;
@@ -1032,27 +2535,79 @@ void KConfigPrivate::revertEntry(const QByteArray &group, const char *key, KConf
 
 QByteArray KConfigPrivate::lookupData(const QByteArray &group, const char *key, KEntryMap::SearchFlags flags) const
 {
-    return lookupInternalEntry(group, key, flags).mValue;
+    return lookupInternalEntry(group, key, flags).toByteArray();
 }
 
 KEntry KConfigPrivate::lookupInternalEntry(const QByteArray &group, const char *key, KEntryMap::SearchFlags flags) const
 {
+    profileAccess(fileName, group, key, KConfigTrace::Access::Read);
     if (bReadDefaults) {
         flags |= KEntryMap::SearchDefaults;
     }
+    loadLazyGroup(group);
+    KConfigTrace::count(KConfigTrace::Lookups);
     const auto it = entryMap.constFindEntry(group, key, flags);
     if (it == entryMap.constEnd()) {
         return {};
     }
+    it->value(); // decode it in the map, not just in the returned copy
     return it.value();
 }
 
-QString KConfigPrivate::lookupData(const QByteArray &group, const char *key, KEntryMap::SearchFlags flags, bool *expand) const
+QByteArrayView KConfigPrivate::lookupValue(const QByteArray &group, const char *key, KEntryMap::SearchFlags flags, bool *expand, KEntryMap::GroupHint *hint) const
+{
+    profileAccess(fileName, group, key, KConfigTrace::Access::Read);
+    if (bReadDefaults) {
+        flags |= KEntryMap::SearchDefaults;
+    }
+    loadLazyGroup(group);
+    KConfigTrace::count(KConfigTrace::Lookups);
+    const auto it = entryMap.constFindEntry(group, hint, key, flags);
+    // as KEntryMap::getEntry()
+    if (it == entryMap.constEnd() || it->bDeleted || it->isNull()) {
+        return {};
+    }
+    if (expand) {
+        *expand = it->bExpand;
+    }
+    return it->value();
+}
+
+QByteArrayView KConfigPrivate::lookupSlot(const QByteArray &group, const char *key, EntrySlot *slot, bool *expand) const
+{
+    profileAccess(fileName, group, key, KConfigTrace::Access::Read);
+    // every change of the entries bumps generation, loading a lazy group adds a group
+    if (slot->generation != generation || slot->groupsGeneration != entryMap.groupsGeneration()) {
+        KEntryMap::SearchFlags flags = KEntryMap::SearchLocalized;
+        if (bReadDefaults) {
+            flags |= KEntryMap::SearchDefaults;
+        }
+        loadLazyGroup(group);
+        KConfigTrace::count(KConfigTrace::Lookups);
+        slot->entry = entryMap.constFindEntry(group, key, flags);
+        slot->generation = generation;
+        slot->groupsGeneration = entryMap.groupsGeneration();
+    }
+    const auto it = slot->entry;
+    // as lookupValue()
+    if (it == entryMap.constEnd() || it->bDeleted || it->isNull()) {
+        return {};
+    }
+    if (expand) {
+        *expand = it->bExpand;
+    }
+    return it->value();
+}
+
+QString KConfigPrivate::lookupData(const QByteArray &group, const char *key, KEntryMap::SearchFlags flags, bool *expand, KEntryMap::GroupHint *hint) const
 {
+    profileAccess(fileName, group, key, KConfigTrace::Access::Read);
     if (bReadDefaults) {
         flags |= KEntryMap::SearchDefaults;
     }
-    return entryMap.getEntry(group, key, QString(), flags, expand);
+    loadLazyGroup(group);
+    KConfigTrace::count(KConfigTrace::Lookups);
+    return entryMap.getEntry(group, key, QString(), flags, expand, hint);
 }
 
 QStandardPaths::StandardLocation KConfig::locationType() const
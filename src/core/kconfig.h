@@ -16,12 +16,15 @@
 #include <kconfigcore_export.h>
 
 #include <QByteArray>
+#include <QByteArrayList>
+#include <QHash>
 #include <QList>
 #include <QStandardPaths>
 #include <QString>
 #include <QVariant>
 
 class KConfigGroup;
+class KConfigSnapshot;
 class KEntryMap;
 class KConfigPrivate;
 
@@ -74,7 +77,12 @@ public:
      * global sources.  The exception is that if a key or group is marked as
      * being immutable, it will not be overridden.
      *
-     * Note that all values other than IncludeGlobals and CascadeConfig are
+     * If LazyLoading is selected, only the group headers of the main configuration
+     * sources are read when the object is created; the entries of a group are parsed
+     * the first time the group is accessed. This speeds up opening large files of which
+     * only a few groups are used.
+     *
+     * Note that all values other than IncludeGlobals, CascadeConfig and LazyLoading are
      * convenience definitions for the basic mode.
      * Do @em not combine them with anything.
      * @see OpenFlags
@@ -82,6 +90,9 @@ public:
     enum OpenFlag {
         IncludeGlobals = 0x01, ///< Blend kdeglobals into the config object.
         CascadeConfig = 0x02, ///< Cascade to system-wide config files.
+        LazyLoading = 0x04, ///< Parse the entries of a group on first access. @since 6.1
+        CacheLocales = 0x08, ///< Keep the entries read for each locale, so that setLocale() back to one of them doesn't parse the files again. @since 6.1
+        ShardedGroups = 0x10, ///< Store each tree of subgroups of a top-level group, like [Containments][1] and all the groups below it, in a file of its own in the directory <file>.d, so that sync() only writes the files of the changed groups and reparseGroups() only reads those. The groups already in the file move on the first sync(). @since 6.1
 
         SimpleConfig = 0x00, ///< Just a single config file.
         NoCascade = IncludeGlobals, ///< Include user's globals, but omit system settings.
@@ -190,6 +201,53 @@ public:
     /// @since 4.12
     bool isDirty() const;
 
+    /**
+     * How much sync() does to keep the changes when the system crashes.
+     * @see setDurability()
+     * @since 6.1
+     */
+    enum Durability {
+        /// sync() waits until the files are on the disk, the default
+        Durable,
+        /// sync() replaces the files without waiting for the disk. After a crash
+        /// a file may be empty, so this is meant for state that is easily lost,
+        /// like window sizes and recently used folders
+        RelaxedNoFsync,
+        /// Like RelaxedNoFsync, but sync() only schedules a write that happens a
+        /// few seconds later, together with those of all the sync() calls until
+        /// then. Destroying the config writes what is left. This needs an event
+        /// loop in the thread of the config, without one sync() writes right away
+        WriteBehind,
+        /// Like RelaxedNoFsync, but sync() only appends the changes to the file
+        /// to a journal next to it, instead of reading and replacing the whole
+        /// file. The journal is read after the file and is folded into it once
+        /// it grows past 64 KiB, and when the config is destroyed. Changes to
+        /// kdeglobals are written as usual. This is meant for state that changes
+        /// all the time, like the geometry of windows
+        Journaled,
+    };
+
+    /**
+     * Sets how much sync() does to keep the changes when the system crashes.
+     * Leaving WriteBehind writes the pending changes.
+     * KSharedConfig::openStateConfig() sets RelaxedNoFsync.
+     * @since 6.1
+     */
+    void setDurability(Durability durability);
+    /**
+     * @see setDurability()
+     * @since 6.1
+     */
+    Durability durability() const;
+
+    /**
+     * Returns an immutable copy of the entries, including the changes not
+     * synced yet, which can be read from any thread.
+     * @see KConfigSnapshot
+     * @since 6.1
+     */
+    KConfigSnapshot snapshot() const;
+
     /// @reimp
     void markAsClean() override;
 
@@ -241,8 +299,13 @@ public:
      * Ensures that the configuration file contains a certain update.
      *
      * If the configuration file does not contain the update @p id
-     * as contained in @p updateFile, kconf_update is run to update
-     * the configuration file.
+     * as contained in @p updateFile, the updates of @p updateFile are
+     * applied as kconf_update applies them, without starting it.
+     *
+     * If the config was opened with NoGlobals on a file name, the way
+     * kconf_update opens the files it updates, the updates are applied to
+     * this config and written from it. Otherwise the files are parsed again
+     * once they are updated.
      *
      * If you install config update files with critical fixes
      * you may wish to use this method to verify that a critical
@@ -259,9 +322,78 @@ public:
      * Updates the state of this object to match the persistent storage.
      * Note that if this object has pending changes, this method will
      * call sync() first so as not to lose those changes.
+     *
+     * The entries that differ from the ones read before are listed by
+     * changesSince(), so that only what changed needs to be read again.
      */
     void reparseConfiguration();
 
+    /**
+     * Updates only @p groups to match the persistent storage, for instance
+     * the groups listed by a change notification. The other groups keep the
+     * entries they had, which saves parsing and rebuilding all of them when
+     * only a few changed. Subgroups aren't included, the names of nested
+     * groups are joined with '\\x1d'.
+     *
+     * Like reparseConfiguration(), this calls sync() first if there are
+     * pending changes.
+     *
+     * @since 6.1
+     */
+    void reparseGroups(const QStringList &groups);
+
+    /**
+     * Forgets the expanded values of the entries marked with [$e].
+     *
+     * Expanded values are kept per config, so that an entry isn't expanded
+     * again on every read. Call this after changing environment variables
+     * that such entries refer to. This drops the values kept by
+     * KConfigGroup::readCachedEntry() as well. Changing or reparsing the
+     * entries doesn't need it.
+     *
+     * @since 6.1
+     */
+    void invalidateExpansions();
+
+    /**
+     * The generation of the entries, which increases with every change of
+     * them: each entry written, reverted or deleted, each reparse, each
+     * change of the locale. Comparing it with the generation seen before
+     * tells whether anything changed since then. The generations of two
+     * configs are never the same.
+     *
+     * @see groupGeneration(), changesSince()
+     * @since 6.1
+     */
+    quint64 generation() const;
+
+    /**
+     * The generation() of the last change of the entries of @p group, or of
+     * the last time all the entries may have changed, see changesSince().
+     * Subgroups have their
+     * own, a change of one doesn't change the generation of its parent.
+     *
+     * @since 6.1
+     */
+    quint64 groupGeneration(const QString &group) const;
+
+    /**
+     * The keys that changed since @p generation, by group. The key of the
+     * default group is an empty string. A group parsed again by reparseGroups()
+     * is listed, but without the keys of its entries. A key may be listed
+     * even though it was written with the value it had.
+     *
+     * The entries parsed again by reparseConfiguration() are listed if they
+     * differ from the ones read before. Only the last few hundred changes are
+     * kept, and all the entries may have changed when they were parsed again
+     * with KConfig::LazyLoading or changed with setLocale(). If the changes since @p generation aren't all known,
+     * nothing is returned, @p complete is set to false and everything is to
+     * be considered changed.
+     *
+     * @since 6.1
+     */
+    QHash<QString, QByteArrayList> changesSince(quint64 generation, bool *complete = nullptr) const;
+
     /// @{ extra config files
     /**
      * Adds the list of configuration sources to the merge stack.
@@ -311,6 +443,11 @@ public:
      * @note If set to the empty string, @b no locale will be matched. This effectively disables
      * reading translated entries.
      *
+     * The files are parsed again for the entries of the new locale. With
+     * CacheLocales, the entries of the previous locale are kept, and those
+     * kept for @p aLocale are used again if none of the files changed since
+     * they were read and there are no unsaved changes.
+     *
      * @return @c true if locale was changed, @c false if the call had no
      *         effect (eg: @p aLocale was already the current locale for this
      *         object)
@@ -369,6 +506,117 @@ public:
      */
     static QString mainConfigName();
 
+    /**
+     * Counters of the work done by all the config objects of the process,
+     * to find out where it spends its time in KConfig.
+     *
+     * @see statistics()
+     * @since 6.1
+     */
+    struct Statistics {
+        quint64 filesParsed = 0; ///< config files read from disk
+        quint64 bytesRead = 0; ///< size of those files
+        quint64 parseNanoseconds = 0; ///< time spent reading and parsing them
+        quint64 writeNanoseconds = 0; ///< time spent writing config files
+        quint64 globalParseHits = 0; ///< configs that got the parsed global files from the cache of the process
+        quint64 globalParseMisses = 0; ///< configs that had to parse them
+        quint64 lookups = 0; ///< entries looked up
+        quint64 conversions = 0; ///< values converted from their text to another type
+        quint64 syncs = 0; ///< calls of sync() that had something to write
+        quint64 lockWaitNanoseconds = 0; ///< time spent waiting for the locks of config files
+        quint64 lockContentions = 0; ///< locks that another process was holding
+        quint64 writeConflicts = 0; ///< writes without a lock file that found the file changed, with KCONFIG_OPTIMISTIC_WRITES=1
+        quint64 notificationsSent = 0; ///< change notifications sent for entries written with Notify
+        quint64 notificationsReceived = 0; ///< change notifications received by a KConfigWatcher
+    };
+
+    /**
+     * Returns the counters since the start of the process or the last
+     * resetStatistics().
+     *
+     * The counters only go up while they are enabled, see
+     * setStatisticsEnabled(). Setting the KCONFIG_TRACE environment variable
+     * enables them from the start, and also logs the time the parsing,
+     * writing and locking of each file takes to the kf.config.core.trace
+     * category. Those of a change, from saving it to its reload in the
+     * processes notified of it, also carry the id of the change and are
+     * broadcast on the session bus, where kconfigtrace6 collects them.
+     *
+     * @since 6.1
+     */
+    static Statistics statistics();
+
+    /**
+     * Sets whether statistics() are counted. Off by default, unless
+     * KCONFIG_TRACE is set.
+     *
+     * @since 6.1
+     */
+    static void setStatisticsEnabled(bool enabled);
+
+    /**
+     * Sets all the counters of statistics() back to zero.
+     *
+     * @since 6.1
+     */
+    static void resetStatistics();
+
+    /**
+     * The memory held by the entries of a config, see memoryUsage().
+     * The bytes of shared keys and values are counted by every config that
+     * has them.
+     * @since 6.1
+     */
+    struct MemoryUsage {
+        QString name; ///< name() of the config
+        qsizetype groups = 0; ///< groups with entries, including deleted ones
+        qsizetype entries = 0; ///< entries, including group markers, defaults and localized ones
+        qint64 keyBytes = 0; ///< bytes in group names and keys
+        qint64 valueBytes = 0; ///< bytes in values, those stored inline included
+        qsizetype sharedKeys = 0; ///< keys shared with other entries, mostly through the pool of interned strings
+        qsizetype sharedValues = 0; ///< values shared with other entries, likewise
+        qsizetype sharedGroups = 0; ///< groups whose entries are shared with other configs, for instance through the cache of the global files
+        qint64 structureBytes = 0; ///< the nodes the entries and groups are kept in
+        qint64 cacheBytes = 0; ///< an estimate of the converted values, expanded values and the index of unparsed groups
+    };
+
+    /**
+     * Returns the memory held by the entries of this config.
+     * Going through all the entries, this is meant for debugging.
+     * @see KSharedConfig::memoryReport()
+     * @since 6.1
+     */
+    MemoryUsage memoryUsage() const;
+
+    /**
+     * How much trimCaches() releases.
+     * @since 6.1
+     */
+    enum TrimLevel {
+        TrimUnused, ///< only what no config uses, reading the configs that are open doesn't get slower
+        TrimAll, ///< the caches in use as well, the configs opened next look up and parse their files again
+    };
+
+    /**
+     * Releases memory held by the caches of KConfig, meant to be called when
+     * the system runs low on memory. QtCore has no signal for that, connect
+     * the one of the platform, if it has one, to this.
+     *
+     * With TrimUnused, the parsed global files and the interned keys and
+     * values that no config shares anymore are dropped, as well as the
+     * defaults bundles no config maps. The shared configs of the calling
+     * thread free the room left in their entries, by deletions for instance,
+     * and the values cached by readEntry().
+     *
+     * TrimAll also drops all the parsed global files, the snapshots shared
+     * by KConfigSnapshot::open() and the cached lookups of the cascades.
+     *
+     * Returns an estimate of the number of bytes freed.
+     *
+     * @since 6.1
+     */
+    static qint64 trimCaches(TrimLevel level = TrimUnused);
+
 protected:
     bool hasGroupImpl(const QByteArray &group) const override;
     KConfigGroup groupImpl(const QByteArray &b) override;
@@ -378,7 +626,13 @@ protected:
 
     friend class KConfigGroup;
     friend class KConfigGroupPrivate;
+    friend class KConfigBackgroundSyncPrivate;
+    friend class KConfigTransactionPrivate;
     friend class KSharedConfig;
+    friend class KConfigWatcher;
+    friend class KCoreConfigSkeleton;
+    friend class KAuthorizedPrivate;
+    friend class KConfigPrivate;
 
     /** Virtual hook, used to add new "virtual" functions while maintaining
      * binary compatibility. Unused in this class.
@@ -14,15 +14,26 @@
 #include "kconfigbackend_p.h"
 #include "kconfigdata_p.h"
 #include "kconfiggroup.h"
+#include "kconfigini_p.h"
 
 #include <QDir>
 #include <QFile>
+#include <QHash>
+#include <QSemaphore>
 #include <QStack>
 #include <QStringList>
+#include <QTimer>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+
+class KConfigSnapshotPrivate;
 
 class KConfigPrivate
 {
     friend class KConfig;
+    friend class KCoreConfigSkeleton; // compares the entries it read with the current ones, see load()
 
 public:
     KConfig::OpenFlags openFlags;
@@ -33,19 +44,74 @@ public:
 
     // functions for KConfigGroup
     bool canWriteEntry(const QByteArray &group, const char *key, bool isDefault = false) const;
-    QString lookupData(const QByteArray &group, const char *key, KEntryMap::SearchFlags flags, bool *expand) const;
+    // @p hint remembers where @p group is for the next lookup, see KEntryMap::GroupHint
+    QString lookupData(const QByteArray &group, const char *key, KEntryMap::SearchFlags flags, bool *expand, KEntryMap::GroupHint *hint = nullptr) const;
     QByteArray lookupData(const QByteArray &group, const char *key, KEntryMap::SearchFlags flags) const;
     KEntry lookupInternalEntry(const QByteArray &group, const char *key, KEntryMap::SearchFlags flags) const;
+    // The decoded value in the map, without a copy, valid until the entries change
+    QByteArrayView lookupValue(const QByteArray &group,
+                               const char *key,
+                               KEntryMap::SearchFlags flags,
+                               bool *expand = nullptr,
+                               KEntryMap::GroupHint *hint = nullptr) const;
+
+    // Where an entry was found, for KConfigKey. It is valid while neither the entries
+    // nor the groups changed, that is for the generation and the groupsGeneration()
+    // of entryMap it was found with.
+    struct EntrySlot {
+        quint64 generation = 0;
+        quint64 groupsGeneration = 0;
+        KEntryMap::ConstIterator entry; // the end if there is none
+    };
+    // Same as lookupValue() with KEntryMap::SearchLocalized, through @p slot if it is still valid
+    QByteArrayView lookupSlot(const QByteArray &group, const char *key, EntrySlot *slot, bool *expand = nullptr) const;
 
     void putData(const QByteArray &group, const char *key, const QByteArray &value, KConfigBase::WriteConfigFlags flags, bool expand = false);
+    // writes all of @p writes to @p group at once, for KConfigGroupBatch
+    void putData(const QByteArray &group, std::vector<KEntryMap::EntryWrite> writes);
+    // the options putData() writes an entry with
+    KEntryMap::EntryOptions writeOptions(const QByteArray &value, KConfigBase::WriteConfigFlags flags, bool expand = false) const;
     void setEntryData(const QByteArray &group, const char *key, const QByteArray &value, KEntryMap::EntryOptions flags)
     {
+        loadLazyGroup(group);
+        dropCachedValues();
+        logChange(group, key);
         if (entryMap.setEntry(group, key, value, flags)) {
             bDirty = true;
         }
     }
     void revertEntry(const QByteArray &group, const char *key, KConfigBase::WriteConfigFlags flags);
+    // the entries of @p group alone, for KConfigGroup::snapshot()
+    KConfigSnapshotPrivate *groupSnapshot(const QByteArray &group) const;
     QStringList groupList(const QByteArray &group) const;
+    // Calls @p callback with the name of each subgroup groupList() lists, for KConfigGroup::forEachSubGroup()
+    template<typename Callback>
+    void forEachSubGroup(const QByteArray &group, Callback callback) const
+    {
+        loadLazyGroups(group);
+        entryMap.forEachSubGroupName(group, callback);
+    }
+    // Calls @p callback with the key and the entry of each of the entries of @p group that
+    // KConfig::entryMap() lists, for KConfigGroup::forEachEntry()
+    template<typename Callback>
+    void forEachEntry(const QByteArray &group, Callback callback) const
+    {
+        loadLazyGroup(group);
+        const auto end = entryMap.constEnd();
+        auto it = entryMap.constFindEntry(group, {}, {});
+        if (it == end) {
+            return;
+        }
+        // as KConfig::entryMap(), the localized entry comes first and hides the plain one
+        QByteArrayView listed;
+        for (++it; it != end && it.key().mGroup == group; ++it) {
+            if (it->bDeleted || it.key().bDefault || (!listed.isNull() && listed == it.key().mKey)) {
+                continue;
+            }
+            listed = it.key().mKey;
+            callback(it.key(), *it);
+        }
+    }
     // copies the entries from @p source to @p otherGroup changing all occurrences
     // of @p source with @p destination
     void copyGroup(const QByteArray &source, const QByteArray &destination, KConfigGroup *otherGroup, KConfigBase::WriteConfigFlags flags) const;
@@ -53,10 +119,112 @@ public:
     QSet<QByteArray> allSubGroups(const QByteArray &parentGroup) const;
     bool hasNonDeletedEntries(const QByteArray &group) const;
 
-    void notifyClients(const QHash<QString, QByteArrayList> &changes, const QString &path);
+    // @p values are the ones sent with KConfigNotifications::setIncludeValues(), see KConfigNotifyTransport
+    static void notifyClients(const QHash<QString, QByteArrayList> &changes, const QString &path, const QHash<QString, QByteArrayList> &values = {});
+    // Sets the entries of @p group to the @p values of a ConfigValuesChanged signal sent for @p path,
+    // returns false if they can't be applied and the group has to be parsed again instead
+    bool applyNotifiedValues(const QString &group, const QByteArrayList &values, const QString &path);
+
+    // A sync taken out of the config to be written on another thread, see KConfigBackgroundSync
+    struct SyncJob {
+        QString name; // KConfig::name()
+        QString localFile;
+        QString globalFile;
+        QByteArray locale;
+        KEntryMap entries; // see KEntryMap::takeDirtyEntries()
+        QList<KEntryKey> dirtyKeys;
+        bool lock = false;
+        KConfigBackend::WriteOptions writeOptions;
+        bool writeLocals = false;
+        bool writeGlobals = false;
+        QHash<QString, QByteArrayList> notifyGroupsLocal;
+        QHash<QString, QByteArrayList> notifyGroupsGlobal;
+        bool succeeded = false;
+        bool lockBusy = false; // another process held a file for longer than syncJobLockTimeout
+        bool notify = true; // whether runSyncJob() sends the notifications, or the caller does for several jobs
+    };
+    // How long runSyncJob() waits for the lock of a file, in milliseconds
+    static constexpr int syncJobLockTimeout = 200;
+    // Moves the dirty entries into @p job, returns false if there is nothing to write.
+    // The caller holds syncSemaphore until the job has been run.
+    bool takeSyncJob(SyncJob *job);
+    // Writes out @p job, this doesn't touch any config and may run on any thread
+    static bool runSyncJob(SyncJob *job);
+    // Writes out all of @p jobs, with the files of all of them locked, see KConfigTransaction.
+    // The changes to each path are notified once, after the last file was written.
+    static bool runSyncJobs(const QList<SyncJob *> &jobs);
+    // Writes out the dirty @p configs at the same time, see KConfigExitSync
+    static bool syncConfigs(const QList<KConfig *> &configs);
+    // Marks the entries of @p job dirty again after it failed
+    void restoreSyncJob(const SyncJob &job);
+    // held while a config file is written, so that sync() can't overtake a background sync
+    QSemaphore syncSemaphore{1};
 
     static QString expandString(const QString &value);
 
+    // Values converted by KConfigGroup::readCachedEntry(), any change of the entries drops all of them
+    struct ConvertedKey {
+        QByteArray group;
+        QByteArray key;
+        int type;
+
+        bool operator==(const ConvertedKey &other) const
+        {
+            return type == other.type && key == other.key && group == other.group;
+        }
+        friend size_t qHash(const ConvertedKey &key, size_t seed = 0)
+        {
+            return qHashMulti(seed, key.group, key.key, key.type);
+        }
+    };
+    struct ConvertedValue {
+        QVariant defaultValue; // the value depends on the default when the entry is missing or invalid
+        QVariant value;
+    };
+    mutable QHash<ConvertedKey, ConvertedValue> convertedValues;
+
+    // expandString() of @p value, kept in expandedValues
+    QString expandCached(const QString &value) const;
+    // keyed by the unexpanded value, a changed entry just isn't found anymore
+    mutable QHash<QString, QString> expandedValues;
+
+    // Called whenever the entries change
+    void dropCachedValues() const
+    {
+        convertedValues.clear();
+        expandedValues.clear();
+        generation = ++s_generations;
+    }
+    // Tells whether the entries changed, see KCoreConfigSkeleton::load(), unique
+    // across all configs so that one isn't mistaken for another at the same address
+    mutable quint64 generation = 0;
+    static inline std::atomic<quint64> s_generations{0};
+
+    // The keys changed since a generation, see KConfig::changesSince()
+    struct LoggedChange {
+        quint64 generation;
+        QByteArray group;
+        QByteArray key; // empty if all the entries of the group changed
+    };
+    std::deque<LoggedChange> changeLog;
+    // How many changes changeLog keeps, the oldest ones are dropped beyond that
+    static constexpr std::size_t changeLogSize = 512;
+    // The changes since an older generation aren't all in changeLog anymore
+    quint64 changeLogStart = 0;
+    // The generation of the last time all the entries may have changed, and of the
+    // last change of each group since then
+    quint64 resetGeneration = 0;
+    QHash<QByteArray, quint64> groupGenerations;
+    // Logs a change of @p key in @p group, after dropCachedValues()
+    void logChange(const QByteArray &group, const QByteArray &key = QByteArray());
+    // Logs that any entry may have changed, after dropCachedValues()
+    void logReset();
+
+    // With KConfig::LazyLoading, parses the entries of @p group if that hasn't happened yet
+    void loadLazyGroup(const QByteArray &group) const;
+    // Same for @p parentGroup and all its subgroups, or for all groups if @p parentGroup is empty
+    void loadLazyGroups(const QByteArray &parentGroup = QByteArray()) const;
+
 protected:
     QExplicitlySharedDataPointer<KConfigBackend> mBackend;
 
@@ -78,6 +246,8 @@ private:
     static bool mappingsRegistered;
 
     KEntryMap entryMap;
+    // Groups indexed but not yet parsed, see KConfig::LazyLoading
+    mutable KConfigIniBackend::GroupIndex lazyGroups;
     QString backendType;
     QStack<QString> extraFiles;
 
@@ -97,7 +267,7 @@ private:
     }
     bool isSimple() const
     {
-        return openFlags == KConfig::SimpleConfig;
+        return (openFlags & ~KConfig::OpenFlags(KConfig::LazyLoading | KConfig::CacheLocales)) == KConfig::SimpleConfig;
     }
     bool isReadOnly() const
     {
@@ -105,11 +275,167 @@ private:
     }
 
     bool setLocale(const QString &aLocale);
+    // With KConfig::CacheLocales, the entries of the other locales that were set
+    struct LocaleEntries {
+        KEntryMap entryMap;
+        KConfigIniBackend::GroupIndex lazyGroups;
+        bool fileImmutable = false;
+        QList<KConfigIniBackend::FileStamp> stamps; // of the files before they were parsed
+    };
+    QHash<QString, LocaleEntries> localeEntries;
+    QList<KConfigIniBackend::FileStamp> parsedStamps; // of the files the current entries were parsed from
+    // Keeps the entries for @p previousLocale and takes those kept for the current one,
+    // returns false if there are none that are up to date and the files must be parsed
+    bool swapLocaleEntries(const QString &previousLocale);
+    // The global files published last in the process, or with globalFilesOutdated a fresh lookup of them
     QStringList getGlobalFiles() const;
+    // set when the files are read again, so that getGlobalFiles() finds those created since
+    mutable bool globalFilesOutdated = false;
+    // Frees the room left in the entries and the cached values, see KConfig::trimCaches()
+    qint64 trimCaches();
     void parseGlobalFiles();
-    void parseConfigFiles();
+    // The files parseConfigFiles() reads, from the least to the most specific
+    QStringList configFiles() const;
+    // With KConfig::ShardedGroups, of the shards only those of @p reparsedGroups are read if it is set
+    void parseConfigFiles(const QList<QByteArray> *reparsedGroups = nullptr);
+    // The stamps of all the files reparseConfiguration() would read, taken before
+    // the files are read they tell whether the entries are still up to date
+    QList<KConfigIniBackend::FileStamp> fileStamps() const;
+    // A file of the cascade, parsed without creating a backend for it
+    struct CascadeFile {
+        QString fileName;
+        KConfigBackend::ParseOptions options;
+        bool local = false; // the file of mBackend
+    };
+    // Parses @p cascade into entryMap, from the least to the most specific file, and
+    // returns the result for each file that was read. With @p lazy, groups are only indexed.
+    QList<KConfigBackend::ParseInfo> parseCascade(const QList<CascadeFile> &cascade, const QByteArray &locale, bool lazy);
     void initCustomized(KConfig *);
+    // WriteOptimistic if KCONFIG_OPTIMISTIC_WRITES=1: sync() then doesn't take the lock files,
+    // WriteNoFsync unless the config is KConfig::Durable, and WriteJournal if it is KConfig::Journaled
+    KConfigBackend::WriteOptions writeOptions() const;
+    // Folds the journal of the local file into it, see KConfig::Journaled
+    void compactJournal();
     bool lockLocal();
+
+    KConfig::Durability durability = KConfig::Durable;
+    // Starts writeBehindTimer for a sync() of a KConfig::WriteBehind config, returns false
+    // if the sync has to write right away
+    bool scheduleWriteBehind(KConfig *q);
+    // How long a KConfig::WriteBehind config waits after the first sync(), in milliseconds
+    static constexpr int writeBehindInterval = 3000;
+    std::unique_ptr<QTimer> writeBehindTimer;
+    bool writingBehind = false; // the timer fired or the config goes away, sync() writes
 };
 
+/**
+ * Process-wide cache of the parsed global files, shared by all threads.
+ *
+ * A hit shares the entries of the cached map with the new config, they are
+ * only copied group by group once the config changes them. The cache keeps
+ * the parsed files of up to a memory budget, which can be set with the
+ * KCONFIG_GLOBAL_PARSE_CACHE_SIZE environment variable, in KiB.
+ *
+ * @internal
+ */
+namespace KConfigGlobalParseCache
+{
+struct Statistics {
+    qint64 hits = 0; ///< configs that got the parsed global files from the cache
+    qint64 misses = 0; ///< configs that had to parse them
+    qint64 watchedHits = 0; ///< hits that trusted the file watcher instead of checking the files
+    qsizetype size = 0; ///< number of parsed cascades in the cache
+    qsizetype cost = 0; ///< estimated memory used by them, in bytes
+    qsizetype budget = 0; ///< the most memory they may use
+};
+
+/**
+ * For debugging: how effective the cache is
+ */
+KCONFIGCORE_EXPORT Statistics statistics();
+
+/**
+ * Sets the memory budget, in bytes. Parsed files are evicted until they fit.
+ */
+KCONFIGCORE_EXPORT void setBudget(qsizetype bytes);
+
+/**
+ * Sets whether the parsed files are watched for changes. Hits then don't
+ * check the modification times of the files anymore, but a change made by
+ * another process is only noticed once the event loop of the application
+ * thread got the notification. Off by default, KCONFIG_GLOBAL_PARSE_CACHE_WATCH=1
+ * turns it on. Needs a QCoreApplication.
+ */
+KCONFIGCORE_EXPORT void setWatchFiles(bool watch);
+
+/**
+ * Drops the cached parses that include @p file, after this process wrote it.
+ */
+void invalidate(const QString &file);
+}
+
+/**
+ * Coalescing of the ConfigChanged signals that KConfig::sync() sends for the
+ * entries written with KConfig::Notify.
+ *
+ * @internal
+ */
+namespace KConfigNotifications
+{
+/**
+ * Sets for how many milliseconds the changes are collected before a single
+ * signal per file is sent for all of them, with the changed keys of each
+ * group merged. 0, the default, sends a signal for every sync().
+ * KCONFIG_NOTIFY_INTERVAL sets the initial value. Without a QCoreApplication
+ * the changes are always sent right away.
+ */
+KCONFIGCORE_EXPORT void setInterval(int msecs);
+
+/**
+ * Sets whether the new values of the changed entries are sent along, in a
+ * ConfigValuesChanged signal, so that the watchers can apply them without
+ * parsing the files again. Off by default, KCONFIG_NOTIFY_VALUES=1 turns it
+ * on. Only the D-Bus transport carries values, see KConfigNotifyTransport.
+ */
+KCONFIGCORE_EXPORT void setIncludeValues(bool include);
+bool includeValues();
+
+/**
+ * Sends the changes collected so far, also done when the application exits.
+ */
+KCONFIGCORE_EXPORT void flush();
+}
+
+/**
+ * The shared configs of the calling thread, see KSharedConfig::openConfig().
+ * Their caches are trimmed by KConfig::trimCaches().
+ *
+ * @internal
+ */
+QList<KConfig *> sharedConfigsOfThread();
+
+/**
+ * The sync of the dirty shared configs when the application exits, instead
+ * of one after the other as they are destroyed.
+ *
+ * @internal
+ */
+namespace KConfigExitSync
+{
+/**
+ * Writes out all of @p configs that are dirty, the files of up to
+ * maxThreads() of them at the same time. The changes to each path are
+ * notified once, after all of them were written. The configs writing a
+ * file another one writes as well, or whose file another process held,
+ * are synced one after the other afterwards.
+ * @return whether everything could be written
+ */
+KCONFIGCORE_EXPORT bool syncAll(const QList<KConfig *> &configs);
+
+/**
+ * How many configs syncAll() writes at the same time.
+ */
+int maxThreads();
+}
+
 #endif // KCONFIG_P_H
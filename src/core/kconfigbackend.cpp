@@ -16,8 +16,8 @@
 #include <QHash>
 #include <QStringList>
 
+#include "kconfigcompiled_p.h"
 #include "kconfigdata_p.h"
-#include "kconfigini_p.h"
 
 typedef QExplicitlySharedDataPointer<KConfigBackend> BackendPtr;
 
@@ -62,7 +62,12 @@ BackendPtr KConfigBackend::create(const QString &file, const QString &sys)
 #endif
 
     // qDebug() << "default creation of the Ini backend";
-    backend = new KConfigIniBackend;
+    // only the files kcompileconfig6 registered, nothing is looked up on disk for the others
+    if (!file.isEmpty() && KConfigCompiledBackend::isRegistered(file)) {
+        backend = new KConfigCompiledBackend;
+    } else {
+        backend = new KConfigIniBackend;
+    }
     backend->setFilePath(file);
     return BackendPtr(backend);
 }
@@ -70,6 +70,8 @@ public:
         ParseGlobal = 1, /// entries should be marked as @em global
         ParseDefaults = 2, /// entries should be marked as @em default
         ParseExpansions = 4, /// entries are allowed to be marked as @em expandable
+        ParseJournal = 8, /// the file is a journal, whose [$r] entries are removed
+        ParseNoJournal = 16, /// the file is known to have no journal, it isn't looked for
     };
     Q_FLAG(ParseOption)
     /// @typedef typedef QFlags<ParseOption> ParseOptions
@@ -77,7 +79,11 @@ public:
 
     /** Allows the behaviour of writeConfig() to be tuned */
     enum WriteOption {
-        WriteGlobal = 1 /// only write entries marked as "global"
+        WriteGlobal = 1, /// only write entries marked as "global"
+        WriteOptimistic = 2, /// without lock(): the file is only replaced if nobody changed it meanwhile, else merged again
+        WriteNoFsync = 4, /// the file is replaced without waiting for it to be on the disk
+        WriteJournal = 8, /// the changes are appended to the journal of the file, see KConfig::Journaled
+        WriteSharded = 16, /// the trees of subgroups are written to files of their own, see KConfig::ShardedGroups
     };
     Q_FLAG(WriteOption)
     /// @typedef typedef QFlags<WriteOption> WriteOptions
@@ -151,9 +157,15 @@ public:
     virtual void setFilePath(const QString &path) = 0;
 
     /**
-     * Lock the file
+     * Lock the file, waiting for another process holding it for as long as
+     * KCONFIG_LOCK_TIMEOUT says, in milliseconds, forever if it isn't set
      */
     virtual bool lock() = 0;
+    /**
+     * Lock the file, waiting at most @p timeout milliseconds for another
+     * process holding it, forever if it is negative
+     */
+    virtual bool tryLock(int timeout) = 0;
     /**
      * Release the lock on the file
      */
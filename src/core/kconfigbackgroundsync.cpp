@@ -0,0 +1,182 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kconfigbackgroundsync.h"
+
+#include "kconfig_core_log_settings.h"
+#include "kconfig_p.h"
+
+#include <QThreadPool>
+#include <QTimer>
+
+#include <memory>
+
+class KConfigBackgroundSyncPrivate
+{
+public:
+    explicit KConfigBackgroundSyncPrivate(KConfigBackgroundSync *qq)
+        : q(qq)
+    {
+    }
+
+    KConfigPrivate *configPrivate() const
+    {
+        return config->d_ptr;
+    }
+
+    void startJob();
+    void finishJob(const std::shared_ptr<KConfigPrivate::SyncJob> &job);
+
+    KConfigBackgroundSync *const q;
+    KSharedConfig::Ptr config;
+    QTimer timer;
+    // the job being written on the thread pool
+    std::shared_ptr<KConfigPrivate::SyncJob> job;
+    // the timer fired while a job was being written
+    bool requestedAgain = false;
+    // the jobs in a row that found a file locked by another process
+    int lockRetries = 0;
+};
+
+// The jobs that may find a file locked in a row, before the sync is reported as failed
+static constexpr int s_maxLockRetries = 10;
+
+void KConfigBackgroundSyncPrivate::startJob()
+{
+    if (job) {
+        // writing the newer changes first would let the older ones win
+        requestedAgain = true;
+        return;
+    }
+
+    if (config->isImmutable() || config->name().isEmpty()) {
+        Q_EMIT q->syncFinished(false);
+        return;
+    }
+
+    auto newJob = std::make_shared<KConfigPrivate::SyncJob>();
+    // sync() waits for the semaphore, so taking the job and writing it
+    // can't be interleaved with another sync of the same config
+    configPrivate()->syncSemaphore.acquire();
+    if (!configPrivate()->takeSyncJob(newJob.get())) {
+        configPrivate()->syncSemaphore.release();
+        Q_EMIT q->syncFinished(true);
+        return;
+    }
+
+    job = newJob;
+    KConfigPrivate *const writing = configPrivate();
+    QThreadPool::globalInstance()->start([this, writing, newJob]() {
+        KConfigPrivate::runSyncJob(newJob.get());
+        // flush() waits for the semaphore, so q is still alive until it is released
+        QMetaObject::invokeMethod(
+            q,
+            [this, newJob]() {
+                finishJob(newJob);
+            },
+            Qt::QueuedConnection);
+        writing->syncSemaphore.release();
+    });
+}
+
+void KConfigBackgroundSyncPrivate::finishJob(const std::shared_ptr<KConfigPrivate::SyncJob> &finished)
+{
+    if (finished != job) {
+        return; // flush() already finished it
+    }
+    job.reset();
+
+    if (!finished->succeeded) {
+        configPrivate()->restoreSyncJob(*finished);
+        // another process is writing the file, try again a little later
+        if (finished->lockBusy && ++lockRetries < s_maxLockRetries) {
+            requestedAgain = false;
+            timer.start();
+            return;
+        }
+        if (finished->lockBusy) {
+            qCWarning(KCONFIG_CORE_LOG) << "couldn't lock the files of" << config->name();
+        }
+    }
+    lockRetries = 0;
+    Q_EMIT q->syncFinished(finished->succeeded);
+
+    if (requestedAgain) {
+        requestedAgain = false;
+        startJob();
+    }
+}
+
+KConfigBackgroundSync::KConfigBackgroundSync(const KSharedConfig::Ptr &config, QObject *parent)
+    : QObject(parent)
+    , d(new KConfigBackgroundSyncPrivate(this))
+{
+    Q_ASSERT(config);
+    d->config = config;
+    d->timer.setSingleShot(true);
+    d->timer.setInterval(500);
+    connect(&d->timer, &QTimer::timeout, this, [this]() {
+        d->startJob();
+    });
+}
+
+KConfigBackgroundSync::~KConfigBackgroundSync()
+{
+    flush();
+}
+
+KSharedConfig::Ptr KConfigBackgroundSync::config() const
+{
+    return d->config;
+}
+
+void KConfigBackgroundSync::setInterval(int msec)
+{
+    d->timer.setInterval(msec);
+}
+
+int KConfigBackgroundSync::interval() const
+{
+    return d->timer.interval();
+}
+
+void KConfigBackgroundSync::requestSync()
+{
+    if (!d->timer.isActive()) {
+        d->timer.start();
+    }
+}
+
+bool KConfigBackgroundSync::isPending() const
+{
+    return d->timer.isActive() || d->job || d->requestedAgain;
+}
+
+bool KConfigBackgroundSync::flush()
+{
+    d->timer.stop();
+    d->requestedAgain = false;
+
+    bool success = true;
+    if (d->job) {
+        // wait for the thread pool to be done with it
+        d->configPrivate()->syncSemaphore.acquire();
+        d->configPrivate()->syncSemaphore.release();
+        const auto job = d->job;
+        // the entries of a job that found a file locked are written below
+        success = job->succeeded || job->lockBusy;
+        d->finishJob(job);
+        d->timer.stop();
+        d->lockRetries = 0;
+    }
+
+    if (d->config->isDirty()) {
+        success = d->config->sync() && success;
+        Q_EMIT syncFinished(success);
+    }
+    return success;
+}
@@ -0,0 +1,104 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGBACKGROUNDSYNC_H
+#define KCONFIGBACKGROUNDSYNC_H
+
+#include <QObject>
+#include <QScopedPointer>
+
+#include <KSharedConfig>
+
+#include <kconfigcore_export.h>
+
+class KConfigBackgroundSyncPrivate;
+
+/**
+ * \class KConfigBackgroundSync kconfigbackgroundsync.h <KConfigBackgroundSync>
+ *
+ * Writes the changes made to a config from a thread of the global thread pool.
+ *
+ * KConfig::sync() reparses the file, merges the changes into it and writes it
+ * out before it returns, which can take long enough to make a user interface
+ * stutter. requestSync() instead returns right away. All the requests made
+ * within interval() are combined into a single sync, which takes the dirty
+ * entries out of the config and writes them while the config can already be
+ * changed again.
+ *
+ * @code
+ * auto syncer = new KConfigBackgroundSync(KSharedConfig::openConfig(), this);
+ * KConfigGroup group(syncer->config(), "Window");
+ * group.writeEntry("Geometry", geometry);
+ * syncer->requestSync();
+ * @endcode
+ *
+ * A sync doesn't wait long for a file another process has locked: the
+ * entries are dirty again and the sync is tried once more after interval().
+ * syncFinished() reports a failure if the file stays locked for several
+ * attempts in a row.
+ *
+ * The config may only be used from the thread the KConfigBackgroundSync lives in.
+ * Destroying the KConfigBackgroundSync calls flush().
+ *
+ * @since 6.1
+ */
+class KCONFIGCORE_EXPORT KConfigBackgroundSync : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Syncs @p config in the background.
+     */
+    explicit KConfigBackgroundSync(const KSharedConfig::Ptr &config, QObject *parent = nullptr);
+    ~KConfigBackgroundSync() override;
+
+    /**
+     * Returns the config being synced
+     */
+    KSharedConfig::Ptr config() const;
+
+    /**
+     * Sets how long to wait for further requests after the first one,
+     * in milliseconds. The default is 500.
+     */
+    void setInterval(int msec);
+    /**
+     * @see setInterval()
+     */
+    int interval() const;
+
+    /**
+     * Syncs the config once interval() has passed, unless a sync is already due.
+     */
+    void requestSync();
+
+    /**
+     * Whether a sync was requested or is being written.
+     */
+    bool isPending() const;
+
+    /**
+     * Waits for the sync being written, then writes what is left synchronously,
+     * like KConfig::sync(). Call this before quitting.
+     * @return whether everything could be written
+     */
+    bool flush();
+
+Q_SIGNALS:
+    /**
+     * Emitted once a sync has been written, or failed to be.
+     * The entries of a failed sync are dirty again.
+     */
+    void syncFinished(bool success);
+
+private:
+    Q_DISABLE_COPY(KConfigBackgroundSync)
+    friend class KConfigBackgroundSyncPrivate;
+    const QScopedPointer<KConfigBackgroundSyncPrivate> d;
+};
+
+#endif // KCONFIGBACKGROUNDSYNC_H
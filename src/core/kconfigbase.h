@@ -54,6 +54,14 @@ public:
          * Implied persistent
          * @since 5.51
          */
+        Binary = 0x10 | Persistent,
+        /**<
+         * Write the value base64 encoded, marked with [$b], rather than with
+         * every byte that isn't printable escaped. Much shorter for binary
+         * data like QMainWindow::saveState(), but older versions of KConfig
+         * read the base64 text instead of the data. Implied persistent
+         * @since 6.1
+         */
         Normal = Persistent,
         /**<
          * Save the entry to the application specific config file without
@@ -0,0 +1,911 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kconfigcompiled_p.h"
+
+#include "bufferfragment_p.h"
+#include "kconfig_core_log_settings.h"
+#include "kconfigdata_p.h"
+#include "kconfigstringpool_p.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring> // memchr, memcmp
+#include <limits>
+
+extern bool kde_kiosk_exception;
+
+using BufferFragment = KConfigIniBackend::BufferFragment;
+
+// Layout of a compiled file, in the byte order of the machine that compiled it:
+// the header, the group records sorted by name, the entry records of all groups
+// and then the strings they point to.
+static constexpr char s_magic[8] = {'K', 'C', 'F', 'G', 'B', 'I', 'N', '1'};
+static constexpr quint32 s_byteOrder = 0x01020304;
+static constexpr quint32 s_nullSize = 0xffffffff;
+
+namespace
+{
+struct Header {
+    char magic[8];
+    quint32 byteOrder;
+    quint32 flags;
+    // the stamp of the source file when it was compiled
+    qint64 sourceSize;
+    qint64 sourceModified;
+    quint32 groupCount;
+    quint32 entryCount;
+    quint32 stringsSize;
+    quint32 reserved;
+};
+
+enum HeaderFlag : quint32 {
+    FileImmutable = 0x1,
+};
+
+enum RecordFlag : quint32 {
+    Immutable = 0x1,
+    Expand = 0x2,
+    Deleted = 0x4,
+    Binary = 0x8, // the value was base64 encoded, it is stored decoded
+};
+}
+
+struct KConfigCompiledFile::StringRef {
+    quint32 offset;
+    quint32 size; // s_nullSize for a null string
+};
+
+struct KConfigCompiledFile::GroupRecord {
+    StringRef name;
+    quint32 firstEntry;
+    quint32 entryCount;
+    quint32 flags; // Immutable if the group is marked with [$i]
+};
+
+struct KConfigCompiledFile::EntryRecord {
+    StringRef key;
+    StringRef locale;
+    StringRef value;
+    quint32 flags;
+};
+
+static_assert(sizeof(Header) % alignof(KConfigCompiledFile::GroupRecord) == 0);
+static_assert(sizeof(KConfigCompiledFile::GroupRecord) % alignof(KConfigCompiledFile::EntryRecord) == 0);
+
+// Layout of a bundle: the header, the file records sorted by name, the strings they
+// point to and then the compiled files, each starting at a multiple of s_bundleAlignment.
+static constexpr char s_bundleMagic[8] = {'K', 'C', 'F', 'G', 'B', 'D', 'L', '1'};
+static constexpr quint64 s_bundleAlignment = 8;
+
+namespace
+{
+struct BundleHeader {
+    char magic[8];
+    quint32 byteOrder;
+    quint32 fileCount;
+    quint32 stringsSize;
+    quint32 reserved;
+};
+
+// The bundles opened by the process, with the modification time of their directory then
+struct BundleCache {
+    struct Bundle {
+        qint64 directoryModified;
+        std::shared_ptr<const KConfigDefaultsBundle> bundle; // null if the directory has none
+    };
+    QMutex mutex;
+    QHash<QString, Bundle> bundles;
+};
+}
+Q_GLOBAL_STATIC(BundleCache, s_bundleCache)
+
+// Every file of the directory has a record, so that a file missing from the bundle is
+// known to be missing from the directory. Only the files packed have a compiled file.
+struct KConfigDefaultsBundle::FileRecord {
+    quint32 nameOffset; // of the UTF-8 name of the file in the directory
+    quint32 nameSize;
+    quint32 canonicalPathOffset;
+    quint32 canonicalPathSize;
+    quint64 offset; // of the compiled file, 0 if it wasn't packed
+    quint64 size;
+};
+
+static_assert(sizeof(BundleHeader) % alignof(KConfigDefaultsBundle::FileRecord) == 0);
+static_assert(alignof(Header) <= s_bundleAlignment);
+
+static QByteArray internValue(QByteArrayView value)
+{
+    if (value.size() <= KEntryValue::InlineCapacity) {
+        // the entry stores a copy inline, neither the pool nor an allocation is needed
+        return QByteArray::fromRawData(value.data(), value.size());
+    }
+    return value.size() <= KConfigStringPool::maxValueSize ? KConfigStringPool::intern(value) : value.toByteArray();
+}
+
+std::shared_ptr<const KConfigCompiledFile> KConfigCompiledFile::open(const QString &sourceFile)
+{
+    if (sourceFile.isEmpty()) {
+        return {};
+    }
+
+    std::shared_ptr<KConfigCompiledFile> compiled(new KConfigCompiledFile);
+    compiled->m_file.setFileName(KConfigCompiledBackend::compiledPath(sourceFile));
+    compiled->m_fileName = compiled->m_file.fileName();
+    if (!compiled->m_file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    // The mapping stays valid until the file is closed, the records point into it
+    const qint64 size = compiled->m_file.size();
+    const uchar *data = size >= qint64(sizeof(Header)) ? compiled->m_file.map(0, size) : nullptr;
+    if (!data || !compiled->load(data, size)) {
+        qCWarning(KCONFIG_CORE_LOG) << "Ignoring invalid compiled config file" << compiled->fileName();
+        return {};
+    }
+
+    const auto *header = reinterpret_cast<const Header *>(data);
+    const QFileInfo source(sourceFile);
+    if (header->sourceSize != source.size() || header->sourceModified != source.lastModified().toMSecsSinceEpoch()) {
+        qCDebug(KCONFIG_CORE_LOG) << "Ignoring" << compiled->fileName() << "which is older than" << sourceFile;
+        return {};
+    }
+    return compiled;
+}
+
+std::shared_ptr<const KConfigCompiledFile> KConfigCompiledFile::fromBundle(const std::shared_ptr<const KConfigDefaultsBundle> &bundle,
+                                                                           const uchar *data,
+                                                                           qint64 size,
+                                                                           const QString &sourceFile)
+{
+    std::shared_ptr<KConfigCompiledFile> compiled(new KConfigCompiledFile);
+    compiled->m_fileName = sourceFile;
+    // the bundle keeps the mapping, its directory is checked rather than the stamp of each file
+    compiled->m_bundle = bundle;
+    if (!compiled->load(data, size)) {
+        qCWarning(KCONFIG_CORE_LOG) << "Ignoring invalid compiled config file for" << sourceFile << "in" << KConfigDefaultsBundle::bundlePath(bundle->directory());
+        return {};
+    }
+    return compiled;
+}
+
+bool KConfigCompiledFile::load(const uchar *data, qint64 size)
+{
+    if (size < qint64(sizeof(Header))) {
+        return false;
+    }
+    const auto *header = reinterpret_cast<const Header *>(data);
+    const qint64 tablesSize = qint64(header->groupCount) * sizeof(GroupRecord) + qint64(header->entryCount) * sizeof(EntryRecord);
+    if (memcmp(header->magic, s_magic, sizeof(s_magic)) != 0 || header->byteOrder != s_byteOrder
+        || qint64(sizeof(Header)) + tablesSize + header->stringsSize != size) {
+        return false;
+    }
+
+    m_immutable = header->flags & FileImmutable;
+    m_groups = reinterpret_cast<const GroupRecord *>(data + sizeof(Header));
+    m_groupCount = header->groupCount;
+    m_entries = reinterpret_cast<const EntryRecord *>(m_groups + header->groupCount);
+    m_entryCount = header->entryCount;
+    m_strings = reinterpret_cast<const char *>(m_entries + header->entryCount);
+    m_stringsSize = header->stringsSize;
+    return true;
+}
+
+QByteArrayView KConfigCompiledFile::string(const StringRef &ref) const
+{
+    if (ref.size == s_nullSize || ref.offset > m_stringsSize || ref.size > m_stringsSize - ref.offset) {
+        return {};
+    }
+    return QByteArrayView(m_strings + ref.offset, ref.size);
+}
+
+const KConfigCompiledFile::GroupRecord *KConfigCompiledFile::findGroup(QByteArrayView name) const
+{
+    const GroupRecord *end = m_groups + m_groupCount;
+    const GroupRecord *it = std::lower_bound(m_groups, end, name, [this](const GroupRecord &record, QByteArrayView name) {
+        return string(record.name).compare(name) < 0;
+    });
+    return it != end && string(it->name) == name ? it : nullptr;
+}
+
+bool KConfigCompiledFile::parseGroup(const QByteArray &currentLocale,
+                                     KEntryMap &entryMap,
+                                     const QByteArray &group,
+                                     const GroupRecord &record,
+                                     KConfigBackend::ParseOptions options) const
+{
+    // Same rules as KConfigIniBackend::parseLines(), only the parsing is done already
+    const bool bDefault = options & KConfigBackend::ParseDefaults;
+    if (!bDefault && entryMap.getEntryOption(group, {}, {}, KEntryMap::EntryImmutable)) {
+        return false;
+    }
+    if (record.firstEntry > m_entryCount || record.entryCount > m_entryCount - record.firstEntry) {
+        return false;
+    }
+
+    const int langIdx = currentLocale.indexOf('_');
+    const QByteArray currentLanguage = langIdx >= 0 ? currentLocale.left(langIdx) : currentLocale;
+
+    const EntryRecord *end = m_entries + record.firstEntry + record.entryCount;
+    for (const EntryRecord *entry = m_entries + record.firstEntry; entry != end; ++entry) {
+        KEntryMap::EntryOptions entryOptions = {};
+        if ((entry->flags & Immutable) && !kde_kiosk_exception) {
+            entryOptions |= KEntryMap::EntryImmutable;
+        }
+        if ((entry->flags & Expand) && (options & KConfigBackend::ParseExpansions)) {
+            entryOptions |= KEntryMap::EntryExpansion;
+        }
+        if (entry->flags & Binary) {
+            entryOptions |= KEntryMap::EntryBinary;
+        }
+
+        const QByteArray key = KConfigStringPool::intern(string(entry->key));
+        if (entry->flags & Deleted) {
+            entryOptions |= KEntryMap::EntryDeleted;
+            entryMap.setEntry(group, key, QByteArray(), entryOptions);
+            continue;
+        }
+
+        const QByteArrayView locale = string(entry->locale);
+        if (!locale.isEmpty() && locale != currentLocale && locale != currentLanguage) {
+            // backward compatibility. C == en_US
+            if (locale.front() != 'C' || currentLocale != "en_US") {
+                continue;
+            }
+        }
+
+        if (options & KConfigBackend::ParseGlobal) {
+            entryOptions |= KEntryMap::EntryGlobal;
+        }
+        if (bDefault) {
+            entryOptions |= KEntryMap::EntryDefault;
+        }
+        if (!locale.isNull()) {
+            entryOptions |= KEntryMap::EntryLocalized;
+            if (memchr(locale.data(), '_', locale.size())) {
+                entryOptions |= KEntryMap::EntryLocalizedCountry;
+            }
+        }
+        entryMap.setEntry(group, key, internValue(string(entry->value)), entryOptions);
+    }
+
+    return (record.flags & Immutable) && !kde_kiosk_exception;
+}
+
+void KConfigCompiledFile::parseGroup(const QByteArray &currentLocale, KEntryMap &entryMap, const QByteArray &group, KConfigBackend::ParseOptions options) const
+{
+    const GroupRecord *record = findGroup(group);
+    if (record && parseGroup(currentLocale, entryMap, group, *record, options)) {
+        entryMap.setEntry(group, QByteArray(), QByteArray(), KEntryMap::EntryImmutable);
+    }
+}
+
+KConfigBackend::ParseInfo KConfigCompiledFile::parse(const QByteArray &currentLocale, KEntryMap &entryMap, KConfigBackend::ParseOptions options) const
+{
+    QList<QByteArray> immutableGroups;
+    for (const GroupRecord *record = m_groups; record != m_groups + m_groupCount; ++record) {
+        const QByteArray group = KConfigStringPool::intern(string(record->name));
+        if (parseGroup(currentLocale, entryMap, group, *record, options)) {
+            immutableGroups.append(group);
+        }
+    }
+
+    // the groups become immutable once the whole file has been read
+    for (const QByteArray &group : std::as_const(immutableGroups)) {
+        entryMap.setEntry(group, QByteArray(), QByteArray(), KEntryMap::EntryImmutable);
+    }
+
+    return m_immutable && !kde_kiosk_exception ? KConfigBackend::ParseImmutable : KConfigBackend::ParseOk;
+}
+
+KConfigBackend::ParseInfo KConfigCompiledFile::index(const QByteArray &currentLocale,
+                                                     KEntryMap &entryMap,
+                                                     KConfigBackend::ParseOptions options,
+                                                     KConfigIniBackend::GroupIndex &index,
+                                                     const std::shared_ptr<const KConfigCompiledFile> &self) const
+{
+    const QByteArray defaultGroup = QByteArrayLiteral("<default>");
+    for (const GroupRecord *record = m_groups; record != m_groups + m_groupCount; ++record) {
+        const QByteArray group = KConfigStringPool::intern(string(record->name));
+        if (group == defaultGroup) {
+            if (parseGroup(currentLocale, entryMap, group, *record, options)) {
+                entryMap.setEntry(group, QByteArray(), QByteArray(), KEntryMap::EntryImmutable);
+            }
+            continue;
+        }
+        // the segment has no buffer, parseGroupSegments() looks the group up in the compiled file
+        KConfigIniBackend::GroupSegment segment{{}, fileName(), 0, 0, 0, options, false, self};
+        index[group].append(segment);
+    }
+
+    return m_immutable && !kde_kiosk_exception ? KConfigBackend::ParseImmutable : KConfigBackend::ParseOk;
+}
+
+KConfigBackend::ParseInfo KConfigCompiledBackend::parseConfig(const QByteArray &currentLocale, KEntryMap &entryMap, ParseOptions options)
+{
+    if (const auto compiled = KConfigCompiledFile::open(filePath())) {
+        return compiled->parse(currentLocale, entryMap, options);
+    }
+    return KConfigIniBackend::parseConfig(currentLocale, entryMap, options);
+}
+
+bool KConfigCompiledBackend::writeConfig(const QByteArray &currentLocale, KEntryMap &entryMap, WriteOptions options)
+{
+    if (!KConfigIniBackend::writeConfig(currentLocale, entryMap, options)) {
+        return false;
+    }
+    // Changes that only went to the journal leave the source as it was, and the compiled
+    // file is not read while there is a journal anyway. It is compiled once it is folded in.
+    const QString compiledFile = compiledPath(filePath());
+    if (QFileInfo::exists(compiledFile) && !QFileInfo::exists(journalPath(filePath()))) {
+        // a failure only leaves the compiled file stale, the source is written
+        compile(filePath(), compiledFile);
+    }
+    return true;
+}
+
+KConfigBackend::ParseInfo
+KConfigCompiledBackend::parseCompiledFile(const QString &fileName, const QByteArray &currentLocale, KEntryMap &entryMap, ParseOptions options)
+{
+    // the defaults of the system may have been packed with the other files of their directory
+    if (options & ParseDefaults) {
+        if (const auto bundled = KConfigDefaultsBundle::compiledFile(fileName)) {
+            return bundled->parse(currentLocale, entryMap, options);
+        }
+    }
+    // Most files aren't compiled, see the class documentation
+    if (fileName.isEmpty() || (!(options & ParseDefaults) && !isRegistered(fileName))) {
+        return parseFile(fileName, currentLocale, entryMap, options);
+    }
+    // The records of a journal are only replayed from the file itself. The defaults of the
+    // system have none, the journal of any other file is looked for once, here.
+    ParseOptions fileOptions = options;
+    if (!(options & ParseDefaults)) {
+        if (QFileInfo::exists(journalPath(fileName))) {
+            return parseJournaled(fileName, currentLocale, entryMap, options, false);
+        }
+        fileOptions |= ParseNoJournal;
+    }
+    if (const auto compiled = KConfigCompiledFile::open(fileName)) {
+        return compiled->parse(currentLocale, entryMap, options);
+    }
+    return parseFile(fileName, currentLocale, entryMap, fileOptions);
+}
+
+KConfigBackend::ParseInfo KConfigCompiledBackend::indexCompiledFile(const QString &fileName,
+                                                                    const QByteArray &currentLocale,
+                                                                    KEntryMap &entryMap,
+                                                                    ParseOptions options,
+                                                                    GroupIndex &index)
+{
+    if (options & ParseDefaults) {
+        if (const auto bundled = KConfigDefaultsBundle::compiledFile(fileName)) {
+            return bundled->index(currentLocale, entryMap, options, index, bundled);
+        }
+    }
+    // as parseCompiledFile()
+    if (fileName.isEmpty() || (!(options & ParseDefaults) && !isRegistered(fileName))) {
+        return indexFile(fileName, currentLocale, entryMap, options, index);
+    }
+    ParseOptions fileOptions = options;
+    if (!(options & ParseDefaults)) {
+        if (QFileInfo::exists(journalPath(fileName))) {
+            // the records may change any group
+            return parseJournaled(fileName, currentLocale, entryMap, options, false);
+        }
+        fileOptions |= ParseNoJournal;
+    }
+    if (const auto compiled = KConfigCompiledFile::open(fileName)) {
+        return compiled->index(currentLocale, entryMap, options, index, compiled);
+    }
+    return indexFile(fileName, currentLocale, entryMap, fileOptions, index);
+}
+
+QString KConfigCompiledBackend::compiledPath(const QString &sourceFile)
+{
+    return sourceFile + QLatin1String(".compiled");
+}
+
+namespace
+{
+// The files kcompileconfig6 registered, one absolute path per line
+struct CompiledRegistry {
+    QMutex mutex;
+    bool loaded = false;
+    QSet<QString> files;
+
+    static QString path()
+    {
+        return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QLatin1String("/kconfig/compiledfiles");
+    }
+    // with the mutex held
+    void load()
+    {
+        if (loaded) {
+            return;
+        }
+        loaded = true;
+        QFile file(path());
+        if (!file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+        const QList<QByteArray> lines = file.readAll().split('\n');
+        for (const QByteArray &line : lines) {
+            if (!line.isEmpty()) {
+                files.insert(QFile::decodeName(line));
+            }
+        }
+    }
+};
+}
+
+Q_GLOBAL_STATIC(CompiledRegistry, s_compiledRegistry)
+
+bool KConfigCompiledBackend::isRegistered(const QString &sourceFile)
+{
+    CompiledRegistry *registry = s_compiledRegistry();
+    if (!registry) {
+        return false;
+    }
+    QMutexLocker locker(&registry->mutex);
+    registry->load();
+    return registry->files.contains(sourceFile);
+}
+
+bool KConfigCompiledBackend::setRegistered(const QString &sourceFile, bool registered)
+{
+    CompiledRegistry *registry = s_compiledRegistry();
+    QMutexLocker locker(&registry->mutex);
+    // read again, another process may have changed it
+    registry->loaded = false;
+    registry->files.clear();
+    registry->load();
+
+    const QString file = QFileInfo(sourceFile).absoluteFilePath();
+    if (registry->files.contains(file) == registered) {
+        return true;
+    }
+    if (registered) {
+        registry->files.insert(file);
+    } else {
+        registry->files.remove(file);
+    }
+
+    const QString path = CompiledRegistry::path();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qCWarning(KCONFIG_CORE_LOG) << "Could not write" << path << out.errorString();
+        return false;
+    }
+    QStringList files(registry->files.cbegin(), registry->files.cend());
+    files.sort();
+    for (const QString &registeredFile : std::as_const(files)) {
+        out.write(QFile::encodeName(registeredFile) + '\n');
+    }
+    if (!out.commit()) {
+        qCWarning(KCONFIG_CORE_LOG) << "Could not write" << path << out.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool KConfigCompiledBackend::compileImage(const QString &sourceFile, QByteArray *image)
+{
+    using StringRef = KConfigCompiledFile::StringRef;
+    using GroupRecord = KConfigCompiledFile::GroupRecord;
+    using EntryRecord = KConfigCompiledFile::EntryRecord;
+
+    QFile file(sourceFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qCWarning(KCONFIG_CORE_LOG) << "Could not open" << sourceFile << file.errorString();
+        return false;
+    }
+    // taken before reading, a change while reading makes the compiled file stale rather than wrong
+    const QFileInfo sourceInfo(sourceFile);
+    QByteArray buffer = file.readAll();
+    BufferFragment contents(buffer.data(), buffer.size());
+
+    struct Entry {
+        QByteArray key;
+        QByteArray locale;
+        QByteArray value;
+        quint32 flags;
+    };
+    struct Group {
+        bool immutable = false;
+        QList<Entry> entries;
+    };
+    QMap<QByteArray, Group> groups;
+
+    // Tokenizes the file like parseLines() does, but keeps the entries of all locales
+    bool fileImmutable = false;
+    bool groupImmutable = false;
+    QByteArray currentGroup = QByteArrayLiteral("<default>");
+    const unsigned int len = contents.length();
+    unsigned int startOfLine = 0;
+    int lineNo = 0;
+    while (startOfLine < len) {
+        BufferFragment line = contents.split('\n', &startOfLine);
+        line.trim();
+        ++lineNo;
+
+        if (line.isEmpty() || line.at(0) == '#') {
+            continue;
+        }
+
+        if (line.at(0) == '[') {
+            groupImmutable = fileImmutable;
+
+            QByteArray newGroup;
+            bool immutable = false;
+            if (!parseGroupHeader(line, file, lineNo, &newGroup, &immutable)) {
+                continue;
+            }
+            if (immutable) {
+                if (newGroup.isEmpty()) {
+                    fileImmutable = true;
+                } else {
+                    groupImmutable = true;
+                }
+            }
+            currentGroup = newGroup;
+            if (groupImmutable) {
+                groups[currentGroup].immutable = true;
+            }
+            continue;
+        }
+
+        EntryToken token;
+        if (!parseEntryLine(line, file, lineNo, &token)) {
+            continue;
+        }
+
+        Entry entry;
+        entry.flags = 0;
+        if (groupImmutable || token.immutable) {
+            entry.flags |= Immutable;
+        }
+        if (token.expand) {
+            entry.flags |= Expand;
+        }
+        if (token.binary) {
+            entry.flags |= Binary;
+        }
+
+        BufferFragment key = token.key;
+        printableToString(&key, file, lineNo);
+        if (token.deleted) {
+            entry.flags |= Deleted;
+        } else {
+            // parseLines() decodes the key of an entry it keeps a second time
+            printableToString(&key, file, lineNo);
+            if (!token.locale.isNull()) {
+                entry.locale = QByteArray(token.locale.constData(), token.locale.length());
+            }
+            BufferFragment value = token.value;
+            if (token.binary) {
+                entry.value = QByteArray::fromBase64(value.toVolatileByteArray());
+            } else {
+                printableToString(&value, file, lineNo);
+                entry.value = QByteArray(value.constData(), value.length());
+            }
+        }
+        entry.key = key.toByteArray();
+        groups[currentGroup].entries.append(entry);
+    }
+
+    QByteArray strings;
+    QHash<QByteArray, StringRef> stringRefs;
+    const auto addString = [&strings, &stringRefs](const QByteArray &string) -> StringRef {
+        if (string.isNull()) {
+            return {0, s_nullSize};
+        }
+        auto it = stringRefs.constFind(string);
+        if (it == stringRefs.constEnd()) {
+            it = stringRefs.insert(string, {quint32(strings.size()), quint32(string.size())});
+            strings.append(string);
+        }
+        return *it;
+    };
+
+    QList<GroupRecord> groupRecords;
+    groupRecords.reserve(groups.size());
+    QList<EntryRecord> entryRecords;
+    for (auto it = groups.cbegin(); it != groups.cend(); ++it) {
+        groupRecords.append({addString(it.key()), quint32(entryRecords.size()), quint32(it->entries.size()), it->immutable ? quint32(Immutable) : 0});
+        for (const Entry &entry : it->entries) {
+            entryRecords.append({addString(entry.key), addString(entry.locale), addString(entry.value), entry.flags});
+        }
+    }
+    if (strings.size() >= qsizetype(std::numeric_limits<quint32>::max())) {
+        qCWarning(KCONFIG_CORE_LOG) << sourceFile << "is too large to be compiled";
+        return false;
+    }
+
+    Header header{};
+    memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.byteOrder = s_byteOrder;
+    header.flags = fileImmutable ? FileImmutable : 0;
+    header.sourceSize = sourceInfo.size();
+    header.sourceModified = sourceInfo.lastModified().toMSecsSinceEpoch();
+    header.groupCount = groupRecords.size();
+    header.entryCount = entryRecords.size();
+    header.stringsSize = strings.size();
+
+    image->clear();
+    image->reserve(sizeof(header) + groupRecords.size() * sizeof(GroupRecord) + entryRecords.size() * sizeof(EntryRecord) + strings.size());
+    image->append(reinterpret_cast<const char *>(&header), sizeof(header));
+    image->append(reinterpret_cast<const char *>(groupRecords.constData()), groupRecords.size() * sizeof(GroupRecord));
+    image->append(reinterpret_cast<const char *>(entryRecords.constData()), entryRecords.size() * sizeof(EntryRecord));
+    image->append(strings);
+    return true;
+}
+
+bool KConfigCompiledBackend::compile(const QString &sourceFile, const QString &compiledFile)
+{
+    QByteArray image;
+    if (!compileImage(sourceFile, &image)) {
+        return false;
+    }
+
+    QSaveFile out(compiledFile);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qCWarning(KCONFIG_CORE_LOG) << "Could not write" << compiledFile << out.errorString();
+        return false;
+    }
+    out.write(image);
+    if (!out.commit()) {
+        qCWarning(KCONFIG_CORE_LOG) << "Could not write" << compiledFile << out.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool KConfigCompiledBackend::pack(const QString &directory, const QStringList &files)
+{
+    using FileRecord = KConfigDefaultsBundle::FileRecord;
+
+    const QString bundleFile = KConfigDefaultsBundle::bundlePath(directory);
+    QStringList names = QDir(directory).entryList(QDir::Files | QDir::Hidden);
+    names.removeOne(QFileInfo(bundleFile).fileName());
+    for (const QString &file : files) {
+        if (!names.contains(file)) {
+            qCWarning(KCONFIG_CORE_LOG) << "There is no file" << file << "in" << directory;
+            return false;
+        }
+    }
+
+    struct File {
+        QByteArray name;
+        QByteArray canonicalPath;
+        QByteArray image;
+    };
+    QList<File> packed;
+    packed.reserve(names.size());
+    for (const QString &name : std::as_const(names)) {
+        const QString path = directory + QLatin1Char('/') + name;
+        File file{name.toUtf8(), QFileInfo(path).canonicalFilePath().toUtf8(), {}};
+        if ((files.isEmpty() || files.contains(name)) && !compileImage(path, &file.image)) {
+            return false;
+        }
+        packed.append(std::move(file));
+    }
+    std::sort(packed.begin(), packed.end(), [](const File &a, const File &b) {
+        return a.name < b.name;
+    });
+
+    QByteArray strings;
+    for (const File &file : std::as_const(packed)) {
+        strings += file.name;
+        strings += file.canonicalPath;
+    }
+    if (strings.size() >= qsizetype(std::numeric_limits<quint32>::max())) {
+        qCWarning(KCONFIG_CORE_LOG) << directory << "has too many files to be packed";
+        return false;
+    }
+
+    const auto align = [](quint64 offset) {
+        return (offset + s_bundleAlignment - 1) / s_bundleAlignment * s_bundleAlignment;
+    };
+    const quint64 imagesOffset = align(sizeof(BundleHeader) + packed.size() * sizeof(FileRecord) + strings.size());
+    QList<FileRecord> records;
+    records.reserve(packed.size());
+    quint32 stringOffset = 0;
+    quint64 imageOffset = imagesOffset;
+    for (const File &file : std::as_const(packed)) {
+        FileRecord record{stringOffset, quint32(file.name.size()), 0, quint32(file.canonicalPath.size()), 0, quint64(file.image.size())};
+        stringOffset += file.name.size();
+        record.canonicalPathOffset = stringOffset;
+        stringOffset += file.canonicalPath.size();
+        if (!file.image.isEmpty()) {
+            record.offset = imageOffset;
+            imageOffset = align(imageOffset + file.image.size());
+        }
+        records.append(record);
+    }
+
+    BundleHeader header{};
+    memcpy(header.magic, s_bundleMagic, sizeof(s_bundleMagic));
+    header.byteOrder = s_byteOrder;
+    header.fileCount = records.size();
+    header.stringsSize = strings.size();
+
+    QSaveFile out(bundleFile);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qCWarning(KCONFIG_CORE_LOG) << "Could not write" << bundleFile << out.errorString();
+        return false;
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(records.constData()), records.size() * sizeof(FileRecord));
+    out.write(strings);
+    for (const File &file : std::as_const(packed)) {
+        if (!file.image.isEmpty()) {
+            out.write(QByteArray(align(out.pos()) - out.pos(), '\0'));
+            out.write(file.image);
+        }
+    }
+    if (!out.commit()) {
+        qCWarning(KCONFIG_CORE_LOG) << "Could not write" << bundleFile << out.errorString();
+        return false;
+    }
+
+    // Moving the bundle into the directory modified it, the bundle must not be older
+    QFile written(bundleFile);
+    if (!written.open(QIODevice::ReadWrite) || !written.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime)) {
+        qCWarning(KCONFIG_CORE_LOG) << "Could not set the modification time of" << bundleFile << written.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString KConfigDefaultsBundle::bundlePath(const QString &directory)
+{
+    return directory + QLatin1String("/kconfig-defaults.bundle");
+}
+
+std::shared_ptr<const KConfigDefaultsBundle> KConfigDefaultsBundle::open(const QString &directory)
+{
+    const QDateTime modified = QFileInfo(directory).lastModified();
+    if (!modified.isValid()) {
+        return {};
+    }
+    const qint64 directoryModified = modified.toMSecsSinceEpoch();
+
+    BundleCache &cache = *s_bundleCache;
+    {
+        QMutexLocker locker(&cache.mutex);
+        const auto it = cache.bundles.constFind(directory);
+        if (it != cache.bundles.constEnd() && it->directoryModified == directoryModified) {
+            return it->bundle;
+        }
+    }
+
+    // A directory without a bundle is remembered as well: adding one modifies the directory
+    std::shared_ptr<const KConfigDefaultsBundle> bundle = load(directory, directoryModified);
+    QMutexLocker locker(&cache.mutex);
+    cache.bundles.insert(directory, {directoryModified, bundle});
+    return bundle;
+}
+
+qint64 KConfigDefaultsBundle::trimCache(bool all)
+{
+    if (!s_bundleCache.exists()) {
+        return 0;
+    }
+    BundleCache &cache = *s_bundleCache;
+    QMutexLocker locker(&cache.mutex);
+    qint64 freed = 0;
+    for (auto it = cache.bundles.begin(); it != cache.bundles.end();) {
+        const bool unused = !it->bundle || it->bundle.use_count() == 1;
+        if (!all && !unused) {
+            ++it;
+            continue;
+        }
+        if (it->bundle && unused) {
+            freed += it->bundle->m_size;
+        }
+        it = cache.bundles.erase(it);
+    }
+    return freed;
+}
+
+std::shared_ptr<const KConfigDefaultsBundle> KConfigDefaultsBundle::load(const QString &directory, qint64 directoryModified)
+{
+    const QFileInfo info(bundlePath(directory));
+    if (!info.isFile()) {
+        return {};
+    }
+    if (info.lastModified().toMSecsSinceEpoch() < directoryModified) {
+        qCDebug(KCONFIG_CORE_LOG) << "Ignoring" << info.filePath() << "which is older than the files of" << directory;
+        return {};
+    }
+
+    std::shared_ptr<KConfigDefaultsBundle> bundle(new KConfigDefaultsBundle);
+    bundle->m_directory = directory;
+    bundle->m_file.setFileName(info.filePath());
+    if (!bundle->m_file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    // The mapping stays valid until the file is closed, the compiled files point into it
+    const qint64 size = bundle->m_file.size();
+    const uchar *data = size >= qint64(sizeof(BundleHeader)) ? bundle->m_file.map(0, size) : nullptr;
+    const auto *header = reinterpret_cast<const BundleHeader *>(data);
+    if (!data || memcmp(header->magic, s_bundleMagic, sizeof(s_bundleMagic)) != 0 || header->byteOrder != s_byteOrder
+        || qint64(sizeof(BundleHeader)) + qint64(header->fileCount) * qint64(sizeof(FileRecord)) + header->stringsSize > size) {
+        qCWarning(KCONFIG_CORE_LOG) << "Ignoring invalid config bundle" << info.filePath();
+        return {};
+    }
+
+    bundle->m_data = data;
+    bundle->m_size = size;
+    bundle->m_files = reinterpret_cast<const FileRecord *>(data + sizeof(BundleHeader));
+    bundle->m_fileCount = header->fileCount;
+    bundle->m_strings = reinterpret_cast<const char *>(bundle->m_files + header->fileCount);
+    bundle->m_stringsSize = header->stringsSize;
+    return bundle;
+}
+
+QByteArrayView KConfigDefaultsBundle::string(quint32 offset, quint32 size) const
+{
+    if (offset > m_stringsSize || size > m_stringsSize - offset) {
+        return {};
+    }
+    return QByteArrayView(m_strings + offset, size);
+}
+
+QByteArrayView KConfigDefaultsBundle::name(const FileRecord &record) const
+{
+    return string(record.nameOffset, record.nameSize);
+}
+
+const KConfigDefaultsBundle::FileRecord *KConfigDefaultsBundle::find(QStringView fileName) const
+{
+    const QByteArray utf8Name = fileName.toUtf8();
+    const FileRecord *end = m_files + m_fileCount;
+    const FileRecord *it = std::lower_bound(m_files, end, utf8Name, [this](const FileRecord &record, const QByteArray &key) {
+        return name(record).compare(key) < 0;
+    });
+    return it != end && name(*it) == utf8Name ? it : nullptr;
+}
+
+QString KConfigDefaultsBundle::canonicalFilePath(QStringView fileName) const
+{
+    const FileRecord *record = find(fileName);
+    if (!record) {
+        return QString();
+    }
+    return QString::fromUtf8(string(record->canonicalPathOffset, record->canonicalPathSize));
+}
+
+std::shared_ptr<const KConfigCompiledFile> KConfigDefaultsBundle::compiledFile(const QString &sourceFile)
+{
+    const qsizetype slash = sourceFile.lastIndexOf(QLatin1Char('/'));
+    if (slash <= 0) {
+        return {};
+    }
+    const std::shared_ptr<const KConfigDefaultsBundle> bundle = open(sourceFile.left(slash));
+    const FileRecord *record = bundle ? bundle->find(QStringView(sourceFile).mid(slash + 1)) : nullptr;
+    if (!record || record->size == 0) {
+        return {};
+    }
+    if (record->offset % s_bundleAlignment != 0 || record->offset > quint64(bundle->m_size) || record->size > quint64(bundle->m_size) - record->offset) {
+        qCWarning(KCONFIG_CORE_LOG) << "Ignoring invalid compiled config file for" << sourceFile << "in" << bundle->m_file.fileName();
+        return {};
+    }
+    return KConfigCompiledFile::fromBundle(bundle, bundle->m_data + record->offset, record->size, sourceFile);
+}
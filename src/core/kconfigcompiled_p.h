@@ -0,0 +1,190 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGCOMPILED_P_H
+#define KCONFIGCOMPILED_P_H
+
+#include "kconfigini_p.h"
+
+#include <QFile>
+
+#include <memory>
+
+class KConfigDefaultsBundle;
+
+/**
+ * A config file compiled by kcompileconfig6, mapped into memory.
+ *
+ * The file holds a table of the groups sorted by name, the entries of each
+ * group in the order of the source file, and the strings they point to,
+ * with their escape sequences already decoded. The .ini file stays the
+ * source of truth: the compiled file is only used as long as the size and
+ * the modification time of the source match the ones it was compiled from,
+ * or, for a file of a KConfigDefaultsBundle, as long as the bundle is.
+ *
+ * @internal
+ */
+class KConfigCompiledFile
+{
+public:
+    struct StringRef;
+    struct GroupRecord;
+    struct EntryRecord;
+
+    // Returns the compiled file of @p sourceFile, or null if there is none or it is stale
+    static std::shared_ptr<const KConfigCompiledFile> open(const QString &sourceFile);
+    // Returns the compiled file of @p sourceFile at @p data in the mapping of @p bundle, or null if it is invalid
+    static std::shared_ptr<const KConfigCompiledFile>
+    fromBundle(const std::shared_ptr<const KConfigDefaultsBundle> &bundle, const uchar *data, qint64 size, const QString &sourceFile);
+
+    // Adds all the entries to @p entryMap, as KConfigIniBackend::parseConfig() does for the source
+    KConfigBackend::ParseInfo parse(const QByteArray &locale, KEntryMap &entryMap, KConfigBackend::ParseOptions options) const;
+    // Adds the entries of the default group to @p entryMap and the other groups to @p index
+    KConfigBackend::ParseInfo index(const QByteArray &locale,
+                                    KEntryMap &entryMap,
+                                    KConfigBackend::ParseOptions options,
+                                    KConfigIniBackend::GroupIndex &index,
+                                    const std::shared_ptr<const KConfigCompiledFile> &self) const;
+    // Adds the entries of @p group to @p entryMap, found by a binary search of the group table
+    void parseGroup(const QByteArray &locale, KEntryMap &entryMap, const QByteArray &group, KConfigBackend::ParseOptions options) const;
+
+    QString fileName() const
+    {
+        return m_fileName;
+    }
+
+private:
+    KConfigCompiledFile() = default;
+    Q_DISABLE_COPY(KConfigCompiledFile)
+
+    // Points the tables at @p data, returns false if it isn't a valid compiled file
+    bool load(const uchar *data, qint64 size);
+    QByteArrayView string(const StringRef &ref) const;
+    const GroupRecord *findGroup(QByteArrayView name) const;
+    // Returns whether the group must be marked immutable once the file is parsed
+    bool parseGroup(const QByteArray &locale, KEntryMap &entryMap, const QByteArray &group, const GroupRecord &record, KConfigBackend::ParseOptions options) const;
+
+    QFile m_file;
+    QString m_fileName;
+    std::shared_ptr<const KConfigDefaultsBundle> m_bundle; // set instead of m_file for a file of a bundle
+    bool m_immutable = false;
+    const GroupRecord *m_groups = nullptr;
+    quint32 m_groupCount = 0;
+    const EntryRecord *m_entries = nullptr;
+    quint32 m_entryCount = 0;
+    const char *m_strings = nullptr;
+    quint32 m_stringsSize = 0;
+};
+
+/**
+ * Reads a config file compiled by kcompileconfig6 next to its source, if
+ * it is up to date, and the source otherwise. Writing goes to the source,
+ * then the compiled file is compiled again from it, so that the processes
+ * sharing a compiled file like kdeglobals keep mapping it instead of each
+ * parsing the source once one of them wrote it.
+ *
+ * Most files are never compiled, so only two kinds of files are looked for
+ * a compiled file: the defaults of the system, compiled at package install
+ * time, and the files kcompileconfig6 registered, see isRegistered().
+ * KConfigBackend::create() only gives this backend to the latter, any
+ * other file doesn't cost a single syscall more than with KConfigIniBackend.
+ *
+ * @internal
+ */
+class KConfigCompiledBackend : public KConfigIniBackend
+{
+    Q_OBJECT
+
+public:
+    using KConfigIniBackend::parseConfig;
+    ParseInfo parseConfig(const QByteArray &locale, KEntryMap &entryMap, ParseOptions options) override;
+    bool writeConfig(const QByteArray &locale, KEntryMap &entryMap, WriteOptions options) override;
+
+    // Like parseFile() and indexFile(), but the compiled file of @p fileName is read if there is one that
+    // is up to date. Its groups are indexed as well, they are only read once they are accessed.
+    static ParseInfo parseCompiledFile(const QString &fileName, const QByteArray &locale, KEntryMap &entryMap, ParseOptions options);
+    static ParseInfo indexCompiledFile(const QString &fileName, const QByteArray &locale, KEntryMap &entryMap, ParseOptions options, GroupIndex &index);
+
+    // The compiled file of @p sourceFile
+    KCONFIGCORE_EXPORT static QString compiledPath(const QString &sourceFile);
+    // Whether kcompileconfig6 registered @p sourceFile as compiled. The registry of the user
+    // is read once per process, files registered later are read from their source.
+    static bool isRegistered(const QString &sourceFile);
+    // Adds @p sourceFile to the registry of the user, or removes it, used by kcompileconfig6
+    KCONFIGCORE_EXPORT static bool setRegistered(const QString &sourceFile, bool registered);
+    // Compiles @p sourceFile into @p compiledFile, used by kcompileconfig6
+    KCONFIGCORE_EXPORT static bool compile(const QString &sourceFile, const QString &compiledFile);
+    // Packs @p files, names of files in @p directory, or all of its files if empty, into
+    // the KConfigDefaultsBundle of the directory, used by kcompileconfig6 --bundle
+    KCONFIGCORE_EXPORT static bool pack(const QString &directory, const QStringList &files);
+
+private:
+    static bool compileImage(const QString &sourceFile, QByteArray *image);
+};
+
+/**
+ * The compiled files of the config files of a system directory such as
+ * /etc/xdg, packed into a single file in that directory by
+ * kcompileconfig6 --bundle, typically at package install time.
+ *
+ * Looking up the defaults of a cascade and reading them then takes one
+ * mapping for the directory, instead of a stat() and the lstat() calls of
+ * canonicalFilePath() for each file found, and opening, reading and
+ * parsing it.
+ *
+ * Unlike a compiled file, the bundle doesn't check the stamp of each file:
+ * it is used as long as the directory wasn't modified after it was packed,
+ * that is as long as no file was added, removed or replaced there, which is
+ * how package managers and KConfig itself write files. A file edited in
+ * place requires packing the bundle again.
+ *
+ * @internal
+ */
+class KCONFIGCORE_EXPORT KConfigDefaultsBundle
+{
+public:
+    struct FileRecord;
+
+    // Returns the bundle of @p directory, or null if there is none or the directory changed
+    // since it was packed. The bundles are shared by the process, checking one takes a stat().
+    static std::shared_ptr<const KConfigDefaultsBundle> open(const QString &directory);
+    // Returns the compiled file of @p sourceFile from the bundle of its directory, or null
+    static std::shared_ptr<const KConfigCompiledFile> compiledFile(const QString &sourceFile);
+    // Forgets the bundles no one else maps, or with @p all every bundle, see KConfig::trimCaches().
+    // Returns the size of the mappings released.
+    static qint64 trimCache(bool all);
+
+    // Returns the canonical path of the file @p name when it was packed, or a null string if it isn't bundled
+    QString canonicalFilePath(QStringView name) const;
+
+    QString directory() const
+    {
+        return m_directory;
+    }
+
+    static QString bundlePath(const QString &directory);
+
+private:
+    KConfigDefaultsBundle() = default;
+    Q_DISABLE_COPY(KConfigDefaultsBundle)
+
+    static std::shared_ptr<const KConfigDefaultsBundle> load(const QString &directory, qint64 directoryModified);
+    QByteArrayView string(quint32 offset, quint32 size) const;
+    const FileRecord *find(QStringView name) const;
+    QByteArrayView name(const FileRecord &record) const;
+
+    QFile m_file;
+    QString m_directory;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    const FileRecord *m_files = nullptr;
+    quint32 m_fileCount = 0;
+    const char *m_strings = nullptr;
+    quint32 m_stringsSize = 0;
+};
+
+#endif // KCONFIGCOMPILED_P_H
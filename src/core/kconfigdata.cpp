@@ -9,6 +9,13 @@
 
 #include "kconfigdata_p.h"
 
+#include "kconfig_core_log_settings.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+
 QDebug operator<<(QDebug dbg, const KEntryKey &key)
 {
     dbg.nospace() << "[" << key.mGroup << ", " << key.mKey << (key.bLocal ? " localized" : "") << (key.bDefault ? " default" : "") << (key.bRaw ? " raw" : "")
@@ -18,62 +25,560 @@ QDebug operator<<(QDebug dbg, const KEntryKey &key)
 
 QDebug operator<<(QDebug dbg, const KEntry &entry)
 {
-    dbg.nospace() << "[" << entry.mValue << (entry.bDirty ? " dirty" : "") << (entry.bGlobal ? " global" : "")
+    dbg.nospace() << "[" << entry.rawValue() << (entry.bDirty ? " dirty" : "") << (entry.bGlobal ? " global" : "")
                   << (entry.bOverridesGlobal ? " overrides global" : "") << (entry.bImmutable ? " immutable" : "") << (entry.bDeleted ? " deleted" : "")
-                  << (entry.bReverted ? " reverted" : "") << (entry.bExpand ? " expand" : "") << "]";
+                  << (entry.bReverted ? " reverted" : "") << (entry.bExpand ? " expand" : "") << (entry.bSharesDefault ? " shares default" : "")
+                  << (entry.bBinary ? " binary" : "") << "]";
 
     return dbg.space();
 }
 
-KEntryMapIterator KEntryMap::findExactEntry(const QByteArray &group, const QByteArray &key, KEntryMap::SearchFlags flags)
+void KEntryValue::setValue(const QByteArray &value)
 {
-    KEntryKey theKey(group, key, bool(flags & SearchLocalized), bool(flags & SearchDefaults));
-    return find(theKey);
+    if (value.isNull()) {
+        destroy();
+    } else if (value.size() <= InlineCapacity) {
+        // value may be our own heap value
+        char buffer[InlineCapacity];
+        const quint8 size = quint8(value.size());
+        memcpy(buffer, value.constData(), size);
+        destroy();
+        memcpy(mInlineValue, buffer, size);
+        mSize = size;
+    } else if (mSize == HeapValue) {
+        mHeapValue = value;
+    } else {
+        new (&mHeapValue) QByteArray(value);
+        mSize = HeapValue;
+    }
 }
 
-KEntryMapIterator KEntryMap::findEntry(const QByteArray &group, const QByteArray &key, KEntryMap::SearchFlags flags)
+void KEntryValue::copyFrom(const KEntryValue &other)
 {
-    KEntryKey theKey(group, key, false, bool(flags & SearchDefaults));
+    mSize = other.mSize;
+    if (mSize == HeapValue) {
+        new (&mHeapValue) QByteArray(other.mHeapValue);
+    } else if (!isNull()) {
+        memcpy(mInlineValue, other.mInlineValue, mSize);
+    }
+}
 
-    // try the localized key first
-    if (flags & SearchLocalized) {
-        theKey.bLocal = true;
+void KEntryValue::moveFrom(KEntryValue &&other) noexcept
+{
+    mSize = other.mSize;
+    if (mSize == HeapValue) {
+        new (&mHeapValue) QByteArray(std::move(other.mHeapValue));
+        other.destroy();
+    } else if (!isNull()) {
+        memcpy(mInlineValue, other.mInlineValue, mSize);
+    }
+}
 
-        Iterator it = find(theKey);
-        if (it != end()) {
-            return it;
+QByteArrayView KEntry::value() const
+{
+    if (bEscaped) {
+        // rawData() detaches, the raw value may be shared with other entries of the same file
+        QStringList warnings;
+        truncateRaw(unescape(rawData(), int(rawValue().size()), &warnings));
+        bEscaped = false;
+        for (const QString &warning : std::as_const(warnings)) {
+            // as printableToString(), without the line, which is known only while parsing
+            qCWarning(KCONFIG_CORE_LOG) << warning;
         }
+    }
+    return rawValue();
+}
 
-        theKey.bLocal = false;
+static char charFromHex(const char *str, QStringList *warnings)
+{
+    unsigned char ret = 0;
+    for (int i = 0; i < 2; i++) {
+        ret <<= 4;
+        quint8 c = quint8(str[i]);
+
+        if (c >= '0' && c <= '9') {
+            ret |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            ret |= c - 'a' + 0x0a;
+        } else if (c >= 'A' && c <= 'F') {
+            ret |= c - 'A' + 0x0a;
+        } else {
+            if (warnings) {
+                *warnings << QStringLiteral("Invalid hex character %1 in \\x<nn>-type escape sequence \"\\x%2\".").arg(c).arg(QLatin1String(str, 2));
+            }
+            return 'x';
+        }
     }
-    return find(theKey);
+    return char(ret);
 }
 
-KEntryMapConstIterator KEntryMap::constFindEntry(const QByteArray &group, const QByteArray &key, SearchFlags flags) const
+int KEntry::unescape(char *str, int length, QStringList *warnings)
 {
-    KEntryKey theKey(group, key, false, bool(flags & SearchDefaults));
+    const char *const end = str + length;
+    const char *s = str;
+    char *r = str;
 
-    // try the localized key first
-    if (flags & SearchLocalized) {
-        theKey.bLocal = true;
+    // the spans between the escape sequences are moved as a whole, only the sequences go byte by byte
+    while (s != end) {
+        const char *backslash = static_cast<const char *>(memchr(s, '\\', end - s));
+        if (!backslash) {
+            backslash = end;
+        }
+        const qsizetype span = backslash - s;
+        if (r != s) {
+            memmove(r, s, span);
+        }
+        r += span;
+        s = backslash;
+        if (s == end) {
+            break;
+        }
 
-        auto it = constFind(theKey);
-        if (it != cend()) {
-            return it;
+        // Probable escape sequence
+        ++s;
+        if (s == end) { // Line ends after backslash - stop.
+            break;
         }
 
-        theKey.bLocal = false;
+        switch (*s) {
+        case 's':
+            *r++ = ' ';
+            break;
+        case 't':
+            *r++ = '\t';
+            break;
+        case 'n':
+            *r++ = '\n';
+            break;
+        case 'r':
+            *r++ = '\r';
+            break;
+        case '\\':
+            *r++ = '\\';
+            break;
+        case ';':
+            // not really an escape sequence, but allowed in .desktop files, don't strip '\;' from the string
+            *r++ = '\\';
+            *r++ = ';';
+            break;
+        case ',':
+            // not really an escape sequence, but allowed in .desktop files, don't strip '\,' from the string
+            *r++ = '\\';
+            *r++ = ',';
+            break;
+        case 'x':
+            if (end - s > 2) {
+                *r++ = charFromHex(s + 1, warnings);
+                s += 2;
+            } else {
+                *r++ = 'x';
+                s = end - 1;
+            }
+            break;
+        default:
+            *r++ = '\\';
+            if (warnings) {
+                *warnings << QStringLiteral("Invalid escape sequence \"\\%1\".").arg(*s);
+            }
+        }
+        ++s;
     }
+    return r - str;
+}
 
-    return constFind(theKey);
+KEntryMap KEntryMap::groupEntries(QByteArrayView group) const
+{
+    KEntryMap map;
+    const std::size_t index = groupLowerBound(group);
+    if (index < m_groups.size() && m_groups[index].name == group) {
+        map.m_groups.push_back(m_groups[index]);
+        map.m_size = m_groups[index].entries.size();
+        map.groupsChanged();
+    }
+    return map;
+}
+
+void KEntryMap::replaceGroup(QByteArrayView group, const KEntryMap &source)
+{
+    const std::size_t sourceIndex = source.groupIndex(group);
+    const std::size_t index = groupLowerBound(group);
+    const bool exists = index < m_groups.size() && m_groups[index].name == group;
+    if (exists) {
+        m_size -= m_groups[index].entries.size();
+    }
+    if (sourceIndex == source.m_groups.size()) {
+        if (exists) {
+            m_groups.erase(m_groups.begin() + index);
+            groupsChanged();
+        }
+        return;
+    }
+    const Group &replacement = source.m_groups[sourceIndex];
+    m_size += replacement.entries.size();
+    if (exists) {
+        m_groups[index] = replacement;
+    } else {
+        m_groups.insert(m_groups.begin() + index, replacement);
+        groupsChanged();
+    }
+}
+
+bool KEntryMap::hasSameGroup(QByteArrayView group, const KEntryMap &other) const
+{
+    const std::size_t index = groupIndex(group);
+    const std::size_t otherIndex = other.groupIndex(group);
+    const bool exists = index < m_groups.size();
+    if (exists != (otherIndex < other.m_groups.size())) {
+        return false;
+    }
+    if (!exists) {
+        return true;
+    }
+
+    const QList<Node> &entries = m_groups[index].entries;
+    const QList<Node> &otherEntries = other.m_groups[otherIndex].entries;
+    if (entries.constData() == otherEntries.constData() && entries.size() == otherEntries.size()) {
+        return true;
+    }
+    return std::equal(entries.cbegin(), entries.cend(), otherEntries.cbegin(), otherEntries.cend(), [](const Node &node, const Node &otherNode) {
+        return !(node.key < otherNode.key) && !(otherNode.key < node.key) && node.value == otherNode.value;
+    });
+}
+
+std::size_t KEntryMap::groupLowerBound(QByteArrayView name) const
+{
+    const auto it = std::lower_bound(m_groups.cbegin(), m_groups.cend(), name, [](const Group &group, QByteArrayView name) {
+        return group.name.compare(name) < 0;
+    });
+    return it - m_groups.cbegin();
+}
+
+std::size_t KEntryMap::entryLowerBound(const Group &group, QByteArrayView key, bool isLocalized, bool isDefault)
+{
+    // the order of KEntryKey's operator<(), without having to build a KEntryKey
+    const auto it = std::lower_bound(group.entries.cbegin(), group.entries.cend(), key, [isLocalized, isDefault](const Node &node, QByteArrayView key) {
+        const int result = node.key.mKey.compare(key);
+        if (result != 0) {
+            return result < 0;
+        }
+        if (node.key.bLocal != isLocalized) {
+            return bool(node.key.bLocal);
+        }
+        return !node.key.bDefault && isDefault;
+    });
+    return it - group.entries.cbegin();
+}
+
+std::size_t KEntryMap::groupIndex(QByteArrayView group, GroupHint *hint) const
+{
+    // a moved-from map keeps its generation, but none of its groups
+    if (hint && hint->generation == m_generation && hint->index <= m_groups.size()) {
+        return hint->index;
+    }
+    std::size_t index = groupLowerBound(group);
+    if (index < m_groups.size() && m_groups[index].name != group) {
+        index = m_groups.size();
+    }
+    if (hint) {
+        *hint = GroupHint{m_generation, index};
+    }
+    return index;
+}
+
+void KEntryMap::groupsChanged()
+{
+    static std::atomic<quint64> generations{0};
+    m_generation = ++generations;
+}
+
+KEntryMapConstIterator KEntryMap::constFind(QByteArrayView group, QByteArrayView key, bool isLocalized, bool isDefault) const
+{
+    return constFindInGroup(groupIndex(group), key, isLocalized, isDefault);
+}
+
+KEntryMapConstIterator KEntryMap::constFindInGroup(std::size_t groupIndex, QByteArrayView key, bool isLocalized, bool isDefault) const
+{
+    if (groupIndex == m_groups.size()) {
+        return cend();
+    }
+    const QList<Node> &entries = m_groups[groupIndex].entries;
+    const std::size_t entryIndex = entryLowerBound(m_groups[groupIndex], key, isLocalized, isDefault);
+    if (entryIndex == std::size_t(entries.size())) {
+        return cend();
+    }
+    const KEntryKey &found = entries[entryIndex].key;
+    if (found.mKey != key || found.bLocal != isLocalized || found.bDefault != isDefault) {
+        return cend();
+    }
+    return ConstIterator(&m_groups, groupIndex, entryIndex);
+}
+
+KEntryMapConstIterator KEntryMap::constFind(const KEntryKey &key) const
+{
+    return constFind(key.mGroup, key.mKey, key.bLocal, key.bDefault);
+}
+
+KEntryMapIterator KEntryMap::find(const KEntryKey &key)
+{
+    const ConstIterator it = constFind(key);
+    return Iterator(&m_groups, it.m_group, it.m_entry);
+}
+
+KEntryMapConstIterator KEntryMap::lowerBound(const KEntryKey &key) const
+{
+    const std::size_t group = groupLowerBound(key.mGroup);
+    if (group == m_groups.size() || m_groups[group].name != key.mGroup) {
+        return ConstIterator(&m_groups, group, 0);
+    }
+    const std::size_t entry = entryLowerBound(m_groups[group], key.mKey, key.bLocal, key.bDefault);
+    if (entry == std::size_t(m_groups[group].entries.size())) {
+        return ConstIterator(&m_groups, group + 1, 0);
+    }
+    return ConstIterator(&m_groups, group, entry);
+}
+
+KEntryMapIterator KEntryMap::insert(const KEntryKey &key, const KEntry &value)
+{
+    std::size_t group = groupLowerBound(key.mGroup);
+    if (group == m_groups.size() || m_groups[group].name != key.mGroup) {
+        m_groups.insert(m_groups.begin() + group, Group{key.mGroup, takeRecycled()});
+        groupsChanged();
+    }
+    if (value.bDirty) {
+        mayDirty(m_groups[group], key.mKey);
+    }
+    if (value.bImmutable) {
+        m_groups[group].immutableEntries = ImmutableSome;
+    }
+    QList<Node> &entries = m_groups[group].entries;
+    const std::size_t entry = entryLowerBound(m_groups[group], key.mKey, key.bLocal, key.bDefault);
+    if (entry < std::size_t(entries.size()) && !(key < entries.at(entry).key)) {
+        entries[entry].value = value;
+    } else {
+        entries.insert(entry, Node{key, value});
+        ++m_size;
+    }
+    return Iterator(&m_groups, group, entry);
+}
+
+KEntry &KEntryMap::operator[](const KEntryKey &key)
+{
+    Iterator it = find(key);
+    if (it == end()) {
+        it = insert(key, KEntry());
+    }
+    return *it;
+}
+
+KEntry KEntryMap::value(const KEntryKey &key) const
+{
+    const ConstIterator it = constFind(key);
+    return it == cend() ? KEntry() : *it;
+}
+
+KEntryMapIterator KEntryMap::erase(KEntryMapIterator it)
+{
+    QList<Node> &entries = m_groups[it.m_group].entries;
+    entries.removeAt(it.m_entry);
+    --m_size;
+    if (entries.empty()) {
+        // keep the invariant that there are no empty groups
+        m_groups.erase(m_groups.begin() + it.m_group);
+        groupsChanged();
+        return Iterator(&m_groups, it.m_group, 0);
+    }
+    if (it.m_entry == std::size_t(entries.size())) {
+        return Iterator(&m_groups, it.m_group + 1, 0);
+    }
+    return it;
+}
+
+qsizetype KEntryMap::remove(const KEntryKey &key)
+{
+    const Iterator it = find(key);
+    if (it == end()) {
+        return 0;
+    }
+    erase(it);
+    return 1;
+}
+
+qsizetype KEntryMap::remove(QList<KEntryKey> keys)
+{
+    std::sort(keys.begin(), keys.end());
+    qsizetype removed = 0;
+    bool groupRemoved = false;
+    for (auto first = keys.cbegin(); first != keys.cend();) {
+        const QByteArray &groupName = first->mGroup;
+        const auto last = std::find_if(first, keys.cend(), [&groupName](const KEntryKey &key) {
+            return key.mGroup != groupName;
+        });
+        const std::size_t index = groupIndex(groupName);
+        if (index < m_groups.size()) {
+            QList<Node> &entries = m_groups[index].entries;
+            const qsizetype count = entries.removeIf([first, last](const Node &node) {
+                return std::binary_search(first, last, node.key);
+            });
+            removed += count;
+            m_size -= count;
+            if (entries.empty()) {
+                // keep the invariant that there are no empty groups
+                m_groups.erase(m_groups.begin() + index);
+                groupRemoved = true;
+            }
+        }
+        first = last;
+    }
+    if (groupRemoved) {
+        groupsChanged();
+    }
+    return removed;
+}
+
+KEntryMapConstIterator KEntryMap::constFindWithSharedDefault(QByteArrayView group, QByteArrayView key, bool isLocalized, bool isDefault) const
+{
+    return constFindWithSharedDefault(groupIndex(group), key, isLocalized, isDefault);
+}
+
+KEntryMapConstIterator KEntryMap::constFindWithSharedDefault(std::size_t groupIndex, QByteArrayView key, bool isLocalized, bool isDefault) const
+{
+    const auto it = constFindInGroup(groupIndex, key, isLocalized, isDefault);
+    if (it != cend() || !isDefault) {
+        return it;
+    }
+    const auto effective = constFindInGroup(groupIndex, key, isLocalized, false);
+    return effective != cend() && effective->bSharesDefault ? effective : cend();
+}
+
+KEntryMapIterator KEntryMap::findExactEntry(QByteArrayView group, QByteArrayView key, KEntryMap::SearchFlags flags)
+{
+    const ConstIterator it = constFindWithSharedDefault(group, key, bool(flags & SearchLocalized), bool(flags & SearchDefaults));
+    return Iterator(&m_groups, it.m_group, it.m_entry);
+}
+
+KEntryMapIterator KEntryMap::findEntry(QByteArrayView group, QByteArrayView key, KEntryMap::SearchFlags flags)
+{
+    const ConstIterator it = constFindEntry(group, key, flags);
+    return Iterator(&m_groups, it.m_group, it.m_entry);
+}
+
+KEntryMapConstIterator KEntryMap::constFindEntry(QByteArrayView group, QByteArrayView key, SearchFlags flags) const
+{
+    return constFindEntry(group, nullptr, key, flags);
+}
+
+KEntryMapConstIterator KEntryMap::constFindEntry(QByteArrayView group, GroupHint *hint, QByteArrayView key, SearchFlags flags) const
+{
+    const bool isDefault = flags & SearchDefaults;
+    const std::size_t index = groupIndex(group, hint);
+    if (index == m_groups.size()) {
+        return cend();
+    }
+
+    // All the variants of the key are next to each other, the localized ones first,
+    // so a single search finds them all
+    constexpr std::size_t none = std::size_t(-1);
+    std::size_t variants[2][2] = {{none, none}, {none, none}}; // by bLocal, then bDefault
+    const QList<Node> &entries = m_groups[index].entries;
+    for (std::size_t i = entryLowerBound(m_groups[index], key, true, false); i < std::size_t(entries.size()) && entries[i].key.mKey == key; ++i) {
+        variants[entries[i].key.bLocal][entries[i].key.bDefault] = i;
+    }
+    // as constFindWithSharedDefault()
+    const auto variant = [&](bool isLocalized) {
+        const std::size_t exact = variants[isLocalized][isDefault];
+        if (exact != none || !isDefault) {
+            return exact;
+        }
+        const std::size_t effective = variants[isLocalized][false];
+        return effective != none && entries[effective].value.bSharesDefault ? effective : none;
+    };
+
+    // try the localized key first
+    std::size_t found = flags & SearchLocalized ? variant(true) : none;
+    if (found == none) {
+        found = variant(false);
+    }
+    return found == none ? cend() : ConstIterator(&m_groups, index, found);
+}
+
+bool KEntryMap::removeLocalized(QByteArrayView group, QByteArrayView key, bool withDefault)
+{
+    bool removed = false;
+    const ConstIterator localized = constFind(group, key, true, false);
+    if (localized != cend()) {
+        if (localized->bSharesDefault && !withDefault) {
+            // the entry becomes the default it shared, that doesn't change the order
+            Node &node = m_groups[localized.m_group].entries[localized.m_entry];
+            node.key.bDefault = true;
+            node.value.bSharesDefault = false;
+        } else {
+            erase(Iterator(&m_groups, localized.m_group, localized.m_entry));
+        }
+        removed = true;
+    }
+    if (withDefault) {
+        const ConstIterator localizedDefault = constFind(group, key, true, true);
+        if (localizedDefault != cend()) {
+            erase(Iterator(&m_groups, localizedDefault.m_group, localizedDefault.m_entry));
+            removed = true;
+        }
+    }
+    return removed;
+}
+
+void KEntryMap::splitDefault(KEntryMapIterator it)
+{
+    Q_ASSERT(it->bSharesDefault);
+    KEntryKey defaultKey = it.key();
+    defaultKey.bDefault = true;
+    KEntry defaultEntry = *it;
+    defaultEntry.bSharesDefault = false;
+    it->bSharesDefault = false;
+    // the default entry comes right after this one, so the iterator stays valid
+    insert(defaultKey, defaultEntry);
+}
+
+void KEntryMap::applyValue(KEntry &e, const KEntryValue &value, EntryOptions options)
+{
+    static_cast<KEntryValue &>(e) = value;
+    e.bEscaped = (options & EntryEscaped);
+    e.bDirty = e.bDirty || (options & EntryDirty);
+    e.bNotify = e.bNotify || (options & EntryNotify);
+
+    e.bGlobal = (options & EntryGlobal); // we can't use || here, because changes to entries in
+    // kdeglobals would be written to kdeglobals instead
+    // of the local config file, regardless of the globals flag
+    e.bImmutable = e.bImmutable || (options & EntryImmutable);
+    if (value.isNull()) {
+        e.bDeleted = e.bDeleted || (options & EntryDeleted);
+    } else {
+        e.bDeleted = false; // setting a value to a previously deleted entry
+    }
+    e.bExpand = (options & EntryExpansion);
+    e.bBinary = (options & EntryBinary);
+    e.bReverted = (options & EntryReverted);
+    if (options & EntryLocalized) {
+        e.bLocalizedCountry = (options & EntryLocalizedCountry);
+    } else {
+        e.bLocalizedCountry = false;
+    }
 }
 
 bool KEntryMap::setEntry(const QByteArray &group, const QByteArray &key, const QByteArray &value, KEntryMap::EntryOptions options)
+{
+    KEntryValue entryValue;
+    entryValue.setValue(value);
+    return setEntry(group, key, entryValue, options);
+}
+
+bool KEntryMap::setEntry(const QByteArray &group, const QByteArray &key, const KEntryValue &value, KEntryMap::EntryOptions options)
 {
     KEntryKey k;
     KEntry e;
     bool newKey = false;
+    const bool isDefault = options & EntryDefault;
 
+    // for a default, this is either the separate default entry or the entry sharing it
     const Iterator it = findExactEntry(group, key, SearchFlags(options >> 16));
 
     if (key.isEmpty()) { // inserting a group marker
@@ -99,9 +604,10 @@ bool KEntryMap::setEntry(const QByteArray &group, const QByteArray &key, const Q
         }
         k = it.key();
         e = *it;
+        e.bSharesDefault = false;
         // qDebug() << "found existing entry for key" << k;
         // If overridden entry is global and not default. And it's overridden by a non global
-        if (e.bGlobal && !(options & EntryGlobal) && !k.bDefault) {
+        if (e.bGlobal && !(options & EntryGlobal) && !isDefault) {
             e.bOverridesGlobal = true;
         }
     } else {
@@ -120,38 +626,16 @@ bool KEntryMap::setEntry(const QByteArray &group, const QByteArray &key, const Q
 
     // set these here, since we may be changing the type of key from the one we found
     k.bLocal = (options & EntryLocalized);
-    k.bDefault = (options & EntryDefault);
+    k.bDefault = false; // a default is stored in the effective entry until it gets overridden
     k.bRaw = (options & EntryRawKey);
 
-    e.mValue = value;
-    e.bDirty = e.bDirty || (options & EntryDirty);
-    e.bNotify = e.bNotify || (options & EntryNotify);
-
-    e.bGlobal = (options & EntryGlobal); // we can't use || here, because changes to entries in
-    // kdeglobals would be written to kdeglobals instead
-    // of the local config file, regardless of the globals flag
-    e.bImmutable = e.bImmutable || (options & EntryImmutable);
-    if (value.isNull()) {
-        e.bDeleted = e.bDeleted || (options & EntryDeleted);
-    } else {
-        e.bDeleted = false; // setting a value to a previously deleted entry
-    }
-    e.bExpand = (options & EntryExpansion);
-    e.bReverted = false;
-    if (options & EntryLocalized) {
-        e.bLocalizedCountry = (options & EntryLocalizedCountry);
-    } else {
-        e.bLocalizedCountry = false;
-    }
+    applyValue(e, value, options);
 
     if (newKey) {
         // qDebug() << "inserting" << k << "=" << value;
+        // this replaces the value of an existing effective entry, just like a separate default would
+        e.bSharesDefault = isDefault;
         insert(k, e);
-        if (k.bDefault) {
-            k.bDefault = false;
-            // qDebug() << "also inserting" << k << "=" << value;
-            insert(k, e);
-        }
         // TODO check for presence of unlocalized key
         return true;
     }
@@ -167,44 +651,31 @@ bool KEntryMap::setEntry(const QByteArray &group, const QByteArray &key, const Q
     }
 
     if (it.value() != e) {
-        // qDebug() << "changing" << k << "from" << it.value().mValue << "to" << value << e;
-        it.value() = e;
-        if (k.bDefault) {
-            KEntryKey nonDefaultKey(k);
-            nonDefaultKey.bDefault = false;
-            insert(nonDefaultKey, e);
+        // qDebug() << "changing" << k << "from" << it->rawValue() << "to" << value << e;
+        if (isDefault) {
+            if (it.key().bDefault) {
+                // the default was overridden, the effective entry gets the new default too
+                erase(it);
+            }
+            e.bSharesDefault = true;
+            insert(k, e);
+        } else {
+            if (it->bSharesDefault) {
+                splitDefault(it);
+            }
+            it.value() = e;
         }
         if (!(options & EntryLocalized)) {
-            KEntryKey theKey(group, key, true, false);
-            // qDebug() << "non-localized entry, remove localized one:" << theKey;
-            remove(theKey);
-            if (k.bDefault) {
-                theKey.bDefault = true;
-                remove(theKey);
-            }
+            // qDebug() << "non-localized entry, remove localized one";
+            removeLocalized(group, key, isDefault);
         }
         return true;
     }
 
-    // qDebug() << k << "was already set to" << e.mValue;
+    // qDebug() << k << "was already set to" << e.rawValue();
     if (!(options & EntryLocalized)) {
         // qDebug() << "unchanged non-localized entry, remove localized one.";
-        KEntryKey theKey(group, key, true, false);
-        bool ret = false;
-        Iterator cit = find(theKey);
-        if (cit != end()) {
-            erase(cit);
-            ret = true;
-        }
-        if (k.bDefault) {
-            theKey.bDefault = true;
-            Iterator cit = find(theKey);
-            if (cit != end()) {
-                erase(cit);
-                return true;
-            }
-        }
-        return ret;
+        return removeLocalized(group, key, isDefault);
     }
 
     // qDebug() << "localized entry, unchanged, return false";
@@ -214,15 +685,84 @@ bool KEntryMap::setEntry(const QByteArray &group, const QByteArray &key, const Q
     return false;
 }
 
-QString KEntryMap::getEntry(const QByteArray &group, const QByteArray &key, const QString &defaultValue, KEntryMap::SearchFlags flags, bool *expand) const
+bool KEntryMap::setEntries(const QByteArray &group, std::vector<EntryWrite> writes)
 {
-    const auto it = constFindEntry(group, key, flags);
+    // stable, so that writes to the same key still happen in order
+    std::stable_sort(writes.begin(), writes.end(), [](const EntryWrite &a, const EntryWrite &b) {
+        return a.key < b.key;
+    });
+
+    const auto marker = constFindEntry(group);
+    const bool groupImmutable = marker != constEnd() && marker->bImmutable;
+
+    // Entries new to the group, in key order. Merging them in at the end moves
+    // the existing entries once, not once for every new entry.
+    std::vector<Node> added;
+    const auto mergeAdded = [this, &group, &added] {
+        if (added.empty()) {
+            return;
+        }
+        if (constFindEntry(group) == constEnd()) {
+            insert(KEntryKey(group), KEntry());
+        }
+        Group &target = m_groups[groupLowerBound(group)];
+        for (const Node &node : added) {
+            if (node.value.bDirty) {
+                mayDirty(target, node.key.mKey);
+            }
+            if (node.value.bImmutable) {
+                target.immutableEntries = ImmutableSome;
+            }
+        }
+        QList<Node> &entries = target.entries;
+        const qsizetype middle = entries.size();
+        entries.reserve(middle + qsizetype(added.size()));
+        for (Node &node : added) {
+            entries.push_back(std::move(node));
+        }
+        std::inplace_merge(entries.begin(), entries.begin() + middle, entries.end(), [](const Node &a, const Node &b) {
+            return a.key < b.key;
+        });
+        m_size += added.size();
+        added.clear();
+    };
+
+    // the group is looked up again only once setEntry() added or removed a group
+    GroupHint hint;
+    bool dirtied = false;
+    for (const EntryWrite &write : writes) {
+        if (!added.empty() && added.back().key.mKey == write.key) {
+            mergeAdded(); // let setEntry() see the entry written before
+        }
+
+        const bool isPlain = !write.key.isEmpty() && !(write.options & (EntryDefault | EntryLocalized));
+        if (isPlain && constFindInGroup(groupIndex(group, &hint), write.key, false, false) == cend()) {
+            if (groupImmutable) {
+                continue;
+            }
+            Node node{KEntryKey(group, write.key), KEntry()};
+            node.key.bRaw = (write.options & EntryRawKey);
+            KEntryValue value;
+            value.setValue(write.value);
+            applyValue(node.value, value, write.options);
+            added.push_back(std::move(node));
+            dirtied = dirtied || (write.options & EntryDirty);
+        } else if (setEntry(group, write.key, write.value, write.options) && (write.options & EntryDirty)) {
+            dirtied = true;
+        }
+    }
+    mergeAdded();
+    return dirtied;
+}
+
+QString KEntryMap::getEntry(QByteArrayView group, QByteArrayView key, const QString &defaultValue, KEntryMap::SearchFlags flags, bool *expand, GroupHint *hint) const
+{
+    const auto it = constFindEntry(group, hint, key, flags);
     QString theValue = defaultValue;
 
     if (it != constEnd() && !it->bDeleted) {
-        if (!it->mValue.isNull()) {
-            const QByteArray data = it->mValue;
-            theValue = QString::fromUtf8(data.constData(), data.length());
+        if (!it->isNull()) {
+            theValue = QString::fromUtf8(it->value());
             if (expand) {
                 *expand = it->bExpand;
             }
@@ -232,7 +772,7 @@ QString KEntryMap::getEntry(const QByteArray &group, const QByteArray &key, cons
     return theValue;
 }
 
-bool KEntryMap::hasEntry(const QByteArray &group, const QByteArray &key, KEntryMap::SearchFlags flags) const
+bool KEntryMap::hasEntry(QByteArrayView group, QByteArrayView key, KEntryMap::SearchFlags flags) const
 {
     const auto it = constFindEntry(group, key, flags);
     if (it == constEnd()) {
@@ -242,7 +782,7 @@ bool KEntryMap::hasEntry(const QByteArray &group, const QByteArray &key, KEntryM
         return false;
     }
     if (key.isNull()) { // looking for group marker
-        return it->mValue.isNull();
+        return it->isNull();
     }
     // if it->bReverted, we'll just return true; the real answer depends on lookup up with SearchDefaults, though.
     return true;
@@ -256,7 +796,7 @@ bool KEntryMap::getEntryOption(const KEntryMapConstIterator &it, KEntryMap::Entr
 
     switch (option) {
     case EntryDirty:
-        return it->bDirty;
+        return it->bDirty || (*it.m_groups)[it.m_group].allDirty;
     case EntryLocalized:
         return it.key().bLocal;
     case EntryGlobal:
@@ -267,6 +807,8 @@ bool KEntryMap::getEntryOption(const KEntryMapConstIterator &it, KEntryMap::Entr
         return it->bDeleted;
     case EntryExpansion:
         return it->bExpand;
+    case EntryBinary:
+        return it->bBinary;
     case EntryNotify:
         return it->bNotify;
     default:
@@ -274,6 +816,22 @@ bool KEntryMap::getEntryOption(const KEntryMapConstIterator &it, KEntryMap::Entr
     }
 }
 
+bool KEntryMap::mayHaveImmutableEntries(QByteArrayView group) const
+{
+    const std::size_t index = groupIndex(group);
+    if (index == m_groups.size()) {
+        return false;
+    }
+    const Group &current = m_groups[index];
+    if (current.immutableEntries == ImmutableUnknown) {
+        const bool any = std::any_of(current.entries.cbegin(), current.entries.cend(), [](const Node &node) {
+            return node.value.bImmutable;
+        });
+        current.immutableEntries = any ? ImmutableSome : ImmutableNone;
+    }
+    return current.immutableEntries == ImmutableSome;
+}
+
 void KEntryMap::setEntryOption(KEntryMapIterator it, KEntryMap::EntryOption option, bool bf)
 {
     if (it == end()) {
@@ -296,6 +854,9 @@ void KEntryMap::setEntryOption(KEntryMapIterator it, KEntryMap::EntryOption opti
     case EntryExpansion:
         it->bExpand = bf;
         return;
+    case EntryBinary:
+        it->bBinary = bf;
+        return;
     case EntryNotify:
         it->bNotify = bf;
         return;
@@ -312,11 +873,16 @@ bool KEntryMap::revertEntry(const QByteArray &group, const QByteArray &key, KEnt
         return false;
     }
 
-    // qDebug() << "reverting" << entry.key() << " = " << entry->mValue;
+    // qDebug() << "reverting" << entry.key() << " = " << entry->rawValue();
     if (entry->bReverted) { // already done before
         return false;
     }
 
+    if (entry->bSharesDefault) {
+        // it has the default value already, but the default itself must not become dirty
+        splitDefault(entry);
+    }
+
     KEntryKey defaultKey(entry.key());
     defaultKey.bDefault = true;
     // qDebug() << "looking up default entry with key=" << defaultKey;
@@ -326,7 +892,8 @@ bool KEntryMap::revertEntry(const QByteArray &group, const QByteArray &key, KEnt
         // qDebug() << "found, update entry";
         *entry = *defaultEntry; // copy default value, for subsequent lookups
     } else {
-        entry->mValue = QByteArray();
+        entry->setValue(QByteArray());
+        entry->bEscaped = false;
     }
     entry->bNotify = entry->bNotify || (options & EntryNotify);
     entry->bDirty = true;
@@ -335,3 +902,328 @@ bool KEntryMap::revertEntry(const QByteArray &group, const QByteArray &key, KEnt
     // qDebug() << "Here's what we have now:" << *this;
     return true;
 }
+
+bool KEntryMap::hasDefault(const KEntryMapConstIterator &it) const
+{
+    if (it == cend()) {
+        return false;
+    }
+    const KEntryKey &key = it.key();
+    return key.bDefault || it->bSharesDefault || constFind(key.mGroup, key.mKey, key.bLocal, true) != cend();
+}
+
+void KEntryMap::markAllDirty()
+{
+    for (Group &group : m_groups) {
+        group.mayHaveDirtyEntries = true;
+        group.allDirty = true;
+    }
+}
+
+void KEntryMap::stampDirty(Group &group)
+{
+    group.allDirty = false;
+    for (Node &node : group.entries) {
+        node.value.bDirty = true;
+    }
+    group.mayHaveDirtyEntries = true;
+    group.dirtyFrom = group.entries.constFirst().key.mKey;
+    group.dirtyTo = group.entries.constLast().key.mKey;
+}
+
+std::pair<std::size_t, std::size_t> KEntryMap::dirtyRange(const Group &group)
+{
+    if (!group.mayHaveDirtyEntries) {
+        return {0, 0};
+    }
+    // the localized entry of a key comes first, the default last
+    const std::size_t first = entryLowerBound(group, group.dirtyFrom, true, false);
+    const auto last = std::upper_bound(group.entries.cbegin() + qsizetype(first), group.entries.cend(), group.dirtyTo, [](const QByteArray &key, const Node &node) {
+        return key < node.key.mKey;
+    });
+    return {first, std::size_t(last - group.entries.cbegin())};
+}
+
+KEntryMap KEntryMap::takeDirtyEntries()
+{
+    KEntryMap taken;
+    for (Group &group : m_groups) {
+        // the marker has the smallest key, so it comes first
+        const bool hasMarker = group.entries.constFirst().key.mKey.isEmpty();
+        if (!group.mayHaveDirtyEntries && !hasMarker) {
+            continue;
+        }
+        if (group.allDirty) {
+            // everything is taken, the entries stay shared with the copy
+            taken.m_size += group.entries.size();
+            taken.m_groups.push_back(group);
+            group.allDirty = false;
+            group.mayHaveDirtyEntries = false;
+            continue;
+        }
+        Group copy{group.name, {}, group.mayHaveDirtyEntries, group.dirtyFrom, group.dirtyTo};
+        if (hasMarker) {
+            copy.entries.push_back(group.entries.constFirst());
+        }
+        const auto [first, last] = dirtyRange(group);
+        for (std::size_t entry = first; entry < last; ++entry) {
+            const Node &node = std::as_const(group.entries)[entry];
+            // the default of an entry directly follows it
+            const bool isDefaultOfTaken = node.key.bDefault && !copy.entries.empty() && !copy.entries.back().key.bDefault
+                && copy.entries.back().key.mKey == node.key.mKey && copy.entries.back().key.bLocal == node.key.bLocal;
+            if ((node.value.bDirty && !(entry == 0 && hasMarker)) || isDefaultOfTaken) {
+                copy.entries.push_back(node);
+            }
+            if (node.value.bDirty) {
+                // only the groups with dirty entries get detached
+                group.entries[entry].value.bDirty = false;
+            }
+        }
+        group.mayHaveDirtyEntries = false;
+        if (!copy.entries.empty()) {
+            taken.m_size += copy.entries.size();
+            taken.m_groups.push_back(std::move(copy));
+        }
+    }
+    if (!taken.m_groups.empty()) {
+        taken.groupsChanged();
+    }
+    return taken;
+}
+
+bool KEntryMap::hasNonDeletedEntry(const Group &group)
+{
+    return std::any_of(group.entries.cbegin(), group.entries.cend(), [](const Node &node) {
+        return !node.key.mKey.isNull() && !node.value.bDeleted;
+    });
+}
+
+std::pair<std::size_t, std::size_t> KEntryMap::subGroupRange(QByteArrayView group) const
+{
+    QByteArray bound = group.toByteArray() + '\x1d';
+    const std::size_t first = groupLowerBound(bound);
+    bound.back() = '\x1e';
+    return {first, groupLowerBound(bound)};
+}
+
+bool KEntryMap::hasNonDeletedEntries(QByteArrayView group) const
+{
+    bool found = false;
+    forEachGroupInTree(group, [this, &found](std::size_t index) {
+        found = found || hasNonDeletedEntry(m_groups[index]);
+    });
+    return found;
+}
+
+QList<QByteArrayView> KEntryMap::subGroupNames(QByteArrayView parentGroup) const
+{
+    QList<QByteArrayView> names;
+    forEachSubGroupName(parentGroup, [&names](QByteArrayView name) {
+        names.append(name);
+    });
+    // Only names with characters sorting before '\x1d' come out of order
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+QByteArrayList KEntryMap::groupAndSubGroupNames(QByteArrayView group) const
+{
+    QByteArrayList names;
+    forEachGroupInTree(group, [this, &names](std::size_t index) {
+        const Group &current = m_groups[index];
+        // the marker has the smallest key, so it comes first
+        if (current.entries.front().key.mKey.isNull()) {
+            names.append(current.name);
+        }
+    });
+    return names;
+}
+
+QList<KEntryKey> KEntryMap::differences(const KEntryMap &previous) const
+{
+    QList<KEntryKey> keys;
+    // the variants of a key are next to each other, whichever map they come from
+    const auto addKey = [&keys](const QByteArray &group, const QByteArray &key) {
+        if (keys.isEmpty() || keys.constLast().mKey != key || keys.constLast().mGroup != group) {
+            keys.append(KEntryKey(group, key));
+        }
+    };
+    const auto addGroup = [&addKey](const Group &group) {
+        for (const Node &node : group.entries) {
+            addKey(group.name, node.key.mKey);
+        }
+    };
+
+    auto group = m_groups.cbegin();
+    auto previousGroup = previous.m_groups.cbegin();
+    while (group != m_groups.cend() || previousGroup != previous.m_groups.cend()) {
+        if (previousGroup == previous.m_groups.cend() || (group != m_groups.cend() && group->name < previousGroup->name)) {
+            addGroup(*group++);
+            continue;
+        }
+        if (group == m_groups.cend() || previousGroup->name < group->name) {
+            addGroup(*previousGroup++);
+            continue;
+        }
+        if (!group->entries.isSharedWith(previousGroup->entries)) {
+            auto node = group->entries.cbegin();
+            auto previousNode = previousGroup->entries.cbegin();
+            while (node != group->entries.cend() || previousNode != previousGroup->entries.cend()) {
+                if (previousNode == previousGroup->entries.cend() || (node != group->entries.cend() && node->key < previousNode->key)) {
+                    addKey(group->name, (node++)->key.mKey);
+                } else if (node == group->entries.cend() || previousNode->key < node->key) {
+                    addKey(group->name, (previousNode++)->key.mKey);
+                } else {
+                    if (node->value != previousNode->value) {
+                        addKey(group->name, node->key.mKey);
+                    }
+                    ++node;
+                    ++previousNode;
+                }
+            }
+        }
+        ++group;
+        ++previousGroup;
+    }
+    return keys;
+}
+
+void KEntryMap::recycle()
+{
+    for (Group &group : m_groups) {
+        if (group.entries.isDetached()) {
+            group.entries.clear(); // keeps the capacity
+            m_recycled.lists.push_back(std::move(group.entries));
+        }
+    }
+    clear();
+}
+
+QList<KEntryMap::Node> KEntryMap::takeRecycled()
+{
+    if (m_recycled.lists.empty()) {
+        return {};
+    }
+    QList<Node> entries = std::move(m_recycled.lists.back());
+    m_recycled.lists.pop_back();
+    return entries;
+}
+
+qint64 KEntryMap::squeeze()
+{
+    qint64 freed = 0;
+    for (const QList<Node> &entries : m_recycled.lists) {
+        freed += entries.capacity() * sizeof(Node);
+    }
+    releaseRecycled();
+
+    for (Group &group : m_groups) {
+        // squeezing a shared array would copy it
+        if (group.entries.isDetached() && group.entries.capacity() > group.entries.size()) {
+            freed += (group.entries.capacity() - group.entries.size()) * sizeof(Node);
+            group.entries.squeeze();
+        }
+    }
+    if (m_groups.capacity() > m_groups.size()) {
+        freed += (m_groups.capacity() - m_groups.size()) * sizeof(Group);
+        m_groups.shrink_to_fit();
+    }
+    // the entries moved
+    groupsChanged();
+    return freed;
+}
+
+KEntryMap::MemoryUsage KEntryMap::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.groups = m_groups.size();
+    usage.entries = m_size;
+    usage.structureBytes = m_groups.capacity() * sizeof(Group);
+    for (const QList<Node> &entries : m_recycled.lists) {
+        usage.structureBytes += entries.capacity() * sizeof(Node);
+    }
+    for (const Group &group : m_groups) {
+        usage.keyBytes += group.name.size();
+        if (!group.entries.isDetached()) {
+            // the nodes belong to all the maps sharing them, their contents aren't shared among each other
+            ++usage.sharedGroups;
+        }
+        usage.structureBytes += group.entries.capacity() * sizeof(Node);
+        for (const Node &node : group.entries) {
+            // the group name of the key is the one of the group
+            usage.keyBytes += node.key.mKey.size();
+            if (!node.key.mKey.isNull() && !node.key.mKey.isDetached()) {
+                ++usage.sharedKeys;
+            }
+            usage.valueBytes += node.value.rawValue().size();
+            if (node.value.isShared()) {
+                ++usage.sharedValues;
+            }
+        }
+    }
+    return usage;
+}
+
+void KEntryMap::merge(const KEntryMap &other)
+{
+    const auto mergeEntry = [this](ConstIterator it) {
+        const KEntryKey &key = it.key();
+        const KEntry &entry = it.value();
+
+        EntryOptions options = {};
+        if (entry.bGlobal) {
+            options |= EntryGlobal;
+        }
+        if (entry.bImmutable) {
+            options |= EntryImmutable;
+        }
+        if (entry.bDeleted) {
+            options |= EntryDeleted;
+        }
+        if (entry.bExpand) {
+            options |= EntryExpansion;
+        }
+        if (entry.bBinary) {
+            options |= EntryBinary;
+        }
+        if (entry.bLocalizedCountry) {
+            options |= EntryLocalizedCountry;
+        }
+        if (entry.bEscaped) {
+            options |= EntryEscaped;
+        }
+        if (key.bRaw) {
+            options |= EntryRawKey;
+        }
+        if (key.bDefault || entry.bSharesDefault) {
+            options |= EntryDefault;
+        }
+        if (key.bLocal) {
+            options |= EntryLocalized;
+        }
+        setEntry(key.mGroup, key.mKey, static_cast<const KEntryValue &>(entry), options);
+    };
+    const auto isDefault = [](ConstIterator it) {
+        return it.key().bDefault || it->bSharesDefault;
+    };
+
+    // Setting a non-localized entry removes the localized one, so within one file
+    // the localized entries that survived must have been set after it. Defaults
+    // come first, the entries overriding them were set later.
+    for (const bool localized : {false, true}) {
+        for (const bool defaults : {true, false}) {
+            for (auto it = other.cbegin(), end = other.cend(); it != end; ++it) {
+                if (!it.key().mKey.isEmpty() && it.key().bLocal == localized && isDefault(it) == defaults) {
+                    mergeEntry(it);
+                }
+            }
+        }
+    }
+
+    // The parser marks groups as immutable once the whole file has been read
+    for (auto it = other.cbegin(), end = other.cend(); it != end; ++it) {
+        if (it.key().mKey.isEmpty() && it->bImmutable) {
+            setEntry(it.key().mGroup, QByteArray(), QByteArray(), EntryImmutable);
+        }
+    }
+}
@@ -11,19 +11,163 @@
 #define KCONFIGDATA_P_H
 
 #include <QByteArray>
+#include <QByteArrayList>
+#include <QByteArrayView>
 #include <QDebug>
-#include <QMap>
+#include <QList>
 #include <QString>
+#include <QStringList>
+#include <QVarLengthArray>
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * The value of a KEntry.
+ *
+ * Most config values are short, so values that fit into the space of a
+ * QByteArray are stored inline instead of in a separately allocated block.
+ * Only longer values are kept in a QByteArray, and converting to one is
+ * only needed by the callers that need a QByteArray.
+ * @internal
+ */
+class KEntryValue
+{
+public:
+    /**
+     * Values of up to this many bytes are stored inline.
+     */
+    static constexpr qsizetype InlineCapacity = sizeof(QByteArray);
+
+    KEntryValue() noexcept
+        : mSize(NullValue)
+    {
+    }
+    KEntryValue(const KEntryValue &other)
+    {
+        copyFrom(other);
+    }
+    KEntryValue(KEntryValue &&other) noexcept
+    {
+        moveFrom(std::move(other));
+    }
+    KEntryValue &operator=(const KEntryValue &other)
+    {
+        if (this != &other) {
+            destroy();
+            copyFrom(other);
+        }
+        return *this;
+    }
+    KEntryValue &operator=(KEntryValue &&other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            moveFrom(std::move(other));
+        }
+        return *this;
+    }
+    ~KEntryValue()
+    {
+        destroy();
+    }
+
+    /**
+     * Whether the value is null, as opposed to empty.
+     */
+    bool isNull() const
+    {
+        return mSize == NullValue;
+    }
+    /**
+     * Whether the value is stored inline.
+     */
+    bool isInline() const
+    {
+        return mSize <= InlineCapacity;
+    }
+    /**
+     * The value as stored, see KEntry::value() for the decoded one.
+     */
+    QByteArrayView rawValue() const
+    {
+        if (mSize == HeapValue) {
+            return mHeapValue;
+        }
+        return isNull() ? QByteArrayView() : QByteArrayView(mInlineValue, mSize);
+    }
+    /**
+     * Whether the value is kept in a QByteArray that is shared with other
+     * entries, through KConfigStringPool or copies of the entry.
+     */
+    bool isShared() const
+    {
+        return mSize == HeapValue && !mHeapValue.isDetached();
+    }
+    /**
+     * The value as stored, as a QByteArray. An inline value is copied.
+     */
+    QByteArray rawByteArray() const
+    {
+        if (mSize == HeapValue) {
+            return mHeapValue;
+        }
+        return isNull() ? QByteArray() : QByteArray(mInlineValue, mSize);
+    }
+    /**
+     * Sets the stored value. Values of up to InlineCapacity bytes are always
+     * copied, so for those @p value may be a QByteArray::fromRawData() that
+     * doesn't outlive the call.
+     */
+    void setValue(const QByteArray &value);
+
+protected:
+    // decoding an escaped value happens in place, it never makes the value longer
+    char *rawData() const
+    {
+        return mSize == HeapValue ? mHeapValue.data() : mInlineValue;
+    }
+    void truncateRaw(qsizetype size) const
+    {
+        if (mSize == HeapValue) {
+            mHeapValue.truncate(size);
+        } else if (!isNull()) {
+            mSize = quint8(size);
+        }
+    }
+
+private:
+    static constexpr quint8 NullValue = 0xfe;
+    static constexpr quint8 HeapValue = 0xff;
+
+    void destroy()
+    {
+        if (mSize == HeapValue) {
+            mHeapValue.~QByteArray();
+        }
+        mSize = NullValue;
+    }
+    void copyFrom(const KEntryValue &other);
+    void moveFrom(KEntryValue &&other) noexcept;
+
+    union {
+        mutable QByteArray mHeapValue; // if mSize is HeapValue
+        mutable char mInlineValue[InlineCapacity];
+    };
+    // the length of an inline value, NullValue or HeapValue
+    mutable quint8 mSize;
+};
 
 /**
  * map/dict/list config node entry.
  * @internal
  */
-struct KEntry {
+struct KEntry : KEntryValue {
     /** Constructor. @internal */
     KEntry()
-        : mValue()
-        , bDirty(false)
+        : bDirty(false)
         , bGlobal(false)
         , bImmutable(false)
         , bDeleted(false)
@@ -32,10 +176,11 @@ struct KEntry {
         , bLocalizedCountry(false)
         , bNotify(false)
         , bOverridesGlobal(false)
+        , bEscaped(false)
+        , bSharesDefault(false)
+        , bBinary(false)
     {
     }
-    /** @internal */
-    QByteArray mValue;
     /**
      * Must the entry be written back to disk?
      */
@@ -72,6 +217,45 @@ struct KEntry {
      * Entry will need to be written on a non global file even if it matches default value
      */
     bool bOverridesGlobal : 1;
+    /**
+     * The raw value still contains the escape sequences of the config file,
+     * they are decoded by the first call to value()
+     */
+    mutable bool bEscaped : 1;
+    /**
+     * The entry is the default entry of its key as well, there is no separate
+     * entry with KEntryKey::bDefault set. KEntryMap splits it into two entries
+     * once the value is overridden or reverted.
+     */
+    bool bSharesDefault : 1;
+    /**
+     * The value is written base64 encoded, with the [$b] option, instead of
+     * with every byte that isn't printable escaped. See KConfig::Binary.
+     */
+    bool bBinary : 1;
+
+    /**
+     * The value of the entry, with its escape sequences decoded.
+     * Note that the first call modifies the entry, even though it is const.
+     */
+    QByteArrayView value() const;
+    /**
+     * The decoded value as a QByteArray, which copies a value stored inline.
+     */
+    QByteArray toByteArray() const
+    {
+        value();
+        return rawByteArray();
+    }
+
+    /**
+     * Decodes the escape sequences of the ini format in place.
+     * @param str the data to decode, the decoded string is never longer
+     * @param length the length of @p str
+     * @param warnings if not null, a description of each invalid escape sequence is appended to it
+     * @return the length of the decoded string
+     */
+    static int unescape(char *str, int length, QStringList *warnings = nullptr);
 };
 
 // These operators are used to check whether an entry which is about
@@ -84,7 +268,8 @@ inline bool operator==(const KEntry &k1, const KEntry &k2)
         && k1.bImmutable == k2.bImmutable
         && k1.bDeleted == k2.bDeleted
         && k1.bExpand == k2.bExpand
-        && k1.mValue == k2.mValue;
+        && k1.bBinary == k2.bBinary
+        && (k1.bEscaped == k2.bEscaped ? k1.rawValue() == k2.rawValue() : k1.value() == k2.value());
     /* clang-format on */
 }
 
@@ -133,7 +318,7 @@ struct KEntryKey {
 };
 
 /**
- * Compares two KEntryKeys (needed for QMap). The order is localized, localized-default,
+ * Compares two KEntryKeys (needed for KEntryMap). The order is localized, localized-default,
  * non-localized, non-localized-default
  * @internal
  */
@@ -174,11 +359,143 @@ QDebug operator<<(QDebug dbg, const KEntry &entry);
  * type specifying a map of entries (key,value pairs).
  * The keys are actually a key in a particular config file group together
  * with the group name.
+ *
+ * The entries are stored in two levels: a vector of the groups sorted by name,
+ * each holding a list of its entries sorted by key. Lookups are two binary
+ * searches over contiguous memory and iteration is a linear walk, in the same
+ * order as KEntryKey's operator<().
+ *
+ * The entries of a group are implicitly shared: copying a map copies just the
+ * group names, and a group's entries are only copied once one of them is
+ * changed. Reading an escaped value decodes it in place, so all the values of a
+ * map must have been read once before copies of it are used in other threads.
+ *
+ * @note Unlike QMap, inserting or erasing entries invalidates all iterators.
  * @internal
  */
-class KEntryMap : public QMap<KEntryKey, KEntry>
+class KEntryMap
 {
+    enum ImmutableEntries : quint8 {
+        ImmutableUnknown, // not looked at since the entries last changed
+        ImmutableNone,
+        ImmutableSome, // or none anymore, the entry was made mutable again or removed
+    };
+    struct Node {
+        KEntryKey key;
+        KEntry value;
+    };
+    struct Group {
+        QByteArray name;
+        QList<Node> entries;
+        // set whenever an entry may have become dirty, see forEachDirtyEntry()
+        bool mayHaveDirtyEntries = false;
+        // the keys the entries that may be dirty are between, if mayHaveDirtyEntries is set
+        QByteArray dirtyFrom;
+        QByteArray dirtyTo;
+        // all the entries count as dirty without bDirty being set, so that they
+        // stay shared with the map they were copied from, see markAllDirty()
+        bool allDirty = false;
+        // whether an entry of the group, or its marker, is immutable, see mayHaveImmutableEntries()
+        mutable ImmutableEntries immutableEntries = ImmutableUnknown;
+    };
+    using Groups = std::vector<Group>;
+
 public:
+    template<bool IsConst>
+    class IteratorBase
+    {
+        using GroupsPointer = std::conditional_t<IsConst, const Groups *, Groups *>;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = qptrdiff;
+        using value_type = KEntry;
+        using pointer = std::conditional_t<IsConst, const KEntry *, KEntry *>;
+        using reference = std::conditional_t<IsConst, const KEntry &, KEntry &>;
+
+        IteratorBase() = default;
+
+        // an Iterator converts to a ConstIterator
+        template<bool OtherIsConst, typename = std::enable_if_t<IsConst && !OtherIsConst>>
+        IteratorBase(const IteratorBase<OtherIsConst> &other)
+            : m_groups(other.m_groups)
+            , m_group(other.m_group)
+            , m_entry(other.m_entry)
+        {
+        }
+
+        const KEntryKey &key() const
+        {
+            // doesn't detach the entries of the group
+            return std::as_const((*m_groups)[m_group].entries)[m_entry].key;
+        }
+        reference value() const
+        {
+            auto &group = (*m_groups)[m_group];
+            if constexpr (!IsConst) {
+                // the entry can be made dirty, or clean, or immutable through the reference
+                mayDirty(group, std::as_const(group.entries)[m_entry].key.mKey);
+                group.immutableEntries = ImmutableUnknown;
+                if (group.allDirty) {
+                    stampDirty(group);
+                }
+            }
+            return group.entries[m_entry].value;
+        }
+        reference operator*() const
+        {
+            return value();
+        }
+        pointer operator->() const
+        {
+            return &value();
+        }
+
+        IteratorBase &operator++()
+        {
+            // there are no empty groups
+            if (++m_entry == std::size_t((*m_groups)[m_group].entries.size())) {
+                ++m_group;
+                m_entry = 0;
+            }
+            return *this;
+        }
+        IteratorBase operator++(int)
+        {
+            IteratorBase it = *this;
+            ++*this;
+            return it;
+        }
+
+        friend bool operator==(const IteratorBase &it1, const IteratorBase &it2)
+        {
+            return it1.m_group == it2.m_group && it1.m_entry == it2.m_entry;
+        }
+        friend bool operator!=(const IteratorBase &it1, const IteratorBase &it2)
+        {
+            return !(it1 == it2);
+        }
+
+    private:
+        friend class KEntryMap;
+        friend class IteratorBase<!IsConst>;
+
+        IteratorBase(GroupsPointer groups, std::size_t group, std::size_t entry)
+            : m_groups(groups)
+            , m_group(group)
+            , m_entry(entry)
+        {
+        }
+
+        GroupsPointer m_groups = nullptr;
+        std::size_t m_group = 0;
+        std::size_t m_entry = 0;
+    };
+    using Iterator = IteratorBase<false>;
+    using ConstIterator = IteratorBase<true>;
+    using iterator = Iterator;
+    using const_iterator = ConstIterator;
+
     enum SearchFlag {
         SearchDefaults = 1,
         SearchLocalized = 2,
@@ -194,21 +511,164 @@ public:
         EntryRawKey = 32,
         EntryLocalizedCountry = 64,
         EntryNotify = 128,
+        EntryEscaped = 256,
+        EntryBinary = 512,
+        EntryReverted = 1024, // the entry is removed, only read from a journal, see KConfig::Journaled
         EntryDefault = (SearchDefaults << 16),
         EntryLocalized = (SearchLocalized << 16),
     };
     Q_DECLARE_FLAGS(EntryOptions, EntryOption)
 
-    Iterator findExactEntry(const QByteArray &group, const QByteArray &key = QByteArray(), SearchFlags flags = SearchFlags());
+    Iterator begin()
+    {
+        return Iterator(&m_groups, 0, 0);
+    }
+    Iterator end()
+    {
+        return Iterator(&m_groups, m_groups.size(), 0);
+    }
+    ConstIterator begin() const
+    {
+        return cbegin();
+    }
+    ConstIterator end() const
+    {
+        return cend();
+    }
+    ConstIterator cbegin() const
+    {
+        return ConstIterator(&m_groups, 0, 0);
+    }
+    ConstIterator cend() const
+    {
+        return ConstIterator(&m_groups, m_groups.size(), 0);
+    }
+    ConstIterator constBegin() const
+    {
+        return cbegin();
+    }
+    ConstIterator constEnd() const
+    {
+        return cend();
+    }
+
+    qsizetype size() const
+    {
+        return m_size;
+    }
+    bool isEmpty() const
+    {
+        return m_size == 0;
+    }
+    void clear()
+    {
+        m_groups.clear();
+        m_size = 0;
+        groupsChanged();
+    }
 
-    Iterator findEntry(const QByteArray &group, const QByteArray &key = QByteArray(), SearchFlags flags = SearchFlags());
+    /**
+     * Empties the map like clear(), but keeps the arrays that held the entries
+     * of the groups. The groups added next store their entries in them, so
+     * parsing the files again doesn't allocate all the arrays again. The ones
+     * still shared with another map aren't kept.
+     */
+    void recycle();
 
-    ConstIterator findEntry(const QByteArray &group, const QByteArray &key = QByteArray(), SearchFlags flags = SearchFlags()) const
+    /**
+     * Frees the arrays kept by recycle() that no group took, once the map is
+     * filled again.
+     */
+    void releaseRecycled()
+    {
+        m_recycled.lists.clear();
+    }
+
+    /**
+     * Frees the arrays kept by recycle() and the room left in the arrays of
+     * the groups, by deletions for instance. The arrays shared with another
+     * map are left as they are. Returns the number of bytes freed.
+     */
+    qint64 squeeze();
+
+    Iterator find(const KEntryKey &key);
+    ConstIterator find(const KEntryKey &key) const
+    {
+        return constFind(key);
+    }
+    ConstIterator constFind(const KEntryKey &key) const;
+    bool contains(const KEntryKey &key) const
+    {
+        return constFind(key) != cend();
+    }
+    /**
+     * Returns the first entry that is not less than @p key
+     */
+    ConstIterator lowerBound(const KEntryKey &key) const;
+    /**
+     * Returns the first entry after the group of @p it, so that a group can be
+     * gone through, or skipped, without comparing the group of each entry.
+     */
+    ConstIterator groupEnd(const ConstIterator &it) const
+    {
+        return ConstIterator(&m_groups, it.m_group + 1, 0);
+    }
+
+    /**
+     * Inserts @p value, replacing the value of an existing entry with the same key.
+     * As with QMap, the key of an existing entry is kept.
+     */
+    Iterator insert(const KEntryKey &key, const KEntry &value);
+    KEntry &operator[](const KEntryKey &key);
+    KEntry value(const KEntryKey &key) const;
+    Iterator erase(Iterator it);
+    qsizetype remove(const KEntryKey &key);
+    /**
+     * Does the same as remove() for each of @p keys, but every group is
+     * gone through once, instead of moving its entries for each one removed.
+     * @return the number of entries removed
+     */
+    qsizetype remove(QList<KEntryKey> keys);
+
+    // The lookups take views, so that reading an entry doesn't need to allocate anything
+    Iterator findExactEntry(QByteArrayView group, QByteArrayView key = {}, SearchFlags flags = SearchFlags());
+
+    Iterator findEntry(QByteArrayView group, QByteArrayView key = {}, SearchFlags flags = SearchFlags());
+
+    ConstIterator findEntry(QByteArrayView group, QByteArrayView key = {}, SearchFlags flags = SearchFlags()) const
     {
         return constFindEntry(group, key, flags);
     }
 
-    ConstIterator constFindEntry(const QByteArray &group, const QByteArray &key = QByteArray(), SearchFlags flags = SearchFlags()) const;
+    ConstIterator constFindEntry(QByteArrayView group, QByteArrayView key = {}, SearchFlags flags = SearchFlags()) const;
+
+    /**
+     * Where a group was found, so that reading more of its keys doesn't have
+     * to search for the group again.
+     *
+     * A hint stays valid until a group is added to or removed from the map.
+     * Every such change gives the map a new generation, which copies with the
+     * same groups share, so a hint may be used with any of them.
+     */
+    struct GroupHint {
+        quint64 generation = 0;
+        std::size_t index = 0;
+    };
+
+    /**
+     * The generation of the groups of the map, see GroupHint. Iterators stay
+     * valid while it doesn't change, as long as no entry is added or removed.
+     */
+    quint64 groupsGeneration() const
+    {
+        return m_generation;
+    }
+
+    /**
+     * Same as constFindEntry(), finding @p group through @p hint and updating
+     * @p hint when it is stale.
+     */
+    ConstIterator constFindEntry(QByteArrayView group, GroupHint *hint, QByteArrayView key, SearchFlags flags) const;
 
     /**
      * Returns true if the entry gets dirtied or false in other case
@@ -220,46 +680,374 @@ public:
         setEntry(group, key, value.toUtf8(), options);
     }
 
-    QString getEntry(const QByteArray &group,
-                     const QByteArray &key,
+    /**
+     * One entry for setEntries()
+     */
+    struct EntryWrite {
+        QByteArray key;
+        QByteArray value;
+        EntryOptions options;
+    };
+
+    /**
+     * Does the same as calling setEntry() for each of @p writes in turn, but
+     * the entries new to @p group are merged into it in one pass instead of
+     * being inserted one at a time.
+     * @return whether an entry written with EntryDirty changed
+     */
+    bool setEntries(const QByteArray &group, std::vector<EntryWrite> writes);
+
+    QString getEntry(QByteArrayView group,
+                     QByteArrayView key,
                      const QString &defaultValue = QString(),
                      SearchFlags flags = SearchFlags(),
-                     bool *expand = nullptr) const;
+                     bool *expand = nullptr,
+                     GroupHint *hint = nullptr) const;
 
-    bool hasEntry(const QByteArray &group, const QByteArray &key = QByteArray(), SearchFlags flags = SearchFlags()) const;
+    bool hasEntry(QByteArrayView group, QByteArrayView key = {}, SearchFlags flags = SearchFlags()) const;
 
     bool getEntryOption(const ConstIterator &it, EntryOption option) const;
-    bool getEntryOption(const QByteArray &group, const QByteArray &key, SearchFlags flags, EntryOption option) const
+
+    /**
+     * Returns false if no entry of @p group is immutable, the group itself
+     * included. This is found once and kept until the entries of the group
+     * change, so that when nothing is immutable, as in most configs, asking
+     * about an entry doesn't have to look it up. Returns true if there may be
+     * one, which getEntryOption() tells for sure.
+     */
+    bool mayHaveImmutableEntries(QByteArrayView group) const;
+    bool getEntryOption(QByteArrayView group, QByteArrayView key, SearchFlags flags, EntryOption option) const
     {
         return getEntryOption(findEntry(group, key, flags), option);
     }
 
     void setEntryOption(Iterator it, EntryOption option, bool bf);
-    void setEntryOption(const QByteArray &group, const QByteArray &key, SearchFlags flags, EntryOption option, bool bf)
+    void setEntryOption(QByteArrayView group, QByteArrayView key, SearchFlags flags, EntryOption option, bool bf)
     {
         setEntryOption(findEntry(group, key, flags), option, bf);
     }
 
     bool revertEntry(const QByteArray &group, const QByteArray &key, EntryOptions options, SearchFlags flags = SearchFlags());
 
+    /**
+     * Whether the entry @p it has a default value. Unlike looking for the key
+     * with bDefault set, this also sees a default sharing the entry.
+     */
+    bool hasDefault(const ConstIterator &it) const;
+
+    /**
+     * Sets the entries of @p other, the map of a config file parsed on its own,
+     * as if the file had been parsed into this map directly.
+     */
+    void merge(const KEntryMap &other);
+
     template<typename ConstIteratorUser>
     void forEachEntryWhoseGroupStartsWith(const QByteArray &groupPrefix, ConstIteratorUser callback) const
     {
-        for (auto it = lowerBound(minimumGroupKey(groupPrefix)), end = cend(); it != end && it.key().mGroup.startsWith(groupPrefix); ++it) {
-            callback(it);
+        for (std::size_t group = groupLowerBound(groupPrefix); group < m_groups.size() && m_groups[group].name.startsWith(groupPrefix); ++group) {
+            for (std::size_t entry = 0, count = m_groups[group].entries.size(); entry < count; ++entry) {
+                callback(ConstIterator(&m_groups, group, entry));
+            }
         }
     }
 
+    /**
+     * Calls @p callback with each entry of @p group and of all the groups below it.
+     *
+     * The groups are sorted by name, so the subgroups of a group are all found
+     * between "<group>\x1d" and "<group>\x1e" by two binary searches. Unlike
+     * forEachEntryWhoseGroupStartsWith(), this takes time in proportion to the
+     * entries of the tree alone, and groups like "<group>Other" aren't included.
+     */
+    template<typename ConstIteratorUser>
+    void forEachEntryInGroupTree(QByteArrayView group, ConstIteratorUser callback) const
+    {
+        forEachGroupInTree(group, [this, &callback](std::size_t index) {
+            for (std::size_t entry = 0, count = m_groups[index].entries.size(); entry < count; ++entry) {
+                callback(ConstIterator(&m_groups, index, entry));
+            }
+        });
+    }
+
     template<typename ConstIteratorPredicate>
     bool anyEntryWhoseGroupStartsWith(const QByteArray &groupPrefix, ConstIteratorPredicate predicate) const
     {
-        for (auto it = lowerBound(minimumGroupKey(groupPrefix)), end = cend(); it != end && it.key().mGroup.startsWith(groupPrefix); ++it) {
-            if (predicate(it)) {
-                return true;
+        for (std::size_t group = groupLowerBound(groupPrefix); group < m_groups.size() && m_groups[group].name.startsWith(groupPrefix); ++group) {
+            for (std::size_t entry = 0, count = m_groups[group].entries.size(); entry < count; ++entry) {
+                if (predicate(ConstIterator(&m_groups, group, entry))) {
+                    return true;
+                }
             }
         }
         return false;
     }
+
+    /**
+     * Calls @p callback with each entry that has bDirty set, group markers included.
+     *
+     * Every group remembers whether one of its entries may have become dirty
+     * since this last found it clean, and the range of keys of those, so only
+     * the entries changed since then are looked at. @p callback may change the
+     * entries, but must not add or remove any.
+     */
+    template<typename IteratorUser>
+    void forEachDirtyEntry(IteratorUser callback)
+    {
+        for (std::size_t group = 0; group < m_groups.size(); ++group) {
+            if (!m_groups[group].mayHaveDirtyEntries) {
+                continue;
+            }
+            if (m_groups[group].allDirty) {
+                stampDirty(m_groups[group]); // @p callback may clean some of them
+            }
+            Group stillDirty; // only the range of keys
+            const auto [first, last] = dirtyRange(m_groups[group]);
+            for (std::size_t entry = first; entry < last; ++entry) {
+                const Node &node = std::as_const(m_groups[group].entries)[entry];
+                if (node.value.bDirty) {
+                    callback(Iterator(&m_groups, group, entry));
+                    if (node.value.bDirty) {
+                        mayDirty(stillDirty, node.key.mKey);
+                    }
+                }
+            }
+            m_groups[group].mayHaveDirtyEntries = stillDirty.mayHaveDirtyEntries;
+            m_groups[group].dirtyFrom = stillDirty.dirtyFrom;
+            m_groups[group].dirtyTo = stillDirty.dirtyTo;
+        }
+    }
+
+    /**
+     * Calls @p callback with the group marker of each group that has one.
+     */
+    template<typename ConstIteratorUser>
+    void forEachGroupMarker(ConstIteratorUser callback) const
+    {
+        for (std::size_t group = 0; group < m_groups.size(); ++group) {
+            // the marker has the smallest key, so it comes first
+            if (m_groups[group].entries.front().key.mKey.isEmpty()) {
+                callback(ConstIterator(&m_groups, group, 0));
+            }
+        }
+    }
+
+    /**
+     * Moves what writing the dirty entries to a file needs into a new map: the
+     * dirty entries, the defaults of those and all the group markers. The
+     * entries of this map are clean afterwards.
+     */
+    KEntryMap takeDirtyEntries();
+
+    /**
+     * Makes all the entries dirty, as if each had bDirty set. The groups
+     * aren't touched, so a copy of a map made dirty this way shares their
+     * entries with the original until they're changed or written.
+     */
+    void markAllDirty();
+
+    /**
+     * A map of only the entries of @p group, defaults and localized ones
+     * included, but not those of its subgroups. The entries are shared with
+     * this map, not copied.
+     */
+    KEntryMap groupEntries(QByteArrayView group) const;
+
+    /**
+     * Replaces the entries of @p group with those it has in @p source, sharing
+     * them, or removes the group if @p source doesn't have it. Subgroups are
+     * left alone.
+     */
+    void replaceGroup(QByteArrayView group, const KEntryMap &source);
+
+    /**
+     * Whether @p group has the same entries in @p other, defaults and localized
+     * ones included. Groups that share their entries compare without a look at them.
+     */
+    bool hasSameGroup(QByteArrayView group, const KEntryMap &other) const;
+
+    /**
+     * Whether @p group or one of its subgroups has an entry that isn't deleted,
+     * not counting group markers.
+     */
+    bool hasNonDeletedEntries(QByteArrayView group) const;
+
+    /**
+     * Returns the names of the direct subgroups of @p parentGroup that have an entry
+     * which isn't deleted, in themselves or in one of their own subgroups, sorted.
+     * An empty @p parentGroup returns the top level groups.
+     *
+     * The groups are sorted by name, so all the subgroups of a group follow it
+     * and can be skipped with one binary search once it is known to be listed.
+     * The views are valid until the map is modified.
+     */
+    QList<QByteArrayView> subGroupNames(QByteArrayView parentGroup) const;
+
+    /**
+     * Calls @p callback with each name subGroupNames() returns, without building a list
+     * of them. The names come in the order of the groups, which is sorted unless names
+     * have characters sorting before '\x1d'.
+     */
+    template<typename Callback>
+    void forEachSubGroupName(QByteArrayView parentGroup, Callback callback) const
+    {
+        // the names searched for are built on the stack
+        QVarLengthArray<char, 256> prefix;
+        prefix.append(parentGroup.data(), parentGroup.size());
+        if (!prefix.isEmpty()) {
+            prefix.append('\x1d');
+        }
+        const QByteArrayView prefixView(prefix.constData(), prefix.size());
+
+        QVarLengthArray<char, 256> subGroupsEnd;
+        QByteArrayView last;
+        std::size_t i = groupLowerBound(prefixView);
+        while (i < m_groups.size() && m_groups[i].name.startsWith(prefixView)) {
+            const QByteArray &name = m_groups[i].name;
+            if (!hasNonDeletedEntry(m_groups[i])) {
+                ++i;
+                continue;
+            }
+
+            const qsizetype separator = name.indexOf('\x1d', prefixView.size());
+            const QByteArrayView subGroup = QByteArrayView(name).sliced(prefixView.size(), (separator < 0 ? name.size() : separator) - prefixView.size());
+            if (subGroup != last) {
+                // Groups with characters before '\x1d' may come between a subgroup and
+                // its own subgroups, then the subgroup was listed for its own entries
+                bool listed = false;
+                if (separator >= 0) {
+                    const std::size_t index = groupIndex(QByteArrayView(name).first(separator));
+                    listed = index < m_groups.size() && hasNonDeletedEntry(m_groups[index]);
+                }
+                if (!listed) {
+                    callback(subGroup);
+                }
+                last = subGroup;
+            }
+            if (separator < 0) {
+                ++i;
+            } else {
+                // everything up to "<subgroup>\x1e" is below the subgroup just listed
+                subGroupsEnd.clear();
+                subGroupsEnd.append(name.constData(), separator);
+                subGroupsEnd.append('\x1e');
+                i = groupLowerBound(QByteArrayView(subGroupsEnd.constData(), subGroupsEnd.size()));
+            }
+        }
+    }
+
+    /**
+     * Returns @p group and the names of all the groups below it that have a
+     * group marker, including deleted ones.
+     */
+    QByteArrayList groupAndSubGroupNames(QByteArrayView group) const;
+
+    /**
+     * Returns the group and the key of each entry that isn't the same in
+     * @p previous, including the ones only one of the maps has, in the order
+     * of the map. A key is listed once for all its localized and default
+     * variants, the group marker has an empty key. Groups whose entries are
+     * still shared with @p previous aren't compared.
+     */
+    QList<KEntryKey> differences(const KEntryMap &previous) const;
+
+    // What the entries hold, see KConfig::memoryUsage()
+    struct MemoryUsage {
+        qsizetype groups = 0;
+        qsizetype entries = 0;
+        qint64 keyBytes = 0; // group names and keys
+        qint64 valueBytes = 0;
+        qsizetype sharedKeys = 0;
+        qsizetype sharedValues = 0;
+        qsizetype sharedGroups = 0; // whose entries are shared with other maps
+        qint64 structureBytes = 0; // the nodes and groups, allocated or not
+    };
+    MemoryUsage memoryUsage() const;
+
+private:
+    // whether @p group has an entry that isn't deleted, not counting the marker
+    static bool hasNonDeletedEntry(const Group &group);
+    // the indexes of the groups below @p group, from the first one to past the last one
+    std::pair<std::size_t, std::size_t> subGroupRange(QByteArrayView group) const;
+    // calls @p callback with the index of @p group if there is such a group, then with the ones of subGroupRange()
+    template<typename GroupIndexUser>
+    void forEachGroupInTree(QByteArrayView group, GroupIndexUser callback) const
+    {
+        const std::size_t index = groupIndex(group);
+        if (index < m_groups.size()) {
+            callback(index);
+        }
+        const auto [first, last] = subGroupRange(group);
+        for (std::size_t i = first; i < last; ++i) {
+            callback(i);
+        }
+    }
+    // index of the first group whose name is not less than @p name
+    std::size_t groupLowerBound(QByteArrayView name) const;
+    // index of the first entry of @p group that is not less than the given key
+    static std::size_t entryLowerBound(const Group &group, QByteArrayView key, bool isLocalized, bool isDefault);
+    // index of @p group, or m_groups.size() if there is no such group, through @p hint if it isn't null
+    std::size_t groupIndex(QByteArrayView group, GroupHint *hint = nullptr) const;
+    ConstIterator constFind(QByteArrayView group, QByteArrayView key, bool isLocalized, bool isDefault) const;
+    // like constFind(), in the group at @p groupIndex
+    ConstIterator constFindInGroup(std::size_t groupIndex, QByteArrayView key, bool isLocalized, bool isDefault) const;
+    // like constFind(), but a default may also be shared by the effective entry
+    ConstIterator constFindWithSharedDefault(QByteArrayView group, QByteArrayView key, bool isLocalized, bool isDefault) const;
+    ConstIterator constFindWithSharedDefault(std::size_t groupIndex, QByteArrayView key, bool isLocalized, bool isDefault) const;
+    // gives the map a new generation, whenever a group is added or removed
+    void groupsChanged();
+    // sets the value of @p e and the flags that go with it, as setEntry() does
+    static void applyValue(KEntry &e, const KEntryValue &value, EntryOptions options);
+    // merge() passes the value of an entry of another map on without converting it
+    bool setEntry(const QByteArray &group, const QByteArray &key, const KEntryValue &value, EntryOptions options);
+    // removes the localized entry of @p key, keeping its default unless @p withDefault
+    bool removeLocalized(QByteArrayView group, QByteArrayView key, bool withDefault);
+    // gives the default shared by the entry @p it an entry of its own
+    void splitDefault(Iterator it);
+    // sets bDirty on all the entries of a group marked allDirty, which detaches them
+    static void stampDirty(Group &group);
+    // notes that the entries of @p key may have become dirty
+    static void mayDirty(Group &group, const QByteArray &key)
+    {
+        if (!group.mayHaveDirtyEntries) {
+            group.mayHaveDirtyEntries = true;
+            group.dirtyFrom = key;
+            group.dirtyTo = key;
+        } else if (key < group.dirtyFrom) {
+            group.dirtyFrom = key;
+        } else if (group.dirtyTo < key) {
+            group.dirtyTo = key;
+        }
+    }
+    // the indexes of the entries of @p group that may be dirty, if it has any
+    static std::pair<std::size_t, std::size_t> dirtyRange(const Group &group);
+    // the entries of a new group, in an array kept by recycle() if there is one
+    QList<Node> takeRecycled();
+
+    // The arrays kept by recycle(). They stay with the map object: a copy doesn't
+    // get them, and assigning another map doesn't replace them.
+    struct Recycled {
+        std::vector<QList<Node>> lists;
+
+        Recycled() = default;
+        Recycled(const Recycled &)
+        {
+        }
+        Recycled(Recycled &&) = default;
+        Recycled &operator=(const Recycled &)
+        {
+            return *this;
+        }
+        Recycled &operator=(Recycled &&)
+        {
+            return *this;
+        }
+    };
+    Recycled m_recycled;
+
+    Groups m_groups;
+    qsizetype m_size = 0;
+    // see GroupHint, 0 for a map that never had any groups
+    quint64 m_generation = 0;
 };
 Q_DECLARE_OPERATORS_FOR_FLAGS(KEntryMap::SearchFlags)
 Q_DECLARE_OPERATORS_FOR_FLAGS(KEntryMap::EntryOptions)
@@ -269,7 +1057,7 @@ Q_DECLARE_OPERATORS_FOR_FLAGS(KEntryMap::EntryOptions)
  * type for iterating over keys in a KEntryMap in sorted order.
  * @internal
  */
-typedef QMap<KEntryKey, KEntry>::Iterator KEntryMapIterator;
+typedef KEntryMap::Iterator KEntryMapIterator;
 
 /**
  * \relates KEntry
@@ -278,6 +1066,6 @@ typedef QMap<KEntryKey, KEntry>::Iterator KEntryMapIterator;
  * only examine them.
  * @internal
  */
-typedef QMap<KEntryKey, KEntry>::ConstIterator KEntryMapConstIterator;
+typedef KEntryMap::ConstIterator KEntryMapConstIterator;
 
 #endif
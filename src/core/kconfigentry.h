@@ -0,0 +1,173 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGENTRY_H
+#define KCONFIGENTRY_H
+
+#include <kconfiggroup.h>
+
+#include <QMetaEnum>
+
+#include <type_traits>
+
+/**
+ * \class KConfigEntry kconfigentry.h <KConfigEntry>
+ *
+ * Describes one setting: its group, its key, its type and its default value,
+ * as a constant that can be declared once and used wherever the setting is
+ * read or written.
+ *
+ * @code
+ * constexpr KConfigEntry<int> Width{"General", "Width", 800};
+ * constexpr KConfigEntry<QString> Theme{"Icons", "Theme", "breeze"};
+ *
+ * resize(Width.read(config), height);
+ * Theme.write(config, QStringLiteral("oxygen"));
+ * @endcode
+ *
+ * Which types may be read is checked at compile time: bool, int, qint64,
+ * double, QString, and enums declared with Q_ENUM() or Q_FLAG(). Each one is
+ * read with the KConfigGroup method parsing it where it is stored, e.g.
+ * KConfigGroup::readIntEntry(), instead of going through a QVariant. Strings
+ * are given as UTF-8 defaults, and enums are stored by the names of their
+ * values, see KConfigGroup::readEnumEntry().
+ *
+ * The group is a top level group. For a nested group, or to read the entry
+ * over and over, pass a KConfigGroup or a KConfigKey of the entry, see
+ * configKey(), instead of the config.
+ *
+ * @since 6.1
+ */
+template<typename T>
+class KConfigEntry
+{
+    static_assert(std::is_same_v<T, bool> || std::is_same_v<T, int> || std::is_same_v<T, qint64> || std::is_same_v<T, double> || std::is_same_v<T, QString>
+                      || std::is_enum_v<T>,
+                  "KConfigEntry only supports bool, int, qint64, double, QString and enums declared with Q_ENUM or Q_FLAG");
+
+public:
+    /**
+     * The type the default value is given as, UTF-8 encoded for a QString.
+     */
+    using DefaultType = std::conditional_t<std::is_same_v<T, QString>, const char *, T>;
+
+    /**
+     * @param group the name of the group, encoded in UTF-8
+     * @param key the key, encoded in UTF-8
+     * @param aDefault the value read when there is no entry
+     */
+    constexpr KConfigEntry(const char *group, const char *key, DefaultType aDefault = DefaultType{})
+        : m_group(group)
+        , m_key(key)
+        , m_default(aDefault)
+    {
+    }
+
+    /**
+     * The name of the group, encoded in UTF-8.
+     */
+    constexpr const char *group() const
+    {
+        return m_group;
+    }
+    /**
+     * The key, encoded in UTF-8.
+     */
+    constexpr const char *key() const
+    {
+        return m_key;
+    }
+    /**
+     * The value read when there is no entry.
+     */
+    constexpr DefaultType defaultValue() const
+    {
+        return m_default;
+    }
+
+    /**
+     * Reads the value of the entry from @p config.
+     */
+    T read(const KConfigBase *config) const
+    {
+        return read(KConfigGroup(config, m_group));
+    }
+    /**
+     * Reads the value of the key of the entry from @p group, which replaces the
+     * group of the entry.
+     */
+    T read(const KConfigGroup &group) const
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            return group.readBoolEntry(m_key, m_default);
+        } else if constexpr (std::is_same_v<T, int>) {
+            return group.readIntEntry(m_key, m_default);
+        } else if constexpr (std::is_same_v<T, qint64>) {
+            return group.readInt64Entry(m_key, m_default);
+        } else if constexpr (std::is_same_v<T, double>) {
+            return group.readDoubleEntry(m_key, m_default);
+        } else if constexpr (std::is_same_v<T, QString>) {
+            return group.readEntry(m_key, m_default);
+        } else {
+            return static_cast<T>(group.readEnumEntry(m_key, QMetaEnum::fromType<T>(), static_cast<int>(m_default)));
+        }
+    }
+    /**
+     * Reads the value of the entry through a handle to it, taken with configKey().
+     * Only for bool, int and QString, which KConfigKey reads.
+     */
+    T read(const KConfigKey &handle) const
+    {
+        static_assert(std::is_same_v<T, bool> || std::is_same_v<T, int> || std::is_same_v<T, QString>, "KConfigKey only reads bool, int and QString entries");
+        if constexpr (std::is_same_v<T, bool>) {
+            return handle.readBoolEntry(m_default);
+        } else if constexpr (std::is_same_v<T, int>) {
+            return handle.readIntEntry(m_default);
+        } else {
+            return handle.readEntry(QString::fromUtf8(m_default));
+        }
+    }
+
+    /**
+     * Returns a handle to the entry in @p config, for reading it over and over.
+     * @see KConfigGroup::configKey()
+     */
+    KConfigKey configKey(const KConfigBase *config) const
+    {
+        return KConfigGroup(config, m_group).configKey(m_key);
+    }
+
+    /**
+     * Writes @p value to the entry in @p config.
+     */
+    void write(KConfigBase *config, const T &value, KConfigBase::WriteConfigFlags flags = KConfigBase::Normal) const
+    {
+        KConfigGroup group(config, m_group);
+        write(group, value, flags);
+    }
+    /**
+     * Writes @p value to the key of the entry in @p group, which replaces the
+     * group of the entry.
+     */
+    void write(KConfigGroup &group, const T &value, KConfigBase::WriteConfigFlags flags = KConfigBase::Normal) const
+    {
+        if constexpr (std::is_enum_v<T>) {
+            const QMetaEnum metaEnum = QMetaEnum::fromType<T>();
+            const int v = static_cast<int>(value);
+            group.writeEntry(m_key, metaEnum.isFlag() ? metaEnum.valueToKeys(v) : QByteArray(metaEnum.valueToKey(v)), flags);
+        } else {
+            group.writeEntry(m_key, value, flags);
+        }
+    }
+
+private:
+    const char *m_group;
+    const char *m_key;
+    DefaultType m_default;
+};
+
+#endif // KCONFIGENTRY_H
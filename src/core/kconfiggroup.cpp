@@ -14,11 +14,15 @@
 #include "kconfig_core_log_settings.h"
 #include "kconfig_p.h"
 #include "kconfigdata_p.h"
+#include "kconfiggroupsnapshot.h"
+#include "kconfigtrace_p.h"
 #include "ksharedconfig.h"
 
 #include <QDate>
 #include <QDir>
 #include <QFile>
+#include <QLocale>
+#include <QMetaEnum>
 #include <QPoint>
 #include <QRect>
 #include <QSharedData>
@@ -26,9 +30,14 @@
 #include <QTextStream>
 #include <QUrl>
 #include <QUuid>
+#include <QVarLengthArray>
 
 #include <algorithm>
 #include <array>
+#include <charconv>
+#include <optional>
+#include <type_traits>
+#include <utility>
 #include <math.h>
 #include <stdlib.h>
 
@@ -44,6 +53,7 @@ public:
         if (Q_UNLIKELY(!mOwner->name().isEmpty() && mOwner->accessMode() == KConfigBase::NoAccess)) {
             qCWarning(KCONFIG_CORE_LOG) << "Created a KConfigGroup on an inaccessible config location" << mOwner->name() << name;
         }
+        mFullName = this->name();
     }
 
     KConfigGroupPrivate(const KSharedConfigPtr &owner, const QByteArray &name)
@@ -56,6 +66,7 @@ public:
         if (Q_UNLIKELY(!mOwner->name().isEmpty() && mOwner->accessMode() == KConfigBase::NoAccess)) {
             qCWarning(KCONFIG_CORE_LOG) << "Created a KConfigGroup on an inaccessible config location" << mOwner->name() << name;
         }
+        mFullName = this->name();
     }
 
     KConfigGroupPrivate(KConfigGroup *parent, bool isImmutable, bool isConst, const QByteArray &name)
@@ -68,6 +79,7 @@ public:
         if (!parent->d->mName.isEmpty()) {
             mParent = parent->d;
         }
+        mFullName = mParent ? mParent->fullName(mName) : this->name();
     }
 
     KConfigGroupPrivate(const KConfigGroupPrivate *other, bool isImmutable, const QByteArray &name)
@@ -80,23 +92,25 @@ public:
         if (!other->mName.isEmpty()) {
             mParent = const_cast<KConfigGroupPrivate *>(other);
         }
+        mFullName = mParent ? mParent->fullName(mName) : this->name();
     }
 
     KSharedConfig::Ptr sOwner;
     KConfig *mOwner;
     QExplicitlySharedDataPointer<KConfigGroupPrivate> mParent;
     QByteArray mName;
+    // the names of the parents and mName joined, as the group is stored in the entry map
+    QByteArray mFullName;
+    // where the group was last found in the entry map
+    mutable KEntryMap::GroupHint mHint;
 
     /* bitfield */
     const bool bImmutable : 1; // is this group immutable?
     const bool bConst : 1; // is this group read-only?
 
-    QByteArray fullName() const
+    const QByteArray &fullName() const
     {
-        if (!mParent) {
-            return name();
-        }
-        return mParent->fullName(mName);
+        return mFullName;
     }
 
     QByteArray name() const
@@ -128,34 +142,97 @@ public:
 
     static QByteArray serializeList(const QList<QByteArray> &list);
     static QStringList deserializeList(const QString &data);
+    // Same for UTF-8 data, without converting all of it to a QString first
+    static QStringList deserializeList(QByteArrayView data);
+    // Reads the list in @p key as readEntry(key, QString()) followed by deserializeList() would,
+    // returns false if there is no such entry
+    static bool readList(const KConfigGroup &group, const char *key, QStringList *list);
+    // Same, converting each element from its UTF-8 with @p convert instead of making a QString of it
+    template<typename T, typename Convert>
+    static QList<T> readList(const KConfigGroup &group, const char *key, const QList<T> &aDefault, Convert convert);
+    // Writes @p list as writeEntry() of a QVariantList of its elements would
+    template<typename T, typename Format>
+    static void writeList(KConfigGroup &group, const char *key, const QList<T> &list, KConfigBase::WriteConfigFlags flags, Format format);
 };
 
 QByteArray KConfigGroupPrivate::serializeList(const QList<QByteArray> &list)
 {
-    QByteArray value;
+    if (list.isEmpty()) {
+        return QByteArray();
+    }
 
-    if (!list.isEmpty()) {
-        auto it = list.cbegin();
-        const auto end = list.cend();
+    qsizetype size = list.size() - 1; // the separators
+    for (const QByteArray &item : list) {
+        size += item.size() + item.count('\\') + item.count(',');
+    }
+    // To be able to distinguish an empty list from a list with one empty element.
+    if (size == 0) {
+        return QByteArrayLiteral("\\0");
+    }
 
-        value = QByteArray(*it).replace('\\', QByteArrayLiteral("\\\\")).replace(',', QByteArrayLiteral("\\,"));
+    QByteArray value(size, Qt::Uninitialized);
+    char *out = value.data();
+    for (auto it = list.cbegin(); it != list.cend(); ++it) {
+        if (it != list.cbegin()) {
+            *out++ = ',';
+        }
+        for (const char c : *it) {
+            if (c == '\\' || c == ',') {
+                *out++ = '\\';
+            }
+            *out++ = c;
+        }
+    }
+    Q_ASSERT(out == value.constData() + size);
+    return value;
+}
 
-        while (++it != end) {
-            // In the loop, so it is not done when there is only one element.
-            // Doing it repeatedly is a pretty cheap operation.
-            value.reserve(4096);
+static char16_t listChar(QChar c)
+{
+    return c.unicode();
+}
 
-            value += ',';
-            value += QByteArray(*it).replace('\\', QByteArrayLiteral("\\\\")).replace(',', QByteArrayLiteral("\\,"));
-        }
+static char listChar(char c)
+{
+    return c;
+}
 
-        // To be able to distinguish an empty list from a list with one empty element.
-        if (value.isEmpty()) {
-            value = QByteArrayLiteral("\\0");
+// Passes every element of the list serialized in @p data to @p append, with the escapes removed.
+// Elements without escapes are passed as slices of @p data.
+template<typename Char, typename View, typename Append>
+static void splitList(View data, Append append)
+{
+    QVarLengthArray<Char, 256> unescaped;
+    const auto appendElement = [&data, &unescaped, &append](qsizetype start, qsizetype end, bool escaped) {
+        if (!escaped) {
+            append(data.sliced(start, end - start));
+            return;
+        }
+        unescaped.clear();
+        for (qsizetype p = start; p < end; ++p) {
+            if (listChar(data[p]) == '\\' && ++p == end) {
+                break; // a lone backslash at the end of the data
+            }
+            unescaped.append(data[p]);
+        }
+        append(View(unescaped.constData(), unescaped.size()));
+    };
+
+    qsizetype start = 0;
+    bool escaped = false;
+    const qsizetype size = data.size();
+    for (qsizetype p = 0; p < size; ++p) {
+        const auto c = listChar(data[p]);
+        if (c == '\\') {
+            escaped = true;
+            ++p;
+        } else if (c == ',') {
+            appendElement(start, p, escaped);
+            start = p + 1;
+            escaped = false;
         }
     }
-
-    return value;
+    appendElement(start, size, escaped);
 }
 
 QStringList KConfigGroupPrivate::deserializeList(const QString &data)
@@ -167,28 +244,106 @@ QStringList KConfigGroupPrivate::deserializeList(const QString &data)
         return QStringList(QString());
     }
     QStringList value;
-    QString val;
-    val.reserve(data.size());
-    bool quoted = false;
-    for (int p = 0; p < data.length(); p++) {
-        if (quoted) {
-            val += data[p];
-            quoted = false;
-        } else if (data[p].unicode() == '\\') {
-            quoted = true;
-        } else if (data[p].unicode() == ',') {
-            val.squeeze(); // release any unused memory
-            value.append(val);
-            val.clear();
-            val.reserve(data.size() - p);
-        } else {
-            val += data[p];
-        }
+    splitList<QChar>(QStringView(data), [&value](QStringView element) {
+        value.append(element.toString());
+    });
+    return value;
+}
+
+QStringList KConfigGroupPrivate::deserializeList(QByteArrayView data)
+{
+    if (data.isEmpty()) {
+        return QStringList();
+    }
+    if (data == QByteArrayView("\\0")) {
+        return QStringList(QString());
     }
-    value.append(val);
+    QStringList value;
+    splitList<char>(data, [&value](QByteArrayView element) {
+        value.append(QString::fromUtf8(element));
+    });
     return value;
 }
 
+bool KConfigGroupValues::toBool(QByteArrayView value)
+{
+    // the same as convertToQVariant()
+    static const std::array<QByteArrayView, 4> negatives = {"false", "no", "off", "0"};
+    return std::none_of(negatives.begin(), negatives.end(), [value](QByteArrayView negative) {
+        return value.compare(negative, Qt::CaseInsensitive) == 0;
+    });
+}
+
+QStringList KConfigGroupValues::toStringList(QByteArrayView value)
+{
+    return KConfigGroupPrivate::deserializeList(value);
+}
+
+QStringList KConfigGroupValues::toStringList(const QString &value)
+{
+    return KConfigGroupPrivate::deserializeList(value);
+}
+
+bool KConfigGroupPrivate::readList(const KConfigGroup &group, const char *key, QStringList *list)
+{
+    bool expand = false;
+    const QByteArrayView data = group.config()->d_func()->lookupValue(group.d->fullName(), key, KEntryMap::SearchLocalized, &expand, &group.d->mHint);
+    if (data.isNull()) {
+        return false;
+    }
+    if (expand) {
+        *list = deserializeList(group.config()->d_func()->expandCached(QString::fromUtf8(data)));
+    } else {
+        *list = deserializeList(data);
+    }
+    return true;
+}
+
+template<typename T, typename Convert>
+QList<T> KConfigGroupPrivate::readList(const KConfigGroup &group, const char *key, const QList<T> &aDefault, Convert convert)
+{
+    Q_ASSERT_X(group.isValid(), "KConfigGroup::readEntry", "accessing an invalid group");
+
+    bool expand = false;
+    const QByteArrayView data = group.config()->d_func()->lookupValue(group.d->fullName(), key, KEntryMap::SearchLocalized, &expand, &group.d->mHint);
+    if (data.isNull()) {
+        return aDefault;
+    }
+
+    QList<T> list;
+    const auto append = [&list, &convert](QByteArrayView element) {
+        list.append(convert(element));
+    };
+    if (expand) {
+        const QByteArray expanded = group.config()->d_func()->expandCached(QString::fromUtf8(data)).toUtf8();
+        if (expanded == QByteArrayView("\\0")) {
+            append(QByteArrayView());
+        } else if (!expanded.isEmpty()) {
+            splitList<char>(QByteArrayView(expanded), append);
+        }
+    } else if (data == QByteArrayView("\\0")) {
+        append(QByteArrayView());
+    } else if (!data.isEmpty()) {
+        list.reserve(data.count(',') + 1);
+        splitList<char>(data, append);
+    }
+    return list;
+}
+
+template<typename T, typename Format>
+void KConfigGroupPrivate::writeList(KConfigGroup &group, const char *key, const QList<T> &list, KConfigBase::WriteConfigFlags flags, Format format)
+{
+    Q_ASSERT_X(group.isValid(), "KConfigGroup::writeEntry", "accessing an invalid group");
+    Q_ASSERT_X(!group.d->bConst, "KConfigGroup::writeEntry", "writing to a read-only group");
+
+    QList<QByteArray> data;
+    data.reserve(list.size());
+    for (const T &value : list) {
+        data.append(format(value));
+    }
+    group.writeEntry(key, serializeList(data), flags);
+}
+
 static QVector<int> asIntList(const QByteArray &string)
 {
     const auto &splitString = string.split(',');
@@ -226,6 +381,8 @@ static QString formatError(int expected, int got)
 
 QVariant KConfigGroup::convertToQVariant(const char *pKey, const QByteArray &value, const QVariant &aDefault)
 {
+    KConfigTrace::count(KConfigTrace::Conversions);
+
     // if a type handler is added here you must add a QVConversions definition
     // to kconfigconversioncheck_p.h, or KConfigConversionCheck::to_QVariant will not allow
     // readEntry<T> to convert to QVariant.
@@ -241,7 +398,7 @@ QVariant KConfigGroup::convertToQVariant(const char *pKey, const QByteArray &val
         return QUuid::fromString(QString::fromUtf8(value));
     case QMetaType::QVariantList:
     case QMetaType::QStringList:
-        return KConfigGroupPrivate::deserializeList(QString::fromUtf8(value));
+        return KConfigGroupPrivate::deserializeList(QByteArrayView(value));
     case QMetaType::QByteArray:
         return value;
     case QMetaType::Bool: {
@@ -389,7 +546,20 @@ QVariant KConfigGroup::convertToQVariant(const char *pKey, const QByteArray &val
     return QVariant();
 }
 
-static bool cleanHomeDirPath(QString &path, const QString &homeDir)
+// The home directory as expandString() will put it back, to keep data intact.
+// Like the other environment variables of KConfig, it is read once.
+static const QString &homeDirPath()
+{
+#ifdef Q_OS_WIN
+    static const QString homeDir = QDir::homePath();
+#else
+    static const QString homeDir = QFile::decodeName(qgetenv("HOME"));
+#endif
+    return homeDir;
+}
+
+// Whether @p path is the home directory or a file in it
+static bool isInHomeDir(const QString &path, const QString &homeDir)
 {
 #ifdef Q_OS_WIN // safer
     if (!QDir::toNativeSeparators(path).startsWith(QDir::toNativeSeparators(homeDir))) {
@@ -401,38 +571,44 @@ static bool cleanHomeDirPath(QString &path, const QString &homeDir)
     }
 #endif
 
-    int len = homeDir.length();
+    const qsizetype len = homeDir.length();
+    return len && (path.length() == len || path[len] == QLatin1Char('/'));
+}
+
+static bool cleanHomeDirPath(QString &path, const QString &homeDir)
+{
     // replace by "$HOME" if possible
-    if (len && (path.length() == len || path[len] == QLatin1Char('/'))) {
-        path.replace(0, len, QStringLiteral("$HOME"));
+    if (isInHomeDir(path, homeDir)) {
+        path.replace(0, homeDir.length(), QStringLiteral("$HOME"));
         return true;
     }
 
     return false;
 }
 
-static QString translatePath(QString path) // krazy:exclude=passbyvalue
+static QString translatePath(const QString &value)
 {
-    if (path.isEmpty()) {
-        return path;
+    if (value.isEmpty()) {
+        return value;
+    }
+
+    const QString &homeDir = homeDirPath();
+    const bool startsWithFile = value.startsWith(QLatin1String("file:"), Qt::CaseInsensitive);
+    // most paths need nothing done, they are returned without a copy
+    if (!startsWithFile && !value.contains(QLatin1Char('$')) && !isInHomeDir(value, homeDir)) {
+        return value;
     }
 
     // only "our" $HOME should be interpreted
+    QString path = value;
     path.replace(QLatin1Char('$'), QLatin1String("$$"));
 
-    const bool startsWithFile = path.startsWith(QLatin1String("file:"), Qt::CaseInsensitive);
     path = startsWithFile ? QUrl(path).toLocalFile() : path;
 
     if (QDir::isRelativePath(path)) {
         return path;
     }
 
-    // Use the same thing as what expandString() will do, to keep data intact
-#ifdef Q_OS_WIN
-    const QString homeDir = QDir::homePath();
-#else
-    const QString homeDir = QFile::decodeName(qgetenv("HOME"));
-#endif
     (void)cleanHomeDirPath(path, homeDir);
 
     if (startsWithFile) {
@@ -631,7 +807,7 @@ QString KConfigGroup::readEntryUntranslated(const char *key, const QString &aDef
 {
     Q_ASSERT_X(isValid(), "KConfigGroup::readEntryUntranslated", "accessing an invalid group");
 
-    QString result = config()->d_func()->lookupData(d->fullName(), key, KEntryMap::SearchFlags(), nullptr);
+    QString result = config()->d_func()->lookupData(d->fullName(), key, KEntryMap::SearchFlags(), nullptr, &d->mHint);
     if (result.isNull()) {
         return aDefault;
     }
@@ -655,13 +831,13 @@ QString KConfigGroup::readEntry(const char *key, const QString &aDefault) const
     bool expand = false;
 
     // read value from the entry map
-    QString aValue = config()->d_func()->lookupData(d->fullName(), key, KEntryMap::SearchLocalized, &expand);
+    QString aValue = config()->d_func()->lookupData(d->fullName(), key, KEntryMap::SearchLocalized, &expand, &d->mHint);
     if (aValue.isNull()) {
         aValue = aDefault;
     }
 
     if (expand) {
-        return KConfigPrivate::expandString(aValue);
+        return config()->d_func()->expandCached(aValue);
     }
 
     return aValue;
@@ -676,12 +852,11 @@ QStringList KConfigGroup::readEntry(const char *key, const QStringList &aDefault
 {
     Q_ASSERT_X(isValid(), "KConfigGroup::readEntry", "accessing an invalid group");
 
-    const QString data = readEntry(key, QString());
-    if (data.isNull()) {
+    QStringList value;
+    if (!KConfigGroupPrivate::readList(*this, key, &value)) {
         return aDefault;
     }
-
-    return KConfigGroupPrivate::deserializeList(data);
+    return value;
 }
 
 QStringList KConfigGroup::readEntry(const QString &key, const QStringList &aDefault) const
@@ -711,16 +886,199 @@ QVariant KConfigGroup::readEntry(const QString &key, const QVariant &aDefault) c
     return readEntry(key.toUtf8().constData(), aDefault);
 }
 
-QVariantList KConfigGroup::readEntry(const char *key, const QVariantList &aDefault) const
+bool KConfigGroup::readEntryIfPresent(const char *key, const QVariant &aDefault, QVariant *value) const
 {
-    Q_ASSERT_X(isValid(), "KConfigGroup::readEntry", "accessing an invalid group");
+    Q_ASSERT_X(isValid(), "KConfigGroup::tryReadEntry", "accessing an invalid group");
 
-    const QString data = readEntry(key, QString());
+    const QByteArrayView data = entryValue(key);
+    if (data.isNull()) {
+        return false;
+    }
+    // as readEntry(), converting what the GUI module handles there
+    const QByteArray bytes = data.toByteArray();
+    if (!readEntryGui(bytes, key, aDefault, *value)) {
+        *value = convertToQVariant(key, bytes, aDefault);
+    }
+    return true;
+}
+
+template<>
+std::optional<QString> KConfigGroup::tryReadEntry(const char *key) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::tryReadEntry", "accessing an invalid group");
+
+    bool expand = false;
+    const QByteArrayView data = config()->d_func()->lookupValue(d->fullName(), key, KEntryMap::SearchLocalized, &expand, &d->mHint);
     if (data.isNull()) {
+        return std::nullopt;
+    }
+    const QString value = QString::fromUtf8(data);
+    if (expand) {
+        return config()->d_func()->expandCached(value);
+    }
+    return value;
+}
+
+template<>
+std::optional<QStringList> KConfigGroup::tryReadEntry(const char *key) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::tryReadEntry", "accessing an invalid group");
+
+    QStringList value;
+    if (!KConfigGroupPrivate::readList(*this, key, &value)) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+const QVariant *KConfigGroup::cachedEntry(const char *key, const QVariant &aDefault) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::readCachedEntry", "accessing an invalid group");
+
+    const auto &values = config()->d_func()->convertedValues;
+    // no copy of the key for the lookup
+    const auto it = values.constFind({d->fullName(), QByteArray::fromRawData(key, qstrlen(key)), aDefault.userType()});
+    if (it == values.cend() || it->defaultValue != aDefault) {
+        return nullptr;
+    }
+    return &it->value;
+}
+
+void KConfigGroup::cacheEntry(const char *key, const QVariant &aDefault, const QVariant &value) const
+{
+    config()->d_func()->convertedValues.insert({d->fullName(), QByteArray(key), aDefault.userType()}, {aDefault, value});
+}
+
+QByteArrayView KConfigGroup::entryValue(const char *key) const
+{
+    return config()->d_func()->lookupValue(d->fullName(), key, KEntryMap::SearchLocalized, nullptr, &d->mHint);
+}
+
+QByteArrayView KConfigGroup::readEntryRaw(const QString &key) const
+{
+    return readEntryRaw(key.toUtf8().constData());
+}
+
+QByteArrayView KConfigGroup::readEntryRaw(const char *key) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::readEntryRaw", "accessing an invalid group");
+
+    return entryValue(key);
+}
+
+bool KConfigGroup::readBoolEntry(const QString &key, bool aDefault) const
+{
+    return readBoolEntry(key.toUtf8().constData(), aDefault);
+}
+
+bool KConfigGroup::readBoolEntry(const char *key, bool aDefault) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::readBoolEntry", "accessing an invalid group");
+    KConfigTrace::count(KConfigTrace::Conversions);
+
+    const QByteArrayView value = entryValue(key);
+    if (value.isNull()) {
+        return aDefault;
+    }
+    return KConfigGroupValues::toBool(value);
+}
+
+int KConfigGroup::readIntEntry(const QString &key, int aDefault) const
+{
+    return readIntEntry(key.toUtf8().constData(), aDefault);
+}
+
+int KConfigGroup::readIntEntry(const char *key, int aDefault) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::readIntEntry", "accessing an invalid group");
+    KConfigTrace::count(KConfigTrace::Conversions);
+
+    bool ok = false;
+    const int value = entryValue(key).toInt(&ok);
+    return ok ? value : aDefault;
+}
+
+qint64 KConfigGroup::readInt64Entry(const QString &key, qint64 aDefault) const
+{
+    return readInt64Entry(key.toUtf8().constData(), aDefault);
+}
+
+qint64 KConfigGroup::readInt64Entry(const char *key, qint64 aDefault) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::readInt64Entry", "accessing an invalid group");
+    KConfigTrace::count(KConfigTrace::Conversions);
+
+    bool ok = false;
+    const qint64 value = entryValue(key).toLongLong(&ok);
+    return ok ? value : aDefault;
+}
+
+double KConfigGroup::readDoubleEntry(const QString &key, double aDefault) const
+{
+    return readDoubleEntry(key.toUtf8().constData(), aDefault);
+}
+
+double KConfigGroup::readDoubleEntry(const char *key, double aDefault) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::readDoubleEntry", "accessing an invalid group");
+    KConfigTrace::count(KConfigTrace::Conversions);
+
+    bool ok = false;
+    const double value = entryValue(key).toDouble(&ok);
+    return ok ? value : aDefault;
+}
+
+// The value of the key @p name of @p metaEnum
+static std::optional<int> enumValue(const QMetaEnum &metaEnum, QByteArrayView name)
+{
+    name = name.trimmed();
+    for (int i = 0, count = metaEnum.keyCount(); i < count; ++i) {
+        if (name == QByteArrayView(metaEnum.key(i))) {
+            return metaEnum.value(i);
+        }
+    }
+    return std::nullopt;
+}
+
+int KConfigGroup::readEnumEntry(const QString &key, const QMetaEnum &metaEnum, int aDefault) const
+{
+    return readEnumEntry(key.toUtf8().constData(), metaEnum, aDefault);
+}
+
+int KConfigGroup::readEnumEntry(const char *key, const QMetaEnum &metaEnum, int aDefault) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::readEnumEntry", "accessing an invalid group");
+
+    QByteArrayView value = entryValue(key);
+    if (value.isNull()) {
         return aDefault;
     }
+    if (!metaEnum.isFlag()) {
+        return enumValue(metaEnum, value).value_or(aDefault);
+    }
+
+    // written by QMetaEnum::valueToKeys()
+    int result = 0;
+    while (!value.isEmpty()) {
+        const qsizetype separator = value.indexOf('|');
+        const std::optional<int> flag = enumValue(metaEnum, value.first(separator == -1 ? value.size() : separator));
+        if (!flag) {
+            return aDefault;
+        }
+        result |= *flag;
+        value = separator == -1 ? QByteArrayView() : value.sliced(separator + 1);
+    }
+    return result;
+}
+
+QVariantList KConfigGroup::readEntry(const char *key, const QVariantList &aDefault) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::readEntry", "accessing an invalid group");
 
-    const auto &list = KConfigGroupPrivate::deserializeList(data);
+    QStringList list;
+    if (!KConfigGroupPrivate::readList(*this, key, &list)) {
+        return aDefault;
+    }
 
     QVariantList value;
     value.reserve(list.count());
@@ -787,12 +1145,12 @@ QString KConfigGroup::readPathEntry(const char *key, const QString &aDefault) co
 
     bool expand = false;
 
-    QString aValue = config()->d_func()->lookupData(d->fullName(), key, KEntryMap::SearchLocalized, &expand);
+    QString aValue = config()->d_func()->lookupData(d->fullName(), key, KEntryMap::SearchLocalized, &expand, &d->mHint);
     if (aValue.isNull()) {
         aValue = aDefault;
     }
 
-    return KConfigPrivate::expandString(aValue);
+    return config()->d_func()->expandCached(aValue);
 }
 
 QStringList KConfigGroup::readPathEntry(const QString &pKey, const QStringList &aDefault) const
@@ -890,6 +1248,123 @@ void KConfigGroup::writeEntry(const char *key, const QVariantList &list, WriteCo
     writeEntry(key, KConfigGroupPrivate::serializeList(data), flags);
 }
 
+// The text of a number, or of the numbers of a point, size, rect or date written as a list,
+// formatted into a buffer on the stack instead of going through a QVariantList of QStrings
+class NumberListFormatter
+{
+public:
+    template<typename Integer>
+    NumberListFormatter &operator<<(Integer value)
+    {
+        separate();
+        m_end = std::to_chars(m_end, m_buffer + sizeof(m_buffer), value).ptr;
+        return *this;
+    }
+    NumberListFormatter &operator<<(double value)
+    {
+        separate();
+        // the same text as QVariant::toString(), which std::to_chars doesn't always give
+        const QByteArray text = QByteArray::number(value, 'g', QLocale::FloatingPointShortest);
+        m_end = std::copy_n(text.constData(), std::min<qsizetype>(text.size(), m_buffer + sizeof(m_buffer) - m_end), m_end);
+        return *this;
+    }
+    QByteArray toByteArray() const
+    {
+        return QByteArray(m_buffer, m_end - m_buffer);
+    }
+
+private:
+    void separate()
+    {
+        if (m_end != m_buffer) {
+            *m_end++ = ',';
+        }
+    }
+
+    // six numbers of at most 24 characters each, and the commas between them
+    char m_buffer[6 * 25];
+    char *m_end = m_buffer;
+};
+
+// The number lists have nothing to escape, their text is formatted in place
+template<typename Number>
+static QByteArray numberList(const QList<Number> &list)
+{
+    QByteArray data;
+    data.reserve(list.size() * 8);
+    for (const Number value : list) {
+        if (!data.isEmpty()) {
+            data += ',';
+        }
+        if constexpr (std::is_floating_point_v<Number>) {
+            // the same text as QVariant::toString()
+            data += QByteArray::number(value, 'g', QLocale::FloatingPointShortest);
+        } else {
+            char buffer[24];
+            data.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr - buffer);
+        }
+    }
+    return data;
+}
+
+template<>
+QList<int> KConfigGroup::readEntry(const char *key, const QList<int> &defaultValue) const
+{
+    return KConfigGroupPrivate::readList(*this, key, defaultValue, [](QByteArrayView element) {
+        return element.toInt();
+    });
+}
+
+template<>
+QList<qint64> KConfigGroup::readEntry(const char *key, const QList<qint64> &defaultValue) const
+{
+    return KConfigGroupPrivate::readList(*this, key, defaultValue, [](QByteArrayView element) {
+        return element.toLongLong();
+    });
+}
+
+template<>
+QList<double> KConfigGroup::readEntry(const char *key, const QList<double> &defaultValue) const
+{
+    return KConfigGroupPrivate::readList(*this, key, defaultValue, [](QByteArrayView element) {
+        return element.toDouble();
+    });
+}
+
+template<>
+QList<QUrl> KConfigGroup::readEntry(const char *key, const QList<QUrl> &defaultValue) const
+{
+    return KConfigGroupPrivate::readList(*this, key, defaultValue, [](QByteArrayView element) {
+        return QUrl(QString::fromUtf8(element));
+    });
+}
+
+template<>
+void KConfigGroup::writeEntry(const char *key, const QList<int> &list, WriteConfigFlags flags)
+{
+    writeEntry(key, numberList(list), flags);
+}
+
+template<>
+void KConfigGroup::writeEntry(const char *key, const QList<qint64> &list, WriteConfigFlags flags)
+{
+    writeEntry(key, numberList(list), flags);
+}
+
+template<>
+void KConfigGroup::writeEntry(const char *key, const QList<double> &list, WriteConfigFlags flags)
+{
+    writeEntry(key, numberList(list), flags);
+}
+
+template<>
+void KConfigGroup::writeEntry(const char *key, const QList<QUrl> &list, WriteConfigFlags flags)
+{
+    KConfigGroupPrivate::writeList(*this, key, list, flags, [](const QUrl &url) {
+        return url.toString().toUtf8();
+    });
+}
+
 void KConfigGroup::writeEntry(const char *key, const QVariant &value, WriteConfigFlags flags)
 {
     Q_ASSERT_X(isValid(), "KConfigGroup::writeEntry", "accessing an invalid group");
@@ -910,14 +1385,26 @@ void KConfigGroup::writeEntry(const char *key, const QVariant &value, WriteConfi
     case QMetaType::QByteArray:
         data = value.toByteArray();
         break;
-    case QMetaType::QString:
     case QMetaType::Int:
+        data = (NumberListFormatter() << value.toInt()).toByteArray();
+        break;
     case QMetaType::UInt:
-    case QMetaType::Double:
-    case QMetaType::Float:
-    case QMetaType::Bool:
+        data = (NumberListFormatter() << value.toUInt()).toByteArray();
+        break;
     case QMetaType::LongLong:
+        data = (NumberListFormatter() << value.toLongLong()).toByteArray();
+        break;
     case QMetaType::ULongLong:
+        data = (NumberListFormatter() << value.toULongLong()).toByteArray();
+        break;
+    case QMetaType::Double:
+        data = (NumberListFormatter() << value.toDouble()).toByteArray();
+        break;
+    case QMetaType::Bool:
+        data = value.toBool() ? QByteArrayLiteral("true") : QByteArrayLiteral("false");
+        break;
+    case QMetaType::QString:
+    case QMetaType::Float:
         data = value.toString().toUtf8();
         break;
     case QMetaType::QVariantList:
@@ -932,43 +1419,28 @@ void KConfigGroup::writeEntry(const char *key, const QVariant &value, WriteConfi
         return;
     case QMetaType::QPoint: {
         const QPoint rPoint = value.toPoint();
-
-        const QVariantList list{rPoint.x(), rPoint.y()};
-
-        writeEntry(key, list, flags);
-        return;
+        data = (NumberListFormatter() << rPoint.x() << rPoint.y()).toByteArray();
+        break;
     }
     case QMetaType::QPointF: {
         const QPointF point = value.toPointF();
-
-        const QVariantList list{point.x(), point.y()};
-
-        writeEntry(key, list, flags);
-        return;
+        data = (NumberListFormatter() << point.x() << point.y()).toByteArray();
+        break;
     }
     case QMetaType::QRect: {
         const QRect rRect = value.toRect();
-
-        const QVariantList list{rRect.left(), rRect.top(), rRect.width(), rRect.height()};
-
-        writeEntry(key, list, flags);
-        return;
+        data = (NumberListFormatter() << rRect.left() << rRect.top() << rRect.width() << rRect.height()).toByteArray();
+        break;
     }
     case QMetaType::QRectF: {
         const QRectF rRectF = value.toRectF();
-
-        const QVariantList list{rRectF.left(), rRectF.top(), rRectF.width(), rRectF.height()};
-
-        writeEntry(key, list, flags);
-        return;
+        data = (NumberListFormatter() << rRectF.left() << rRectF.top() << rRectF.width() << rRectF.height()).toByteArray();
+        break;
     }
     case QMetaType::QSize: {
         const QSize rSize = value.toSize();
-
-        const QVariantList list{rSize.width(), rSize.height()};
-
-        writeEntry(key, list, flags);
-        return;
+        data = (NumberListFormatter() << rSize.width() << rSize.height()).toByteArray();
+        break;
     }
     case QMetaType::QUuid: {
         writeEntry(key, value.toString(), flags);
@@ -976,19 +1448,13 @@ void KConfigGroup::writeEntry(const char *key, const QVariant &value, WriteConfi
     }
     case QMetaType::QSizeF: {
         const QSizeF rSizeF = value.toSizeF();
-
-        const QVariantList list{rSizeF.width(), rSizeF.height()};
-
-        writeEntry(key, list, flags);
-        return;
+        data = (NumberListFormatter() << rSizeF.width() << rSizeF.height()).toByteArray();
+        break;
     }
     case QMetaType::QDate: {
         const QDate date = value.toDate();
-
-        const QVariantList list{date.year(), date.month(), date.day()};
-
-        writeEntry(key, list, flags);
-        return;
+        data = (NumberListFormatter() << date.year() << date.month() << date.day()).toByteArray();
+        break;
     }
     case QMetaType::QDateTime: {
         const QDateTime rDateTime = value.toDateTime();
@@ -996,18 +1462,10 @@ void KConfigGroup::writeEntry(const char *key, const QVariant &value, WriteConfi
         const QTime time = rDateTime.time();
         const QDate date = rDateTime.date();
 
-        const QVariantList list{
-            date.year(),
-            date.month(),
-            date.day(),
-
-            time.hour(),
-            time.minute(),
-            time.second() + time.msec() / 1000.0,
-        };
-
-        writeEntry(key, list, flags);
-        return;
+        data = (NumberListFormatter() << date.year() << date.month() << date.day() << time.hour() << time.minute()
+                                      << time.second() + time.msec() / 1000.0)
+                   .toByteArray();
+        break;
     }
 
     case QMetaType::QColor:
@@ -1104,6 +1562,203 @@ void KConfigGroup::deleteEntry(const QString &key, WriteConfigFlags flags)
     deleteEntry(key.toUtf8().constData(), flags);
 }
 
+class KConfigGroupBatchPrivate
+{
+public:
+    KConfigGroup group; // keeps the config alive
+    KConfigPrivate *config;
+    QByteArray fullName;
+    std::vector<KEntryMap::EntryWrite> writes;
+
+    void write(const char *key, const QByteArray &value, KConfigBase::WriteConfigFlags flags)
+    {
+        writes.push_back({QByteArray(key), value, config->writeOptions(value, flags)});
+    }
+};
+
+KConfigGroupBatch KConfigGroup::beginBatch()
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::beginBatch", "accessing an invalid group");
+    Q_ASSERT_X(!d->bConst, "KConfigGroup::beginBatch", "writing to a read-only group");
+
+    return KConfigGroupBatch(new KConfigGroupBatchPrivate{*this, config()->d_func(), d->fullName(), {}});
+}
+
+KConfigGroupBatch::KConfigGroupBatch(KConfigGroupBatchPrivate *dd)
+    : d(dd)
+{
+}
+
+KConfigGroupBatch::KConfigGroupBatch(KConfigGroupBatch &&other) noexcept = default;
+KConfigGroupBatch &KConfigGroupBatch::operator=(KConfigGroupBatch &&other) noexcept = default;
+
+KConfigGroupBatch::~KConfigGroupBatch()
+{
+    if (d) {
+        apply();
+    }
+}
+
+void KConfigGroupBatch::writeEntry(const QString &key, const QString &value, KConfigBase::WriteConfigFlags flags)
+{
+    writeEntry(key.toUtf8().constData(), value, flags);
+}
+
+void KConfigGroupBatch::writeEntry(const char *key, const QString &value, KConfigBase::WriteConfigFlags flags)
+{
+    writeEntry(key, value.toUtf8(), flags);
+}
+
+void KConfigGroupBatch::writeEntry(const char *key, const QByteArray &value, KConfigBase::WriteConfigFlags flags)
+{
+    d->write(key, value.isNull() ? QByteArray("") : value, flags);
+}
+
+void KConfigGroupBatch::writeEntry(const char *key, const QStringList &value, KConfigBase::WriteConfigFlags flags)
+{
+    QList<QByteArray> balist;
+    balist.reserve(value.count());
+
+    for (const QString &entry : value) {
+        balist.append(entry.toUtf8());
+    }
+
+    writeEntry(key, KConfigGroupPrivate::serializeList(balist), flags);
+}
+
+void KConfigGroupBatch::writeEntry(const char *key, const char *value, KConfigBase::WriteConfigFlags flags)
+{
+    writeEntry(key, QString::fromLatin1(value), flags);
+}
+
+void KConfigGroupBatch::deleteEntry(const QString &key, KConfigBase::WriteConfigFlags flags)
+{
+    deleteEntry(key.toUtf8().constData(), flags);
+}
+
+void KConfigGroupBatch::deleteEntry(const char *key, KConfigBase::WriteConfigFlags flags)
+{
+    d->write(key, QByteArray(), flags);
+}
+
+void KConfigGroupBatch::apply()
+{
+    if (!d->writes.empty()) {
+        d->config->putData(d->fullName, std::exchange(d->writes, {}));
+    }
+}
+
+class KConfigKeyPrivate
+{
+public:
+    KConfigGroup group; // keeps the config alive
+    const KConfigPrivate *config;
+    QByteArray fullName;
+    QByteArray key;
+    KConfigPrivate::EntrySlot slot;
+
+    QByteArrayView value(bool *expand = nullptr)
+    {
+        return config->lookupSlot(fullName, key.constData(), &slot, expand);
+    }
+};
+
+KConfigKey KConfigGroup::configKey(const QString &key) const
+{
+    return configKey(key.toUtf8().constData());
+}
+
+KConfigKey KConfigGroup::configKey(const char *key) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::configKey", "accessing an invalid group");
+
+    return KConfigKey(new KConfigKeyPrivate{*this, config()->d_func(), d->fullName(), QByteArray(key), {}});
+}
+
+KConfigKey::KConfigKey() = default;
+
+KConfigKey::KConfigKey(KConfigKeyPrivate *dd)
+    : d(dd)
+{
+}
+
+KConfigKey::KConfigKey(const KConfigKey &other)
+    : d(other.d ? new KConfigKeyPrivate(*other.d) : nullptr)
+{
+}
+
+KConfigKey &KConfigKey::operator=(const KConfigKey &other)
+{
+    if (this != &other) {
+        d.reset(other.d ? new KConfigKeyPrivate(*other.d) : nullptr);
+    }
+    return *this;
+}
+
+KConfigKey::KConfigKey(KConfigKey &&other) noexcept = default;
+KConfigKey &KConfigKey::operator=(KConfigKey &&other) noexcept = default;
+
+KConfigKey::~KConfigKey() = default;
+
+bool KConfigKey::isNull() const
+{
+    return !d;
+}
+
+KConfigGroup KConfigKey::group() const
+{
+    return d ? d->group : KConfigGroup();
+}
+
+QByteArray KConfigKey::key() const
+{
+    return d ? d->key : QByteArray();
+}
+
+bool KConfigKey::exists() const
+{
+    return d && !d->value().isNull();
+}
+
+QByteArrayView KConfigKey::readEntryRaw() const
+{
+    return d ? d->value() : QByteArrayView();
+}
+
+QString KConfigKey::readEntry(const QString &aDefault) const
+{
+    if (!d) {
+        return aDefault;
+    }
+    bool expand = false;
+    const QByteArrayView value = d->value(&expand);
+    if (value.isNull()) {
+        return aDefault;
+    }
+    if (expand) {
+        return d->config->expandCached(QString::fromUtf8(value));
+    }
+    return QString::fromUtf8(value);
+}
+
+bool KConfigKey::readBoolEntry(bool aDefault) const
+{
+    KConfigTrace::count(KConfigTrace::Conversions);
+    const QByteArrayView value = readEntryRaw();
+    if (value.isNull()) {
+        return aDefault;
+    }
+    return KConfigGroupValues::toBool(value);
+}
+
+int KConfigKey::readIntEntry(int aDefault) const
+{
+    KConfigTrace::count(KConfigTrace::Conversions);
+    bool ok = false;
+    const int value = readEntryRaw().toInt(&ok);
+    return ok ? value : aDefault;
+}
+
 void KConfigGroup::revertToDefault(const char *key)
 {
     revertToDefault(key, WriteConfigFlags());
@@ -1172,6 +1827,29 @@ QStringList KConfigGroup::groupList() const
     return config()->d_func()->groupList(d->fullName());
 }
 
+void KConfigGroup::forEachEntryImpl(void (*visit)(void *visitor, QByteArrayView key, QByteArrayView value, EntryFlags flags), void *visitor) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::forEachEntry", "accessing an invalid group");
+
+    config()->d_func()->forEachEntry(d->fullName(), [visit, visitor](const KEntryKey &key, const KEntry &entry) {
+        EntryFlags flags;
+        flags.setFlag(EntryImmutable, entry.bImmutable);
+        flags.setFlag(EntryExpandable, entry.bExpand);
+        flags.setFlag(EntryGlobal, entry.bGlobal);
+        flags.setFlag(EntryLocalized, key.bLocal);
+        visit(visitor, key.mKey, entry.value(), flags);
+    });
+}
+
+void KConfigGroup::forEachSubGroupImpl(void (*visit)(void *visitor, QByteArrayView name), void *visitor) const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::forEachSubGroup", "accessing an invalid group");
+
+    config()->d_func()->forEachSubGroup(d->fullName(), [visit, visitor](QByteArrayView name) {
+        visit(visitor, name);
+    });
+}
+
 QStringList KConfigGroup::keyList() const
 {
     Q_ASSERT_X(isValid(), "KConfigGroup::keyList", "accessing an invalid group");
@@ -1179,6 +1857,14 @@ QStringList KConfigGroup::keyList() const
     return entryMap().keys();
 }
 
+KConfigGroupSnapshot KConfigGroup::snapshot() const
+{
+    Q_ASSERT_X(isValid(), "KConfigGroup::snapshot", "accessing an invalid group");
+
+    const QByteArray group = d->fullName();
+    return KConfigGroupSnapshot(config()->d_func()->groupSnapshot(group), group);
+}
+
 void KConfigGroup::markAsClean()
 {
     Q_ASSERT_X(isValid(), "KConfigGroup::markAsClean", "accessing an invalid group");
@@ -1258,7 +1944,7 @@ void KConfigGroup::moveValuesTo(const QList<const char *> &keys, KConfigGroup &o
         const auto entry = config()->d_ptr->lookupInternalEntry(groupName, key, KEntryMap::SearchLocalized);
 
         // Only write the entry if it is not null, if it is a global enry there is no point in moving it
-        if (!entry.mValue.isNull() && !entry.bGlobal) {
+        if (!entry.isNull() && !entry.bGlobal) {
             deleteEntry(key, pFlags);
             KEntryMap::EntryOptions options = KEntryMap::EntryOption::EntryDirty;
             if (entry.bDeleted) {
@@ -1268,8 +1954,11 @@ void KConfigGroup::moveValuesTo(const QList<const char *> &keys, KConfigGroup &o
             if (entry.bExpand) {
                 options |= KEntryMap::EntryExpansion;
             }
+            if (entry.bBinary) {
+                options |= KEntryMap::EntryBinary;
+            }
 
-            other.config()->d_ptr->setEntryData(other.name().toLocal8Bit(), key, entry.mValue, options);
+            other.config()->d_ptr->setEntryData(other.name().toLocal8Bit(), key, entry.toByteArray(), options);
         }
     }
 }
@@ -15,13 +15,24 @@
 
 #include <kconfigcore_export.h>
 
+#include <QByteArrayView>
 #include <QExplicitlySharedDataPointer>
 #include <QStringList>
 #include <QVariant>
 
+#include <memory>
+#include <optional>
+
 class KConfig;
+class KConfigGroupBatch;
+class KConfigGroupBatchPrivate;
 class KConfigGroupPrivate;
+class KConfigGroupSnapshot;
+class KConfigKey;
+class KConfigKeyPrivate;
 class KSharedConfig;
+class QMetaEnum;
+class QUrl;
 
 /**
  * \class KConfigGroup kconfiggroup.h <KConfigGroup>
@@ -198,6 +209,20 @@ public:
      */
     QStringList keyList() const;
 
+    /**
+     * Returns an immutable copy of the entries of this group, without those
+     * of its subgroups.
+     *
+     * The entries are shared with the config until one of them is changed, so
+     * this is cheap even for large groups. Reading many keys from the snapshot
+     * only looks them up in the group, and the snapshot may be passed to other
+     * threads.
+     *
+     * @see KConfigGroupSnapshot
+     * @since 6.1
+     */
+    KConfigGroupSnapshot snapshot() const;
+
     /**
      * Delete all entries in the entire group
      *
@@ -336,6 +361,165 @@ public:
     template<typename T>
     QList<T> readEntry(const char *key, const QList<T> &aDefault) const;
 
+    /**
+     * Reads the value of an entry if there is one, like readEntry() does.
+     * Unlike hasKey() followed by readEntry(), this looks the entry up once.
+     *
+     * @code
+     * if (const std::optional<int> size = group.tryReadEntry<int>("Size")) {
+     *     resize(*size);
+     * }
+     * @endcode
+     *
+     * @param key the key to search for
+     * @return the value converted to @c T, a default constructed @c T if it
+     *         can't be converted, or no value if the key was not found
+     *
+     * @see hasKey()
+     * @since 6.1
+     */
+    template<typename T>
+    std::optional<T> tryReadEntry(const QString &key) const
+    {
+        return tryReadEntry<T>(key.toUtf8().constData());
+    }
+    /**
+     * Overload for tryReadEntry<T>(const QString&) const
+     * @param key name of key, encoded in UTF-8
+     * @since 6.1
+     */
+    template<typename T>
+    std::optional<T> tryReadEntry(const char *key) const;
+
+    /**
+     * Reads the value of an entry like readEntry() does, and keeps the
+     * converted value for the next read of @p key with the same type and
+     * the same @p aDefault.
+     *
+     * Meant for settings that are read over and over, e.g. on every paint.
+     * The kept values are dropped whenever an entry of the config changes,
+     * and by KConfig::reparseConfiguration().
+     *
+     * @since 6.1
+     */
+    template<typename T>
+    T readCachedEntry(const QString &key, const T &aDefault) const
+    {
+        return readCachedEntry(key.toUtf8().constData(), aDefault);
+    }
+    /**
+     * Overload for readCachedEntry<T>(const QString&, const T&) const
+     * @param key name of key, encoded in UTF-8
+     * @since 6.1
+     */
+    template<typename T>
+    T readCachedEntry(const char *key, const T &aDefault) const;
+
+    /**
+     * Reads the value of an entry as it is stored, UTF-8 encoded and without
+     * any conversion or copy.
+     *
+     * This is the cheapest way to compare a value against a constant. Unlike
+     * readEntry(), the value doesn't undergo dollar expansion when the entry
+     * is marked with [$e], and no QString is created.
+     *
+     * @warning The view is only valid until the entries of the config change:
+     * any write, revert, deletion or reparseConfiguration() invalidates it, as
+     * does destroying the config. Copy it with toByteArray() to keep it.
+     *
+     * @param key the key to search for
+     * @return the value of the entry, or a null view if there is none
+     *
+     * @see readCachedEntry() to keep a converted QString instead
+     * @since 6.1
+     */
+    QByteArrayView readEntryRaw(const QString &key) const;
+    /**
+     * Overload for readEntryRaw(const QString&) const
+     * @param key name of key, encoded in UTF-8
+     * @since 6.1
+     */
+    QByteArrayView readEntryRaw(const char *key) const;
+
+    /**
+     * Reads a boolean entry, like readEntry(key, aDefault) but without going
+     * through QVariant: the entry is parsed where it is stored.
+     *
+     * @param key the key to search for
+     * @param aDefault the value returned if the key was not found
+     * @return false if the value is "false", "no", "off" or "0" in any case,
+     *         true for any other value, or @p aDefault
+     *
+     * @since 6.1
+     */
+    bool readBoolEntry(const QString &key, bool aDefault) const;
+    /**
+     * Overload for readBoolEntry(const QString&, bool) const
+     * @param key name of key, encoded in UTF-8
+     * @since 6.1
+     */
+    bool readBoolEntry(const char *key, bool aDefault) const;
+
+    /**
+     * Reads an integer entry, like readEntry(key, aDefault) but without
+     * going through QVariant.
+     *
+     * @param key the key to search for
+     * @param aDefault the value returned if the key was not found or isn't a number
+     *
+     * @since 6.1
+     */
+    int readIntEntry(const QString &key, int aDefault) const;
+    /**
+     * Overload for readIntEntry(const QString&, int) const
+     * @param key name of key, encoded in UTF-8
+     * @since 6.1
+     */
+    int readIntEntry(const char *key, int aDefault) const;
+
+    /**
+     * Same as readIntEntry() for 64 bit integers.
+     * @since 6.1
+     */
+    qint64 readInt64Entry(const QString &key, qint64 aDefault) const;
+    /**
+     * Overload for readInt64Entry(const QString&, qint64) const
+     * @param key name of key, encoded in UTF-8
+     * @since 6.1
+     */
+    qint64 readInt64Entry(const char *key, qint64 aDefault) const;
+
+    /**
+     * Same as readIntEntry() for floating point numbers.
+     * @since 6.1
+     */
+    double readDoubleEntry(const QString &key, double aDefault) const;
+    /**
+     * Overload for readDoubleEntry(const QString&, double) const
+     * @param key name of key, encoded in UTF-8
+     * @since 6.1
+     */
+    double readDoubleEntry(const char *key, double aDefault) const;
+
+    /**
+     * Reads an entry holding the name of a value of @p metaEnum, as written
+     * by writeEntry() for enums declared with KCONFIGGROUP_DECLARE_ENUM_QOBJECT.
+     * For flags, the names are separated by '|'.
+     *
+     * @param key the key to search for
+     * @param metaEnum the enum the names belong to, e.g. QMetaEnum::fromType<MyEnum>()
+     * @param aDefault the value returned if the key was not found or holds an unknown name
+     *
+     * @since 6.1
+     */
+    int readEnumEntry(const QString &key, const QMetaEnum &metaEnum, int aDefault) const;
+    /**
+     * Overload for readEnumEntry(const QString&, const QMetaEnum&, int) const
+     * @param key name of key, encoded in UTF-8
+     * @since 6.1
+     */
+    int readEnumEntry(const char *key, const QMetaEnum &metaEnum, int aDefault) const;
+
     /**
      * Reads a list of strings from the config object, following XDG
      * desktop entry spec separator semantics
@@ -561,6 +745,32 @@ public:
      */
     void deleteEntry(const char *key, WriteConfigFlags pFlags = Normal);
 
+    /**
+     * Starts writing many entries of this group at once.
+     *
+     * This is faster than calling writeEntry() for every entry when writing
+     * hundreds of them, for example when importing settings.
+     *
+     * @see KConfigGroupBatch
+     * @since 6.1
+     */
+    KConfigGroupBatch beginBatch();
+
+    /**
+     * Returns a handle to the entry @p key of this group, for a setting that
+     * is read over and over.
+     *
+     * @see KConfigKey
+     * @since 6.1
+     */
+    KConfigKey configKey(const QString &key) const;
+    /**
+     * Overload for configKey(const QString&) const
+     * @param key name of key, encoded in UTF-8
+     * @since 6.1
+     */
+    KConfigKey configKey(const char *key) const;
+
     /**
      * Checks whether the key has an entry in this group
      *
@@ -683,6 +893,68 @@ public:
      */
     QMap<QString, QString> entryMap() const;
 
+    /**
+     * What forEachEntry() tells about an entry besides its value.
+     * @since 6.1
+     */
+    enum EntryFlag {
+        EntryImmutable = 0x1, ///< The entry can't be changed, it is marked with [$i]
+        EntryExpandable = 0x2, ///< The entry is marked with [$e], readEntry() expands its value
+        EntryGlobal = 0x4, ///< The entry is written to kdeglobals
+        EntryLocalized = 0x8, ///< The value is the one for the locale of the config
+    };
+    Q_DECLARE_FLAGS(EntryFlags, EntryFlag)
+
+    /**
+     * Calls @p callback with each entry of this group, in the order of the keys,
+     * as the entries entryMap() returns. This is the way to go over many entries
+     * without building a list or a map of them.
+     *
+     * The callback is called as @c callback(QByteArrayView key, QByteArrayView value, EntryFlags flags),
+     * with the key and the value as they are stored, UTF-8 encoded and without the
+     * dollar expansion of readEntry(). The views are only valid during the call;
+     * and the callback must not change the entries of the config.
+     *
+     * @code
+     * group.forEachEntry([&](QByteArrayView key, QByteArrayView value, KConfigGroup::EntryFlags) {
+     *     if (key.startsWith("plugin_")) {
+     *         plugins.append(QString::fromUtf8(value));
+     *     }
+     * });
+     * @endcode
+     *
+     * @since 6.1
+     */
+    template<typename Callback>
+    void forEachEntry(Callback &&callback) const
+    {
+        forEachEntryImpl(
+            [](void *visitor, QByteArrayView key, QByteArrayView value, EntryFlags flags) {
+                (*static_cast<std::remove_reference_t<Callback> *>(visitor))(key, value, flags);
+            },
+            const_cast<void *>(static_cast<const void *>(&callback)));
+    }
+
+    /**
+     * Calls @p callback with the name of each subgroup of this group that
+     * groupList() returns, as @c callback(QByteArrayView name), without building
+     * a list of them. The name is UTF-8 encoded and only valid during the call,
+     * and the callback must not change the groups of the config.
+     *
+     * The names come sorted, unless they contain characters sorting before '\\x1d'.
+     *
+     * @since 6.1
+     */
+    template<typename Callback>
+    void forEachSubGroup(Callback &&callback) const
+    {
+        forEachSubGroupImpl(
+            [](void *visitor, QByteArrayView name) {
+                (*static_cast<std::remove_reference_t<Callback> *>(visitor))(name);
+            },
+            const_cast<void *>(static_cast<const void *>(&callback)));
+    }
+
 protected:
     bool hasGroupImpl(const QByteArray &group) const override;
     KConfigGroup groupImpl(const QByteArray &b) override;
@@ -705,10 +977,195 @@ private:
      * @return @p value converted to QVariant, or @p aDefault if @p value is invalid or cannot be converted.
      */
     static QVariant convertToQVariant(const char *pKey, const QByteArray &value, const QVariant &aDefault);
+
+    // The value readCachedEntry() kept for @p key and @p aDefault, or null
+    const QVariant *cachedEntry(const char *key, const QVariant &aDefault) const;
+    void cacheEntry(const char *key, const QVariant &aDefault, const QVariant &value) const;
+    // The decoded value of @p key, valid until the entries change, null if there is none
+    QByteArrayView entryValue(const char *key) const;
+    // Sets @p value to the entry @p key converted to the type of @p aDefault, returns false if there is none
+    bool readEntryIfPresent(const char *key, const QVariant &aDefault, QVariant *value) const;
+    // forEachEntry() and forEachSubGroup() without a template, @p visit calls the callback at @p visitor
+    void forEachEntryImpl(void (*visit)(void *visitor, QByteArrayView key, QByteArrayView value, EntryFlags flags), void *visitor) const;
+    void forEachSubGroupImpl(void (*visit)(void *visitor, QByteArrayView name), void *visitor) const;
+
     friend class KServicePrivate; // XXX yeah, ugly^5
     friend class KServiceAction;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KConfigGroup::EntryFlags)
+
+/**
+ * \class KConfigGroupBatch kconfiggroup.h <KConfigGroup>
+ *
+ * Collects writes to a KConfigGroup and applies them all at once.
+ *
+ * Each KConfigGroup::writeEntry() looks up the group and inserts a new entry
+ * on its own. A batch sorts its writes by key and merges all the new entries
+ * into the group in a single pass, which makes writing thousands of entries
+ * much cheaper.
+ *
+ * The writes take effect when apply() is called or the batch is destroyed.
+ * Until then, reading the group still returns the previous values.
+ *
+ * @code
+ * KConfigGroup group = config->group(QStringLiteral("Imported"));
+ * KConfigGroupBatch batch = group.beginBatch();
+ * for (auto it = settings.cbegin(); it != settings.cend(); ++it) {
+ *     batch.writeEntry(it.key(), it.value());
+ * }
+ * batch.apply();
+ * @endcode
+ *
+ * @see KConfigGroup::beginBatch()
+ * @since 6.1
+ */
+class KCONFIGCORE_EXPORT KConfigGroupBatch
+{
+public:
+    KConfigGroupBatch(KConfigGroupBatch &&other) noexcept;
+    KConfigGroupBatch &operator=(KConfigGroupBatch &&other) noexcept;
+    /**
+     * Applies the writes that are still pending.
+     */
+    ~KConfigGroupBatch();
+
+    /**
+     * Writes @p value to @p key, like KConfigGroup::writeEntry().
+     * A later write to the same key replaces the value.
+     */
+    void writeEntry(const QString &key, const QString &value, KConfigBase::WriteConfigFlags flags = KConfigBase::Normal);
+    /**
+     * Overload for writeEntry(const QString&, const QString&, KConfigBase::WriteConfigFlags)
+     * @param key name of key, encoded in UTF-8
+     */
+    void writeEntry(const char *key, const QString &value, KConfigBase::WriteConfigFlags flags = KConfigBase::Normal);
+    /**
+     * Overload for writeEntry(const QString&, const QString&, KConfigBase::WriteConfigFlags)
+     * @param key name of key, encoded in UTF-8
+     * @param value the value, encoded in UTF-8
+     */
+    void writeEntry(const char *key, const QByteArray &value, KConfigBase::WriteConfigFlags flags = KConfigBase::Normal);
+    /**
+     * Overload for writeEntry(const QString&, const QString&, KConfigBase::WriteConfigFlags)
+     * @param key name of key, encoded in UTF-8
+     */
+    void writeEntry(const char *key, const QStringList &value, KConfigBase::WriteConfigFlags flags = KConfigBase::Normal);
+    /**
+     * Overload for writeEntry(const QString&, const QString&, KConfigBase::WriteConfigFlags)
+     * @param key name of key, encoded in UTF-8
+     * @param value the value, encoded in Latin-1
+     */
+    void writeEntry(const char *key, const char *value, KConfigBase::WriteConfigFlags flags = KConfigBase::Normal);
+
+    /**
+     * Deletes the entry @p key, like KConfigGroup::deleteEntry().
+     */
+    void deleteEntry(const QString &key, KConfigBase::WriteConfigFlags flags = KConfigBase::Normal);
+    /**
+     * Overload for deleteEntry(const QString&, KConfigBase::WriteConfigFlags)
+     * @param key name of key, encoded in UTF-8
+     */
+    void deleteEntry(const char *key, KConfigBase::WriteConfigFlags flags = KConfigBase::Normal);
+
+    /**
+     * Applies the pending writes to the group.
+     * The batch can be used for more writes afterwards.
+     */
+    void apply();
+
+private:
+    friend class KConfigGroup;
+    explicit KConfigGroupBatch(KConfigGroupBatchPrivate *dd);
+
+    std::unique_ptr<KConfigGroupBatchPrivate> d;
+};
+
+/**
+ * \class KConfigKey kconfiggroup.h <KConfigGroup>
+ *
+ * A handle to one entry of a group, taken with KConfigGroup::configKey().
+ *
+ * Reading an entry through KConfigGroup searches for its group and its key
+ * every time. A handle remembers where it found the entry, and finds it again
+ * only once the entries of the config changed. This makes reading the same
+ * setting over and over, e.g. on every paint, as cheap as it gets.
+ *
+ * The values read are the same as KConfigGroup's: localized, with the
+ * defaults if KConfig::readDefaults() is set, and expanded where the entry
+ * asks for it.
+ *
+ * @code
+ * // once
+ * m_animate = KSharedConfig::openConfig()->group(QStringLiteral("KDE")).configKey("AnimationsEnabled");
+ * // on every paint
+ * if (m_animate.readBoolEntry(true)) {
+ *     ...
+ * }
+ * @endcode
+ *
+ * Like the config it refers to, a handle isn't meant to be used by several
+ * threads at the same time.
+ *
+ * @since 6.1
+ */
+class KCONFIGCORE_EXPORT KConfigKey
+{
+public:
+    /**
+     * Constructs a null handle, which refers to no entry.
+     */
+    KConfigKey();
+    KConfigKey(const KConfigKey &other);
+    KConfigKey &operator=(const KConfigKey &other);
+    KConfigKey(KConfigKey &&other) noexcept;
+    KConfigKey &operator=(KConfigKey &&other) noexcept;
+    ~KConfigKey();
+
+    /**
+     * Whether this handle was default constructed.
+     */
+    bool isNull() const;
+
+    /**
+     * The group of the entry.
+     */
+    KConfigGroup group() const;
+    /**
+     * The key of the entry, encoded in UTF-8.
+     */
+    QByteArray key() const;
+
+    /**
+     * Whether there is an entry, see KConfigGroup::hasKey().
+     */
+    bool exists() const;
+    /**
+     * Reads the value of the entry as it is stored, see KConfigGroup::readEntryRaw(),
+     * which tells how long the view is valid.
+     * @return the value of the entry, or a null view if there is none
+     */
+    QByteArrayView readEntryRaw() const;
+    /**
+     * Reads the value of the entry, see KConfigGroup::readEntry(const char*, const QString&) const.
+     */
+    QString readEntry(const QString &aDefault = QString()) const;
+    /**
+     * Reads a boolean entry, see KConfigGroup::readBoolEntry().
+     */
+    bool readBoolEntry(bool aDefault) const;
+    /**
+     * Reads an integer entry, see KConfigGroup::readIntEntry().
+     */
+    int readIntEntry(int aDefault) const;
+
+private:
+    friend class KConfigGroup;
+    explicit KConfigKey(KConfigKeyPrivate *dd);
+
+    std::unique_ptr<KConfigKeyPrivate> d;
+};
+
 #define KCONFIGGROUP_ENUMERATOR_ERROR(ENUM) "The Qt MetaObject system does not seem to know about \"" ENUM "\" please use Q_ENUM or Q_FLAG to register it."
 
 /**
@@ -769,6 +1226,29 @@ private:
         writeEntry(key, QByteArray(M_enum.valueToKeys(value)), flags);                                                                                         \
     }
 
+// The lists most often stored directly parse and format their text, without a QVariantList
+template<>
+KCONFIGCORE_EXPORT QList<int> KConfigGroup::readEntry(const char *key, const QList<int> &defaultValue) const;
+template<>
+KCONFIGCORE_EXPORT QList<qint64> KConfigGroup::readEntry(const char *key, const QList<qint64> &defaultValue) const;
+template<>
+KCONFIGCORE_EXPORT QList<double> KConfigGroup::readEntry(const char *key, const QList<double> &defaultValue) const;
+template<>
+KCONFIGCORE_EXPORT QList<QUrl> KConfigGroup::readEntry(const char *key, const QList<QUrl> &defaultValue) const;
+// Strings and string lists are expanded like readEntry() does, not read as a QVariant
+template<>
+KCONFIGCORE_EXPORT std::optional<QString> KConfigGroup::tryReadEntry(const char *key) const;
+template<>
+KCONFIGCORE_EXPORT std::optional<QStringList> KConfigGroup::tryReadEntry(const char *key) const;
+template<>
+KCONFIGCORE_EXPORT void KConfigGroup::writeEntry(const char *key, const QList<int> &list, WriteConfigFlags pFlags);
+template<>
+KCONFIGCORE_EXPORT void KConfigGroup::writeEntry(const char *key, const QList<qint64> &list, WriteConfigFlags pFlags);
+template<>
+KCONFIGCORE_EXPORT void KConfigGroup::writeEntry(const char *key, const QList<double> &list, WriteConfigFlags pFlags);
+template<>
+KCONFIGCORE_EXPORT void KConfigGroup::writeEntry(const char *key, const QList<QUrl> &list, WriteConfigFlags pFlags);
+
 #include "kconfigconversioncheck_p.h"
 
 template<typename T>
@@ -778,6 +1258,31 @@ T KConfigGroup::readEntry(const char *key, const T &defaultValue) const
     return qvariant_cast<T>(readEntry(key, QVariant::fromValue(defaultValue)));
 }
 
+template<typename T>
+std::optional<T> KConfigGroup::tryReadEntry(const char *key) const
+{
+    KConfigConversionCheck::to_QVariant<T>();
+    QVariant value;
+    if (!readEntryIfPresent(key, QVariant::fromValue(T()), &value)) {
+        return std::nullopt;
+    }
+    return qvariant_cast<T>(value);
+}
+
+template<typename T>
+T KConfigGroup::readCachedEntry(const char *key, const T &defaultValue) const
+{
+    KConfigConversionCheck::to_QVariant<T>();
+    const QVariant variantDefault = QVariant::fromValue(defaultValue);
+    if (const QVariant *value = cachedEntry(key, variantDefault)) {
+        return qvariant_cast<T>(*value);
+    }
+    // the same overload as readEntry(), which makes a difference for strings and lists
+    const T value = readEntry(key, defaultValue);
+    cacheEntry(key, variantDefault, QVariant::fromValue(value));
+    return value;
+}
+
 template<typename T>
 QList<T> KConfigGroup::readEntry(const char *key, const QList<T> &defaultValue) const
 {
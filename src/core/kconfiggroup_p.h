@@ -23,4 +23,14 @@ struct KConfigGroupGui {
 
 extern KCONFIGCORE_EXPORT KConfigGroupGui _kde_internal_KConfigGroupGui;
 
+// The conversions of KConfigGroup, shared with KConfigGroupSnapshot
+namespace KConfigGroupValues
+{
+// as KConfigGroup::readBoolEntry()
+bool toBool(QByteArrayView value);
+// splits a list written by KConfigGroup::writeEntry()
+QStringList toStringList(QByteArrayView value);
+QStringList toStringList(const QString &value);
+}
+
 #endif
@@ -0,0 +1,135 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kconfiggroupsnapshot.h"
+
+#include "kconfig_p.h"
+#include "kconfiggroup_p.h"
+#include "kconfigsnapshot_p.h"
+
+#include <set>
+
+KConfigGroupSnapshot::KConfigGroupSnapshot() = default;
+
+KConfigGroupSnapshot::KConfigGroupSnapshot(KConfigSnapshotPrivate *dd, const QByteArray &group)
+    : d(dd)
+    , m_group(group)
+{
+}
+
+KConfigGroupSnapshot::KConfigGroupSnapshot(const KConfigGroupSnapshot &other) = default;
+
+KConfigGroupSnapshot &KConfigGroupSnapshot::operator=(const KConfigGroupSnapshot &other) = default;
+
+KConfigGroupSnapshot::~KConfigGroupSnapshot() = default;
+
+bool KConfigGroupSnapshot::isNull() const
+{
+    return !d;
+}
+
+QString KConfigGroupSnapshot::name() const
+{
+    // as KConfigGroup::name(), without the names of the parent groups
+    return QString::fromUtf8(m_group.mid(m_group.lastIndexOf('\x1d') + 1));
+}
+
+QStringList KConfigGroupSnapshot::keyList() const
+{
+    if (!d) {
+        return QStringList();
+    }
+    std::set<QString> keys; // unique set, sorted
+    for (auto it = d->entries.cbegin(); it != d->entries.cend(); ++it) {
+        if (!it.key().mKey.isNull() && !it->bDeleted) {
+            keys.insert(QString::fromUtf8(it.key().mKey));
+        }
+    }
+    return QStringList(keys.begin(), keys.end());
+}
+
+bool KConfigGroupSnapshot::hasKey(const char *key) const
+{
+    return d && d->entries.hasEntry(m_group, key, d->searchFlags);
+}
+
+QByteArrayView KConfigGroupSnapshot::value(const char *key, bool *expand) const
+{
+    if (!d) {
+        return {};
+    }
+    const auto it = d->entries.constFindEntry(m_group, key, d->searchFlags);
+    // as KConfigPrivate::lookupValue()
+    if (it == d->entries.constEnd() || it->bDeleted || it->isNull()) {
+        return {};
+    }
+    if (expand) {
+        *expand = it->bExpand;
+    }
+    return it->value();
+}
+
+QByteArrayView KConfigGroupSnapshot::readEntryRaw(const char *key) const
+{
+    return value(key);
+}
+
+QString KConfigGroupSnapshot::readEntry(const char *key, const QString &aDefault) const
+{
+    bool expand = false;
+    const QByteArrayView data = value(key, &expand);
+    if (data.isNull()) {
+        return aDefault;
+    }
+    if (expand) {
+        return KConfigPrivate::expandString(QString::fromUtf8(data));
+    }
+    return QString::fromUtf8(data);
+}
+
+QStringList KConfigGroupSnapshot::readEntry(const char *key, const QStringList &aDefault) const
+{
+    bool expand = false;
+    const QByteArrayView data = value(key, &expand);
+    if (data.isNull()) {
+        return aDefault;
+    }
+    if (expand) {
+        return KConfigGroupValues::toStringList(KConfigPrivate::expandString(QString::fromUtf8(data)));
+    }
+    return KConfigGroupValues::toStringList(data);
+}
+
+bool KConfigGroupSnapshot::readBoolEntry(const char *key, bool aDefault) const
+{
+    const QByteArrayView data = value(key);
+    if (data.isNull()) {
+        return aDefault;
+    }
+    return KConfigGroupValues::toBool(data);
+}
+
+int KConfigGroupSnapshot::readIntEntry(const char *key, int aDefault) const
+{
+    bool ok = false;
+    const int result = value(key).toInt(&ok);
+    return ok ? result : aDefault;
+}
+
+qint64 KConfigGroupSnapshot::readInt64Entry(const char *key, qint64 aDefault) const
+{
+    bool ok = false;
+    const qint64 result = value(key).toLongLong(&ok);
+    return ok ? result : aDefault;
+}
+
+double KConfigGroupSnapshot::readDoubleEntry(const char *key, double aDefault) const
+{
+    bool ok = false;
+    const double result = value(key).toDouble(&ok);
+    return ok ? result : aDefault;
+}
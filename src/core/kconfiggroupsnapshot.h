@@ -0,0 +1,117 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGGROUPSNAPSHOT_H
+#define KCONFIGGROUPSNAPSHOT_H
+
+#include <kconfigcore_export.h>
+
+#include <QByteArrayView>
+#include <QExplicitlySharedDataPointer>
+#include <QStringList>
+
+class KConfigSnapshotPrivate;
+
+/**
+ * \class KConfigGroupSnapshot kconfiggroupsnapshot.h <KConfigGroupSnapshot>
+ *
+ * An immutable copy of the entries of a single group, taken with
+ * KConfigGroup::snapshot().
+ *
+ * Taking it costs about as much as one readEntry(): the entries of the group
+ * are shared with the config rather than copied, and only copied by the config
+ * once one of them is changed. This makes it the cheap way to read many keys of
+ * a group at once, for instance to load a settings page, or to hand them to
+ * another thread. Like KConfigSnapshot, it may be read by any number of threads
+ * at the same time.
+ *
+ * The entries of subgroups aren't part of it; take a snapshot of the subgroup
+ * for those.
+ *
+ * @code
+ * const KConfigGroupSnapshot general = config->group(QStringLiteral("General")).snapshot();
+ * const bool showHidden = general.readBoolEntry("ShowHidden", false);
+ * const int iconSize = general.readIntEntry("IconSize", 32);
+ * @endcode
+ *
+ * @since 6.1
+ */
+class KCONFIGCORE_EXPORT KConfigGroupSnapshot
+{
+public:
+    /**
+     * Constructs a null snapshot, without any entries.
+     */
+    KConfigGroupSnapshot();
+    KConfigGroupSnapshot(const KConfigGroupSnapshot &other);
+    KConfigGroupSnapshot &operator=(const KConfigGroupSnapshot &other);
+    ~KConfigGroupSnapshot();
+
+    /**
+     * Whether this snapshot was default constructed.
+     */
+    bool isNull() const;
+
+    /**
+     * The name of the group, see KConfigGroup::name().
+     */
+    QString name() const;
+
+    /**
+     * The keys of the group, see KConfigGroup::keyList().
+     */
+    QStringList keyList() const;
+    /**
+     * Whether the group has an entry @p key that isn't deleted.
+     */
+    bool hasKey(const char *key) const;
+
+    /**
+     * Reads the value of @p key as it is stored, like KConfigGroup::readEntryRaw().
+     * Unlike the view of a KConfigGroup, this one stays valid as long as the snapshot.
+     * @return the value of the entry, or a null view if there is none
+     * @since 6.1
+     */
+    QByteArrayView readEntryRaw(const char *key) const;
+
+    /**
+     * Reads the value of @p key, like KConfigGroup::readEntry() does.
+     */
+    QString readEntry(const char *key, const QString &aDefault = QString()) const;
+    /**
+     * Reads the list in @p key, like KConfigGroup::readEntry() does.
+     */
+    QStringList readEntry(const char *key, const QStringList &aDefault) const;
+
+    /**
+     * Reads the value of @p key as KConfigGroup::readBoolEntry() does.
+     */
+    bool readBoolEntry(const char *key, bool aDefault) const;
+    /**
+     * Reads the value of @p key as KConfigGroup::readIntEntry() does.
+     */
+    int readIntEntry(const char *key, int aDefault) const;
+    /**
+     * Reads the value of @p key as KConfigGroup::readInt64Entry() does.
+     */
+    qint64 readInt64Entry(const char *key, qint64 aDefault) const;
+    /**
+     * Reads the value of @p key as KConfigGroup::readDoubleEntry() does.
+     */
+    double readDoubleEntry(const char *key, double aDefault) const;
+
+private:
+    friend class KConfigGroup;
+    KConfigGroupSnapshot(KConfigSnapshotPrivate *dd, const QByteArray &group);
+    // the value of @p key, null if there is none
+    QByteArrayView value(const char *key, bool *expand = nullptr) const;
+
+    QExplicitlySharedDataPointer<KConfigSnapshotPrivate> d;
+    QByteArray m_group;
+};
+
+#endif // KCONFIGGROUPSNAPSHOT_H
@@ -11,35 +11,54 @@
 
 #include "bufferfragment_p.h"
 #include "kconfig.h"
+#include "kconfigcompiled_p.h"
 #include "kconfig_core_log_settings.h"
 #include "kconfigbackend_p.h"
 #include "kconfigdata_p.h"
+#include "kconfigstringpool_p.h"
+#include "kconfigtrace_p.h"
 
 #include <QDateTime>
+#include <QDeadlineTimer>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QLockFile>
 #include <QSaveFile>
+#include <QTemporaryFile>
+#include <QThread>
 #include <qplatformdefs.h>
 
 #ifndef Q_OS_WIN
 #include <unistd.h> // getuid, close
+#else
+#include <qt_windows.h> // MoveFileExW
 #endif
+#include <algorithm>
+#include <cstdio> // rename
+#include <cstring> // memchr
 #include <fcntl.h> // open
+#include <limits>
+#include <map>
+#include <set>
 #include <sys/types.h> // uid_t
 
 KCONFIGCORE_EXPORT bool kde_kiosk_exception = false; // flag to disable kiosk restrictions
 
-static QByteArray lookup(const KConfigIniBackend::BufferFragment fragment, QHash<KConfigIniBackend::BufferFragment, QByteArray> *cache)
+static QByteArray intern(const KConfigIniBackend::BufferFragment fragment)
 {
-    auto it = cache->constFind(fragment);
-    if (it != cache->constEnd()) {
-        return it.value();
-    }
+    return KConfigStringPool::intern(QByteArrayView(fragment.constData(), fragment.length()));
+}
 
-    return cache->insert(fragment, fragment.toByteArray()).value();
+static QByteArray internValue(const KConfigIniBackend::BufferFragment fragment)
+{
+    if (fragment.length() <= KEntryValue::InlineCapacity) {
+        // the entry stores a copy inline, neither the pool nor an allocation is needed
+        return fragment.toVolatileByteArray();
+    }
+    return fragment.length() <= KConfigStringPool::maxValueSize ? intern(fragment) : fragment.toByteArray();
 }
 
 QString KConfigIniBackend::warningProlog(const QFile &file, int line)
@@ -49,6 +68,37 @@ QString KConfigIniBackend::warningProlog(const QFile &file, int line)
     return QStringLiteral("KConfigIni: In file %2, line %1: ").arg(line).arg(file.fileName());
 }
 
+KConfigIniBackend::BufferFragment KConfigIniBackend::mapContents(QFile &file, QByteArray *buffer)
+{
+    // Files below this size are cheaper to read than to map.
+    static constexpr qint64 s_mapThreshold = 16 * 1024;
+
+    const qint64 size = file.size();
+    // Resources may hand out read-only memory, printableToString() needs to write to it
+    if (size >= s_mapThreshold && size <= std::numeric_limits<int>::max() && !file.fileName().startsWith(QLatin1Char(':'))) {
+        // A private mapping is copy-on-write: printableToString() decodes escape sequences
+        // in place, so only the pages holding escaped fragments get copied, the rest of
+        // the file is shared with the page cache instead of being duplicated on the heap.
+        // The mapping stays valid until @p file is closed.
+        if (uchar *data = file.map(0, size, QFileDevice::MapPrivateOption)) {
+            return BufferFragment(reinterpret_cast<char *>(data), int(size));
+        }
+    }
+
+    // read into the memory @p buffer already has, unless the size isn't known
+    if (size > 0 && size <= std::numeric_limits<int>::max()) {
+        buffer->resize(size);
+        const qint64 read = file.read(buffer->data(), size);
+        buffer->resize(qMax<qint64>(read, 0));
+        if (read == size) {
+            buffer->append(file.readAll()); // it grew meanwhile
+        }
+    } else {
+        *buffer = file.readAll();
+    }
+    return BufferFragment(buffer->data(), buffer->size());
+}
+
 KConfigIniBackend::KConfigIniBackend()
     : KConfigBackend()
     , lockFile(nullptr)
@@ -68,43 +118,459 @@ KConfigBackend::ParseInfo KConfigIniBackend::parseConfig(const QByteArray &curre
 // merge changes in the on-disk file with the changes in the KConfig object.
 KConfigBackend::ParseInfo KConfigIniBackend::parseConfig(const QByteArray &currentLocale, KEntryMap &entryMap, ParseOptions options, bool merging)
 {
-    if (filePath().isEmpty()) {
+    return parseFile(filePath(), currentLocale, entryMap, options, merging);
+}
+
+namespace
+{
+// What a parse needs besides the entries, kept for the next parse on the same
+// thread instead of being allocated for every file
+struct ParseScratch {
+    QByteArray buffer; // the contents of a file too small to be mapped
+    QList<QByteArray> immutableGroups;
+};
+thread_local ParseScratch t_parseScratch;
+}
+
+KConfigBackend::ParseInfo
+KConfigIniBackend::parseFile(const QString &fileName, const QByteArray &currentLocale, KEntryMap &entryMap, ParseOptions options, bool merging)
+{
+    if (fileName.isEmpty()) {
         return ParseOk;
     }
+    // the defaults of the system are never journaled, no process of the user writes them
+    if (!(options & (ParseDefaults | ParseNoJournal)) && QFileInfo::exists(journalPath(fileName))) {
+        return parseJournaled(fileName, currentLocale, entryMap, options, merging);
+    }
+    return parseSingleFile(fileName, currentLocale, entryMap, options, merging);
+}
+
+QString KConfigIniBackend::journalPath(const QString &fileName)
+{
+    return fileName + QLatin1String(".journal");
+}
+
+QByteArray KConfigIniBackend::shardOf(QByteArrayView group)
+{
+    const qsizetype first = group.indexOf('\x1d');
+    if (first < 0) {
+        return QByteArray();
+    }
+    const qsizetype second = group.indexOf('\x1d', first + 1);
+    return (second < 0 ? group : group.first(second)).toByteArray();
+}
+
+QString KConfigIniBackend::shardPath(const QString &fileName, QByteArrayView shard)
+{
+    // "Containments.1", the dot separating the two levels is escaped in the names
+    const qsizetype separator = shard.indexOf('\x1d');
+    QByteArray name = shard.first(separator).toByteArray().toPercentEncoding(QByteArray(), QByteArrayLiteral("."));
+    name += '.';
+    name += shard.sliced(separator + 1).toByteArray().toPercentEncoding(QByteArray(), QByteArrayLiteral("."));
+    return fileName + QLatin1String(".d/") + QLatin1String(name);
+}
+
+QStringList KConfigIniBackend::shardFiles(const QString &fileName)
+{
+    const QDir dir(fileName + QLatin1String(".d"));
+    QStringList files;
+    const QStringList names = dir.entryList(QDir::Files, QDir::Name);
+    for (const QString &name : names) {
+        // lock files, journals and files still being written have a second dot
+        if (name.count(QLatin1Char('.')) == 1) {
+            files.append(dir.filePath(name));
+        }
+    }
+    return files;
+}
+
+QStringList KConfigIniBackend::shardFiles(const QString &fileName, const QList<QByteArray> &groups)
+{
+    QStringList files;
+    for (const QByteArray &group : groups) {
+        const QByteArray shard = shardOf(group);
+        if (!shard.isEmpty()) {
+            const QString file = shardPath(fileName, shard);
+            if (!files.contains(file) && QFileInfo::exists(file)) {
+                files.append(file);
+            }
+        }
+    }
+    return files;
+}
+
+// Applies the records of @p journal to @p target, calling @p prepareGroup before
+// the entries of a group are changed
+template<typename PrepareGroup>
+static void replayJournal(const KEntryMap &journal, KEntryMap &target, PrepareGroup prepareGroup)
+{
+    QList<KEntryKey> removedKeys;
+    for (auto it = journal.cbegin(), end = journal.cend(); it != end; ++it) {
+        const KEntryKey &key = it.key();
+        if (key.mKey.isNull()) {
+            prepareGroup(key.mGroup); // every group starts with its marker
+        } else if (it->bReverted) {
+            removedKeys.append(key);
+        } else {
+            target[key] = *it;
+        }
+    }
+    target.remove(std::move(removedKeys));
+}
+
+KConfigBackend::ParseInfo
+KConfigIniBackend::parseJournaled(const QString &fileName, const QByteArray &currentLocale, KEntryMap &entryMap, ParseOptions options, bool merging)
+{
+    // The removed entries have to fall back to the files read before, so the records
+    // are applied to the entries of the file alone, which are then parsed as usual
+    KEntryMap fileMap;
+    const ParseOptions fileOptions = options & ParseExpansions;
+    const ParseInfo info = parseSingleFile(fileName, currentLocale, fileMap, fileOptions, merging);
+    if (info == ParseImmutable) {
+        // nothing was appended to the journal since the file became immutable
+        return parseSingleFile(fileName, currentLocale, entryMap, options, merging);
+    } else if (info != ParseOk) {
+        return info;
+    }
+    KEntryMap journal;
+    parseSingleFile(journalPath(fileName), currentLocale, journal, fileOptions | ParseJournal, merging);
+    replayJournal(journal, fileMap, [](const QByteArray &) {});
+
+    QByteArray contents;
+    bool firstEntry = true;
+    writeEntries(currentLocale, contents, fileMap, true, firstEntry);
+    writeEntries(currentLocale, contents, fileMap, false, firstEntry);
+
+    const QFile file(fileName);
+    QList<QByteArray> immutableGroups;
+    parseLines(BufferFragment(contents.data(), contents.size()),
+               file,
+               0,
+               currentLocale,
+               entryMap,
+               options,
+               merging,
+               QByteArrayLiteral("<default>"),
+               false,
+               &immutableGroups);
+    for (const QByteArray &group : std::as_const(immutableGroups)) {
+        entryMap.setEntry(group, QByteArray(), QByteArray(), KEntryMap::EntryImmutable);
+    }
+    return ParseOk;
+}
 
-    QFile file(filePath());
+KConfigBackend::ParseInfo
+KConfigIniBackend::parseSingleFile(const QString &fileName, const QByteArray &currentLocale, KEntryMap &entryMap, ParseOptions options, bool merging)
+{
+    const KConfigTrace::Span span("parseConfig", KConfigTrace::ParseTime, fileName);
+    QFile file(fileName);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         return file.exists() ? ParseOpenError : ParseOk;
     }
 
+    // on systems using \r\n as end of line, \r will be taken care of by
+    // trim() below. The entries don't point into the buffer, it's free again after the parse.
+    ParseScratch &scratch = t_parseScratch;
+    BufferFragment contents = mapContents(file, &scratch.buffer);
+    KConfigTrace::count(KConfigTrace::FilesParsed);
+    KConfigTrace::count(KConfigTrace::BytesRead, contents.length());
+
+    QList<QByteArray> &immutableGroups = scratch.immutableGroups;
+    immutableGroups.clear();
+    const ParseInfo info = parseLines(contents, file, 0, currentLocale, entryMap, options, merging, QByteArrayLiteral("<default>"), false, &immutableGroups);
+
+    // now make sure immutable groups are marked immutable
+    for (const QByteArray &group : std::as_const(immutableGroups)) {
+        entryMap.setEntry(group, QByteArray(), QByteArray(), KEntryMap::EntryImmutable);
+    }
+    immutableGroups.clear();
+    if (scratch.buffer.capacity() > 64 * 1024) {
+        scratch.buffer = QByteArray(); // a large resource that couldn't be mapped isn't worth keeping
+    }
+
+    return info;
+}
+
+// Whether @p line is a plain "Key[locale]=value" entry for another locale.
+// Checks just enough to be sure that the full parse would skip the entry
+// anyway, desktop files have dozens of translations for each localized key.
+static bool isForeignLocaleEntry(const KConfigIniBackend::BufferFragment &line, const QByteArray &currentLocale, const QByteArray &currentLanguage)
+{
+    const int eqpos = line.indexOf('=');
+    if (eqpos <= 0) {
+        return false;
+    }
+
+    int end = eqpos - 1;
+    while (end > 0 && bf_isspace(line.at(end))) {
+        --end;
+    }
+    if (line.at(end) != ']') {
+        return false;
+    }
+
+    int start = end - 1;
+    while (start >= 0 && line.at(start) != '[') {
+        if (line.at(start) == ']') {
+            return false;
+        }
+        --start;
+    }
+    // no locale, an empty one, options, or more brackets in the key: leave it to the full parse
+    if (start <= 0 || start + 1 == end || line.at(start + 1) == '$' || memchr(line.constData(), '[', start)) {
+        return false;
+    }
+
+    const QByteArrayView locale(line.constData() + start + 1, end - start - 1);
+    if (locale == currentLocale || locale == currentLanguage) {
+        return false;
+    }
+    // backward compatibility. C == en_US
+    return locale.front() != 'C' || currentLocale != "en_US";
+}
+
+KConfigBackend::ParseInfo KConfigIniBackend::indexConfig(const QByteArray &currentLocale, KEntryMap &entryMap, ParseOptions options, GroupIndex &index, bool merging)
+{
+    if (filePath().isEmpty()) {
+        return ParseOk;
+    }
+
+    // Parsing decodes escape sequences in the buffer, so what was written can only be used once
+    std::shared_ptr<QByteArray> buffer = std::move(writtenContents);
+    writtenContents.reset();
+    if (!merging || !buffer || !(writtenStamp == FileStamp::of(filePath()))) {
+        buffer.reset();
+    }
+    return indexFile(filePath(), currentLocale, entryMap, options, index, merging, std::move(buffer));
+}
+
+KConfigBackend::ParseInfo KConfigIniBackend::indexFile(const QString &fileName,
+                                                       const QByteArray &currentLocale,
+                                                       KEntryMap &entryMap,
+                                                       ParseOptions options,
+                                                       GroupIndex &index,
+                                                       bool merging,
+                                                       std::shared_ptr<QByteArray> buffer)
+{
+    if (fileName.isEmpty()) {
+        return ParseOk;
+    }
+    if (!merging && !(options & (ParseDefaults | ParseNoJournal)) && QFileInfo::exists(journalPath(fileName))) {
+        // the records may change any group
+        return parseJournaled(fileName, currentLocale, entryMap, options, merging);
+    }
+
+    const KConfigTrace::Span span("indexConfig", KConfigTrace::ParseTime, fileName);
+    QFile file(fileName);
+    if (!buffer) {
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            return file.exists() ? ParseOpenError : ParseOk;
+        }
+        // The segments keep pointing into the buffer after the file is closed, so it can't be a mapping
+        buffer = std::make_shared<QByteArray>(file.readAll());
+        KConfigTrace::count(KConfigTrace::FilesParsed);
+        KConfigTrace::count(KConfigTrace::BytesRead, buffer->size());
+    }
+    BufferFragment contents(buffer->data(), buffer->size());
+
     QList<QByteArray> immutableGroups;
+    const ParseInfo info =
+        parseLines(contents, file, 0, currentLocale, entryMap, options, merging, QByteArrayLiteral("<default>"), false, &immutableGroups, &index, buffer);
+
+    for (const QByteArray &group : std::as_const(immutableGroups)) {
+        entryMap.setEntry(group, QByteArray(), QByteArray(), KEntryMap::EntryImmutable);
+    }
+
+    return info;
+}
 
+void KConfigIniBackend::parseGroupSegments(const QByteArray &currentLocale,
+                                           KEntryMap &entryMap,
+                                           const QByteArray &group,
+                                           const QList<GroupSegment> &segments,
+                                           bool merging)
+{
+    QList<QByteArray> immutableGroups;
+    const auto markImmutable = [&entryMap, &immutableGroups]() {
+        for (const QByteArray &immutableGroup : std::as_const(immutableGroups)) {
+            entryMap.setEntry(immutableGroup, QByteArray(), QByteArray(), KEntryMap::EntryImmutable);
+        }
+        immutableGroups.clear();
+    };
+
+    // Same order and immutability handling as a full parse of the files: a group
+    // becomes immutable once the file that marks it as such has been read completely
+    const QByteArray *previousBuffer = nullptr;
+    for (const GroupSegment &segment : segments) {
+        if (segment.compiled) {
+            markImmutable();
+            previousBuffer = nullptr;
+            segment.compiled->parseGroup(currentLocale, entryMap, group, segment.options);
+            continue;
+        }
+        if (segment.buffer.get() != previousBuffer) {
+            markImmutable();
+            previousBuffer = segment.buffer.get();
+        }
+
+        if (!(segment.options & ParseDefaults) && entryMap.getEntryOption(group, {}, {}, KEntryMap::EntryImmutable)) {
+            continue;
+        }
+
+        const QFile file(segment.fileName); // only used for warnings
+        BufferFragment contents(segment.buffer->data() + segment.start, segment.end - segment.start);
+        parseLines(contents, file, segment.lineNo, currentLocale, entryMap, segment.options, merging, group, segment.immutable, &immutableGroups);
+    }
+    markImmutable();
+}
+
+bool KConfigIniBackend::parseGroupHeader(BufferFragment line, const QFile &file, int lineNo, QByteArray *group, bool *immutable)
+{
+    int start = 1;
+    int end = 0;
+    do {
+        end = start;
+        for (;;) {
+            if (end == line.length()) {
+                qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, lineNo) << "Invalid group header.";
+                return false;
+            }
+            if (line.at(end) == ']') {
+                break;
+            }
+            ++end;
+        }
+        /* clang-format off */
+        if (end + 1 == line.length()
+            && start + 2 == end
+            && line.at(start) == '$'
+            && line.at(start + 1) == 'i') { /* clang-format on */
+            *immutable = true;
+        } else {
+            if (!group->isEmpty()) {
+                *group += '\x1d';
+            }
+            BufferFragment namePart = line.mid(start, end - start);
+            printableToString(&namePart, file, lineNo);
+            group->append(namePart.constData(), namePart.length());
+        }
+    } while ((start = end + 2) <= line.length() && line.at(end + 1) == '[');
+
+    return true;
+}
+
+bool KConfigIniBackend::parseEntryLine(BufferFragment line, const QFile &file, int lineNo, EntryToken *token)
+{
+    BufferFragment aKey;
+    int eqpos = line.indexOf('=');
+    if (eqpos < 0) {
+        aKey = line;
+        line.clear();
+    } else {
+        BufferFragment temp = line.left(eqpos);
+        temp.trim();
+        aKey = temp;
+        line.truncateLeft(eqpos + 1);
+        line.trim();
+    }
+    if (aKey.isEmpty()) {
+        qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, lineNo) << "Invalid entry (empty key)";
+        return false;
+    }
+
+    int start;
+    while ((start = aKey.lastIndexOf('[')) >= 0) {
+        int end = aKey.indexOf(']', start);
+        if (end < 0) {
+            qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, lineNo) << "Invalid entry (missing ']')";
+            return false;
+        } else if (end > start + 1 && aKey.at(start + 1) == '$') { // found option(s)
+            int i = start + 2;
+            while (i < end) {
+                switch (aKey.at(i)) {
+                case 'i':
+                    token->immutable = true;
+                    break;
+                case 'e':
+                    token->expand = true;
+                    break;
+                case 'b':
+                    token->binary = true;
+                    break;
+                case 'r':
+                    token->removed = true;
+                    break;
+                case 'd':
+                    // the rest of the key is ignored, the entry is deleted whether it has a value or not
+                    token->deleted = true;
+                    aKey.truncate(start);
+                    token->key = aKey;
+                    return true;
+                default:
+                    break;
+                }
+                ++i;
+            }
+        } else { // found a locale
+            if (!token->locale.isNull()) {
+                qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, lineNo) << "Invalid entry (second locale!?)";
+                return false;
+            }
+
+            token->locale = aKey.mid(start + 1, end - start - 1);
+        }
+        aKey.truncate(start);
+    }
+    if (eqpos < 0 && !token->removed) { // Do this here after [$d] and [$r] were checked
+        qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, lineNo) << "Invalid entry (missing '=')";
+        return false;
+    }
+
+    token->key = aKey;
+    token->value = line;
+    return true;
+}
+
+KConfigBackend::ParseInfo KConfigIniBackend::parseLines(BufferFragment contents,
+                                                        const QFile &file,
+                                                        int lineNo,
+                                                        const QByteArray &currentLocale,
+                                                        KEntryMap &entryMap,
+                                                        ParseOptions options,
+                                                        bool merging,
+                                                        const QByteArray &group,
+                                                        bool groupImmutable,
+                                                        QList<QByteArray> *immutableGroups,
+                                                        GroupIndex *index,
+                                                        const std::shared_ptr<QByteArray> &buffer)
+{
     bool fileOptionImmutable = false;
-    bool groupOptionImmutable = false;
+    bool groupOptionImmutable = groupImmutable;
     bool groupSkip = false;
 
-    int lineNo = 0;
-    // on systems using \r\n as end of line, \r will be taken care of by
-    // trim() below
-    QByteArray buffer = file.readAll();
-    BufferFragment contents(buffer.data(), buffer.size());
     unsigned int len = contents.length();
     unsigned int startOfLine = 0;
 
+    if (groupOptionImmutable) {
+        immutableGroups->append(group);
+    }
+
     const int langIdx = currentLocale.indexOf('_');
     const QByteArray currentLanguage = langIdx >= 0 ? currentLocale.left(langIdx) : currentLocale;
 
-    QByteArray currentGroup("<default>");
+    QByteArray currentGroup(group);
     bool bDefault = options & ParseDefaults;
     bool allowExecutableValues = options & ParseExpansions;
 
-    // Reduce memory overhead by making use of implicit sharing
-    // This assumes that config files contain only a small amount of
-    // different fragments which are repeated often.
-    // This is often the case, especially sub groups will all have
-    // the same list of keys and similar values as well.
-    QHash<BufferFragment, QByteArray> cache;
-    cache.reserve(4096);
+    // The entries of the current group, in file order. They are set all at once
+    // when the group ends, instead of looking up the group for every one of them.
+    std::vector<KEntryMap::EntryWrite> groupWrites;
+    const auto flushGroup = [&entryMap, &currentGroup, &groupWrites] {
+        if (!groupWrites.empty()) {
+            entryMap.setEntries(currentGroup, std::move(groupWrites));
+            groupWrites.clear();
+        }
+    };
 
     while (startOfLine < len) {
         BufferFragment line = contents.split('\n', &startOfLine);
@@ -117,44 +583,44 @@ KConfigBackend::ParseInfo KConfigIniBackend::parseConfig(const QByteArray &curre
         }
 
         if (line.at(0) == '[') { // found a group
+            flushGroup();
             groupOptionImmutable = fileOptionImmutable;
 
             QByteArray newGroup;
-            int start = 1;
-            int end = 0;
-            do {
-                end = start;
-                for (;;) {
-                    if (end == line.length()) {
-                        qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, lineNo) << "Invalid group header.";
-                        // XXX maybe reset the current group here?
-                        goto next_line;
-                    }
-                    if (line.at(end) == ']') {
-                        break;
-                    }
-                    ++end;
-                }
-                /* clang-format off */
-                if (end + 1 == line.length()
-                    && start + 2 == end
-                    && line.at(start) == '$'
-                    && line.at(start + 1) == 'i') { /* clang-format on */
-                    if (newGroup.isEmpty()) {
-                        fileOptionImmutable = !kde_kiosk_exception;
-                    } else {
-                        groupOptionImmutable = !kde_kiosk_exception;
-                    }
+            bool immutable = false;
+            if (!parseGroupHeader(line, file, lineNo, &newGroup, &immutable)) {
+                // XXX maybe reset the current group here?
+                continue;
+            }
+            if (immutable) {
+                if (newGroup.isEmpty()) {
+                    fileOptionImmutable = !kde_kiosk_exception;
                 } else {
-                    if (!newGroup.isEmpty()) {
-                        newGroup += '\x1d';
+                    groupOptionImmutable = !kde_kiosk_exception;
+                }
+            }
+            // Reduce memory overhead by making use of implicit sharing, the same
+            // group names, keys and values occur in many config files
+            currentGroup = KConfigStringPool::intern(newGroup);
+
+            if (index) {
+                // Only remember where the entries of this group are, parseGroupSegments()
+                // parses them once the group is accessed
+                GroupSegment segment{buffer, file.fileName(), startOfLine, startOfLine, lineNo, options, groupOptionImmutable, {}};
+                while (startOfLine < len) {
+                    const unsigned int nextLine = startOfLine;
+                    BufferFragment entry = contents.split('\n', &startOfLine);
+                    entry.trim();
+                    if (!entry.isEmpty() && entry.at(0) == '[') {
+                        startOfLine = nextLine;
+                        break;
                     }
-                    BufferFragment namePart = line.mid(start, end - start);
-                    printableToString(&namePart, file, lineNo);
-                    newGroup += namePart.toByteArray();
+                    ++lineNo;
+                    segment.end = qMin(startOfLine, len);
                 }
-            } while ((start = end + 2) <= line.length() && line.at(end + 1) == '[');
-            currentGroup = newGroup;
+                (*index)[currentGroup].append(segment);
+                continue;
+            }
 
             groupSkip = entryMap.getEntryOption(currentGroup, {}, {}, KEntryMap::EntryImmutable);
 
@@ -166,81 +632,43 @@ KConfigBackend::ParseInfo KConfigIniBackend::parseConfig(const QByteArray &curre
             // Do not make the groups immutable until the entries from
             // this file have been added.
             {
-                immutableGroups.append(currentGroup);
+                immutableGroups->append(currentGroup);
             }
         } else {
             if (groupSkip && !bDefault) {
                 continue; // skip entry
             }
+            if (!merging && isForeignLocaleEntry(line, currentLocale, currentLanguage)) {
+                continue;
+            }
 
-            BufferFragment aKey;
-            int eqpos = line.indexOf('=');
-            if (eqpos < 0) {
-                aKey = line;
-                line.clear();
-            } else {
-                BufferFragment temp = line.left(eqpos);
-                temp.trim();
-                aKey = temp;
-                line.truncateLeft(eqpos + 1);
-                line.trim();
-            }
-            if (aKey.isEmpty()) {
-                qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, lineNo) << "Invalid entry (empty key)";
+            EntryToken token;
+            if (!parseEntryLine(line, file, lineNo, &token)) {
                 continue;
             }
 
             KEntryMap::EntryOptions entryOptions = {};
-            if (groupOptionImmutable) {
+            if (groupOptionImmutable || (token.immutable && !kde_kiosk_exception)) {
                 entryOptions |= KEntryMap::EntryImmutable;
             }
+            if (token.expand && allowExecutableValues) {
+                entryOptions |= KEntryMap::EntryExpansion;
+            }
 
-            BufferFragment locale;
-            int start;
-            while ((start = aKey.lastIndexOf('[')) >= 0) {
-                int end = aKey.indexOf(']', start);
-                if (end < 0) {
-                    qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, lineNo) << "Invalid entry (missing ']')";
-                    goto next_line;
-                } else if (end > start + 1 && aKey.at(start + 1) == '$') { // found option(s)
-                    int i = start + 2;
-                    while (i < end) {
-                        switch (aKey.at(i)) {
-                        case 'i':
-                            if (!kde_kiosk_exception) {
-                                entryOptions |= KEntryMap::EntryImmutable;
-                            }
-                            break;
-                        case 'e':
-                            if (allowExecutableValues) {
-                                entryOptions |= KEntryMap::EntryExpansion;
-                            }
-                            break;
-                        case 'd':
-                            entryOptions |= KEntryMap::EntryDeleted;
-                            aKey.truncate(start);
-                            printableToString(&aKey, file, lineNo);
-                            entryMap.setEntry(currentGroup, aKey.toByteArray(), QByteArray(), entryOptions);
-                            goto next_line;
-                        default:
-                            break;
-                        }
-                        ++i;
-                    }
-                } else { // found a locale
-                    if (!locale.isNull()) {
-                        qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, lineNo) << "Invalid entry (second locale!?)";
-                        goto next_line;
-                    }
-
-                    locale = aKey.mid(start + 1, end - start - 1);
-                }
-                aKey.truncate(start);
+            if (token.removed && !(options & ParseJournal)) {
+                continue;
             }
-            if (eqpos < 0) { // Do this here after [$d] was checked
-                qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, lineNo) << "Invalid entry (missing '=')";
+
+            BufferFragment aKey = token.key;
+            if (token.deleted) {
+                entryOptions |= KEntryMap::EntryDeleted;
+                printableToString(&aKey, file, lineNo);
+                groupWrites.push_back({aKey.toByteArray(), QByteArray(), entryOptions});
                 continue;
             }
+
+            const BufferFragment locale = token.locale;
+            line = token.value;
             printableToString(&aKey, file, lineNo);
             if (!locale.isEmpty()) {
                 if (locale != currentLocale && locale != currentLanguage) {
@@ -249,7 +677,7 @@ KConfigBackend::ParseInfo KConfigIniBackend::parseConfig(const QByteArray &curre
                         if (merging) {
                             entryOptions |= KEntryMap::EntryRawKey;
                         } else {
-                            goto next_line; // skip this entry if we're not merging
+                            continue; // skip this entry if we're not merging
                         }
                     }
                 }
@@ -271,183 +699,634 @@ KConfigBackend::ParseInfo KConfigIniBackend::parseConfig(const QByteArray &curre
                     entryOptions |= KEntryMap::EntryLocalizedCountry;
                 }
             }
-            printableToString(&line, file, lineNo);
+            QByteArray value;
+            if (token.removed) {
+                entryOptions |= KEntryMap::EntryReverted; // with a null value
+            } else if (token.binary) {
+                entryOptions |= KEntryMap::EntryBinary;
+                value = QByteArray::fromBase64(line.toVolatileByteArray());
+            } else {
+                if (line.indexOf('\\') != -1) {
+                    // decoded on first access, see KEntry::value()
+                    entryOptions |= KEntryMap::EntryEscaped;
+                }
+                value = internValue(line);
+            }
             if (entryOptions & KEntryMap::EntryRawKey) {
                 QByteArray rawKey;
                 rawKey.reserve(aKey.length() + locale.length() + 2);
                 rawKey.append(aKey.toVolatileByteArray());
                 rawKey.append('[').append(locale.toVolatileByteArray()).append(']');
-                entryMap.setEntry(currentGroup, rawKey, lookup(line, &cache), entryOptions);
+                groupWrites.push_back({rawKey, value, entryOptions});
             } else {
-                entryMap.setEntry(currentGroup, lookup(aKey, &cache), lookup(line, &cache), entryOptions);
+                groupWrites.push_back({intern(aKey), value, entryOptions});
             }
         }
-    next_line:
-        continue;
     }
+    flushGroup();
 
-    // now make sure immutable groups are marked immutable
-    for (const QByteArray &group : std::as_const(immutableGroups)) {
-        entryMap.setEntry(group, QByteArray(), QByteArray(), KEntryMap::EntryImmutable);
+    return fileOptionImmutable ? ParseImmutable : ParseOk;
+}
+
+void KConfigIniBackend::writeGroupHeader(QByteArray &out, const QByteArray &group, bool immutable)
+{
+    writeGroupName(out, group);
+    out.append(immutable ? QByteArrayView("][$i]\n") : QByteArrayView("]\n"));
+}
+
+void KConfigIniBackend::writeGroupName(QByteArray &out, const QByteArray &group)
+{
+    for (int start = 0, end;; start = end + 1) {
+        out.append('[');
+        end = group.indexOf('\x1d', start);
+        if (end < 0) {
+            int cgl = group.length();
+            if (group.at(start) == '$' && cgl - start <= 10) {
+                for (int i = start + 1; i < cgl; i++) {
+                    char c = group.at(i);
+                    if (c < 'a' || c > 'z') {
+                        goto nope;
+                    }
+                }
+                out.append("\\x24");
+                ++start;
+            }
+        nope:
+            appendPrintable(out, QByteArrayView(group).sliced(start), GroupString);
+            break;
+        } else {
+            appendPrintable(out, QByteArrayView(group).sliced(start, end - start), GroupString);
+            out.append(']');
+        }
     }
+}
 
-    return fileOptionImmutable ? ParseImmutable : ParseOk;
+void KConfigIniBackend::writeCopiedGroup(QByteArray &out, const QByteArray &group, const GroupSegment &segment, bool &firstEntry)
+{
+    // the lines after the header, up to the next group, without the blank lines at the end
+    const char *data = segment.buffer->constData() + segment.start;
+    qsizetype size = segment.end - segment.start;
+    while (size > 0 && bf_isspace(data[size - 1])) {
+        --size;
+    }
+    if (size == 0) {
+        return; // no entries, such a group isn't written either
+    }
+
+    if (!firstEntry) {
+        out.append('\n');
+    }
+    firstEntry = false;
+    writeGroupHeader(out, group, segment.immutable);
+    out.append(data, size);
+    out.append('\n');
 }
 
-void KConfigIniBackend::writeEntries(const QByteArray &locale, QIODevice &file, const KEntryMap &map, bool defaultGroup, bool &firstEntry)
+static bool needsEscaping(QByteArrayView string, bool escapeBrackets, bool escapeEquals);
+
+// The serialized entries are handed to the file in chunks of this size
+static constexpr qsizetype s_streamChunkSize = 64 * 1024;
+// The size of a file up to which its written contents are kept for the next parse, see
+// setWrittenContents(). A larger one is streamed to the file as it is serialized instead.
+static constexpr qint64 s_keptContentsLimit = 1024 * 1024;
+
+void KConfigIniBackend::writeEntries(const QByteArray &locale,
+                                     QByteArray &out,
+                                     const KEntryMap &map,
+                                     bool defaultGroup,
+                                     bool &firstEntry,
+                                     const CopiedGroups &copied,
+                                     WriterCache *cache,
+                                     QIODevice *stream)
 {
-    QByteArray currentGroup;
-    bool groupIsImmutable = false;
+    static const QByteArray defaultGroupName = QByteArrayLiteral("<default>");
+    // hands what was serialized so far on to @p stream, between groups
+    const auto flush = [&out, stream]() {
+        if (stream && out.size() >= s_streamChunkSize) {
+            stream->write(out);
+            out.truncate(0);
+        }
+    };
+    auto nextCopied = copied.cbegin();
     const auto end = map.cend();
-    for (auto it = map.cbegin(); it != end; ++it) {
-        const KEntryKey &key = it.key();
-
-        // Either process the default group or all others
-        if ((key.mGroup != "<default>") == defaultGroup) {
-            continue; // skip
+    // the default group is found by one lookup, the others are gone through a group at a time
+    auto group = defaultGroup ? map.lowerBound(minimumGroupKey(defaultGroupName)) : map.cbegin();
+    while (group != end) {
+        const auto groupEnd = map.groupEnd(group);
+        const QByteArray &groupName = group.key().mGroup;
+        if ((groupName == defaultGroupName) != defaultGroup) {
+            if (defaultGroup) {
+                break; // not in the map
+            }
+            group = groupEnd;
+            continue;
         }
 
         // the only thing we care about groups is, is it immutable?
-        if (key.mKey.isNull()) {
+        auto it = group;
+        bool groupIsImmutable = false;
+        if (it.key().mKey.isNull()) {
             groupIsImmutable = it->bImmutable;
-            continue; // skip
+            ++it;
         }
-
-        const KEntry &currentEntry = *it;
-        if (!defaultGroup && currentGroup != key.mGroup) {
+        if (!defaultGroup && it != groupEnd) {
+            for (; nextCopied != copied.cend() && nextCopied->first < groupName; ++nextCopied) {
+                writeCopiedGroup(out, nextCopied->first, nextCopied->second, firstEntry);
+                flush();
+            }
             if (!firstEntry) {
-                file.putChar('\n');
-            }
-            currentGroup = key.mGroup;
-            for (int start = 0, end;; start = end + 1) {
-                file.putChar('[');
-                end = currentGroup.indexOf('\x1d', start);
-                if (end < 0) {
-                    int cgl = currentGroup.length();
-                    if (currentGroup.at(start) == '$' && cgl - start <= 10) {
-                        for (int i = start + 1; i < cgl; i++) {
-                            char c = currentGroup.at(i);
-                            if (c < 'a' || c > 'z') {
-                                goto nope;
-                            }
-                        }
-                        file.write("\\x24");
-                        ++start;
-                    }
-                nope:
-                    file.write(stringToPrintable(currentGroup.mid(start), GroupString));
-                    file.putChar(']');
-                    if (groupIsImmutable) {
-                        file.write("[$i]", 4);
-                    }
-                    file.putChar('\n');
-                    break;
-                } else {
-                    file.write(stringToPrintable(currentGroup.mid(start, end - start), GroupString));
-                    file.putChar(']');
-                }
+                out.append('\n');
+            }
+            if (cache) {
+                cache->groups.append(out, groupName, [&groupName](QByteArray &escaped) {
+                    writeGroupName(escaped, groupName);
+                });
+                out.append(groupIsImmutable ? QByteArrayView("][$i]\n") : QByteArrayView("]\n"));
+            } else {
+                writeGroupHeader(out, groupName, groupIsImmutable);
             }
         }
 
-        firstEntry = false;
-        // it is data for a group
-
-        if (key.bRaw) { // unprocessed key with attached locale from merge
-            file.write(key.mKey);
-        } else {
-            file.write(stringToPrintable(key.mKey, KeyString)); // Key
-            if (key.bLocal && locale != "C") { // 'C' locale == untranslated
-                file.putChar('[');
-                file.write(locale); // locale tag
-                file.putChar(']');
+        for (; it != groupEnd; ++it) {
+            const KEntryKey &key = it.key();
+            const KEntry &currentEntry = *it;
+            if (key.mKey.isNull()) {
+                continue; // the marker comes first, unless an empty key was localized
             }
-        }
-        if (currentEntry.bDeleted) {
-            if (currentEntry.bImmutable) {
-                file.write("[$di]", 5); // Deleted + immutable
+            firstEntry = false;
+
+            if (key.bRaw) { // unprocessed key with attached locale from merge
+                out.append(key.mKey);
             } else {
-                file.write("[$d]", 4); // Deleted
+                // most keys need no escaping, finding that out is cheaper than a lookup
+                if (cache && !key.mKey.isEmpty() && needsEscaping(key.mKey, true, true)) {
+                    cache->keys.append(out, key.mKey, [&key](QByteArray &escaped) {
+                        appendPrintable(escaped, key.mKey, KeyString);
+                    });
+                } else {
+                    appendPrintable(out, key.mKey, KeyString); // Key
+                }
+                if (key.bLocal && locale != "C") { // 'C' locale == untranslated
+                    out.append('[');
+                    out.append(locale); // locale tag
+                    out.append(']');
+                }
             }
-        } else {
-            if (currentEntry.bImmutable || currentEntry.bExpand) {
-                file.write("[$", 2);
+            if (currentEntry.bDeleted) {
                 if (currentEntry.bImmutable) {
-                    file.putChar('i');
+                    out.append("[$di]\n"); // Deleted + immutable
+                } else {
+                    out.append("[$d]\n"); // Deleted
+                }
+                continue;
+            }
+            if (currentEntry.bReverted) {
+                out.append("[$r]\n"); // Removed, only in the records of a journal
+                continue;
+            }
+            if (currentEntry.bImmutable || currentEntry.bExpand || currentEntry.bBinary) {
+                out.append("[$");
+                if (currentEntry.bImmutable) {
+                    out.append('i');
                 }
                 if (currentEntry.bExpand) {
-                    file.putChar('e');
+                    out.append('e');
+                }
+                if (currentEntry.bBinary) {
+                    out.append('b');
                 }
-                file.putChar(']');
+                out.append(']');
             }
-            file.putChar('=');
-            file.write(stringToPrintable(currentEntry.mValue, ValueString));
+            out.append('=');
+            if (currentEntry.bBinary) {
+                const QByteArrayView value = currentEntry.value();
+                out.append(QByteArray::fromRawData(value.data(), value.size()).toBase64());
+            } else if (currentEntry.bEscaped) {
+                // never decoded, so still in the form it was read from disk in
+                out.append(currentEntry.rawValue());
+            } else {
+                appendPrintable(out, currentEntry.rawValue(), ValueString);
+            }
+            out.append('\n');
+        }
+
+        if (defaultGroup) {
+            break;
+        }
+        flush();
+        group = groupEnd;
+    }
+
+    if (!defaultGroup) {
+        for (; nextCopied != copied.cend(); ++nextCopied) {
+            writeCopiedGroup(out, nextCopied->first, nextCopied->second, firstEntry);
+            flush();
         }
-        file.putChar('\n');
     }
 }
 
-void KConfigIniBackend::writeEntries(const QByteArray &locale, QIODevice &file, const KEntryMap &map)
+QByteArray KConfigIniBackend::writeEntries(const QByteArray &locale, QIODevice &file, const KEntryMap &map, const CopiedGroups &copied)
 {
     bool firstEntry = true;
+    QByteArray out;
+    // Only the changed groups of a large file are parsed, the others are copied as they
+    // are from what was read, so streaming it leaves no second copy of the whole file
+    const auto source = std::find_if(copied.cbegin(), copied.cend(), [](const auto &group) {
+        return group.second.buffer != nullptr;
+    });
+    QIODevice *stream = source != copied.cend() && source->second.buffer->size() > s_keptContentsLimit ? &file : nullptr;
 
     // write default group
-    writeEntries(locale, file, map, true, firstEntry);
+    writeEntries(locale, out, map, true, firstEntry, {}, &m_writerCache, stream);
 
     // write all other groups
-    writeEntries(locale, file, map, false, firstEntry);
+    writeEntries(locale, out, map, false, firstEntry, copied, &m_writerCache, stream);
+    m_writerCache.groups.rotate();
+    m_writerCache.keys.rotate();
+
+    if (stream) {
+        file.write(out);
+        return QByteArray(); // not kept, the next parse reads the file
+    }
+    // the file gets the serialized entries in large chunks
+    for (qsizetype pos = 0; pos < out.size(); pos += s_streamChunkSize) {
+        file.write(out.constData() + pos, qMin(s_streamChunkSize, out.size() - pos));
+    }
+    return out;
+}
+
+KConfigIniBackend::FileStamp KConfigIniBackend::FileStamp::of(const QString &fileName)
+{
+    FileStamp stamp;
+    const QFileInfo info(fileName);
+    if (!info.exists()) {
+        return stamp;
+    }
+    stamp.size = info.size();
+    stamp.modified = info.lastModified().toMSecsSinceEpoch();
+    stamp.metadataChanged = info.metadataChangeTime().toMSecsSinceEpoch();
+#ifndef Q_OS_WIN
+    // a file replaced by another one, as QSaveFile does, gets a new inode
+    QT_STATBUF statBuf;
+    if (QT_STAT(QFile::encodeName(fileName).constData(), &statBuf) == 0) {
+        stamp.inode = statBuf.st_ino;
+    }
+#endif
+    return stamp;
+}
+
+void KConfigIniBackend::setWrittenContents(QByteArray &&contents)
+{
+    writtenStamp = FileStamp::of(filePath());
+    if (writtenStamp.size != contents.size()) {
+        // the file size differs after eol translation, read it back next time
+        writtenContents.reset();
+        return;
+    }
+    writtenContents = std::make_shared<QByteArray>(std::move(contents));
+}
+
+// How often an optimistic write is tried before it waits for the lock file
+static constexpr int s_optimisticAttempts = 3;
+// The size from which the journal is folded into the file instead of growing further
+static constexpr qint64 s_journalLimit = 64 * 1024;
+
+bool KConfigIniBackend::isChangedSince(const FileStamp &stamp) const
+{
+    // a writer that took the lock file may be about to replace the file
+    return !(FileStamp::of(filePath()) == stamp) || QFileInfo::exists(filePath() + QLatin1String(".lock"));
 }
 
 bool KConfigIniBackend::writeConfig(const QByteArray &locale, KEntryMap &entryMap, WriteOptions options)
 {
     Q_ASSERT(!filePath().isEmpty());
+    const KConfigTrace::Span span("writeConfig", KConfigTrace::WriteTime, filePath());
+    // whether it fails or not, the answer may have changed
+    m_writableDeadline = QDeadlineTimer();
+
+    bool shardsWritten = true;
+    const bool sharding = (options & WriteSharded) && m_shard.isEmpty() && !(options & WriteGlobal);
+    if (sharding) {
+        bool writeFile = false;
+        shardsWritten = writeShards(locale, entryMap, options, &writeFile);
+        if (!writeFile) {
+            return shardsWritten;
+        }
+    }
+
+    WriteResult result = WriteConflict;
+    // only looked at before the lock by the writes that may do without it, the others check it once locked
+    const QString journal = journalPath(filePath());
+    if ((options & WriteJournal) && !(options & WriteGlobal) && QFileInfo(journal).size() < s_journalLimit) {
+        result = appendJournal(locale, entryMap, options);
+    } else if ((options & WriteOptimistic) && !QFileInfo::exists(journal)) {
+        // a journal is only folded into the file by a writer holding the lock file
+        for (int attempt = 0; attempt < s_optimisticAttempts && result == WriteConflict; ++attempt) {
+            if (QFileInfo::exists(filePath() + QLatin1String(".lock"))) {
+                break; // no use merging while another writer holds it
+            }
+            const FileStamp stamp = FileStamp::of(filePath());
+            result = writeMerged(locale, entryMap, options, &stamp);
+            if (result == WriteConflict) {
+                KConfigTrace::count(KConfigTrace::WriteConflicts);
+            }
+        }
+    }
+    if (result == WriteConflict) {
+        // other processes keep writing the file, take turns with them
+        const bool locked = (options & WriteOptimistic) && !isLocked();
+        if (locked && !lock()) {
+            return false;
+        }
+        const bool journaled = QFileInfo::exists(journal); // nobody appends to it while the file is locked
+        result = writeMerged(locale, entryMap, options, nullptr);
+        if (result == Written && journaled) {
+            QFile::remove(journal);
+        }
+        if (locked) {
+            unlock();
+        }
+    }
+
+    if (result == MergeFailed) {
+        return false;
+    }
+    if (sharding && result == Written) {
+        m_shardedStamp = FileStamp::of(filePath()); // the shards' groups were left out
+    }
+    // the entries count as written even if writing failed, KConfig::sync() marks the config dirty again
+    const bool bGlobal = options & WriteGlobal;
+    entryMap.forEachDirtyEntry([this, bGlobal, options](KEntryMapIterator it) {
+        if (it->bGlobal == bGlobal && ownsGroup(it.key().mGroup, options)) {
+            it->bDirty = false;
+        }
+    });
+    return result == Written && shardsWritten;
+}
+
+bool KConfigIniBackend::ownsGroup(QByteArrayView group, WriteOptions options) const
+{
+    return !(options & WriteSharded) || shardOf(group) == m_shard;
+}
+
+bool KConfigIniBackend::writeShards(const QByteArray &locale, KEntryMap &entryMap, WriteOptions options, bool *writeFile)
+{
+    // the shards with dirty entries, and whether the file itself has any
+    std::set<QByteArray> dirtyShards;
+    bool dirtyFile = false;
+    entryMap.forEachDirtyEntry([&dirtyShards, &dirtyFile](KEntryMapIterator it) {
+        if (!it->bGlobal) {
+            QByteArray shard = shardOf(it.key().mGroup);
+            if (shard.isEmpty()) {
+                dirtyFile = true;
+            } else {
+                dirtyShards.insert(std::move(shard));
+            }
+        }
+    });
+
+    // Groups of shards that are still in the file, like all of them in a file written
+    // before it was sharded, are moved to the shards before the dirty entries are written
+    std::map<QByteArray, KEntryMap> moved;
+    const FileStamp stamp = FileStamp::of(filePath());
+    if (!(stamp == m_shardedStamp)) {
+        KEntryMap defaultGroup;
+        GroupIndex index;
+        if (indexFile(filePath(), locale, defaultGroup, ParseExpansions, index, true) != ParseOk) {
+            *writeFile = false;
+            return false;
+        }
+        for (auto it = index.cbegin(); it != index.cend(); ++it) {
+            const QByteArray shard = shardOf(it.key());
+            if (!shard.isEmpty()) {
+                parseGroupSegments(locale, moved[shard], it.key(), *it, true);
+            }
+        }
+        if (moved.empty()) {
+            m_shardedStamp = stamp;
+        }
+    }
+
+    const auto writeShard = [this, &locale, options](const QByteArray &shard, KEntryMap &map) {
+        KConfigIniBackend backend;
+        backend.setFilePath(shardPath(filePath(), shard));
+        backend.m_shard = shard;
+        backend.createEnclosing();
+        // as KConfig::sync() does for the file
+        const bool locked = !(options & WriteOptimistic);
+        if (locked && !backend.lock()) {
+            qCWarning(KCONFIG_CORE_LOG) << "couldn't lock shard file" << backend.filePath();
+            return false;
+        }
+        const bool written = backend.writeConfig(locale, map, options);
+        if (locked) {
+            backend.unlock();
+        }
+        return written;
+    };
+
+    bool written = true;
+    for (auto &[shard, map] : moved) {
+        map.markAllDirty();
+        written = writeShard(shard, map) && written;
+    }
+    if (!written) {
+        // the groups stay in the file until their shards could be written
+        *writeFile = false;
+        return false;
+    }
+    for (const QByteArray &shard : dirtyShards) {
+        written = writeShard(shard, entryMap) && written;
+    }
+    *writeFile = dirtyFile || !moved.empty() || QFileInfo::exists(journalPath(filePath()));
+    return written;
+}
+
+KConfigIniBackend::WriteResult KConfigIniBackend::appendJournal(const QByteArray &locale, KEntryMap &entryMap, WriteOptions options)
+{
+    // the records are what writeMerged() would do to the entries in the file
+    KEntryMap records;
+    entryMap.forEachDirtyEntry([this, &entryMap, &records, options](KEntryMapIterator it) {
+        if (it->bGlobal || !ownsGroup(it.key().mGroup, options)) {
+            return;
+        }
+        KEntry record = *it;
+        if (it->bReverted && it->bOverridesGlobal) {
+            record.bDeleted = true;
+        } else if (it->bReverted || (it->bDeleted && !entryMap.hasDefault(it) && !it->bOverridesGlobal)) {
+            record.bDeleted = false;
+            record.bReverted = true;
+        }
+        records[it.key()] = record;
+    });
+
+    QByteArray out;
+    bool firstEntry = true;
+    writeEntries(locale, out, records, true, firstEntry);
+    if (!out.isEmpty()) {
+        out.prepend("[<default>]\n"); // the records before may have ended in any group
+    }
+    writeEntries(locale, out, records, false, firstEntry);
+    if (out.isEmpty()) {
+        return Written;
+    }
+    out.append('\n');
+
+    const bool locked = !isLocked();
+    if (locked && !lock()) {
+        return WriteFailed;
+    }
+    // one write at the end of the file, the records of other processes go before or after it
+    QFile file(journalPath(filePath()));
+    WriteResult result = WriteFailed;
+    if (file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered)) {
+        if (file.size() == 0) {
+            file.setPermissions(QFile::ReadUser | QFile::WriteUser);
+        }
+        if (file.write(out) == out.size()) {
+            result = Written;
+        } else {
+            qCWarning(KCONFIG_CORE_LOG) << "Couldn't write" << file.fileName() << ". Disk full?";
+        }
+    } else {
+        qCWarning(KCONFIG_CORE_LOG) << "Couldn't open" << file.fileName() << ". Error:" << file.errorString();
+    }
+    if (locked) {
+        unlock();
+    }
+    return result;
+}
+
+// Moves @p from over @p to, replacing it, which QFile::rename() never does
+static bool replaceFile(const QString &from, const QString &to)
+{
+#ifdef Q_OS_WIN
+    return MoveFileExW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(from).utf16()),
+                       reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(to).utf16()),
+                       MOVEFILE_REPLACE_EXISTING);
+#else
+    return ::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0;
+#endif
+}
 
+KConfigIniBackend::WriteResult KConfigIniBackend::writeMerged(const QByteArray &locale, KEntryMap &entryMap, WriteOptions options, const FileStamp *expected)
+{
     KEntryMap writeMap;
     const bool bGlobal = options & WriteGlobal;
 
     // First, reparse the file on disk, to merge our changes with the ones done by other apps
-    // Store the result into writeMap.
+    // Store the result into writeMap. Only the groups we change are actually parsed,
+    // the others are copied to the new file as they are.
+    GroupIndex index;
     {
         ParseOptions opts = ParseExpansions;
         if (bGlobal) {
             opts |= ParseGlobal;
         }
-        ParseInfo info = parseConfig(locale, writeMap, opts, true);
+        ParseInfo info = indexConfig(locale, writeMap, opts, index, true);
         if (info != ParseOk) { // either there was an error or the file became immutable
-            return false;
+            return MergeFailed;
+        }
+    }
+    const auto parseGroup = [&locale, &writeMap, &index](const QByteArray &group) {
+        const auto segments = index.constFind(group);
+        if (segments != index.cend()) {
+            parseGroupSegments(locale, writeMap, group, *segments, true);
+            index.erase(segments);
+        }
+    };
+    // a group split over several places in the file is joined, like the default group
+    for (auto it = index.begin(); it != index.end();) {
+        if (it->size() > 1 || it.key() == "<default>") {
+            parseGroupSegments(locale, writeMap, it.key(), *it, true);
+            it = index.erase(it);
+        } else {
+            ++it;
         }
     }
 
-    const KEntryMapIterator end = entryMap.end();
-    for (KEntryMapIterator it = entryMap.begin(); it != end; ++it) {
-        if (!it.key().mKey.isEmpty() && !it->bDirty) { // not dirty, doesn't overwrite entry in writeMap. skips default entries, too.
-            continue;
+    // The records of the journal are newer than the file, and older than the dirty entries.
+    // Only a writer holding the lock file folds them into the file, see writeConfig().
+    if (!expected && QFileInfo::exists(journalPath(filePath()))) {
+        KEntryMap journal;
+        ParseOptions opts = ParseExpansions | ParseJournal;
+        if (bGlobal) {
+            opts |= ParseGlobal;
+        }
+        if (parseSingleFile(journalPath(filePath()), locale, journal, opts, true) == ParseOpenError) {
+            return MergeFailed;
+        }
+        replayJournal(journal, writeMap, parseGroup);
+    }
+
+    // the groups of other shards are left out, writeShards() moved them
+    if (options & WriteSharded) {
+        for (auto it = index.begin(); it != index.end();) {
+            if (ownsGroup(it.key(), options)) {
+                ++it;
+            } else {
+                it = index.erase(it);
+            }
+        }
+        QList<QByteArray> foreignGroups;
+        writeMap.forEachGroupMarker([this, &foreignGroups, options](KEntryMapConstIterator it) {
+            if (!ownsGroup(it.key().mGroup, options)) {
+                foreignGroups.append(it.key().mGroup);
+            }
+        });
+        for (const QByteArray &group : std::as_const(foreignGroups)) {
+            writeMap.replaceGroup(group, KEntryMap());
         }
+    }
 
+    // Only dirty entries overwrite the ones in writeMap, which skips default entries, too.
+    // The groups without dirty entries aren't even looked at.
+    // What is removed is collected first, a deleted group would move the rest of its entries for each key otherwise.
+    QList<KEntryKey> removedKeys;
+    entryMap.forEachDirtyEntry([this, &entryMap, &writeMap, &parseGroup, &removedKeys, bGlobal, options](KEntryMapIterator it) {
         const KEntryKey &key = it.key();
 
         // only write entries that have the same "globality" as the file
-        if (it->bGlobal == bGlobal) {
+        if (it->bGlobal == bGlobal && ownsGroup(key.mGroup, options)) {
+            parseGroup(key.mGroup);
             if (it->bReverted && it->bOverridesGlobal) {
                 it->bDeleted = true;
                 writeMap[key] = *it;
             } else if (it->bReverted) {
-                writeMap.remove(key);
+                removedKeys.append(key);
             } else if (!it->bDeleted) {
                 writeMap[key] = *it;
             } else {
-                KEntryKey defaultKey = key;
-                defaultKey.bDefault = true;
-                if (!entryMap.contains(defaultKey) && !it->bOverridesGlobal) {
-                    writeMap.remove(key); // remove the deleted entry if there is no default
+                if (!entryMap.hasDefault(it) && !it->bOverridesGlobal) {
+                    removedKeys.append(key); // remove the deleted entry if there is no default
                     // qDebug() << "Detected as deleted=>removed:" << key.mGroup << key.mKey << "global=" << bGlobal;
                 } else {
                     writeMap[key] = *it; // otherwise write an explicitly deleted entry
                     // qDebug() << "Detected as deleted=>[$d]:" << key.mGroup << key.mKey << "global=" << bGlobal;
                 }
             }
-            it->bDirty = false;
         }
+    });
+    writeMap.remove(std::move(removedKeys));
+    // group markers are written whether dirty or not, the dirty ones were above
+    entryMap.forEachGroupMarker([this, &writeMap, &index, &parseGroup, bGlobal, options](KEntryMapConstIterator it) {
+        if (!it->bDirty && it->bGlobal == bGlobal && ownsGroup(it.key().mGroup, options)) {
+            const auto segments = index.constFind(it.key().mGroup);
+            if (segments != index.cend() && segments->constFirst().immutable != it->bImmutable) {
+                parseGroup(it.key().mGroup); // the header changes
+            }
+            writeMap[it.key()] = *it;
+        }
+    });
+
+    CopiedGroups copied;
+    copied.reserve(index.size());
+    for (auto it = index.cbegin(); it != index.cend(); ++it) {
+        copied.append({it.key(), it->constFirst()});
     }
+    std::sort(copied.begin(), copied.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
 
     // now writeMap should contain only entries to be written
     // so write it out to disk
@@ -473,7 +1352,40 @@ bool KConfigIniBackend::writeConfig(const QByteArray &locale, KEntryMap &entryMa
 #endif
     }
 
-    if (createNew) {
+    if (createNew && (options & WriteNoFsync)) {
+        // Like QSaveFile, but renamed into place without waiting for the disk, see KConfig::RelaxedNoFsync
+        QTemporaryFile file(filePath() + QLatin1String(".XXXXXX"));
+        if (!file.open()) {
+            qCWarning(KCONFIG_CORE_LOG) << "Couldn't create a new file:" << filePath() << ". Error:" << file.errorString();
+            return WriteFailed;
+        }
+
+        file.setTextModeEnabled(true); // to get eol translation
+        QByteArray contents = writeEntries(locale, file, writeMap, copied);
+
+        if (expected && isChangedSince(*expected)) {
+            return WriteConflict;
+        }
+
+        if (!file.size() && (fileMode == (QFile::ReadUser | QFile::WriteUser))) {
+            // File is empty and doesn't have special permissions: delete it, see below
+            if (fi.exists()) {
+                QFile::remove(filePath());
+            }
+            return Written;
+        }
+        if (file.flush() && file.setPermissions(fileMode)) {
+            const QString tempPath = file.fileName();
+            file.close();
+            if (replaceFile(tempPath, filePath())) {
+                file.setAutoRemove(false);
+                setWrittenContents(std::move(contents));
+                return Written;
+            }
+        }
+        qCWarning(KCONFIG_CORE_LOG) << "Couldn't write" << filePath() << ". Disk full?";
+        return WriteFailed;
+    } else if (createNew) {
         QSaveFile file(filePath());
         if (!file.open(QIODevice::WriteOnly)) {
 #ifdef Q_OS_ANDROID
@@ -482,16 +1394,21 @@ bool KConfigIniBackend::writeConfig(const QByteArray &locale, KEntryMap &entryMa
             file.setDirectWriteFallback(true);
             if (!file.open(QIODevice::WriteOnly)) {
                 qWarning(KCONFIG_CORE_LOG) << "Couldn't create a new file:" << filePath() << ". Error:" << file.errorString();
-                return false;
+                return WriteFailed;
             }
 #else
             qWarning(KCONFIG_CORE_LOG) << "Couldn't create a new file:" << filePath() << ". Error:" << file.errorString();
-            return false;
+            return WriteFailed;
 #endif
         }
 
         file.setTextModeEnabled(true); // to get eol translation
-        writeEntries(locale, file, writeMap);
+        QByteArray contents = writeEntries(locale, file, writeMap, copied);
+
+        if (expected && isChangedSince(*expected)) {
+            file.cancelWriting();
+            return WriteConflict;
+        }
 
         if (!file.size() && (fileMode == (QFile::ReadUser | QFile::WriteUser))) {
             // File is empty and doesn't have special permissions: delete it.
@@ -508,47 +1425,52 @@ bool KConfigIniBackend::writeConfig(const QByteArray &locale, KEntryMap &entryMa
             // Normal case: Close the file
             if (file.commit()) {
                 QFile::setPermissions(filePath(), fileMode);
-                return true;
+                setWrittenContents(std::move(contents));
+                return Written;
             }
             // Couldn't write. Disk full?
             qCWarning(KCONFIG_CORE_LOG) << "Couldn't write" << filePath() << ". Disk full?";
-            return false;
+            return WriteFailed;
         }
     } else {
+        // Written in place, so the check can only come before the file is truncated
+        if (expected && isChangedSince(*expected)) {
+            return WriteConflict;
+        }
         // Open existing file. *DON'T* create it if it suddenly does not exist!
 #if defined(Q_OS_UNIX) && !defined(Q_OS_ANDROID)
         int fd = QT_OPEN(QFile::encodeName(filePath()).constData(), O_WRONLY | O_TRUNC);
         if (fd < 0) {
-            return false;
+            return WriteFailed;
         }
         QFile f;
         if (!f.open(fd, QIODevice::WriteOnly)) {
             QT_CLOSE(fd);
-            return false;
+            return WriteFailed;
         }
-        writeEntries(locale, f, writeMap);
+        QByteArray contents = writeEntries(locale, f, writeMap, copied);
         f.close();
         QT_CLOSE(fd);
+        setWrittenContents(std::move(contents));
 #else
         QFile f(filePath());
         // XXX This is broken - it DOES create the file if it is suddenly gone.
         if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-            return false;
+            return WriteFailed;
         }
         f.setTextModeEnabled(true);
-        writeEntries(locale, f, writeMap);
+        writeEntries(locale, f, writeMap, copied);
 #endif
     }
-    return true;
+    return Written;
 }
 
-bool KConfigIniBackend::isWritable() const
-{
-    const QString filePath = this->filePath();
-    if (filePath.isEmpty()) {
-        return false;
-    }
+// How long isWritable() keeps its answer, in milliseconds. The permissions
+// rarely change, but dialogs ask for every page they show.
+static constexpr qint64 s_writableValidity = 1000;
 
+static bool isFileWritable(const QString &filePath)
+{
     QFileInfo file(filePath);
     if (file.exists()) {
         return file.isWritable();
@@ -567,6 +1489,20 @@ bool KConfigIniBackend::isWritable() const
     return dir.isDir() && dir.isWritable();
 }
 
+bool KConfigIniBackend::isWritable() const
+{
+    const QString filePath = this->filePath();
+    if (filePath.isEmpty()) {
+        return false;
+    }
+
+    if (m_writableDeadline.hasExpired()) {
+        m_writable = isFileWritable(filePath);
+        m_writableDeadline.setRemainingTime(s_writableValidity);
+    }
+    return m_writable;
+}
+
 QString KConfigIniBackend::nonWritableErrorMessage() const
 {
     return tr("Configuration file \"%1\" not writable.\n").arg(filePath());
@@ -581,6 +1517,7 @@ void KConfigIniBackend::createEnclosing()
 
     // Create the containing dir, maybe it wasn't there
     QDir().mkpath(QFileInfo(file).absolutePath());
+    m_writableDeadline = QDeadlineTimer();
 }
 
 void KConfigIniBackend::setFilePath(const QString &path)
@@ -590,6 +1527,7 @@ void KConfigIniBackend::setFilePath(const QString &path)
     }
 
     Q_ASSERT(QDir::isAbsolutePath(path));
+    m_writableDeadline = QDeadlineTimer();
 
     const QFileInfo info(path);
     if (info.exists()) {
@@ -618,11 +1556,32 @@ KConfigBase::AccessMode KConfigIniBackend::accessMode() const
     return KConfigBase::ReadOnly;
 }
 
+// How long lock() waits, KCONFIG_LOCK_TIMEOUT in milliseconds
+static int lockTimeout()
+{
+    static const int timeout = qEnvironmentVariableIsSet("KCONFIG_LOCK_TIMEOUT") ? qEnvironmentVariableIntValue("KCONFIG_LOCK_TIMEOUT") : -1;
+    return timeout;
+}
+
+// A longer wait for a lock file is reported, with the process holding it
+static constexpr qint64 s_lockReportTime = 500;
+// The longest pause between two attempts to get a lock file, in milliseconds
+static constexpr int s_lockMaxSleep = 50;
+
 bool KConfigIniBackend::lock()
+{
+    return tryLock(lockTimeout());
+}
+
+bool KConfigIniBackend::tryLock(int timeout)
 {
     Q_ASSERT(!filePath().isEmpty());
+    const KConfigTrace::Span span("lock", KConfigTrace::LockWaitTime, filePath());
+    const QDeadlineTimer deadline = timeout < 0 ? QDeadlineTimer(QDeadlineTimer::Forever) : QDeadlineTimer(timeout);
 
-    m_mutex.lock();
+    if (!m_mutex.tryLock(timeout < 0 ? -1 : timeout)) {
+        return false;
+    }
 #ifdef Q_OS_ANDROID
     if (!lockFile) {
         // handle content Uris properly
@@ -642,8 +1601,42 @@ bool KConfigIniBackend::lock()
     }
 #endif
 
-    lockFile->lock();
-    return lockFile->isLocked();
+    // QLockFile::lock() sleeps 100 ms after the first attempt and doubles that up to
+    // 5 s, a file another process holds for a moment would stall for seconds
+    QElapsedTimer waited;
+    bool reported = false;
+    int sleep = 1;
+    while (!lockFile->tryLock(0)) {
+        if (lockFile->error() != QLockFile::LockFailedError || deadline.hasExpired()) {
+            break;
+        }
+        if (!waited.isValid()) {
+            waited.start();
+            KConfigTrace::count(KConfigTrace::LockContentions);
+        }
+        if (!reported && waited.elapsed() >= s_lockReportTime) {
+            reported = true;
+            qint64 pid = 0;
+            QString hostName;
+            QString appName;
+            lockFile->getLockInfo(&pid, &hostName, &appName);
+            qCWarning(KCONFIG_CORE_LOG) << "Waiting for the lock of" << filePath() << "held by" << appName << "with pid" << pid << "on" << hostName;
+        }
+        const qint64 remaining = deadline.remainingTime();
+        QThread::msleep(remaining < 0 ? sleep : std::min<qint64>(sleep, remaining));
+        sleep = std::min(sleep * 2, s_lockMaxSleep);
+    }
+    if (reported) {
+        qCWarning(KCONFIG_CORE_LOG) << "Waited" << waited.elapsed() << "ms for the lock of" << filePath();
+    }
+
+    if (!lockFile->isLocked()) {
+        delete lockFile;
+        lockFile = nullptr;
+        m_mutex.unlock();
+        return false;
+    }
+    return true;
 }
 
 void KConfigIniBackend::unlock()
@@ -767,19 +1760,45 @@ public:
 };
 }
 
-QByteArray KConfigIniBackend::stringToPrintable(const QByteArray &aString, StringType type)
+// Whether @p string has to go through the escaping in appendPrintable(). This is
+// checked without branching on the bytes, so that the compiler can vectorize it.
+static bool needsEscaping(QByteArrayView string, bool escapeBrackets, bool escapeEquals)
+{
+    if (string.front() == ' ' || string.back() == ' ') {
+        return true; // only protected for keys and values, leave that to the escaping
+    }
+    bool escape = false;
+    bool ascii = true;
+    for (const char c : string) {
+        const auto u = static_cast<unsigned char>(c);
+        // control characters and DEL
+        escape |= (u < 32u) | (u == 127u);
+        ascii &= u < 128u;
+        escape |= c == '\\';
+        escape |= escapeBrackets & ((c == '[') | (c == ']'));
+        escape |= escapeEquals & (c == '=');
+    }
+    // valid UTF-8 is written as it is, only the bytes of invalid sequences are escaped
+    return escape || (!ascii && !string.isValidUtf8());
+}
+
+void KConfigIniBackend::appendPrintable(QByteArray &out, QByteArrayView aString, StringType type)
 {
-    const int len = aString.size();
+    const qsizetype len = aString.size();
     if (len == 0) {
-        return aString;
+        return;
+    }
+    if (!needsEscaping(aString, type != ValueString, type == KeyString)) {
+        out.append(aString);
+        return;
     }
 
-    QByteArray result; // Guesstimated that it's good to avoid data() initialization for a length of len*4
-    result.resize(len * 4); // Maximum 4x as long as source string due to \x<ab> escape sequences
-    const char *s = aString.constData();
-    int i = 0;
-    char *data = result.data();
-    char *start = data;
+    const qsizetype oldSize = out.size();
+    out.resize(oldSize + len * 4); // Maximum 4x as long as source string due to \x<ab> escape sequences
+    const char *s = aString.data();
+    qsizetype i = 0;
+    char *start = out.data() + oldSize;
+    char *data = start;
 
     // Protect leading space
     if (s[0] == ' ' && type != GroupString) {
@@ -846,39 +1865,23 @@ QByteArray KConfigIniBackend::stringToPrintable(const QByteArray &aString, Strin
         }
     }
     data = utf8.write(data);
-    *data = 0;
-    result.resize(data - start);
 
-    // Protect trailing space
-    if (result.endsWith(' ') && type != GroupString) {
-        result.replace(result.length() - 1, 1, "\\s");
+    // Protect trailing space, the escaped string has room for the extra byte
+    if (data != start && data[-1] == ' ' && type != GroupString) {
+        data[-1] = '\\';
+        *data++ = 's';
     }
-
-    return result;
+    out.resize(data - out.constData());
 }
 
-char KConfigIniBackend::charFromHex(const char *str, const QFile &file, int line)
+QByteArray KConfigIniBackend::stringToPrintable(const QByteArray &aString, StringType type)
 {
-    unsigned char ret = 0;
-    for (int i = 0; i < 2; i++) {
-        ret <<= 4;
-        quint8 c = quint8(str[i]);
-
-        if (c >= '0' && c <= '9') {
-            ret |= c - '0';
-        } else if (c >= 'a' && c <= 'f') {
-            ret |= c - 'a' + 0x0a;
-        } else if (c >= 'A' && c <= 'F') {
-            ret |= c - 'A' + 0x0a;
-        } else {
-            QByteArray e(str, 2);
-            e.prepend("\\x");
-            qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, line) << "Invalid hex character " << c << " in \\x<nn>-type escape sequence \"" << e.constData()
-                                        << "\".";
-            return 'x';
-        }
+    if (!aString.isEmpty() && !needsEscaping(aString, type != ValueString, type == KeyString)) {
+        return aString; // shared, not copied
     }
-    return char(ret);
+    QByteArray result;
+    appendPrintable(result, aString, type);
+    return result;
 }
 
 void KConfigIniBackend::printableToString(BufferFragment *aString, const QFile &file, int line)
@@ -887,63 +1890,9 @@ void KConfigIniBackend::printableToString(BufferFragment *aString, const QFile &
         return;
     }
     aString->trim();
-    int l = aString->length();
-    char *r = aString->data();
-    char *str = r;
-
-    for (int i = 0; i < l; i++, r++) {
-        if (str[i] != '\\') {
-            *r = str[i];
-        } else {
-            // Probable escape sequence
-            ++i;
-            if (i >= l) { // Line ends after backslash - stop.
-                *r = '\\';
-                break;
-            }
-
-            switch (str[i]) {
-            case 's':
-                *r = ' ';
-                break;
-            case 't':
-                *r = '\t';
-                break;
-            case 'n':
-                *r = '\n';
-                break;
-            case 'r':
-                *r = '\r';
-                break;
-            case '\\':
-                *r = '\\';
-                break;
-            case ';':
-                // not really an escape sequence, but allowed in .desktop files, don't strip '\;' from the string
-                *r = '\\';
-                ++r;
-                *r = ';';
-                break;
-            case ',':
-                // not really an escape sequence, but allowed in .desktop files, don't strip '\,' from the string
-                *r = '\\';
-                ++r;
-                *r = ',';
-                break;
-            case 'x':
-                if (i + 2 < l) {
-                    *r = charFromHex(str + i + 1, file, line);
-                    i += 2;
-                } else {
-                    *r = 'x';
-                    i = l - 1;
-                }
-                break;
-            default:
-                *r = '\\';
-                qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, line) << QStringLiteral("Invalid escape sequence \"\\%1\".").arg(str[i]);
-            }
-        }
+    QStringList warnings;
+    aString->truncate(KEntry::unescape(aString->data(), aString->length(), &warnings));
+    for (const QString &warning : std::as_const(warnings)) {
+        qCWarning(KCONFIG_CORE_LOG) << warningProlog(file, line) << warning;
     }
-    aString->truncate(r - aString->constData());
 }
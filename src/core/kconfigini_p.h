@@ -12,21 +12,118 @@
 
 #include <kconfigbackend_p.h>
 #include <kconfigcore_export.h>
+#include <QDeadlineTimer>
+#include <QHash>
 #include <QMutex>
 
+#include <memory>
+#include <utility>
+
+class KConfigCompiledFile;
 class QLockFile;
 class QIODevice;
 
 class KConfigIniBackend : public KConfigBackend
 {
     Q_OBJECT
+    friend class KConfigIniReader;
+
+public:
+    // Tells whether a file was changed, without reading it, a missing file has a size of -1
+    struct FileStamp {
+        qint64 size = -1;
+        qint64 modified = 0;
+        qint64 metadataChanged = 0;
+        quint64 inode = 0;
+
+        static FileStamp of(const QString &fileName);
+        bool operator==(const FileStamp &other) const
+        {
+            return size == other.size && modified == other.modified && metadataChanged == other.metadataChanged && inode == other.inode;
+        }
+    };
+
+    // The escaped forms of the strings one write escaped, for the next write of the
+    // same file. What the next write doesn't need anymore is forgotten after it.
+    class EscapeCache
+    {
+    public:
+        // Appends the escaped @p string, which @p escape appends to the byte array it is given
+        template<typename Escape>
+        void append(QByteArray &out, const QByteArray &string, Escape escape)
+        {
+            auto it = m_current.constFind(string);
+            if (it == m_current.cend()) {
+                QByteArray escaped = m_previous.take(string);
+                if (escaped.isNull()) {
+                    escape(escaped);
+                }
+                it = m_current.insert(string, escaped);
+            }
+            out.append(*it);
+        }
+        // Called once a write is done
+        void rotate()
+        {
+            m_previous = std::exchange(m_current, {});
+        }
+
+    private:
+        QHash<QByteArray, QByteArray> m_previous;
+        QHash<QByteArray, QByteArray> m_current;
+    };
+    // The group names and the keys that had to be escaped, see writeEntries()
+    struct WriterCache {
+        EscapeCache groups;
+        EscapeCache keys;
+    };
+
 private:
     QLockFile *lockFile;
     QMutex m_mutex;
 
+    // The contents writeConfig() wrote last. As long as the file still has the same
+    // stamp, the next writeConfig() merges with them instead of reading the file again.
+    std::shared_ptr<QByteArray> writtenContents;
+    FileStamp writtenStamp;
+    // Remembers @p contents as the ones of the file just written
+    void setWrittenContents(QByteArray &&contents);
+
+    // The shard this backend writes, empty for the file the shards belong to
+    QByteArray m_shard;
+    // The stamp of the file when it was last found without groups that belong to shards
+    FileStamp m_shardedStamp;
+
+    // What isWritable() found last, until the deadline. Setting the file, creating
+    // its directory or writing it asks again, so a failed sync() is seen at once.
+    mutable bool m_writable = false;
+    mutable QDeadlineTimer m_writableDeadline;
+
+    // What the last write of the file escaped, for the next one
+    WriterCache m_writerCache;
+
 public:
     class BufferFragment;
 
+    /**
+     * The location of the entries of one group in the file read by indexConfig()
+     */
+    struct GroupSegment {
+        std::shared_ptr<QByteArray> buffer;
+        QString fileName;
+        unsigned int start;
+        unsigned int end;
+        int lineNo;
+        ParseOptions options;
+        bool immutable;
+        // set for a group of a compiled file, whose segments have no buffer
+        std::shared_ptr<const KConfigCompiledFile> compiled;
+    };
+    // Segments of a group are in the order the files were read
+    using GroupIndex = QHash<QByteArray, QList<GroupSegment>>;
+    // Groups copied to the written file as they were read, sorted by name
+    using CopiedGroups = QList<std::pair<QByteArray, GroupSegment>>;
+
     KConfigIniBackend();
     ~KConfigIniBackend() override;
 
@@ -34,12 +131,43 @@ public:
     ParseInfo parseConfig(const QByteArray &locale, KEntryMap &entryMap, ParseOptions options, bool merging);
     bool writeConfig(const QByteArray &locale, KEntryMap &entryMap, WriteOptions options) override;
 
+    // Like parseConfig(), but only the entries of the default group are parsed,
+    // the other groups are just added to @p index
+    ParseInfo indexConfig(const QByteArray &locale, KEntryMap &entryMap, ParseOptions options, GroupIndex &index, bool merging = false);
+    // Parse @p fileName the same as parseConfig() and indexConfig() of a backend for it, without
+    // creating one. With @p buffer, these are the contents of the file and it isn't read.
+    static ParseInfo parseFile(const QString &fileName, const QByteArray &locale, KEntryMap &entryMap, ParseOptions options, bool merging = false);
+    static ParseInfo indexFile(const QString &fileName,
+                               const QByteArray &locale,
+                               KEntryMap &entryMap,
+                               ParseOptions options,
+                               GroupIndex &index,
+                               bool merging = false,
+                               std::shared_ptr<QByteArray> buffer = {});
+    // The file next to @p fileName that KConfig::Journaled appends the changes to.
+    // parseFile() and indexFile() replay it after the file, writeConfig() folds it into it.
+    static QString journalPath(const QString &fileName);
+    // With KConfig::ShardedGroups, a group below a top-level group, like [Containments][1][Applets][2],
+    // is stored in the file of the shard named by its first two levels, [Containments][1].
+    // Returns that name, or an empty one for a top-level group, which stays in the file.
+    static QByteArray shardOf(QByteArrayView group);
+    // The file of @p shard of @p fileName, in the directory <fileName>.d
+    static QString shardPath(const QString &fileName, QByteArrayView shard);
+    // The shard files of @p fileName that exist, sorted
+    static QStringList shardFiles(const QString &fileName);
+    // The file of the shard of each of @p groups that exists, for reading just those again
+    static QStringList shardFiles(const QString &fileName, const QList<QByteArray> &groups);
+    // Parses the entries of @p group that were indexed by indexConfig()
+    static void
+    parseGroupSegments(const QByteArray &locale, KEntryMap &entryMap, const QByteArray &group, const QList<GroupSegment> &segments, bool merging = false);
+
     bool isWritable() const override;
     QString nonWritableErrorMessage() const override;
     KConfigBase::AccessMode accessMode() const override;
     void createEnclosing() override;
     void setFilePath(const QString &path) override;
     bool lock() override;
+    bool tryLock(int timeout) override;
     void unlock() override;
     bool isLocked() const override;
 
@@ -53,11 +181,73 @@ protected:
     // fragment will get their data modified too.
     static void printableToString(BufferFragment *aString, const QFile &file, int line);
     static QByteArray stringToPrintable(const QByteArray &aString, StringType type);
-    static char charFromHex(const char *str, const QFile &file, int line);
+    // Appends @p aString to @p out, escaped as stringToPrintable() does
+    static void appendPrintable(QByteArray &out, QByteArrayView aString, StringType type);
     static QString warningProlog(const QFile &file, int line);
+    // Returns the contents of @p file, either mapped copy-on-write or read into @p buffer
+    static BufferFragment mapContents(QFile &file, QByteArray *buffer);
+
+    // The tokenizer used by the parser and KConfigIniReader. Warnings are printed for invalid lines.
+
+    // Decodes the group name of @p line, which starts with '['. @p immutable is set if it ends with [$i].
+    static bool parseGroupHeader(BufferFragment line, const QFile &file, int lineNo, QByteArray *group, bool *immutable);
+    struct EntryToken; // defined with BufferFragment
+    static bool parseEntryLine(BufferFragment line, const QFile &file, int lineNo, EntryToken *token);
+
+    // Parses @p fileName alone, without its journal
+    static ParseInfo parseSingleFile(const QString &fileName, const QByteArray &locale, KEntryMap &entryMap, ParseOptions options, bool merging);
+    // Parses @p fileName with the records of its journal applied
+    static ParseInfo parseJournaled(const QString &fileName, const QByteArray &locale, KEntryMap &entryMap, ParseOptions options, bool merging);
+
+    static ParseInfo parseLines(BufferFragment contents,
+                                const QFile &file,
+                                int lineNo,
+                                const QByteArray &locale,
+                                KEntryMap &entryMap,
+                                ParseOptions options,
+                                bool merging,
+                                const QByteArray &group,
+                                bool groupImmutable,
+                                QList<QByteArray> *immutableGroups,
+                                GroupIndex *index = nullptr,
+                                const std::shared_ptr<QByteArray> &buffer = {});
+
+    enum WriteResult {
+        Written,
+        WriteFailed,
+        MergeFailed, // the file couldn't be read, the entries stay dirty
+        WriteConflict, // the file changed since @p expected
+    };
+    // Merges the dirty entries of @p entryMap with the file and writes it. With @p expected,
+    // the file is only replaced if it still has that stamp, and no lock file exists.
+    WriteResult writeMerged(const QByteArray &locale, KEntryMap &entryMap, WriteOptions options, const FileStamp *expected);
+    bool isChangedSince(const FileStamp &stamp) const;
+    // Appends the dirty local entries of @p entryMap to the journal of the file
+    WriteResult appendJournal(const QByteArray &locale, KEntryMap &entryMap, WriteOptions options);
+    // Whether entries of @p group are written to this file
+    bool ownsGroup(QByteArrayView group, WriteOptions options) const;
+    // Writes the dirty entries of the shards, and moves the groups that belong to shards
+    // there from the file. @p writeFile is set if the file itself still has to be written.
+    bool writeShards(const QByteArray &locale, KEntryMap &entryMap, WriteOptions options, bool *writeFile);
 
-    void writeEntries(const QByteArray &locale, QIODevice &file, const KEntryMap &map);
-    void writeEntries(const QByteArray &locale, QIODevice &file, const KEntryMap &map, bool defaultGroup, bool &firstEntry);
+    // Writes the groups of @p map, and the ones in @p copied between them in their order.
+    // Returns what was written, or nothing for a large file, which is written as it goes.
+    QByteArray writeEntries(const QByteArray &locale, QIODevice &file, const KEntryMap &map, const CopiedGroups &copied = {});
+    // Serializes the entries into @p out. With @p cache, the group headers and the
+    // keys that need escaping are taken from it, as the previous write escaped them.
+    // With @p stream, @p out is written to it and emptied whenever it grew large.
+    static void writeEntries(const QByteArray &locale,
+                             QByteArray &out,
+                             const KEntryMap &map,
+                             bool defaultGroup,
+                             bool &firstEntry,
+                             const CopiedGroups &copied = {},
+                             WriterCache *cache = nullptr,
+                             QIODevice *stream = nullptr);
+    static void writeGroupHeader(QByteArray &out, const QByteArray &group, bool immutable);
+    // The header of @p group without its closing bracket
+    static void writeGroupName(QByteArray &out, const QByteArray &group);
+    static void writeCopiedGroup(QByteArray &out, const QByteArray &group, const GroupSegment &segment, bool &firstEntry);
 };
 
 #endif // KCONFIGINI_P_H
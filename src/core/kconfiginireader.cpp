@@ -0,0 +1,145 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kconfiginireader.h"
+
+#include "bufferfragment_p.h"
+#include "kconfigini_p.h"
+
+#include <QFile>
+
+using BufferFragment = KConfigIniBackend::BufferFragment;
+
+class KConfigIniReaderPrivate
+{
+public:
+    QFile file;
+    QByteArray buffer; // the contents of small files, large ones are mapped
+    BufferFragment contents;
+    unsigned int startOfLine = 0;
+    int lineNo = 0;
+    bool isOpen = false;
+
+    QByteArray group = QByteArrayLiteral("<default>");
+    bool fileImmutable = false;
+    bool groupImmutable = false;
+
+    BufferFragment key;
+    BufferFragment locale;
+    BufferFragment value;
+    QByteArray binaryValue; // the decoded value of a Binary entry
+    KConfigIniReader::EntryFlags flags;
+};
+
+KConfigIniReader::KConfigIniReader(const QString &fileName)
+    : d(new KConfigIniReaderPrivate)
+{
+    d->file.setFileName(fileName);
+    if (d->file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        d->isOpen = true;
+        d->contents = KConfigIniBackend::mapContents(d->file, &d->buffer);
+    }
+}
+
+KConfigIniReader::~KConfigIniReader() = default;
+
+bool KConfigIniReader::isOpen() const
+{
+    return d->isOpen;
+}
+
+bool KConfigIniReader::readNext()
+{
+    const unsigned int len = d->contents.length();
+    while (d->startOfLine < len) {
+        BufferFragment line = d->contents.split('\n', &d->startOfLine);
+        line.trim();
+        ++d->lineNo;
+
+        // skip empty lines and lines beginning with '#'
+        if (line.isEmpty() || line.at(0) == '#') {
+            continue;
+        }
+
+        if (line.at(0) == '[') {
+            QByteArray newGroup;
+            bool immutable = false;
+            if (!KConfigIniBackend::parseGroupHeader(line, d->file, d->lineNo, &newGroup, &immutable)) {
+                continue;
+            }
+            if (newGroup.isEmpty()) { // [$i] on its own
+                d->fileImmutable = d->fileImmutable || immutable;
+            } else {
+                d->groupImmutable = immutable;
+                d->group = newGroup;
+            }
+            continue;
+        }
+
+        KConfigIniBackend::EntryToken token;
+        if (!KConfigIniBackend::parseEntryLine(line, d->file, d->lineNo, &token)) {
+            continue;
+        }
+
+        d->flags = NoFlags;
+        if (token.immutable || d->groupImmutable || d->fileImmutable) {
+            d->flags |= Immutable;
+        }
+        if (token.expand) {
+            d->flags |= Expand;
+        }
+        if (token.deleted) {
+            d->flags |= Deleted;
+        }
+        if (token.binary) {
+            d->flags |= Binary;
+        }
+
+        d->key = token.key;
+        KConfigIniBackend::printableToString(&d->key, d->file, d->lineNo);
+        d->locale = token.locale;
+        d->value = token.value;
+        if (token.binary) {
+            d->binaryValue = QByteArray::fromBase64(d->value.toVolatileByteArray());
+            d->value = BufferFragment(d->binaryValue.data(), int(d->binaryValue.size()));
+        } else {
+            KConfigIniBackend::printableToString(&d->value, d->file, d->lineNo);
+        }
+        return true;
+    }
+
+    d->key = BufferFragment();
+    d->locale = BufferFragment();
+    d->value = BufferFragment();
+    d->flags = NoFlags;
+    return false;
+}
+
+QByteArrayView KConfigIniReader::group() const
+{
+    return d->group;
+}
+
+QByteArrayView KConfigIniReader::key() const
+{
+    return QByteArrayView(d->key.constData(), d->key.length());
+}
+
+QByteArrayView KConfigIniReader::locale() const
+{
+    return QByteArrayView(d->locale.constData(), d->locale.length());
+}
+
+QByteArrayView KConfigIniReader::value() const
+{
+    return QByteArrayView(d->value.constData(), d->value.length());
+}
+
+KConfigIniReader::EntryFlags KConfigIniReader::flags() const
+{
+    return d->flags;
+}
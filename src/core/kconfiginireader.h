@@ -0,0 +1,109 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGINIREADER_H
+#define KCONFIGINIREADER_H
+
+#include <kconfigcore_export.h>
+
+#include <QByteArrayView>
+#include <QScopedPointer>
+#include <QString>
+
+class KConfigIniReaderPrivate;
+
+/**
+ * \class KConfigIniReader kconfiginireader.h <KConfigIniReader>
+ *
+ * Reads the entries of a single configuration file one after the other.
+ *
+ * Unlike KConfig, this neither cascades to other files nor stores the entries,
+ * which makes it cheap for tools that only need a few keys or a single pass
+ * over a file. Every call to readNext() advances to the next entry; stop
+ * calling it once the wanted entries have been found.
+ *
+ * @code
+ * KConfigIniReader reader(fileName);
+ * while (reader.readNext()) {
+ *     if (reader.group() == "General" && reader.key() == "Theme" && reader.locale().isNull()) {
+ *         theme = QString::fromUtf8(reader.value());
+ *         break;
+ *     }
+ * }
+ * @endcode
+ *
+ * The views returned by group(), key(), locale() and value() are only valid
+ * until the next call to readNext().
+ *
+ * @since 6.1
+ */
+class KCONFIGCORE_EXPORT KConfigIniReader
+{
+public:
+    /**
+     * The options of an entry.
+     */
+    enum EntryFlag {
+        NoFlags = 0,
+        Immutable = 0x1, ///< The entry, its group or the whole file is marked with [$i]
+        Expand = 0x2, ///< The value should undergo dollar expansion, see KConfigGroup::readPathEntry()
+        Deleted = 0x4, ///< The entry is marked with [$d], it has no value
+        Binary = 0x8, ///< The entry is marked with [$b], value() is decoded from base64. @since 6.1
+    };
+    /**
+     * Stores a combination of #EntryFlag values.
+     */
+    Q_DECLARE_FLAGS(EntryFlags, EntryFlag)
+
+    /**
+     * Opens @p fileName for reading.
+     */
+    explicit KConfigIniReader(const QString &fileName);
+    ~KConfigIniReader();
+
+    /**
+     * Whether the file could be opened.
+     */
+    bool isOpen() const;
+
+    /**
+     * Advances to the next entry.
+     * @return false once the end of the file is reached
+     */
+    bool readNext();
+
+    /**
+     * The group of the current entry, with the names of nested groups
+     * separated by '\\x1d', or "<default>" for entries before the first group.
+     */
+    QByteArrayView group() const;
+    /**
+     * The key of the current entry, without its locale and options.
+     */
+    QByteArrayView key() const;
+    /**
+     * The locale of the current entry, null if the entry isn't localized.
+     */
+    QByteArrayView locale() const;
+    /**
+     * The value of the current entry, with escape sequences decoded, or
+     * decoded from base64 if it is marked Binary.
+     */
+    QByteArrayView value() const;
+    /**
+     * The options of the current entry.
+     */
+    EntryFlags flags() const;
+
+private:
+    Q_DISABLE_COPY(KConfigIniReader)
+    const QScopedPointer<KConfigIniReaderPrivate> d;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KConfigIniReader::EntryFlags)
+
+#endif // KCONFIGINIREADER_H
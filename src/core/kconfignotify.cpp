@@ -0,0 +1,119 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kconfignotify_p.h"
+
+#include "config-kconfig.h"
+#include "kconfig_core_log_settings.h"
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+// A file is started anew once it grows beyond this, see writeFile()
+static const qint64 s_maxFileSize = 64 * 1024;
+
+static int defaultKind()
+{
+    const QByteArray name = qgetenv("KCONFIG_NOTIFY_TRANSPORT");
+#if KCONFIG_USE_DBUS
+    if (name != "file") {
+        return KConfigNotifyTransport::DBus;
+    }
+#else
+    if (name == "dbus") {
+        qCWarning(KCONFIG_CORE_LOG) << "KConfig was built without D-Bus, notifications use files";
+    }
+#endif
+    return KConfigNotifyTransport::File;
+}
+
+static QAtomicInt s_kind = -1;
+
+KConfigNotifyTransport::Kind KConfigNotifyTransport::kind()
+{
+    int kind = s_kind.loadRelaxed();
+    if (kind < 0) {
+        kind = defaultKind();
+        s_kind.storeRelaxed(kind);
+    }
+    return Kind(kind);
+}
+
+void KConfigNotifyTransport::setKind(Kind kind)
+{
+    s_kind.storeRelaxed(kind);
+}
+
+QString KConfigNotifyTransport::filePath(const QString &path)
+{
+    // one flat directory, the path is a D-Bus object path like "/kdeglobals"
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + QLatin1String("/kconfig-notify/")
+        + QString::fromLatin1(path.toUtf8().toPercentEncoding());
+}
+
+void KConfigNotifyTransport::writeFile(const QHash<QString, QByteArrayList> &changes, const QString &path)
+{
+    // a line per group: the group and its keys, percent-encoded and separated by
+    // spaces, and an empty line at the end of the notification
+    QByteArray record;
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        record += it.key().toUtf8().toPercentEncoding();
+        for (const QByteArray &key : it.value()) {
+            record += ' ' + key.toPercentEncoding();
+        }
+        record += '\n';
+    }
+    record += '\n';
+
+    const QString fileName = filePath(path);
+    QDir().mkpath(QFileInfo(fileName).path());
+    QFile file(fileName);
+    // truncating rather than replacing the file keeps it the one being watched
+    const QIODevice::OpenMode mode = file.size() > s_maxFileSize ? QIODevice::WriteOnly | QIODevice::Truncate : QIODevice::Append;
+    // a single write, so that notifications of several processes don't interleave
+    if (!file.open(mode) || file.write(record) != record.size()) {
+        qCWarning(KCONFIG_CORE_LOG) << "Couldn't write the change notification to" << fileName << file.errorString();
+    }
+}
+
+QList<QHash<QString, QByteArrayList>> KConfigNotifyTransport::readRecords(const QByteArray &data, qsizetype *consumed)
+{
+    QList<QHash<QString, QByteArrayList>> records;
+    QHash<QString, QByteArrayList> record;
+    *consumed = 0;
+    qsizetype start = 0;
+    for (qsizetype end = data.indexOf('\n'); end >= 0; start = end + 1, end = data.indexOf('\n', start)) {
+        const QByteArrayView line = QByteArrayView(data).sliced(start, end - start);
+        if (line.isEmpty()) {
+            records.append(std::move(record));
+            record.clear();
+            *consumed = end + 1;
+            continue;
+        }
+        const QByteArrayList fields = line.toByteArray().split(' ');
+        QByteArrayList &keys = record[QString::fromUtf8(QByteArray::fromPercentEncoding(fields.first()))];
+        for (qsizetype i = 1; i < fields.size(); ++i) {
+            keys.append(QByteArray::fromPercentEncoding(fields.at(i)));
+        }
+    }
+    return records;
+}
+
+QHash<QString, QByteArrayList> KConfigNotifyTransport::changedKeys(const QHash<QString, QByteArrayList> &values)
+{
+    QHash<QString, QByteArrayList> changes;
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        QByteArrayList &keys = changes[it.key()];
+        for (qsizetype i = 0; i + 1 < it.value().size(); i += 2) {
+            keys.append(it.value().at(i));
+        }
+    }
+    return changes;
+}
@@ -0,0 +1,78 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGNOTIFY_P_H
+#define KCONFIGNOTIFY_P_H
+
+#include <kconfigcore_export.h>
+
+#include <QByteArrayList>
+#include <QHash>
+#include <QString>
+
+/**
+ * How the ConfigChanged notifications of KConfig::Notify reach the
+ * KConfigWatchers of other processes.
+ *
+ * With D-Bus they are signals on the session bus. Without a bus they are
+ * appended to a file per notified path in the runtime directory, which the
+ * watchers of that path watch. Both carry the same changes: the changed
+ * keys of each group.
+ *
+ * With KConfigNotifications::setIncludeValues(), a ConfigValuesChanged signal
+ * goes on the bus right before ConfigChanged. It holds the new values as well,
+ * as a list of pairs of a key and its value for each group. A value starts
+ * with '=', or with '$' if it undergoes dollar expansion, and is just "-"
+ * when the entry can't be applied from the signal, e.g. because it was
+ * deleted or written localized. The File transport doesn't carry values.
+ *
+ * @internal
+ */
+namespace KConfigNotifyTransport
+{
+enum Kind {
+    DBus,
+    File,
+};
+
+/**
+ * The transport used by this process. KCONFIG_NOTIFY_TRANSPORT=file or
+ * =dbus picks one; the default is D-Bus if KConfig was built with it.
+ * Senders and watchers have to use the same transport.
+ */
+KCONFIGCORE_EXPORT Kind kind();
+
+/**
+ * Changes the transport, for tests. Watchers already created keep theirs.
+ */
+KCONFIGCORE_EXPORT void setKind(Kind kind);
+
+/**
+ * The file the File transport uses for the notifications of @p path.
+ */
+KCONFIGCORE_EXPORT QString filePath(const QString &path);
+
+/**
+ * Appends @p changes as a single notification to the file of @p path.
+ */
+KCONFIGCORE_EXPORT void writeFile(const QHash<QString, QByteArrayList> &changes, const QString &path);
+
+/**
+ * The notifications in @p data, as written by writeFile(). @p consumed
+ * is set to the length of the complete ones, a partly written one is left
+ * for the next read.
+ */
+KCONFIGCORE_EXPORT QList<QHash<QString, QByteArrayList>> readRecords(const QByteArray &data, qsizetype *consumed);
+
+/**
+ * The changed keys of each group in the @p values of a ConfigValuesChanged
+ * signal, the same as the ConfigChanged signal following it holds.
+ */
+KCONFIGCORE_EXPORT QHash<QString, QByteArrayList> changedKeys(const QHash<QString, QByteArrayList> &values);
+}
+
+#endif // KCONFIGNOTIFY_P_H
@@ -0,0 +1,274 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kconfigparsecache_p.h"
+
+#include "kconfig_core_log_settings.h"
+#include "kconfigdata_p.h"
+#include "kconfigstringpool_p.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <qplatformdefs.h>
+
+#include <cstring>
+
+// bumped whenever the layout below changes
+static constexpr char s_magic[8] = {'K', 'C', 'F', 'G', 'P', 'C', '0', '1'};
+static constexpr quint32 s_nullSize = 0xffffffff;
+
+// The records following the magic and the stamp
+enum RecordType : quint8 {
+    GroupRecord = 1, // the name of the group the following entries are in
+    EntryRecord = 2,
+};
+
+enum EntryFlag : quint16 {
+    Localized = 0x1,
+    Default = 0x2,
+    Raw = 0x4,
+    Global = 0x8,
+    Immutable = 0x10,
+    Deleted = 0x20,
+    Expand = 0x40,
+    LocalizedCountry = 0x80,
+    OverridesGlobal = 0x100,
+    Escaped = 0x200,
+    SharesDefault = 0x400,
+    Binary = 0x800,
+};
+
+template<typename T>
+static void appendPod(QByteArray &out, T value)
+{
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static void appendBytes(QByteArray &out, QByteArrayView bytes, bool isNull = false)
+{
+    appendPod<quint32>(out, isNull ? s_nullSize : quint32(bytes.size()));
+    out.append(bytes);
+}
+
+namespace
+{
+// Reads what the append functions wrote, any read past the end makes it invalid
+struct Reader {
+    const char *pos;
+    const char *end;
+    bool valid = true;
+
+    template<typename T>
+    T pod()
+    {
+        T value{};
+        if (end - pos < qptrdiff(sizeof(T))) {
+            valid = false;
+            return value;
+        }
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+    // sets @p isNull if the bytes were written as null
+    QByteArrayView bytes(bool *isNull = nullptr)
+    {
+        const quint32 size = pod<quint32>();
+        if (isNull) {
+            *isNull = size == s_nullSize;
+        }
+        if (size == s_nullSize || !valid) {
+            return {};
+        }
+        if (quint32(end - pos) < size) {
+            valid = false;
+            return {};
+        }
+        const QByteArrayView bytes(pos, size);
+        pos += size;
+        return bytes;
+    }
+};
+}
+
+static QByteArray internValue(QByteArrayView value)
+{
+    if (value.size() <= KEntryValue::InlineCapacity) {
+        // stored inline, no need for a copy
+        return QByteArray::fromRawData(value.data(), value.size());
+    }
+    return value.size() <= KConfigStringPool::maxValueSize ? KConfigStringPool::intern(value) : value.toByteArray();
+}
+
+KConfigParseCache::Sources KConfigParseCache::sources(const QStringList &files, const QByteArray &locale)
+{
+    Sources sources;
+    if (qEnvironmentVariableIsSet("KCONFIG_DISABLE_PARSE_CACHE")) {
+        return sources;
+    }
+
+    QString dir;
+    if (QStandardPaths::isTestModeEnabled() || !qEnvironmentVariableIsSet("XDG_RUNTIME_DIR")) {
+        dir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    } else {
+        // shared by the session, and gone with it
+        dir = qEnvironmentVariable("XDG_RUNTIME_DIR");
+    }
+    if (dir.isEmpty()) {
+        return sources;
+    }
+
+    QCryptographicHash name(QCryptographicHash::Sha1);
+    name.addData(locale);
+    appendBytes(sources.stamp, locale);
+    appendPod<quint32>(sources.stamp, files.size());
+    for (const QString &file : files) {
+        const QByteArray path = QFile::encodeName(file);
+        name.addData(QByteArrayView("\0", 1));
+        name.addData(path);
+        appendBytes(sources.stamp, path);
+
+        const QFileInfo info(file);
+        appendPod<qint64>(sources.stamp, info.exists() ? info.size() : -1);
+        appendPod<qint64>(sources.stamp, info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0);
+        quint64 inode = 0;
+#ifndef Q_OS_WIN
+        QT_STATBUF statBuf;
+        if (QT_STAT(path.constData(), &statBuf) == 0) {
+            inode = statBuf.st_ino;
+        }
+#endif
+        appendPod<quint64>(sources.stamp, inode);
+    }
+    sources.cacheFile = dir + QLatin1String("/kconfig-parsecache/") + QString::fromLatin1(name.result().toHex()) + QLatin1String(".cache");
+    return sources;
+}
+
+bool KConfigParseCache::load(const Sources &sources, KEntryMap &entryMap)
+{
+    Q_ASSERT(entryMap.isEmpty());
+    if (sources.cacheFile.isEmpty()) {
+        return false;
+    }
+
+    QFile file(sources.cacheFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const qint64 size = file.size();
+    const uchar *data = file.map(0, size);
+    if (!data) {
+        return false;
+    }
+
+    Reader reader{reinterpret_cast<const char *>(data), reinterpret_cast<const char *>(data) + size};
+    const QByteArrayView magic(reader.pos, qMin<qint64>(size, sizeof(s_magic)));
+    if (magic != QByteArrayView(s_magic, sizeof(s_magic))) {
+        return false;
+    }
+    reader.pos += sizeof(s_magic);
+    if (reader.bytes() != sources.stamp || !reader.valid) {
+        return false; // a source file changed
+    }
+
+    QByteArray group;
+    while (reader.valid && reader.pos != reader.end) {
+        const auto type = reader.pod<quint8>();
+        if (type == GroupRecord) {
+            group = KConfigStringPool::intern(reader.bytes());
+            continue;
+        }
+        if (type != EntryRecord || group.isEmpty()) {
+            reader.valid = false;
+            break;
+        }
+
+        bool keyIsNull = false;
+        const QByteArrayView keyBytes = reader.bytes(&keyIsNull);
+        const auto flags = reader.pod<quint16>();
+        bool valueIsNull = false;
+        const QByteArrayView value = reader.bytes(&valueIsNull);
+        if (!reader.valid) {
+            break;
+        }
+
+        KEntryKey key(group, keyIsNull ? QByteArray() : KConfigStringPool::intern(keyBytes), flags & Localized, flags & Default);
+        key.bRaw = flags & Raw;
+        KEntry entry;
+        entry.bGlobal = flags & Global;
+        entry.bImmutable = flags & Immutable;
+        entry.bDeleted = flags & Deleted;
+        entry.bExpand = flags & Expand;
+        entry.bLocalizedCountry = flags & LocalizedCountry;
+        entry.bOverridesGlobal = flags & OverridesGlobal;
+        entry.bEscaped = flags & Escaped;
+        entry.bSharesDefault = flags & SharesDefault;
+        entry.bBinary = flags & Binary;
+        if (!valueIsNull) {
+            entry.setValue(internValue(value));
+        }
+        entryMap.insert(key, entry);
+    }
+
+    if (!reader.valid) {
+        qCWarning(KCONFIG_CORE_LOG) << "Ignoring the corrupt parse cache" << sources.cacheFile;
+        entryMap.clear();
+        return false;
+    }
+    return true;
+}
+
+void KConfigParseCache::store(const Sources &sources, const KEntryMap &entryMap)
+{
+    if (sources.cacheFile.isEmpty()) {
+        return;
+    }
+
+    QByteArray out(s_magic, sizeof(s_magic));
+    appendBytes(out, sources.stamp);
+
+    const QByteArray *group = nullptr;
+    for (auto it = entryMap.cbegin(); it != entryMap.cend(); ++it) {
+        const KEntryKey &key = it.key();
+        if (!group || *group != key.mGroup) {
+            group = &key.mGroup;
+            appendPod<quint8>(out, GroupRecord);
+            appendBytes(out, key.mGroup);
+        }
+
+        const KEntry &entry = *it;
+        quint16 flags = 0;
+        flags |= key.bLocal ? Localized : 0;
+        flags |= key.bDefault ? Default : 0;
+        flags |= key.bRaw ? Raw : 0;
+        flags |= entry.bGlobal ? Global : 0;
+        flags |= entry.bImmutable ? Immutable : 0;
+        flags |= entry.bDeleted ? Deleted : 0;
+        flags |= entry.bExpand ? Expand : 0;
+        flags |= entry.bLocalizedCountry ? LocalizedCountry : 0;
+        flags |= entry.bOverridesGlobal ? OverridesGlobal : 0;
+        flags |= entry.bEscaped ? Escaped : 0;
+        flags |= entry.bSharesDefault ? SharesDefault : 0;
+        flags |= entry.bBinary ? Binary : 0;
+
+        appendPod<quint8>(out, EntryRecord);
+        appendBytes(out, key.mKey, key.mKey.isNull());
+        appendPod<quint16>(out, flags);
+        appendBytes(out, entry.rawValue(), entry.isNull());
+    }
+
+    QDir().mkpath(QFileInfo(sources.cacheFile).absolutePath());
+    QSaveFile file(sources.cacheFile);
+    if (!file.open(QIODevice::WriteOnly) || file.write(out) != out.size() || !file.commit()) {
+        qCDebug(KCONFIG_CORE_LOG) << "Couldn't write the parse cache" << sources.cacheFile;
+    }
+}
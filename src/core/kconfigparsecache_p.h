@@ -0,0 +1,58 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGPARSECACHE_P_H
+#define KCONFIGPARSECACHE_P_H
+
+#include <QByteArray>
+#include <QStringList>
+
+#include <kconfigcore_export.h>
+
+class KEntryMap;
+
+/**
+ * Binary cache of parsed cascades shared by all processes of the session.
+ *
+ * Every process parses kdeglobals and the system wide defaults below it. The
+ * result of parsing such a cascade is stored in a file in $XDG_RUNTIME_DIR,
+ * which the other processes map and turn into entries without tokenizing
+ * or merging any text. A cache file records the size, modification time
+ * and inode of each of its source files and is ignored as soon as one of
+ * them changes. Setting KCONFIG_DISABLE_PARSE_CACHE turns it off.
+ *
+ * @internal
+ */
+namespace KConfigParseCache
+{
+/**
+ * The files of a cascade, as they are on disk right now
+ */
+struct Sources {
+    QString cacheFile; ///< where the result of parsing them is cached, empty if the cache is off
+    QByteArray stamp; ///< the locale and the path, size, modification time and inode of each file
+};
+
+/**
+ * Looks at @p files, to be parsed for @p locale. Do this before parsing them,
+ * so that changes made while parsing make the stored result stale.
+ */
+KCONFIGCORE_EXPORT Sources sources(const QStringList &files, const QByteArray &locale);
+
+/**
+ * Fills the empty @p entryMap with the cached result of parsing @p sources.
+ * Returns false if there is no up to date cache.
+ */
+KCONFIGCORE_EXPORT bool load(const Sources &sources, KEntryMap &entryMap);
+
+/**
+ * Stores @p entryMap as the result of parsing @p sources.
+ */
+KCONFIGCORE_EXPORT void store(const Sources &sources, const KEntryMap &entryMap);
+}
+
+#endif // KCONFIGPARSECACHE_P_H
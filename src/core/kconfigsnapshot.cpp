@@ -0,0 +1,233 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kconfigsnapshot.h"
+#include "kconfigsnapshot_p.h"
+
+#include "kconfig_p.h"
+
+#include <QHash>
+#include <QMutex>
+
+#include <memory>
+#include <set>
+
+namespace
+{
+// The snapshots handed out by KConfigSnapshot::open()
+struct SharedSnapshots {
+    struct Slot {
+        QString fileName;
+        // held while the file is parsed, so that the other threads wait for it
+        QMutex mutex;
+        KConfigSnapshot snapshot;
+    };
+
+    QMutex mutex;
+    QHash<QString, std::shared_ptr<Slot>> slots;
+    // held by update() while it changes a file, kept when the slots are forgotten
+    QHash<QString, std::shared_ptr<QMutex>> writers;
+};
+}
+
+Q_GLOBAL_STATIC(SharedSnapshots, s_sharedSnapshots)
+
+KConfigSnapshotPrivate::KConfigSnapshotPrivate(const QString &name, const KEntryMap &entries, bool readDefaults)
+    : name(name)
+    , entries(entries)
+    , searchFlags(readDefaults ? KEntryMap::SearchLocalized | KEntryMap::SearchDefaults : KEntryMap::SearchFlags(KEntryMap::SearchLocalized))
+{
+    for (auto it = this->entries.cbegin(); it != this->entries.cend(); ++it) {
+        it->value();
+    }
+}
+
+void KConfigSnapshotPrivate::forgetShared(const QString &fileName)
+{
+    if (!s_sharedSnapshots.exists()) {
+        return;
+    }
+    SharedSnapshots &shared = *s_sharedSnapshots;
+    QMutexLocker locker(&shared.mutex);
+    for (auto it = shared.slots.begin(); it != shared.slots.end();) {
+        if (it.value()->fileName == fileName) {
+            it = shared.slots.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+qint64 KConfigSnapshotPrivate::trimShared()
+{
+    if (!s_sharedSnapshots.exists()) {
+        return 0;
+    }
+    QHash<QString, std::shared_ptr<SharedSnapshots::Slot>> slots;
+    {
+        SharedSnapshots &shared = *s_sharedSnapshots;
+        QMutexLocker locker(&shared.mutex);
+        slots.swap(shared.slots);
+    }
+
+    qint64 freed = 0;
+    for (const std::shared_ptr<SharedSnapshots::Slot> &slot : std::as_const(slots)) {
+        // a slot that is being parsed is still in use
+        if (!slot->mutex.tryLock()) {
+            continue;
+        }
+        const KConfigSnapshotPrivate *d = slot->snapshot.d.data();
+        if (d && d->ref.loadRelaxed() == 1) {
+            const KEntryMap::MemoryUsage usage = d->entries.memoryUsage();
+            freed += usage.keyBytes + usage.valueBytes + usage.structureBytes;
+        }
+        slot->mutex.unlock();
+    }
+    return freed;
+}
+
+KConfigSnapshot::KConfigSnapshot() = default;
+
+KConfigSnapshot::KConfigSnapshot(KConfigSnapshotPrivate *dd)
+    : d(dd)
+{
+}
+
+KConfigSnapshot::KConfigSnapshot(const KConfigSnapshot &other) = default;
+
+KConfigSnapshot &KConfigSnapshot::operator=(const KConfigSnapshot &other) = default;
+
+KConfigSnapshot::~KConfigSnapshot() = default;
+
+static QString sharedKey(const QString &fileName, KConfig::OpenFlags mode, QStandardPaths::StandardLocation type)
+{
+    return QString::number(mode) + QLatin1Char(':') + QString::number(type) + QLatin1Char(':') + fileName;
+}
+
+KConfigSnapshot KConfigSnapshot::open(const QString &fileName, KConfig::OpenFlags mode, QStandardPaths::StandardLocation type)
+{
+    const QString key = sharedKey(fileName, mode, type);
+
+    std::shared_ptr<SharedSnapshots::Slot> slot;
+    {
+        SharedSnapshots &shared = *s_sharedSnapshots;
+        QMutexLocker locker(&shared.mutex);
+        std::shared_ptr<SharedSnapshots::Slot> &existing = shared.slots[key];
+        if (!existing) {
+            existing = std::make_shared<SharedSnapshots::Slot>();
+            existing->fileName = fileName;
+        }
+        slot = existing;
+    }
+
+    QMutexLocker locker(&slot->mutex);
+    if (slot->snapshot.isNull()) {
+        const KConfig config(fileName, mode, type);
+        slot->snapshot = config.snapshot();
+    }
+    return slot->snapshot;
+}
+
+bool KConfigSnapshot::update(const QString &fileName,
+                             const std::function<void(KConfig &config)> &change,
+                             KConfig::OpenFlags mode,
+                             QStandardPaths::StandardLocation type)
+{
+    const QString key = sharedKey(fileName, mode, type);
+    SharedSnapshots &shared = *s_sharedSnapshots;
+    std::shared_ptr<QMutex> writer;
+    {
+        QMutexLocker locker(&shared.mutex);
+        std::shared_ptr<QMutex> &existing = shared.writers[fileName];
+        if (!existing) {
+            existing = std::make_shared<QMutex>();
+        }
+        writer = existing;
+    }
+
+    QMutexLocker writeLocker(writer.get());
+    KConfig config(fileName, mode, type);
+    change(config);
+    // sync() makes open() forget the snapshots of the file
+    if (!config.sync()) {
+        return false;
+    }
+
+    auto slot = std::make_shared<SharedSnapshots::Slot>();
+    slot->fileName = fileName;
+    slot->snapshot = config.snapshot();
+    QMutexLocker locker(&shared.mutex);
+    shared.slots.insert(key, slot);
+    return true;
+}
+
+bool KConfigSnapshot::isNull() const
+{
+    return !d;
+}
+
+QString KConfigSnapshot::name() const
+{
+    return d ? d->name : QString();
+}
+
+QStringList KConfigSnapshot::groupList() const
+{
+    QStringList groups;
+    if (!d) {
+        return groups;
+    }
+    const QList<QByteArrayView> names = d->entries.subGroupNames({});
+    for (QByteArrayView group : names) {
+        if (!group.isEmpty() && group != "<default>" && group != "$Version") {
+            groups.append(QString::fromUtf8(group));
+        }
+    }
+    return groups;
+}
+
+bool KConfigSnapshot::hasGroup(const QString &group) const
+{
+    return d && d->entries.hasNonDeletedEntries(group.toUtf8());
+}
+
+QStringList KConfigSnapshot::keyList(const QString &group) const
+{
+    if (!d) {
+        return QStringList();
+    }
+    const QByteArray theGroup = group.toUtf8();
+    std::set<QString> keys; // unique set, sorted
+    const auto theEnd = d->entries.constEnd();
+    for (auto it = d->entries.constFindEntry(theGroup); it != theEnd && it.key().mGroup == theGroup; ++it) {
+        if (!it.key().mKey.isNull() && !it->bDeleted) {
+            keys.insert(QString::fromUtf8(it.key().mKey));
+        }
+    }
+    return QStringList(keys.begin(), keys.end());
+}
+
+bool KConfigSnapshot::hasKey(const QString &group, const char *key) const
+{
+    return d && d->entries.hasEntry(group.toUtf8(), key, d->searchFlags);
+}
+
+QString KConfigSnapshot::readEntry(const QString &group, const char *key, const QString &aDefault) const
+{
+    if (!d) {
+        return aDefault;
+    }
+    bool expand = false;
+    QString aValue = d->entries.getEntry(group.toUtf8(), key, QString(), d->searchFlags, &expand);
+    if (aValue.isNull()) {
+        aValue = aDefault;
+    }
+    if (expand) {
+        return KConfigPrivate::expandString(aValue);
+    }
+    return aValue;
+}
@@ -0,0 +1,134 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGSNAPSHOT_H
+#define KCONFIGSNAPSHOT_H
+
+#include <KConfig>
+
+#include <kconfigcore_export.h>
+
+#include <QExplicitlySharedDataPointer>
+#include <QStringList>
+
+#include <functional>
+
+class KConfigSnapshotPrivate;
+
+/**
+ * \class KConfigSnapshot kconfigsnapshot.h <KConfigSnapshot>
+ *
+ * An immutable copy of the entries of a config, which any number of threads
+ * may read at the same time.
+ *
+ * A KConfig, and therefore KSharedConfig, may only be used by one thread at a
+ * time. A snapshot never changes once it has been taken, so reading it needs
+ * no locking and copies of it are cheap to pass between threads. Take one with
+ * KConfig::snapshot(), or share one parse of a file between all threads with
+ * open():
+ *
+ * @code
+ * // in each worker thread
+ * const KConfigSnapshot config = KConfigSnapshot::open(QStringLiteral("indexerrc"));
+ * const QString folders = config.readEntry(QStringLiteral("General"), "Folders");
+ * @endcode
+ *
+ * Such a shared config is changed with update(), which serializes the
+ * changes of all threads and publishes the result as a new snapshot.
+ *
+ * The names of nested groups are joined with '\\x1d', as in KConfigIniReader.
+ *
+ * @since 6.1
+ */
+class KCONFIGCORE_EXPORT KConfigSnapshot
+{
+public:
+    /**
+     * Constructs a null snapshot, without any entries.
+     */
+    KConfigSnapshot();
+    KConfigSnapshot(const KConfigSnapshot &other);
+    KConfigSnapshot &operator=(const KConfigSnapshot &other);
+    ~KConfigSnapshot();
+
+    /**
+     * Returns a snapshot of the config opened with the given arguments, see KConfig::KConfig().
+     *
+     * The file is only parsed by the first call, all the later ones from any
+     * thread return the same snapshot. KConfig::sync() of a config with the
+     * same name in this process makes the next call parse the file again.
+     * To see changes made by other processes, take a new KConfig::snapshot().
+     */
+    static KConfigSnapshot open(const QString &fileName,
+                                KConfig::OpenFlags mode = KConfig::FullConfig,
+                                QStandardPaths::StandardLocation type = QStandardPaths::GenericConfigLocation);
+
+    /**
+     * Changes the config opened with the given arguments from any thread, and
+     * publishes a snapshot of the result for open() to return.
+     *
+     * The updates of a file are serialized: @p change is called with a config
+     * of its own, in the calling thread, once the previous update of the file
+     * in this process is written. The config is then synced, and the
+     * following open() calls return a snapshot of it instead of parsing the
+     * file again. Snapshots taken before stay as they were.
+     *
+     * @code
+     * KConfigSnapshot::update(QStringLiteral("indexerrc"), [&folders](KConfig &config) {
+     *     config.group(QStringLiteral("General")).writeEntry("Folders", folders);
+     * });
+     * @endcode
+     *
+     * Returns false if the config could not be written, see KConfig::sync().
+     *
+     * @since 6.1
+     */
+    static bool update(const QString &fileName,
+                       const std::function<void(KConfig &config)> &change,
+                       KConfig::OpenFlags mode = KConfig::FullConfig,
+                       QStandardPaths::StandardLocation type = QStandardPaths::GenericConfigLocation);
+
+    /**
+     * Whether this snapshot was default constructed.
+     */
+    bool isNull() const;
+
+    /**
+     * The name of the config the snapshot was taken of, see KConfig::name().
+     */
+    QString name() const;
+
+    /**
+     * The top level groups, see KConfig::groupList().
+     */
+    QStringList groupList() const;
+    /**
+     * Whether @p group has any entries that aren't deleted.
+     */
+    bool hasGroup(const QString &group) const;
+    /**
+     * The keys of @p group, see KConfigGroup::keyList().
+     */
+    QStringList keyList(const QString &group) const;
+    /**
+     * Whether @p group has an entry @p key that isn't deleted.
+     */
+    bool hasKey(const QString &group, const char *key) const;
+
+    /**
+     * Reads the value of @p key in @p group, like KConfigGroup::readEntry() does.
+     */
+    QString readEntry(const QString &group, const char *key, const QString &aDefault = QString()) const;
+
+private:
+    friend class KConfig;
+    friend class KConfigSnapshotPrivate;
+    explicit KConfigSnapshot(KConfigSnapshotPrivate *dd);
+    QExplicitlySharedDataPointer<KConfigSnapshotPrivate> d;
+};
+
+#endif // KCONFIGSNAPSHOT_H
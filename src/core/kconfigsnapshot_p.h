@@ -0,0 +1,32 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGSNAPSHOT_P_H
+#define KCONFIGSNAPSHOT_P_H
+
+#include "kconfigdata_p.h"
+
+#include <QSharedData>
+
+class KConfigSnapshotPrivate : public QSharedData
+{
+public:
+    // Decodes all of @p entries, so that reading them doesn't modify them anymore
+    KConfigSnapshotPrivate(const QString &name, const KEntryMap &entries, bool readDefaults);
+
+    // Makes KConfigSnapshot::open() parse @p fileName again, called by KConfig::sync()
+    static void forgetShared(const QString &fileName);
+    // Drops all the snapshots of KConfigSnapshot::open(), see KConfig::trimCaches().
+    // Returns an estimate of the bytes freed by those no one else holds.
+    static qint64 trimShared();
+
+    const QString name;
+    const KEntryMap entries;
+    const KEntryMap::SearchFlags searchFlags;
+};
+
+#endif // KCONFIGSNAPSHOT_P_H
@@ -0,0 +1,95 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kconfigstringpool_p.h"
+
+#include <QMutex>
+#include <QSet>
+
+namespace
+{
+struct Pool {
+    QMutex mutex;
+    QSet<QByteArray> strings;
+    // size of the pool after the last purge
+    qsizetype purgedSize = 0;
+    KConfigStringPool::Statistics statistics;
+
+    // Drops the strings only the pool still references, returns their size
+    qint64 purge()
+    {
+        qint64 freed = 0;
+        for (auto it = strings.begin(); it != strings.end();) {
+            if (it->isDetached()) {
+                freed += it->capacity();
+                it = strings.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        purgedSize = strings.size();
+        return freed;
+    }
+};
+}
+
+Q_GLOBAL_STATIC(Pool, s_pool)
+
+QByteArray KConfigStringPool::intern(QByteArrayView data)
+{
+    if (data.isEmpty()) {
+        return data.toByteArray();
+    }
+
+    // no copy needed to look it up
+    const QByteArray key = QByteArray::fromRawData(data.data(), data.size());
+
+    Pool &pool = *s_pool;
+    QMutexLocker locker(&pool.mutex);
+    const auto it = pool.strings.constFind(key);
+    if (it != pool.strings.constEnd()) {
+        ++pool.statistics.hits;
+        pool.statistics.bytesSaved += data.size();
+        return *it;
+    }
+
+    if (pool.strings.size() >= qMax<qsizetype>(4096, 2 * pool.purgedSize)) {
+        pool.purge();
+    }
+
+    ++pool.statistics.misses;
+    const QByteArray string = data.toByteArray();
+    pool.strings.insert(string);
+    return string;
+}
+
+KConfigStringPool::Statistics KConfigStringPool::statistics()
+{
+    Pool &pool = *s_pool;
+    QMutexLocker locker(&pool.mutex);
+    Statistics statistics = pool.statistics;
+    statistics.size = pool.strings.size();
+    return statistics;
+}
+
+qint64 KConfigStringPool::trim()
+{
+    Pool &pool = *s_pool;
+    QMutexLocker locker(&pool.mutex);
+    const qint64 freed = pool.purge();
+    pool.strings.squeeze();
+    return freed;
+}
+
+QDebug operator<<(QDebug dbg, const KConfigStringPool::Statistics &statistics)
+{
+    QDebugStateSaver saver(dbg);
+    const qint64 lookups = statistics.hits + statistics.misses;
+    dbg.nospace() << "KConfigStringPool(" << statistics.size << " strings, hit rate " << (lookups ? 100.0 * statistics.hits / lookups : 0.0) << "%, "
+                  << statistics.bytesSaved << " bytes saved)";
+    return dbg;
+}
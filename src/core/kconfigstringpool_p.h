@@ -0,0 +1,59 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGSTRINGPOOL_P_H
+#define KCONFIGSTRINGPOOL_P_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QDebug>
+
+#include <kconfigcore_export.h>
+
+/**
+ * Process-wide pool of the group names, keys and short values read from config files.
+ *
+ * The same keys and values repeat across all the config files a process reads, so
+ * handing out shared copies of them saves a lot of memory. The pool is thread-safe.
+ * Strings that aren't used anymore outside of the pool are dropped from time to time.
+ *
+ * @internal
+ */
+namespace KConfigStringPool
+{
+/**
+ * Values longer than this aren't interned, they rarely repeat
+ */
+constexpr qsizetype maxValueSize = 256;
+
+/**
+ * Returns a shared copy of @p data
+ */
+QByteArray intern(QByteArrayView data);
+
+struct Statistics {
+    qint64 hits = 0; ///< strings that were already in the pool
+    qint64 misses = 0; ///< strings that had to be added to the pool
+    qint64 bytesSaved = 0; ///< bytes not allocated thanks to the hits
+    qsizetype size = 0; ///< number of strings in the pool
+};
+
+/**
+ * For debugging: how effective the pool is
+ */
+KCONFIGCORE_EXPORT Statistics statistics();
+
+/**
+ * Drops the strings only the pool still references, see KConfig::trimCaches().
+ * Returns the number of bytes freed.
+ */
+qint64 trim();
+}
+
+KCONFIGCORE_EXPORT QDebug operator<<(QDebug dbg, const KConfigStringPool::Statistics &statistics);
+
+#endif // KCONFIGSTRINGPOOL_P_H
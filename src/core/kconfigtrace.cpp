@@ -0,0 +1,277 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kconfigtrace_p.h"
+
+#include "config-kconfig.h"
+#include "kconfig_core_log_settings.h"
+#include "kconfig_trace_log_settings.h"
+
+#include <QCoreApplication>
+#if KCONFIG_USE_DBUS
+#include <QDBusConnection>
+#include <QDBusMessage>
+#endif
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+
+#if HAVE_EXECINFO_H
+#include <dlfcn.h>
+#include <execinfo.h>
+#endif
+#include <stdio.h> // stderr, for KCONFIG_ACCESS_PROFILE=-
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+static std::atomic<quint64> s_counters[KConfigTrace::CounterCount];
+
+static bool enabledByEnvironment()
+{
+    if (!qEnvironmentVariableIsSet("KCONFIG_TRACE")) {
+        return false;
+    }
+    KCONFIG_TRACE_LOG().setEnabled(QtDebugMsg, true);
+    return true;
+}
+
+std::atomic<bool> KConfigTrace::s_enabled{enabledByEnvironment()};
+
+static const bool s_tracingChanges = qEnvironmentVariableIsSet("KCONFIG_TRACE");
+static thread_local QString s_currentChange;
+
+void KConfigTrace::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void KConfigTrace::add(Counter counter, quint64 value)
+{
+    s_counters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+quint64 KConfigTrace::value(Counter counter)
+{
+    return s_counters[counter].load(std::memory_order_relaxed);
+}
+
+void KConfigTrace::reset()
+{
+    for (std::atomic<quint64> &counter : s_counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool KConfigTrace::isTracingChanges()
+{
+    return s_tracingChanges;
+}
+
+QString KConfigTrace::currentChange()
+{
+    return s_currentChange;
+}
+
+QString KConfigTrace::currentOrNewChange()
+{
+    if (!s_tracingChanges) {
+        return QString();
+    }
+    if (!s_currentChange.isEmpty()) {
+        return s_currentChange;
+    }
+    // unique in the session as long as the pid is
+    static std::atomic<quint64> s_lastChange{0};
+    return QStringLiteral("%1-%2").arg(QCoreApplication::applicationPid()).arg(++s_lastChange);
+}
+
+KConfigTrace::ChangeScope::ChangeScope(const QString &change)
+    : m_active(!change.isEmpty())
+{
+    if (m_active) {
+        m_previous = std::exchange(s_currentChange, change);
+    }
+}
+
+KConfigTrace::ChangeScope::~ChangeScope()
+{
+    if (m_active) {
+        s_currentChange = m_previous;
+    }
+}
+
+// Sends the span of a change to kconfigtrace6, with the wall clock time it started at
+static void broadcast(const QString &change, const char *name, const QString &file, qint64 nsecs)
+{
+#if KCONFIG_USE_DBUS
+    using namespace std::chrono;
+    const qint64 end = duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+    QDBusMessage message = QDBusMessage::createSignal(QStringLiteral("/KConfigTrace"), QStringLiteral("org.kde.kconfig.trace"), QStringLiteral("Span"));
+    message.setArguments({change,
+                          QString::fromLatin1(name),
+                          file,
+                          QCoreApplication::applicationName(),
+                          QCoreApplication::applicationPid(),
+                          end - nsecs / 1000,
+                          nsecs / 1000});
+    QDBusConnection::sessionBus().send(message);
+#else
+    Q_UNUSED(change);
+    Q_UNUSED(name);
+    Q_UNUSED(file);
+    Q_UNUSED(nsecs);
+#endif
+}
+
+void KConfigTrace::Span::finish()
+{
+    const qint64 elapsed = m_timer.nsecsElapsed();
+    if (m_counter != CounterCount) {
+        add(m_counter, elapsed);
+    }
+    const QString change = s_tracingChanges ? s_currentChange : QString();
+    if (change.isEmpty()) {
+        qCDebug(KCONFIG_TRACE_LOG) << m_name << m_file << "took" << elapsed / 1000 << "us";
+        return;
+    }
+    qCDebug(KCONFIG_TRACE_LOG) << m_name << m_file << "of change" << change << "took" << elapsed / 1000 << "us";
+    broadcast(change, m_name, m_file, elapsed);
+}
+
+const bool KConfigTrace::s_profilingAccess = qEnvironmentVariableIsSet("KCONFIG_ACCESS_PROFILE");
+
+namespace
+{
+struct AccessKey {
+    QString file;
+    QByteArray group;
+    QByteArray key;
+    KConfigTrace::Access access;
+    QString module;
+
+    bool operator==(const AccessKey &other) const
+    {
+        return access == other.access && key == other.key && group == other.group && file == other.file && module == other.module;
+    }
+};
+
+size_t qHash(const AccessKey &key, size_t seed = 0)
+{
+    return qHashMulti(seed, key.file, key.group, key.key, int(key.access), key.module);
+}
+
+// Writes the report when it's destroyed at exit
+struct AccessProfile {
+    ~AccessProfile();
+
+    QMutex mutex;
+    QHash<AccessKey, quint64> counts;
+};
+}
+
+Q_GLOBAL_STATIC(AccessProfile, s_accessProfile)
+
+static const quint64 s_profileInterval = std::max(1, qEnvironmentVariableIntValue("KCONFIG_ACCESS_PROFILE_INTERVAL"));
+
+// The file name of the first module up the stack that isn't this library, empty if it can't be told
+static QString callerModule()
+{
+#if HAVE_EXECINFO_H
+    Dl_info self;
+    if (!dladdr(reinterpret_cast<void *>(&callerModule), &self)) {
+        return QString();
+    }
+    void *frames[64];
+    const int depth = backtrace(frames, int(std::size(frames)));
+    for (int i = 1; i < depth; ++i) {
+        Dl_info info;
+        if (dladdr(frames[i], &info) && info.dli_fname && info.dli_fbase != self.dli_fbase) {
+            const char *name = strrchr(info.dli_fname, '/');
+            return QFile::decodeName(name ? name + 1 : info.dli_fname);
+        }
+    }
+#endif
+    return QString();
+}
+
+void KConfigTrace::recordAccess(const QString &file, const QByteArray &group, const char *key, Access access)
+{
+    static thread_local quint64 s_sinceSample = 0;
+    if (++s_sinceSample < s_profileInterval) {
+        return;
+    }
+    s_sinceSample = 0;
+
+    AccessKey accessKey{file, group, QByteArray(key), access, callerModule()};
+    AccessProfile *profile = s_accessProfile();
+    if (!profile) { // accessed while exiting, after the report
+        return;
+    }
+    QMutexLocker locker(&profile->mutex);
+    ++profile->counts[accessKey];
+}
+
+AccessProfile::~AccessProfile()
+{
+    using Count = std::pair<const AccessKey *, quint64>;
+    std::vector<Count> sorted;
+    sorted.reserve(counts.size());
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        sorted.emplace_back(&it.key(), it.value());
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Count &a, const Count &b) {
+        if (a.second != b.second) {
+            return a.second > b.second;
+        }
+        return std::tie(a.first->file, a.first->group, a.first->key) < std::tie(b.first->file, b.first->group, b.first->key);
+    });
+
+    QJsonArray accesses;
+    for (const auto &[key, count] : sorted) {
+        QJsonArray group;
+        // nested groups are joined with \x1d, see KConfigGroupPrivate::fullName()
+        for (const QByteArray &name : key->group.split('\x1d')) {
+            group.append(QString::fromUtf8(name));
+        }
+        accesses.append(QJsonObject{
+            {QStringLiteral("count"), qint64(count)},
+            {QStringLiteral("operation"), key->access == KConfigTrace::Access::Read ? QStringLiteral("read") : QStringLiteral("write")},
+            {QStringLiteral("file"), key->file},
+            {QStringLiteral("group"), group},
+            {QStringLiteral("key"), QString::fromUtf8(key->key)},
+            {QStringLiteral("module"), key->module},
+        });
+    }
+    const QByteArray report = QJsonDocument(QJsonObject{
+                                                {QStringLiteral("pid"), qint64(QCoreApplication::applicationPid())},
+                                                {QStringLiteral("interval"), qint64(s_profileInterval)},
+                                                {QStringLiteral("accesses"), accesses},
+                                            })
+                                  .toJson();
+
+    const QString path = qEnvironmentVariable("KCONFIG_ACCESS_PROFILE");
+    QFile out;
+    bool opened;
+    if (path == QLatin1String("-")) {
+        opened = out.open(stderr, QIODevice::WriteOnly);
+    } else {
+        out.setFileName(QString(path).replace(QLatin1String("%p"), QString::number(QCoreApplication::applicationPid())));
+        opened = out.open(QIODevice::WriteOnly);
+    }
+    if (!opened || out.write(report) != report.size()) {
+        qCWarning(KCONFIG_CORE_LOG) << "Couldn't write the access profile to" << out.fileName();
+    }
+}
@@ -0,0 +1,184 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGTRACE_P_H
+#define KCONFIGTRACE_P_H
+
+#include <QElapsedTimer>
+#include <QString>
+
+#include <atomic>
+
+/**
+ * The counters behind KConfig::statistics() and the spans logged to the
+ * kf.config.core.trace category.
+ *
+ * Nothing is counted unless KCONFIG_TRACE is set in the environment or
+ * KConfig::setStatisticsEnabled() was called, then the hot paths only pay
+ * for a relaxed load of a flag. KCONFIG_TRACE also turns on the debug
+ * output of the category, which logs how long each span took.
+ *
+ * With KCONFIG_TRACE, the spans of a change to a config also carry the id of
+ * that change, from saving a KCoreConfigSkeleton and syncing to the reparse
+ * and reload in the processes notified of it. They are then broadcast on the
+ * session bus as well, where kconfigtrace6 collects them.
+ *
+ * Apart from those, KCONFIG_ACCESS_PROFILE=<file> counts which keys are read
+ * and written, how often and by which module, and writes the counts to
+ * <file> at exit, see recordAccess().
+ *
+ * @internal
+ */
+namespace KConfigTrace
+{
+enum Counter {
+    FilesParsed,
+    BytesRead,
+    ParseTime,
+    WriteTime,
+    GlobalParseHits,
+    GlobalParseMisses,
+    Lookups,
+    Conversions,
+    Syncs,
+    LockWaitTime,
+    LockContentions,
+    WriteConflicts,
+    NotificationsSent,
+    NotificationsReceived,
+    CounterCount,
+};
+
+extern std::atomic<bool> s_enabled;
+
+inline bool isEnabled()
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool enabled);
+
+// Adds @p value to @p counter, whether counting is on or not
+void add(Counter counter, quint64 value);
+quint64 value(Counter counter);
+void reset();
+
+inline void count(Counter counter, quint64 value = 1)
+{
+    if (isEnabled()) {
+        add(counter, value);
+    }
+}
+
+// Whether the spans of changes are broadcast, i.e. KCONFIG_TRACE is set
+bool isTracingChanges();
+
+// The id of the change made or received in this thread, empty if there is none
+QString currentChange();
+// The current change, or a new one if there is none, empty unless isTracingChanges()
+QString currentOrNewChange();
+
+/**
+ * Makes @p change the current change of the thread until it goes out of
+ * scope, so that the spans in between are part of it. Does nothing if
+ * @p change is empty.
+ */
+class ChangeScope
+{
+public:
+    explicit ChangeScope(const QString &change);
+    ~ChangeScope();
+
+private:
+    Q_DISABLE_COPY(ChangeScope)
+
+    bool m_active;
+    QString m_previous;
+};
+
+/**
+ * Measures the time until it goes out of scope, adds it to @p counter and
+ * logs it with @p name and @p file. A span of the current change is also
+ * broadcast.
+ */
+class Span
+{
+public:
+    Span(const char *name, Counter counter, const QString &file)
+        : m_name(name)
+        , m_counter(counter)
+        , m_active(isEnabled())
+    {
+        if (m_active) {
+            m_file = file;
+            m_timer.start();
+        }
+    }
+    // A span that only matters as a stage of a change, not counted
+    Span(const char *name, const QString &file)
+        : m_name(name)
+        , m_counter(CounterCount)
+        , m_active(isTracingChanges() && !currentChange().isEmpty())
+    {
+        if (m_active) {
+            m_file = file;
+            m_timer.start();
+        }
+    }
+    ~Span()
+    {
+        if (m_active) {
+            finish();
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(Span)
+    void finish();
+
+    const char *m_name;
+    Counter m_counter;
+    bool m_active;
+    QString m_file;
+    QElapsedTimer m_timer;
+};
+
+enum class Access {
+    Read,
+    Write,
+};
+
+extern const bool s_profilingAccess;
+
+// Whether KCONFIG_ACCESS_PROFILE is set
+inline bool isProfilingAccess()
+{
+    return s_profilingAccess;
+}
+
+/**
+ * Counts a read or a write of @p key in @p group of the config @p file, along
+ * with the module, i.e. the executable or the library, the call came from:
+ * the first one up the stack that isn't KConfigCore itself.
+ *
+ * Finding that module takes a backtrace, so with
+ * KCONFIG_ACCESS_PROFILE_INTERVAL=<n> only one access in n is counted, in
+ * each thread. At exit, the counts are written to the file named by
+ * KCONFIG_ACCESS_PROFILE, with %p replaced by the pid, or to stderr for "-",
+ * as JSON, the most frequent accesses first:
+ *
+ *	{"pid": 1234, "interval": 1, "accesses": [
+ *	    {"count": 52, "operation": "read", "file": "kdeglobals",
+ *	     "group": ["KDE"], "key": "SingleClick", "module": "libKF6KIOWidgets.so.6"},
+ *	    ...]}
+ *
+ * The group is the list of the names of the nested groups, outermost first.
+ */
+void recordAccess(const QString &file, const QByteArray &group, const char *key, Access access);
+}
+
+#endif // KCONFIGTRACE_P_H
@@ -0,0 +1,97 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kconfigtransaction.h"
+
+#include "kconfig_p.h"
+
+#include <QTimer>
+
+#include <utility>
+#include <vector>
+
+class KConfigTransactionPrivate
+{
+public:
+    static KConfigPrivate *configPrivate(KConfig *config)
+    {
+        return config->d_ptr;
+    }
+
+    QList<KConfig *> configs;
+    // the configs added as KSharedConfig, kept alive until commit()
+    QList<KSharedConfig::Ptr> sharedConfigs;
+};
+
+KConfigTransaction::KConfigTransaction()
+    : d(new KConfigTransactionPrivate)
+{
+}
+
+KConfigTransaction::~KConfigTransaction() = default;
+
+void KConfigTransaction::addConfig(KConfig *config)
+{
+    Q_ASSERT(config);
+    if (!d->configs.contains(config)) {
+        d->configs.append(config);
+    }
+}
+
+void KConfigTransaction::addConfig(const KSharedConfig::Ptr &config)
+{
+    addConfig(config.data());
+    d->sharedConfigs.append(config);
+}
+
+QList<KConfig *> KConfigTransaction::configs() const
+{
+    return d->configs;
+}
+
+bool KConfigTransaction::commit()
+{
+    const QList<KConfig *> configs = std::exchange(d->configs, {});
+    const QList<KSharedConfig::Ptr> sharedConfigs = std::exchange(d->sharedConfigs, {});
+
+    for (KConfig *config : configs) {
+        if (config->isImmutable() || config->name().isEmpty()) {
+            return false;
+        }
+    }
+
+    // the same steps as KConfigBackgroundSync, only all the jobs are written at once
+    std::vector<KConfigPrivate::SyncJob> jobs(configs.size());
+    QList<KConfigPrivate::SyncJob *> taken;
+    QList<KConfigPrivate *> writing;
+    for (qsizetype i = 0; i < configs.size(); ++i) {
+        KConfigPrivate *const configPrivate = KConfigTransactionPrivate::configPrivate(configs.at(i));
+        if (configPrivate->writeBehindTimer) {
+            configPrivate->writeBehindTimer->stop();
+        }
+        // waits for a background sync still writing older changes
+        configPrivate->syncSemaphore.acquire();
+        if (configPrivate->takeSyncJob(&jobs[i])) {
+            taken.append(&jobs[i]);
+            writing.append(configPrivate);
+        } else {
+            configPrivate->syncSemaphore.release();
+        }
+    }
+    if (taken.isEmpty()) {
+        return true;
+    }
+
+    const bool succeeded = KConfigPrivate::runSyncJobs(taken);
+    for (qsizetype i = 0; i < taken.size(); ++i) {
+        if (!taken.at(i)->succeeded) {
+            writing.at(i)->restoreSyncJob(*taken.at(i));
+        }
+        writing.at(i)->syncSemaphore.release();
+    }
+    return succeeded;
+}
@@ -0,0 +1,88 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGTRANSACTION_H
+#define KCONFIGTRANSACTION_H
+
+#include <QList>
+#include <QScopedPointer>
+
+#include <KSharedConfig>
+
+#include <kconfigcore_export.h>
+
+class KConfigTransactionPrivate;
+
+/**
+ * \class KConfigTransaction kconfigtransaction.h <KConfigTransaction>
+ *
+ * Syncs several configs in one go.
+ *
+ * A settings module often changes the config of an application, kdeglobals
+ * and a state file together. Calling KConfig::sync() on each of them locks,
+ * merges and writes the files one after the other, and every one of them
+ * sends its own change notification. commit() instead locks all the files
+ * the configs write to, always in the same order, writes them, and only
+ * then notifies clients, once for each file:
+ *
+ * @code
+ * KConfigTransaction transaction;
+ * transaction.addConfig(KSharedConfig::openConfig());
+ * transaction.addConfig(KSharedConfig::openStateConfig());
+ * if (!transaction.commit()) {
+ *     // the configs that couldn't be written are still dirty
+ * }
+ * @endcode
+ *
+ * Nobody using KConfig sees some of the files written and not the others,
+ * as they would have to lock them to read them for writing. Each file is
+ * replaced on its own, though, so a write failing halfway leaves the files
+ * before it written.
+ *
+ * @since 6.1
+ */
+class KCONFIGCORE_EXPORT KConfigTransaction
+{
+public:
+    KConfigTransaction();
+    /**
+     * Destroys the transaction, without writing anything.
+     */
+    ~KConfigTransaction();
+
+    /**
+     * Adds @p config to the configs written by commit(). It has to be
+     * used by the same thread as the transaction and must outlive it.
+     */
+    void addConfig(KConfig *config);
+    /**
+     * Adds @p config to the configs written by commit(), and keeps it
+     * alive until then.
+     */
+    void addConfig(const KSharedConfig::Ptr &config);
+
+    /**
+     * Returns the configs added since the last commit(), in the order they were added.
+     */
+    QList<KConfig *> configs() const;
+
+    /**
+     * Writes the dirty entries of all the configs and removes them from the
+     * transaction. Configs without any changes are skipped.
+     *
+     * Nothing is written if any of the configs is immutable or anonymous,
+     * or if one of the files can't be locked.
+     * @return whether all the configs could be written
+     */
+    bool commit();
+
+private:
+    Q_DISABLE_COPY(KConfigTransaction)
+    const QScopedPointer<KConfigTransactionPrivate> d;
+};
+
+#endif // KCONFIGTRANSACTION_H
@@ -5,7 +5,7 @@
 
     SPDX-License-Identifier: LGPL-2.0-or-later
 */
-#include "kconfigutils.h"
+#include "kconfigutils_p.h"
 
 // KDE
 #include <kconfig.h>
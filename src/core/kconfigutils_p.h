@@ -0,0 +1,33 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-FileCopyrightText: 2010 Canonical Ltd
+    SPDX-FileContributor: Aurélien Gâteau <aurelien.gateau@canonical.com>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+#ifndef KCONFIGUTILS_P_H
+#define KCONFIGUTILS_P_H
+
+#include <QStringList>
+
+#include <kconfigcore_export.h>
+
+class QString;
+
+class KConfig;
+class KConfigGroup;
+
+namespace KConfigUtils
+{
+KCONFIGCORE_EXPORT bool hasGroup(KConfig *, const QStringList &);
+
+KCONFIGCORE_EXPORT KConfigGroup openGroup(KConfig *, const QStringList &);
+
+KCONFIGCORE_EXPORT QStringList parseGroupString(const QString &str, bool *ok, QString *error);
+
+KCONFIGCORE_EXPORT QString unescapeString(const QString &str, bool *ok, QString *error);
+
+} // namespace
+
+#endif /* KCONFIGUTILS_P_H */
@@ -5,9 +5,11 @@
 */
 
 #include "kconfigwatcher.h"
+#include "kconfigwatcher_p.h"
 
 #include "config-kconfig.h"
-#include "kconfig_core_log_settings.h"
+#include "kconfig_p.h"
+#include "kconfigtrace_p.h"
 
 #if KCONFIG_USE_DBUS
 #include <QDBusConnection>
@@ -15,15 +17,244 @@
 #include <QDBusMetaType>
 #endif
 
+#include <QCoreApplication>
 #include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
 #include <QHash>
+#include <QMutex>
 #include <QThreadStorage>
 
+#include <algorithm>
+#include <utility>
+
 class KConfigWatcherPrivate
 {
 public:
+    // whether the watcher cares about changes to @p group
+    bool isWatched(const QString &group) const
+    {
+        if (m_groups.isEmpty()) {
+            return true;
+        }
+        return std::any_of(m_groups.cbegin(), m_groups.cend(), [&group](const QString &watched) {
+            return group == watched || (group.startsWith(watched) && group.at(watched.size()) == QLatin1Char('\x1d'));
+        });
+    }
+
     KSharedConfig::Ptr m_config;
+    QStringList m_groups; // empty for all of them
+};
+
+namespace
+{
+// All the subscriptions of the process, see KConfigWatcherSubscription
+struct Subscriptions {
+    struct Subscription {
+        KConfigWatcherSubscription *receiver = nullptr;
+        QList<KConfigWatcher *> watchers;
+    };
+
+    QMutex mutex;
+    QHash<QString, Subscription> byPath;
 };
+}
+Q_GLOBAL_STATIC(Subscriptions, s_subscriptions)
+
+KConfigWatcherSubscription::KConfigWatcherSubscription(const QString &path)
+    : m_path(path)
+    , m_kind(KConfigNotifyTransport::kind())
+{
+}
+
+void KConfigWatcherSubscription::connectTransport()
+{
+    if (m_kind == KConfigNotifyTransport::File) {
+        const QString fileName = KConfigNotifyTransport::filePath(m_path);
+        QDir().mkpath(QFileInfo(fileName).path());
+        QFile file(fileName);
+        // it has to exist to be watched, earlier notifications are of no interest
+        if (file.open(QIODevice::Append)) {
+            m_fileOffset = file.size();
+        }
+        m_fileWatcher = new QFileSystemWatcher({fileName}, this);
+        connect(m_fileWatcher, &QFileSystemWatcher::fileChanged, this, &KConfigWatcherSubscription::readFile);
+        return;
+    }
+#if KCONFIG_USE_DBUS
+    QDBusConnection::sessionBus().connect(QString(),
+                                          m_path,
+                                          QStringLiteral("org.kde.kconfig.notify"),
+                                          QStringLiteral("ConfigChanged"),
+                                          this,
+                                          // clang-format off
+                                          SLOT(onConfigChanged(QHash<QString,QByteArrayList>))
+                                          // clang-format on
+    );
+    QDBusConnection::sessionBus().connect(QString(),
+                                          m_path,
+                                          QStringLiteral("org.kde.kconfig.notify"),
+                                          QStringLiteral("ConfigValuesChanged"),
+                                          this,
+                                          // clang-format off
+                                          SLOT(onConfigValuesChanged(QHash<QString,QByteArrayList>))
+                                          // clang-format on
+    );
+    if (KConfigTrace::isTracingChanges()) {
+        QDBusConnection::sessionBus().connect(QString(),
+                                              m_path,
+                                              QStringLiteral("org.kde.kconfig.notify"),
+                                              QStringLiteral("ConfigChangeTraced"),
+                                              this,
+                                              SLOT(onConfigChangeTraced(QString)));
+    }
+#endif
+}
+
+void KConfigWatcherSubscription::disconnectTransport()
+{
+    if (m_kind == KConfigNotifyTransport::File) {
+        return; // the file watcher goes with this object
+    }
+#if KCONFIG_USE_DBUS
+    QDBusConnection::sessionBus().disconnect(QString(),
+                                             m_path,
+                                             QStringLiteral("org.kde.kconfig.notify"),
+                                             QStringLiteral("ConfigChanged"),
+                                             this,
+                                             // clang-format off
+                                             SLOT(onConfigChanged(QHash<QString,QByteArrayList>))
+                                             // clang-format on
+    );
+    QDBusConnection::sessionBus().disconnect(QString(),
+                                             m_path,
+                                             QStringLiteral("org.kde.kconfig.notify"),
+                                             QStringLiteral("ConfigValuesChanged"),
+                                             this,
+                                             // clang-format off
+                                             SLOT(onConfigValuesChanged(QHash<QString,QByteArrayList>))
+                                             // clang-format on
+    );
+    if (KConfigTrace::isTracingChanges()) {
+        QDBusConnection::sessionBus().disconnect(QString(),
+                                                 m_path,
+                                                 QStringLiteral("org.kde.kconfig.notify"),
+                                                 QStringLiteral("ConfigChangeTraced"),
+                                                 this,
+                                                 SLOT(onConfigChangeTraced(QString)));
+    }
+#endif
+}
+
+void KConfigWatcherSubscription::readFile()
+{
+    QFile file(KConfigNotifyTransport::filePath(m_path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    if (file.size() < m_fileOffset) { // started anew by a sender
+        m_fileOffset = 0;
+    }
+    file.seek(m_fileOffset);
+    qsizetype consumed = 0;
+    const QList<QHash<QString, QByteArrayList>> records = KConfigNotifyTransport::readRecords(file.readAll(), &consumed);
+    m_fileOffset += consumed;
+    for (const QHash<QString, QByteArrayList> &changes : records) {
+        onConfigChanged(changes);
+    }
+}
+
+void KConfigWatcherSubscription::subscribe(KConfigWatcher *watcher, const QStringList &paths)
+{
+    Subscriptions &subscriptions = *s_subscriptions;
+    QMutexLocker locker(&subscriptions.mutex);
+    for (const QString &path : paths) {
+        Subscriptions::Subscription &subscription = subscriptions.byPath[path];
+        if (subscription.watchers.contains(watcher)) {
+            continue;
+        }
+        subscription.watchers.append(watcher);
+        if (subscription.receiver) {
+            continue;
+        }
+        subscription.receiver = new KConfigWatcherSubscription(path);
+        subscription.receiver->connectTransport();
+        if (QCoreApplication::instance()) {
+            subscription.receiver->moveToThread(QCoreApplication::instance()->thread());
+        }
+    }
+}
+
+void KConfigWatcherSubscription::unsubscribe(KConfigWatcher *watcher)
+{
+    if (!s_subscriptions.exists()) {
+        return;
+    }
+    Subscriptions &subscriptions = *s_subscriptions;
+    QMutexLocker locker(&subscriptions.mutex);
+    for (auto it = subscriptions.byPath.begin(); it != subscriptions.byPath.end();) {
+        it->watchers.removeOne(watcher);
+        if (!it->watchers.isEmpty()) {
+            ++it;
+            continue;
+        }
+        // the last watcher of the path is gone
+        it->receiver->disconnectTransport();
+        it->receiver->deleteLater();
+        it = subscriptions.byPath.erase(it);
+    }
+}
+
+void KConfigWatcherSubscription::onConfigChanged(const QHash<QString, QByteArrayList> &changes)
+{
+    const QString change = std::exchange(m_tracedChange, QString());
+    if (m_applied.removeOne(changes)) {
+        return;
+    }
+    Subscriptions &subscriptions = *s_subscriptions;
+    QMutexLocker locker(&subscriptions.mutex);
+    const QList<KConfigWatcher *> watchers = subscriptions.byPath.value(m_path).watchers;
+    for (KConfigWatcher *watcher : watchers) {
+        // Queued, so that no slot runs with the mutex held. A watcher destroyed
+        // before its thread gets to the call drops it.
+        QMetaObject::invokeMethod(
+            watcher,
+            [watcher, changes, change]() {
+                const KConfigTrace::ChangeScope scope(change);
+                watcher->onConfigChangeNotification(changes);
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+void KConfigWatcherSubscription::onConfigValuesChanged(const QHash<QString, QByteArrayList> &values)
+{
+    // the sender sends ConfigChanged right after, unless it went away in between
+    m_applied.append(KConfigNotifyTransport::changedKeys(values));
+    if (m_applied.size() > 16) {
+        m_applied.removeFirst();
+    }
+    Subscriptions &subscriptions = *s_subscriptions;
+    QMutexLocker locker(&subscriptions.mutex);
+    const QList<KConfigWatcher *> watchers = subscriptions.byPath.value(m_path).watchers;
+    for (KConfigWatcher *watcher : watchers) {
+        QMetaObject::invokeMethod(
+            watcher,
+            [watcher, values, path = m_path, change = m_tracedChange]() {
+                const KConfigTrace::ChangeScope scope(change);
+                watcher->onConfigValuesNotification(values, path);
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+void KConfigWatcherSubscription::onConfigChangeTraced(const QString &change)
+{
+    // the ConfigChanged signal right after takes it, one of ConfigValuesChanged leaves it to that
+    m_tracedChange = change;
+}
 
 KConfigWatcher::Ptr KConfigWatcher::create(const KSharedConfig::Ptr &config)
 {
@@ -44,6 +275,16 @@ KConfigWatcher::Ptr KConfigWatcher::create(const KSharedConfig::Ptr &config)
     return watcherList.localData().value(c).toStrongRef();
 }
 
+KConfigWatcher::Ptr KConfigWatcher::create(const KSharedConfig::Ptr &config, const QStringList &groups)
+{
+    if (groups.isEmpty()) {
+        return create(config);
+    }
+    KConfigWatcher::Ptr watcher(new KConfigWatcher(config));
+    watcher->d->m_groups = groups;
+    return watcher;
+}
+
 KConfigWatcher::KConfigWatcher(const KSharedConfig::Ptr &config)
     : QObject(nullptr)
     , d(new KConfigWatcherPrivate)
@@ -52,10 +293,9 @@ KConfigWatcher::KConfigWatcher(const KSharedConfig::Ptr &config)
     d->m_config = config;
 
 #if KCONFIG_USE_DBUS
-
     qDBusRegisterMetaType<QByteArrayList>();
     qDBusRegisterMetaType<QHash<QString, QByteArrayList>>();
-
+#endif
 
     QStringList watchedPaths = d->m_config->additionalConfigSources();
     for (QString &file : watchedPaths) {
@@ -67,23 +307,13 @@ KConfigWatcher::KConfigWatcher(const KSharedConfig::Ptr &config)
         watchedPaths << QStringLiteral("/kdeglobals");
     }
 
-    for (const QString &path : std::as_const(watchedPaths)) {
-        QDBusConnection::sessionBus().connect(QString(),
-                                              path,
-                                              QStringLiteral("org.kde.kconfig.notify"),
-                                              QStringLiteral("ConfigChanged"),
-                                              this,
-                                              // clang-format off
-                                              SLOT(onConfigChangeNotification(QHash<QString,QByteArrayList>))
-                                              // clang-format on
-        );
-    }
-#else
-    qCWarning(KCONFIG_CORE_LOG) << "Use of KConfigWatcher without DBus support. You will not receive updates";
-#endif
+    KConfigWatcherSubscription::subscribe(this, watchedPaths);
 }
 
-KConfigWatcher::~KConfigWatcher() = default;
+KConfigWatcher::~KConfigWatcher()
+{
+    KConfigWatcherSubscription::unsubscribe(this);
+}
 
 KSharedConfig::Ptr KConfigWatcher::config() const
 {
@@ -92,11 +322,57 @@ KSharedConfig::Ptr KConfigWatcher::config() const
 
 void KConfigWatcher::onConfigChangeNotification(const QHash<QString, QByteArrayList> &changes)
 {
+    KConfigTrace::count(KConfigTrace::NotificationsReceived);
+    const KConfigTrace::Span span("notified", d->m_config->name());
     // should we ever need it we can determine the file changed with  QDbusContext::message().path(), but it doesn't seem too useful
 
-    d->m_config->reparseConfiguration();
+    QStringList groups;
+    for (auto it = changes.constBegin(); it != changes.constEnd(); it++) {
+        if (d->isWatched(it.key())) {
+            groups.append(it.key());
+        }
+    }
+    if (groups.isEmpty()) {
+        return;
+    }
+
+    // the signal lists every group that changed, the others don't need to be parsed again
+    d->m_config->reparseGroups(groups);
+
+    emitConfigChanged(changes);
+}
 
+void KConfigWatcher::onConfigValuesNotification(const QHash<QString, QByteArrayList> &values, const QString &path)
+{
+    KConfigTrace::count(KConfigTrace::NotificationsReceived);
+    const KConfigTrace::Span span("notified", d->m_config->name());
+    QStringList staleGroups;
+    bool watched = false;
+    for (auto it = values.constBegin(); it != values.constEnd(); it++) {
+        if (!d->isWatched(it.key())) {
+            continue;
+        }
+        watched = true;
+        if (!d->m_config->d_func()->applyNotifiedValues(it.key(), it.value(), path)) {
+            staleGroups.append(it.key());
+        }
+    }
+    if (!watched) {
+        return;
+    }
+    if (!staleGroups.isEmpty()) {
+        d->m_config->reparseGroups(staleGroups);
+    }
+
+    emitConfigChanged(KConfigNotifyTransport::changedKeys(values));
+}
+
+void KConfigWatcher::emitConfigChanged(const QHash<QString, QByteArrayList> &changes)
+{
     for (auto it = changes.constBegin(); it != changes.constEnd(); it++) {
+        if (!d->isWatched(it.key())) {
+            continue;
+        }
         KConfigGroup group = d->m_config->group(QString()); // top level group
         const auto parts = it.key().split(QLatin1Char('\x1d')); // magic char, see KConfig
         for (const QString &groupName : parts) {
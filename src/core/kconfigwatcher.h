@@ -21,6 +21,10 @@ class KConfigWatcherPrivate;
  * \class KConfigWatcher kconfigwatcher.h <KConfigWatcher>
  *
  * Notifies when another client has updated this config file with the Notify flag set.
+ *
+ * The notifications are D-Bus signals on the session bus. Without a bus, or
+ * with KCONFIG_NOTIFY_TRANSPORT=file in the environment of all the processes
+ * involved, they are written to files in the runtime directory instead.
  * @since 5.51
  */
 class KCONFIGCORE_EXPORT KConfigWatcher : public QObject
@@ -36,6 +40,19 @@ public:
      */
     static Ptr create(const KSharedConfig::Ptr &config);
 
+    /**
+     * Instantiate a ConfigWatcher that only cares about some groups of a config
+     *
+     * Changes to other groups neither reload the config nor emit configChanged().
+     * A group includes its subgroups; the names of nested groups are joined
+     * with '\x1d', e.g. "Parent\x1dChild". Unlike create(config), every
+     * call returns a new watcher.
+     *
+     * @note any additional config sources should be set before this point.
+     * @since 6.1
+     */
+    static Ptr create(const KSharedConfig::Ptr &config, const QStringList &groups);
+
     ~KConfigWatcher() override;
 
     /**
@@ -58,7 +75,11 @@ private Q_SLOTS:
     void onConfigChangeNotification(const QHash<QString, QByteArrayList> &changes);
 
 private:
+    friend class KConfigWatcherSubscription;
     KConfigWatcher(const KSharedConfig::Ptr &config);
+    // for a ConfigValuesChanged signal on @p path, which updates the config without reparsing it
+    void onConfigValuesNotification(const QHash<QString, QByteArrayList> &values, const QString &path);
+    void emitConfigChanged(const QHash<QString, QByteArrayList> &changes);
     Q_DISABLE_COPY(KConfigWatcher)
     const QScopedPointer<KConfigWatcherPrivate> d;
 };
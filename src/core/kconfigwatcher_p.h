@@ -0,0 +1,68 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KCONFIGWATCHER_P_H
+#define KCONFIGWATCHER_P_H
+
+#include "kconfignotify_p.h"
+
+#include <QByteArrayList>
+#include <QHash>
+#include <QObject>
+
+class KConfigWatcher;
+class QFileSystemWatcher;
+
+/**
+ * The one ConfigChanged subscription of the process for a path, shared by all
+ * the watchers of that path, in any thread.
+ *
+ * It lives in the thread of the application and hands each notification on
+ * to the watchers in their own threads. Depending on KConfigNotifyTransport,
+ * it is connected to the session bus or watches the notification file.
+ * The ConfigChanged signal that follows a ConfigValuesChanged one for the
+ * same changes is dropped, the values already updated the configs.
+ * With KCONFIG_TRACE, a ConfigChangeTraced signal before those gives the id
+ * of the change, which the watchers handle it under.
+ *
+ * @internal
+ */
+class KConfigWatcherSubscription : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Makes @p watcher receive the signals sent for @p paths
+    static void subscribe(KConfigWatcher *watcher, const QStringList &paths);
+    // Stops all the signals to @p watcher, called when it is destroyed
+    static void unsubscribe(KConfigWatcher *watcher);
+
+private Q_SLOTS:
+    void onConfigChanged(const QHash<QString, QByteArrayList> &changes);
+    void onConfigValuesChanged(const QHash<QString, QByteArrayList> &values);
+    void onConfigChangeTraced(const QString &change);
+
+private:
+    explicit KConfigWatcherSubscription(const QString &path);
+
+    void connectTransport();
+    void disconnectTransport();
+    // passes on the notifications appended to the file since the last read
+    void readFile();
+
+    const QString m_path;
+    const KConfigNotifyTransport::Kind m_kind;
+    // for KConfigNotifyTransport::File
+    QFileSystemWatcher *m_fileWatcher = nullptr;
+    qint64 m_fileOffset = 0;
+    // the changes of the ConfigValuesChanged signals whose ConfigChanged signal is still to come
+    QList<QHash<QString, QByteArrayList>> m_applied;
+    // the id of the change the next signals are about, see KConfigTrace
+    QString m_tracedChange;
+};
+
+#endif // KCONFIGWATCHER_P_H
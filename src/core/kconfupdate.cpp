@@ -0,0 +1,1052 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2001 Waldo Bastian <bastian@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-only
+*/
+
+#include "kconfupdate_p.h"
+
+#include "config-kconfig.h" // CMAKE_INSTALL_FULL_LIBDIR
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+
+#include <QCryptographicHash>
+#include <QDate>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QThread>
+#include <QUrl>
+
+#include "kconf_update_debug.h"
+#include "kconfig.h"
+#include "kconfiggroup.h"
+#include "kconfigutils_p.h"
+
+// Convenience wrapper around qCDebug to prefix the output with metadata of
+// the file.
+#define qCDebugFile(CATEGORY) qCDebug(CATEGORY) << m_currentFilename << ':' << m_lineCount << ":'" << m_line << "': "
+
+static bool caseInsensitiveCompare(const QStringView &a, const QLatin1String &b)
+{
+    return a.compare(b, Qt::CaseInsensitive) == 0;
+}
+
+// An update script running in the background, see KonfUpdate::gotScript()
+struct ScriptJob {
+    QProcess process;
+    QTemporaryFile scriptIn;
+    QTemporaryFile scriptOut;
+    // not a pipe, nobody reads it while the script runs
+    QTemporaryFile scriptErr;
+    QDeadlineTimer deadline;
+    QString cmd;
+    QString updateFileName;
+    QString id;
+    QString oldFile;
+    KConfig *oldConfig2 = nullptr;
+    KConfig *newConfig = nullptr;
+    QStringList oldGroup;
+    QStringList newGroup;
+
+    // the configs to record the update in once the script is done, if it was closed in the meantime
+    QList<KConfig *> versionConfigs;
+    bool recordDone = false;
+};
+
+KonfUpdate::KonfUpdate(const Options &options, KConfig *target)
+    : m_oldConfig1(nullptr)
+    , m_oldConfig2(nullptr)
+    , m_newConfig(nullptr)
+    , m_target(target)
+    , m_bCopy(false)
+    , m_bOverwrite(false)
+    , m_textStream(nullptr)
+    , m_file(nullptr)
+    , m_lineCount(-1)
+{
+    bool updateAll = false;
+    QByteArray stamp;
+
+    m_config = new KConfig(QStringLiteral("kconf_updaterc"));
+    KConfigGroup cg(m_config, QString());
+
+    QStringList updateFiles;
+    if (m_target) {
+        m_targets.insert(m_target->name(), m_target);
+    }
+
+    m_bDebugOutput = options.debugOutput;
+    if (m_bDebugOutput) {
+        // The only way to enable debug reliably is through a filter rule.
+        // The category itself is const, so we can't just go around changing
+        // its mode. This can however be overridden by the environment, so
+        // we'll want to have a fallback warning if debug is not enabled
+        // after setting the filter.
+        QLoggingCategory::setFilterRules(QLatin1String("%1.debug=true").arg(QLatin1String{KCONF_UPDATE_LOG().categoryName()}));
+        qDebug() << "Automatically enabled the debug logging category" << KCONF_UPDATE_LOG().categoryName();
+        if (!KCONF_UPDATE_LOG().isDebugEnabled()) {
+            qWarning("The debug logging category %s needs to be enabled manually to get debug output", KCONF_UPDATE_LOG().categoryName());
+        }
+    }
+
+    m_bTestMode = options.testMode;
+    if (m_bTestMode) {
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
+    m_bUseConfigInfo = false;
+    if (!options.check.isEmpty()) {
+        m_bUseConfigInfo = true;
+        const QString file = QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1String{"kconf_update/"} + options.check);
+        if (file.isEmpty()) {
+            qWarning("File '%s' not found.", options.check.toLocal8Bit().data());
+            qCDebug(KCONF_UPDATE_LOG) << "File" << options.check << "passed on command line not found";
+            return;
+        }
+        updateFiles.append(file);
+    } else if (!options.files.isEmpty()) {
+        updateFiles += options.files;
+    } else if (m_bTestMode) {
+        qWarning("Test mode enabled, but no files given.");
+        return;
+    } else {
+        if (cg.readEntry("autoUpdateDisabled", false)) {
+            return;
+        }
+        stamp = updateDirsStamp();
+        if (cg.readEntry("updateInfoAdded", false) && cg.readEntry("updateDirsStamp", QByteArray()) == stamp) {
+            qCDebug(KCONF_UPDATE_LOG) << "No update-file changed since the last run";
+            return;
+        }
+        updateFiles = findUpdateFiles(true);
+        updateAll = true;
+    }
+
+    for (const QString &file : std::as_const(updateFiles)) {
+        updateFile(file);
+    }
+    finishAllScripts();
+    syncTargets();
+
+    if (updateAll && !cg.readEntry("updateInfoAdded", false)) {
+        cg.writeEntry("updateInfoAdded", true);
+        updateFiles = findUpdateFiles(false);
+
+        for (const auto &file : std::as_const(updateFiles)) {
+            checkFile(file);
+        }
+        updateFiles.clear();
+    }
+
+    if (updateAll) {
+        cg.writeEntry("updateDirsStamp", stamp);
+        cg.sync();
+    }
+}
+
+KonfUpdate::~KonfUpdate()
+{
+    // the targets first, an update must not be recorded as done before it was written
+    finishAllScripts();
+    syncTargets();
+    for (KConfig *config : std::as_const(m_targets)) {
+        if (config != m_target) {
+            delete config;
+        }
+    }
+    delete m_config;
+    delete m_file;
+    delete m_textStream;
+}
+
+QStringList KonfUpdate::findUpdateFiles(bool dirtyOnly)
+{
+    QStringList result;
+
+    const QStringList dirs = QStandardPaths::locateAll(QStandardPaths::GenericDataLocation, QStringLiteral("kconf_update"), QStandardPaths::LocateDirectory);
+    for (const QString &d : dirs) {
+        const QDir dir(d);
+
+        const QStringList fileNames = dir.entryList(QStringList(QStringLiteral("*.upd")));
+        for (const QString &fileName : fileNames) {
+            const QString file = dir.filePath(fileName);
+            QFileInfo info(file);
+
+            KConfigGroup cg(m_config, fileName);
+            const qint64 ctime = cg.readEntry("ctime", 0);
+            const qint64 mtime = cg.readEntry("mtime", 0);
+            if (!dirtyOnly //
+                || (ctime != 0 && ctime != info.birthTime().toSecsSinceEpoch()) //
+                || mtime != info.lastModified().toSecsSinceEpoch()) {
+                result.append(file);
+            }
+        }
+    }
+    return result;
+}
+
+// A hash of the update-file directories, with the modification times of the
+// directories and the names and times of the files in them. As long as it
+// matches the one of the last run, there is nothing new to apply.
+QByteArray KonfUpdate::updateDirsStamp() const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    const QStringList dirs = QStandardPaths::locateAll(QStandardPaths::GenericDataLocation, QStringLiteral("kconf_update"), QStandardPaths::LocateDirectory);
+    for (const QString &d : dirs) {
+        const QDir dir(d);
+        hash.addData(QFile::encodeName(d) + '\t' + QByteArray::number(QFileInfo(d).lastModified().toMSecsSinceEpoch()) + '\n');
+
+        const QFileInfoList infos = dir.entryInfoList(QStringList(QStringLiteral("*.upd")), QDir::Files, QDir::Name);
+        for (const QFileInfo &info : infos) {
+            const qint64 birthTime = info.birthTime().isValid() ? info.birthTime().toMSecsSinceEpoch() : 0;
+            hash.addData(QFile::encodeName(info.fileName()) + '\t' + QByteArray::number(birthTime) + '\t'
+                         + QByteArray::number(info.lastModified().toMSecsSinceEpoch()) + '\n');
+        }
+    }
+    return hash.result().toHex();
+}
+
+bool KonfUpdate::checkFile(const QString &filename)
+{
+    m_currentFilename = filename;
+    const int i = m_currentFilename.lastIndexOf(QLatin1Char{'/'});
+    if (i != -1) {
+        m_currentFilename = m_currentFilename.mid(i + 1);
+    }
+    m_skip = true;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QTextStream ts(&file);
+    ts.setEncoding(QStringConverter::Encoding::Latin1);
+    int lineCount = 0;
+    resetOptions();
+    QString id;
+    bool foundVersion = false;
+    while (!ts.atEnd()) {
+        const QString line = ts.readLine().trimmed();
+        if (line.startsWith(QLatin1String("Version=5"))) {
+            foundVersion = true;
+        }
+        ++lineCount;
+        if (line.isEmpty() || (line[0] == QLatin1Char{'#'})) {
+            continue;
+        }
+        if (line.startsWith(QLatin1String("Id="))) {
+            if (!foundVersion) {
+                qCDebug(KCONF_UPDATE_LOG, "Missing 'Version=5', file '%s' will be skipped.", qUtf8Printable(filename));
+                return true;
+            }
+            id = m_currentFilename + QLatin1Char{':'} + line.mid(3);
+        } else if (line.startsWith(QLatin1String("File="))) {
+            checkGotFile(line.mid(5), id);
+        }
+    }
+
+    return true;
+}
+
+void KonfUpdate::checkGotFile(const QString &_file, const QString &id)
+{
+    QString file;
+    const int i = _file.indexOf(QLatin1Char{','});
+    if (i == -1) {
+        file = _file.trimmed();
+    } else {
+        file = _file.mid(i + 1).trimmed();
+    }
+
+    //   qDebug("File %s, id %s", file.toLatin1().constData(), id.toLatin1().constData());
+
+    KConfig cfg(file, KConfig::SimpleConfig);
+    KConfigGroup cg = cfg.group("$Version");
+    QStringList ids = cg.readEntry("update_info", QStringList());
+    if (ids.contains(id)) {
+        return;
+    }
+    ids.append(id);
+    cg.writeEntry("update_info", ids);
+}
+
+/**
+ * Syntax:
+ * # Comment
+ * Id=id
+ * File=oldfile[,newfile]
+ * AllGroups
+ * Group=oldgroup[,newgroup]
+ * RemoveGroup=oldgroup
+ * Options=[copy,][overwrite,]
+ * Key=oldkey[,newkey]
+ * RemoveKey=ldkey
+ * AllKeys
+ * Keys= [Options](AllKeys|(Key|RemoveKey)*)
+ * ScriptArguments=arguments
+ * Script=scriptfile[,interpreter]
+ *
+ * Sequence:
+ * (Id,(File(Group,Keys)*)*)*
+ **/
+bool KonfUpdate::updateFile(const QString &filename)
+{
+    m_currentFilename = filename;
+    const int i = m_currentFilename.lastIndexOf(QLatin1Char{'/'});
+    if (i != -1) {
+        m_currentFilename = m_currentFilename.mid(i + 1);
+    }
+    m_skip = true;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning("Could not open update-file '%s'.", qUtf8Printable(filename));
+        return false;
+    }
+
+    qCDebug(KCONF_UPDATE_LOG) << "Checking update-file" << filename << "for new updates";
+
+    QTextStream ts(&file);
+    ts.setEncoding(QStringConverter::Encoding::Latin1);
+    m_lineCount = 0;
+    resetOptions();
+    bool foundVersion = false;
+    while (!ts.atEnd()) {
+        m_line = ts.readLine().trimmed();
+        if (m_line.startsWith(QLatin1String("Version=5"))) {
+            foundVersion = true;
+        }
+        ++m_lineCount;
+        if (m_line.isEmpty() || (m_line[0] == QLatin1Char('#'))) {
+            continue;
+        }
+        if (m_currentScript && !m_line.startsWith(QLatin1String("Id="))) {
+            // the rest of the update depends on the outcome of its script
+            finishScript(m_currentScript);
+        }
+        if (m_line.startsWith(QLatin1String("Id="))) {
+            if (!foundVersion) {
+                qCDebug(KCONF_UPDATE_LOG, "Missing 'Version=5', file '%s' will be skipped.", qUtf8Printable(filename));
+                break;
+            }
+            gotId(m_line.mid(3));
+        } else if (m_skip) {
+            continue;
+        } else if (m_line.startsWith(QLatin1String("Options="))) {
+            gotOptions(m_line.mid(8));
+        } else if (m_line.startsWith(QLatin1String("File="))) {
+            gotFile(m_line.mid(5));
+        } else if (m_skipFile) {
+            continue;
+        } else if (m_line.startsWith(QLatin1String("Group="))) {
+            gotGroup(m_line.mid(6));
+        } else if (m_line.startsWith(QLatin1String("RemoveGroup="))) {
+            gotRemoveGroup(m_line.mid(12));
+            resetOptions();
+        } else if (m_line.startsWith(QLatin1String("Script="))) {
+            gotScript(m_line.mid(7));
+            resetOptions();
+        } else if (m_line.startsWith(QLatin1String("ScriptArguments="))) {
+            gotScriptArguments(m_line.mid(16));
+        } else if (m_line.startsWith(QLatin1String("Key="))) {
+            gotKey(m_line.mid(4));
+            resetOptions();
+        } else if (m_line.startsWith(QLatin1String("RemoveKey="))) {
+            gotRemoveKey(m_line.mid(10));
+            resetOptions();
+        } else if (m_line == QLatin1String("AllKeys")) {
+            gotAllKeys();
+            resetOptions();
+        } else if (m_line == QLatin1String("AllGroups")) {
+            gotAllGroups();
+            resetOptions();
+        } else {
+            qCDebugFile(KCONF_UPDATE_LOG) << "Parse error";
+        }
+    }
+    // Flush.
+    gotId(QString());
+
+    // Remember that this file was updated:
+    if (!m_bTestMode) {
+        QFileInfo info(filename);
+        KConfigGroup cg(m_config, m_currentFilename);
+        if (info.birthTime().isValid()) {
+            cg.writeEntry("ctime", info.birthTime().toSecsSinceEpoch());
+        }
+        cg.writeEntry("mtime", info.lastModified().toSecsSinceEpoch());
+    }
+
+    return true;
+}
+
+// Several updates, also from different update-files, often touch the same
+// file: they all share one KConfig, which is only written by syncTargets()
+KConfig *KonfUpdate::targetConfig(const QString &file)
+{
+    KConfig *&config = m_targets[file];
+    if (!config) {
+        config = new KConfig(file, KConfig::NoGlobals);
+    }
+    return config;
+}
+
+void KonfUpdate::syncTargets()
+{
+    for (auto it = m_targets.cbegin(); it != m_targets.cend(); ++it) {
+        it.value()->sync();
+
+        QString file = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QLatin1Char('/') + it.key();
+        QFileInfo info(file);
+        if (info.exists() && info.size() == 0) {
+            // Delete empty file.
+            QFile::remove(file);
+        }
+    }
+}
+
+void KonfUpdate::gotId(const QString &_id)
+{
+    // Remember that the last update group has been done:
+    if (!m_id.isEmpty() && !m_skip && !m_bTestMode) {
+        if (m_currentScript) {
+            m_currentScript->recordDone = true;
+        } else {
+            addDoneId(m_currentFilename, m_id);
+        }
+    }
+
+    // Flush pending changes
+    gotFile(QString());
+    // the script of the last update keeps running while the next ones are read
+    m_currentScript = nullptr;
+
+    if (_id.isEmpty()) {
+        return;
+    }
+
+    // Check whether this update group needs to be done:
+    KConfigGroup cg(m_config, m_currentFilename);
+    QStringList ids = cg.readEntry("done", QStringList());
+    if (ids.contains(_id) && !m_bUseConfigInfo) {
+        // qDebug("Id '%s' was already in done-list", _id.toLatin1().constData());
+        m_skip = true;
+        return;
+    }
+    m_skip = false;
+    m_skipFile = false;
+    m_id = _id;
+    if (m_bUseConfigInfo) {
+        qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": Checking update" << _id;
+    } else {
+        qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": Found new update" << _id;
+    }
+}
+
+void KonfUpdate::addDoneId(const QString &updateFileName, const QString &id)
+{
+    KConfigGroup cg(m_config, updateFileName);
+    QStringList ids = cg.readEntry("done", QStringList());
+    if (!ids.contains(id)) {
+        ids.append(id);
+        cg.writeEntry("done", ids);
+    }
+}
+
+// Records in @p config that the current update was applied to it, once its script is done if it has one
+void KonfUpdate::addUpdateInfo(KConfig *config)
+{
+    if (m_currentScript) {
+        m_currentScript->versionConfigs.append(config);
+    } else {
+        addUpdateInfo(config, m_currentFilename + QLatin1Char{':'} + m_id);
+    }
+}
+
+void KonfUpdate::addUpdateInfo(KConfig *config, const QString &cfgId)
+{
+    KConfigGroup cg(config, "$Version");
+    QStringList ids = cg.readEntry("update_info", QStringList());
+    if (!ids.contains(cfgId)) {
+        ids.append(cfgId);
+        cg.writeEntry("update_info", ids);
+    }
+}
+
+void KonfUpdate::gotFile(const QString &_file)
+{
+    // Reset group
+    gotGroup(QString());
+
+    if (!m_oldFile.isEmpty()) {
+        // Close old file.
+        delete m_oldConfig1;
+        m_oldConfig1 = nullptr;
+
+        if (!m_skip) {
+            addUpdateInfo(m_oldConfig2);
+        }
+        m_oldConfig2 = nullptr;
+
+        m_oldFile.clear();
+    }
+    if (!m_newFile.isEmpty()) {
+        // Close new file.
+        if (!m_skip) {
+            addUpdateInfo(m_newConfig);
+        }
+        m_newConfig = nullptr;
+
+        m_newFile.clear();
+    }
+    m_newConfig = nullptr;
+
+    const int i = _file.indexOf(QLatin1Char{','});
+    if (i == -1) {
+        m_oldFile = _file.trimmed();
+    } else {
+        m_oldFile = _file.left(i).trimmed();
+        m_newFile = _file.mid(i + 1).trimmed();
+        if (m_oldFile == m_newFile) {
+            m_newFile.clear();
+        }
+    }
+
+    if (!m_oldFile.isEmpty()) {
+        m_oldConfig2 = targetConfig(m_oldFile);
+        finishScripts(m_oldConfig2);
+        const QString cfg_id = m_currentFilename + QLatin1Char{':'} + m_id;
+        KConfigGroup cg(m_oldConfig2, "$Version");
+        QStringList ids = cg.readEntry("update_info", QStringList());
+        if (ids.contains(cfg_id)) {
+            m_skip = true;
+            m_newFile.clear();
+            qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": Skipping update" << m_id;
+        }
+
+        if (!m_newFile.isEmpty()) {
+            m_newConfig = targetConfig(m_newFile);
+            finishScripts(m_newConfig);
+            KConfigGroup cg(m_newConfig, "$Version");
+            ids = cg.readEntry("update_info", QStringList());
+            if (ids.contains(cfg_id)) {
+                m_skip = true;
+                qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": Skipping update" << m_id;
+            }
+        } else {
+            m_newConfig = m_oldConfig2;
+        }
+
+        // the keys are read as they were before this update, with the changes of the previous ones
+        m_oldConfig1 = m_oldConfig2->copyTo(QString());
+    } else {
+        m_newFile.clear();
+    }
+    m_newFileName = m_newFile;
+    if (m_newFileName.isEmpty()) {
+        m_newFileName = m_oldFile;
+    }
+
+    m_skipFile = false;
+    if (!m_oldFile.isEmpty()) { // if File= is specified, it doesn't exist, is empty or contains only kconf_update's [$Version] group, skip
+        if (m_oldConfig1 != nullptr
+            && (m_oldConfig1->groupList().isEmpty()
+                || (m_oldConfig1->groupList().count() == 1 && m_oldConfig1->groupList().at(0) == QLatin1String("$Version")))) {
+            qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": File" << m_oldFile << "does not exist or empty, skipping";
+            m_skipFile = true;
+        }
+    }
+}
+
+QStringList KonfUpdate::parseGroupString(const QString &str)
+{
+    bool ok;
+    QString error;
+    QStringList lst = KConfigUtils::parseGroupString(str, &ok, &error);
+    if (!ok) {
+        qCDebugFile(KCONF_UPDATE_LOG) << error;
+    }
+    return lst;
+}
+
+void KonfUpdate::gotGroup(const QString &_group)
+{
+    QString group = _group.trimmed();
+    if (group.isEmpty()) {
+        m_oldGroup = m_newGroup = QStringList();
+        return;
+    }
+
+    const QStringList tokens = group.split(QLatin1Char{','});
+    m_oldGroup = parseGroupString(tokens.at(0));
+    if (tokens.count() == 1) {
+        m_newGroup = m_oldGroup;
+    } else {
+        m_newGroup = parseGroupString(tokens.at(1));
+    }
+}
+
+void KonfUpdate::gotRemoveGroup(const QString &_group)
+{
+    m_oldGroup = parseGroupString(_group);
+
+    if (!m_oldConfig1) {
+        qCDebugFile(KCONF_UPDATE_LOG) << "RemoveGroup without previous File specification";
+        return;
+    }
+
+    KConfigGroup cg = KConfigUtils::openGroup(m_oldConfig2, m_oldGroup);
+    if (!cg.exists()) {
+        return;
+    }
+    // Delete group.
+    cg.deleteGroup();
+    qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": RemoveGroup removes group" << m_oldFile << ":" << m_oldGroup;
+}
+
+void KonfUpdate::gotKey(const QString &_key)
+{
+    QString oldKey;
+    QString newKey;
+    const int i = _key.indexOf(QLatin1Char{','});
+    if (i == -1) {
+        oldKey = _key.trimmed();
+        newKey = oldKey;
+    } else {
+        oldKey = _key.left(i).trimmed();
+        newKey = _key.mid(i + 1).trimmed();
+    }
+
+    if (oldKey.isEmpty() || newKey.isEmpty()) {
+        qCDebugFile(KCONF_UPDATE_LOG) << "Key specifies invalid key";
+        return;
+    }
+    if (!m_oldConfig1) {
+        qCDebugFile(KCONF_UPDATE_LOG) << "Key without previous File specification";
+        return;
+    }
+    copyOrMoveKey(m_oldGroup, oldKey, m_newGroup, newKey);
+}
+
+void KonfUpdate::copyOrMoveKey(const QStringList &srcGroupPath, const QString &srcKey, const QStringList &dstGroupPath, const QString &dstKey)
+{
+    KConfigGroup dstCg = KConfigUtils::openGroup(m_newConfig, dstGroupPath);
+    if (!m_bOverwrite && dstCg.hasKey(dstKey)) {
+        qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": Skipping" << m_newFileName << ":" << dstCg.name() << ":" << dstKey << ", already exists.";
+        return;
+    }
+
+    KConfigGroup srcCg = KConfigUtils::openGroup(m_oldConfig1, srcGroupPath);
+    const std::optional<QString> srcValue = srcCg.tryReadEntry<QString>(srcKey);
+    if (!srcValue) {
+        return;
+    }
+    const QString &value = *srcValue;
+    qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": Updating" << m_newFileName << ":" << dstCg.name() << ":" << dstKey << "to" << value;
+    dstCg.writeEntry(dstKey, value);
+
+    if (m_bCopy) {
+        return; // Done.
+    }
+
+    // Delete old entry
+    if (m_oldConfig2 == m_newConfig && srcGroupPath == dstGroupPath && srcKey == dstKey) {
+        return; // Don't delete!
+    }
+    KConfigGroup srcCg2 = KConfigUtils::openGroup(m_oldConfig2, srcGroupPath);
+    srcCg2.deleteEntry(srcKey);
+    qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": Removing" << m_oldFile << ":" << srcCg2.name() << ":" << srcKey << ", moved.";
+}
+
+void KonfUpdate::copyOrMoveGroup(const QStringList &srcGroupPath, const QStringList &dstGroupPath)
+{
+    KConfigGroup cg = KConfigUtils::openGroup(m_oldConfig1, srcGroupPath);
+
+    // Keys
+    const QStringList lstKeys = cg.keyList();
+    for (const QString &key : lstKeys) {
+        copyOrMoveKey(srcGroupPath, key, dstGroupPath, key);
+    }
+
+    // Subgroups
+    const QStringList lstGroup = cg.groupList();
+    for (const QString &group : lstGroup) {
+        const QStringList groupPath(group);
+        copyOrMoveGroup(srcGroupPath + groupPath, dstGroupPath + groupPath);
+    }
+}
+
+void KonfUpdate::gotRemoveKey(const QString &_key)
+{
+    QString key = _key.trimmed();
+
+    if (key.isEmpty()) {
+        qCDebugFile(KCONF_UPDATE_LOG) << "RemoveKey specifies invalid key";
+        return;
+    }
+
+    if (!m_oldConfig1) {
+        qCDebugFile(KCONF_UPDATE_LOG) << "Key without previous File specification";
+        return;
+    }
+
+    KConfigGroup cg1 = KConfigUtils::openGroup(m_oldConfig1, m_oldGroup);
+    if (!cg1.hasKey(key)) {
+        return;
+    }
+    qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": RemoveKey removes" << m_oldFile << ":" << m_oldGroup << ":" << key;
+
+    // Delete old entry
+    KConfigGroup cg2 = KConfigUtils::openGroup(m_oldConfig2, m_oldGroup);
+    cg2.deleteEntry(key);
+    /*if (m_oldConfig2->deleteGroup(m_oldGroup, KConfig::Normal)) { // Delete group if empty.
+       qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": Removing empty group " << m_oldFile << ":" << m_oldGroup;
+    }   (this should be automatic)*/
+}
+
+void KonfUpdate::gotAllKeys()
+{
+    if (!m_oldConfig1) {
+        qCDebugFile(KCONF_UPDATE_LOG) << "AllKeys without previous File specification";
+        return;
+    }
+
+    copyOrMoveGroup(m_oldGroup, m_newGroup);
+}
+
+void KonfUpdate::gotAllGroups()
+{
+    if (!m_oldConfig1) {
+        qCDebugFile(KCONF_UPDATE_LOG) << "AllGroups without previous File specification";
+        return;
+    }
+
+    const QStringList allGroups = m_oldConfig1->groupList();
+    for (const auto &grp : allGroups) {
+        m_oldGroup = QStringList{grp};
+        m_newGroup = m_oldGroup;
+        gotAllKeys();
+    }
+}
+
+void KonfUpdate::gotOptions(const QString &_options)
+{
+    const QStringList options = _options.split(QLatin1Char{','});
+    for (const auto &opt : options) {
+        const auto normalizedOpt = QStringView(opt).trimmed();
+
+        if (caseInsensitiveCompare(normalizedOpt, QLatin1String("copy"))) {
+            m_bCopy = true;
+        } else if (caseInsensitiveCompare(normalizedOpt, QLatin1String("overwrite"))) {
+            m_bOverwrite = true;
+        }
+    }
+}
+
+void KonfUpdate::copyGroup(const KConfigBase *cfg1, const QString &group1, KConfigBase *cfg2, const QString &group2)
+{
+    KConfigGroup cg2 = cfg2->group(group2);
+    copyGroup(cfg1->group(group1), cg2);
+}
+
+void KonfUpdate::copyGroup(const KConfigGroup &cg1, KConfigGroup &cg2)
+{
+    // Copy keys
+    const auto map = cg1.entryMap();
+    for (auto it = map.cbegin(); it != map.cend(); ++it) {
+        if (m_bOverwrite || !cg2.hasKey(it.key())) {
+            cg2.writeEntry(it.key(), it.value());
+        }
+    }
+
+    // Copy subgroups
+    const QStringList lstGroup = cg1.groupList();
+    for (const QString &group : lstGroup) {
+        copyGroup(&cg1, group, &cg2, group);
+    }
+}
+
+void KonfUpdate::gotScriptArguments(const QString &_arguments)
+{
+    m_arguments = _arguments;
+}
+
+void KonfUpdate::gotScript(const QString &_script)
+{
+    QString script;
+    QString interpreter;
+    const int i = _script.indexOf(QLatin1Char{','});
+    if (i == -1) {
+        script = _script.trimmed();
+    } else {
+        script = _script.left(i).trimmed();
+        interpreter = _script.mid(i + 1).trimmed();
+    }
+
+    if (script.isEmpty()) {
+        qCDebugFile(KCONF_UPDATE_LOG) << "Script fails to specify filename";
+        m_skip = true;
+        return;
+    }
+
+    QString path = QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1String("kconf_update/") + script);
+    if (path.isEmpty()) {
+        if (interpreter.isEmpty()) {
+            path = QStringLiteral("%1/kconf_update_bin/%2").arg(QStringLiteral(CMAKE_INSTALL_FULL_LIBDIR), script);
+            if (!QFile::exists(path)) {
+                path = QStandardPaths::findExecutable(script);
+            }
+        }
+
+        if (path.isEmpty()) {
+            qCDebugFile(KCONF_UPDATE_LOG) << "Script" << script << "not found";
+            m_skip = true;
+            return;
+        }
+    }
+
+    if (!m_arguments.isNull()) {
+        qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": Running script" << script << "with arguments" << m_arguments;
+    } else {
+        qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": Running script" << script;
+    }
+
+    QStringList args;
+    QString cmd;
+    if (interpreter.isEmpty()) {
+        cmd = path;
+    } else {
+        QString interpreterPath = QStandardPaths::findExecutable(interpreter);
+        if (interpreterPath.isEmpty()) {
+            qCDebugFile(KCONF_UPDATE_LOG) << "Cannot find interpreter" << interpreter;
+            m_skip = true;
+            return;
+        }
+        cmd = interpreterPath;
+        args << path;
+    }
+
+    if (!m_arguments.isNull()) {
+        args += m_arguments;
+    }
+
+    auto job = std::make_unique<ScriptJob>();
+    if (!job->scriptIn.open() || !job->scriptOut.open() || !job->scriptErr.open()) {
+        qCDebugFile(KCONF_UPDATE_LOG) << "Could not create temporary file!";
+        return;
+    }
+
+    job->cmd = cmd;
+    job->updateFileName = m_currentFilename;
+    job->id = m_id;
+    job->oldFile = m_oldFile;
+    job->oldConfig2 = m_oldConfig2;
+    job->newConfig = m_newConfig;
+    job->oldGroup = m_oldGroup;
+    job->newGroup = m_newGroup;
+    job->process.setProcessChannelMode(QProcess::SeparateChannels);
+    job->process.setStandardInputFile(job->scriptIn.fileName());
+    job->process.setStandardOutputFile(job->scriptOut.fileName());
+    job->process.setStandardErrorFile(job->scriptErr.fileName());
+    if (m_oldConfig1) {
+        if (m_bDebugOutput) {
+            qCDebug(KCONF_UPDATE_LOG) << "Script input stored in" << job->scriptIn.fileName();
+        }
+        KConfig cfg(job->scriptIn.fileName(), KConfig::SimpleConfig);
+
+        if (m_oldGroup.isEmpty()) {
+            // Write all entries to tmpFile;
+            const QStringList grpList = m_oldConfig1->groupList();
+            for (const auto &grp : grpList) {
+                copyGroup(m_oldConfig1, grp, &cfg, grp);
+            }
+        } else {
+            KConfigGroup cg1 = KConfigUtils::openGroup(m_oldConfig1, m_oldGroup);
+            KConfigGroup cg2(&cfg, QString());
+            copyGroup(cg1, cg2);
+        }
+        cfg.sync();
+    } else {
+        // without a File= line, the script reads and writes whatever it wants itself
+        finishAllScripts();
+        syncTargets();
+    }
+
+    qCDebug(KCONF_UPDATE_LOG) << "About to run" << cmd;
+    if (m_bDebugOutput) {
+        QFile scriptFile(path);
+        if (scriptFile.open(QIODevice::ReadOnly)) {
+            qCDebug(KCONF_UPDATE_LOG) << "Script contents is:\n" << scriptFile.readAll();
+        }
+    }
+
+    // at most as many scripts as cores run at the same time
+    while (m_scriptJobs.size() >= std::max(1, QThread::idealThreadCount())) {
+        finishScript(m_scriptJobs.first());
+    }
+
+    job->process.start(cmd, args);
+    job->deadline.setRemainingTime(60000);
+    m_currentScript = job.get();
+    m_scriptJobs.append(job.release());
+
+    if (!m_oldConfig1) {
+        finishScript(m_currentScript);
+        for (KConfig *config : std::as_const(m_targets)) {
+            config->reparseConfiguration();
+        }
+    }
+}
+
+// Waits for @p job, merges its output and records the update it belongs to as
+// done, if that update was already closed while the script was running
+void KonfUpdate::finishScript(ScriptJob *job)
+{
+    const std::unique_ptr<ScriptJob> deleter(job);
+    m_scriptJobs.removeOne(job);
+    const bool current = job == m_currentScript;
+    if (current) {
+        m_currentScript = nullptr;
+    }
+
+    QProcess &proc = job->process;
+    if (!proc.waitForFinished(int(std::max<qint64>(0, job->deadline.remainingTime())))) {
+        qCDebug(KCONF_UPDATE_LOG) << job->updateFileName << ": update script did not terminate within 60 seconds:" << job->cmd;
+        if (current) {
+            m_skip = true;
+        }
+        return;
+    }
+    const int result = proc.exitCode();
+
+    // Copy script stderr to log file
+    {
+        QTextStream ts(&job->scriptErr);
+        while (!ts.atEnd()) {
+            QString line = ts.readLine();
+            qCDebug(KCONF_UPDATE_LOG) << "[Script]" << line;
+        }
+    }
+    proc.close();
+
+    if (result != EXIT_SUCCESS) {
+        qCDebug(KCONF_UPDATE_LOG) << job->updateFileName << ": !! An error occurred while running" << job->cmd;
+        recordScriptUpdate(job);
+        return;
+    }
+
+    qCDebug(KCONF_UPDATE_LOG) << "Successfully ran" << job->cmd;
+
+    if (!job->oldConfig2) {
+        recordScriptUpdate(job);
+        return; // Nothing to merge
+    }
+
+    if (m_bDebugOutput) {
+        qCDebug(KCONF_UPDATE_LOG) << "Script output stored in" << job->scriptOut.fileName();
+        QFile output(job->scriptOut.fileName());
+        if (output.open(QIODevice::ReadOnly)) {
+            qCDebug(KCONF_UPDATE_LOG) << "Script output is:\n" << output.readAll();
+        }
+    }
+
+    // Deleting old entries
+    {
+        QStringList group = job->oldGroup;
+        QFile output(job->scriptOut.fileName());
+        if (output.open(QIODevice::ReadOnly)) {
+            QTextStream ts(&output);
+            while (!ts.atEnd()) {
+                const QString line = ts.readLine();
+                if (line.startsWith(QLatin1Char{'['})) {
+                    group = parseGroupString(line);
+                } else if (line.startsWith(QLatin1String("# DELETE "))) {
+                    QString key = line.mid(9);
+                    if (key.startsWith(QLatin1Char{'['})) {
+                        const int idx = key.lastIndexOf(QLatin1Char{']'}) + 1;
+                        if (idx > 0) {
+                            group = parseGroupString(key.left(idx));
+                            key = key.mid(idx);
+                        }
+                    }
+                    KConfigGroup cg = KConfigUtils::openGroup(job->oldConfig2, group);
+                    cg.deleteEntry(key);
+                    qCDebug(KCONF_UPDATE_LOG) << job->updateFileName << ": Script removes" << job->oldFile << ":" << group << ":" << key;
+                    /*if (m_oldConfig2->deleteGroup(group, KConfig::Normal)) { // Delete group if empty.
+                       qCDebug(KCONF_UPDATE_LOG) << m_currentFilename << ": Removing empty group " << m_oldFile << ":" << group;
+                    } (this should be automatic)*/
+                } else if (line.startsWith(QLatin1String("# DELETEGROUP"))) {
+                    const QString str = line.mid(13).trimmed();
+                    if (!str.isEmpty()) {
+                        group = parseGroupString(str);
+                    }
+                    KConfigGroup cg = KConfigUtils::openGroup(job->oldConfig2, group);
+                    cg.deleteGroup();
+                    qCDebug(KCONF_UPDATE_LOG) << job->updateFileName << ": Script removes group" << job->oldFile << ":" << group;
+                }
+            }
+        }
+    }
+
+    // Merging in new entries.
+    KConfig scriptOutConfig(job->scriptOut.fileName(), KConfig::NoGlobals);
+    if (job->newGroup.isEmpty()) {
+        // Copy "default" keys as members of "default" keys
+        copyGroup(&scriptOutConfig, QString(), job->newConfig, QString());
+    } else {
+        // Copy default keys as members of m_newGroup
+        KConfigGroup srcCg = KConfigUtils::openGroup(&scriptOutConfig, QStringList());
+        KConfigGroup dstCg = KConfigUtils::openGroup(job->newConfig, job->newGroup);
+        copyGroup(srcCg, dstCg);
+    }
+    const QStringList lstGroup = scriptOutConfig.groupList();
+    for (const QString &group : lstGroup) {
+        copyGroup(&scriptOutConfig, group, job->newConfig, group);
+    }
+    recordScriptUpdate(job);
+}
+
+// Records the update of @p job as done, if it was closed while the script ran
+void KonfUpdate::recordScriptUpdate(const ScriptJob *job)
+{
+    for (KConfig *config : job->versionConfigs) {
+        addUpdateInfo(config, job->updateFileName + QLatin1Char{':'} + job->id);
+    }
+    if (job->recordDone) {
+        addDoneId(job->updateFileName, job->id);
+    }
+}
+
+// Waits for the scripts that change @p config, in the order they were started
+void KonfUpdate::finishScripts(const KConfig *config)
+{
+    const QList<ScriptJob *> jobs = m_scriptJobs;
+    for (ScriptJob *job : jobs) {
+        if (job->oldConfig2 == config || job->newConfig == config) {
+            finishScript(job);
+        }
+    }
+}
+
+void KonfUpdate::finishAllScripts()
+{
+    while (!m_scriptJobs.isEmpty()) {
+        finishScript(m_scriptJobs.first());
+    }
+}
+
+void KonfUpdate::resetOptions()
+{
+    m_bCopy = false;
+    m_bOverwrite = false;
+    m_arguments.clear();
+}
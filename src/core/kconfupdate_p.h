@@ -0,0 +1,141 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2001 Waldo Bastian <bastian@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-only
+*/
+
+#ifndef KCONFUPDATE_P_H
+#define KCONFUPDATE_P_H
+
+#include <QHash>
+#include <QList>
+#include <QStringList>
+
+#include <kconfigcore_export.h>
+
+class QFile;
+class QTextStream;
+
+class KConfig;
+class KConfigBase;
+class KConfigGroup;
+
+struct ScriptJob;
+
+/**
+ * The engine of kconf_update, which applies the updates described in the
+ * update-files (*.upd) in kconf_update/ to the config files.
+ *
+ * The kconf_update executable runs it for the update-files that changed,
+ * KConfig::checkUpdate() runs it in the application for the one it is
+ * given, on the config it was called on.
+ *
+ * @internal
+ */
+class KCONFIGCORE_EXPORT KonfUpdate
+{
+public:
+    struct Options {
+        /** Enable the debug output of kf.config.kconf_update and keep the output of scripts */
+        bool debugOutput = false;
+        /** Use the test directories of QStandardPaths */
+        bool testMode = false;
+        /** The name of an update-file in kconf_update/ to check the configs against, as for --check */
+        QString check;
+        /** The update-files to apply, all of them that changed if empty and there is no @c check */
+        QStringList files;
+    };
+
+    /**
+     * Applies the updates selected by @p options.
+     *
+     * If @p target is set, the updates to the file it was opened for are
+     * applied to it and written from it, instead of from a KConfig of
+     * its own. It must have been opened with KConfig::NoGlobals on a file
+     * name in QStandardPaths::GenericConfigLocation, the way kconf_update
+     * opens the files.
+     */
+    explicit KonfUpdate(const Options &options, KConfig *target = nullptr);
+    ~KonfUpdate();
+
+    KonfUpdate(const KonfUpdate &) = delete;
+    KonfUpdate &operator=(const KonfUpdate &) = delete;
+
+    QStringList findUpdateFiles(bool dirtyOnly);
+    QByteArray updateDirsStamp() const;
+
+    bool checkFile(const QString &filename);
+    void checkGotFile(const QString &_file, const QString &id);
+
+    bool updateFile(const QString &filename);
+
+    KConfig *targetConfig(const QString &file);
+    void syncTargets();
+    void addDoneId(const QString &updateFileName, const QString &id);
+    void addUpdateInfo(KConfig *config);
+    void addUpdateInfo(KConfig *config, const QString &cfgId);
+
+    void gotId(const QString &_id);
+    void gotFile(const QString &_file);
+    void gotGroup(const QString &_group);
+    void gotRemoveGroup(const QString &_group);
+    void gotKey(const QString &_key);
+    void gotRemoveKey(const QString &_key);
+    void gotAllKeys();
+    void gotAllGroups();
+    void gotOptions(const QString &_options);
+    void gotScript(const QString &_script);
+    void gotScriptArguments(const QString &_arguments);
+    void finishScript(ScriptJob *job);
+    void recordScriptUpdate(const ScriptJob *job);
+    void finishScripts(const KConfig *config);
+    void finishAllScripts();
+    void resetOptions();
+
+    void copyGroup(const KConfigBase *cfg1, const QString &group1, KConfigBase *cfg2, const QString &group2);
+    void copyGroup(const KConfigGroup &cg1, KConfigGroup &cg2);
+    void copyOrMoveKey(const QStringList &srcGroupPath, const QString &srcKey, const QStringList &dstGroupPath, const QString &dstKey);
+    void copyOrMoveGroup(const QStringList &srcGroupPath, const QStringList &dstGroupPath);
+
+    QStringList parseGroupString(const QString &_str);
+
+protected:
+    /** kconf_updaterc */
+    KConfig *m_config;
+    QString m_currentFilename;
+    bool m_skip;
+    bool m_skipFile;
+    bool m_bTestMode;
+    bool m_bDebugOutput;
+    QString m_id;
+
+    QString m_oldFile;
+    QString m_newFile;
+    QString m_newFileName;
+    KConfig *m_oldConfig1; // Config to read keys from.
+    KConfig *m_oldConfig2; // Config to delete keys from.
+    KConfig *m_newConfig;
+    /** The configs the updates are applied to, each one written once all of them are done */
+    QHash<QString, KConfig *> m_targets;
+    /** The config passed to the constructor, one of m_targets that isn't ours to delete */
+    KConfig *m_target;
+    /** The scripts still running, in the order they were started */
+    QList<ScriptJob *> m_scriptJobs;
+    /** The script of the current update, if it is still running */
+    ScriptJob *m_currentScript = nullptr;
+
+    QStringList m_oldGroup;
+    QStringList m_newGroup;
+
+    bool m_bCopy;
+    bool m_bOverwrite;
+    bool m_bUseConfigInfo;
+    QString m_arguments;
+    QTextStream *m_textStream;
+    QFile *m_file;
+    QString m_line;
+    int m_lineCount;
+};
+
+#endif // KCONFUPDATE_P_H
@@ -7,11 +7,14 @@
 */
 
 #include "kcoreconfigskeleton.h"
+#include "kconfig_p.h"
 #include "kcoreconfigskeleton_p.h"
+#include "kconfigtrace_p.h"
 
 #include <QUrl>
 
 #include <algorithm>
+#include <utility>
 
 static QString obscuredString(const QString &str)
 {
@@ -49,7 +52,11 @@ KConfigSkeletonItem::~KConfigSkeletonItem()
 
 void KConfigSkeletonItem::setGroup(const QString &_group)
 {
-    mGroup = _group;
+    Q_D(KConfigSkeletonItem);
+    const QString oldGroup = std::exchange(mGroup, _group);
+    if (d->mSkeleton) {
+        d->mSkeleton->reindexItem(this, oldGroup, mKey);
+    }
 }
 
 void KConfigSkeletonItem::setGroup(const KConfigGroup &cg)
@@ -64,6 +71,9 @@ KConfigGroup KConfigSkeletonItem::configGroup(KConfig *config) const
     if (d->mConfigGroup.isValid()) {
         return d->mConfigGroup;
     }
+    if (d->mSharedGroup.isValid() && d->mSharedGroup.config() == config) {
+        return d->mSharedGroup;
+    }
     return KConfigGroup(config, mGroup);
 }
 
@@ -74,7 +84,11 @@ QString KConfigSkeletonItem::group() const
 
 void KConfigSkeletonItem::setKey(const QString &_key)
 {
-    mKey = _key;
+    Q_D(KConfigSkeletonItem);
+    const QString oldKey = std::exchange(mKey, _key);
+    if (d->mSkeleton) {
+        d->mSkeleton->reindexItem(this, mGroup, oldKey);
+    }
 }
 
 QString KConfigSkeletonItem::key() const
@@ -82,6 +96,16 @@ QString KConfigSkeletonItem::key() const
     return mKey;
 }
 
+const char *KConfigSkeletonItem::keyUtf8() const
+{
+    // subclasses may assign mKey without setKey(), so compare to what was converted
+    if (d_ptr->mKeyUtf8.isNull() || d_ptr->mConvertedKey != mKey) {
+        d_ptr->mConvertedKey = mKey;
+        d_ptr->mKeyUtf8 = mKey.toUtf8();
+    }
+    return d_ptr->mKeyUtf8.constData();
+}
+
 void KConfigSkeletonItem::setName(const QString &_name)
 {
     mName = _name;
@@ -174,10 +198,18 @@ QVariant KConfigSkeletonItem::getDefault() const
     return d->mGetDefaultImpl();
 }
 
+void KConfigSkeletonItem::markChanged()
+{
+    Q_D(KConfigSkeletonItem);
+    if (d->mSkeleton) {
+        d->mSkeleton->markChanged(this);
+    }
+}
+
 void KConfigSkeletonItem::readImmutability(const KConfigGroup &group)
 {
     Q_D(KConfigSkeletonItem);
-    d->mIsImmutable = group.isEntryImmutable(mKey);
+    d->mIsImmutable = group.isEntryImmutable(keyUtf8());
 }
 
 void KConfigSkeletonItem::setIsDefaultImpl(const std::function<bool()> &impl)
@@ -228,6 +260,7 @@ void KPropertySkeletonItem::setProperty(const QVariant &p)
         return;
     }
     d->mReference = p;
+    markChanged();
     if (d->mNotifyFunction) {
         d->mNotifyFunction();
     }
@@ -293,14 +326,14 @@ void KCoreConfigSkeleton::ItemString::writeConfig(KConfig *config)
 {
     if (mReference != mLoadedValue) { // WABA: Is this test needed?
         KConfigGroup cg = configGroup(config);
-        if ((mDefault == mReference) && !cg.hasDefault(mKey)) {
-            cg.revertToDefault(mKey, writeFlags());
+        if ((mDefault == mReference) && !cg.hasDefault(keyUtf8())) {
+            cg.revertToDefault(keyUtf8(), writeFlags());
         } else if (mType == Path) {
-            cg.writePathEntry(mKey, mReference, writeFlags());
+            cg.writePathEntry(keyUtf8(), mReference, writeFlags());
         } else if (mType == Password) {
-            cg.writeEntry(mKey, obscuredString(mReference), writeFlags());
+            cg.writeEntry(keyUtf8(), obscuredString(mReference), writeFlags());
         } else {
-            cg.writeEntry(mKey, mReference, writeFlags());
+            cg.writeEntry(keyUtf8(), mReference, writeFlags());
         }
         mLoadedValue = mReference;
     }
@@ -311,12 +344,12 @@ void KCoreConfigSkeleton::ItemString::readConfig(KConfig *config)
     KConfigGroup cg = configGroup(config);
 
     if (mType == Path) {
-        mReference = cg.readPathEntry(mKey, mDefault);
+        mReference = cg.readPathEntry(keyUtf8(), mDefault);
     } else if (mType == Password) {
-        QString val = cg.readEntry(mKey, obscuredString(mDefault));
+        QString val = cg.readEntry(keyUtf8(), obscuredString(mDefault));
         mReference = obscuredString(val);
     } else {
-        mReference = cg.readEntry(mKey, mDefault);
+        mReference = cg.readEntry(keyUtf8(), mDefault);
     }
 
     mLoadedValue = mReference;
@@ -327,6 +360,7 @@ void KCoreConfigSkeleton::ItemString::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemString::setProperty(const QVariant &p)
 {
     mReference = p.toString();
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemString::isEqual(const QVariant &v) const
@@ -358,10 +392,10 @@ void KCoreConfigSkeleton::ItemUrl::writeConfig(KConfig *config)
 {
     if (mReference != mLoadedValue) { // WABA: Is this test needed?
         KConfigGroup cg = configGroup(config);
-        if ((mDefault == mReference) && !cg.hasDefault(mKey)) {
-            cg.revertToDefault(mKey, writeFlags());
+        if ((mDefault == mReference) && !cg.hasDefault(keyUtf8())) {
+            cg.revertToDefault(keyUtf8(), writeFlags());
         } else {
-            cg.writeEntry<QString>(mKey, mReference.toString(), writeFlags());
+            cg.writeEntry<QString>(keyUtf8(), mReference.toString(), writeFlags());
         }
         mLoadedValue = mReference;
     }
@@ -371,7 +405,7 @@ void KCoreConfigSkeleton::ItemUrl::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
 
-    mReference = QUrl(cg.readEntry<QString>(mKey, mDefault.toString()));
+    mReference = QUrl(cg.readEntry<QString>(keyUtf8(), mDefault.toString()));
     mLoadedValue = mReference;
 
     readImmutability(cg);
@@ -380,6 +414,7 @@ void KCoreConfigSkeleton::ItemUrl::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemUrl::setProperty(const QVariant &p)
 {
     mReference = qvariant_cast<QUrl>(p);
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemUrl::isEqual(const QVariant &v) const
@@ -400,7 +435,7 @@ KCoreConfigSkeleton::ItemProperty::ItemProperty(const QString &_group, const QSt
 void KCoreConfigSkeleton::ItemProperty::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readEntry(keyUtf8(), mDefault);
     mLoadedValue = mReference;
 
     readImmutability(cg);
@@ -409,6 +444,7 @@ void KCoreConfigSkeleton::ItemProperty::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemProperty::setProperty(const QVariant &p)
 {
     mReference = p;
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemProperty::isEqual(const QVariant &v) const
@@ -430,7 +466,7 @@ KCoreConfigSkeleton::ItemBool::ItemBool(const QString &_group, const QString &_k
 void KCoreConfigSkeleton::ItemBool::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readBoolEntry(keyUtf8(), mDefault);
     mLoadedValue = mReference;
 
     readImmutability(cg);
@@ -439,6 +475,7 @@ void KCoreConfigSkeleton::ItemBool::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemBool::setProperty(const QVariant &p)
 {
     mReference = p.toBool();
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemBool::isEqual(const QVariant &v) const
@@ -461,7 +498,7 @@ KCoreConfigSkeleton::ItemInt::ItemInt(const QString &_group, const QString &_key
 void KCoreConfigSkeleton::ItemInt::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readIntEntry(keyUtf8(), mDefault);
     if (mHasMin) {
         mReference = qMax(mReference, mMin);
     }
@@ -476,6 +513,7 @@ void KCoreConfigSkeleton::ItemInt::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemInt::setProperty(const QVariant &p)
 {
     mReference = p.toInt();
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemInt::isEqual(const QVariant &v) const
@@ -526,7 +564,7 @@ KCoreConfigSkeleton::ItemLongLong::ItemLongLong(const QString &_group, const QSt
 void KCoreConfigSkeleton::ItemLongLong::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readInt64Entry(keyUtf8(), mDefault);
     if (mHasMin) {
         mReference = qMax(mReference, mMin);
     }
@@ -541,6 +579,7 @@ void KCoreConfigSkeleton::ItemLongLong::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemLongLong::setProperty(const QVariant &p)
 {
     mReference = p.toLongLong();
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemLongLong::isEqual(const QVariant &v) const
@@ -592,6 +631,7 @@ QString KCoreConfigSkeleton::ItemEnum::valueForChoice(const QString &name) const
 void KCoreConfigSkeleton::ItemEnum::setValueForChoice(const QString &name, const QString &value)
 {
     d_ptr->mValues.insert(name, value);
+    d_ptr->mChoiceIndexes.clear();
 }
 
 KCoreConfigSkeleton::ItemEnum::ItemEnum(const QString &_group, const QString &_key, qint32 &reference, const QList<Choice> &choices, qint32 defaultValue)
@@ -603,21 +643,30 @@ KCoreConfigSkeleton::ItemEnum::ItemEnum(const QString &_group, const QString &_k
 void KCoreConfigSkeleton::ItemEnum::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    if (!cg.hasKey(mKey)) {
+    const QString entryString = cg.readEntry(keyUtf8(), QString());
+    if (entryString.isNull()) {
         mReference = mDefault;
     } else {
-        int i = 0;
-        mReference = -1;
-        const QString entryString = cg.readEntry(mKey, QString());
-        for (auto it = mChoices.cbegin(); it != mChoices.cend(); ++it, ++i) {
-            QString choiceName = (*it).name;
-            if (valueForChoice(choiceName).compare(entryString, Qt::CaseInsensitive) == 0) {
-                mReference = i;
-                break;
+        // the values are compared case insensitively, the first choice with one wins
+        QHash<QString, int> &indexes = d_ptr->mChoiceIndexes;
+        if (indexes.isEmpty()) {
+            for (int i = 0; i < mChoices.size(); ++i) {
+                const QString value = valueForChoice(mChoices.at(i).name).toCaseFolded();
+                if (!indexes.contains(value)) {
+                    indexes.insert(value, i);
+                }
             }
         }
-        if (mReference == -1) {
-            mReference = cg.readEntry(mKey, mDefault);
+        const auto it = indexes.constFind(entryString.toCaseFolded());
+        if (it != indexes.cend()) {
+            mReference = it.value();
+        } else {
+            // not a choice, the index itself then
+            bool ok = false;
+            mReference = entryString.toInt(&ok);
+            if (!ok) {
+                mReference = mDefault;
+            }
         }
     }
     mLoadedValue = mReference;
@@ -629,12 +678,12 @@ void KCoreConfigSkeleton::ItemEnum::writeConfig(KConfig *config)
 {
     if (mReference != mLoadedValue) { // WABA: Is this test needed?
         KConfigGroup cg = configGroup(config);
-        if ((mDefault == mReference) && !cg.hasDefault(mKey)) {
-            cg.revertToDefault(mKey, writeFlags());
+        if ((mDefault == mReference) && !cg.hasDefault(keyUtf8())) {
+            cg.revertToDefault(keyUtf8(), writeFlags());
         } else if ((mReference >= 0) && (mReference < mChoices.count())) {
-            cg.writeEntry(mKey, valueForChoice(mChoices.at(mReference).name), writeFlags());
+            cg.writeEntry(keyUtf8(), valueForChoice(mChoices.at(mReference).name), writeFlags());
         } else {
-            cg.writeEntry(mKey, mReference, writeFlags());
+            cg.writeEntry(keyUtf8(), mReference, writeFlags());
         }
         mLoadedValue = mReference;
     }
@@ -655,7 +704,7 @@ KCoreConfigSkeleton::ItemUInt::ItemUInt(const QString &_group, const QString &_k
 void KCoreConfigSkeleton::ItemUInt::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readEntry(keyUtf8(), mDefault);
     if (mHasMin) {
         mReference = qMax(mReference, mMin);
     }
@@ -670,6 +719,7 @@ void KCoreConfigSkeleton::ItemUInt::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemUInt::setProperty(const QVariant &p)
 {
     mReference = p.toUInt();
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemUInt::isEqual(const QVariant &v) const
@@ -720,7 +770,7 @@ KCoreConfigSkeleton::ItemULongLong::ItemULongLong(const QString &_group, const Q
 void KCoreConfigSkeleton::ItemULongLong::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readEntry(keyUtf8(), mDefault);
     if (mHasMin) {
         mReference = qMax(mReference, mMin);
     }
@@ -735,6 +785,7 @@ void KCoreConfigSkeleton::ItemULongLong::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemULongLong::setProperty(const QVariant &p)
 {
     mReference = p.toULongLong();
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemULongLong::isEqual(const QVariant &v) const
@@ -785,7 +836,7 @@ KCoreConfigSkeleton::ItemDouble::ItemDouble(const QString &_group, const QString
 void KCoreConfigSkeleton::ItemDouble::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readDoubleEntry(keyUtf8(), mDefault);
     if (mHasMin) {
         mReference = qMax(mReference, mMin);
     }
@@ -800,6 +851,7 @@ void KCoreConfigSkeleton::ItemDouble::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemDouble::setProperty(const QVariant &p)
 {
     mReference = p.toDouble();
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemDouble::isEqual(const QVariant &v) const
@@ -848,7 +900,7 @@ KCoreConfigSkeleton::ItemRect::ItemRect(const QString &_group, const QString &_k
 void KCoreConfigSkeleton::ItemRect::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readEntry(keyUtf8(), mDefault);
     mLoadedValue = mReference;
 
     readImmutability(cg);
@@ -857,6 +909,7 @@ void KCoreConfigSkeleton::ItemRect::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemRect::setProperty(const QVariant &p)
 {
     mReference = p.toRect();
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemRect::isEqual(const QVariant &v) const
@@ -877,7 +930,7 @@ KCoreConfigSkeleton::ItemPoint::ItemPoint(const QString &_group, const QString &
 void KCoreConfigSkeleton::ItemPoint::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readEntry(keyUtf8(), mDefault);
     mLoadedValue = mReference;
 
     readImmutability(cg);
@@ -886,6 +939,7 @@ void KCoreConfigSkeleton::ItemPoint::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemPoint::setProperty(const QVariant &p)
 {
     mReference = p.toPoint();
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemPoint::isEqual(const QVariant &v) const
@@ -906,7 +960,7 @@ KCoreConfigSkeleton::ItemSize::ItemSize(const QString &_group, const QString &_k
 void KCoreConfigSkeleton::ItemSize::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readEntry(keyUtf8(), mDefault);
     mLoadedValue = mReference;
 
     readImmutability(cg);
@@ -915,6 +969,7 @@ void KCoreConfigSkeleton::ItemSize::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemSize::setProperty(const QVariant &p)
 {
     mReference = p.toSize();
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemSize::isEqual(const QVariant &v) const
@@ -935,7 +990,7 @@ KCoreConfigSkeleton::ItemDateTime::ItemDateTime(const QString &_group, const QSt
 void KCoreConfigSkeleton::ItemDateTime::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readEntry(keyUtf8(), mDefault);
     mLoadedValue = mReference;
 
     readImmutability(cg);
@@ -944,6 +999,7 @@ void KCoreConfigSkeleton::ItemDateTime::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemDateTime::setProperty(const QVariant &p)
 {
     mReference = p.toDateTime();
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemDateTime::isEqual(const QVariant &v) const
@@ -956,19 +1012,35 @@ QVariant KCoreConfigSkeleton::ItemDateTime::property() const
     return QVariant(mReference);
 }
 
+// Compares the lists of the items. QList compares lists sharing their data, or of
+// different sizes, without going through the elements, so @p other, the loaded or
+// default value, is made to share the data of an equal @p value. Settings pages ask
+// isSaveNeeded() and isDefault() on every edit, after the first time that's all it takes.
+template<typename List>
+static bool shareIfEqual(const List &value, List &other)
+{
+    if (value != other) {
+        return false;
+    }
+    other = value;
+    return true;
+}
+
 KCoreConfigSkeleton::ItemStringList::ItemStringList(const QString &_group, const QString &_key, QStringList &reference, const QStringList &defaultValue)
     : KConfigSkeletonGenericItem<QStringList>(_group, _key, reference, defaultValue)
 {
+    setIsDefaultImpl([this] {
+        return shareIfEqual(mReference, mDefault);
+    });
+    setIsSaveNeededImpl([this] {
+        return !shareIfEqual(mReference, mLoadedValue);
+    });
 }
 
 void KCoreConfigSkeleton::ItemStringList::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    if (!cg.hasKey(mKey)) {
-        mReference = mDefault;
-    } else {
-        mReference = cg.readEntry(mKey, mDefault);
-    }
+    mReference = cg.tryReadEntry<QStringList>(keyUtf8()).value_or(mDefault);
     mLoadedValue = mReference;
 
     readImmutability(cg);
@@ -977,6 +1049,7 @@ void KCoreConfigSkeleton::ItemStringList::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemStringList::setProperty(const QVariant &p)
 {
     mReference = p.toStringList();
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemStringList::isEqual(const QVariant &v) const
@@ -997,10 +1070,10 @@ KCoreConfigSkeleton::ItemPathList::ItemPathList(const QString &_group, const QSt
 void KCoreConfigSkeleton::ItemPathList::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    if (!cg.hasKey(mKey)) {
+    if (!cg.hasKey(keyUtf8())) {
         mReference = mDefault;
     } else {
-        mReference = cg.readPathEntry(mKey, QStringList());
+        mReference = cg.readPathEntry(keyUtf8(), QStringList());
     }
     mLoadedValue = mReference;
 
@@ -1011,11 +1084,11 @@ void KCoreConfigSkeleton::ItemPathList::writeConfig(KConfig *config)
 {
     if (mReference != mLoadedValue) { // WABA: Is this test needed?
         KConfigGroup cg = configGroup(config);
-        if ((mDefault == mReference) && !cg.hasDefault(mKey)) {
-            cg.revertToDefault(mKey, writeFlags());
+        if ((mDefault == mReference) && !cg.hasDefault(keyUtf8())) {
+            cg.revertToDefault(keyUtf8(), writeFlags());
         } else {
             QStringList sl = mReference;
-            cg.writePathEntry(mKey, sl, writeFlags());
+            cg.writePathEntry(keyUtf8(), sl, writeFlags());
         }
         mLoadedValue = mReference;
     }
@@ -1024,23 +1097,24 @@ void KCoreConfigSkeleton::ItemPathList::writeConfig(KConfig *config)
 KCoreConfigSkeleton::ItemUrlList::ItemUrlList(const QString &_group, const QString &_key, QList<QUrl> &reference, const QList<QUrl> &defaultValue)
     : KConfigSkeletonGenericItem<QList<QUrl>>(_group, _key, reference, defaultValue)
 {
+    setIsDefaultImpl([this] {
+        return shareIfEqual(mReference, mDefault);
+    });
+    setIsSaveNeededImpl([this] {
+        return !shareIfEqual(mReference, mLoadedValue);
+    });
 }
 
 void KCoreConfigSkeleton::ItemUrlList::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    if (!cg.hasKey(mKey)) {
-        mReference = mDefault;
-    } else {
-        QStringList strList;
-        for (const QUrl &url : std::as_const(mDefault)) {
-            strList.append(url.toString());
-        }
+    if (const std::optional<QStringList> readList = cg.tryReadEntry<QStringList>(keyUtf8())) {
         mReference.clear();
-        const QStringList readList = cg.readEntry<QStringList>(mKey, strList);
-        for (const QString &str : readList) {
+        for (const QString &str : *readList) {
             mReference.append(QUrl(str));
         }
+    } else {
+        mReference = mDefault;
     }
     mLoadedValue = mReference;
 
@@ -1051,14 +1125,14 @@ void KCoreConfigSkeleton::ItemUrlList::writeConfig(KConfig *config)
 {
     if (mReference != mLoadedValue) { // WABA: Is this test needed?
         KConfigGroup cg = configGroup(config);
-        if ((mDefault == mReference) && !cg.hasDefault(mKey)) {
-            cg.revertToDefault(mKey, writeFlags());
+        if ((mDefault == mReference) && !cg.hasDefault(keyUtf8())) {
+            cg.revertToDefault(keyUtf8(), writeFlags());
         } else {
             QStringList strList;
             for (const QUrl &url : std::as_const(mReference)) {
                 strList.append(url.toString());
             }
-            cg.writeEntry<QStringList>(mKey, strList, writeFlags());
+            cg.writeEntry<QStringList>(keyUtf8(), strList, writeFlags());
         }
         mLoadedValue = mReference;
     }
@@ -1067,6 +1141,7 @@ void KCoreConfigSkeleton::ItemUrlList::writeConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemUrlList::setProperty(const QVariant &p)
 {
     mReference = qvariant_cast<QList<QUrl>>(p);
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemUrlList::isEqual(const QVariant &v) const
@@ -1082,15 +1157,21 @@ QVariant KCoreConfigSkeleton::ItemUrlList::property() const
 KCoreConfigSkeleton::ItemIntList::ItemIntList(const QString &_group, const QString &_key, QList<int> &reference, const QList<int> &defaultValue)
     : KConfigSkeletonGenericItem<QList<int>>(_group, _key, reference, defaultValue)
 {
+    setIsDefaultImpl([this] {
+        return shareIfEqual(mReference, mDefault);
+    });
+    setIsSaveNeededImpl([this] {
+        return !shareIfEqual(mReference, mLoadedValue);
+    });
 }
 
 void KCoreConfigSkeleton::ItemIntList::readConfig(KConfig *config)
 {
     KConfigGroup cg = configGroup(config);
-    if (!cg.hasKey(mKey)) {
+    if (!cg.hasKey(keyUtf8())) {
         mReference = mDefault;
     } else {
-        mReference = cg.readEntry(mKey, mDefault);
+        mReference = cg.readEntry(keyUtf8(), mDefault);
     }
     mLoadedValue = mReference;
 
@@ -1100,6 +1181,7 @@ void KCoreConfigSkeleton::ItemIntList::readConfig(KConfig *config)
 void KCoreConfigSkeleton::ItemIntList::setProperty(const QVariant &p)
 {
     mReference = qvariant_cast<QList<int>>(p);
+    markChanged();
 }
 
 bool KCoreConfigSkeleton::ItemIntList::isEqual(const QVariant &v) const
@@ -1172,10 +1254,16 @@ KSharedConfig::Ptr KCoreConfigSkeleton::sharedConfig() const
 void KCoreConfigSkeleton::setSharedConfig(KSharedConfig::Ptr pConfig)
 {
     d->mConfig = std::move(pConfig);
+    d->mReadValid = false;
+    d->mLoadedStamps.clear();
+    if (d->mWatcher) {
+        watchConfig();
+    }
 }
 
 KConfigSkeletonItem::List KCoreConfigSkeleton::items() const
 {
+    d->createItems();
     return d->mItems;
 }
 
@@ -1186,9 +1274,9 @@ bool KCoreConfigSkeleton::useDefaults(bool b)
     }
 
     d->mUseDefaults = b;
-    for (auto *skelItem : std::as_const(d->mItems)) {
+    d->changeAllItems([](KConfigSkeletonItem *skelItem) {
         skelItem->swapDefault();
-    }
+    });
 
     usrUseDefaults(b);
     return !d->mUseDefaults;
@@ -1196,28 +1284,137 @@ bool KCoreConfigSkeleton::useDefaults(bool b)
 
 void KCoreConfigSkeleton::setDefaults()
 {
-    for (auto *skelItem : std::as_const(d->mItems)) {
+    d->changeAllItems([](KConfigSkeletonItem *skelItem) {
         skelItem->setDefault();
-    }
+    });
     usrSetDefaults();
 }
 
 void KCoreConfigSkeleton::load()
 {
-    d->mConfig->reparseConfiguration();
-    read();
+    KConfigPrivate *config = d->mConfig->d_func();
+    // taken before the files are parsed, a change while they are shows up next time
+    const QList<KConfigIniBackend::FileStamp> stamps = config->fileStamps();
+    // a dirty config is written before it is parsed again, which changes the files once more
+    const bool dirty = d->mConfig->isDirty();
+    if (dirty || stamps.isEmpty() || stamps != d->mLoadedStamps) {
+        d->mConfig->reparseConfiguration();
+        d->mLoadedStamps = dirty ? QList<KConfigIniBackend::FileStamp>() : stamps;
+    }
+
+    if (!d->mReadValid || d->mUseDefaults || d->mConfig->isImmutable() != d->mReadImmutable) {
+        read();
+        return;
+    }
+
+    // Only the items of the groups that changed since the last read() are read again,
+    // and those that were changed since, which load() resets
+    const bool entriesChanged = config->generation != d->mReadGeneration;
+    QHash<QString, bool> changedGroups;
+    KConfigSkeletonItem::List items;
+    for (auto *skelItem : std::as_const(d->mItems)) {
+        if (skelItem->d_func()->mConfigGroup.isValid()) {
+            items.append(skelItem);
+            continue;
+        }
+        if (entriesChanged) {
+            auto it = changedGroups.find(skelItem->mGroup);
+            if (it == changedGroups.end()) {
+                const QByteArray group = skelItem->mGroup.isEmpty() ? QByteArrayLiteral("<default>") : skelItem->mGroup.toUtf8();
+                config->loadLazyGroup(group);
+                it = changedGroups.insert(skelItem->mGroup, !config->entryMap.hasSameGroup(group, d->mReadEntries));
+            }
+            if (it.value()) {
+                items.append(skelItem);
+                continue;
+            }
+        }
+        if (skelItem->isSaveNeeded()) {
+            items.append(skelItem);
+        }
+    }
+
+    shareGroups(items, true);
+    for (auto *skelItem : std::as_const(items)) {
+        skelItem->readConfig(d->mConfig.data());
+    }
+    shareGroups(items, false);
+    if (entriesChanged) {
+        rememberRead();
+    }
+    if (d->mTrackChanges) {
+        d->resetChanges();
+    }
+    usrRead();
+    d->updateSnapshot(items);
+}
+
+void KCoreConfigSkeleton::shareGroups(const KConfigSkeletonItem::List &items, bool share)
+{
+    // Every item would look its group up on its own otherwise, the ones of a group
+    // share a single KConfigGroup and the place of the group it remembers.
+    QHash<QString, KConfigGroup> groups;
+    for (auto *skelItem : items) {
+        KConfigSkeletonItemPrivate *itemPrivate = skelItem->d_func();
+        if (!share) {
+            itemPrivate->mSharedGroup = KConfigGroup();
+        } else if (!itemPrivate->mConfigGroup.isValid()) {
+            auto it = groups.find(skelItem->mGroup);
+            if (it == groups.end()) {
+                it = groups.insert(skelItem->mGroup, KConfigGroup(d->mConfig.data(), skelItem->mGroup));
+            }
+            itemPrivate->mSharedGroup = it.value();
+        }
+    }
+}
+
+void KCoreConfigSkeleton::rememberRead()
+{
+    const KConfigPrivate *config = d->mConfig->d_func();
+    d->mReadEntries.clear();
+    for (auto *skelItem : std::as_const(d->mItems)) {
+        if (!skelItem->d_func()->mConfigGroup.isValid()) {
+            const QByteArray group = skelItem->mGroup.isEmpty() ? QByteArrayLiteral("<default>") : skelItem->mGroup.toUtf8();
+            d->mReadEntries.replaceGroup(group, config->entryMap);
+        }
+    }
+    d->mReadGeneration = config->generation;
+    d->mReadImmutable = d->mConfig->isImmutable();
+    d->mReadValid = true;
 }
 
 void KCoreConfigSkeleton::read()
 {
+    shareGroups(d->mItems, true);
     for (auto *skelItem : std::as_const(d->mItems)) {
         skelItem->readConfig(d->mConfig.data());
     }
+    shareGroups(d->mItems, false);
+    rememberRead();
+    if (d->mTrackChanges) {
+        d->resetChanges();
+    }
     usrRead();
+    d->updateSnapshot(d->mItems);
 }
 
 bool KCoreConfigSkeleton::isDefaults() const
 {
+    d->createItems();
+    if (d->mIsDefaultsImpl && !d->mIsDefaultsImpl()) {
+        return false;
+    }
+    if (d->mTrackChanges) {
+        // a changed item may have changed once more since it was marked
+        for (auto *skelItem : std::as_const(d->mChangedItems)) {
+            if (skelItem->isDefault()) {
+                d->mNonDefaultItems.remove(skelItem);
+            } else {
+                d->mNonDefaultItems.insert(skelItem);
+            }
+        }
+        return d->mNonDefaultItems.isEmpty();
+    }
     return std::all_of(d->mItems.cbegin(), d->mItems.cend(), [](KConfigSkeletonItem *skelItem) {
         return skelItem->isDefault();
     });
@@ -1225,17 +1422,49 @@ bool KCoreConfigSkeleton::isDefaults() const
 
 bool KCoreConfigSkeleton::isSaveNeeded() const
 {
+    if (d->mIsSaveNeededImpl && d->mIsSaveNeededImpl()) {
+        return true;
+    }
+    if (d->mTrackChanges) {
+        return std::any_of(d->mChangedItems.cbegin(), d->mChangedItems.cend(), [](KConfigSkeletonItem *skelItem) {
+            return skelItem->isSaveNeeded();
+        });
+    }
     return std::any_of(d->mItems.cbegin(), d->mItems.cend(), [](KConfigSkeletonItem *skelItem) {
         return skelItem->isSaveNeeded();
     });
 }
 
+void KCoreConfigSkeleton::setCreateItemsImpl(const std::function<void()> &impl)
+{
+    d->mCreateItemsImpl = impl;
+}
+
+void KCoreConfigSkeleton::setIsDefaultsImpl(const std::function<bool()> &impl)
+{
+    d->mIsDefaultsImpl = impl;
+}
+
+void KCoreConfigSkeleton::setIsSaveNeededImpl(const std::function<bool()> &impl)
+{
+    d->mIsSaveNeededImpl = impl;
+}
+
 bool KCoreConfigSkeleton::save()
 {
+    // with KCONFIG_TRACE, the sync is part of the same change
+    const KConfigTrace::ChangeScope change(KConfigTrace::currentOrNewChange());
+    const KConfigTrace::Span span("save", d->mConfig->name());
     // qDebug();
-    for (auto *skelItem : std::as_const(d->mItems)) {
+    // only the changed items can have something to write
+    const KConfigSkeletonItem::List items = d->mTrackChanges ? KConfigSkeletonItem::List(d->mChangedItems.cbegin(), d->mChangedItems.cend()) : d->mItems;
+    shareGroups(items, true);
+    for (auto *skelItem : items) {
         skelItem->writeConfig(d->mConfig.data());
     }
+    shareGroups(items, false);
+    d->mChangedItems.clear();
+    d->updateSnapshot(items);
 
     if (!usrSave()) {
         return false;
@@ -1250,6 +1479,124 @@ bool KCoreConfigSkeleton::save()
     return true;
 }
 
+void KCoreConfigSkeleton::setTrackChanges(bool track)
+{
+    if (track == d->mTrackChanges) {
+        return;
+    }
+    d->mTrackChanges = track;
+    d->resetChanges();
+    if (track) {
+        // the values may have changed since the last read(), unnoticed
+        d->mChangedItems = QSet<KConfigSkeletonItem *>(d->mItems.cbegin(), d->mItems.cend());
+    }
+}
+
+void KCoreConfigSkeleton::setAutoReload(bool reload)
+{
+    if (reload == autoReload()) {
+        return;
+    }
+    if (reload) {
+        watchConfig();
+    } else {
+        disconnect(d->mWatcher.data(), nullptr, this, nullptr);
+        d->mWatcher.reset();
+    }
+}
+
+bool KCoreConfigSkeleton::autoReload() const
+{
+    return !d->mWatcher.isNull();
+}
+
+void KCoreConfigSkeleton::watchConfig()
+{
+    if (d->mWatcher) {
+        disconnect(d->mWatcher.data(), nullptr, this, nullptr);
+    }
+    d->mWatcher = KConfigWatcher::create(d->mConfig);
+    connect(d->mWatcher.data(), &KConfigWatcher::configChanged, this, &KCoreConfigSkeleton::readNotifiedItems);
+}
+
+void KCoreConfigSkeleton::readNotifiedItems(const KConfigGroup &group, const QByteArrayList &names)
+{
+    const KConfigTrace::Span span("reload", d->mConfig->name());
+    // the watcher has updated the config already
+    const QString groupName = group.name();
+    KConfigSkeletonItem::List items;
+    for (const QByteArray &name : names) {
+        const QString key = QString::fromUtf8(name);
+        // items that aren't created yet will read the new value when they are
+        if (KConfigSkeletonItem *item = d->mItemsByKey.value({groupName, key})) {
+            items.append(item);
+            continue;
+        }
+        // a nested group is only known to the items that were given it
+        for (auto *skelItem : std::as_const(d->mItems)) {
+            if (skelItem->d_func()->mConfigGroup.isValid() && skelItem->key() == key && skelItem->configGroup(d->mConfig.data()).name() == groupName) {
+                items.append(skelItem);
+            }
+        }
+    }
+
+    for (auto *skelItem : std::as_const(items)) {
+        skelItem->readConfig(d->mConfig.data());
+        if (d->mTrackChanges) {
+            d->mChangedItems.remove(skelItem);
+            if (skelItem->isDefault()) {
+                d->mNonDefaultItems.remove(skelItem);
+            } else {
+                d->mNonDefaultItems.insert(skelItem);
+            }
+        }
+    }
+    d->updateSnapshot(items);
+}
+
+void KCoreConfigSkeleton::setSnapshotsEnabled(bool enabled)
+{
+    if (enabled == d->mSnapshotsEnabled) {
+        return;
+    }
+    d->mSnapshotsEnabled = enabled;
+    if (enabled) {
+        d->createItems();
+        d->updateSnapshot(d->mItems);
+    } else {
+        QMutexLocker locker(&d->mSnapshotMutex);
+        d->mSnapshot.reset();
+    }
+}
+
+bool KCoreConfigSkeleton::snapshotsEnabled() const
+{
+    return d->mSnapshotsEnabled;
+}
+
+KCoreConfigSkeleton::Snapshot KCoreConfigSkeleton::snapshot() const
+{
+    QMutexLocker locker(&d->mSnapshotMutex);
+    return d->mSnapshot;
+}
+
+bool KCoreConfigSkeleton::tracksChanges() const
+{
+    return d->mTrackChanges;
+}
+
+void KCoreConfigSkeleton::markChanged(KConfigSkeletonItem *item)
+{
+    if (d->mTrackChanges && item) {
+        d->itemChanged(item);
+    }
+}
+
+void KCoreConfigSkeleton::markChanged(const QString &name)
+{
+    markChanged(d->mItemDict.value(name));
+}
+
 bool KCoreConfigSkeleton::usrUseDefaults(bool)
 {
     return false;
@@ -1280,12 +1627,18 @@ void KCoreConfigSkeleton::addItem(KConfigSkeletonItem *item, const QString &name
         d->mItemDict.remove(item->name());
     } else {
         d->mItems.append(item);
+        d->mItemsByKey.insert({item->group(), item->key()}, item);
     }
 
     item->setName(name.isEmpty() ? item->key() : name);
     d->mItemDict.insert(item->name(), item);
+    item->d_func()->mSkeleton = this;
     item->readDefault(d->mConfig.data());
     item->readConfig(d->mConfig.data());
+    d->mReadValid = false; // its group may have changed since the last read()
+    if (d->mTrackChanges && !item->isDefault()) {
+        d->mNonDefaultItems.insert(item);
+    }
 }
 
 void KCoreConfigSkeleton::removeItem(const QString &name)
@@ -1294,6 +1647,9 @@ void KCoreConfigSkeleton::removeItem(const QString &name)
     if (item) {
         d->mItems.removeAll(item);
         d->mItemDict.remove(item->name());
+        reindexItem(item, item->group(), item->key());
+        d->mChangedItems.remove(item);
+        d->mNonDefaultItems.remove(item);
         delete item;
     }
 }
@@ -1303,6 +1659,10 @@ void KCoreConfigSkeleton::clearItems()
     KConfigSkeletonItem::List items = d->mItems;
     d->mItems.clear();
     d->mItemDict.clear();
+    d->mItemsByKey.clear();
+    d->mChangedItems.clear();
+    d->mNonDefaultItems.clear();
+    d->mCreateItemsImpl = {};
     qDeleteAll(items);
 }
 
@@ -1447,7 +1807,40 @@ bool KCoreConfigSkeleton::isImmutable(const QString &name) const
 
 KConfigSkeletonItem *KCoreConfigSkeleton::findItem(const QString &name) const
 {
-    return d->mItemDict.value(name);
+    KConfigSkeletonItem *item = d->mItemDict.value(name);
+    if (!item && d->mCreateItemsImpl) {
+        d->createItems();
+        item = d->mItemDict.value(name);
+    }
+    return item;
+}
+
+KConfigSkeletonItem *KCoreConfigSkeleton::findItem(const QString &group, const QString &key) const
+{
+    KConfigSkeletonItem *item = d->mItemsByKey.value({group, key});
+    if (!item && d->mCreateItemsImpl) {
+        d->createItems();
+        item = d->mItemsByKey.value({group, key});
+    }
+    return item;
+}
+
+void KCoreConfigSkeleton::reindexItem(KConfigSkeletonItem *item, const QString &oldGroup, const QString &oldKey)
+{
+    const auto it = d->mItemsByKey.constFind({oldGroup, oldKey});
+    if (it != d->mItemsByKey.cend() && it.value() == item) {
+        d->mItemsByKey.erase(it);
+        // another item may be stored at the same place, the last one added wins as in addItem()
+        for (auto skelIt = d->mItems.crbegin(); skelIt != d->mItems.crend(); ++skelIt) {
+            if (*skelIt != item && (*skelIt)->group() == oldGroup && (*skelIt)->key() == oldKey) {
+                d->mItemsByKey.insert({oldGroup, oldKey}, *skelIt);
+                break;
+            }
+        }
+    }
+    if (d->mItems.contains(item)) {
+        d->mItemsByKey.insert({item->group(), item->key()}, item);
+    }
 }
 
 KConfigCompilerSignallingItem::KConfigCompilerSignallingItem(KConfigSkeletonItem *item,
@@ -1526,9 +1919,11 @@ void KConfigCompilerSignallingItem::writeConfig(KConfig *c)
 
 void KConfigCompilerSignallingItem::setDefault()
 {
-    QVariant oldValue = mItem->property();
+    // only a value other than the default changes, no need to copy it to find out
+    const bool changes = !mItem->isDefault();
     mItem->setDefault();
-    if (!mItem->isEqual(oldValue)) {
+    if (changes) {
+        markChanged();
         invokeNotifyFunction();
     }
 }
@@ -1537,15 +1932,18 @@ void KConfigCompilerSignallingItem::setProperty(const QVariant &p)
 {
     if (!mItem->isEqual(p)) {
         mItem->setProperty(p);
+        markChanged();
         invokeNotifyFunction();
     }
 }
 
 void KConfigCompilerSignallingItem::swapDefault()
 {
-    QVariant oldValue = mItem->property();
+    // as in setDefault()
+    const bool changes = !mItem->isDefault();
     mItem->swapDefault();
-    if (!mItem->isEqual(oldValue)) {
+    if (changes) {
+        markChanged();
         invokeNotifyFunction();
     }
 }
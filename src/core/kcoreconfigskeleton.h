@@ -22,6 +22,8 @@
 #include <QUrl>
 #include <QVariant>
 
+#include <memory>
+
 class KCoreConfigSkeletonPrivate;
 
 class KConfigSkeletonItemPrivate;
@@ -248,6 +250,22 @@ protected:
      */
     void readImmutability(const KConfigGroup &group);
 
+    /**
+     * Tells the skeleton of this item that its value may have changed, see
+     * KCoreConfigSkeleton::setTrackChanges(). Called by the implementations
+     * of setProperty().
+     * @since 6.1
+     */
+    void markChanged();
+
+    /**
+     * Returns mKey in UTF-8, for the overloads of KConfigGroup taking a
+     * const char *key. The key is only converted again after it changed,
+     * not every time the item is read or written.
+     * @since 6.1
+     */
+    const char *keyUtf8() const;
+
     QString mGroup; ///< The group name for this item
     QString mKey; ///< The config key for this item
     QString mName; ///< The name of this item
@@ -259,6 +277,9 @@ protected:
     void setGetDefaultImpl(const std::function<QVariant()> &impl);
 
     KConfigSkeletonItemPrivate *const d_ptr;
+
+private:
+    friend class KCoreConfigSkeleton;
 };
 
 class KPropertySkeletonItemPrivate;
@@ -353,6 +374,7 @@ public:
     void setValue(const T &v)
     {
         mReference = v;
+        markChanged();
     }
 
     /**
@@ -385,6 +407,7 @@ public:
     void setDefault() override
     {
         mReference = mDefault;
+        markChanged();
     }
 
     /** @copydoc KConfigSkeletonItem::writeConfig(KConfig *) */
@@ -392,10 +415,10 @@ public:
     {
         if (mReference != mLoadedValue) { // Is this needed?
             KConfigGroup cg = configGroup(config);
-            if ((mDefault == mReference) && !cg.hasDefault(mKey)) {
-                cg.revertToDefault(mKey, writeFlags());
+            if ((mDefault == mReference) && !cg.hasDefault(keyUtf8())) {
+                cg.revertToDefault(keyUtf8(), writeFlags());
             } else {
-                cg.writeEntry(mKey, mReference, writeFlags());
+                cg.writeEntry(keyUtf8(), mReference, writeFlags());
             }
             mLoadedValue = mReference;
         }
@@ -413,9 +436,8 @@ public:
     /** @copydoc KConfigSkeletonItem::swapDefault() */
     void swapDefault() override
     {
-        T tmp = mReference;
-        mReference = mDefault;
-        mDefault = tmp;
+        std::swap(mReference, mDefault);
+        markChanged();
     }
 
 protected:
@@ -1148,6 +1170,11 @@ public:
      * This method calls usrRead() after reading the settings of the
      * registered items from the KConfig. You can override usrRead()
      * in derived classes if you have special requirements.
+     *
+     * The files are only parsed again if one of them changed since the last
+     * call or the KConfig has unsaved changes. After that, only the items of
+     * the groups whose entries differ from the ones the last read() found, and
+     * the items that were changed since, are read again.
      */
     void load();
 
@@ -1178,6 +1205,102 @@ public:
      */
     bool isSaveNeeded() const;
 
+    /**
+     * Sets whether the skeleton keeps track of the items that changed since
+     * they were last read or saved. When it does, save() only writes those,
+     * and isSaveNeeded() and isDefaults() only look at those, instead of
+     * going through all the items, which helps settings pages that update
+     * their Apply button on every change.
+     *
+     * The changes are only noticed when they are made through
+     * KConfigSkeletonItem::setProperty(), KConfigSkeletonGenericItem::setValue(),
+     * the setters generated by kconfig_compiler with TrackChanges=true, or
+     * when the code changing a value calls markChanged(). Off by default.
+     *
+     * @since 6.1
+     */
+    void setTrackChanges(bool track);
+
+    /**
+     * Whether the skeleton keeps track of the changed items.
+     * @see setTrackChanges()
+     * @since 6.1
+     */
+    bool tracksChanges() const;
+
+    /**
+     * Tells the skeleton that the value of @p item may have changed, for
+     * setTrackChanges(). Does nothing if changes aren't tracked.
+     * @since 6.1
+     */
+    void markChanged(KConfigSkeletonItem *item);
+
+    /**
+     * Same as markChanged(KConfigSkeletonItem *) for the item called @p name.
+     * @since 6.1
+     */
+    void markChanged(const QString &name);
+
+    /**
+     * Sets whether the items follow the changes other processes make to their
+     * entries with KConfigBase::Notify, see KConfigWatcher. Only the items
+     * of the keys that were notified are read again, those wrapped in a
+     * KConfigCompilerSignallingItem invoke their notify function if their
+     * value changed. Unlike load(), this doesn't emit configChanged().
+     *
+     * The default is @c false.
+     * @since 6.1
+     */
+    void setAutoReload(bool reload);
+
+    /**
+     * Whether the items follow the changes of other processes.
+     * @see setAutoReload()
+     * @since 6.1
+     */
+    bool autoReload() const;
+
+    /**
+     * The values of the items by their name, see snapshot(). It never changes
+     * once taken, so it can be kept and read from any thread.
+     * @since 6.1
+     */
+    using Snapshot = std::shared_ptr<const QHash<QString, QVariant>>;
+
+    /**
+     * Sets whether the skeleton takes a snapshot() of the values of its items
+     * after each read(), load() and save(), and after it read the items that
+     * changed with setAutoReload(). Only the items that were read or written
+     * are looked at again, and the snapshot is only copied when one of them
+     * changed. Off by default.
+     *
+     * @see snapshot()
+     * @since 6.1
+     */
+    void setSnapshotsEnabled(bool enabled);
+
+    /**
+     * Whether the skeleton takes snapshots of its values.
+     * @see setSnapshotsEnabled()
+     * @since 6.1
+     */
+    bool snapshotsEnabled() const;
+
+    /**
+     * Returns the values of the items as they were after the last read(),
+     * load() or save(), or a null pointer if snapshots are not enabled.
+     *
+     * Unlike the rest of the skeleton, this can be called from any thread,
+     * also while the skeleton is read or saved: threads that need the
+     * settings get them without racing with load(), and the values of one
+     * snapshot are consistent with each other. Changes made to the values
+     * since, but not saved yet, are not in it.
+     *
+     * @see setSnapshotsEnabled()
+     * @since 6.1
+     */
+    Snapshot snapshot() const;
+
     /**
      * Set the config file group for subsequent addItem() calls. It is valid
      * until setCurrentGroup() is called with a new argument. Call this before
@@ -1471,6 +1594,14 @@ public:
      */
     KConfigSkeletonItem *findItem(const QString &name) const;
 
+    /**
+     * Lookup item by the group and the key it is stored with, for instance to
+     * read just the items of the keys KConfigWatcher::configChanged() names.
+     * @return the item, or @c nullptr if none is stored there
+     * @since 6.1
+     */
+    KConfigSkeletonItem *findItem(const QString &group, const QString &key) const;
+
     /**
      * Specify whether this object should reflect the actual values or the
      * default values.
@@ -1533,9 +1664,48 @@ protected:
      */
     virtual bool usrSave();
 
+    /**
+     * Lets a subclass that adds some of its items only once they are used,
+     * like the classes kconfig_compiler generates with LazyGroups=true,
+     * add the others when the skeleton needs all of them: in items(),
+     * setDefaults(), useDefaults(), isDefaults() and when findItem() does
+     * not know an item. Items that are added later read their value then,
+     * so read(), load() and save() don't need them.
+     * @p impl is called at most once.
+     * @since 6.1
+     */
+    void setCreateItemsImpl(const std::function<void()> &impl);
+
+    /**
+     * Lets isDefaults() also ask @p impl, for subclasses that keep values
+     * outside of registered items, like the classes kconfig_compiler
+     * generates with StaticItems=true. isDefaults() is only true when
+     * @p impl and all the items agree.
+     * @since 6.1
+     */
+    void setIsDefaultsImpl(const std::function<bool()> &impl);
+
+    /**
+     * Lets isSaveNeeded() also ask @p impl, see setIsDefaultsImpl().
+     * isSaveNeeded() is true when @p impl or any item says so.
+     * @since 6.1
+     */
+    void setIsSaveNeededImpl(const std::function<bool()> &impl);
+
 private:
+    // lets the items of each group in @p items use the same KConfigGroup while read() or save() runs
+    void shareGroups(const KConfigSkeletonItem::List &items, bool share);
+    // remembers the entries just read, for load() to find the items it has to read again
+    void rememberRead();
+    // with autoReload(), reads the items of the keys KConfigWatcher::configChanged() named again
+    void readNotifiedItems(const KConfigGroup &group, const QByteArrayList &names);
+    void watchConfig();
+    // moves @p item in the index of findItem(group, key) after its group or key changed
+    void reindexItem(KConfigSkeletonItem *item, const QString &oldGroup, const QString &oldKey);
+
     KCoreConfigSkeletonPrivate *const d;
     friend class KConfigSkeleton;
+    friend class KConfigSkeletonItem;
 };
 
 #endif
@@ -9,8 +9,14 @@
 #ifndef KCORECONFIGSKELETON_P_H
 #define KCORECONFIGSKELETON_P_H
 
+#include "kconfigdata_p.h"
+#include "kconfigini_p.h"
+#include "kconfigwatcher.h"
 #include "kcoreconfigskeleton.h"
 
+#include <QMutex>
+#include <QSet>
+
 class KCoreConfigSkeletonPrivate
 {
 public:
@@ -29,8 +35,109 @@ public:
 
     KConfigSkeletonItem::List mItems;
     KConfigSkeletonItem::Dict mItemDict;
+    QHash<std::pair<QString, QString>, KConfigSkeletonItem *> mItemsByKey; // by group and key, see findItem()
 
     bool mUseDefaults;
+
+    // for KCoreConfigSkeleton::setTrackChanges()
+    bool mTrackChanges = false;
+    QSet<KConfigSkeletonItem *> mChangedItems; // since the last read() or save()
+    QSet<KConfigSkeletonItem *> mNonDefaultItems; // without their default value when last looked at
+    bool mChangingAllItems = false; // while setDefaults() or useDefaults() marks all the items at once
+
+    // what load() compares to find the items it has to read again
+    bool mReadValid = false; // whether the following still describe the last read()
+    quint64 mReadGeneration = 0; // KConfigPrivate::generation after it
+    bool mReadImmutable = false; // KConfig::isImmutable() then
+    KEntryMap mReadEntries; // the groups of the items, as read() found them
+    QList<KConfigIniBackend::FileStamp> mLoadedStamps; // of the files load() parsed last
+
+    KConfigWatcher::Ptr mWatcher; // with KCoreConfigSkeleton::setAutoReload()
+
+    // for KCoreConfigSkeleton::setSnapshotsEnabled(). Only the thread of the skeleton
+    // replaces mSnapshot, other threads only take it, with mSnapshotMutex held.
+    bool mSnapshotsEnabled = false;
+    mutable QMutex mSnapshotMutex;
+    KCoreConfigSkeleton::Snapshot mSnapshot;
+
+    // for the values subclasses keep outside of items, see KCoreConfigSkeleton::setIsDefaultsImpl()
+    std::function<bool()> mIsDefaultsImpl;
+    std::function<bool()> mIsSaveNeededImpl;
+    // adds the items a subclass creates lazily, see KCoreConfigSkeleton::setCreateItemsImpl()
+    std::function<void()> mCreateItemsImpl;
+
+    // for what has to go through all the items, once
+    void createItems()
+    {
+        if (mCreateItemsImpl) {
+            const std::function<void()> impl = std::exchange(mCreateItemsImpl, {});
+            impl();
+        }
+    }
+    // with mTrackChanges, takes note of the current value of @p item
+    void itemChanged(KConfigSkeletonItem *item)
+    {
+        if (mChangingAllItems) {
+            return;
+        }
+        mChangedItems.insert(item);
+        if (item->isDefault()) {
+            mNonDefaultItems.remove(item);
+        } else {
+            mNonDefaultItems.insert(item);
+        }
+    }
+    // with mSnapshotsEnabled, replaces the snapshot if the value of one of @p items changed
+    void updateSnapshot(const KConfigSkeletonItem::List &items)
+    {
+        if (!mSnapshotsEnabled) {
+            return;
+        }
+        // shares the values with the current snapshot until one of them differs
+        QHash<QString, QVariant> values = mSnapshot ? *mSnapshot : QHash<QString, QVariant>();
+        bool changed = !mSnapshot;
+        for (KConfigSkeletonItem *item : items) {
+            const QVariant value = item->property();
+            const auto it = values.constFind(item->name());
+            if (it == values.cend() || it.value() != value) {
+                values.insert(item->name(), value);
+                changed = true;
+            }
+        }
+        if (!changed) {
+            return;
+        }
+        KCoreConfigSkeleton::Snapshot snapshot = std::make_shared<const QHash<QString, QVariant>>(std::move(values));
+        QMutexLocker locker(&mSnapshotMutex);
+        mSnapshot.swap(snapshot);
+        // the old one is released once the lock is, in case it was the last reference
+    }
+    // calls @p change on all the items, and with mTrackChanges marks them all changed at once,
+    // instead of comparing each one to its default as it goes
+    template<typename Change>
+    void changeAllItems(Change change)
+    {
+        createItems();
+        mChangingAllItems = true;
+        for (KConfigSkeletonItem *item : std::as_const(mItems)) {
+            change(item);
+        }
+        mChangingAllItems = false;
+        if (mTrackChanges) {
+            mChangedItems = QSet<KConfigSkeletonItem *>(mItems.cbegin(), mItems.cend());
+        }
+    }
+    // with mTrackChanges, looks at all the items again and forgets the changes
+    void resetChanges()
+    {
+        mChangedItems.clear();
+        mNonDefaultItems.clear();
+        for (KConfigSkeletonItem *item : std::as_const(mItems)) {
+            if (!item->isDefault()) {
+                mNonDefaultItems.insert(item);
+            }
+        }
+    }
 };
 
 class KConfigSkeletonItemPrivate
@@ -49,11 +156,18 @@ public:
     QString mToolTip; ///< The ToolTip text for this item
     QString mWhatsThis; ///< The What's This text for this item
     KConfigGroup mConfigGroup; ///< KConfigGroup, allow to read/write item in nested groups
+    KCoreConfigSkeleton *mSkeleton = nullptr; ///< The skeleton the item was added to
+    KConfigGroup mSharedGroup; ///< The group of mGroup shared by all the items in it, for the duration of KCoreConfigSkeleton::read() and save()
+    QString mConvertedKey; ///< The key mKeyUtf8 was converted from
+    QByteArray mKeyUtf8; ///< The UTF-8 of the key, see KConfigSkeletonItem::keyUtf8()
     QHash<QString, QString> mValues; /// The values used for ItemEnum's choices, name -> value (if set)
+    QHash<QString, int> mChoiceIndexes; /// ItemEnum's case folded values -> index of the first choice with it, built by readConfig()
 
     // HACK: Necessary to avoid introducing new virtuals in KConfigSkeletonItem
     std::function<bool()> mIsDefaultImpl;
     std::function<bool()> mIsSaveNeededImpl;
+    // adds the items a subclass creates lazily, see KCoreConfigSkeleton::setCreateItemsImpl()
+    std::function<void()> mCreateItemsImpl;
     std::function<QVariant()> mGetDefaultImpl;
 };
 
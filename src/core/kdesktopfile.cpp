@@ -16,6 +16,7 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <QMutex>
 #include <QStandardPaths>
 #include <QUrl>
 
@@ -28,28 +29,39 @@
 class KDesktopFilePrivate : public KConfigPrivate
 {
 public:
-    KDesktopFilePrivate(QStandardPaths::StandardLocation resourceType, const QString &fileName);
+    KDesktopFilePrivate(QStandardPaths::StandardLocation resourceType, const QString &fileName, KDesktopFile::DesktopFileFlags flags);
     KConfigGroup desktopGroup;
 };
 
-KDesktopFilePrivate::KDesktopFilePrivate(QStandardPaths::StandardLocation resourceType, const QString &fileName)
+KDesktopFilePrivate::KDesktopFilePrivate(QStandardPaths::StandardLocation resourceType, const QString &fileName, KDesktopFile::DesktopFileFlags flags)
     : KConfigPrivate(KConfig::ConfigAssociation::NoAssociation, KConfig::NoGlobals, resourceType)
 {
+    // only the group headers get indexed, each group is parsed on its first access
+    if (flags & KDesktopFile::DesktopEntryOnly) {
+        openFlags |= KConfig::LazyLoading;
+    }
     mBackend = new KConfigIniBackend();
     bDynamicBackend = false;
     changeFileName(fileName);
 }
 
 KDesktopFile::KDesktopFile(QStandardPaths::StandardLocation resourceType, const QString &fileName)
-    : KConfig(*new KDesktopFilePrivate(resourceType, fileName))
+    : KDesktopFile(resourceType, fileName, DesktopFileFlags())
 {
-    Q_D(KDesktopFile);
-    reparseConfiguration();
-    d->desktopGroup = KConfigGroup(this, "Desktop Entry");
 }
 
 KDesktopFile::KDesktopFile(const QString &fileName)
-    : KConfig(*new KDesktopFilePrivate(QStandardPaths::ApplicationsLocation, fileName))
+    : KDesktopFile(QStandardPaths::ApplicationsLocation, fileName, DesktopFileFlags())
+{
+}
+
+KDesktopFile::KDesktopFile(const QString &fileName, DesktopFileFlags flags)
+    : KDesktopFile(QStandardPaths::ApplicationsLocation, fileName, flags)
+{
+}
+
+KDesktopFile::KDesktopFile(QStandardPaths::StandardLocation resourceType, const QString &fileName, DesktopFileFlags flags)
+    : KConfig(*new KDesktopFilePrivate(resourceType, fileName, flags))
 {
     Q_D(KDesktopFile);
     reparseConfiguration();
@@ -100,6 +112,82 @@ bool KDesktopFile::isDesktopFile(const QString &path)
     return path.endsWith(QLatin1String(".desktop"));
 }
 
+namespace
+{
+// The directories a desktop file is authorized in: the application dirs, the
+// kservices5 dir of the generic data dirs and the autostart dir of the config dirs
+struct DesktopFilePrefixes {
+    struct Prefix {
+        QString dir;
+        QString subDir;
+        QString canonical; // of dir with subDir appended, empty while dir doesn't exist
+    };
+
+    QMutex mutex;
+    QStringList locations; // the standard locations the prefixes were built from
+    QList<Prefix> prefixes;
+};
+}
+
+Q_GLOBAL_STATIC(DesktopFilePrefixes, s_desktopFilePrefixes)
+
+static void resolvePrefix(DesktopFilePrefixes::Prefix &prefix)
+{
+    QFileInfo info(prefix.dir);
+    if (info.exists() && info.isDir()) {
+        prefix.canonical = info.canonicalFilePath() + prefix.subDir;
+    }
+}
+
+// Whether @p realPath is in one of the directories of DesktopFilePrefixes. They
+// are only resolved again when the standard locations change, for instance
+// with the environment or the test mode, or while they don't exist.
+static bool isInStandardPrefix(const QString &realPath, Qt::CaseSensitivity sensitivity)
+{
+    const QStringList appsDirs = QStandardPaths::standardLocations(QStandardPaths::ApplicationsLocation);
+    const QStringList genericData = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    const QStringList lstConfigPath = QStandardPaths::standardLocations(QStandardPaths::GenericConfigLocation);
+    QStringList locations = appsDirs;
+    locations.append(QString()); // separates the lists, they may have the same dirs
+    locations += genericData;
+    locations.append(QString());
+    locations += lstConfigPath;
+
+    DesktopFilePrefixes *cache = s_desktopFilePrefixes();
+    QMutexLocker locker(&cache->mutex);
+    if (cache->locations != locations) {
+        cache->locations = locations;
+        cache->prefixes.clear();
+        for (const QString &dir : appsDirs) {
+            cache->prefixes.append({dir, QString(), QString()});
+        }
+        const QString servicesDir = QStringLiteral("/kservices5/"); // KGlobal::dirs()->xdgDataRelativePath("services")
+        for (const QString &dir : genericData) {
+            cache->prefixes.append({dir, servicesDir, QString()});
+        }
+        const QString autostartDir = QStringLiteral("/autostart/");
+        for (const QString &dir : lstConfigPath) {
+            cache->prefixes.append({dir, autostartDir, QString()});
+        }
+        for (DesktopFilePrefixes::Prefix &prefix : cache->prefixes) {
+            resolvePrefix(prefix);
+        }
+    }
+
+    for (DesktopFilePrefixes::Prefix &prefix : cache->prefixes) {
+        if (prefix.canonical.isEmpty()) {
+            resolvePrefix(prefix);
+            if (prefix.canonical.isEmpty()) {
+                continue;
+            }
+        }
+        if (realPath.startsWith(prefix.canonical, sensitivity)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool KDesktopFile::isAuthorizedDesktopFile(const QString &path)
 {
     if (path.isEmpty()) {
@@ -122,40 +210,7 @@ bool KDesktopFile::isAuthorizedDesktopFile(const QString &path)
 #endif
 
     // Check if the .desktop file is installed as part of KDE or XDG.
-    const QStringList appsDirs = QStandardPaths::standardLocations(QStandardPaths::ApplicationsLocation);
-    auto it = std::find_if(appsDirs.cbegin(), appsDirs.cend(), [&realPath, sensitivity](const QString &prefix) {
-        QFileInfo info(prefix);
-        return info.exists() && info.isDir() && realPath.startsWith(info.canonicalFilePath(), sensitivity);
-    });
-    if (it != appsDirs.cend()) {
-        return true;
-    }
-
-    const QString servicesDir = QStringLiteral("kservices5/"); // KGlobal::dirs()->xdgDataRelativePath("services")
-    const QStringList genericData = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
-    auto genericIt = std::find_if(genericData.cbegin(), genericData.cend(), [&realPath, &servicesDir, sensitivity](const QString &xdgDataPrefix) {
-        QFileInfo info(xdgDataPrefix);
-        if (info.exists() && info.isDir()) {
-            const QString prefix = info.canonicalFilePath();
-            return realPath.startsWith(prefix + QLatin1Char('/') + servicesDir, sensitivity);
-        }
-        return false;
-    });
-    if (genericIt != genericData.cend()) {
-        return true;
-    }
-
-    const QString autostartDir = QStringLiteral("autostart/");
-    const QStringList lstConfigPath = QStandardPaths::standardLocations(QStandardPaths::GenericConfigLocation);
-    auto configIt = std::find_if(lstConfigPath.cbegin(), lstConfigPath.cend(), [&realPath, &autostartDir, sensitivity](const QString &xdgDataPrefix) {
-        QFileInfo info(xdgDataPrefix);
-        if (info.exists() && info.isDir()) {
-            const QString prefix = info.canonicalFilePath();
-            return realPath.startsWith(prefix + QLatin1Char('/') + autostartDir, sensitivity);
-        }
-        return false;
-    });
-    if (configIt != lstConfigPath.cend()) {
+    if (isInStandardPrefix(realPath, sensitivity)) {
         return true;
     }
 
@@ -26,6 +26,29 @@ class KDesktopFilePrivate;
 class KCONFIGCORE_EXPORT KDesktopFile : public KConfig
 {
 public:
+    /**
+     * Determines how much of the file is parsed when it is opened.
+     *
+     * @see DesktopFileFlags
+     * @since 6.1
+     */
+    enum DesktopFileFlag {
+        /**
+         * Only the group headers are looked at when the file is opened, the
+         * entries of "[Desktop Entry]" are parsed on the first read and those
+         * of a "[Desktop Action ...]" group once actionGroup() reads from it.
+         * Translations into other languages than the current one are skipped.
+         * This is meant for scanning many desktop files of which only a few
+         * fields are used, like the name and icon of launchers.
+         */
+        DesktopEntryOnly = 0x01,
+    };
+    /**
+     * Stores a combination of #DesktopFileFlag values.
+     * @since 6.1
+     */
+    Q_DECLARE_FLAGS(DesktopFileFlags, DesktopFileFlag)
+
     /**
      * Constructs a KDesktopFile object.
      *
@@ -51,6 +74,28 @@ public:
      */
     explicit KDesktopFile(const QString &fileName);
 
+    /**
+     * Constructs a KDesktopFile object, parsed as @p flags tell.
+     *
+     * @param resourceType   Allows you to change what sort of resource
+     *                       to search for if @p fileName is not absolute.
+     * @param fileName       The name or path of the desktop file.
+     * @param flags          How much of the file to parse when it is opened.
+     * @since 6.1
+     */
+    KDesktopFile(QStandardPaths::StandardLocation resourceType, const QString &fileName, DesktopFileFlags flags);
+
+    /**
+     * Constructs a KDesktopFile object, parsed as @p flags tell.
+     *
+     * @param fileName       The name or path of the desktop file. If it
+     *                       is not absolute, it will be located
+     *                       using the resource type ApplicationsLocation
+     * @param flags          How much of the file to parse when it is opened.
+     * @since 6.1
+     */
+    KDesktopFile(const QString &fileName, DesktopFileFlags flags);
+
     /**
      * Destructs the KDesktopFile object.
      *
@@ -230,4 +275,6 @@ private:
     Q_DECLARE_PRIVATE(KDesktopFile)
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KDesktopFile::DesktopFileFlags)
+
 #endif
@@ -0,0 +1,412 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kdesktopfileindex.h"
+
+#include "kconfig_p.h"
+#include "kconfiggroup_p.h"
+#include "kconfiginireader.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QLocale>
+#include <QSemaphore>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+// The fields of one desktop file
+struct DesktopEntry {
+    QString name;
+    QString icon;
+    QString type;
+    QStringList actions;
+    bool noDisplay = false;
+};
+
+// A desktop file found by KDesktopFileIndexPrivate::scan()
+struct FoundFile {
+    QString path;
+    qint64 size;
+    qint64 modified;
+};
+
+// The keys of "[Desktop Entry]" the index needs
+enum Field {
+    NameField,
+    IconField,
+    TypeField,
+    ActionsField,
+    NoDisplayField,
+    OnlyShowInField,
+    NotShowInField,
+    FieldCount,
+};
+
+int fieldOf(QByteArrayView key)
+{
+    static const QByteArrayView keys[FieldCount] = {"Name", "Icon", "Type", "Actions", "NoDisplay", "OnlyShowIn", "NotShowIn"};
+    for (int field = 0; field < FieldCount; ++field) {
+        if (key == keys[field]) {
+            return field;
+        }
+    }
+    return -1;
+}
+
+// The same as KConfigGroup::readXdgListEntry()
+QStringList splitXdgList(const QString &data)
+{
+    QStringList value;
+    QString val;
+    bool quoted = false;
+    for (const QChar c : data) {
+        if (quoted) {
+            val += c;
+            quoted = false;
+        } else if (c == QLatin1Char('\\')) {
+            quoted = true;
+        } else if (c == QLatin1Char(';')) {
+            value.append(val);
+            val.clear();
+        } else {
+            val += c;
+        }
+    }
+    if (!val.isEmpty()) {
+        value.append(val);
+    }
+    return value;
+}
+
+// Reads the fields of @p path as KDesktopFile would for @p locale
+DesktopEntry readDesktopEntry(const QString &path, const QByteArray &locale, const QByteArray &language)
+{
+    // as in KConfigIniBackend, localized values win over plain ones and
+    // for a locale with a country, those of the country over the language
+    enum Tier {
+        Plain,
+        Language,
+        Country,
+        TierCount,
+    };
+    struct Value {
+        QString text;
+        bool found = false;
+    };
+    Value values[FieldCount][TierCount];
+
+    KConfigIniReader reader(path);
+    while (reader.readNext()) {
+        if (reader.group() != QByteArrayView("Desktop Entry")) {
+            continue;
+        }
+        const int field = fieldOf(reader.key());
+        if (field < 0) {
+            continue;
+        }
+
+        Tier tier = Plain;
+        const QByteArrayView entryLocale = reader.locale();
+        if (!entryLocale.isEmpty()) {
+            if (entryLocale != locale && entryLocale != language && (entryLocale.front() != 'C' || locale != "en_US")) {
+                continue; // another locale
+            }
+            tier = entryLocale.contains('_') ? Country : Language;
+        }
+
+        Value &value = values[field][tier];
+        if (reader.flags() & KConfigIniReader::Deleted) {
+            value = Value();
+            continue;
+        }
+        value.text = QString::fromUtf8(reader.value());
+        if (reader.flags() & KConfigIniReader::Expand) {
+            value.text = KConfigPrivate::expandString(value.text);
+        }
+        value.found = true;
+    }
+
+    const auto valueOf = [&values](Field field) -> const Value * {
+        for (int tier = TierCount - 1; tier >= 0; --tier) {
+            if (values[field][tier].found) {
+                return &values[field][tier];
+            }
+        }
+        return nullptr;
+    };
+    const auto textOf = [&valueOf](Field field) {
+        const Value *value = valueOf(field);
+        return value ? value->text : QString();
+    };
+
+    DesktopEntry entry;
+    entry.name = textOf(NameField);
+    entry.icon = textOf(IconField);
+    entry.type = textOf(TypeField);
+    entry.actions = splitXdgList(textOf(ActionsField));
+
+    // the same as KDesktopFile::noDisplay()
+    const Value *noDisplay = valueOf(NoDisplayField);
+    const Value *onlyShowIn = valueOf(OnlyShowInField);
+    const Value *notShowIn = valueOf(NotShowInField);
+    entry.noDisplay = (noDisplay && KConfigGroupValues::toBool(noDisplay->text.toUtf8())) //
+        || (onlyShowIn && !splitXdgList(onlyShowIn->text).contains(QLatin1String("KDE"))) //
+        || (notShowIn && splitXdgList(notShowIn->text).contains(QLatin1String("KDE")));
+    return entry;
+}
+
+// Reads all of @p files, spread over the global thread pool
+std::vector<DesktopEntry> readDesktopEntries(const QList<FoundFile> &files)
+{
+    std::vector<DesktopEntry> entries(files.size());
+    if (files.isEmpty()) {
+        return entries;
+    }
+
+    const QByteArray locale = QLocale().name().toUtf8();
+    const qsizetype langIdx = locale.indexOf('_');
+    const QByteArray language = langIdx >= 0 ? locale.left(langIdx) : locale;
+
+    // small files, a thread only pays off for a few dozen of them
+    constexpr qsizetype filesPerTask = 32;
+    const qsizetype taskCount = std::min<qsizetype>(std::max(1, QThread::idealThreadCount()), (files.size() + filesPerTask - 1) / filesPerTask);
+    const qsizetype chunk = (files.size() + taskCount - 1) / taskCount;
+    const auto readChunk = [&](qsizetype task) {
+        const qsizetype end = std::min(files.size(), (task + 1) * chunk);
+        for (qsizetype i = task * chunk; i < end; ++i) {
+            entries[i] = readDesktopEntry(files.at(i).path, locale, language);
+        }
+    };
+
+    QSemaphore done;
+    std::vector<std::unique_ptr<QRunnable>> tasks;
+    QThreadPool *pool = QThreadPool::globalInstance();
+    for (qsizetype task = 1; task < taskCount; ++task) {
+        tasks.emplace_back(QRunnable::create([&readChunk, &done, task]() {
+            readChunk(task);
+            done.release();
+        }));
+        tasks.back()->setAutoDelete(false);
+        pool->start(tasks.back().get());
+    }
+    readChunk(0);
+
+    // tasks still queued are run here, the pool may be busy, or this may run in it
+    int waiting = 0;
+    for (const auto &task : tasks) {
+        if (pool->tryTake(task.get())) {
+            task->run();
+        }
+        ++waiting;
+    }
+    done.acquire(waiting);
+    return entries;
+}
+}
+
+class KDesktopFileIndexPrivate
+{
+public:
+    QList<FoundFile> scan() const;
+
+    QStringList directories;
+
+    // the columns of the table, with a row for each file
+    QStringList paths;
+    QList<qint64> sizes;
+    QList<qint64> modified;
+    QStringList names;
+    QStringList icons;
+    QStringList types;
+    QList<QStringList> actions;
+    QList<bool> noDisplay;
+
+    QHash<QString, int> rows; // by path
+
+    void setRow(int row, const FoundFile &file, DesktopEntry &&entry)
+    {
+        paths[row] = file.path;
+        sizes[row] = file.size;
+        modified[row] = file.modified;
+        names[row] = std::move(entry.name);
+        icons[row] = std::move(entry.icon);
+        types[row] = std::move(entry.type);
+        actions[row] = std::move(entry.actions);
+        noDisplay[row] = entry.noDisplay;
+    }
+    void resize(int count)
+    {
+        paths.resize(count);
+        sizes.resize(count);
+        modified.resize(count);
+        names.resize(count);
+        icons.resize(count);
+        types.resize(count);
+        actions.resize(count);
+        noDisplay.resize(count);
+    }
+    void moveRow(int from, int to)
+    {
+        paths[to] = std::move(paths[from]);
+        sizes[to] = sizes.at(from);
+        modified[to] = modified.at(from);
+        names[to] = std::move(names[from]);
+        icons[to] = std::move(icons[from]);
+        types[to] = std::move(types[from]);
+        actions[to] = std::move(actions[from]);
+        noDisplay[to] = noDisplay.at(from);
+    }
+};
+
+QList<FoundFile> KDesktopFileIndexPrivate::scan() const
+{
+    QList<FoundFile> files;
+    QSet<QString> relativePaths;
+    for (const QString &directory : directories) {
+        QDirIterator it(directory, {QStringLiteral("*.desktop")}, QDir::Files, QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+        while (it.hasNext()) {
+            it.next();
+            const QFileInfo info = it.fileInfo();
+            const QString path = info.absoluteFilePath();
+            // hidden by a file with the same name in an earlier directory
+            const QString relativePath = QDir(directory).relativeFilePath(path);
+            if (relativePaths.contains(relativePath)) {
+                continue;
+            }
+            relativePaths.insert(relativePath);
+            files.append({path, info.size(), info.lastModified().toMSecsSinceEpoch()});
+        }
+    }
+    return files;
+}
+
+KDesktopFileIndex::KDesktopFileIndex(const QStringList &directories)
+    : d(new KDesktopFileIndexPrivate)
+{
+    d->directories = directories;
+    refresh();
+}
+
+KDesktopFileIndex::~KDesktopFileIndex() = default;
+
+QStringList KDesktopFileIndex::directories() const
+{
+    return d->directories;
+}
+
+bool KDesktopFileIndex::refresh()
+{
+    const QList<FoundFile> files = d->scan();
+
+    QList<bool> found(d->paths.size(), false);
+    QList<FoundFile> toRead;
+    QList<int> toReadRows; // -1 for new files
+    for (const FoundFile &file : files) {
+        const int row = d->rows.value(file.path, -1);
+        if (row >= 0) {
+            found[row] = true;
+            if (d->sizes.at(row) == file.size && d->modified.at(row) == file.modified) {
+                continue;
+            }
+        }
+        toRead.append(file);
+        toReadRows.append(row);
+    }
+
+    const bool removed = found.contains(false);
+    if (toRead.isEmpty() && !removed) {
+        return false;
+    }
+
+    std::vector<DesktopEntry> entries = readDesktopEntries(toRead);
+
+    if (removed) {
+        // keep the order of the remaining rows
+        QHash<int, int> newRows;
+        int count = 0;
+        for (int row = 0; row < found.size(); ++row) {
+            if (found.at(row)) {
+                if (row != count) {
+                    d->moveRow(row, count);
+                }
+                newRows.insert(row, count);
+                ++count;
+            }
+        }
+        d->resize(count);
+        for (int &row : toReadRows) {
+            if (row >= 0) {
+                row = newRows.value(row);
+            }
+        }
+    }
+
+    for (int i = 0; i < toRead.size(); ++i) {
+        int row = toReadRows.at(i);
+        if (row < 0) {
+            row = d->paths.size();
+            d->resize(row + 1);
+        }
+        d->setRow(row, toRead.at(i), std::move(entries[i]));
+    }
+
+    d->rows.clear();
+    d->rows.reserve(d->paths.size());
+    for (int row = 0; row < d->paths.size(); ++row) {
+        d->rows.insert(d->paths.at(row), row);
+    }
+    return true;
+}
+
+int KDesktopFileIndex::count() const
+{
+    return d->paths.size();
+}
+
+int KDesktopFileIndex::indexOf(const QString &filePath) const
+{
+    return d->rows.value(filePath, -1);
+}
+
+QString KDesktopFileIndex::filePath(int row) const
+{
+    return d->paths.value(row);
+}
+
+QString KDesktopFileIndex::readName(int row) const
+{
+    return d->names.value(row);
+}
+
+QString KDesktopFileIndex::readIcon(int row) const
+{
+    return d->icons.value(row);
+}
+
+QString KDesktopFileIndex::readType(int row) const
+{
+    return d->types.value(row);
+}
+
+bool KDesktopFileIndex::noDisplay(int row) const
+{
+    return d->noDisplay.value(row);
+}
+
+QStringList KDesktopFileIndex::readActions(int row) const
+{
+    return d->actions.value(row);
+}
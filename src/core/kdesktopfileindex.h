@@ -0,0 +1,109 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KDESKTOPFILEINDEX_H
+#define KDESKTOPFILEINDEX_H
+
+#include <kconfigcore_export.h>
+
+#include <QScopedPointer>
+#include <QStringList>
+
+class KDesktopFileIndexPrivate;
+
+/**
+ * \class KDesktopFileIndex kdesktopfileindex.h <KDesktopFileIndex>
+ *
+ * The most used fields of all the desktop files in a set of directories.
+ *
+ * Creating a KDesktopFile for each of hundreds of desktop files, just to show
+ * their names and icons, parses every file completely, with the translations
+ * into all languages. The index only reads the "[Desktop Entry]" group of each
+ * file, with KConfigIniReader and for the current locale, and spreads the
+ * files over several threads.
+ *
+ * @code
+ * KDesktopFileIndex index(QStandardPaths::standardLocations(QStandardPaths::ApplicationsLocation));
+ * for (int i = 0; i < index.count(); ++i) {
+ *     if (!index.noDisplay(i)) {
+ *         addLauncher(index.readName(i), index.readIcon(i), index.filePath(i));
+ *     }
+ * }
+ * @endcode
+ *
+ * The fields match those of KDesktopFile, except that a value marked with
+ * [$e] is expanded without the restrictions of the kiosk mode.
+ *
+ * @since 6.1
+ */
+class KCONFIGCORE_EXPORT KDesktopFileIndex
+{
+public:
+    /**
+     * Indexes the desktop files found in @p directories and their
+     * subdirectories. A file found in several of them is only indexed in
+     * the first one, as QStandardPaths::locate() would find it.
+     */
+    explicit KDesktopFileIndex(const QStringList &directories);
+    ~KDesktopFileIndex();
+
+    /**
+     * The directories given to the constructor.
+     */
+    QStringList directories() const;
+
+    /**
+     * Looks for changes in the directories. Files that were added, or whose
+     * size or modification time changed, are read again, those that were
+     * removed are dropped from the index. The other ones keep their row,
+     * new files are appended at the end.
+     *
+     * @return whether anything changed
+     */
+    bool refresh();
+
+    /**
+     * The number of indexed desktop files.
+     */
+    int count() const;
+
+    /**
+     * The row of @p filePath, or -1 if it isn't indexed.
+     */
+    int indexOf(const QString &filePath) const;
+
+    /**
+     * The absolute path of the desktop file in @p row.
+     */
+    QString filePath(int row) const;
+    /**
+     * The "Name" of the desktop file in @p row, see KDesktopFile::readName().
+     */
+    QString readName(int row) const;
+    /**
+     * The "Icon" of the desktop file in @p row, see KDesktopFile::readIcon().
+     */
+    QString readIcon(int row) const;
+    /**
+     * The "Type" of the desktop file in @p row, see KDesktopFile::readType().
+     */
+    QString readType(int row) const;
+    /**
+     * Whether the desktop file in @p row should be hidden, see KDesktopFile::noDisplay().
+     */
+    bool noDisplay(int row) const;
+    /**
+     * The "Actions" of the desktop file in @p row, see KDesktopFile::readActions().
+     */
+    QStringList readActions(int row) const;
+
+private:
+    Q_DISABLE_COPY(KDesktopFileIndex)
+    const QScopedPointer<KDesktopFileIndexPrivate> d;
+};
+
+#endif // KDESKTOPFILEINDEX_H
@@ -10,13 +10,39 @@
 #include "kconfig_p.h"
 #include "kconfigbackend_p.h"
 #include "kconfiggroup.h"
+#include "kconfigstringpool_p.h"
 #include <QCoreApplication>
+#include <QFuture>
+#include <QHash>
+#include <QPromise>
 #include <QThread>
+#include <QThreadPool>
 #include <QThreadStorage>
 
+#include <algorithm>
+#include <memory>
+
 void _k_globalMainConfigSync();
 
-using SharedConfigList = QList<KSharedConfig *>;
+// What openConfig() tells the shared configs apart by
+struct SharedConfigKey {
+    QString fileName;
+    KConfig::OpenFlags flags;
+    QStandardPaths::StandardLocation resType;
+
+    bool operator==(const SharedConfigKey &other) const
+    {
+        return fileName == other.fileName && flags == other.flags && resType == other.resType;
+    }
+};
+
+static size_t qHash(const SharedConfigKey &key, size_t seed = 0)
+{
+    return qHashMulti(seed, key.fileName, key.flags.toInt(), int(key.resType));
+}
+
+// The live configs, they don't hold a reference: KSharedConfig removes itself when deleted
+using SharedConfigHash = QHash<SharedConfigKey, KSharedConfig *>;
 
 class GlobalSharedConfig
 {
@@ -35,7 +61,9 @@ public:
         // the thread exits.
     }
 
-    SharedConfigList configList;
+    SharedConfigHash configs;
+    // configs parsed on a background thread by KSharedConfig::prefetch(), until they are opened
+    QHash<SharedConfigKey, QFuture<KSharedConfigPtr>> prefetched;
     // in addition to the list, we need to hold the main config,
     // so that it's not created and destroyed all the time.
     KSharedConfigPtr mainConfig;
@@ -60,10 +88,18 @@ static GlobalSharedConfig *globalSharedConfig()
 
 void _k_globalMainConfigSync()
 {
-    KSharedConfigPtr mainConfig = globalSharedConfig()->mainConfig;
-    if (mainConfig) {
-        mainConfig->sync();
+    // all the shared configs of the main thread at once, rather than each one when it is destroyed
+    GlobalSharedConfig *global = globalSharedConfig();
+    QList<KConfig *> dirty;
+    for (KSharedConfig *config : std::as_const(global->configs)) {
+        if (config->isDirty()) {
+            dirty.append(config);
+        }
     }
+    if (global->mainConfig && global->mainConfig->isDirty() && !dirty.contains(global->mainConfig.data())) {
+        dirty.append(global->mainConfig.data());
+    }
+    KConfigExitSync::syncAll(dirty);
 }
 
 static void makeMainConfig(KSharedConfig::Ptr ptr)
@@ -87,53 +123,72 @@ std::optional<KSharedConfigPtr> KSharedConfig::tryGetGlobalConfig(const QString
     GlobalSharedConfig *global = globalSharedConfig();
     if (!global->wasTestModeEnabled && QStandardPaths::isTestModeEnabled()) {
         global->wasTestModeEnabled = true;
-        global->configList.clear();
+        global->configs.clear();
+        global->prefetched.clear();
         global->mainConfig = nullptr;
     }
 
-    for (auto *cfg : std::as_const(global->configList)) {
-        if (cfg->name() == fileName && cfg->d_ptr->openFlags == flags && cfg->locationType() == resType
-            //                cfg->backend()->type() == backend
-        ) {
-            return std::make_optional(KSharedConfigPtr(cfg));
-        }
+    KSharedConfig *cfg = global->configs.value(SharedConfigKey{fileName, flags, resType});
+    if (cfg) {
+        return std::make_optional(KSharedConfigPtr(cfg));
     }
     return std::nullopt;
 }
 
-KSharedConfig::Ptr
-KSharedConfig::openConfig(KConfig::ConfigAssociation association, const QString &_fileName, OpenFlags flags, QStandardPaths::StandardLocation resType)
+QList<KConfig *> sharedConfigsOfThread()
 {
-    QString fileName(_fileName);
-    if (fileName.isEmpty() && !flags.testFlag(KConfig::SimpleConfig)) {
-        // Determine the config file name that KConfig will make up (see KConfigPrivate::changeFileName)
-        fileName = KConfig::mainConfigName();
+    QList<KConfig *> configs;
+    if (!s_storage.hasLocalData()) {
+        return configs;
+    }
+    GlobalSharedConfig *global = globalSharedConfig();
+    configs.reserve(global->configs.size());
+    for (KSharedConfig *config : std::as_const(global->configs)) {
+        configs.append(config);
     }
+    return configs;
+}
 
-    if (auto ptr = tryGetGlobalConfig(fileName, flags, resType))
-        return *ptr;
+// Determines the config file name that KConfig will make up (see KConfigPrivate::changeFileName)
+static QString sharedConfigName(const QString &fileName, KConfig::OpenFlags flags)
+{
+    if (fileName.isEmpty() && !flags.testFlag(KConfig::SimpleConfig)) {
+        return KConfig::mainConfigName();
+    }
+    return fileName;
+}
 
-    KSharedConfigPtr ptr(new KSharedConfig(association, fileName, flags, resType));
+static void shareConfig(KSharedConfig *config)
+{
+    globalSharedConfig()->configs.insert(SharedConfigKey{config->name(), config->openFlags(), config->locationType()}, config);
+}
 
-    if (_fileName.isEmpty() && flags == FullConfig && resType == QStandardPaths::GenericConfigLocation) {
-        makeMainConfig(ptr);
+// The config prefetched for @p key, waits for it to be parsed if needed
+static KSharedConfigPtr takePrefetched(const SharedConfigKey &key)
+{
+    GlobalSharedConfig *global = globalSharedConfig();
+    const auto it = global->prefetched.find(key);
+    if (it == global->prefetched.end()) {
+        return KSharedConfigPtr();
     }
-
+    KSharedConfigPtr ptr = it->result();
+    global->prefetched.erase(it);
     return ptr;
 }
 
-KSharedConfigPtr KSharedConfig::openConfig(const QString &_fileName, OpenFlags flags, QStandardPaths::StandardLocation resType)
+KSharedConfig::Ptr
+KSharedConfig::openConfig(KConfig::ConfigAssociation association, const QString &_fileName, OpenFlags flags, QStandardPaths::StandardLocation resType)
 {
-    QString fileName(_fileName);
-    if (fileName.isEmpty() && !flags.testFlag(KConfig::SimpleConfig)) {
-        // Determine the config file name that KConfig will make up (see KConfigPrivate::changeFileName)
-        fileName = KConfig::mainConfigName();
-    }
+    const QString fileName = sharedConfigName(_fileName, flags);
 
     if (auto ptr = tryGetGlobalConfig(fileName, flags, resType))
         return *ptr;
 
-    KSharedConfigPtr ptr(new KSharedConfig(KConfig::ConfigAssociation::NoAssociation, fileName, flags, resType));
+    KSharedConfigPtr ptr = takePrefetched(SharedConfigKey{fileName, flags, resType});
+    if (!ptr) {
+        ptr.reset(new KSharedConfig(association, fileName, flags, resType));
+    }
+    shareConfig(ptr.data());
 
     if (_fileName.isEmpty() && flags == FullConfig && resType == QStandardPaths::GenericConfigLocation) {
         makeMainConfig(ptr);
@@ -142,6 +197,11 @@ KSharedConfigPtr KSharedConfig::openConfig(const QString &_fileName, OpenFlags f
     return ptr;
 }
 
+KSharedConfigPtr KSharedConfig::openConfig(const QString &_fileName, OpenFlags flags, QStandardPaths::StandardLocation resType)
+{
+    return openConfig(KConfig::ConfigAssociation::NoAssociation, _fileName, flags, resType);
+}
+
 KSharedConfig::Ptr KSharedConfig::openStateConfig(const QString &_fileName)
 {
     // KF6 TODO: port this to XDG_STATE_HOME (default ~/.local/state)
@@ -152,19 +212,98 @@ KSharedConfig::Ptr KSharedConfig::openStateConfig(const QString &_fileName)
         fileName = QCoreApplication::applicationName() + QLatin1String("staterc");
     }
 
-    return openConfig(KConfig::ConfigAssociation::NoAssociation, fileName, SimpleConfig, QStandardPaths::AppDataLocation);
+    KSharedConfig::Ptr config = openConfig(KConfig::ConfigAssociation::NoAssociation, fileName, SimpleConfig, QStandardPaths::AppDataLocation);
+    // window sizes and such aren't worth waiting for the disk on each sync(), keeps WriteBehind
+    if (config->durability() == KConfig::Durable) {
+        config->setDurability(KConfig::RelaxedNoFsync);
+    }
+    return config;
 }
 
+QFuture<KSharedConfigPtr>
+KSharedConfig::startPrefetch(KConfig::ConfigAssociation association, const QString &fileName, OpenFlags flags, QStandardPaths::StandardLocation resType)
+{
+    const SharedConfigKey key{fileName, flags, resType};
+    GlobalSharedConfig *global = globalSharedConfig();
+    const auto it = global->prefetched.constFind(key);
+    if (it != global->prefetched.cend()) {
+        return *it;
+    }
+
+    auto promise = std::make_shared<QPromise<KSharedConfigPtr>>();
+    QFuture<KSharedConfigPtr> future = promise->future();
+    global->prefetched.insert(key, future);
+    // not shared in the pool thread, shareConfig() is called by openConfig() in this one
+    QThreadPool::globalInstance()->start([promise, association, key]() {
+        promise->start();
+        promise->addResult(KSharedConfigPtr(new KSharedConfig(association, key.fileName, key.flags, key.resType)));
+        promise->finish();
+    });
+    return future;
+}
+
+void KSharedConfig::prefetch(KConfig::ConfigAssociation association, const QStringList &fileNames, OpenFlags flags, QStandardPaths::StandardLocation resType)
+{
+    for (const QString &name : fileNames) {
+        const QString fileName = sharedConfigName(name, flags);
+        if (!tryGetGlobalConfig(fileName, flags, resType)) {
+            startPrefetch(association, fileName, flags, resType);
+        }
+    }
+}
+
+QFuture<KSharedConfig::Ptr>
+KSharedConfig::openConfigAsync(KConfig::ConfigAssociation association, const QString &fileName, OpenFlags flags, QStandardPaths::StandardLocation resType)
+{
+    const QString name = sharedConfigName(fileName, flags);
+    if (auto ptr = tryGetGlobalConfig(name, flags, resType)) {
+        QPromise<KSharedConfigPtr> promise;
+        promise.start();
+        promise.addResult(*ptr);
+        promise.finish();
+        return promise.future();
+    }
+    // openConfig() takes it from the prefetched ones, until then it is shared through them
+    return startPrefetch(association, name, flags, resType);
+}
+
+// openConfig() and prefetch() share the config in the thread it is meant for
 KSharedConfig::KSharedConfig(KConfig::ConfigAssociation association, const QString &fileName, OpenFlags flags, QStandardPaths::StandardLocation resType)
     : KConfig(association, fileName, flags, resType)
 {
-    globalSharedConfig()->configList.append(this);
+}
+
+KSharedConfig::MemoryReport KSharedConfig::memoryReport()
+{
+    MemoryReport report;
+    const SharedConfigHash &configs = globalSharedConfig()->configs;
+    report.configs.reserve(configs.size());
+    for (const KSharedConfig *config : configs) {
+        report.configs.append(config->memoryUsage());
+    }
+    std::sort(report.configs.begin(), report.configs.end(), [](const KConfig::MemoryUsage &a, const KConfig::MemoryUsage &b) {
+        return a.name < b.name;
+    });
+
+    const KConfigGlobalParseCache::Statistics parseCache = KConfigGlobalParseCache::statistics();
+    report.globalParseCacheFiles = parseCache.size;
+    report.globalParseCacheBytes = parseCache.cost;
+    report.globalParseCacheBudget = parseCache.budget;
+    const KConfigStringPool::Statistics pool = KConfigStringPool::statistics();
+    report.internedStrings = pool.size;
+    report.internedBytesSaved = pool.bytesSaved;
+    return report;
 }
 
 KSharedConfig::~KSharedConfig()
 {
     if (s_storage.hasLocalData()) {
-        globalSharedConfig()->configList.removeAll(this);
+        SharedConfigHash &configs = globalSharedConfig()->configs;
+        const auto it = configs.constFind(SharedConfigKey{name(), d_ptr->openFlags, locationType()});
+        // configs dropped when the test mode got enabled may have been replaced
+        if (it != configs.cend() && it.value() == this) {
+            configs.erase(it);
+        }
     }
 }
 
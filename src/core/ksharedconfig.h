@@ -10,6 +10,7 @@
 #define KSHAREDCONFIG_H
 
 #include <QExplicitlySharedDataPointer>
+#include <QFuture>
 #include <kconfig.h>
 
 /**
@@ -26,7 +27,8 @@
  * of shared KConfig objects. This means, however, that you'll be responsible for
  * synchronizing the instances of KConfig for the same filename between threads,
  * using KConfig::reparseConfiguration() after a manual change notification, just like you have
- * to do between processes.
+ * to do between processes. Threads that only read a config can share a single parse of it
+ * with KConfigSnapshot::open() instead, and change it with KConfigSnapshot::update().
  */
 class KCONFIGCORE_EXPORT KSharedConfig : public KConfig, public QSharedData // krazy:exclude=dpointer (only for refcounting)
 {
@@ -91,12 +93,90 @@ public:
      * @param fileName the configuration file to open. If empty, it will be determined
      *                 automatically from the application name + "staterc"
      *
+     * Since 6.1 the config is KConfig::RelaxedNoFsync, unless it was made
+     * KConfig::WriteBehind.
+     *
      * @since 5.67
      *
      * @sa KConfig
      */
     static KSharedConfig::Ptr openStateConfig(const QString &fileName = QString());
 
+    /**
+     * Parses the configuration files @p fileNames on a background thread, so
+     * that the first openConfig() of one of them in the calling thread doesn't
+     * have to. Meant for the configs an application knows it needs at startup.
+     *
+     * The configs are only picked up by openConfig() calls in the calling
+     * thread with the same @p mode and @p type. Such a call waits for the
+     * background parse if it isn't done yet. Files that are open already are
+     * skipped.
+     *
+     * @param association  the config group associated with the configs, see openConfig()
+     * @param fileNames    the configuration files, an empty name stands for the
+     *                     main config of the application as in openConfig()
+     * @param mode         how global settings should affect the configs
+     * @param type         the standard directory to look for the files in
+     *
+     * @since 6.1
+     */
+    static void prefetch(KConfig::ConfigAssociation association,
+                         const QStringList &fileNames,
+                         OpenFlags mode = FullConfig,
+                         QStandardPaths::StandardLocation type = QStandardPaths::GenericConfigLocation);
+
+    /**
+     * Opens a shared config like openConfig(), but the files are found and
+     * parsed on a background thread, so that the calling thread can go on,
+     * for instance to show its first window.
+     *
+     * The config is shared in the calling thread as soon as this returns: a
+     * later openConfig() or openConfigAsync() of the same file there, with the
+     * same @p mode and @p type, gets the same config, the synchronous one
+     * waiting for the parse if it isn't done yet. If the config is open
+     * already, the returned future has it right away.
+     *
+     * The future can be waited for, or be continued with QFuture::then() and a
+     * context object to get the config in the calling thread. The config is
+     * meant for the calling thread, like the ones of openConfig().
+     *
+     * @param association  the config group associated with the config, see openConfig()
+     * @param fileName     the configuration file to open, see openConfig()
+     * @param mode         how global settings should affect the config
+     * @param type         the standard directory to look for the file in
+     *
+     * @see prefetch()
+     * @since 6.1
+     */
+    static QFuture<KSharedConfig::Ptr> openConfigAsync(KConfig::ConfigAssociation association,
+                                                       const QString &fileName = QString(),
+                                                       OpenFlags mode = FullConfig,
+                                                       QStandardPaths::StandardLocation type = QStandardPaths::GenericConfigLocation);
+
+    /**
+     * The memory held by the shared configs and the caches of the process,
+     * see memoryReport().
+     * @since 6.1
+     */
+    struct MemoryReport {
+        QList<KConfig::MemoryUsage> configs; ///< the shared configs open in the calling thread
+        qsizetype globalParseCacheFiles = 0; ///< cascades of global files whose parsed entries are cached
+        qint64 globalParseCacheBytes = 0; ///< an estimate of the memory they use
+        qint64 globalParseCacheBudget = 0; ///< the most memory they may use
+        qsizetype internedStrings = 0; ///< group names, keys and short values in the pool of interned strings
+        qint64 internedBytesSaved = 0; ///< bytes not allocated because the pool had them already
+    };
+
+    /**
+     * Returns the memory used by the shared configs of the calling thread,
+     * since KSharedConfig::openConfig() keeps the configs of each thread apart,
+     * and by the caches shared by the whole process.
+     * Going through all the entries, this is meant for debugging.
+     * @see KConfig::memoryUsage()
+     * @since 6.1
+     */
+    static MemoryReport memoryReport();
+
     ~KSharedConfig() override;
 
 private:
@@ -104,6 +184,9 @@ private:
     KConfigGroup groupImpl(const QByteArray &aGroup) override;
     const KConfigGroup groupImpl(const QByteArray &aGroup) const override;
     static std::optional<KSharedConfig::Ptr> tryGetGlobalConfig(const QString &fileName, OpenFlags flags, QStandardPaths::StandardLocation resType);
+    // Starts parsing the config in the thread pool for openConfig() to pick up, unless that was done already
+    static QFuture<KSharedConfig::Ptr>
+    startPrefetch(KConfig::ConfigAssociation association, const QString &fileName, OpenFlags flags, QStandardPaths::StandardLocation resType);
 
     KSharedConfig(KConfig::ConfigAssociation association, const QString &file, OpenFlags mode, QStandardPaths::StandardLocation resourceType);
 };
@@ -6,13 +6,84 @@
 */
 
 #include <kconfiggroup.h>
+#include <kconfiggroupsnapshot.h>
+#include <kconfiggui.h>
 
 #include <QColor>
 #include <QDebug>
 #include <QFont>
+#include <QHash>
+#include <QMutex>
 
 #include <kconfiggroup_p.h>
 
+/**
+ * Decodes @p data written as "r,g,b" or "r,g,b,a" with plain numbers in range,
+ * which is how writeEntryGui() stores colors, without allocating.
+ *
+ * @returns false for anything else, left to the full parser and its diagnostics
+ */
+static bool decodeRgb(QByteArrayView data, QColor *color)
+{
+    int components[4];
+    int count = 0;
+    int value = -1;
+    for (const char c : data) {
+        if (c >= '0' && c <= '9') {
+            value = (value < 0 ? 0 : value * 10) + (c - '0');
+            if (value > 255) {
+                return false;
+            }
+        } else if (c == ',' && value >= 0 && count < 3) {
+            components[count++] = value;
+            value = -1;
+        } else {
+            return false;
+        }
+    }
+    if (value < 0 || count < 2) {
+        return false;
+    }
+    components[count++] = value;
+
+    *color = QColor(components[0], components[1], components[2]);
+    if (count == 4) {
+        color->setAlpha(components[3]);
+    }
+    return true;
+}
+
+/**
+ * Decodes the font in @p data. Parsing fonts is costly and the same few of them
+ * are read over and over, e.g. from kdeglobals, so the decoded fonts are kept.
+ *
+ * @returns false if QFont::fromString() fails
+ */
+static bool decodeFont(const QByteArray &data, QFont *font)
+{
+    static QMutex mutex;
+    static QHash<QByteArray, QFont> fonts;
+
+    QMutexLocker locker(&mutex);
+    const auto it = fonts.constFind(data);
+    if (it != fonts.cend()) {
+        *font = it.value();
+        return true;
+    }
+
+    QFont decoded;
+    if (!decoded.fromString(QString::fromUtf8(data))) {
+        return false;
+    }
+    // the fonts of a desktop are few, a full cache means something reads arbitrary ones
+    if (fonts.size() >= 64) {
+        fonts.clear();
+    }
+    fonts.insert(data, decoded);
+    *font = decoded;
+    return true;
+}
+
 /**
  * Try to read a GUI type from config group @p cg at key @p key.
  * @p input is the default value and also indicates the type to be read.
@@ -37,8 +108,9 @@ static bool readEntryGui(const QByteArray &data, const char *key, const QVariant
             output = QColor(); // return what was stored
             return true;
         } else if (data.at(0) == '#') {
-            QColor col;
-            col.setNamedColor(QString::fromUtf8(data.constData(), data.length()));
+            output = QColor::fromString(data);
+            return true;
+        } else if (QColor col; decodeRgb(data, &col)) {
             output = col;
             return true;
         } else if (!data.contains(',')) {
@@ -93,6 +165,10 @@ static bool readEntryGui(const QByteArray &data, const char *key, const QVariant
     }
 
     case QMetaType::QFont: {
+        if (QFont font; decodeFont(data, &font)) {
+            output = font;
+            return true;
+        }
         QVariant tmp = QString::fromUtf8(data.constData(), data.length());
         if (tmp.canConvert<QFont>()) {
             output = tmp;
@@ -120,6 +196,40 @@ static bool readEntryGui(const QByteArray &data, const char *key, const QVariant
     return false; // not handled
 }
 
+// The color @p data read from @p key, decoded as readEntryGui() does
+static QColor decodeColor(QByteArrayView data, const char *key, const QColor &aDefault)
+{
+    if (data.isNull()) {
+        return aDefault;
+    }
+    if (data.isEmpty() || data == "invalid") {
+        return QColor();
+    }
+    if (data.at(0) == '#') {
+        return QColor::fromString(QUtf8StringView(data.data(), data.size()));
+    }
+    if (QColor color; decodeRgb(data, &color)) {
+        return color;
+    }
+    QVariant output;
+    readEntryGui(data.toByteArray(), key, aDefault, output);
+    return output.value<QColor>();
+}
+
+QList<QColor> KConfigGui::readColors(const KConfigBase &config, const QStringList &groups, const QByteArrayList &keys, const QColor &aDefault)
+{
+    QList<QColor> colors;
+    colors.reserve(groups.size() * keys.size());
+    for (const QString &group : groups) {
+        // one lookup of the group, the views of its values stay valid with it
+        const KConfigGroupSnapshot snapshot = config.group(group).snapshot();
+        for (const QByteArray &key : keys) {
+            colors.append(decodeColor(snapshot.readEntryRaw(key.constData()), key.constData(), aDefault));
+        }
+    }
+    return colors;
+}
+
 /**
  * Try to write a GUI type @p prop to config group @p cg at key @p key.
  *
@@ -137,15 +247,14 @@ static bool writeEntryGui(KConfigGroup *cg, const char *key, const QVariant &pro
             return true;
         }
 
-        QList<int> list;
-        list.insert(0, rColor.red());
-        list.insert(1, rColor.green());
-        list.insert(2, rColor.blue());
+        // "r,g,b[,a]", as a list of ints would be written, in one buffer
+        QByteArray value = QByteArray::number(rColor.red()) + ',' + QByteArray::number(rColor.green()) + ',' + QByteArray::number(rColor.blue());
+
         if (rColor.alpha() != 255) {
-            list.insert(3, rColor.alpha());
+            value += ',' + QByteArray::number(rColor.alpha());
         }
 
-        cg->writeEntry(key, list, pFlags);
+        cg->writeEntry(key, value, pFlags);
         return true;
     }
     case QMetaType::QFont: {
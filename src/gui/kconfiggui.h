@@ -10,9 +10,12 @@
 
 #include <kconfiggui_export.h>
 
+#include <QColor>
+#include <QList>
 #include <QString>
 
 class KConfig;
+class KConfigBase;
 
 /**
  * Interface-related functions.
@@ -50,6 +53,30 @@ KCONFIGGUI_EXPORT void setSessionConfig(const QString &id, const QString &key);
  * @return @c true if a sessionConfig object was created, @c false otherwise
  */
 KCONFIGGUI_EXPORT bool hasSessionConfig();
+
+/**
+ * Reads the colors @p keys of each of @p groups of @p config, as
+ * KConfigGroup::readEntry() does for a QColor, e.g. all the roles of the
+ * "Colors:*" groups of a color scheme.
+ *
+ * Every group is looked up once, and the colors are decoded where they are
+ * stored, which makes this much cheaper than reading them one by one.
+ *
+ * @code
+ * const QStringList sets = {QStringLiteral("Colors:View"), QStringLiteral("Colors:Window")};
+ * const QByteArrayList roles = {"BackgroundNormal", "ForegroundNormal"};
+ * const QList<QColor> colors = KConfigGui::readColors(*KSharedConfig::openConfig(), sets, roles);
+ * const QColor windowForeground = colors.at(1 * roles.size() + 1);
+ * @endcode
+ *
+ * @param aDefault the color of the entries that don't exist
+ * @return the colors of the first group in the order of @p keys, then those
+ *         of the second group and so on: the color of key k in group g is at
+ *         g * keys.size() + k
+ *
+ * @since 6.1
+ */
+KCONFIGGUI_EXPORT QList<QColor> readColors(const KConfigBase &config, const QStringList &groups, const QByteArrayList &keys, const QColor &aDefault = QColor());
 }
 
 #endif // KCONFIGGUI_H
@@ -8,17 +8,25 @@
 #include "kconfigloader_p.h"
 #include "kconfigloaderhandler_p.h"
 
+#include <QBuffer>
 #include <QColor>
 #include <QFont>
 #include <QHash>
+#include <QMutex>
+#include <QPromise>
+#include <QThreadPool>
 #include <QUrl>
 
+#include <memory>
+#include <utility>
+
 #include <QDebug>
 
 void ConfigLoaderPrivate::parse(KConfigLoader *loader, QIODevice *xml)
 {
     clearData();
     loader->clearItems();
+    schema.reset();
 
     if (xml) {
         ConfigLoaderHandler handler(loader, this);
@@ -33,13 +41,62 @@ ConfigLoaderHandler::ConfigLoaderHandler(KConfigLoader *config, ConfigLoaderPriv
     resetState();
 }
 
+namespace
+{
+// The schemas parsed in the process, by the content of their .kcfg file
+struct SchemaCache {
+    QMutex mutex;
+    QHash<QByteArray, std::shared_ptr<const ConfigLoaderSchema>> schemas;
+};
+}
+Q_GLOBAL_STATIC(SchemaCache, s_schemaCache)
+
 bool ConfigLoaderHandler::parse(QIODevice *input)
 {
     if (!input->open(QIODevice::ReadOnly)) {
         qWarning() << "Impossible to open device";
         return false;
     }
-    QXmlStreamReader reader(input);
+
+    bool ok = true;
+    const std::shared_ptr<const ConfigLoaderSchema> schema = schemaOf(input->readAll(), &ok);
+
+    // The items copy their names, labels, defaults and choices from the schema, which
+    // as implicitly shared data keeps a single copy for all the loaders of the file
+    d->schema = schema;
+    apply(*schema);
+    return ok;
+}
+
+std::shared_ptr<const ConfigLoaderSchema> ConfigLoaderHandler::schemaOf(const QByteArray &xml, bool *ok)
+{
+    SchemaCache &cache = *s_schemaCache;
+    {
+        QMutexLocker locker(&cache.mutex);
+        if (std::shared_ptr<const ConfigLoaderSchema> schema = cache.schemas.value(xml)) {
+            *ok = true;
+            return schema;
+        }
+    }
+
+    // parsing the document only records its groups and entries
+    ConfigLoaderHandler handler(nullptr, nullptr);
+    *ok = handler.parseXml(xml);
+    auto schema = std::make_shared<const ConfigLoaderSchema>(std::exchange(handler.m_schema, ConfigLoaderSchema()));
+    if (*ok) {
+        QMutexLocker locker(&cache.mutex);
+        // a process only loads a few different schemas, many times
+        if (cache.schemas.size() >= 64) {
+            cache.schemas.clear();
+        }
+        cache.schemas.insert(xml, schema);
+    }
+    return schema;
+}
+
+bool ConfigLoaderHandler::parseXml(const QByteArray &xml)
+{
+    QXmlStreamReader reader(xml);
 
     while (!reader.atEnd()) {
         reader.readNext();
@@ -71,6 +128,17 @@ bool ConfigLoaderHandler::parse(QIODevice *input)
     return true;
 }
 
+void ConfigLoaderHandler::apply(const ConfigLoaderSchema &schema)
+{
+    for (const ConfigLoaderSchema::Step &step : schema.steps) {
+        if (step.isGroup) {
+            addGroup(step.group);
+        } else {
+            addItem(step.entry);
+        }
+    }
+}
+
 static bool caseInsensitiveCompare(const QStringView a, const QLatin1String b)
 {
     return a.compare(b, Qt::CaseInsensitive) == 0;
@@ -80,35 +148,25 @@ void ConfigLoaderHandler::startElement(const QStringView localName, const QXmlSt
 {
     // qDebug() << "ConfigLoaderHandler::startElement(" << localName << qName;
     if (caseInsensitiveCompare(localName, QLatin1String("group"))) {
-        QString group;
+        ConfigLoaderSchema::Step step;
+        step.isGroup = true;
         for (const auto &attr : attrs) {
             const auto attrName = attr.name();
             if (caseInsensitiveCompare(attrName, QLatin1String("name"))) {
                 // qDebug() << "set group to" << attrs.value(i);
-                group = attr.value().toString();
-            }
-        }
-        if (group.isEmpty()) {
-            group = d->baseGroup;
-        } else {
-            d->groups.append(group);
-            if (!d->baseGroup.isEmpty()) {
-                group = d->baseGroup + QLatin1Char('\x1d') + group;
+                step.group = attr.value().toString();
             }
         }
-
-        if (m_config) {
-            m_config->setCurrentGroup(group);
-        }
+        m_schema.steps.append(step);
     } else if (caseInsensitiveCompare(localName, QLatin1String("entry"))) {
         for (const auto &attr : attrs) {
             const auto attrName = attr.name();
             if (caseInsensitiveCompare(attrName, QLatin1String("name"))) {
-                m_name = attr.value().trimmed().toString();
+                m_entry.name = attr.value().trimmed().toString();
             } else if (caseInsensitiveCompare(attrName, QLatin1String("type"))) {
-                m_type = attr.value().toString().toLower();
+                m_entry.type = attr.value().toString().toLower();
             } else if (caseInsensitiveCompare(attrName, QLatin1String("key"))) {
-                m_key = attr.value().trimmed().toString();
+                m_entry.key = attr.value().trimmed().toString();
             }
         }
     } else if (caseInsensitiveCompare(localName, QLatin1String("choice"))) {
@@ -129,191 +187,209 @@ void ConfigLoaderHandler::endElement(const QStringView localName)
 {
     //     qDebug() << "ConfigLoaderHandler::endElement(" << localName << qName;
     if (caseInsensitiveCompare(localName, QLatin1String("entry"))) {
-        addItem();
+        recordEntry();
         resetState();
     } else if (caseInsensitiveCompare(localName, QLatin1String("label"))) {
         if (m_inChoice) {
             m_choice.label = m_cdata.trimmed();
         } else {
-            m_label = m_cdata.trimmed();
+            m_entry.label = m_cdata.trimmed();
         }
     } else if (caseInsensitiveCompare(localName, QLatin1String("whatsthis"))) {
         if (m_inChoice) {
             m_choice.whatsThis = m_cdata.trimmed();
         } else {
-            m_whatsThis = m_cdata.trimmed();
+            m_entry.whatsThis = m_cdata.trimmed();
         }
     } else if (caseInsensitiveCompare(localName, QLatin1String("default"))) {
-        m_default = m_cdata.trimmed();
+        m_entry.defaultValue = m_cdata.trimmed();
     } else if (caseInsensitiveCompare(localName, QLatin1String("min"))) {
-        m_min = m_cdata.toInt(&m_haveMin);
+        m_entry.min = m_cdata.toInt(&m_entry.haveMin);
     } else if (caseInsensitiveCompare(localName, QLatin1String("max"))) {
-        m_max = m_cdata.toInt(&m_haveMax);
+        m_entry.max = m_cdata.toInt(&m_entry.haveMax);
     } else if (caseInsensitiveCompare(localName, QLatin1String("choice"))) {
-        m_enumChoices.append(m_choice);
+        m_entry.enumChoices.append(m_choice);
         m_inChoice = false;
     }
 
     m_cdata.clear();
 }
 
-void ConfigLoaderHandler::addItem()
+void ConfigLoaderHandler::recordEntry()
 {
-    if (m_name.isEmpty()) {
-        if (m_key.isEmpty()) {
+    if (m_entry.name.isEmpty()) {
+        if (m_entry.key.isEmpty()) {
             return;
         }
 
-        m_name = m_key;
+        m_entry.name = m_entry.key;
+    }
+
+    m_entry.name.remove(QLatin1Char(' '));
+
+    if (m_entry.type == QLatin1String("stringlist") || m_entry.type == QLatin1String("intlist")) {
+        // FIXME: the split() is naive and will break on lists with ,'s in them
+        // empty parts are not wanted in this case
+        m_entry.defaultList = m_entry.defaultValue.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    }
+
+    ConfigLoaderSchema::Step step;
+    step.entry = m_entry;
+    m_schema.steps.append(step);
+}
+
+void ConfigLoaderHandler::addGroup(const QString &name)
+{
+    QString group = name;
+    if (group.isEmpty()) {
+        group = d->baseGroup;
+    } else {
+        d->groups.append(group);
+        if (!d->baseGroup.isEmpty()) {
+            group = d->baseGroup + QLatin1Char('\x1d') + group;
+        }
+    }
+
+    if (m_config) {
+        m_config->setCurrentGroup(group);
     }
+}
 
-    m_name.remove(QLatin1Char(' '));
+void ConfigLoaderHandler::addItem(const ConfigLoaderEntry &entry)
+{
+    QString key = entry.key;
 
     KConfigSkeletonItem *item = nullptr;
 
-    if (m_type == QLatin1String("bool")) {
-        const bool defaultValue = caseInsensitiveCompare(m_default, QLatin1String("true"));
-        item = m_config->addItemBool(m_name, *d->newBool(), defaultValue, m_key);
-    } else if (m_type == QLatin1String("color")) {
-        item = m_config->addItemColor(m_name, *d->newColor(), QColor(m_default), m_key);
-    } else if (m_type == QLatin1String("datetime")) {
-        item = m_config->addItemDateTime(m_name, *d->newDateTime(), QDateTime::fromString(m_default), m_key);
-    } else if (m_type == QLatin1String("enum")) {
-        m_key = (m_key.isEmpty()) ? m_name : m_key;
-        KConfigSkeleton::ItemEnum *enumItem = new KConfigSkeleton::ItemEnum(m_config->currentGroup(), m_key, *d->newInt(), m_enumChoices, m_default.toUInt());
-        m_config->addItem(enumItem, m_name);
+    if (entry.type == QLatin1String("bool")) {
+        const bool defaultValue = caseInsensitiveCompare(entry.defaultValue, QLatin1String("true"));
+        item = m_config->addItemBool(entry.name, *d->newBool(), defaultValue, key);
+    } else if (entry.type == QLatin1String("color")) {
+        item = m_config->addItemColor(entry.name, *d->newColor(), QColor(entry.defaultValue), key);
+    } else if (entry.type == QLatin1String("datetime")) {
+        item = m_config->addItemDateTime(entry.name, *d->newDateTime(), QDateTime::fromString(entry.defaultValue), key);
+    } else if (entry.type == QLatin1String("enum")) {
+        key = (key.isEmpty()) ? entry.name : key;
+        KConfigSkeleton::ItemEnum *enumItem = new KConfigSkeleton::ItemEnum(m_config->currentGroup(), key, *d->newInt(), entry.enumChoices, entry.defaultValue.toUInt());
+        m_config->addItem(enumItem, entry.name);
         item = enumItem;
-    } else if (m_type == QLatin1String("font")) {
-        item = m_config->addItemFont(m_name, *d->newFont(), QFont(m_default), m_key);
-    } else if (m_type == QLatin1String("int")) {
-        KConfigSkeleton::ItemInt *intItem = m_config->addItemInt(m_name, *d->newInt(), m_default.toInt(), m_key);
+    } else if (entry.type == QLatin1String("font")) {
+        item = m_config->addItemFont(entry.name, *d->newFont(), QFont(entry.defaultValue), key);
+    } else if (entry.type == QLatin1String("int")) {
+        KConfigSkeleton::ItemInt *intItem = m_config->addItemInt(entry.name, *d->newInt(), entry.defaultValue.toInt(), key);
 
-        if (m_haveMin) {
-            intItem->setMinValue(m_min);
+        if (entry.haveMin) {
+            intItem->setMinValue(entry.min);
         }
 
-        if (m_haveMax) {
-            intItem->setMaxValue(m_max);
+        if (entry.haveMax) {
+            intItem->setMaxValue(entry.max);
         }
 
         item = intItem;
-    } else if (m_type == QLatin1String("password")) {
-        item = m_config->addItemPassword(m_name, *d->newString(), m_default, m_key);
-    } else if (m_type == QLatin1String("path")) {
-        item = m_config->addItemPath(m_name, *d->newString(), m_default, m_key);
-    } else if (m_type == QLatin1String("string")) {
-        item = m_config->addItemString(m_name, *d->newString(), m_default, m_key);
-    } else if (m_type == QLatin1String("stringlist")) {
-        // FIXME: the split() is naive and will break on lists with ,'s in them
-        // empty parts are not wanted in this case
-        item = m_config->addItemStringList(m_name, *d->newStringList(), m_default.split(QLatin1Char(','), Qt::SkipEmptyParts), m_key);
-    } else if (m_type == QLatin1String("uint")) {
-        KConfigSkeleton::ItemUInt *uintItem = m_config->addItemUInt(m_name, *d->newUint(), m_default.toUInt(), m_key);
-        if (m_haveMin) {
-            uintItem->setMinValue(m_min);
+    } else if (entry.type == QLatin1String("password")) {
+        item = m_config->addItemPassword(entry.name, *d->newString(), entry.defaultValue, key);
+    } else if (entry.type == QLatin1String("path")) {
+        item = m_config->addItemPath(entry.name, *d->newString(), entry.defaultValue, key);
+    } else if (entry.type == QLatin1String("string")) {
+        item = m_config->addItemString(entry.name, *d->newString(), entry.defaultValue, key);
+    } else if (entry.type == QLatin1String("stringlist")) {
+        item = m_config->addItemStringList(entry.name, *d->newStringList(), entry.defaultList, key);
+    } else if (entry.type == QLatin1String("uint")) {
+        KConfigSkeleton::ItemUInt *uintItem = m_config->addItemUInt(entry.name, *d->newUint(), entry.defaultValue.toUInt(), key);
+        if (entry.haveMin) {
+            uintItem->setMinValue(entry.min);
         }
-        if (m_haveMax) {
-            uintItem->setMaxValue(m_max);
+        if (entry.haveMax) {
+            uintItem->setMaxValue(entry.max);
         }
         item = uintItem;
-    } else if (m_type == QLatin1String("url")) {
-        m_key = (m_key.isEmpty()) ? m_name : m_key;
-        KConfigSkeleton::ItemUrl *urlItem = new KConfigSkeleton::ItemUrl(m_config->currentGroup(), m_key, *d->newUrl(), QUrl::fromUserInput(m_default));
-        m_config->addItem(urlItem, m_name);
+    } else if (entry.type == QLatin1String("url")) {
+        key = (key.isEmpty()) ? entry.name : key;
+        KConfigSkeleton::ItemUrl *urlItem = new KConfigSkeleton::ItemUrl(m_config->currentGroup(), key, *d->newUrl(), QUrl::fromUserInput(entry.defaultValue));
+        m_config->addItem(urlItem, entry.name);
         item = urlItem;
-    } else if (m_type == QLatin1String("double")) {
-        KConfigSkeleton::ItemDouble *doubleItem = m_config->addItemDouble(m_name, *d->newDouble(), m_default.toDouble(), m_key);
-        if (m_haveMin) {
-            doubleItem->setMinValue(m_min);
+    } else if (entry.type == QLatin1String("double")) {
+        KConfigSkeleton::ItemDouble *doubleItem = m_config->addItemDouble(entry.name, *d->newDouble(), entry.defaultValue.toDouble(), key);
+        if (entry.haveMin) {
+            doubleItem->setMinValue(entry.min);
         }
-        if (m_haveMax) {
-            doubleItem->setMaxValue(m_max);
+        if (entry.haveMax) {
+            doubleItem->setMaxValue(entry.max);
         }
         item = doubleItem;
-    } else if (m_type == QLatin1String("intlist")) {
+    } else if (entry.type == QLatin1String("intlist")) {
         QList<int> defaultList;
-        const QStringList tmpList = m_default.split(QLatin1Char(','), Qt::SkipEmptyParts);
-        for (const QString &tmp : tmpList) {
+        for (const QString &tmp : entry.defaultList) {
             defaultList.append(tmp.toInt());
         }
-        item = m_config->addItemIntList(m_name, *d->newIntList(), defaultList, m_key);
-    } else if (m_type == QLatin1String("longlong")) {
-        KConfigSkeleton::ItemLongLong *longlongItem = m_config->addItemLongLong(m_name, *d->newLongLong(), m_default.toLongLong(), m_key);
-        if (m_haveMin) {
-            longlongItem->setMinValue(m_min);
+        item = m_config->addItemIntList(entry.name, *d->newIntList(), defaultList, key);
+    } else if (entry.type == QLatin1String("longlong")) {
+        KConfigSkeleton::ItemLongLong *longlongItem = m_config->addItemLongLong(entry.name, *d->newLongLong(), entry.defaultValue.toLongLong(), key);
+        if (entry.haveMin) {
+            longlongItem->setMinValue(entry.min);
         }
-        if (m_haveMax) {
-            longlongItem->setMaxValue(m_max);
+        if (entry.haveMax) {
+            longlongItem->setMaxValue(entry.max);
         }
         item = longlongItem;
         /* No addItemPathList in KConfigSkeleton ?
-        } else if (m_type == "PathList") {
+        } else if (entry.type == "PathList") {
             //FIXME: the split() is naive and will break on lists with ,'s in them
-            item = m_config->addItemPathList(m_name, *d->newStringList(), m_default.split(","), m_key);
+            item = m_config->addItemPathList(entry.name, *d->newStringList(), entry.defaultValue.split(","), key);
         */
-    } else if (m_type == QLatin1String("point")) {
+    } else if (entry.type == QLatin1String("point")) {
         QPoint defaultPoint;
-        const QStringList tmpList = m_default.split(QLatin1Char(','));
+        const QStringList tmpList = entry.defaultValue.split(QLatin1Char(','));
         if (tmpList.size() >= 2) {
             defaultPoint.setX(tmpList[0].toInt());
             defaultPoint.setY(tmpList[1].toInt());
         }
-        item = m_config->addItemPoint(m_name, *d->newPoint(), defaultPoint, m_key);
-    } else if (m_type == QLatin1String("rect")) {
+        item = m_config->addItemPoint(entry.name, *d->newPoint(), defaultPoint, key);
+    } else if (entry.type == QLatin1String("rect")) {
         QRect defaultRect;
-        const QStringList tmpList = m_default.split(QLatin1Char(','));
+        const QStringList tmpList = entry.defaultValue.split(QLatin1Char(','));
         if (tmpList.size() >= 4) {
             defaultRect.setCoords(tmpList[0].toInt(), tmpList[1].toInt(), tmpList[2].toInt(), tmpList[3].toInt());
         }
-        item = m_config->addItemRect(m_name, *d->newRect(), defaultRect, m_key);
-    } else if (m_type == QLatin1String("size")) {
+        item = m_config->addItemRect(entry.name, *d->newRect(), defaultRect, key);
+    } else if (entry.type == QLatin1String("size")) {
         QSize defaultSize;
-        const QStringList tmpList = m_default.split(QLatin1Char(','));
+        const QStringList tmpList = entry.defaultValue.split(QLatin1Char(','));
         if (tmpList.size() >= 2) {
             defaultSize.setWidth(tmpList[0].toInt());
             defaultSize.setHeight(tmpList[1].toInt());
         }
-        item = m_config->addItemSize(m_name, *d->newSize(), defaultSize, m_key);
-    } else if (m_type == QLatin1String("ulonglong")) {
-        KConfigSkeleton::ItemULongLong *ulonglongItem = m_config->addItemULongLong(m_name, *d->newULongLong(), m_default.toULongLong(), m_key);
-        if (m_haveMin) {
-            ulonglongItem->setMinValue(m_min);
+        item = m_config->addItemSize(entry.name, *d->newSize(), defaultSize, key);
+    } else if (entry.type == QLatin1String("ulonglong")) {
+        KConfigSkeleton::ItemULongLong *ulonglongItem = m_config->addItemULongLong(entry.name, *d->newULongLong(), entry.defaultValue.toULongLong(), key);
+        if (entry.haveMin) {
+            ulonglongItem->setMinValue(entry.min);
         }
-        if (m_haveMax) {
-            ulonglongItem->setMaxValue(m_max);
+        if (entry.haveMax) {
+            ulonglongItem->setMaxValue(entry.max);
         }
         item = ulonglongItem;
         /* No addItemUrlList in KConfigSkeleton ?
-        } else if (m_type == "urllist") {
+        } else if (entry.type == "urllist") {
             //FIXME: the split() is naive and will break on lists with ,'s in them
-            QStringList tmpList = m_default.split(",");
+            QStringList tmpList = entry.defaultValue.split(",");
             QList<QUrl> defaultList;
             foreach (const QString& tmp, tmpList) {
                 defaultList.append(QUrl(tmp));
             }
-            item = m_config->addItemUrlList(m_name, *d->newUrlList(), defaultList, m_key);*/
+            item = m_config->addItemUrlList(entry.name, *d->newUrlList(), defaultList, key);*/
     }
 
     if (item) {
-        item->setLabel(m_label);
-        item->setWhatsThis(m_whatsThis);
-        d->keysToNames.insert(item->group() + item->key(), item->name());
+        item->setLabel(entry.label);
+        item->setWhatsThis(entry.whatsThis);
     }
 }
 
 void ConfigLoaderHandler::resetState()
 {
-    m_haveMin = false;
-    m_min = 0;
-    m_haveMax = false;
-    m_max = 0;
-    m_name.clear();
-    m_type.clear();
-    m_label.clear();
-    m_default.clear();
-    m_key.clear();
-    m_whatsThis.clear();
-    m_enumChoices.clear();
+    m_entry = ConfigLoaderEntry();
     m_inChoice = false;
 }
 
@@ -373,6 +449,34 @@ void KConfigLoader::setupConfigGroup(const KConfigGroup &config, QIODevice *xml)
     d->parse(this, xml);
 }
 
+QFuture<KConfigLoader *>
+KConfigLoader::createAsync(KConfig::ConfigAssociation association, const QString &configFile, const QByteArray &xml, QObject *parent)
+{
+    Q_ASSERT_X(parent, "KConfigLoader::createAsync", "the loader is created in the thread of its parent");
+
+    // the config is shared in this thread right away, and parsed in the thread pool
+    const QFuture<KSharedConfigPtr> config = KSharedConfig::openConfigAsync(association, configFile);
+
+    auto promise = std::make_shared<QPromise<void>>();
+    QFuture<void> schema = promise->future();
+    QThreadPool::globalInstance()->start([promise, xml]() {
+        promise->start();
+        bool ok = true;
+        ConfigLoaderHandler::schemaOf(xml, &ok);
+        promise->finish();
+    });
+
+    // with both ready, the constructor only creates the items and reads them
+    QFuture<QFuture<KSharedConfigPtr>> afterSchema = schema.then(parent, [config]() {
+        return config;
+    });
+    return afterSchema.unwrap().then(parent, [xml, parent](KSharedConfigPtr sharedConfig) {
+        QBuffer buffer;
+        buffer.setData(xml);
+        return new KConfigLoader(std::move(sharedConfig), &buffer, parent);
+    });
+}
+
 KConfigLoader::~KConfigLoader()
 {
     delete d;
@@ -380,7 +484,7 @@ KConfigLoader::~KConfigLoader()
 
 KConfigSkeletonItem *KConfigLoader::findItem(const QString &group, const QString &key) const
 {
-    return KConfigSkeleton::findItem(d->keysToNames[group + key]);
+    return KConfigSkeleton::findItem(group, key);
 }
 
 KConfigSkeletonItem *KConfigLoader::findItemByName(const QString &name) const
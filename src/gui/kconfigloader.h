@@ -7,6 +7,7 @@
 #ifndef KCONFIGLOADER_H
 #define KCONFIGLOADER_H
 
+#include <QFuture>
 #include <QIODevice>
 
 #include <kconfiggroup.h>
@@ -136,6 +137,31 @@ public:
         "Please specify association by calling KConfigLoader(KConfig::ConfigAssociation associatoin, const KConfigGroup &config, QIODevice *xml, QObject "
         "*parent = nullptr) instead.")]] KConfigLoader(const KConfigGroup &config, QIODevice *xml, QObject *parent = nullptr);
 
+    /**
+     * Creates a loader the same as KConfigLoader(association, configFile, xml, parent),
+     * with the slow parts done on background threads: the XML is parsed in the
+     * thread pool, and the config file as with KSharedConfig::openConfigAsync().
+     * The loader is created in the thread of @p parent once both are done,
+     * which only has to create the items and read their values then.
+     *
+     * The future finishes in the thread of @p parent, or is canceled if
+     * @p parent is deleted before. It can be continued with QFuture::then()
+     * and a context object of that thread.
+     *
+     * \code
+     * KConfigLoader::createAsync(KConfig::ConfigAssociation::KdeApp, configFile, xml, this).then(this, [this](KConfigLoader *loader) {
+     *     m_configLoader = loader;
+     * });
+     * \endcode
+     *
+     * @param association see KConfigLoader(association, configFile, xml, parent)
+     * @param configFile path to the configuration file to use
+     * @param xml the contents of a .kcfg file; must be valid KConfigXT data
+     * @param parent the parent of the loader, which must not be null
+     * @since 6.1
+     */
+    static QFuture<KConfigLoader *> createAsync(KConfig::ConfigAssociation association, const QString &configFile, const QByteArray &xml, QObject *parent);
+
     ~KConfigLoader() override;
 
     /**
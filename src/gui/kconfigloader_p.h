@@ -9,6 +9,10 @@
 
 #include <QUrl>
 
+#include <memory>
+
+struct ConfigLoaderSchema;
+
 class ConfigLoaderPrivate
 {
 public:
@@ -201,7 +205,8 @@ public:
     QList<QList<QUrl> *> urllists;
     QString baseGroup;
     QStringList groups;
-    QHash<QString, QString> keysToNames;
+    // what the items were created from, shared by all the loaders of the same file
+    std::shared_ptr<const ConfigLoaderSchema> schema;
     bool saveDefaults;
 };
 
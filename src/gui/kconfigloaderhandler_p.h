@@ -10,35 +10,64 @@
 
 #include <QXmlStreamAttributes>
 
+#include <memory>
+
+// An entry of a .kcfg file, as read by ConfigLoaderHandler
+struct ConfigLoaderEntry {
+    QString name;
+    QString key;
+    QString type;
+    QString label;
+    QString defaultValue;
+    QStringList defaultList; // the default of the list types, split once
+    QString whatsThis;
+    QList<KConfigSkeleton::ItemEnum::Choice> enumChoices;
+    int min = 0;
+    int max = 0;
+    bool haveMin = false;
+    bool haveMax = false;
+};
+
+// The groups and entries of a .kcfg file in the order of the document, which is
+// all the loaders need from it: it is kept per content, so that the loaders of
+// the same file only parse it once
+struct ConfigLoaderSchema {
+    struct Step {
+        bool isGroup = false;
+        QString group; // the name attribute of a group
+        ConfigLoaderEntry entry;
+    };
+    QList<Step> steps;
+};
+
 class ConfigLoaderHandler
 {
 public:
     ConfigLoaderHandler(KConfigLoader *config, ConfigLoaderPrivate *d);
 
     bool parse(QIODevice *input);
+    // The schema of the .kcfg file @p xml, taken from the cache of the process or parsed
+    // and added to it. @p ok is set to false if it isn't valid, which isn't cached.
+    // Needs no loader, so that it can be called in any thread.
+    static std::shared_ptr<const ConfigLoaderSchema> schemaOf(const QByteArray &xml, bool *ok);
 
     void startElement(const QStringView localName, const QXmlStreamAttributes &attrs);
     void endElement(const QStringView localName);
 
 private:
-    void addItem();
+    bool parseXml(const QByteArray &xml);
+    void apply(const ConfigLoaderSchema &schema);
+    void addGroup(const QString &name);
+    void addItem(const ConfigLoaderEntry &entry);
+    void recordEntry();
     void resetState();
 
     KConfigLoader *m_config;
     ConfigLoaderPrivate *d;
-    int m_min;
-    int m_max;
-    QString m_name;
-    QString m_key;
-    QString m_type;
-    QString m_label;
-    QString m_default;
+    ConfigLoaderSchema m_schema;
+    ConfigLoaderEntry m_entry;
     QString m_cdata;
-    QString m_whatsThis;
     KConfigSkeleton::ItemEnum::Choice m_choice;
-    QList<KConfigSkeleton::ItemEnum::Choice> m_enumChoices;
-    bool m_haveMin;
-    bool m_haveMax;
     bool m_inChoice;
 };
 
@@ -33,7 +33,7 @@ KConfigSkeleton::ItemColor::ItemColor(const QString &_group, const QString &_key
 void KConfigSkeleton::ItemColor::readConfig(KConfig *config)
 {
     KConfigGroup cg(config, mGroup);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readEntry(keyUtf8(), mDefault);
     mLoadedValue = mReference;
 
     readImmutability(cg);
@@ -42,6 +42,7 @@ void KConfigSkeleton::ItemColor::readConfig(KConfig *config)
 void KConfigSkeleton::ItemColor::setProperty(const QVariant &p)
 {
     mReference = qvariant_cast<QColor>(p);
+    markChanged();
 }
 
 bool KConfigSkeleton::ItemColor::isEqual(const QVariant &v) const
@@ -62,7 +63,7 @@ KConfigSkeleton::ItemFont::ItemFont(const QString &_group, const QString &_key,
 void KConfigSkeleton::ItemFont::readConfig(KConfig *config)
 {
     KConfigGroup cg(config, mGroup);
-    mReference = cg.readEntry(mKey, mDefault);
+    mReference = cg.readEntry(keyUtf8(), mDefault);
     mLoadedValue = mReference;
 
     readImmutability(cg);
@@ -71,6 +72,7 @@ void KConfigSkeleton::ItemFont::readConfig(KConfig *config)
 void KConfigSkeleton::ItemFont::setProperty(const QVariant &p)
 {
     mReference = qvariant_cast<QFont>(p);
+    markChanged();
 }
 
 bool KConfigSkeleton::ItemFont::isEqual(const QVariant &v) const
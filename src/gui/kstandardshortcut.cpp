@@ -8,6 +8,7 @@
 */
 
 #include "kstandardshortcut.h"
+#include "kstandardshortcut_p.h"
 #include "kstandardshortcutwatcher.h"
 
 #include "kconfig.h"
@@ -17,7 +18,9 @@
 
 #include <QCoreApplication>
 #include <QDebug>
+#include <QHash>
 #include <QKeySequence>
+#include <QSet>
 
 namespace KStandardShortcut
 {
@@ -432,25 +435,36 @@ static KStandardShortcutInfo *guardedStandardShortcutInfo(StandardShortcut id)
 // declaration is clearly bogus so fix it
 static void sanitizeShortcutList(QList<QKeySequence> *list)
 {
-    for (int i = 0; i < list->size(); ++i) {
-        const QKeySequence &ks = list->at(i);
-        int other = list->indexOf(ks, i + 1);
-        while (other != -1) {
-            list->removeAt(other);
-            other = list->indexOf(ks, other);
+    QSet<QKeySequence> seen;
+    seen.reserve(list->size());
+    qsizetype kept = 0;
+    for (qsizetype i = 0; i < list->size(); ++i) {
+        if (!seen.contains(list->at(i))) {
+            seen.insert(list->at(i));
+            if (kept != i) {
+                (*list)[kept] = list->at(i);
+            }
+            ++kept;
         }
     }
+    list->resize(kept);
 }
 
-/** Initialize the accelerator @p id by checking if it is overridden
-    in the configuration file (and if it isn't, use the default).
-    On X11, if QApplication was initialized with GUI disabled,
-    the default will always be used.
-*/
-void initialize(StandardShortcut id)
+// The shortcuts by key sequence, built by find() once all the shortcuts are initialized
+// and dropped whenever one of them changes
+struct SequenceIndex {
+    QHash<QKeySequence, StandardShortcut> ids;
+    bool isValid = false;
+};
+
+static SequenceIndex &sequenceIndex()
 {
-    KStandardShortcutInfo *info = guardedStandardShortcutInfo(id);
+    static SequenceIndex index;
+    return index;
+}
 
+static void initialize(KStandardShortcutInfo *info, const KConfigGroup &cg)
+{
     // All three are needed.
     if (info->id != AccelNone) {
         Q_ASSERT(info->description.text);
@@ -458,35 +472,63 @@ void initialize(StandardShortcut id)
         Q_ASSERT(info->name);
     }
 
-    KConfigGroup cg(KSharedConfig::openConfig(), "Shortcuts");
-
-    if (cg.hasKey(info->name)) {
-        QString s = cg.readEntry(info->name);
-        if (s != QLatin1String("none")) {
-            info->cut = QKeySequence::listFromString(s);
+    // a null view if there is no entry, one lookup instead of hasKey() and a read
+    const QByteArrayView s = cg.readEntryRaw(info->name);
+    if (!s.isNull()) {
+        if (s != "none") {
+            info->cut = QKeySequence::listFromString(QString::fromUtf8(s));
             sanitizeShortcutList(&info->cut);
         } else {
             info->cut = QList<QKeySequence>();
         }
     } else {
-        info->cut = hardcodedDefaultShortcut(id);
+        info->cut = hardcodedDefaultShortcut(info->id);
     }
 
     info->isInitialized = true;
+    sequenceIndex().isValid = false;
 }
 
-void saveShortcut(StandardShortcut id, const QList<QKeySequence> &newShortcut)
+/** Initialize the accelerator @p id by checking if it is overridden
+    in the configuration file (and if it isn't, use the default).
+    On X11, if QApplication was initialized with GUI disabled,
+    the default will always be used.
+*/
+void initialize(StandardShortcut id)
+{
+    initialize(guardedStandardShortcutInfo(id), KConfigGroup(KSharedConfig::openConfig(), "Shortcuts"));
+}
+
+void initialize(const QList<StandardShortcut> &ids, const KConfigGroup &cg)
+{
+    for (const StandardShortcut id : ids) {
+        initialize(guardedStandardShortcutInfo(id), cg);
+    }
+}
+
+// Initializes all the shortcuts that aren't yet, reading their group once
+static void initializeAll()
+{
+    const KConfigGroup cg(KSharedConfig::openConfig(), "Shortcuts");
+    for (KStandardShortcutInfo &shortcutInfo : g_infoStandardShortcut) {
+        if (shortcutInfo.id != AccelNone && !shortcutInfo.isInitialized) {
+            initialize(&shortcutInfo, cg);
+        }
+    }
+}
+
+// Writes @p newShortcut of @p id to @p cg, returns whether the group needs to be synced
+static bool writeShortcut(KConfigGroup &cg, StandardShortcut id, const QList<QKeySequence> &newShortcut)
 {
     KStandardShortcutInfo *info = guardedStandardShortcutInfo(id);
     // If the action has no standard shortcut associated there is nothing to
     // save
     if (info->id == AccelNone) {
-        return;
+        return false;
     }
 
-    KConfigGroup cg(KSharedConfig::openConfig(), "Shortcuts");
-
     info->cut = newShortcut;
+    sequenceIndex().isValid = false;
     bool sameAsDefault = (newShortcut == hardcodedDefaultShortcut(id));
 
     if (sameAsDefault) {
@@ -494,16 +536,37 @@ void saveShortcut(StandardShortcut id, const QList<QKeySequence> &newShortcut)
         // kdeglobal if necessary and return.
         if (cg.hasKey(info->name)) {
             cg.deleteEntry(info->name, KConfig::Global | KConfig::Persistent | KConfig::Notify);
-            cg.sync();
+            return true;
         }
 
-        return;
+        return false;
     }
 
     // Write the changed shortcut to kdeglobals
     sanitizeShortcutList(&info->cut);
     cg.writeEntry(info->name, QKeySequence::listToString(info->cut), KConfig::Global | KConfig::Persistent | KConfig::Notify);
-    cg.sync();
+    return true;
+}
+
+void saveShortcut(StandardShortcut id, const QList<QKeySequence> &newShortcut)
+{
+    KConfigGroup cg(KSharedConfig::openConfig(), "Shortcuts");
+    if (writeShortcut(cg, id, newShortcut)) {
+        cg.sync();
+    }
+}
+
+void saveShortcuts(const QHash<StandardShortcut, QList<QKeySequence>> &newShortcuts)
+{
+    KConfigGroup cg(KSharedConfig::openConfig(), "Shortcuts");
+    bool needsSync = false;
+    for (auto it = newShortcuts.cbegin(); it != newShortcuts.cend(); ++it) {
+        needsSync = writeShortcut(cg, it.key(), it.value()) || needsSync;
+    }
+    // A single sync writes kdeglobals and notifies the watchers of all the changes at once
+    if (needsSync) {
+        cg.sync();
+    }
 }
 
 QString name(StandardShortcut id)
@@ -532,7 +595,12 @@ const QList<QKeySequence> &shortcut(StandardShortcut id)
     KStandardShortcutInfo *info = guardedStandardShortcutInfo(id);
 
     if (!info->isInitialized) {
-        initialize(id);
+        // The first shortcut asked for is rarely the last one
+        if (info->id != AccelNone) {
+            initializeAll();
+        } else {
+            initialize(id);
+        }
     }
 
     return info->cut;
@@ -540,30 +608,45 @@ const QList<QKeySequence> &shortcut(StandardShortcut id)
 
 StandardShortcut find(const QKeySequence &seq)
 {
-    if (!seq.isEmpty()) {
+    if (seq.isEmpty()) {
+        return AccelNone;
+    }
+
+    SequenceIndex &index = sequenceIndex();
+    if (!index.isValid) {
+        initializeAll();
+
+        index.ids.clear();
         for (const KStandardShortcutInfo &shortcutInfo : g_infoStandardShortcut) {
-            const StandardShortcut id = shortcutInfo.id;
-            if (id != AccelNone) {
-                if (!shortcutInfo.isInitialized) {
-                    initialize(id);
-                }
-                if (shortcutInfo.cut.contains(seq)) {
-                    return id;
+            if (shortcutInfo.id == AccelNone) {
+                continue;
+            }
+            for (const QKeySequence &cut : shortcutInfo.cut) {
+                // The first shortcut of the table using a sequence wins, as it always did
+                if (!cut.isEmpty() && !index.ids.contains(cut)) {
+                    index.ids.insert(cut, shortcutInfo.id);
                 }
             }
         }
+        index.isValid = true;
     }
-    return AccelNone;
+
+    return index.ids.value(seq, AccelNone);
 }
 
 StandardShortcut findByName(const QString &name)
 {
-    for (const KStandardShortcutInfo &shortcutInfo : g_infoStandardShortcut) {
-        if (QString::fromLatin1(shortcutInfo.name) == name) {
-            return shortcutInfo.id;
+    // The names never change, they are indexed once
+    static const QHash<QString, StandardShortcut> ids = [] {
+        QHash<QString, StandardShortcut> ids;
+        for (const KStandardShortcutInfo &shortcutInfo : g_infoStandardShortcut) {
+            if (shortcutInfo.name) {
+                ids.insert(QString::fromLatin1(shortcutInfo.name), shortcutInfo.id);
+            }
         }
-    }
-    return AccelNone;
+        return ids;
+    }();
+    return ids.value(name, AccelNone);
 }
 
 QList<QKeySequence> hardcodedDefaultShortcut(StandardShortcut id)
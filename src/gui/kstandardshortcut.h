@@ -9,6 +9,7 @@
 #ifndef KSTANDARDSHORTCUT_H
 #define KSTANDARDSHORTCUT_H
 
+#include <QHash>
 #include <QKeySequence>
 #include <QString>
 
@@ -218,6 +219,13 @@ KCONFIGGUI_EXPORT QList<QKeySequence> hardcodedDefaultShortcut(StandardShortcut
  */
 KCONFIGGUI_EXPORT void saveShortcut(StandardShortcut id, const QList<QKeySequence> &newShortcut);
 
+/**
+ * Saves the new shortcuts in @p newShortcuts, like saveShortcut() does for each of them,
+ * but writes the configuration and notifies the StandardShortcutWatcher only once.
+ * @since 6.1
+ */
+KCONFIGGUI_EXPORT void saveShortcuts(const QHash<StandardShortcut, QList<QKeySequence>> &newShortcuts);
+
 /**
  * Returns the appropriate category for the given StandardShortcut \p id.
  * @since 5.73
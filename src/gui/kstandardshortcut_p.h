@@ -12,9 +12,13 @@
 
 #include "kstandardshortcut.h"
 
+class KConfigGroup;
+
 namespace KStandardShortcut
 {
 void initialize(StandardShortcut id);
+// Initializes @p ids again from @p cg, the "Shortcuts" group
+void initialize(const QList<StandardShortcut> &ids, const KConfigGroup &cg);
 }
 
 #endif
@@ -14,7 +14,8 @@ namespace KStandardShortcut
 class StandardShortcutWatcherPrivate
 {
 public:
-    KConfigWatcher::Ptr watcher = KConfigWatcher::create(KSharedConfig::openConfig());
+    // Changes to the other groups of kdeglobals are of no interest, they aren't reparsed for us
+    KConfigWatcher::Ptr watcher = KConfigWatcher::create(KSharedConfig::openConfig(), {QStringLiteral("Shortcuts")});
 };
 
 StandardShortcutWatcher::StandardShortcutWatcher(QObject *parent)
@@ -25,13 +26,18 @@ StandardShortcutWatcher::StandardShortcutWatcher(QObject *parent)
         if (group.name() != QStringLiteral("Shortcuts")) {
             return;
         }
+        // Only the shortcuts listed by the notification are read again, from the group we got
+        QList<StandardShortcut> changed;
         for (const auto &key : keys) {
             const StandardShortcut shortcut = KStandardShortcut::findByName(QString::fromUtf8(key));
             if (shortcut != KStandardShortcut::AccelNone) {
-                initialize(shortcut);
-                Q_EMIT shortcutChanged(shortcut, KStandardShortcut::shortcut(shortcut));
+                changed.append(shortcut);
             }
         }
+        initialize(changed, group);
+        for (const StandardShortcut shortcut : std::as_const(changed)) {
+            Q_EMIT shortcutChanged(shortcut, KStandardShortcut::shortcut(shortcut));
+        }
     });
 }
 
@@ -9,9 +9,12 @@
 #include "ksharedconfig.h"
 
 #include <QGuiApplication>
+#include <QPointer>
 #include <QScreen>
 #include <QWindow>
 
+#include <optional>
+
 static const char s_initialSizePropertyName[] = "_kconfig_initial_size";
 static const char s_initialScreenSizePropertyName[] = "_kconfig_initial_screen_size";
 
@@ -69,36 +72,163 @@ static QString configFileString(const QScreen *screen, const QString &key)
     return returnString;
 }
 
+namespace
+{
+// The screen arrangement and the config keys derived from it
+struct ScreenKeys {
+    QString allConnectedScreens;
+    QString maximized;
+    QString width;
+    QString height;
+    QString xPosition;
+    QString yPosition;
+    // the same in UTF-8, to find them among the entries of a group
+    QByteArray utf8ConnectedScreens;
+    QByteArray utf8Maximized;
+    QByteArray utf8Width;
+    QByteArray utf8Height;
+    QByteArray utf8XPosition;
+    QByteArray utf8YPosition;
+};
+}
+
+// The keys of the current screen arrangement, computed again only once screens
+// are added, removed or change their geometry
+static const ScreenKeys &screenKeys()
+{
+    static ScreenKeys keys;
+    static bool valid = false;
+    static QPointer<QGuiApplication> application;
+
+    if (application != qGuiApp) {
+        application = qGuiApp;
+        valid = false;
+        if (application) {
+            const auto invalidate = []() {
+                valid = false;
+            };
+            const auto followScreen = [invalidate](QScreen *screen) {
+                QObject::connect(screen, &QScreen::geometryChanged, application, invalidate);
+            };
+            QObject::connect(application, &QGuiApplication::screenAdded, application, [invalidate, followScreen](QScreen *screen) {
+                invalidate();
+                followScreen(screen);
+            });
+            QObject::connect(application, &QGuiApplication::screenRemoved, application, invalidate);
+            QObject::connect(application, &QGuiApplication::primaryScreenChanged, application, invalidate);
+            const auto screens = QGuiApplication::screens();
+            for (QScreen *screen : screens) {
+                followScreen(screen);
+            }
+        }
+    }
+
+    if (!valid) {
+        keys.allConnectedScreens = allConnectedScreens();
+        keys.maximized = configFileString(nullptr, QStringLiteral("Window-Maximized"));
+        keys.width = configFileString(nullptr, QStringLiteral("Width"));
+        keys.height = configFileString(nullptr, QStringLiteral("Height"));
+        keys.xPosition = configFileString(nullptr, QStringLiteral("XPosition"));
+        keys.yPosition = configFileString(nullptr, QStringLiteral("YPosition"));
+        keys.utf8ConnectedScreens = keys.allConnectedScreens.toUtf8();
+        keys.utf8Maximized = keys.maximized.toUtf8();
+        keys.utf8Width = keys.width.toUtf8();
+        keys.utf8Height = keys.height.toUtf8();
+        keys.utf8XPosition = keys.xPosition.toUtf8();
+        keys.utf8YPosition = keys.yPosition.toUtf8();
+        // without an application there is nothing telling about changes
+        valid = !application.isNull();
+    }
+    return keys;
+}
+
 // Convenience function for "window is maximized" string
 static QString screenMaximizedString(const QScreen *screen)
 {
-    return configFileString(screen, QStringLiteral("Window-Maximized"));
+    Q_UNUSED(screen);
+    return screenKeys().maximized;
 }
 // Convenience function for window width string
 static QString windowWidthString(const QScreen *screen)
 {
-    return configFileString(screen, QStringLiteral("Width"));
+    Q_UNUSED(screen);
+    return screenKeys().width;
 }
 // Convenience function for window height string
 static QString windowHeightString(const QScreen *screen)
 {
-    return configFileString(screen, QStringLiteral("Height"));
+    Q_UNUSED(screen);
+    return screenKeys().height;
 }
 // Convenience function for window X position string
 static QString windowXPositionString(const QScreen *screen)
 {
-    return configFileString(screen, QStringLiteral("XPosition"));
+    Q_UNUSED(screen);
+    return screenKeys().xPosition;
 }
 // Convenience function for window Y position string
 static QString windowYPositionString(const QScreen *screen)
 {
-    return configFileString(screen, QStringLiteral("YPosition"));
+    Q_UNUSED(screen);
+    return screenKeys().yPosition;
 }
 static QString windowScreenPositionString()
 {
-    return QStringLiteral("%1").arg(allConnectedScreens());
+    return screenKeys().allConnectedScreens;
+}
+
+namespace
+{
+// The entries of the current screen arrangement in a group, unset if there is none
+struct SavedGeometry {
+    std::optional<QString> screenName;
+    std::optional<bool> maximized;
+    std::optional<int> width;
+    std::optional<int> height;
+    std::optional<int> xPosition;
+    std::optional<int> yPosition;
+};
+}
+
+// Reads the entries restoreWindowSize() and restoreWindowPosition() look at in one pass over
+// the group, instead of looking each one up. A value that isn't a number counts as unset.
+static SavedGeometry readSavedGeometry(const KConfigGroup &config)
+{
+    const ScreenKeys &keys = screenKeys();
+    SavedGeometry saved;
+    const auto toInt = [](QByteArrayView value, std::optional<int> &to) {
+        bool ok = false;
+        const int i = value.trimmed().toInt(&ok);
+        if (ok) {
+            to = i;
+        }
+    };
+    config.forEachEntry([&](QByteArrayView key, QByteArrayView value, KConfigGroup::EntryFlags) {
+        if (key == keys.utf8ConnectedScreens) {
+            saved.screenName = QString::fromUtf8(value);
+        } else if (key == keys.utf8Maximized) {
+            // as KConfigGroup::readEntry() reads a bool
+            const QByteArray lower = value.trimmed().toByteArray().toLower();
+            if (!lower.isEmpty()) {
+                saved.maximized = !(lower == "false" || lower == "no" || lower == "off" || lower == "0");
+            }
+        } else if (key == keys.utf8Width) {
+            toInt(value, saved.width);
+        } else if (key == keys.utf8Height) {
+            toInt(value, saved.height);
+        } else if (key == keys.utf8XPosition) {
+            toInt(value, saved.xPosition);
+        } else if (key == keys.utf8YPosition) {
+            toInt(value, saved.yPosition);
+        }
+    });
+    return saved;
 }
 
+static void restoreWindowSize(QWindow *window, const KConfigGroup &config, const SavedGeometry &saved);
+static void restoreWindowPosition(QWindow *window, const KConfigGroup &config, const SavedGeometry &saved);
+static void restoreWindowScreenPosition(QWindow *window, const QScreen *screen, const KConfigGroup &config, const SavedGeometry &saved);
+
 void KWindowConfig::saveWindowSize(const QWindow *window, KConfigGroup &config, KConfigGroup::WriteConfigFlags options)
 {
     // QWindow::screen() shouldn't return null, but it sometimes does due to bugs.
@@ -135,20 +265,21 @@ void KWindowConfig::restoreWindowSize(QWindow *window, const KConfigGroup &confi
     if (!window) {
         return;
     }
+    ::restoreWindowSize(window, config, readSavedGeometry(config));
+}
 
-    const QString screenName = config.readEntry(windowScreenPositionString(), window->screen()->name());
+static void restoreWindowSize(QWindow *window, const KConfigGroup &config, const SavedGeometry &saved)
+{
+    const QString screenName = saved.screenName.value_or(window->screen()->name());
     const QScreen *screen = findScreenByName(window, screenName);
 
     // Fall back to non-per-screen-arrangement info if it's available but
     // per-screen-arrangement information is not
     // TODO: Remove in KF6 or maybe even KF5.80 or something. It really only needs
     // to be here to transition existing users once they upgrade from 5.73 -> 5.74
-    const int fallbackWidth = config.readEntry(QStringLiteral("Width %1").arg(screen->geometry().width()), window->size().width());
-    const int fallbackHeight = config.readEntry(QStringLiteral("Height %1").arg(screen->geometry().height()), window->size().height());
-
-    const int width = config.readEntry(windowWidthString(screen), fallbackWidth);
-    const int height = config.readEntry(windowHeightString(screen), fallbackHeight);
-    const bool isMaximized = config.readEntry(configFileString(screen, QStringLiteral("Window-Maximized")), false);
+    const int width = saved.width ? *saved.width : config.readEntry(QStringLiteral("Width %1").arg(screen->geometry().width()), window->size().width());
+    const int height = saved.height ? *saved.height : config.readEntry(QStringLiteral("Height %1").arg(screen->geometry().height()), window->size().height());
+    const bool isMaximized = saved.maximized.value_or(false);
 
     // Check default size
     const QSize defaultSize(window->property(s_initialSizePropertyName).toSize());
@@ -192,9 +323,25 @@ void KWindowConfig::restoreWindowPosition(QWindow *window, const KConfigGroup &c
     if (!window || QGuiApplication::platformName() == QLatin1String{"wayland"}) {
         return;
     }
+    ::restoreWindowPosition(window, config, readSavedGeometry(config));
+}
 
+void KWindowConfig::restoreWindowGeometry(QWindow *window, const KConfigGroup &config)
+{
+    if (!window) {
+        return;
+    }
+    const SavedGeometry saved = readSavedGeometry(config);
+    ::restoreWindowSize(window, config, saved);
+    if (QGuiApplication::platformName() != QLatin1String{"wayland"}) {
+        ::restoreWindowPosition(window, config, saved);
+    }
+}
+
+static void restoreWindowPosition(QWindow *window, const KConfigGroup &config, const SavedGeometry &saved)
+{
     const QScreen *screen = window->screen();
-    const bool isMaximized = config.readEntry(configFileString(screen, QStringLiteral("Window-Maximized")), false);
+    const bool isMaximized = saved.maximized.value_or(false);
 
     // Don't need to restore position if the window was maximized
     if (isMaximized) {
@@ -203,27 +350,32 @@ void KWindowConfig::restoreWindowPosition(QWindow *window, const KConfigGroup &c
     }
 
     // Move window to proper screen
-    const QString screenName = config.readEntry(windowScreenPositionString(), screen->name());
+    const QString screenName = saved.screenName.value_or(screen->name());
     if (screenName != screen->name()) {
         QScreen *screenConf = findScreenByName(window, screenName);
         window->setScreen(screenConf);
-        restoreWindowScreenPosition(window, screenConf, config);
+        restoreWindowScreenPosition(window, screenConf, config, saved);
         return;
     }
-    restoreWindowScreenPosition(window, screen, config);
+    restoreWindowScreenPosition(window, screen, config, saved);
 }
 
 void KWindowConfig::restoreWindowScreenPosition(QWindow *window, const QScreen *screen, const KConfigGroup &config)
 {
+    ::restoreWindowScreenPosition(window, screen, config, readSavedGeometry(config));
+}
+
+static void restoreWindowScreenPosition(QWindow *window, const QScreen *screen, const KConfigGroup &config, const SavedGeometry &saved)
+{
+    Q_UNUSED(screen);
     const QRect desk = window->screen()->geometry();
     // Fall back to non-per-resolution info if it's available but
     // per-resolution information is not
     // TODO: Remove in KF6 or maybe even KF5.85 or something. It really only needs
     // to be here to transition existing users once they upgrade from 5.78 -> 5.79
-    const int fallbackXPosition = config.readEntry(QStringLiteral("%1 XPosition %2").arg(allConnectedScreens(), QString::number(desk.width())), -1);
-    const int fallbackYPosition = config.readEntry(QStringLiteral("%1 YPosition %2").arg(allConnectedScreens(), QString::number(desk.height())), -1);
-    const int xPos = config.readEntry(windowXPositionString(screen), fallbackXPosition);
-    const int yPos = config.readEntry(windowYPositionString(screen), fallbackYPosition);
+    const QString &screens = screenKeys().allConnectedScreens;
+    const int xPos = saved.xPosition ? *saved.xPosition : config.readEntry(QStringLiteral("%1 XPosition %2").arg(screens, QString::number(desk.width())), -1);
+    const int yPos = saved.yPosition ? *saved.yPosition : config.readEntry(QStringLiteral("%1 YPosition %2").arg(screens, QString::number(desk.height())), -1);
 
     if (xPos == -1 || yPos == -1) {
         return;
@@ -84,6 +84,21 @@ KCONFIGGUI_EXPORT void saveWindowPosition(const QWindow *window, KConfigGroup &c
  */
 KCONFIGGUI_EXPORT void restoreWindowPosition(QWindow *window, const KConfigGroup &config);
 
+/**
+ * Restores the window's size and position from the configuration, like
+ * restoreWindowSize() followed by restoreWindowPosition(), with one pass
+ * over the entries of the group instead of a lookup for each of them.
+ * Meant for restoring many windows at once, e.g. on session restore. The
+ * position is left alone on Wayland, as restoreWindowPosition() does.
+ *
+ * @note the group must be set before calling
+ *
+ * @param window The window whose size and position to restore.
+ * @param config The config group to read from.
+ * @since 6.1
+ */
+KCONFIGGUI_EXPORT void restoreWindowGeometry(QWindow *window, const KConfigGroup &config);
+
 /**
  * Restores the window's position on provided screen from the configuration.
  * This function has no effect on Wayland, where the compositor is responsible
@@ -7,33 +7,100 @@
 #include "ksharedconfig.h"
 #include "kwindowconfig.h"
 
+#include <QBasicTimer>
+#include <QCoreApplication>
+#include <QPointer>
+#include <QSet>
+#include <QTimerEvent>
 #include <QWindow>
 
+#include <utility>
+
 class KWindowStateSaverPrivate
 {
 public:
     QWindow *window = nullptr;
     KConfigGroup configGroup;
     std::function<QWindow *()> windowHandleCallback;
-    int timerId = 0;
 
     void init(KWindowStateSaver *q);
     void initWidget(QObject *widget, KWindowStateSaver *q);
+    void save();
 };
 
+namespace
+{
+// Writes the states of all the windows of the process that changed since the last
+// batch, once they stopped moving for a moment or the application quits, and syncs
+// each of the configs they went to once
+class WindowStateWriter : public QObject
+{
+public:
+    using QObject::QObject;
+
+    static WindowStateWriter *instance()
+    {
+        if (!s_writer) {
+            s_writer = new WindowStateWriter(QCoreApplication::instance());
+            QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, s_writer, &WindowStateWriter::flush);
+        }
+        return s_writer;
+    }
+
+    static QPointer<WindowStateWriter> s_writer;
+
+    void schedule(KWindowStateSaverPrivate *saver)
+    {
+        m_dirty.insert(saver);
+        m_timer.start(250, this);
+    }
+
+    void cancel(KWindowStateSaverPrivate *saver)
+    {
+        m_dirty.remove(saver);
+    }
+
+    void flush()
+    {
+        m_timer.stop();
+        QSet<KConfig *> configs;
+        for (KWindowStateSaverPrivate *saver : std::exchange(m_dirty, {})) {
+            saver->save();
+            configs.insert(saver->configGroup.config());
+        }
+        for (KConfig *config : std::as_const(configs)) {
+            config->sync();
+        }
+    }
+
+protected:
+    void timerEvent(QTimerEvent *event) override
+    {
+        if (event->timerId() == m_timer.timerId()) {
+            flush();
+        } else {
+            QObject::timerEvent(event);
+        }
+    }
+
+private:
+    QSet<KWindowStateSaverPrivate *> m_dirty;
+    QBasicTimer m_timer;
+};
+
+QPointer<WindowStateWriter> WindowStateWriter::s_writer;
+}
+
 void KWindowStateSaverPrivate::init(KWindowStateSaver *q)
 {
     if (!window) {
         return;
     }
 
-    KWindowConfig::restoreWindowSize(window, configGroup);
-    KWindowConfig::restoreWindowPosition(window, configGroup);
+    KWindowConfig::restoreWindowGeometry(window, configGroup);
 
-    const auto deferredSave = [q, this]() {
-        if (!timerId) {
-            timerId = q->startTimer(250);
-        }
+    const auto deferredSave = [this]() {
+        WindowStateWriter::instance()->schedule(this);
     };
     QObject::connect(window, &QWindow::widthChanged, q, deferredSave);
     QObject::connect(window, &QWindow::heightChanged, q, deferredSave);
@@ -41,6 +108,12 @@ void KWindowStateSaverPrivate::init(KWindowStateSaver *q)
     QObject::connect(window, &QWindow::yChanged, q, deferredSave);
 }
 
+void KWindowStateSaverPrivate::save()
+{
+    KWindowConfig::saveWindowPosition(window, configGroup);
+    KWindowConfig::saveWindowSize(window, configGroup);
+}
+
 void KWindowStateSaverPrivate::initWidget(QObject *widget, KWindowStateSaver *q)
 {
     if (!window && windowHandleCallback) {
@@ -85,15 +158,15 @@ KWindowStateSaver::KWindowStateSaver(QWindow *window, const char *configGroupNam
 
 KWindowStateSaver::~KWindowStateSaver()
 {
+    if (WindowStateWriter::s_writer) {
+        WindowStateWriter::s_writer->cancel(d);
+    }
     delete d;
 }
 
 void KWindowStateSaver::timerEvent(QTimerEvent *event)
 {
-    killTimer(event->timerId());
-    KWindowConfig::saveWindowPosition(d->window, d->configGroup);
-    KWindowConfig::saveWindowSize(d->window, d->configGroup);
-    d->timerId = 0;
+    QObject::timerEvent(event);
 }
 
 bool KWindowStateSaver::eventFilter(QObject *watched, QEvent *event)
@@ -13,6 +13,7 @@
 
 #include "KConfigCodeGeneratorBase.h"
 
+#include <QFile>
 #include <QFileInfo>
 #include <QLatin1Char>
 
@@ -32,12 +33,8 @@ KConfigCodeGeneratorBase::KConfigCodeGeneratorBase(const QString &inputFile,
     , m_fileName(fileName)
     , m_cfg(parameters)
 {
-    m_file.setFileName(m_fileName);
-    if (!m_file.open(QIODevice::WriteOnly)) {
-        std::cerr << "Can not open '" << qPrintable(m_fileName) << "for writing." << std::endl;
-        exit(1);
-    }
-    m_stream.setDevice(&m_file);
+    m_buffer.open(QIODevice::WriteOnly);
+    m_stream.setDevice(&m_buffer);
 
     if (m_cfg.staticAccessors) {
         m_this = QStringLiteral("self()->");
@@ -53,7 +50,22 @@ KConfigCodeGeneratorBase::~KConfigCodeGeneratorBase()
 
 void KConfigCodeGeneratorBase::save()
 {
-    m_file.close();
+    if (!m_buffer.isOpen()) {
+        return;
+    }
+    m_stream.flush();
+    m_buffer.close();
+
+    QFile file(m_fileName);
+    // leaving an unchanged file alone keeps what includes it from being rebuilt
+    if (m_cfg.writeIfChanged && file.open(QIODevice::ReadOnly) && file.readAll() == m_buffer.data()) {
+        return;
+    }
+    file.close();
+    if (!file.open(QIODevice::WriteOnly) || file.write(m_buffer.data()) != m_buffer.size() || !file.flush()) {
+        std::cerr << "Can not open '" << qPrintable(m_fileName) << "for writing." << std::endl;
+        exit(1);
+    }
 }
 
 // TODO: Remove this weird logic and adapt the testcases
@@ -173,34 +185,88 @@ QString KConfigCodeGeneratorBase::memberAccessorBody(const CfgEntry *e, bool glo
     return result;
 }
 
-void KConfigCodeGeneratorBase::memberImmutableBody(const CfgEntry *e, bool globalEnums)
+QString KConfigCodeGeneratorBase::itemNameExpression(const CfgEntry *e, bool globalEnums) const
 {
-    stream() << whitespace() << "return " << m_this << "isImmutable( QStringLiteral( \"";
+    QString result = QStringLiteral("QStringLiteral( \"");
     if (!e->param.isEmpty()) {
-        stream() << QString(e->paramName).replace(QLatin1String("$(%1)").arg(e->param), QLatin1String("%1")) << "\" ).arg( ";
+        result += QString(e->paramName).replace(QLatin1String("$(%1)").arg(e->param), QLatin1String("%1")) + QLatin1String("\" ).arg( ");
         if (e->paramType == QLatin1String("Enum")) {
-            stream() << "QLatin1String( ";
+            result += QLatin1String("QLatin1String( ");
 
             if (globalEnums) {
-                stream() << enumName(e->param) << "ToString[i]";
+                result += enumName(e->param) + QLatin1String("ToString[i]");
             } else {
-                stream() << enumName(e->param) << "::enumToString[i]";
+                result += enumName(e->param) + QLatin1String("::enumToString[i]");
             }
 
-            stream() << " )";
+            result += QLatin1String(" )");
         } else {
-            stream() << "i";
+            result += QLatin1Char('i');
         }
-        stream() << " )";
+        result += QLatin1String(" )");
     } else {
-        stream() << e->name << "\" )";
+        result += e->name + QLatin1String("\" )");
+    }
+    return result;
+}
+
+QStringList KConfigCodeGeneratorBase::lazyGroups() const
+{
+    QStringList groups;
+    for (const auto *entry : std::as_const(parseResult.entries)) {
+        if (!groups.contains(entry->group)) {
+            groups.append(entry->group);
+        }
+    }
+    return groups;
+}
+
+void KConfigCodeGeneratorBase::ensureItemsCall(const CfgEntry *e)
+{
+    if (!m_cfg.lazyGroups) {
+        return;
+    }
+    m_stream << whitespace() << m_this << "ensureItems( " << lazyGroups().indexOf(e->group) << " );\n";
+}
+
+QStringList KConfigCodeGeneratorBase::parameterizedGroups() const
+{
+    QStringList groups;
+    if (!m_cfg.staticItems) {
+        return groups;
+    }
+    for (const auto *entry : std::as_const(parseResult.entries)) {
+        if (entry->group.contains(QLatin1String("$(")) && !groups.contains(entry->group)) {
+            groups.append(entry->group);
+        }
+    }
+    return groups;
+}
+
+QString KConfigCodeGeneratorBase::groupNameExpression(const QString &group) const
+{
+    const qsizetype index = parameterizedGroups().indexOf(group);
+    if (index < 0) {
+        return paramString(group, parseResult.parameters);
     }
-    stream() << " );\n";
+    return QStringLiteral("groupName( %1 )").arg(index);
+}
+
+void KConfigCodeGeneratorBase::memberImmutableBody(const CfgEntry *e, bool globalEnums)
+{
+    ensureItemsCall(e);
+    if (m_cfg.staticItems) {
+        // there is no item that would know
+        stream() << whitespace() << "return KConfigGroup( " << m_this << "config(), " << groupNameExpression(e->group) << " ).isEntryImmutable( "
+                 << paramString(e->key, parseResult.parameters) << " );\n";
+        return;
+    }
+    stream() << whitespace() << "return " << m_this << "isImmutable( " << itemNameExpression(e, globalEnums) << " );\n";
 }
 
 void KConfigCodeGeneratorBase::createIfSetLogic(const CfgEntry *e, const QString &varExpression)
 {
-    const bool hasBody = !e->signalList.empty() || m_cfg.generateProperties;
+    const bool hasBody = !e->signalList.empty() || m_cfg.generateProperties || m_cfg.trackChanges;
 
     m_stream << whitespace() << "if (";
     if (hasBody) {
@@ -217,6 +283,7 @@ void KConfigCodeGeneratorBase::createIfSetLogic(const CfgEntry *e, const QString
 
 void KConfigCodeGeneratorBase::memberMutatorBody(const CfgEntry *e)
 {
+    ensureItemsCall(e);
     // HACK: Don't open '{' manually, use startScope / endScope to automatically handle whitespace indentation.
     if (!e->min.isEmpty()) {
         if (e->min != QLatin1String("0") || !isUnsigned(e->type)) { // skip writing "if uint<0" (#187579)
@@ -244,19 +311,22 @@ void KConfigCodeGeneratorBase::memberMutatorBody(const CfgEntry *e)
     const QString varExpression = m_this + varPath(e->name, m_cfg) + (e->param.isEmpty() ? QString{} : QStringLiteral("[i]"));
 
     // TODO: Remove this `hasBody` logic, always use an '{' for the if.
-    const bool hasBody = !e->signalList.empty() || m_cfg.generateProperties;
+    const bool hasBody = !e->signalList.empty() || m_cfg.generateProperties || m_cfg.trackChanges;
 
     // m_this call creates an `if (someTest ...) that's just to long to throw over the code.
     createIfSetLogic(e, varExpression);
     m_stream << (hasBody ? " {" : "") << '\n';
     m_stream << whitespace() << "  " << varExpression << " = v;\n";
+    if (m_cfg.trackChanges) {
+        m_stream << whitespace() << "  " << m_this << "markChanged( " << itemNameExpression(e, m_cfg.globalEnums) << " );\n";
+    }
 
     const auto listSignal = e->signalList;
     for (const Signal &signal : std::as_const(listSignal)) {
         if (signal.modify) {
             m_stream << whitespace() << "  Q_EMIT " << m_this << signal.name << "();\n";
         } else {
-            m_stream << whitespace() << "  " << m_this << varPath(QStringLiteral("settingsChanged"), m_cfg) << ".insert(" << signalEnumName(signal.name) << ");\n";
+            m_stream << whitespace() << "  " << m_this << varPath(QStringLiteral("settingsChanged"), m_cfg) << ".set(" << signalEnumName(signal.name) << ");\n";
         }
     }
     if (hasBody) {
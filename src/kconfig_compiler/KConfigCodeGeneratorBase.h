@@ -14,7 +14,7 @@
 #ifndef KCONFIGCODEGENERATORBASE_H
 #define KCONFIGCODEGENERATORBASE_H
 
-#include <QFile>
+#include <QBuffer>
 #include <QString>
 #include <QTextStream>
 #include <QVector>
@@ -63,7 +63,7 @@ public:
     // start writing to the output file
     virtual void start();
 
-    // save the result on the disk
+    // save the result on the disk, with writeIfChanged only if it differs from the file there
     void save();
 
     // Code Implementations
@@ -71,6 +71,9 @@ public:
     // TODO: write to the stream directly without returning a QString.
     QString memberAccessorBody(const CfgEntry *e, bool globalEnums) const;
 
+    // The name the item of the CfgEntry is added to the skeleton with, as an expression
+    QString itemNameExpression(const CfgEntry *e, bool globalEnums) const;
+
     // Implements the is<Param>Immutable for the CfgEntry
     void memberImmutableBody(const CfgEntry *e, bool globalEnums);
 
@@ -83,6 +86,16 @@ public:
     // what was happening in a bigger function.
     void createIfSetLogic(const CfgEntry *e, const QString &varExpression);
 
+    // With LazyGroups, the distinct groups of the entries, the items of each are created together
+    QStringList lazyGroups() const;
+    // With LazyGroups, makes sure the items of the group of the CfgEntry are created
+    void ensureItemsCall(const CfgEntry *e);
+
+    // With StaticItems, the distinct groups whose names have parameters, filled in once per instance
+    QStringList parameterizedGroups() const;
+    // The expression for the name of the group, with its parameters filled in
+    QString groupNameExpression(const QString &group) const;
+
 protected:
     /* advance the number of spaces for the indentation level */
     void indent();
@@ -136,7 +149,7 @@ private:
 
     KConfigParameters m_cfg; // The parameters passed via the kcfgc file
     QTextStream m_stream; // the stream that operates in the file to write data.
-    QFile m_file; // The file handler.
+    QBuffer m_buffer; // The generated code, written to the file by save().
 
     // Special access to `this->` and `const` thru the code.
     QString m_this;
@@ -139,6 +139,10 @@ QString immutableFunction(const QString &n, const QString &className = QString()
 
 QString itemAccessorBody(const CfgEntry *e, const KConfigParameters &cfg);
 QString signalEnumName(const QString &signalName);
+// the flag of an entry that emits several signals, itemChanged() emits each of them
+QString signalsOfEntryEnumName(const QString &entryName);
+// the type of the set of signals to emit on the next save, indexed by their enum values
+QString settingsChangedType(const QList<Signal> &signalList);
 
 bool isUnsigned(const QString &type);
 
@@ -182,7 +186,10 @@ QString paramString(const QString &s, const CfgEntry *e, int i);
 QString paramString(const QString &group, const QList<Param> &parameters);
 
 QString defaultValue(const QString &t);
+// the default of the entry as an expression of its C++ type, for StaticItems
+QString staticDefaultValue(const CfgEntry *e);
 QString memberGetDefaultBody(const CfgEntry *e);
+bool hasConstexprDefault(const CfgEntry *e);
 QString literalString(const QString &s);
 QString enumTypeQualifier(const QString &n, const CfgEntry::Choices &c);
 
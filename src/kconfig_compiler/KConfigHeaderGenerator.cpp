@@ -51,6 +51,7 @@ void KConfigHeaderGenerator::doClassDefinition()
     implementEnums();
     createConstructor();
     createDestructor();
+    createValuesStruct();
 
     for (const auto *entry : std::as_const(parseResult.entries)) {
         const QString returnType = (cfg().useEnumTypes && entry->type == QLatin1String("Enum")) ? enumType(entry, cfg().globalEnums) : cppType(entry->type);
@@ -72,6 +73,12 @@ void KConfigHeaderGenerator::doClassDefinition()
     if (parseResult.hasNonModifySignals) {
         stream() << whitespace() << "bool usrSave() override;\n";
     }
+    if (cfg().staticItems) {
+        stream() << whitespace() << "void usrRead() override;\n";
+        stream() << whitespace() << "bool usrSave() override;\n";
+        stream() << whitespace() << "void usrSetDefaults() override;\n";
+        stream() << whitespace() << "bool usrUseDefaults(bool b) override;\n";
+    }
 
     // Member variables
     if (!cfg().memberVariables.isEmpty() //
@@ -115,7 +122,7 @@ void KConfigHeaderGenerator::createHeaders()
 
     addHeaders({QStringLiteral("QCoreApplication"), QStringLiteral("QDebug")});
     if (!cfg().dpointer && parseResult.hasNonModifySignals) {
-        addHeaders({QStringLiteral("QSet")});
+        addHeaders({QStringLiteral("bitset")});
     }
     stream() << '\n';
 
@@ -230,9 +237,19 @@ void KConfigHeaderGenerator::createSignals()
     // just to make the source generated code equal to the old one.
     // When we are sure, revert this to a range-based-for and just add
     // a last comma, as it's valid c++.
+    QStringList enumValues;
     for (int i = 0, end = parseResult.signalList.size(); i < end; i++) {
         auto signal = parseResult.signalList.at(i);
-        stream() << whitespace() << "  " << signalEnumName(signal.name) << " = " << (i + 1);
+        enumValues.append(signalEnumName(signal.name) + QLatin1String(" = ") + QString::number(i + 1));
+    }
+    // after the signals, so that the set of signals to emit can be indexed by them
+    for (const auto *entry : std::as_const(parseResult.entries)) {
+        if (entry->signalList.size() > 1) {
+            enumValues.append(signalsOfEntryEnumName(entry->name) + QLatin1String(" = ") + QString::number(enumValues.size() + 1));
+        }
+    }
+    for (int i = 0, end = enumValues.size(); i < end; i++) {
+        stream() << whitespace() << "  " << enumValues.at(i);
         if (i != end - 1) {
             stream() << ",\n";
         }
@@ -286,7 +303,7 @@ void KConfigHeaderGenerator::createDPointer()
     // use a private class for both member variables and items
     stream() << "  private:\n";
     for (const auto *entry : std::as_const(parseResult.entries)) {
-        if (cfg().allDefaultGetters || cfg().defaultGetters.contains(entry->name)) {
+        if ((cfg().allDefaultGetters || cfg().defaultGetters.contains(entry->name)) && !hasConstexprDefault(entry)) {
             stream() << whitespace() << "";
             if (cfg().staticAccessors) {
                 stream() << "static ";
@@ -456,6 +473,7 @@ void KConfigHeaderGenerator::createGetters(const CfgEntry *entry, const QString
     if (!cfg().dpointer) {
         stream() << '\n';
         startScope();
+        ensureItemsCall(entry);
         stream() << whitespace() << memberAccessorBody(entry, cfg().globalEnums);
         endScope();
         stream() << '\n';
@@ -532,6 +550,25 @@ void KConfigHeaderGenerator::createDefaultValueMember(const CfgEntry *entry)
     stream() << whitespace() << "/**\n";
     stream() << whitespace() << "  Get " << entry->label << " default value\n";
     stream() << whitespace() << "*/\n";
+
+    const bool useEnumType = cfg().useEnumTypes && entry->type == QLatin1String("Enum");
+    if (hasConstexprDefault(entry)) {
+        // a literal, no need for the helper
+        stream() << whitespace() << "static constexpr " << (useEnumType ? enumType(entry, cfg().globalEnums) : cppType(entry->type)) << " "
+                 << getDefaultFunction(entry->name) << "()\n";
+        stream() << whitespace() << "{\n";
+        stream() << whitespace() << "    return ";
+        if (useEnumType) {
+            stream() << "static_cast<" << enumType(entry, cfg().globalEnums) << ">(" << entry->defaultValue << ")";
+        } else {
+            stream() << entry->defaultValue;
+        }
+        stream() << ";\n";
+        stream() << whitespace() << "}\n";
+        stream() << '\n';
+        return;
+    }
+
     if (cfg().staticAccessors) {
         stream() << whitespace() << "static\n";
     }
@@ -591,6 +628,11 @@ void KConfigHeaderGenerator::createNonDPointerHelpers()
         return;
     }
 
+    if (cfg().staticItems) {
+        createStaticValues();
+        return;
+    }
+
     QString group;
     for (const auto *entry : std::as_const(parseResult.entries)) {
         if (entry->group != group) {
@@ -604,7 +646,7 @@ void KConfigHeaderGenerator::createNonDPointerHelpers()
         }
         stream() << ";\n";
 
-        if (cfg().allDefaultGetters || cfg().defaultGetters.contains(entry->name)) {
+        if ((cfg().allDefaultGetters || cfg().defaultGetters.contains(entry->name)) && !hasConstexprDefault(entry)) {
             stream() << whitespace() << "";
             if (cfg().staticAccessors) {
                 stream() << "static ";
@@ -631,6 +673,84 @@ void KConfigHeaderGenerator::createNonDPointerHelpers()
     }
 
     if (parseResult.hasNonModifySignals) {
-        stream() << whitespace() << "QSet<quint64> " << varName(QStringLiteral("settingsChanged"), cfg()) << ";\n";
+        stream() << whitespace() << settingsChangedType(parseResult.signalList) << " " << varName(QStringLiteral("settingsChanged"), cfg()) << ";\n";
+    }
+
+    if (cfg().lazyGroups) {
+        stream() << whitespace() << "// creates the items of a group the first time it is used\n";
+        stream() << whitespace() << "void ensureItems(int group) const\n";
+        startScope();
+        stream() << whitespace() << "if (!mItemsCreated[group]) {\n";
+        stream() << whitespace() << "  const_cast<" << cfg().className << " *>(this)->createItems(group);\n";
+        stream() << whitespace() << "}\n";
+        endScope();
+        stream() << whitespace() << "void createItems(int group);\n";
+        stream() << whitespace() << "bool mItemsCreated[" << lazyGroups().size() << "] = {};\n";
+    }
+}
+
+void KConfigHeaderGenerator::createValuesStruct()
+{
+    if (!cfg().staticItems && !cfg().generateValues) {
+        return;
+    }
+
+    // all the values in one struct, with StaticItems the defaults and the loaded values are copies of it
+    stream() << whitespace() << "struct Values\n";
+    startScope();
+    QString group;
+    for (const auto *entry : std::as_const(parseResult.entries)) {
+        if (entry->group != group) {
+            group = entry->group;
+            stream() << whitespace() << "// " << group << '\n';
+        }
+        stream() << whitespace() << cppType(entry->type) << " " << varName(entry->name, cfg());
+        if (!entry->param.isEmpty()) {
+            stream() << QStringLiteral("[%1]").arg(entry->paramMax + 1);
+        }
+        stream() << ";\n";
+    }
+    endScope(ScopeFinalizer::Semicolon);
+    stream() << '\n';
+
+    if (cfg().generateValues) {
+        stream() << whitespace() << "/**\n";
+        stream() << whitespace() << "  Get a copy of all the values, which can be kept or passed to another thread\n";
+        stream() << whitespace() << "*/\n";
+        if (cfg().staticAccessors) {
+            stream() << whitespace() << "static\n";
+        }
+        stream() << whitespace() << "Values values()" << Const() << ";\n\n";
+    }
+}
+
+void KConfigHeaderGenerator::createStaticValues()
+{
+    stream() << '\n';
+    stream() << whitespace() << "Values mValues;\n";
+
+    for (const auto *entry : std::as_const(parseResult.entries)) {
+        if ((cfg().allDefaultGetters || cfg().defaultGetters.contains(entry->name)) && !hasConstexprDefault(entry)) {
+            stream() << whitespace() << "";
+            if (cfg().staticAccessors) {
+                stream() << "static ";
+            }
+            stream() << cppType(entry->type) << " " << getDefaultFunction(entry->name) << "_helper()" << Const() << ";\n";
+        }
+    }
+
+    stream() << "\n  private:\n";
+    stream() << whitespace() << "Values mDefaults;\n";
+    stream() << whitespace() << "Values mLoaded;\n";
+    stream() << whitespace() << "void readValues(Values &values, const Values *fallback);\n";
+
+    const qsizetype parameterizedGroupCount = parameterizedGroups().size();
+    if (parameterizedGroupCount > 0) {
+        stream() << whitespace() << "// the names of the groups with parameters, filled in the first time they are used
+";
+        stream() << whitespace() << "QString groupName(int group) const;
+";
+        stream() << whitespace() << "mutable QString mGroupNames[" << parameterizedGroupCount << "];
+";
     }
 }
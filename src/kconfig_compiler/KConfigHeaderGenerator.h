@@ -44,6 +44,8 @@ private:
     void createHeaders();
     void createDPointer();
     void createNonDPointerHelpers();
+    void createStaticValues();
+    void createValuesStruct();
 
     void createConstructor();
     void createDestructor();
@@ -66,6 +66,10 @@ KConfigParameters::KConfigParameters(const QString &codegenFilename)
     useEnumTypes = codegenConfig.value(QStringLiteral("UseEnumTypes"), false).toBool();
     const QString trString = codegenConfig.value(QStringLiteral("TranslationSystem")).toString().toLower();
     generateProperties = codegenConfig.value(QStringLiteral("GenerateProperties"), false).toBool();
+    trackChanges = codegenConfig.value(QStringLiteral("TrackChanges"), false).toBool();
+    staticItems = codegenConfig.value(QStringLiteral("StaticItems"), false).toBool();
+    lazyGroups = codegenConfig.value(QStringLiteral("LazyGroups"), false).toBool();
+    generateValues = codegenConfig.value(QStringLiteral("GenerateValues"), false).toBool();
     if (trString == QLatin1String("kde")) {
         translationSystem = KdeTranslation;
         translationDomain = codegenConfig.value(QStringLiteral("TranslationDomain")).toString();
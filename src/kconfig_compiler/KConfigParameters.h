@@ -62,7 +62,14 @@ public:
     TranslationSystem translationSystem;
     QString translationDomain;
     bool generateProperties;
+    bool trackChanges;
+    bool staticItems; // values in one struct, read and written by generated code instead of items
+    bool lazyGroups; // the items of a group are only created once it is used
+    bool generateValues; // values() returns a copy of all the values in a plain struct
     QString baseName;
+
+    // Set by --batch: the generated files are only written if they changed
+    bool writeIfChanged = false;
 };
 
 #endif
@@ -15,6 +15,8 @@
 
 #include <QRegularExpression>
 
+#include <algorithm>
+
 KConfigSourceGenerator::KConfigSourceGenerator(const QString &inputFile, const QString &baseDir, const KConfigParameters &cfg, ParseResult &parseResult)
     : KConfigCodeGeneratorBase(inputFile, baseDir, baseDir + cfg.baseName + QLatin1Char('.') + cfg.sourceExtension, cfg, parseResult)
 {
@@ -35,6 +37,8 @@ void KConfigSourceGenerator::start()
     createSingletonImplementation();
     createPreamble();
     doConstructor();
+    doStaticItems();
+    createValuesFunction();
     doGetterSetterDPointerMode();
     createDefaultValueGetterSetter();
     createDestructor();
@@ -74,7 +78,11 @@ void KConfigSourceGenerator::createHeaders()
     }
 
     if (cfg().dpointer && parseResult.hasNonModifySignals) {
-        addHeaders({QStringLiteral("QSet")});
+        addHeaders({QStringLiteral("bitset")});
+    }
+
+    if (cfg().staticItems) {
+        addHeaders({QStringLiteral("kconfiggroupsnapshot.h")});
     }
 
     if (cfg().singleton) {
@@ -123,7 +131,7 @@ void KConfigSourceGenerator::createPrivateDPointerImplementation()
     }
 
     if (parseResult.hasNonModifySignals) {
-        stream() << "    QSet<quint64> " << varName(QStringLiteral("settingsChanged"), cfg()) << ";\n";
+        stream() << "    " << settingsChangedType(parseResult.signalList) << " " << varName(QStringLiteral("settingsChanged"), cfg()) << ";\n";
     }
 
     stream() << "};\n\n";
@@ -399,12 +407,11 @@ void KConfigSourceGenerator::handleCurrentGroupChange(const CfgEntry *entry)
     }
 
     // HACK: This fixes one spacing line in the diff. Remove this in the future and adapt the testcases.
-    static bool first = true;
     if (!entry->group.isEmpty()) {
-        if (!first) {
+        if (!mFirstGroup) {
             stream() << '\n';
         }
-        first = false;
+        mFirstGroup = false;
     }
 
     mCurrentGroup = entry->group;
@@ -454,6 +461,26 @@ void KConfigSourceGenerator::doConstructor()
         stream() << "  s_global" << cfg().className << "()->q = this;\n";
     }
 
+    if (cfg().staticItems) {
+        createStaticItemsConstructor();
+        stream() << "}\n\n";
+        return;
+    }
+
+    if (cfg().lazyGroups) {
+        stream() << "  setCreateItemsImpl([this] {\n";
+        stream() << "    for (int group = 0; group < " << lazyGroups().size() << "; ++group) {\n";
+        stream() << "      ensureItems(group);\n";
+        stream() << "    }\n";
+        stream() << "  });\n";
+        if (cfg().trackChanges) {
+            stream() << "  setTrackChanges(true);\n";
+        }
+        stream() << "}\n\n";
+        createLazyItems();
+        return;
+    }
+
     if (!parseResult.signalList.isEmpty()) {
         // this cast to base-class pointer-to-member is valid C++
         // https://stackoverflow.com/questions/4272909/is-it-safe-to-upcast-a-method-pointer-and-use-it-with-base-class-pointer/
@@ -481,6 +508,285 @@ void KConfigSourceGenerator::doConstructor()
         }
     }
 
+    if (cfg().trackChanges) {
+        stream() << "  setTrackChanges(true);\n";
+    }
+
+    stream() << "}\n\n";
+}
+
+void KConfigSourceGenerator::createLazyItems()
+{
+    stream() << "void " << cfg().className << "::createItems(int group)\n";
+    stream() << "{\n";
+    stream() << "  mItemsCreated[group] = true;\n";
+    if (!parseResult.signalList.isEmpty()) {
+        stream() << "  KConfigCompilerSignallingItem::NotifyFunction notifyFunction ="
+                 << " static_cast<KConfigCompilerSignallingItem::NotifyFunction>(&" << cfg().className << "::itemChanged);\n";
+    }
+    stream() << "  switch (group) {\n";
+
+    const QStringList groups = lazyGroups();
+    for (int i = 0; i < groups.size(); ++i) {
+        stream() << "  case " << i << ": {\n";
+        stream() << "  setCurrentGroup( " << paramString(groups.at(i), parseResult.parameters) << " );\n";
+        for (const auto *entry : std::as_const(parseResult.entries)) {
+            if (entry->group != groups.at(i)) {
+                continue;
+            }
+            const QString key = paramString(entry->key, parseResult.parameters);
+            if (!entry->code.isEmpty()) {
+                stream() << entry->code << '\n';
+            }
+            createEnums(entry);
+
+            stream() << itemDeclaration(entry, cfg());
+
+            if (entry->param.isEmpty()) {
+                createNormalEntry(entry, key);
+            } else {
+                createIndexedEntry(entry, key);
+            }
+        }
+        stream() << "  break;\n";
+        stream() << "  }\n";
+    }
+    stream() << "  }\n";
+    stream() << "}\n\n";
+}
+
+void KConfigSourceGenerator::createStaticItemsConstructor()
+{
+    stream() << "  config()->setReadDefaults(true);\n";
+    stream() << "  readValues(mDefaults, nullptr);\n";
+    stream() << "  config()->setReadDefaults(false);\n";
+    stream() << "  readValues(mValues, &mDefaults);\n";
+    stream() << "  mLoaded = mValues;\n";
+
+    if (parseResult.entries.isEmpty()) {
+        return;
+    }
+
+    // isDefaults() and isSaveNeeded() of the base class only know about items
+    const auto compareValues = [this](const char *other, const char *op, const char *join) {
+        for (auto it = parseResult.entries.cbegin(); it != parseResult.entries.cend(); ++it) {
+            const QString var = varName((*it)->name, cfg());
+            if (it == parseResult.entries.cbegin()) {
+                stream() << "    return ";
+            } else {
+                stream() << "\n        " << join << " ";
+            }
+            stream() << "mValues." << var << " " << op << " " << other << "." << var;
+        }
+        stream() << ";\n";
+    };
+    stream() << '\n';
+    stream() << "  setIsDefaultsImpl([this] {\n";
+    compareValues("mDefaults", "==", "&&");
+    stream() << "  });\n";
+    stream() << "  setIsSaveNeededImpl([this] {\n";
+    compareValues("mLoaded", "!=", "||");
+    stream() << "  });\n";
+}
+
+void KConfigSourceGenerator::createStaticGroupBlocks(const std::function<void(const CfgEntry *entry, const QString &key)> &entryCode,
+                                                     const std::function<void(const QList<const CfgEntry *> &entries)> &groupCode)
+{
+    // Runs of entries of the same group share one KConfigGroup
+    QList<QList<const CfgEntry *>> runs;
+    for (const auto *entry : std::as_const(parseResult.entries)) {
+        if (runs.isEmpty() || runs.constLast().constFirst()->group != entry->group) {
+            runs.append({});
+        }
+        runs.last().append(entry);
+    }
+
+    for (const auto &run : std::as_const(runs)) {
+        stream() << "  {\n";
+        stream() << "    KConfigGroup cg(config(), " << groupNameExpression(run.constFirst()->group) << ");\n";
+        if (groupCode) {
+            groupCode(run);
+        }
+        for (const auto *entry : run) {
+            entryCode(entry, paramString(entry->key, parseResult.parameters));
+        }
+        stream() << "  }\n";
+    }
+}
+
+// The reader of KConfigGroupSnapshot for the type of entry, or an empty string if it must be
+// read from the KConfigGroup. The snapshot only takes plain keys, without parameters.
+static QString snapshotReader(const CfgEntry *entry)
+{
+    if (entry->key.contains(QLatin1String("$("))) {
+        return QString();
+    }
+    for (const QChar c : entry->key) {
+        if (c.unicode() < 0x20 || c.unicode() > 0x7e || c == QLatin1Char('"') || c == QLatin1Char('\\')) {
+            return QString();
+        }
+    }
+
+    static const QHash<QString, QString> readers = {
+        {QStringLiteral("String"), QStringLiteral("readEntry")},
+        {QStringLiteral("StringList"), QStringLiteral("readEntry")},
+        {QStringLiteral("Bool"), QStringLiteral("readBoolEntry")},
+        {QStringLiteral("Int"), QStringLiteral("readIntEntry")},
+        {QStringLiteral("LongLong"), QStringLiteral("readInt64Entry")},
+        {QStringLiteral("Double"), QStringLiteral("readDoubleEntry")},
+    };
+    return readers.value(entry->type);
+}
+
+void KConfigSourceGenerator::doStaticItems()
+{
+    if (!cfg().staticItems) {
+        return;
+    }
+
+    const auto isPath = [](const CfgEntry *entry) {
+        return entry->type == QLatin1String("Path") || entry->type == QLatin1String("PathList");
+    };
+
+    // Reads all the values of a group with one KConfigGroup, falling back to the values of
+    // fallback, or to the defaults given in the kcfg file when reading the defaults
+    stream() << "void " << cfg().className << "::readValues(Values &values, const Values *fallback)\n";
+    stream() << "{\n";
+    // Most of the entries are looked up in one snapshot of their group, which spares a lookup
+    // of the group and a conversion through QVariant for each of them
+    const auto readSnapshot = [this](const QList<const CfgEntry *> &entries) {
+        if (std::any_of(entries.cbegin(), entries.cend(), [](const CfgEntry *entry) {
+                return !snapshotReader(entry).isEmpty();
+            })) {
+            stream() << "    const KConfigGroupSnapshot snapshot = cg.snapshot();\n";
+        }
+    };
+    const auto readEntry = [this, &isPath](const CfgEntry *entry, const QString &key) {
+        const QString var = varName(entry->name, cfg());
+        if (!entry->code.isEmpty()) {
+            stream() << entry->code << '\n';
+        }
+        const QString reader = snapshotReader(entry);
+        if (!reader.isEmpty()) {
+            stream() << "    values." << var << " = snapshot." << reader << "(\"" << entry->key << "\", fallback ? fallback->" << var << " : "
+                     << staticDefaultValue(entry) << ");\n";
+        } else {
+            stream() << "    values." << var << " = cg." << (isPath(entry) ? "readPathEntry" : "readEntry") << "(" << key << ", fallback ? fallback->" << var
+                     << " : " << staticDefaultValue(entry) << ");\n";
+        }
+        if (!entry->min.isEmpty()) {
+            stream() << "    values." << var << " = qMax<" << cppType(entry->type) << ">(values." << var << ", " << entry->min << ");\n";
+        }
+        if (!entry->max.isEmpty()) {
+            stream() << "    values." << var << " = qMin<" << cppType(entry->type) << ">(values." << var << ", " << entry->max << ");\n";
+        }
+    };
+    createStaticGroupBlocks(readEntry, readSnapshot);
+    stream() << "}\n\n";
+
+    stream() << "void " << cfg().className << "::usrRead()\n";
+    stream() << "{\n";
+    stream() << "  readValues(mValues, &mDefaults);\n";
+    stream() << "  mLoaded = mValues;\n";
+    stream() << "  " << cfg().inherits << "::usrRead();\n";
+    stream() << "}\n\n";
+
+    // Only writes what changed since it was read, like the items do
+    stream() << "bool " << cfg().className << "::usrSave()\n";
+    stream() << "{\n";
+    createStaticGroupBlocks([this, &isPath](const CfgEntry *entry, const QString &key) {
+        const QString var = varName(entry->name, cfg());
+        const char *flags = (cfg().allNotifiers || cfg().notifiers.contains(entry->name)) ? "KConfigBase::Notify" : "KConfigBase::Normal";
+        stream() << "    if (mValues." << var << " != mLoaded." << var << ") {\n";
+        stream() << "      if (mValues." << var << " == mDefaults." << var << " && !cg.hasDefault(" << key << ")) {\n";
+        stream() << "        cg.revertToDefault(" << key << ", " << flags << ");\n";
+        stream() << "      } else {\n";
+        stream() << "        cg." << (isPath(entry) ? "writePathEntry" : "writeEntry") << "(" << key << ", mValues." << var << ", " << flags << ");\n";
+        stream() << "      }\n";
+        stream() << "    }\n";
+    });
+    stream() << "  mLoaded = mValues;\n";
+    stream() << "  return " << cfg().inherits << "::usrSave();\n";
+    stream() << "}\n\n";
+
+    stream() << "void " << cfg().className << "::usrSetDefaults()\n";
+    stream() << "{\n";
+    stream() << "  mValues = mDefaults;\n";
+    stream() << "  " << cfg().inherits << "::usrSetDefaults();\n";
+    stream() << "}\n\n";
+
+    stream() << "bool " << cfg().className << "::usrUseDefaults(bool b)\n";
+    stream() << "{\n";
+    stream() << "  std::swap(mValues, mDefaults);\n";
+    stream() << "  return " << cfg().inherits << "::usrUseDefaults(b);\n";
+    stream() << "}\n\n";
+
+    // The parameters of an instance don't change, so each name is only formatted the first
+    // time it is used and not on every read(), save() or immutability check
+    const QStringList groups = parameterizedGroups();
+    if (!groups.isEmpty()) {
+        stream() << "QString " << cfg().className << "::groupName(int group) const
+";
+        stream() << "{
+";
+        stream() << "  QString &name = mGroupNames[group];
+";
+        stream() << "  if (name.isNull()) {
+";
+        stream() << "    switch (group) {
+";
+        for (int i = 0; i < groups.size(); ++i) {
+            stream() << "    case " << i << ":
+";
+            stream() << "      name = " << paramString(groups.at(i), parseResult.parameters) << ";
+";
+            stream() << "      break;
+";
+        }
+        stream() << "    }
+";
+        stream() << "  }
+";
+        stream() << "  return name;
+";
+        stream() << "}
+
+";
+    }
+}
+
+void KConfigSourceGenerator::createValuesFunction()
+{
+    if (!cfg().generateValues) {
+        return;
+    }
+
+    stream() << cfg().className << "::Values " << cfg().className << "::values()" << Const() << '\n';
+    stream() << "{\n";
+    if (cfg().staticItems) {
+        stream() << "  return " << This() << "mValues;\n";
+        stream() << "}\n\n";
+        return;
+    }
+
+    if (cfg().lazyGroups) {
+        stream() << "  for (int group = 0; group < " << lazyGroups().size() << "; ++group) {\n";
+        stream() << "    " << This() << "ensureItems(group);\n";
+        stream() << "  }\n";
+    }
+    stream() << "  Values values;\n";
+    for (const auto *entry : std::as_const(parseResult.entries)) {
+        const QString var = varName(entry->name, cfg());
+        const QString path = This() + varPath(entry->name, cfg());
+        if (entry->param.isEmpty()) {
+            stream() << "  values." << var << " = " << path << ";\n";
+        } else {
+            stream() << "  for (int i = 0; i < " << entry->paramMax + 1 << "; ++i) {\n";
+            stream() << "    values." << var << "[i] = " << path << "[i];\n";
+            stream() << "  }\n";
+        }
+    }
+    stream() << "  return values;\n";
     stream() << "}\n\n";
 }
 
@@ -591,7 +897,7 @@ void KConfigSourceGenerator::createDefaultValueGetterSetter()
         QString t = entry->type;
 
         // Default value Accessor, as "helper" function
-        if ((cfg().allDefaultGetters || cfg().defaultGetters.contains(n)) && !entry->defaultValue.isEmpty()) {
+        if ((cfg().allDefaultGetters || cfg().defaultGetters.contains(n)) && !entry->defaultValue.isEmpty() && !hasConstexprDefault(entry)) {
             stream() << cppType(t) << " " << getDefaultFunction(n, cfg().className) << "_helper(";
             if (!entry->param.isEmpty()) {
                 stream() << " " << cppType(entry->paramType) << " i ";
@@ -631,13 +937,14 @@ void KConfigSourceGenerator::createNonModifyingSignalsHelper()
              << "usrSave()\n";
     startScope();
     stream() << "  const bool res = " << cfg().inherits << "::usrSave();\n";
-    stream() << "  if (!res) return false;\n\n";
+    stream() << "  if (!res) return false;\n";
+    stream() << "  if (" << varPath(QStringLiteral("settingsChanged"), cfg()) << ".none()) return true;\n\n";
     for (const Signal &signal : std::as_const(parseResult.signalList)) {
         if (signal.modify) {
             continue;
         }
 
-        stream() << "  if (" << varPath(QStringLiteral("settingsChanged"), cfg()) << ".contains(" << signalEnumName(signal.name) << "))\n";
+        stream() << "  if (" << varPath(QStringLiteral("settingsChanged"), cfg()) << ".test(" << signalEnumName(signal.name) << "))\n";
         stream() << "    Q_EMIT " << signal.name << "(";
         auto it = signal.arguments.cbegin();
         const auto itEnd = signal.arguments.cend();
@@ -665,7 +972,7 @@ void KConfigSourceGenerator::createNonModifyingSignalsHelper()
         stream() << ");\n";
     }
 
-    stream() << "  " << varPath(QStringLiteral("settingsChanged"), cfg()) << ".clear();\n";
+    stream() << "  " << varPath(QStringLiteral("settingsChanged"), cfg()) << ".reset();\n";
     stream() << "  return true;\n";
     endScope();
 }
@@ -679,8 +986,28 @@ void KConfigSourceGenerator::createSignalFlagsHandler()
     stream() << '\n';
     stream() << "void " << cfg().className << "::"
              << "itemChanged(quint64 signalFlag) {\n";
+
+    bool multipleSignalsWritten = false;
+    for (const auto *entry : std::as_const(parseResult.entries)) {
+        if (entry->signalList.size() < 2) {
+            continue;
+        }
+        if (!multipleSignalsWritten) {
+            stream() << "  switch (signalFlag) {\n";
+            multipleSignalsWritten = true;
+        }
+        stream() << "  case " << signalsOfEntryEnumName(entry->name) << ":\n";
+        for (const Signal &signal : std::as_const(entry->signalList)) {
+            stream() << "    itemChanged(" << signalEnumName(signal.name) << ");\n";
+        }
+        stream() << "    return;\n";
+    }
+    if (multipleSignalsWritten) {
+        stream() << "  }\n";
+    }
+
     if (parseResult.hasNonModifySignals) {
-        stream() << "  " << varPath(QStringLiteral("settingsChanged"), cfg()) << ".insert(signalFlag);\n";
+        stream() << "  " << varPath(QStringLiteral("settingsChanged"), cfg()) << ".set(signalFlag);\n";
     }
 
     if (!parseResult.signalList.isEmpty()) {
@@ -20,6 +20,8 @@
 #include <QList>
 #include <QString>
 
+#include <functional>
+
 class KConfigParameters;
 class CfgEntry;
 class QTextStream;
@@ -57,6 +59,18 @@ private:
     void createIndexedEntry(const CfgEntry *entry, const QString &key);
     void handleCurrentGroupChange(const CfgEntry *entry);
 
+    // LazyGroups=true, the items are created by createItems() instead of the constructor
+    void createLazyItems();
+
+    // StaticItems=true, code working on the values instead of items
+    void createStaticItemsConstructor();
+    void doStaticItems();
+
+    // GenerateValues=true, copies the values to the struct
+    void createValuesFunction();
+    void createStaticGroupBlocks(const std::function<void(const CfgEntry *entry, const QString &key)> &entryCode,
+                                 const std::function<void(const QList<const CfgEntry *> &entries)> &groupCode = {});
+
     void doGetterSetterDPointerMode();
     void createGetterDPointerMode(const CfgEntry *entry);
     void createImmutableGetterDPointerMode(const CfgEntry *entry);
@@ -65,6 +79,7 @@ private:
 
 private:
     QString mCurrentGroup;
+    bool mFirstGroup = true;
     QStringList mConfigGroupList; // keeps track of generated KConfigGroup;
 };
 
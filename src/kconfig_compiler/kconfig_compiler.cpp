@@ -20,8 +20,10 @@
 #include <QSettings>
 #include <QStringList>
 #include <QTextStream>
+#include <QThreadPool>
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <ostream>
 #include <stdlib.h>
@@ -51,6 +53,8 @@ QString varPath(const QString &n, const KConfigParameters &cfg)
     QString result;
     if (cfg.dpointer) {
         result = QLatin1String{"d->"} + varName(n, cfg);
+    } else if (cfg.staticItems) {
+        result = QLatin1String{"mValues."} + varName(n, cfg);
     } else {
         result = varName(n, cfg);
     }
@@ -184,6 +188,19 @@ QString literalString(const QString &str)
     }
 }
 
+QString signalsOfEntryEnumName(const QString &entryName)
+{
+    QString result = QLatin1String("signalsOf") + entryName;
+    result[9] = result.at(9).toUpper();
+    return result;
+}
+
+QString settingsChangedType(const QList<Signal> &signalList)
+{
+    // the enum values start at 1
+    return QLatin1String("std::bitset<%1>").arg(signalList.size() + 1);
+}
+
 QString signalEnumName(const QString &signalName)
 {
     QString result;
@@ -357,6 +374,19 @@ QString defaultValue(const QString &t)
     }
 }
 
+QString staticDefaultValue(const CfgEntry *e)
+{
+    if (!e->defaultValue.isEmpty()) {
+        return cppType(e->type) + QLatin1Char('(') + e->defaultValue + QLatin1Char(')');
+    }
+    // like the items, but an empty string can't be written as a plain literal
+    const QString t = e->type.toLower();
+    if (t == QLatin1String("string") || t == QLatin1String("path")) {
+        return QStringLiteral("QString()");
+    }
+    return cppType(e->type) + QLatin1Char('(') + defaultValue(e->type) + QLatin1Char(')');
+}
+
 QString itemType(const QString &type)
 {
     if (type.isEmpty()) {
@@ -459,14 +489,8 @@ QString newItem(const CfgEntry *entry, const QString &key, const QString &defaul
 
     QString str;
     str += QLatin1String("new KConfigCompilerSignallingItem(%1, this, notifyFunction, ").arg(innerItemVar(entry, cfg) + param);
-    // Append the signal flags
-    const int listSize = sigs.size();
-    for (int i = 0; i < listSize; ++i) {
-        if (i != 0) {
-            str += QLatin1String(" | ");
-        }
-        str += signalEnumName(sigs[i].name);
-    }
+    // the flags are the indexes of the signals, more than one don't fit into a single flag
+    str += sigs.size() == 1 ? signalEnumName(sigs.constFirst().name) : signalsOfEntryEnumName(entry->name);
     str += QLatin1String(");");
 
     return str;
@@ -619,6 +643,37 @@ QString memberGetDefaultBody(const CfgEntry *e)
     return result;
 }
 
+// whether the default of the entry is a literal its default value getter can
+// return as a compile-time constant, instead of calling a helper running e->code
+bool hasConstexprDefault(const CfgEntry *e)
+{
+    if (!e->param.isEmpty() || e->defaultValue.isEmpty()) {
+        return false;
+    }
+
+    const QString &value = e->defaultValue;
+    if (e->type == QLatin1String("Bool")) {
+        return value == QLatin1String("true") || value == QLatin1String("false");
+    }
+    if (e->type == QLatin1String("Int") || e->type == QLatin1String("UInt") || e->type == QLatin1String("LongLong")
+        || e->type == QLatin1String("ULongLong")) {
+        static const QRegularExpression integerRe(QRegularExpression::anchoredPattern(QStringLiteral("-?\\d+[uUlL]*")));
+        return integerRe.match(value).hasMatch();
+    }
+    if (e->type == QLatin1String("Double")) {
+        static const QRegularExpression doubleRe(QRegularExpression::anchoredPattern(QStringLiteral("-?\\d*\\.?\\d+([eE][-+]?\\d+)?")));
+        return doubleRe.match(value).hasMatch();
+    }
+    if (e->type == QLatin1String("Enum")) {
+        // one of the choices, as preProcessDefault() qualified it
+        return std::any_of(e->choices.choices.cbegin(), e->choices.choices.cend(), [&](const CfgEntry::Choice &choice) {
+            const QString enumerator = e->choices.prefix + choice.name;
+            return value == enumerator || value.endsWith(QLatin1String("::") + enumerator);
+        });
+    }
+    return false;
+}
+
 // returns the item accessor implementation
 // which should go in the h file if inline
 // or the cpp file if not inline
@@ -674,6 +729,67 @@ bool hasErrors(KConfigXmlParser &parser, const ParseResult &parseResult, const K
         return true;
     }
 
+    if (cfg.staticItems) {
+        const char *unsupported = nullptr;
+        if (cfg.dpointer) {
+            unsupported = "MemberVariables=dpointer";
+        } else if (cfg.itemAccessors) {
+            unsupported = "ItemAccessors";
+        } else if (cfg.setUserTexts) {
+            unsupported = "SetUserTexts";
+        } else if (cfg.trackChanges) {
+            unsupported = "TrackChanges";
+        } else if (!parseResult.signalList.isEmpty()) {
+            unsupported = "signals";
+        }
+        for (const auto *entry : parseResult.entries) {
+            if (unsupported) {
+                break;
+            }
+            static const QStringList unsupportedTypes = {QStringLiteral("Enum"), QStringLiteral("Password"), QStringLiteral("Url"), QStringLiteral("UrlList")};
+            if (!entry->param.isEmpty()) {
+                unsupported = "parameterized entries";
+            } else if (!entry->parentGroup.isEmpty()) {
+                unsupported = "nested groups";
+            } else if (unsupportedTypes.contains(entry->type)) {
+                std::cerr << "StaticItems does not support entries of type " << qPrintable(entry->type) << std::endl;
+                return true;
+            }
+        }
+        if (unsupported) {
+            std::cerr << "StaticItems can not be used with " << unsupported << std::endl;
+            return true;
+        }
+    }
+
+    if (cfg.lazyGroups) {
+        const char *unsupported = nullptr;
+        if (cfg.dpointer) {
+            unsupported = "MemberVariables=dpointer";
+        } else if (cfg.itemAccessors) {
+            unsupported = "ItemAccessors";
+        } else if (cfg.staticItems) {
+            unsupported = "StaticItems";
+        } else if (parseResult.entries.isEmpty()) {
+            unsupported = "no entries";
+        }
+        for (const auto &signal : parseResult.signalList) {
+            // they are emitted with the values of entries whose group may not be used yet
+            if (!signal.arguments.isEmpty()) {
+                unsupported = "signals with arguments";
+            }
+        }
+        for (const auto *entry : parseResult.entries) {
+            if (!entry->parentGroup.isEmpty()) {
+                unsupported = "nested groups";
+            }
+        }
+        if (unsupported) {
+            std::cerr << "LazyGroups can not be used with " << unsupported << std::endl;
+            return true;
+        }
+    }
+
     /* TODO: For some reason some configuration files prefer to have *no* entries
      * at all in it, and the generated code is mostly bogus as KConfigXT will not
      * handle save / load / properties, etc, nothing.
@@ -695,6 +811,91 @@ bool hasErrors(KConfigXmlParser &parser, const ParseResult &parseResult, const K
     return false;
 }
 
+// Generates the code for @p inputFilename in @p baseDir, returns false on errors
+static bool generate(const QString &inputFilename, const QString &codegenFilename, QString baseDir, bool writeIfChanged)
+{
+    // TODO: Transform baseDir into a helper.
+#ifdef Q_OS_WIN
+    if (!baseDir.endsWith(QLatin1Char{'/'}) && !baseDir.endsWith(QLatin1Char{'\\'})) {
+#else
+    if (!baseDir.endsWith(QLatin1Char{'/'})) {
+#endif
+        baseDir.append(QLatin1Char{'/'});
+    }
+
+    KConfigParameters cfg(codegenFilename);
+    cfg.writeIfChanged = writeIfChanged;
+
+    KConfigXmlParser xmlParser(cfg, inputFilename);
+
+    // The Xml Parser aborts in the case of an error, so if we get
+    // to parseResult, we have a working Xml file.
+    xmlParser.start();
+
+    ParseResult parseResult = xmlParser.getParseResult();
+
+    if (hasErrors(xmlParser, parseResult, cfg)) {
+        return false;
+    }
+
+    // TODO: Move this to somewhere saner.
+    for (const auto &signal : std::as_const(parseResult.signalList)) {
+        parseResult.hasNonModifySignals |= !signal.modify;
+    }
+
+    // remove '.kcfg' from the name.
+    const QString baseName = inputFilename.mid(0, inputFilename.size() - 5);
+    KConfigHeaderGenerator headerGenerator(baseName, baseDir, cfg, parseResult);
+    headerGenerator.start();
+    headerGenerator.save();
+
+    KConfigSourceGenerator sourceGenerator(baseName, baseDir, cfg, parseResult);
+    sourceGenerator.start();
+    sourceGenerator.save();
+
+    qDeleteAll(parseResult.entries);
+    return true;
+}
+
+// Generates the code for all the files listed in @p batchFilename, on all cores
+static bool generateBatch(const QString &batchFilename)
+{
+    QFile batchFile(batchFilename);
+    if (!batchFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        std::cerr << "Can not open '" << qPrintable(batchFilename) << "' for reading." << std::endl;
+        return false;
+    }
+
+    QList<QStringList> jobs;
+    QTextStream in(&batchFile);
+    while (!in.atEnd()) {
+        const QString line = in.readLine();
+        if (line.isEmpty()) {
+            continue;
+        }
+        const QStringList job = line.split(QLatin1Char('\t'));
+        if (job.size() != 3) {
+            std::cerr << qPrintable(batchFilename) << ": expected the kcfg file, the kcfgc file and the directory separated by tabs: "
+                      << qPrintable(line) << std::endl;
+            return false;
+        }
+        jobs.append(job);
+    }
+
+    // a pool of our own, the global one would wait for a job that exit()s on an error
+    QThreadPool pool;
+    std::atomic<bool> succeeded{true};
+    for (const QStringList &job : std::as_const(jobs)) {
+        pool.start([&job, &succeeded] {
+            if (!generate(job.at(0), job.at(1), job.at(2), true)) {
+                succeeded = false;
+            }
+        });
+    }
+    pool.waitForDone();
+    return succeeded;
+}
+
 int main(int argc, char **argv)
 {
     QCoreApplication app(argc, argv);
@@ -712,6 +913,13 @@ int main(int argc, char **argv)
     QCommandLineOption licenseOption(QStringList{QStringLiteral("l"), QStringLiteral("license")},
                                      QCoreApplication::translate("main", "Display software license."));
 
+    QCommandLineOption batchOption(QStringList{QStringLiteral("batch")},
+                                   QCoreApplication::translate("main",
+                                                               "Generate the code for all the files listed in <file>, one line each with the kcfg file, "
+                                                               "the kcfgc file and the directory to generate the files in, separated by tabs. "
+                                                               "Only the generated files that changed are written."),
+                                   QCoreApplication::translate("main", "file"));
+
     QCommandLineParser parser;
 
     parser.addPositionalArgument(QStringLiteral("file.kcfg"), QStringLiteral("Input kcfg XML file"));
@@ -719,6 +927,7 @@ int main(int argc, char **argv)
 
     parser.addOption(targetDirectoryOption);
     parser.addOption(licenseOption);
+    parser.addOption(batchOption);
 
     parser.addVersionOption();
     parser.addHelpOption();
@@ -735,6 +944,14 @@ int main(int argc, char **argv)
     }
 
     const QStringList args = parser.positionalArguments();
+    if (parser.isSet(batchOption)) {
+        if (!args.isEmpty()) {
+            std::cerr << "Too many arguments." << std::endl;
+            return 1;
+        }
+        return generateBatch(parser.value(batchOption)) ? 0 : 1;
+    }
+
     if (args.count() < 2) {
         std::cerr << "Too few arguments." << std::endl;
         return 1;
@@ -747,45 +964,5 @@ int main(int argc, char **argv)
     inputFilename = args.at(0);
     codegenFilename = args.at(1);
 
-    // TODO: Transform baseDir into a helper.
-    QString baseDir = parser.value(targetDirectoryOption);
-
-#ifdef Q_OS_WIN
-    if (!baseDir.endsWith(QLatin1Char{'/'}) && !baseDir.endsWith(QLatin1Char{'\\'})) {
-#else
-    if (!baseDir.endsWith(QLatin1Char{'/'})) {
-#endif
-        baseDir.append(QLatin1Char{'/'});
-    }
-
-    KConfigParameters cfg(codegenFilename);
-
-    KConfigXmlParser xmlParser(cfg, inputFilename);
-
-    // The Xml Parser aborts in the case of an error, so if we get
-    // to parseResult, we have a working Xml file.
-    xmlParser.start();
-
-    ParseResult parseResult = xmlParser.getParseResult();
-
-    if (hasErrors(xmlParser, parseResult, cfg)) {
-        return 1;
-    }
-
-    // TODO: Move this to somewhere saner.
-    for (const auto &signal : std::as_const(parseResult.signalList)) {
-        parseResult.hasNonModifySignals |= !signal.modify;
-    }
-
-    // remove '.kcfg' from the name.
-    const QString baseName = inputFilename.mid(0, inputFilename.size() - 5);
-    KConfigHeaderGenerator headerGenerator(baseName, baseDir, cfg, parseResult);
-    headerGenerator.start();
-    headerGenerator.save();
-
-    KConfigSourceGenerator sourceGenerator(baseName, baseDir, cfg, parseResult);
-    sourceGenerator.start();
-    sourceGenerator.save();
-
-    qDeleteAll(parseResult.entries);
+    return generate(inputFilename, codegenFilename, parser.value(targetDirectoryOption), false) ? 0 : 1;
 }
@@ -0,0 +1,98 @@
+/*  Compile config files into the binary format KConfig reads instead of them.
+
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+/*
+ * Meant to be run when installing large, rarely changing default files,
+ * e.g. by distributions at package install time:
+ *
+ *	kcompileconfig6 /etc/xdg/kdeglobals /etc/xdg/kwinrc
+ *
+ * writes /etc/xdg/kdeglobals.compiled and /etc/xdg/kwinrc.compiled. The
+ * .ini files stay the source of truth; once one is changed, KConfig reads
+ * it again until it is compiled anew.
+ *
+ * The compiled files of system defaults are always looked for. Any other
+ * file, such as the kdeglobals of the user, is also registered for the user
+ * running the tool, as KConfig only looks for the compiled files of the
+ * files registered.
+ *
+ *	kcompileconfig6 --bundle /etc/xdg
+ *
+ * packs all the files of /etc/xdg into /etc/xdg/kconfig-defaults.bundle
+ * instead, or only the files named after the directory. It is used until a
+ * file of the directory is added, removed or replaced, so it should be
+ * packed again after each installation touching the directory.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <stdio.h>
+
+#include <kconfigcompiled_p.h>
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption(
+        QCommandLineOption(QStringLiteral("output"),
+                           QCoreApplication::translate("main", "Write to <file> instead of next to the config file, only with a single config file"),
+                           QStringLiteral("file")));
+    parser.addOption(QCommandLineOption(QStringLiteral("bundle"),
+                                        QCoreApplication::translate("main", "Pack the files of <directory> into a single bundle, all of them if none is given"),
+                                        QStringLiteral("directory")));
+    parser.addOption(QCommandLineOption(QStringLiteral("remove"), QCoreApplication::translate("main", "Remove the compiled files instead")));
+    parser.addPositionalArgument(QStringLiteral("files"), QCoreApplication::translate("main", "Config files to compile"), QStringLiteral("files..."));
+
+    parser.process(app);
+
+    const QStringList files = parser.positionalArguments();
+    const QString output = parser.value(QStringLiteral("output"));
+    const QString directory = parser.value(QStringLiteral("bundle"));
+    if (!directory.isEmpty()) {
+        if (!output.isEmpty()) {
+            parser.showHelp(1);
+        }
+        const QString bundleFile = KConfigDefaultsBundle::bundlePath(directory);
+        if (parser.isSet(QStringLiteral("remove"))) {
+            if (QFile::exists(bundleFile) && !QFile::remove(bundleFile)) {
+                fprintf(stderr, "Could not remove %s\n", qPrintable(bundleFile));
+                return 1;
+            }
+        } else if (!KConfigCompiledBackend::pack(directory, files)) {
+            fprintf(stderr, "Could not pack %s\n", qPrintable(directory));
+            return 1;
+        }
+        return 0;
+    }
+    if (files.isEmpty() || (!output.isEmpty() && files.size() != 1)) {
+        parser.showHelp(1);
+    }
+
+    int result = 0;
+    for (const QString &file : files) {
+        const QString compiledFile = output.isEmpty() ? KConfigCompiledBackend::compiledPath(file) : output;
+        if (parser.isSet(QStringLiteral("remove"))) {
+            if (QFile::exists(compiledFile) && !QFile::remove(compiledFile)) {
+                fprintf(stderr, "Could not remove %s\n", qPrintable(compiledFile));
+                result = 1;
+            } else if (output.isEmpty()) {
+                KConfigCompiledBackend::setRegistered(file, false);
+            }
+        } else if (!KConfigCompiledBackend::compile(file, compiledFile)) {
+            fprintf(stderr, "Could not compile %s\n", qPrintable(file));
+            result = 1;
+        } else if (output.isEmpty() && !KConfigCompiledBackend::setRegistered(file, true)) {
+            fprintf(stderr, "Could not register %s\n", qPrintable(file));
+            result = 1;
+        }
+    }
+    return result;
+}
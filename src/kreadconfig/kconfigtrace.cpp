@@ -0,0 +1,151 @@
+/*  Collect the spans KConfig broadcasts with KCONFIG_TRACE set.
+
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+/*
+ * The processes to look at have to run with KCONFIG_TRACE set, the settings
+ * module as well as those it notifies, usually the whole session. Each span
+ * of a change is printed as it is received, with the time it started at
+ * relative to the first one of the change:
+ *
+ *	<change> +<start> ms <stage> <application>[<pid>] <config> <duration> ms
+ *
+ * The stages are save (KCoreConfigSkeleton::save()), sync, lock,
+ * writeConfig and notify in the process making the change, then notified,
+ * parseConfig and reload in each process notified of it. Once no span of a
+ * change came for --settle milliseconds, a summary line follows, with the
+ * time from the start of its first span to the end of its last one, i.e.
+ * from the click on Apply to the last reload.
+ *
+ *	KCONFIG_TRACE=1 systemsettings &
+ *	kconfigtrace6
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+#include <stdio.h>
+
+#include <algorithm>
+
+class SpanCollector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SpanCollector(int settle)
+        : m_settle(settle)
+    {
+        m_timer.setSingleShot(true);
+        connect(&m_timer, &QTimer::timeout, this, &SpanCollector::summarizeSettled);
+    }
+
+public Q_SLOTS:
+    void onSpan(const QString &change, const QString &stage, const QString &file, const QString &application, qint64 pid, qint64 start, qint64 duration)
+    {
+        Change &c = m_changes[change];
+        if (c.spans == 0) {
+            c.start = start;
+            c.end = start + duration;
+        } else {
+            c.start = std::min(c.start, start);
+            c.end = std::max(c.end, start + duration);
+        }
+        c.processes.insert(pid);
+        c.spans++;
+        c.lastReceived.start();
+
+        fprintf(stdout,
+                "%s +%.3f ms %s %s[%lld] %s %.3f ms\n",
+                qPrintable(change),
+                (start - c.start) / 1000.0,
+                qPrintable(stage),
+                qPrintable(application),
+                static_cast<long long>(pid),
+                qPrintable(file),
+                duration / 1000.0);
+        fflush(stdout);
+        m_timer.start(m_settle);
+    }
+
+private:
+    struct Change {
+        qint64 start = 0; // microseconds since the epoch
+        qint64 end = 0;
+        int spans = 0;
+        QSet<qint64> processes;
+        QElapsedTimer lastReceived;
+    };
+
+    void summarizeSettled()
+    {
+        int next = -1;
+        for (auto it = m_changes.begin(); it != m_changes.end();) {
+            const qint64 quiet = it->lastReceived.elapsed();
+            if (quiet < m_settle) {
+                next = next < 0 ? int(m_settle - quiet) : std::min(next, int(m_settle - quiet));
+                ++it;
+                continue;
+            }
+            fprintf(stdout,
+                    "%s: %.3f ms from the first span to the end of the last, %d spans in %lld processes\n",
+                    qPrintable(it.key()),
+                    (it->end - it->start) / 1000.0,
+                    it->spans,
+                    static_cast<long long>(it->processes.size()));
+            fflush(stdout);
+            it = m_changes.erase(it);
+        }
+        if (next >= 0) {
+            m_timer.start(next);
+        }
+    }
+
+    const int m_settle;
+    QHash<QString, Change> m_changes;
+    QTimer m_timer;
+};
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption(QStringLiteral("settle"),
+                                        QCoreApplication::translate("main", "Summarize a change once no span of it came for <ms> milliseconds"),
+                                        QStringLiteral("ms"),
+                                        QStringLiteral("1000")));
+    parser.process(app);
+
+    bool ok = false;
+    const int settle = parser.value(QStringLiteral("settle")).toInt(&ok);
+    if (!ok || settle <= 0 || !parser.positionalArguments().isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    SpanCollector collector(settle);
+    if (!QDBusConnection::sessionBus().connect(QString(),
+                                               QStringLiteral("/KConfigTrace"),
+                                               QStringLiteral("org.kde.kconfig.trace"),
+                                               QStringLiteral("Span"),
+                                               &collector,
+                                               SLOT(onSpan(QString, QString, QString, QString, qint64, qint64, qint64)))) {
+        fprintf(stderr,
+                "%s: %s\n",
+                qPrintable(QCoreApplication::applicationName()),
+                qPrintable(QCoreApplication::translate("main", "Couldn't listen on the session bus")));
+        return 1;
+    }
+    return app.exec();
+}
+
+#include "kconfigtrace.moc"
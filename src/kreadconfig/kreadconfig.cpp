@@ -28,16 +28,288 @@
  *	else
  *		rm someFile
  *	fi
+ *
+ * With --batch, the entries to read are taken from stdin instead, one per
+ * line as tab separated fields: the group, the key, and optionally the type
+ * and the default value. Nested groups are written as in the config file,
+ * "Parent][Child". The value of each entry is printed on its own line, bools
+ * as "true" or "false", and the exit status is 0. All of them are read from
+ * the same parse of the configuration.
+ *
+ *	printf 'KDE\tmacStyle\tbool\nPaths\tTrash\n' | kreadconfig6 --batch
+ *
+ * When --file is an absolute path and the type is not path, the file is read
+ * on its own with KConfigIniReader, without setting up an application or a
+ * KConfig. Anything this can't answer the same way, like entries that need
+ * expansion or are immutable, takes the usual way.
+ *
+ * With --watch, the value is printed as with no --type, bools as "true" or
+ * "false", and then again on its own line each time it changes, until the
+ * process is killed. The changes are those notified by KConfigWatcher, i.e.
+ * written with the Notify flag, as kwriteconfig6 --notify does; their values
+ * are usually part of the notification, so the file is not even read again.
+ *
+ *	kreadconfig6 --group General --key ColorScheme --watch | while read -r scheme; do
+ *		echo "Color scheme is now $scheme"
+ *	done
  */
 
 #include <KConfig>
 #include <KConfigGroup>
+#include <KConfigIniReader>
+#include <KConfigWatcher>
 #include <KSharedConfig>
 #include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QLocale>
 #include <stdio.h>
 
+#include <algorithm>
+
+static bool isTrue(const QString &value)
+{
+    const QString lower = value.toLower();
+    return lower == QLatin1String{"true"} || lower == QLatin1String{"on"} || lower == QLatin1String{"yes"} || lower == QLatin1String{"1"};
+}
+
+// Reads the entries listed on stdin, see the comment at the top
+static int readBatch(KConfig *konfig)
+{
+    QFile input;
+    if (!input.open(stdin, QIODevice::ReadOnly | QIODevice::Text)) {
+        return 2;
+    }
+
+    int status = 0;
+    int lineNumber = 0;
+    while (!input.atEnd()) {
+        ++lineNumber;
+        QByteArray bytes = input.readLine();
+        if (bytes.endsWith('\n')) {
+            bytes.chop(1);
+        }
+        const QString line = QString::fromLocal8Bit(bytes);
+        if (line.isEmpty()) {
+            continue;
+        }
+        const QStringList fields = line.split(QLatin1Char('\t'));
+        const QStringList groups = fields.at(0).split(QLatin1String("]["));
+        if (fields.size() < 2 || fields.size() > 4 || fields.at(1).isEmpty() || groups.contains(QString())) {
+            fprintf(stderr,
+                    "%s: %s\n",
+                    qPrintable(QCoreApplication::applicationName()),
+                    qPrintable(QCoreApplication::translate("main", "Line %1: expected a group, a key, and optionally a type and a default value").arg(lineNumber)));
+            // keep the lines of the output matching those of the input
+            fprintf(stdout, "\n");
+            status = 2;
+            continue;
+        }
+
+        KConfigGroup cfgGroup = konfig->group(QString());
+        for (const QString &grp : groups) {
+            cfgGroup = cfgGroup.group(grp);
+        }
+        const QString &key = fields.at(1);
+        const QString type = fields.value(2).toLower();
+        const QString dflt = fields.value(3);
+
+        QString value;
+        if (type == QLatin1String{"bool"}) {
+            value = cfgGroup.readEntry(key, isTrue(dflt)) ? QStringLiteral("true") : QStringLiteral("false");
+        } else if (type == QLatin1String{"num"} || type == QLatin1String{"int"}) {
+            value = QString::number(cfgGroup.readEntry(key, dflt.toInt()));
+        } else if (type == QLatin1String{"path"}) {
+            value = cfgGroup.readPathEntry(key, dflt);
+        } else {
+            value = cfgGroup.readEntry(key, dflt);
+        }
+        fprintf(stdout, "%s\n", value.toLocal8Bit().data());
+    }
+    return status;
+}
+
+// Prints the entry of @p cfgGroup and then its new value on each notified change, see the comment at the top
+static int
+watchEntry(const KConfigWatcher::Ptr &watcher, const KConfigGroup &cfgGroup, const QString &key, const QString &type, const QString &dflt)
+{
+    auto readValue = [&]() -> QString {
+        if (type == QLatin1String{"bool"}) {
+            return cfgGroup.readEntry(key, isTrue(dflt)) ? QStringLiteral("true") : QStringLiteral("false");
+        } else if (type == QLatin1String{"num"} || type == QLatin1String{"int"}) {
+            return QString::number(cfgGroup.readEntry(key, dflt.toInt()));
+        } else if (type == QLatin1String{"path"}) {
+            return cfgGroup.readPathEntry(key, dflt);
+        }
+        return cfgGroup.readEntry(key, dflt);
+    };
+
+    QString value = readValue();
+    fprintf(stdout, "%s\n", value.toLocal8Bit().data());
+    fflush(stdout);
+
+    const QByteArray keyName = key.toUtf8();
+    QObject::connect(watcher.data(), &KConfigWatcher::configChanged, [&](const KConfigGroup &group, const QByteArrayList &names) {
+        Q_UNUSED(group)
+        // the watcher only reports the group of the entry, and writing the same value again is no change
+        if (!names.contains(keyName)) {
+            return;
+        }
+        const QString newValue = readValue();
+        if (newValue == value) {
+            return;
+        }
+        value = newValue;
+        fprintf(stdout, "%s\n", value.toLocal8Bit().data());
+        fflush(stdout);
+    });
+
+    return QCoreApplication::exec();
+}
+
+// The entry a lookup found so far: localized ones win over plain ones,
+// and for a locale with a country, those of the country over the language
+struct LeanMatch {
+    enum Tier {
+        Plain,
+        Language,
+        Country,
+        TierCount,
+    };
+    QByteArray value[TierCount];
+    bool found[TierCount] = {};
+};
+
+// Reads a single entry of an absolute --file straight from the file, before
+// any QCoreApplication. Returns false if the arguments or the entry need the
+// full KConfig, which then reads the file again.
+static bool leanRead(int argc, char **argv, int *status)
+{
+    QByteArray file;
+    QByteArray key;
+    QByteArray type;
+    QByteArray dflt;
+    bool hasKey = false;
+    QList<QByteArray> groups;
+    for (int i = 1; i < argc; ++i) {
+        QByteArrayView arg(argv[i]);
+        if (!arg.startsWith("--")) {
+            return false;
+        }
+        arg = arg.sliced(2);
+
+        QByteArray value;
+        const qsizetype eq = arg.indexOf('=');
+        if (eq >= 0) {
+            value = arg.sliced(eq + 1).toByteArray();
+            arg = arg.first(eq);
+        } else if (i + 1 < argc) {
+            value = argv[++i];
+        } else {
+            return false;
+        }
+
+        if (arg == "file") {
+            file = value;
+        } else if (arg == "group") {
+            groups.append(QString::fromLocal8Bit(value).toUtf8());
+        } else if (arg == "key") {
+            key = QString::fromLocal8Bit(value).toUtf8();
+            hasKey = true;
+        } else if (arg == "type") {
+            type = value.toLower();
+        } else if (arg == "default") {
+            dflt = value;
+        } else {
+            return false; // --help, --batch, --watch, or something for QCommandLineParser to complain about
+        }
+    }
+
+    const QString fileName = QString::fromLocal8Bit(file);
+    if (!hasKey || !QDir::isAbsolutePath(fileName) || type == "path") {
+        return false;
+    }
+    if (groups.isEmpty()) {
+        groups.append(QByteArrayLiteral("KDE"));
+    }
+    if (groups.contains(QByteArray()) || (groups.size() > 1 && groups.contains(QByteArrayLiteral("<default>")))) {
+        return false;
+    }
+    const QByteArray group = groups.join('\x1d');
+
+    // the same matching as KConfigIniBackend::parseConfig()
+    const QByteArray locale = QLocale().name().toUtf8();
+    const qsizetype langIdx = locale.indexOf('_');
+    const QByteArray language = langIdx >= 0 ? locale.left(langIdx) : locale;
+
+    // later entries override earlier ones, so the whole file is read
+    LeanMatch match;
+    KConfigIniReader reader(fileName);
+    while (reader.readNext()) {
+        if (reader.key() != key || reader.group() != group) {
+            continue;
+        }
+        if (reader.flags() & (KConfigIniReader::Immutable | KConfigIniReader::Expand)) {
+            return false;
+        }
+
+        LeanMatch::Tier tier = LeanMatch::Plain;
+        const QByteArrayView entryLocale = reader.locale();
+        if (!entryLocale.isNull()) {
+            if (entryLocale.isEmpty()) {
+                return false;
+            }
+            if (entryLocale != locale && entryLocale != language && (entryLocale.front() != 'C' || locale != "en_US")) {
+                continue; // another locale
+            }
+            tier = entryLocale.contains('_') ? LeanMatch::Country : LeanMatch::Language;
+        }
+        if (reader.flags() & KConfigIniReader::Deleted) {
+            if (tier != LeanMatch::Plain) {
+                return false;
+            }
+            match.found[tier] = false;
+            continue;
+        }
+        match.value[tier] = reader.value().toByteArray();
+        match.found[tier] = true;
+    }
+
+    const QByteArray *value = nullptr;
+    for (int tier = LeanMatch::TierCount - 1; tier >= 0 && !value; --tier) {
+        if (match.found[tier]) {
+            value = &match.value[tier];
+        }
+    }
+
+    if (type == "bool") {
+        bool retValue = isTrue(QString::fromLocal8Bit(dflt));
+        if (value) {
+            // the same as KConfigGroup::readEntry(key, bool)
+            static const char *const negatives[] = {"false", "no", "off", "0"};
+            retValue = std::none_of(std::begin(negatives), std::end(negatives), [value](const char *negative) {
+                return value->compare(negative, Qt::CaseInsensitive) == 0;
+            });
+        }
+        *status = !retValue;
+    } else if (type == "num" || type == "int") {
+        bool ok = false;
+        const int number = value ? value->toInt(&ok) : 0;
+        *status = ok ? number : QString::fromLocal8Bit(dflt).toInt();
+    } else {
+        fprintf(stdout, "%s\n", value ? QString::fromUtf8(*value).toLocal8Bit().data() : dflt.data());
+        *status = 0;
+    }
+    return true;
+}
+
 int main(int argc, char **argv)
 {
+    int leanStatus = 0;
+    if (leanRead(argc, argv, &leanStatus)) {
+        return leanStatus;
+    }
+
     QCoreApplication app(argc, argv);
 
     QCommandLineParser parser;
@@ -52,6 +324,12 @@ int main(int argc, char **argv)
     parser.addOption(QCommandLineOption(QStringLiteral("key"), QCoreApplication::translate("main", "Key to look for"), QStringLiteral("key")));
     parser.addOption(QCommandLineOption(QStringLiteral("default"), QCoreApplication::translate("main", "Default value"), QStringLiteral("value")));
     parser.addOption(QCommandLineOption(QStringLiteral("type"), QCoreApplication::translate("main", "Type of variable"), QStringLiteral("type")));
+    parser.addOption(QCommandLineOption(
+        QStringLiteral("batch"),
+        QCoreApplication::translate("main", "Read many entries, listed on stdin as lines of tab separated group, key, and optional type and default value")));
+
+    parser.addOption(QCommandLineOption(QStringLiteral("watch"),
+                                        QCoreApplication::translate("main", "Keep running and print the value again each time it is changed with notification")));
 
     parser.process(app);
 
@@ -60,8 +338,10 @@ int main(int argc, char **argv)
     QString file = parser.value(QStringLiteral("file"));
     QString dflt = parser.value(QStringLiteral("default"));
     QString type = parser.value(QStringLiteral("type")).toLower();
+    const bool batch = parser.isSet(QStringLiteral("batch"));
+    const bool watch = parser.isSet(QStringLiteral("watch"));
 
-    if (key.isNull() || !parser.positionalArguments().isEmpty()) {
+    if ((key.isNull() && !batch) || (batch && watch) || !parser.positionalArguments().isEmpty()) {
         parser.showHelp(1);
     }
 
@@ -75,6 +355,15 @@ int main(int argc, char **argv)
         konfig = new KConfig(file, KConfig::NoGlobals);
         configMustDeleted = true;
     }
+
+    if (batch) {
+        const int status = readBatch(konfig);
+        if (configMustDeleted) {
+            delete konfig;
+        }
+        return status;
+    }
+
     KConfigGroup cfgGroup = konfig->group(QString());
     for (const QString &grp : groups) {
         if (grp.isEmpty()) {
@@ -90,10 +379,23 @@ int main(int argc, char **argv)
         cfgGroup = cfgGroup.group(grp);
     }
 
+    if (watch) {
+        // the watcher needs a shared config, and only reloads the watched group
+        KSharedConfig::Ptr shared =
+            file.isEmpty() ? KSharedConfig::openConfig() : KSharedConfig::openConfig(file, KConfig::NoGlobals);
+        if (configMustDeleted) {
+            delete konfig;
+        }
+        KConfigGroup watchedGroup = shared->group(QString());
+        for (const QString &grp : groups) {
+            watchedGroup = watchedGroup.group(grp);
+        }
+        const KConfigWatcher::Ptr watcher = KConfigWatcher::create(shared, {groups.join(QLatin1Char('\x1d'))});
+        return watchEntry(watcher, watchedGroup, key, type, dflt);
+    }
+
     if (type == QLatin1String{"bool"}) {
-        dflt = dflt.toLower();
-        bool def = (dflt == QLatin1String{"true"} || dflt == QLatin1String{"on"} || dflt == QLatin1String{"yes"} || dflt == QLatin1String{"1"});
-        bool retValue = !cfgGroup.readEntry(key, def);
+        bool retValue = !cfgGroup.readEntry(key, isTrue(dflt));
         if (configMustDeleted) {
             delete konfig;
         }
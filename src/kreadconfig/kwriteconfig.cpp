@@ -9,12 +9,95 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
+/*
+ * With --batch, the entries to write are taken from stdin, one per line as
+ * four tab separated fields: the group, the key, the type and the value.
+ * Nested groups are written as in the config file, "Parent][Child". The type
+ * is empty for a string, "bool", "path", or "delete" to delete the entry,
+ * in which case the value is ignored. The file is written once, after all
+ * the lines were read.
+ *
+ *	printf 'KDE\tSingleClick\tbool\tfalse\nIcons\tTheme\t\tbreeze\n' | kwriteconfig6 --batch
+ */
+
 #include <KConfig>
 #include <KConfigGroup>
 #include <QCommandLineParser>
 #include <QCoreApplication>
+#include <QFile>
 #include <stdio.h>
 
+static void writeValue(KConfigGroup &cfgGroup, const QString &key, const QString &type, const QString &value)
+{
+    if (type == QLatin1String{"bool"}) {
+        // For symmetry with kreadconfig we accept a wider range of values as true than Qt
+        /* clang-format off */
+        bool boolvalue = value == QLatin1String{"true"}
+                         || value == QLatin1String{"on"}
+                         || value == QLatin1String{"yes"}
+                         || value == QLatin1String{"1"}; /* clang-format on */
+        cfgGroup.writeEntry(key, boolvalue);
+    } else if (type == QLatin1String{"path"}) {
+        cfgGroup.writePathEntry(key, value);
+    } else {
+        cfgGroup.writeEntry(key, value);
+    }
+}
+
+// Writes the entries listed on stdin, see the comment at the top
+static int writeBatch(KConfig *konfig)
+{
+    QFile input;
+    if (!input.open(stdin, QIODevice::ReadOnly | QIODevice::Text)) {
+        return 2;
+    }
+
+    int status = 0;
+    int lineNumber = 0;
+    while (!input.atEnd()) {
+        ++lineNumber;
+        QByteArray bytes = input.readLine();
+        if (bytes.endsWith('\n')) {
+            bytes.chop(1);
+        }
+        if (bytes.isEmpty()) {
+            continue;
+        }
+        const QStringList fields = QString::fromLocal8Bit(bytes).split(QLatin1Char('\t'));
+        const QStringList groups = fields.at(0).split(QLatin1String("]["));
+        if (fields.size() != 4 || fields.at(1).isEmpty() || groups.contains(QString())) {
+            fprintf(stderr,
+                    "%s: %s\n",
+                    qPrintable(QCoreApplication::applicationName()),
+                    qPrintable(QCoreApplication::translate("main", "Line %1: expected a group, a key, a type and a value").arg(lineNumber)));
+            status = 2;
+            continue;
+        }
+
+        KConfigGroup cfgGroup = konfig->group(QString());
+        for (const QString &grp : groups) {
+            cfgGroup = cfgGroup.group(grp);
+        }
+        const QString &key = fields.at(1);
+        if (cfgGroup.isEntryImmutable(key)) {
+            status = 2;
+            continue;
+        }
+
+        const QString type = fields.at(2).toLower();
+        if (type == QLatin1String{"delete"}) {
+            cfgGroup.deleteEntry(key);
+        } else {
+            writeValue(cfgGroup, key, type, fields.at(3));
+        }
+    }
+
+    if (!konfig->sync()) {
+        status = 2;
+    }
+    return status;
+}
+
 int main(int argc, char **argv)
 {
     QCoreApplication app(argc, argv);
@@ -34,6 +117,9 @@ int main(int argc, char **argv)
                            QCoreApplication::translate("main", "Type of variable. Use \"bool\" for a boolean, otherwise it is treated as a string"),
                            QStringLiteral("type")));
     parser.addOption(QCommandLineOption(QStringLiteral("delete"), QCoreApplication::translate("main", "Delete the designated key if enabled")));
+    parser.addOption(QCommandLineOption(
+        QStringLiteral("batch"),
+        QCoreApplication::translate("main", "Write many entries, listed on stdin as lines of tab separated group, key, type and value")));
     parser.addPositionalArgument(QStringLiteral("value"), QCoreApplication::translate("main", "The value to write. Mandatory, on a shell use '' for empty"));
 
     parser.process(app);
@@ -43,9 +129,14 @@ int main(int argc, char **argv)
     QString file = parser.value(QStringLiteral("file"));
     QString type = parser.value(QStringLiteral("type")).toLower();
     bool del = parser.isSet(QStringLiteral("delete"));
+    const bool batch = parser.isSet(QStringLiteral("batch"));
 
     QString value;
-    if (del) {
+    if (batch) {
+        if (!parser.positionalArguments().isEmpty()) {
+            parser.showHelp(1);
+        }
+    } else if (del) {
         value = QString{};
     } else if (parser.positionalArguments().isEmpty()) {
         parser.showHelp(1);
@@ -60,6 +151,12 @@ int main(int argc, char **argv)
         konfig = new KConfig(file, KConfig::NoGlobals);
     }
 
+    if (batch) {
+        const int status = konfig->accessMode() == KConfig::ReadWrite ? writeBatch(konfig) : 2;
+        delete konfig;
+        return status;
+    }
+
     KConfigGroup cfgGroup = konfig->group(QString());
     for (const QString &grp : groups) {
         if (grp.isEmpty()) {
@@ -78,18 +175,8 @@ int main(int argc, char **argv)
 
     if (del) {
         cfgGroup.deleteEntry(key);
-    } else if (type == QLatin1String{"bool"}) {
-        // For symmetry with kreadconfig we accept a wider range of values as true than Qt
-        /* clang-format off */
-        bool boolvalue = value == QLatin1String{"true"}
-                         || value == QLatin1String{"on"}
-                         || value == QLatin1String{"yes"}
-                         || value == QLatin1String{"1"}; /* clang-format on */
-        cfgGroup.writeEntry(key, boolvalue);
-    } else if (type == QLatin1String{"path"}) {
-        cfgGroup.writePathEntry(key, value);
     } else {
-        cfgGroup.writeEntry(key, value);
+        writeValue(cfgGroup, key, type, value);
     }
     konfig->sync();
     delete konfig;
@@ -9,10 +9,13 @@
 #include "kconfigpropertymap.h"
 
 #include <KCoreConfigSkeleton>
+#include <QHash>
 #include <QJSValue>
 #include <QPointer>
+#include <QTimer>
 
 #include <functional>
+#include <utility>
 
 class KConfigPropertyMapPrivate
 {
@@ -28,21 +31,34 @@ public:
     };
 
     void loadConfig(LoadConfigOption option);
+    // inserts @p value unless the map has it already, so that bindings to @p key aren't evaluated for nothing
+    bool insertIfChanged(const QString &key, const QVariant &value);
     void writeConfig();
     void writeConfigValue(const QString &key, const QVariant &value);
+    // sets the items of pendingValues and saves the skeleton, see KConfigPropertyMap::setWriteThroughInterval()
+    void writePendingValues();
 
     KConfigPropertyMap *q;
     QPointer<KCoreConfigSkeleton> config;
+    KConfigPropertyMap::Options options;
     bool updatingConfigValue = false;
     bool notify = false;
+    QTimer writeThroughTimer;
+    QHash<QString, QVariant> pendingValues; // the last one written to each key since the last writePendingValues()
 };
 
 KConfigPropertyMap::KConfigPropertyMap(KCoreConfigSkeleton *config, QObject *parent)
+    : KConfigPropertyMap(config, NoOptions, parent)
+{
+}
+
+KConfigPropertyMap::KConfigPropertyMap(KCoreConfigSkeleton *config, Options options, QObject *parent)
     : QQmlPropertyMap(this, parent)
     , d(new KConfigPropertyMapPrivate(this))
 {
     Q_ASSERT(config);
     d->config = config;
+    d->options = options;
 
     // Reload the config only if the change signal has *not* been emitted by ourselves updating the config
     connect(config, &KCoreConfigSkeleton::configChanged, this, [this]() {
@@ -53,11 +69,18 @@ KConfigPropertyMap::KConfigPropertyMap(KCoreConfigSkeleton *config, QObject *par
     connect(this, &KConfigPropertyMap::valueChanged, this, [this](const QString &key, const QVariant &value) {
         d->writeConfigValue(key, value);
     });
+    d->writeThroughTimer.setSingleShot(true);
+    connect(&d->writeThroughTimer, &QTimer::timeout, this, [this]() {
+        d->writePendingValues();
+    });
 
     d->loadConfig(KConfigPropertyMapPrivate::DontEmitValueChanged);
 }
 
-KConfigPropertyMap::~KConfigPropertyMap() = default;
+KConfigPropertyMap::~KConfigPropertyMap()
+{
+    d->writePendingValues();
+}
 
 bool KConfigPropertyMap::isNotify() const
 {
@@ -69,6 +92,19 @@ void KConfigPropertyMap::setNotify(bool notify)
     d->notify = notify;
 }
 
+int KConfigPropertyMap::writeThroughInterval() const
+{
+    return d->writeThroughTimer.interval();
+}
+
+void KConfigPropertyMap::setWriteThroughInterval(int msec)
+{
+    d->writeThroughTimer.setInterval(msec);
+    if (msec <= 0) {
+        d->writePendingValues();
+    }
+}
+
 void KConfigPropertyMap::writeConfig()
 {
     d->writeConfig();
@@ -93,38 +129,70 @@ bool KConfigPropertyMap::isImmutable(const QString &key) const
     return false;
 }
 
+QVariant KConfigPropertyMap::defaultValue(const QString &key) const
+{
+    KConfigSkeletonItem *item = d->config ? d->config.data()->findItem(key) : nullptr;
+    return item ? item->getDefault() : QVariant();
+}
+
 void KConfigPropertyMapPrivate::loadConfig(KConfigPropertyMapPrivate::LoadConfigOption option)
 {
     if (!config) {
         return;
     }
 
+    // only the values that differ from the ones in the map are inserted and signalled
     const auto &items = config.data()->items();
     for (KConfigSkeletonItem *item : items) {
-        q->insert(item->key() + QStringLiteral("Default"), item->getDefault());
-        q->insert(item->key(), item->property());
-        if (option == EmitValueChanged) {
-            Q_EMIT q->valueChanged(item->key(), item->property());
+        if (!(options & KConfigPropertyMap::LazyDefaults)) {
+            insertIfChanged(item->key() + QStringLiteral("Default"), item->getDefault());
+        }
+        const QVariant value = item->property();
+        if (insertIfChanged(item->key(), value) && option == EmitValueChanged) {
+            Q_EMIT q->valueChanged(item->key(), value);
         }
     }
 }
 
+bool KConfigPropertyMapPrivate::insertIfChanged(const QString &key, const QVariant &value)
+{
+    if (q->contains(key) && q->value(key) == value) {
+        return false;
+    }
+    q->insert(key, value);
+    return true;
+}
+
 void KConfigPropertyMapPrivate::writeConfig()
 {
+    pendingValues.clear(); // all the values are set below
+    writeThroughTimer.stop();
     if (!config) {
         return;
     }
 
+    // setProperty() marks the items it sets changed, so that a skeleton that tracks
+    // changes only writes those, see KCoreConfigSkeleton::setTrackChanges()
     const auto lstItems = config.data()->items();
     for (KConfigSkeletonItem *item : lstItems) {
-        item->setWriteFlags(notify ? KConfigBase::Notify : KConfigBase::Normal);
-        item->setProperty(q->value(item->key()));
+        const QVariant value = q->value(item->key());
+        if (!item->isEqual(value)) {
+            item->setWriteFlags(notify ? KConfigBase::Notify : KConfigBase::Normal);
+            item->setProperty(value);
+        }
     }
-
 }
 
 void KConfigPropertyMapPrivate::writeConfigValue(const QString &key, const QVariant &value)
 {
+    if (writeThroughTimer.interval() > 0) {
+        // a slider moved from one end to the other is written once, with the value it ended at
+        pendingValues.insert(key, value);
+        if (!writeThroughTimer.isActive()) {
+            writeThroughTimer.start();
+        }
+        return;
+    }
     KConfigSkeletonItem *item = config.data()->findItem(key);
     if (item) {
         updatingConfigValue = true;
@@ -134,3 +202,27 @@ void KConfigPropertyMapPrivate::writeConfigValue(const QString &key, const QVari
     }
 }
 
+void KConfigPropertyMapPrivate::writePendingValues()
+{
+    writeThroughTimer.stop();
+    const QHash<QString, QVariant> values = std::exchange(pendingValues, {});
+    if (!config) {
+        return;
+    }
+
+    bool changed = false;
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        KConfigSkeletonItem *item = config.data()->findItem(it.key());
+        if (item && !item->isEqual(it.value())) {
+            item->setWriteFlags(notify ? KConfigBase::Notify : KConfigBase::Normal);
+            item->setProperty(it.value());
+            changed = true;
+        }
+    }
+    if (changed) {
+        // a single sync, so that the notification of all the keys goes out at once
+        updatingConfigValue = true;
+        config.data()->save();
+        updatingConfigValue = false;
+    }
+}
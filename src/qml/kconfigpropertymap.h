@@ -30,7 +30,24 @@ class KCONFIGQML_EXPORT KConfigPropertyMap : public QQmlPropertyMap
     Q_OBJECT
 
 public:
+    /**
+     * @see Options
+     * @since 6.1
+     */
+    enum Option {
+        NoOptions = 0x0,
+        /// Leave out the "<key>Default" values, which double the size of the map
+        /// and the time it takes to fill it. defaultValue() looks them up instead.
+        LazyDefaults = 0x1,
+    };
+    Q_DECLARE_FLAGS(Options, Option)
+
     KConfigPropertyMap(KCoreConfigSkeleton *config, QObject *parent = nullptr);
+    /**
+     * Same as above, with @p options.
+     * @since 6.1
+     */
+    KConfigPropertyMap(KCoreConfigSkeleton *config, Options options, QObject *parent = nullptr);
     ~KConfigPropertyMap() override;
 
     /**
@@ -54,6 +71,36 @@ public:
      */
     Q_INVOKABLE bool isImmutable(const QString &key) const;
 
+    /**
+     * The default value of the item at @p key, looked up when called. Unlike
+     * the "<key>Default" values a binding to it isn't updated when the
+     * default changes.
+     *
+     * @return the default, or an invalid QVariant if there is no such item
+     * @since 6.1
+     */
+    Q_INVOKABLE QVariant defaultValue(const QString &key) const;
+
+    /**
+     * Sets how long the values QML writes to the map are collected before
+     * they are set to the items, in milliseconds. When the interval is over
+     * the items are set to the last value of each key and the skeleton is
+     * saved, so that the values set while dragging a slider, for instance,
+     * are written and notified once, not on every step.
+     *
+     * With the default of 0 the items are set right away and the skeleton
+     * isn't saved, writeConfig() and KCoreConfigSkeleton::save() are left
+     * to the caller. Setting 0 writes the values still pending, as does
+     * destroying the map.
+     * @since 6.1
+     */
+    void setWriteThroughInterval(int msec);
+    /**
+     * @see setWriteThroughInterval()
+     * @since 6.1
+     */
+    int writeThroughInterval() const;
+
     /**
      * Saves the state of the property map on disk.
      */
@@ -66,4 +113,6 @@ private:
     std::unique_ptr<KConfigPropertyMapPrivate> const d;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KConfigPropertyMap::Options)
+
 #endif